@@ -0,0 +1,406 @@
+/*
+ * Simulated BCMSDH backend: an SDIO bus with a cost model and a dongle
+ * that unpacks F2 writes, for measuring host framing without hardware.
+ *
+ * Copyright (C) 1999-2010, Broadcom Corporation
+ *
+ *      Unless you and Broadcom execute a separate written software license
+ * agreement governing use of this software, this software is licensed to you
+ * under the terms of the GNU General Public License version 2 (the "GPL"),
+ * available at http://www.broadcom.com/licenses/GPLv2.php, with the
+ * following added to such license:
+ *
+ *      As a special exception, the copyright holders of this software give you
+ * permission to link this software with independent modules, and to copy and
+ * distribute the resulting executable under terms of your choice, provided that
+ * you also meet, for each linked independent module, the terms and conditions of
+ * the license of that module.  An independent module is a module which is not
+ * derived from this software.  The special exception does not apply to any
+ * modifications of the software.
+ *
+ *      Notwithstanding the above, under no circumstances may you combine this
+ * software in any way with any other Broadcom software provided under a license
+ * other than the GPL, without Broadcom's express prior written consent.
+ *
+ * $Id$
+ */
+
+#include <typedefs.h>
+#include <osl.h>
+#include <bcmutils.h>
+#include <bcmendian.h>
+#include <sbsdio.h>
+#include <sdio.h>
+#include <sbhnddma.h>
+#include <sbconfig.h>
+#include <sbsdpcmdev.h>
+#include <bcmsdpcm.h>
+#include <bcmsdh.h>
+
+#include "bcmsdh_sim.h"
+
+#define SIM_SDALIGN	32	/* Subframe alignment, must match DHD_SDALIGN */
+
+#define SDPCM_HDRLEN	(SDPCM_FRAMETAG_LEN + SDPCM_SWHEADER_LEN)
+
+struct bcmsdh_info {
+	osl_t			*osh;
+	bcmsdh_sim_cfg_t	cfg;
+	bcmsdh_sim_stats_t	stats;
+	bcmsdh_sim_rx_fn_t	rx_fn;
+	void			*rx_arg;
+	uint64			now_ns;
+	uint8			rx_seq;		/* Next sequence number expected */
+	bool			intr_enabled;
+};
+
+/* Bus cost of one CMD53 transfer, split into block and byte mode parts */
+static void
+sim_cmd53(bcmsdh_info_t *sdh, uint nbytes)
+{
+	bcmsdh_sim_cfg_t *cfg = &sdh->cfg;
+	uint blocks = nbytes / cfg->blocksize;
+	uint tail = nbytes % cfg->blocksize;
+	uint ncmds = (blocks ? 1 : 0) + (tail ? 1 : 0);
+	uint64 clks;
+	uint64 ns;
+
+	clks = (uint64)nbytes * 8 / cfg->width;
+	clks += (uint64)(blocks + (tail ? 1 : 0)) * cfg->block_clks;
+	ns = (uint64)ncmds * cfg->cmd53_ns + clks * 1000000 / cfg->clock_khz;
+
+	sdh->stats.cmd53 += ncmds;
+	sdh->stats.bytes += nbytes;
+	sdh->stats.busy_ns += ns;
+	sdh->now_ns += ns;
+}
+
+static void
+sim_cmd52(bcmsdh_info_t *sdh)
+{
+	sdh->stats.cmd52++;
+	sdh->stats.busy_ns += sdh->cfg.cmd52_ns;
+	sdh->now_ns += sdh->cfg.cmd52_ns;
+}
+
+/* Checks one SDPCM frame and hands its payload up; returns its HW length */
+static uint
+sim_frame(bcmsdh_info_t *sdh, uint8 *frame, uint room, bool sub)
+{
+	uint16 len, check;
+	uint8 *swh, doff, seq;
+	uint chan;
+
+	if (room < SDPCM_HDRLEN) {
+		sdh->stats.errors++;
+		return 0;
+	}
+
+	len = ltoh16_ua(frame);
+	check = ltoh16_ua(frame + sizeof(uint16));
+	swh = frame + SDPCM_FRAMETAG_LEN;
+	chan = SDPCM_PACKET_CHANNEL(swh);
+	seq = SDPCM_PACKET_SEQUENCE(swh);
+	doff = SDPCM_DOFFSET_VALUE(swh);
+
+	if ((uint16)~(len ^ check) || (len < SDPCM_HDRLEN) || (len > room) ||
+	    (doff < SDPCM_HDRLEN) || (doff > len)) {
+		printf("sim dongle: bad %sframe header len/check 0x%04x/0x%04x doff %d\n",
+		       sub ? "sub" : "", len, check, doff);
+		sdh->stats.errors++;
+		return 0;
+	}
+	if (sub && (chan == SDPCM_GLOM_CHANNEL)) {
+		printf("sim dongle: nested superframe\n");
+		sdh->stats.errors++;
+		return 0;
+	}
+
+	if (seq != sdh->rx_seq) {
+		printf("sim dongle: seq %d, expected %d\n", seq, sdh->rx_seq);
+		sdh->stats.errors++;
+	}
+	sdh->rx_seq = (uint8)(seq + 1);
+
+	sdh->stats.frames++;
+	sdh->stats.payload += len - doff;
+	if (sdh->rx_fn)
+		sdh->rx_fn(sdh->rx_arg, chan, seq, frame + doff, len - doff);
+
+	return len;
+}
+
+/* The dongle side of an F2 write: one frame, or a superframe of them */
+static void
+sim_f2write(bcmsdh_info_t *sdh, uint8 *buf, uint nbytes)
+{
+	uint16 len, check;
+	uint8 *swh, doff, seq;
+	uint off, sublen;
+
+	sdh->stats.f2writes++;
+
+	if (nbytes < SDPCM_HDRLEN) {
+		sdh->stats.errors++;
+		return;
+	}
+
+	swh = buf + SDPCM_FRAMETAG_LEN;
+	if (SDPCM_PACKET_CHANNEL(swh) != SDPCM_GLOM_CHANNEL) {
+		sim_frame(sdh, buf, nbytes, FALSE);
+		return;
+	}
+
+	/* Superframe: header, then aligned subframes up to the header length */
+	len = ltoh16_ua(buf);
+	check = ltoh16_ua(buf + sizeof(uint16));
+	seq = SDPCM_PACKET_SEQUENCE(swh);
+	doff = SDPCM_DOFFSET_VALUE(swh);
+	if ((uint16)~(len ^ check) || (len > nbytes) || (doff < SDPCM_HDRLEN) ||
+	    (doff % SIM_SDALIGN) || (len <= doff)) {
+		printf("sim dongle: bad superframe header len/check 0x%04x/0x%04x doff %d\n",
+		       len, check, doff);
+		sdh->stats.errors++;
+		return;
+	}
+	if (seq != sdh->rx_seq) {
+		printf("sim dongle: superframe seq %d, expected %d\n", seq, sdh->rx_seq);
+		sdh->stats.errors++;
+	}
+	sdh->stats.superframes++;
+
+	for (off = doff; off < len; off += ROUNDUP(sublen, SIM_SDALIGN)) {
+		if (!(sublen = sim_frame(sdh, buf + off, len - off, TRUE)))
+			return;
+	}
+	if (off < ROUNDUP(len, SIM_SDALIGN)) {
+		printf("sim dongle: superframe ends mid-subframe\n");
+		sdh->stats.errors++;
+	}
+}
+
+bcmsdh_info_t *
+bcmsdh_sim_attach(osl_t *osh, const bcmsdh_sim_cfg_t *cfg, bcmsdh_sim_rx_fn_t fn, void *arg)
+{
+	bcmsdh_info_t *sdh;
+
+	if (!(sdh = (bcmsdh_info_t *)MALLOC(osh, sizeof(bcmsdh_info_t))))
+		return NULL;
+	bzero(sdh, sizeof(bcmsdh_info_t));
+	sdh->osh = osh;
+	sdh->cfg = *cfg;
+	sdh->rx_fn = fn;
+	sdh->rx_arg = arg;
+	return sdh;
+}
+
+void
+bcmsdh_sim_detach(bcmsdh_info_t *sdh)
+{
+	MFREE(sdh->osh, sdh, sizeof(bcmsdh_info_t));
+}
+
+uint64
+bcmsdh_sim_now(bcmsdh_info_t *sdh)
+{
+	return sdh->now_ns;
+}
+
+void
+bcmsdh_sim_idle(bcmsdh_info_t *sdh, uint64 until_ns)
+{
+	if (until_ns > sdh->now_ns)
+		sdh->now_ns = until_ns;
+}
+
+uint8
+bcmsdh_sim_rxseq(bcmsdh_info_t *sdh)
+{
+	return sdh->rx_seq;
+}
+
+void
+bcmsdh_sim_stats(bcmsdh_info_t *sdh, bcmsdh_sim_stats_t *stats)
+{
+	*stats = sdh->stats;
+}
+
+/* BCMSDH API */
+
+int
+bcmsdh_send_buf(void *sdh, uint32 addr, uint fn, uint flags,
+                uint8 *buf, uint nbytes, void *pkt,
+                bcmsdh_cmplt_fn_t complete, void *handle)
+{
+	bcmsdh_info_t *bcmsdh = (bcmsdh_info_t *)sdh;
+
+	if (flags & SDIO_REQ_ASYNC)
+		return BCME_UNSUPPORTED;
+
+	sim_cmd53(bcmsdh, nbytes);
+	if (fn == SDIO_FUNC_2)
+		sim_f2write(bcmsdh, buf, nbytes);
+	return 0;
+}
+
+int
+bcmsdh_recv_buf(void *sdh, uint32 addr, uint fn, uint flags,
+                uint8 *buf, uint nbytes, void *pkt,
+                bcmsdh_cmplt_fn_t complete, void *handle)
+{
+	/* Nothing to read: the dongle never raises a frame indication */
+	sim_cmd53((bcmsdh_info_t *)sdh, nbytes);
+	bzero(buf, nbytes);
+	return 0;
+}
+
+int
+bcmsdh_rwdata(void *sdh, uint rw, uint32 addr, uint8 *buf, uint nbytes)
+{
+	sim_cmd53((bcmsdh_info_t *)sdh, nbytes);
+	if (!rw)
+		bzero(buf, nbytes);
+	return 0;
+}
+
+uint8
+bcmsdh_cfg_read(void *sdh, uint func, uint32 addr, int *err)
+{
+	sim_cmd52((bcmsdh_info_t *)sdh);
+	if (err)
+		*err = 0;
+	/* Clocks are always up */
+	if ((func == SDIO_FUNC_1) && (addr == SBSDIO_FUNC1_CHIPCLKCSR))
+		return SBSDIO_AVBITS;
+	return 0;
+}
+
+void
+bcmsdh_cfg_write(void *sdh, uint func, uint32 addr, uint8 data, int *err)
+{
+	sim_cmd52((bcmsdh_info_t *)sdh);
+	if (err)
+		*err = 0;
+}
+
+uint32
+bcmsdh_reg_read(void *sdh, uint32 addr, uint size)
+{
+	sim_cmd53((bcmsdh_info_t *)sdh, size);
+	return 0;
+}
+
+uint32
+bcmsdh_reg_write(void *sdh, uint32 addr, uint size, uint32 data)
+{
+	sim_cmd53((bcmsdh_info_t *)sdh, size);
+	return 0;
+}
+
+bool
+bcmsdh_regfail(void *sdh)
+{
+	return FALSE;
+}
+
+int
+bcmsdh_abort(void *sdh, uint fn)
+{
+	sim_cmd52((bcmsdh_info_t *)sdh);
+	return 0;
+}
+
+int
+bcmsdh_cis_read(void *sdh, uint func, uint8 *cis, uint length)
+{
+	bzero(cis, length);
+	return 0;
+}
+
+uint32
+bcmsdh_cur_sbwad(void *sdh)
+{
+	return 0;
+}
+
+void
+bcmsdh_chipinfo(void *sdh, uint32 chip, uint32 chiprev)
+{
+}
+
+uint
+bcmsdh_query_iofnum(void *sdh)
+{
+	return 2;
+}
+
+int
+bcmsdh_iovar_op(void *sdh, const char *name,
+                void *params, int plen, void *arg, int len, bool set)
+{
+	bcmsdh_info_t *bcmsdh = (bcmsdh_info_t *)sdh;
+	int32 val;
+
+	if (set || (len < (int)sizeof(int32)))
+		return BCME_UNSUPPORTED;
+
+	if (!strcmp(name, "sd_blocksize"))
+		val = bcmsdh->cfg.blocksize;
+	else if (!strcmp(name, "sd_rxchain"))
+		val = FALSE;
+	else
+		return BCME_UNSUPPORTED;
+
+	bcopy(&val, arg, sizeof(val));
+	return 0;
+}
+
+int
+bcmsdh_intr_enable(void *sdh)
+{
+	((bcmsdh_info_t *)sdh)->intr_enabled = TRUE;
+	return 0;
+}
+
+int
+bcmsdh_intr_disable(void *sdh)
+{
+	((bcmsdh_info_t *)sdh)->intr_enabled = FALSE;
+	return 0;
+}
+
+int
+bcmsdh_intr_reg(void *sdh, bcmsdh_cb_fn_t fn, void *argh)
+{
+	return 0;
+}
+
+int
+bcmsdh_intr_dereg(void *sdh)
+{
+	return 0;
+}
+
+bool
+bcmsdh_intr_pending(void *sdh)
+{
+	return FALSE;
+}
+
+int
+bcmsdh_reset(bcmsdh_info_t *sdh)
+{
+	sdh->rx_seq = 0;
+	return 0;
+}
+
+int
+bcmsdh_register(bcmsdh_driver_t *driver)
+{
+	return 0;
+}
+
+void
+bcmsdh_unregister(void)
+{
+}
@@ -0,0 +1,73 @@
+/*
+ * Simulated BCMSDH backend: an SDIO bus with a cost model and a dongle
+ * that unpacks F2 writes, for measuring host framing without hardware.
+ *
+ * Copyright (C) 1999-2010, Broadcom Corporation
+ *
+ *      Unless you and Broadcom execute a separate written software license
+ * agreement governing use of this software, this software is licensed to you
+ * under the terms of the GNU General Public License version 2 (the "GPL"),
+ * available at http://www.broadcom.com/licenses/GPLv2.php, with the
+ * following added to such license:
+ *
+ *      As a special exception, the copyright holders of this software give you
+ * permission to link this software with independent modules, and to copy and
+ * distribute the resulting executable under terms of your choice, provided that
+ * you also meet, for each linked independent module, the terms and conditions of
+ * the license of that module.  An independent module is a module which is not
+ * derived from this software.  The special exception does not apply to any
+ * modifications of the software.
+ *
+ *      Notwithstanding the above, under no circumstances may you combine this
+ * software in any way with any other Broadcom software provided under a license
+ * other than the GPL, without Broadcom's express prior written consent.
+ *
+ * $Id$
+ */
+
+#ifndef	_bcmsdh_sim_h_
+#define	_bcmsdh_sim_h_
+
+#include <bcmsdh.h>
+
+/* Bus timing.  A CMD53 moves whole blocks in block mode and any remainder
+ * in a separate byte mode command, the way the Linux MMC core splits it.
+ */
+typedef struct bcmsdh_sim_cfg {
+	uint	clock_khz;	/* SD clock */
+	uint	width;		/* Data lines (1 or 4) */
+	uint	blocksize;	/* F2 block size */
+	uint	cmd53_ns;	/* Fixed cost per CMD53: command, setup, completion */
+	uint	cmd52_ns;	/* Fixed cost per CMD52 */
+	uint	block_clks;	/* CRC and turnaround per data block, in clocks */
+} bcmsdh_sim_cfg_t;
+
+typedef struct bcmsdh_sim_stats {
+	uint	cmd53;		/* Data commands, byte mode tails included */
+	uint	cmd52;		/* Register commands */
+	uint	f2writes;	/* F2 writes seen by the dongle */
+	uint	superframes;	/* ... of which were superframes */
+	uint	frames;		/* Frames unpacked by the dongle */
+	uint	errors;		/* Framing and sequence errors */
+	uint64	bytes;		/* Bytes on the bus, padding included */
+	uint64	payload;	/* Frame bytes past the SDPCM headers */
+	uint64	busy_ns;	/* Time the bus spent on commands */
+} bcmsdh_sim_stats_t;
+
+/* Called by the dongle for every frame it unpacks */
+typedef void (*bcmsdh_sim_rx_fn_t)(void *arg, uint chan, uint8 seq, uint8 *data, uint len);
+
+extern bcmsdh_info_t *bcmsdh_sim_attach(osl_t *osh, const bcmsdh_sim_cfg_t *cfg,
+	bcmsdh_sim_rx_fn_t fn, void *arg);
+extern void bcmsdh_sim_detach(bcmsdh_info_t *sdh);
+
+/* Virtual time: advanced by bus commands, or by the caller while idle */
+extern uint64 bcmsdh_sim_now(bcmsdh_info_t *sdh);
+extern void bcmsdh_sim_idle(bcmsdh_info_t *sdh, uint64 until_ns);
+
+/* Next sequence number the dongle expects */
+extern uint8 bcmsdh_sim_rxseq(bcmsdh_info_t *sdh);
+
+extern void bcmsdh_sim_stats(bcmsdh_info_t *sdh, bcmsdh_sim_stats_t *stats);
+
+#endif	/* _bcmsdh_sim_h_ */
@@ -0,0 +1,563 @@
+/*
+ * SDIO bus simulator: runs the real dhd_sdio.c transmit path on a host
+ * against the simulated BCMSDH backend, in virtual time, and reports how
+ * well frames are packed into F2 writes for a few traffic mixes with and
+ * without tx glomming.  The simulated dongle checks every frame's framing,
+ * sequence number, order and contents, so this doubles as a test: it
+ * exits non-zero on any error.
+ *
+ *   dhd_sim [-n frames] [-w window] [-s seed] [-v]
+ *
+ * Copyright (C) 1999-2010, Broadcom Corporation
+ *
+ *      Unless you and Broadcom execute a separate written software license
+ * agreement governing use of this software, this software is licensed to you
+ * under the terms of the GNU General Public License version 2 (the "GPL"),
+ * available at http://www.broadcom.com/licenses/GPLv2.php, with the
+ * following added to such license:
+ *
+ *      As a special exception, the copyright holders of this software give you
+ * permission to link this software with independent modules, and to copy and
+ * distribute the resulting executable under terms of your choice, provided that
+ * you also meet, for each linked independent module, the terms and conditions of
+ * the license of that module.  An independent module is a module which is not
+ * derived from this software.  The special exception does not apply to any
+ * modifications of the software.
+ *
+ *      Notwithstanding the above, under no circumstances may you combine this
+ * software in any way with any other Broadcom software provided under a license
+ * other than the GPL, without Broadcom's express prior written consent.
+ *
+ * $Id$
+ */
+
+/* Built as part of this file so the harness can set up a bus by hand */
+#include "../sys/dhd_sdio.c"
+
+#include <unistd.h>
+#include "bcmsdh_sim.h"
+
+/* 25MHz 4-bit SD clock, 512-byte F2 blocks; fixed costs are typical of
+ * the Linux MMC stack (request setup, completion interrupt, wakeup).
+ */
+static const bcmsdh_sim_cfg_t sim_cfg = {
+	25000,		/* clock_khz */
+	4,		/* width */
+	512,		/* blocksize */
+	25000,		/* cmd53_ns */
+	12000,		/* cmd52_ns */
+	20		/* block_clks */
+};
+
+typedef struct sim_traffic {
+	const char	*name;
+	uint		minlen;		/* Frame length range */
+	uint		maxlen;
+	uint		rate;		/* Offered frames per second, 0 keeps the queue full */
+} sim_traffic_t;
+
+static const sim_traffic_t sim_traffic[] = {
+	{"bulk",	1514,	1514,	0 },
+	{"acks",	80,	80,	0 },
+	{"mixed",	64,	1514,	4000 },
+};
+
+typedef struct sim_mode {
+	const char	*name;
+	bool		txglom;
+	uint		depth;
+	uint		flush;		/* Watchdog ticks */
+} sim_mode_t;
+
+static const sim_mode_t sim_modes[] = {
+	{"single",	FALSE,	0,	0 },
+	{"glom4",	TRUE,	4,	0 },
+	{"glom8",	TRUE,	8,	0 },
+	{"glom16",	TRUE,	16,	0 },
+	{"glom8/f1",	TRUE,	8,	1 },
+};
+
+#define SIM_BACKLOG	64	/* Queue depth kept up for saturating traffic */
+#define SIM_HEADROOM	64	/* Headroom of a fresh packet */
+#define SIM_PAYHDR	8	/* Frame id and length at the start of the payload */
+
+/* State shared with the stubs and the simulated dongle */
+typedef struct sim {
+	dhd_pub_t	dhd;
+	dhd_bus_t	*bus;
+	bcmsdh_info_t	*sdh;
+	sdpcmd_regs_t	regs;
+	bool		dpc_pending;
+
+	uint		nframes;
+	uint64		*arrival;	/* Per frame id */
+	uint32		*latency;	/* In order of receipt, usec */
+	uint		received;
+	uint		txfail;
+	uint		errors;
+	int		pkts;		/* Live packets */
+	uint32		rng;
+} sim_t;
+
+static sim_t sim;
+
+/* OSL */
+
+void *
+osl_malloc(osl_t *osh, uint size)
+{
+	return malloc(size);
+}
+
+void
+osl_mfree(osl_t *osh, void *addr, uint size)
+{
+	free(addr);
+}
+
+uint
+osl_malloced(osl_t *osh)
+{
+	return 0;
+}
+
+void *
+osl_pktget(osl_t *osh, uint len)
+{
+	osl_pkt_t *p;
+
+	if (!(p = (osl_pkt_t *)malloc(sizeof(osl_pkt_t) + SIM_HEADROOM + len)))
+		return NULL;
+	bzero(p, sizeof(osl_pkt_t));
+	p->head = (uint8 *)(p + 1);
+	p->data = p->head + SIM_HEADROOM;
+	p->len = len;
+	p->size = SIM_HEADROOM + len;
+	sim.pkts++;
+	return p;
+}
+
+void
+osl_pktfree(osl_t *osh, void *skb, bool send)
+{
+	osl_pkt_t *p = (osl_pkt_t *)skb, *next;
+
+	for (; p; p = next) {
+		next = p->next;
+		free(p);
+		sim.pkts--;
+	}
+}
+
+void *
+osl_pktdup(osl_t *osh, void *skb)
+{
+	osl_pkt_t *p;
+
+	if (!(p = (osl_pkt_t *)osl_pktget(osh, PKTLEN(osh, skb))))
+		return NULL;
+	bcopy(PKTDATA(osh, skb), p->data, p->len);
+	return p;
+}
+
+uint
+osl_pktalloced(osl_t *osh)
+{
+	return (uint)sim.pkts;
+}
+
+void
+osl_delay(uint usec)
+{
+	bcmsdh_sim_idle(sim.sdh, bcmsdh_sim_now(sim.sdh) + (uint64)usec * 1000);
+}
+
+uint32
+osl_sysuptime(void)
+{
+	return (uint32)(bcmsdh_sim_now(sim.sdh) / 1000000);
+}
+
+int
+net_ratelimit(void)
+{
+	return 1;
+}
+
+/* The rest of the DHD and the SI layer, as far as the tx path needs them */
+
+int dhd_msg_level = DHD_ERROR_VAL;
+uint dhd_watchdog_ms = 10;
+uint dhd_poll = FALSE;
+uint dhd_intr = TRUE;
+int dhd_idletime = 0;
+uint dhd_sdiod_drive_strength = 6;
+
+void dhd_os_sdlock(dhd_pub_t *pub) {}
+void dhd_os_sdunlock(dhd_pub_t *pub) {}
+void dhd_os_sdlock_txq(dhd_pub_t *pub) {}
+void dhd_os_sdunlock_txq(dhd_pub_t *pub) {}
+void dhd_os_sdlock_rxq(dhd_pub_t *pub) {}
+void dhd_os_sdunlock_rxq(dhd_pub_t *pub) {}
+int dhd_os_wake_lock(dhd_pub_t *pub) { return 0; }
+int dhd_os_wake_unlock(dhd_pub_t *pub) { return 0; }
+void dhd_os_wd_timer(void *bus, uint wdtick) {}
+int dhd_os_proto_block(dhd_pub_t *pub) { return 1; }
+int dhd_os_proto_unblock(dhd_pub_t *pub) { return 1; }
+int dhd_os_ioctl_resp_wait(dhd_pub_t *pub, uint *condition, bool *pending) { return 0; }
+int dhd_os_ioctl_resp_wake(dhd_pub_t *pub) { return 0; }
+void *dhd_os_open_image(char *filename) { return NULL; }
+int dhd_os_get_image_block(char *buf, int len, void *image) { return 0; }
+void dhd_os_close_image(void *image) {}
+void dhd_wait_for_event(dhd_pub_t *dhd, bool *lockvar) {}
+void dhd_wait_event_wakeup(dhd_pub_t *dhd) {}
+osl_t *dhd_osl_attach(void *pdev, uint bustype) { return NULL; }
+void dhd_osl_detach(osl_t *osh) {}
+dhd_pub_t *dhd_attach(osl_t *osh, struct dhd_bus *bus, uint bus_hdrlen) { return NULL; }
+void dhd_detach(dhd_pub_t *dhdp) {}
+int dhd_net_attach(dhd_pub_t *dhdp, int idx) { return 0; }
+int dhd_bus_start(dhd_pub_t *dhdp) { return 0; }
+void dhd_common_init(void) {}
+int dhd_preinit_ioctls(dhd_pub_t *dhd) { return 0; }
+int dhd_prot_hdrpull(dhd_pub_t *dhd, int *ifidx, void *rxp) { return 0; }
+void dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *rxp, int numpkt) { PKTFREE(NULL, rxp, FALSE); }
+int dhdcdc_query_ioctl(dhd_pub_t *dhd, int ifidx, uint cmd, void *buf, uint len) { return 0; }
+void dhd_txflowcontrol(dhd_pub_t *dhdp, int ifidx, bool on) {}
+void dhd_timeout_start(dhd_timeout_t *tmo, uint usec) { tmo->limit = usec; tmo->elapsed = 0; }
+int dhd_timeout_expired(dhd_timeout_t *tmo) { return 1; }
+
+si_t *si_attach(uint pcidev, osl_t *osh, void *regs, uint bustype, void *sdh,
+	char **vars, uint *varsz) { return NULL; }
+void si_detach(si_t *sih) {}
+void *si_setcore(si_t *sih, uint coreid, uint coreunit) { return NULL; }
+uint si_corerev(si_t *sih) { return 0; }
+bool si_iscoreup(si_t *sih) { return TRUE; }
+void si_core_disable(si_t *sih, uint32 bits) {}
+void si_core_reset(si_t *sih, uint32 bits, uint32 resetbits) {}
+uint32 si_socram_size(si_t *sih) { return 0; }
+void si_watchdog(si_t *sih, uint ticks) {}
+void si_sdiod_drive_strength_init(si_t *sih, osl_t *osh, uint32 drivestrength) {}
+
+void
+dhd_sched_dpc(dhd_pub_t *dhdp)
+{
+	sim.dpc_pending = TRUE;
+}
+
+/* dhd_sdio.c passes TRUE here when the frame could not be sent */
+void
+dhd_txcomplete(dhd_pub_t *dhdp, void *txp, bool failed)
+{
+	if (failed)
+		sim.txfail++;
+}
+
+bool
+dhd_prec_enq(dhd_pub_t *dhdp, struct pktq *q, void *pkt, int prec)
+{
+	if (pktq_pfull(q, prec) || pktq_full(q))
+		return FALSE;
+	pktq_penq(q, prec, pkt);
+	return TRUE;
+}
+
+/* Traffic */
+
+static uint32
+sim_rand(void)
+{
+	/* xorshift32 */
+	sim.rng ^= sim.rng << 13;
+	sim.rng ^= sim.rng >> 17;
+	sim.rng ^= sim.rng << 5;
+	return sim.rng;
+}
+
+static uint8
+sim_pattern(uint32 id, uint i)
+{
+	return (uint8)(id * 7 + i);
+}
+
+static void *
+sim_frame(uint32 id, uint len)
+{
+	void *pkt;
+	uint8 *data;
+	uint i;
+
+	if (!(pkt = PKTGET(NULL, len, TRUE)))
+		return NULL;
+	data = PKTDATA(NULL, pkt);
+	htol32_ua_store(id, data);
+	htol32_ua_store(len, data + sizeof(uint32));
+	for (i = SIM_PAYHDR; i < len; i++)
+		data[i] = sim_pattern(id, i);
+	return pkt;
+}
+
+/* Dongle delivery: frames must come back whole and in order */
+static void
+sim_rx(void *arg, uint chan, uint8 seq, uint8 *data, uint len)
+{
+	uint32 id, sent;
+	uint i;
+
+	if ((chan != SDPCM_DATA_CHANNEL) || (len < SIM_PAYHDR)) {
+		printf("sim: unexpected chan %d len %d\n", chan, len);
+		sim.errors++;
+		return;
+	}
+	id = ltoh32_ua(data);
+	sent = ltoh32_ua(data + sizeof(uint32));
+	if ((id != sim.received) || (sent != len)) {
+		printf("sim: got frame %u (%u bytes), expected frame %u\n", id, len, sim.received);
+		sim.errors++;
+		return;
+	}
+	for (i = SIM_PAYHDR; i < len; i++) {
+		if (data[i] != sim_pattern(id, i)) {
+			printf("sim: frame %u corrupt at byte %u\n", id, i);
+			sim.errors++;
+			break;
+		}
+	}
+	sim.latency[sim.received++] =
+	        (uint32)((bcmsdh_sim_now(sim.sdh) - sim.arrival[id]) / 1000);
+}
+
+static int
+sim_cmp32(const void *a, const void *b)
+{
+	uint32 x = *(const uint32 *)a, y = *(const uint32 *)b;
+	return (x > y) - (x < y);
+}
+
+static int
+sim_iovar(const char *name, int32 val)
+{
+	return dhd_bus_iovar_op(&sim.dhd, name, NULL, 0, &val, sizeof(val), TRUE);
+}
+
+/* Runs one traffic mix through one mode, returns the number of errors */
+static uint
+sim_run(const sim_traffic_t *t, const sim_mode_t *m, uint nframes, uint window,
+	uint32 seed, bool verbose)
+{
+	bcmsdh_sim_stats_t st;
+	dhd_bus_t *bus;
+	uint64 now, next_arrival, next_wd, wd_ns, limit;
+	uint32 sent = 0;
+	uint64 latsum = 0;
+	uint i, errors;
+	uint8 txmax;
+	void *pkt;
+
+	bzero(&sim, sizeof(sim));
+	sim.nframes = nframes;
+	sim.rng = seed ? seed : 1;
+	sim.arrival = (uint64 *)malloc(nframes * sizeof(uint64));
+	sim.latency = (uint32 *)malloc(nframes * sizeof(uint32));
+	sim.sdh = bcmsdh_sim_attach(NULL, &sim_cfg, sim_rx, NULL);
+
+	/* A bus that is up with clocks on, as dhdsdio_probe would leave it */
+	bus = sim.bus = (dhd_bus_t *)MALLOC(NULL, sizeof(dhd_bus_t));
+	bzero(bus, sizeof(dhd_bus_t));
+	bus->dhd = &sim.dhd;
+	bus->sdh = sim.sdh;
+	bus->regs = &sim.regs;
+	bus->bus = SDIO_BUS;
+	bus->blocksize = sim_cfg.blocksize;
+	bus->roundup = MIN(max_roundup, bus->blocksize);
+	bus->clkstate = CLK_AVAIL;
+	bus->intr = TRUE;
+	bus->hostintmask = HOSTINTMASK;
+	bus->tx_max = (uint8)window;
+	bus->txglom_depth = DHD_TXGLOM_DEPTH;
+	bus->txglom_flush = DHD_TXGLOM_FLUSH;
+	pktq_init(&bus->txq, (PRIOMASK + 1), QLEN);
+
+	sim.dhd.bus = bus;
+	sim.dhd.up = TRUE;
+	sim.dhd.busstate = DHD_BUS_DATA;
+
+	dhd_txbound = DHD_TXBOUND;
+	dhd_rxbound = DHD_RXBOUND;
+	dhd_txminmax = DHD_TXMINMAX;
+	forcealign = TRUE;
+
+	errors = 0;
+	if (m->txglom) {
+		if (sim_iovar("txglomdepth", m->depth) || sim_iovar("txglomflush", m->flush) ||
+		    sim_iovar("txglom", TRUE)) {
+			printf("sim: txglom iovars failed\n");
+			errors++;
+		}
+	}
+
+	wd_ns = (uint64)dhd_watchdog_ms * 1000000;
+	next_wd = wd_ns;
+	next_arrival = 0;
+	/* Way beyond what a 1-bit bus would need */
+	limit = (uint64)nframes * 2000000 + 10 * wd_ns;
+
+	while ((sim.received < nframes) && !errors && !sim.errors) {
+		now = bcmsdh_sim_now(sim.sdh);
+		if (now > limit) {
+			printf("sim: stalled with %d frames queued\n", pktq_len(&bus->txq));
+			errors++;
+			break;
+		}
+
+		/* New frames from the stack */
+		while ((sent < nframes) &&
+		       (t->rate ? (next_arrival <= now) : (pktq_len(&bus->txq) < SIM_BACKLOG))) {
+			uint len = t->minlen + sim_rand() % (t->maxlen - t->minlen + 1);
+			if (!(pkt = sim_frame(sent, len))) {
+				errors++;
+				break;
+			}
+			sim.arrival[sent] = t->rate ? next_arrival : now;
+			sim.dhd.tx_packets++;
+			if (dhd_bus_txdata(bus, pkt)) {
+				printf("sim: txdata refused frame %u\n", sent);
+				errors++;
+				break;
+			}
+			sent++;
+			if (t->rate)
+				next_arrival += 1000000000ULL / t->rate / 2 +
+				        sim_rand() % (1000000000U / t->rate);
+		}
+
+		if (now >= next_wd) {
+			dhd_bus_watchdog(&sim.dhd);
+			next_wd += wd_ns;
+		}
+
+		/* The dongle frees its buffers as soon as the frames are in, and
+		 * the credit update interrupts a host that has frames waiting.
+		 */
+		txmax = (uint8)(bcmsdh_sim_rxseq(sim.sdh) + window);
+		if (txmax != bus->tx_max) {
+			bus->tx_max = txmax;
+			if (pktq_len(&bus->txq) && !bus->dpc_sched) {
+				bus->dpc_sched = TRUE;
+				sim.dpc_pending = TRUE;
+			}
+		}
+
+		if (sim.dpc_pending) {
+			sim.dpc_pending = FALSE;
+			if (dhd_bus_dpc(bus))
+				sim.dpc_pending = TRUE;
+			continue;
+		}
+
+		/* Idle until something happens */
+		if ((sent < nframes) && t->rate && (next_arrival < next_wd))
+			bcmsdh_sim_idle(sim.sdh, next_arrival);
+		else
+			bcmsdh_sim_idle(sim.sdh, next_wd);
+	}
+
+	bcmsdh_sim_stats(sim.sdh, &st);
+	now = bcmsdh_sim_now(sim.sdh);
+
+	if (sim.txfail) {
+		printf("sim: %u frames failed\n", sim.txfail);
+		errors++;
+	}
+	if (st.errors) {
+		printf("sim: dongle saw %u errors\n", st.errors);
+		errors++;
+	}
+	if (!errors && !sim.errors) {
+		if (pktq_len(&bus->txq) || sim.pkts) {
+			printf("sim: %d frames left queued, %d packets live\n",
+			       pktq_len(&bus->txq), sim.pkts);
+			errors++;
+		}
+		if (m->txglom && (bus->txglompkts + (st.f2writes - bus->txglomframes) != nframes)) {
+			printf("sim: txglompkts %u over %u superframes doesn't add up\n",
+			       bus->txglompkts, bus->txglomframes);
+			errors++;
+		}
+	}
+
+	for (i = 0; i < sim.received; i++)
+		latsum += sim.latency[i];
+	qsort(sim.latency, sim.received, sizeof(uint32), sim_cmp32);
+
+	printf("%-6s %-9s %7.2f %7.2f %8u %5.1f%% %7.0f %7u %7u\n",
+	       t->name, m->name,
+	       now ? (double)st.payload * 8 * 1000 / now : 0.0,
+	       st.f2writes ? (double)st.frames / st.f2writes : 0.0,
+	       st.cmd53,
+	       now ? 100.0 * st.busy_ns / now : 0.0,
+	       sim.received ? (double)latsum / sim.received : 0.0,
+	       sim.received ? sim.latency[sim.received * 99 / 100] : 0,
+	       bus->txglomflushes);
+
+	if (verbose) {
+		struct bcmstrbuf b;
+		char *buf = (char *)malloc(4096);
+		bcm_binit(&b, buf, 4096);
+		dhd_bus_dump(&sim.dhd, &b);
+		printf("%s\n", buf);
+		free(buf);
+	}
+
+	pktq_flush(NULL, &bus->txq, TRUE);
+	dhdsdio_release_malloc(bus, NULL);
+	MFREE(NULL, bus, sizeof(dhd_bus_t));
+	bcmsdh_sim_detach(sim.sdh);
+	free(sim.arrival);
+	free(sim.latency);
+
+	return errors + sim.errors;
+}
+
+int
+main(int argc, char **argv)
+{
+	uint nframes = 20000, window = 32;
+	uint32 seed = 1;
+	bool verbose = FALSE;
+	uint errors = 0;
+	uint i, j;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:w:s:v")) != -1) {
+		switch (c) {
+		case 'n': nframes = (uint)atoi(optarg); break;
+		case 'w': window = (uint)atoi(optarg); break;
+		case 's': seed = (uint32)atoi(optarg); break;
+		case 'v': verbose = TRUE; break;
+		default:
+			fprintf(stderr, "usage: %s [-n frames] [-w window] [-s seed] [-v]\n",
+			        argv[0]);
+			return 2;
+		}
+	}
+	if (!nframes || !window || (window > 0x40)) {
+		fprintf(stderr, "%s: need frames > 0 and 0 < window <= 64\n", argv[0]);
+		return 2;
+	}
+
+	printf("SDIO %u kHz x%u, %u-byte blocks, %u us per CMD53, window %u, %u frames\n\n",
+	       sim_cfg.clock_khz, sim_cfg.width, sim_cfg.blocksize,
+	       sim_cfg.cmd53_ns / 1000, window, nframes);
+	printf("%-6s %-9s %7s %7s %8s %6s %7s %7s %7s\n",
+	       "load", "mode", "Mbps", "pkts/wr", "cmd53", "bus", "lat us", "p99 us", "flushes");
+
+	for (i = 0; i < ARRAYSIZE(sim_traffic); i++) {
+		for (j = 0; j < ARRAYSIZE(sim_modes); j++)
+			errors += sim_run(&sim_traffic[i], &sim_modes[j], nframes, window,
+			                  seed, verbose);
+		printf("\n");
+	}
+
+	printf("%s\n", errors ? "FAILED" : "passed");
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Host OS abstraction for the SDIO bus simulator.
+ *
+ * Stands in for include/linux_osl.h when dhd_sdio.c is built as a
+ * user-space program: packets are plain heap buffers with headroom,
+ * registers are ordinary memory and locks are no-ops (the simulator is
+ * single threaded).
+ *
+ * Copyright (C) 1999-2010, Broadcom Corporation
+ *
+ *      Unless you and Broadcom execute a separate written software license
+ * agreement governing use of this software, this software is licensed to you
+ * under the terms of the GNU General Public License version 2 (the "GPL"),
+ * available at http://www.broadcom.com/licenses/GPLv2.php, with the
+ * following added to such license:
+ *
+ *      As a special exception, the copyright holders of this software give you
+ * permission to link this software with independent modules, and to copy and
+ * distribute the resulting executable under terms of your choice, provided that
+ * you also meet, for each linked independent module, the terms and conditions of
+ * the license of that module.  An independent module is a module which is not
+ * derived from this software.  The special exception does not apply to any
+ * modifications of the software.
+ *
+ *      Notwithstanding the above, under no circumstances may you combine this
+ * software in any way with any other Broadcom software provided under a license
+ * other than the GPL, without Broadcom's express prior written consent.
+ *
+ * $Id$
+ */
+
+#ifndef _linux_osl_h_
+#define _linux_osl_h_
+
+#include <typedefs.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/* dhd.h looks at the kernel version even outside of LINUX builds */
+#define KERNEL_VERSION(a, b, c)	(((a) << 16) + ((b) << 8) + (c))
+#define LINUX_VERSION_CODE	KERNEL_VERSION(2, 6, 25)
+
+#define	ASSERT(exp)		assert(exp)
+
+/* DHD_ERROR is rate limited outside of DHD_DEBUG builds */
+extern int net_ratelimit(void);
+
+#define	OSL_DELAY(usec)		osl_delay(usec)
+extern void osl_delay(uint usec);
+
+#define OSL_PCI_READ_CONFIG(osh, offset, size)		0
+#define OSL_PCI_WRITE_CONFIG(osh, offset, size, val)	do {} while (0)
+#define OSL_PCMCIA_READ_ATTR(osh, offset, buf, size)	do {} while (0)
+#define OSL_PCMCIA_WRITE_ATTR(osh, offset, buf, size)	do {} while (0)
+
+#define OSL_ERROR(bcmerror)	bcmerror
+#define OSL_SYSUPTIME()		osl_sysuptime()
+extern uint32 osl_sysuptime(void);
+
+/* host endianness is little */
+#define BUS_SWAP32(v)		(v)
+
+#define	MALLOC(osh, size)	osl_malloc((osh), (size))
+#define	MFREE(osh, addr, size)	osl_mfree((osh), (addr), (size))
+#define MALLOCED(osh)		osl_malloced((osh))
+#define	MALLOC_FAILED(osh)	0
+extern void *osl_malloc(osl_t *osh, uint size);
+extern void osl_mfree(osl_t *osh, void *addr, uint size);
+extern uint osl_malloced(osl_t *osh);
+
+/* Registers are simulated in memory */
+#define R_REG(osh, r)		(*(volatile typeof(*(r)) *)(r))
+#define W_REG(osh, r, v)	(*(volatile typeof(*(r)) *)(r) = (v))
+#define	AND_REG(osh, r, v)	W_REG(osh, (r), R_REG(osh, r) & (v))
+#define	OR_REG(osh, r, v)	W_REG(osh, (r), R_REG(osh, r) | (v))
+#define REG_MAP(pa, size)	((void *)(uintptr)(pa))
+#define REG_UNMAP(va)		do {} while (0)
+#define R_SM(r)			*(r)
+#define W_SM(r, v)		(*(r) = (v))
+#define BZERO_SM(r, len)	memset((r), '\0', (len))
+
+#define	bcopy(src, dst, len)	memcpy((dst), (src), (len))
+#define	bcmp(b1, b2, len)	memcmp((b1), (b2), (len))
+#define	bzero(b, len)		memset((b), '\0', (len))
+
+/* Packets: data/len window into a heap buffer, linked for queues/chains */
+typedef struct osl_pkt {
+	struct osl_pkt	*next;		/* chain (PKTNEXT) */
+	struct osl_pkt	*link;		/* queue (PKTLINK) */
+	uint8		*head;
+	uint8		*data;
+	uint		len;
+	uint		size;		/* bytes allocated from head */
+	uint		prio;
+	uint8		tag[OSL_PKTTAG_SZ];
+} osl_pkt_t;
+
+#define	PKTBUFSZ		2048
+#define PKTGET(osh, len, send)	osl_pktget((osh), (len))
+#define PKTFREE(osh, skb, send)	osl_pktfree((osh), (skb), (send))
+#define	PKTDATA(osh, skb)	(((osl_pkt_t *)(skb))->data)
+#define	PKTLEN(osh, skb)	(((osl_pkt_t *)(skb))->len)
+#define PKTHEADROOM(osh, skb)	((uint)(PKTDATA(osh, skb) - ((osl_pkt_t *)(skb))->head))
+#define PKTTAILROOM(osh, skb)	(((osl_pkt_t *)(skb))->size - PKTHEADROOM(osh, skb) - \
+				 PKTLEN(osh, skb))
+#define	PKTNEXT(osh, skb)	((void *)((osl_pkt_t *)(skb))->next)
+#define	PKTSETNEXT(osh, skb, x)	(((osl_pkt_t *)(skb))->next = (osl_pkt_t *)(x))
+#define	PKTSETLEN(osh, skb, l)	(((osl_pkt_t *)(skb))->len = (l))
+#define	PKTPUSH(osh, skb, bytes)	osl_pktpush((skb), (bytes))
+#define	PKTPULL(osh, skb, bytes)	osl_pktpull((skb), (bytes))
+#define	PKTTAG(skb)		((void *)(((osl_pkt_t *)(skb))->tag))
+#define PKTALLOCED(osh)		osl_pktalloced(osh)
+#define	PKTLINK(skb)		((void *)((osl_pkt_t *)(skb))->link)
+#define	PKTSETLINK(skb, x)	(((osl_pkt_t *)(skb))->link = (osl_pkt_t *)(x))
+#define	PKTPRIO(skb)		(((osl_pkt_t *)(skb))->prio)
+#define	PKTSETPRIO(skb, x)	(((osl_pkt_t *)(skb))->prio = (x))
+#define PKTSUMNEEDED(skb)	(0)
+#define PKTSETSUMGOOD(skb, x)	do {} while (0)
+#define PKTSHARED(skb)		(0)
+#define PKTSETPOOL(osh, skb, x, y)	do {} while (0)
+#define PKTPOOL(osh, skb)	FALSE
+#define PKTFREESETCB(osh, _tx_fn, _tx_ctx)	do {} while (0)
+#define PKTDUP(osh, skb)	osl_pktdup((osh), (skb))
+#define PKTLIST_DUMP(osh, buf)	do {} while (0)
+
+extern void *osl_pktget(osl_t *osh, uint len);
+extern void osl_pktfree(osl_t *osh, void *skb, bool send);
+extern void *osl_pktdup(osl_t *osh, void *skb);
+extern uint osl_pktalloced(osl_t *osh);
+
+static inline uchar *
+osl_pktpush(void *skb, int bytes)
+{
+	osl_pkt_t *p = (osl_pkt_t *)skb;
+	assert(p->data - p->head >= bytes);
+	p->data -= bytes;
+	p->len += bytes;
+	return p->data;
+}
+
+static inline uchar *
+osl_pktpull(void *skb, int bytes)
+{
+	osl_pkt_t *p = (osl_pkt_t *)skb;
+	assert(p->len >= (uint)bytes);
+	p->data += bytes;
+	p->len -= bytes;
+	return p->data;
+}
+
+#endif	/* _linux_osl_h_ */
@@ -77,6 +77,10 @@
 
 #define DHD_TXMINMAX	1	/* Max tx frames if rx still pending */
 
+#define DHD_TXGLOM_DEPTH	8	/* Default max tx frames per superframe */
+#define DHD_TXGLOM_MAX		16	/* Upper limit on txglomdepth */
+#define DHD_TXGLOM_FLUSH	0	/* Default watchdog ticks to hold a partial glom */
+
 #define MEMBLOCK	2048		/* Block size used for downloading of dongle image */
 #define MAX_DATA_BUF	(32 * 1024)	/* Must be large enough to hold biggest possible glom */
 
@@ -178,6 +182,14 @@ typedef struct dhd_bus {
 	uint8		tx_seq;			/* Transmit sequence number (next) */
 	uint8		tx_max;			/* Maximum transmit sequence allowed */
 
+	bool		txglom;			/* Coalesce queued tx frames into one F2 write */
+	uint		txglom_depth;		/* Max frames per tx superframe */
+	uint		txglom_flush;		/* Watchdog ticks to hold a partial batch */
+	uint		txglom_tick;		/* Ticks the current partial batch was held */
+	bool		txglom_flushnow;	/* Flush tick expired, send partial batch */
+	uint8		*txglombuf;		/* Buffer for building tx superframes */
+	uint8		*txglomptr;		/* Aligned pointer into txglombuf */
+
 	uint8		hdrbuf[MAX_HDR_READ + DHD_SDALIGN];
 	uint8		*rxhdr;			/* Header of current rx frame (in hdrbuf) */
 	uint16		nextlen;		/* Next Read Len from last header */
@@ -267,6 +279,9 @@ typedef struct dhd_bus {
 	uint		rxglomfail;		/* Failed deglom attempts */
 	uint		rxglomframes;		/* Number of glom frames (superframes) */
 	uint		rxglompkts;		/* Number of packets from glom frames */
+	uint		txglomframes;		/* Number of tx superframes */
+	uint		txglompkts;		/* Number of packets sent in tx superframes */
+	uint		txglomflushes;		/* Partial batches released by flush tick */
 	uint		f2rxhdrs;		/* Number of header reads */
 	uint		f2rxdata;		/* Number of frame data reads */
 	uint		f2txdata;		/* Number of f2 frame writes */
@@ -357,6 +372,18 @@ static bool dhd_readahead;
 	(((uint8)(bus->tx_max - bus->tx_seq) != 0) && \
 	(((uint8)(bus->tx_max - bus->tx_seq) & 0x80) == 0))
 
+/* Frames a full tx superframe would carry with the current window */
+#define TXGLOM_TARGET(bus) \
+	MIN((bus)->txglom_depth, (uint)(uint8)((bus)->tx_max - (bus)->tx_seq))
+
+/* A partial tx superframe is held until it fills up or the flush tick */
+#define TXGLOM_HOLD(bus) \
+	((bus)->txglom && (bus)->txglom_flush && !(bus)->txglom_flushnow && \
+	 (pktq_mlen(&(bus)->txq, ~(bus)->flowcontrol) < TXGLOM_TARGET(bus)))
+
+/* Size of the tx superframe buffer, including room for alignment */
+#define TXGLOM_BUFSZ	(MAX_DATA_BUF + DHD_SDALIGN)
+
 /* Macros to get register read/write status */
 /* NOTE: these assume a local dhdsdio_bus_t *bus! */
 #define R_SDREG(regvar, regaddr, retryvar) \
@@ -858,6 +885,52 @@ dhd_enable_oob_intr(struct dhd_bus *bus, bool enable)
 	} while (0);
 
 
+/* Rounds a tx length up to what the SDIO write should carry */
+static uint16
+dhdsdio_txroundup(dhd_bus_t *bus, uint16 len)
+{
+	/* Raise len to next SDIO block to eliminate tail command */
+	if (bus->roundup && bus->blocksize && (len > bus->blocksize)) {
+		uint16 pad = bus->blocksize - (len % bus->blocksize);
+		if ((pad <= bus->roundup) && (pad < bus->blocksize))
+			len += pad;
+	} else if (len % DHD_SDALIGN) {
+		len += DHD_SDALIGN - (len % DHD_SDALIGN);
+	}
+
+	/* Some controllers have trouble with odd bytes -- round to even */
+	if (forcealign && (len & (ALIGNMENT - 1)))
+		len = ROUNDUP(len, ALIGNMENT);
+
+	return len;
+}
+
+/* On a failed F2 write, abort the command and terminate the frame */
+static void
+dhdsdio_txabort(dhd_bus_t *bus)
+{
+	bcmsdh_info_t *sdh = bus->sdh;
+	int i;
+
+	bus->tx_sderrs++;
+
+	bcmsdh_abort(sdh, SDIO_FUNC_2);
+	bcmsdh_cfg_write(sdh, SDIO_FUNC_1, SBSDIO_FUNC1_FRAMECTRL,
+	                 SFC_WF_TERM, NULL);
+	bus->f1regdata++;
+
+	for (i = 0; i < 3; i++) {
+		uint8 hi, lo;
+		hi = bcmsdh_cfg_read(sdh, SDIO_FUNC_1,
+		                     SBSDIO_FUNC1_WFRAMEBCHI, NULL);
+		lo = bcmsdh_cfg_read(sdh, SDIO_FUNC_1,
+		                     SBSDIO_FUNC1_WFRAMEBCLO, NULL);
+		bus->f1regdata += 2;
+		if ((hi == 0) && (lo == 0))
+			break;
+	}
+}
+
 /* Writes a HW/SW header into the packet and sends it. */
 /* Assumes: (a) header space already there, (b) caller holds lock */
 static int
@@ -871,7 +944,6 @@ dhdsdio_txpkt(dhd_bus_t *bus, void *pkt, uint chan, bool free_pkt)
 	uint retries = 0;
 	bcmsdh_info_t *sdh;
 	void *new;
-	int i;
 
 	DHD_TRACE(("%s: Enter\n", __FUNCTION__));
 
@@ -942,29 +1014,7 @@ dhdsdio_txpkt(dhd_bus_t *bus, void *pkt, uint chan, bool free_pkt)
 	}
 #endif
 
-	/* Raise len to next SDIO block to eliminate tail command */
-	if (bus->roundup && bus->blocksize && (len > bus->blocksize)) {
-		uint16 pad = bus->blocksize - (len % bus->blocksize);
-		if ((pad <= bus->roundup) && (pad < bus->blocksize))
-#ifdef NOTUSED
-			if (pad <= PKTTAILROOM(osh, pkt))
-#endif /* NOTUSED */
-				len += pad;
-	} else if (len % DHD_SDALIGN) {
-		len += DHD_SDALIGN - (len % DHD_SDALIGN);
-	}
-
-	/* Some controllers have trouble with odd bytes -- round to even */
-	if (forcealign && (len & (ALIGNMENT - 1))) {
-#ifdef NOTUSED
-		if (PKTTAILROOM(osh, pkt))
-#endif
-			len = ROUNDUP(len, ALIGNMENT);
-#ifdef NOTUSED
-		else
-			DHD_ERROR(("%s: sending unrounded %d-byte packet\n", __FUNCTION__, len));
-#endif
-	}
+	len = dhdsdio_txroundup(bus, len);
 
 	do {
 		ret = dhd_bcmsdh_send_buf(bus, bcmsdh_cur_sbwad(sdh), SDIO_FUNC_2, F2SYNC,
@@ -973,27 +1023,9 @@ dhdsdio_txpkt(dhd_bus_t *bus, void *pkt, uint chan, bool free_pkt)
 		ASSERT(ret != BCME_PENDING);
 
 		if (ret < 0) {
-			/* On failure, abort the command and terminate the frame */
 			DHD_INFO(("%s: sdio error %d, abort command and terminate frame.\n",
 			          __FUNCTION__, ret));
-			bus->tx_sderrs++;
-
-			bcmsdh_abort(sdh, SDIO_FUNC_2);
-			bcmsdh_cfg_write(sdh, SDIO_FUNC_1, SBSDIO_FUNC1_FRAMECTRL,
-			                 SFC_WF_TERM, NULL);
-			bus->f1regdata++;
-
-			for (i = 0; i < 3; i++) {
-				uint8 hi, lo;
-				hi = bcmsdh_cfg_read(sdh, SDIO_FUNC_1,
-				                     SBSDIO_FUNC1_WFRAMEBCHI, NULL);
-				lo = bcmsdh_cfg_read(sdh, SDIO_FUNC_1,
-				                     SBSDIO_FUNC1_WFRAMEBCLO, NULL);
-				bus->f1regdata += 2;
-				if ((hi == 0) && (lo == 0))
-					break;
-			}
-
+			dhdsdio_txabort(bus);
 		}
 	} while ((ret < 0) && retrydata && retries++ < TXRETRIES);
 
@@ -1010,6 +1042,130 @@ done:
 	return ret;
 }
 
+/* Copies several data frames into one superframe and sends it as a single
+ * F2 write.  The layout mirrors rx superframes: a header on the glom channel
+ * carrying the total length and the first sequence number, then each frame
+ * with its own HW/SW header on a DHD_SDALIGN boundary.  Frames that don't
+ * fit the buffer go out one by one after it.
+ * Assumes: (a) header space already there, (b) caller holds lock,
+ * (c) the window is open for all of them.  Always frees the packets.
+ */
+static int
+dhdsdio_txglom(dhd_bus_t *bus, void **pkts, uint npkts, uint chan)
+{
+	int ret;
+	osl_t *osh;
+	uint8 *frame;
+	uint16 len;
+	uint32 swheader;
+	uint retries = 0;
+	uint total, end, nglom, i;
+	uint8 seq;
+	bcmsdh_info_t *sdh;
+
+	DHD_TRACE(("%s: Enter\n", __FUNCTION__));
+
+	sdh = bus->sdh;
+	osh = bus->dhd->osh;
+
+	if (bus->dhd->dongle_reset) {
+		ret = BCME_NOTREADY;
+		nglom = npkts;
+		goto done;
+	}
+
+	/* Subframes follow the superframe header, padded to keep them aligned */
+	seq = bus->tx_seq;
+	total = end = DHD_SDALIGN;
+
+	for (nglom = 0; nglom < npkts; nglom++) {
+		len = (uint16)PKTLEN(osh, pkts[nglom]);
+
+		/* Leave room for rounding up the whole superframe */
+		if (total + ROUNDUP(len, DHD_SDALIGN) + bus->blocksize > MAX_DATA_BUF)
+			break;
+
+		frame = bus->txglomptr + total;
+		bcopy(PKTDATA(osh, pkts[nglom]), frame, len);
+
+		/* Hardware tag: 2 byte len followed by 2 byte ~len check (all LE) */
+		*(uint16*)frame = htol16(len);
+		*(((uint16*)frame) + 1) = htol16(~len);
+
+		/* Software tag: channel, sequence number, data offset */
+		swheader = ((chan << SDPCM_CHANNEL_SHIFT) & SDPCM_CHANNEL_MASK) | bus->tx_seq |
+		        ((SDPCM_HDRLEN << SDPCM_DOFFSET_SHIFT) & SDPCM_DOFFSET_MASK);
+		htol32_ua_store(swheader, frame + SDPCM_FRAMETAG_LEN);
+		htol32_ua_store(0, frame + SDPCM_FRAMETAG_LEN + sizeof(swheader));
+		bus->tx_seq = (bus->tx_seq + 1) % SDPCM_SEQUENCE_WRAP;
+
+#ifdef DHD_DEBUG
+		tx_packets[PKTPRIO(pkts[nglom])]++;
+		if (DHD_BYTES_ON() && DHD_DATA_ON())
+			prhex("Tx Subframe", frame, len);
+		else if (DHD_HDRS_ON())
+			prhex("TxHdr", frame, MIN(len, 16));
+#endif
+
+		/* Zero the gap up to the next subframe */
+		bzero(frame + len, ROUNDUP(len, DHD_SDALIGN) - len);
+		end = total + len;
+		total += ROUNDUP(len, DHD_SDALIGN);
+	}
+	ASSERT(nglom > 0);
+
+	/* Superframe header: length up to the end of the last subframe */
+	frame = bus->txglomptr;
+	bzero(frame, DHD_SDALIGN);
+	len = (uint16)end;
+	*(uint16*)frame = htol16(len);
+	*(((uint16*)frame) + 1) = htol16(~len);
+
+	swheader = ((SDPCM_GLOM_CHANNEL << SDPCM_CHANNEL_SHIFT) & SDPCM_CHANNEL_MASK) | seq |
+	        ((DHD_SDALIGN << SDPCM_DOFFSET_SHIFT) & SDPCM_DOFFSET_MASK);
+	htol32_ua_store(swheader, frame + SDPCM_FRAMETAG_LEN);
+
+	len = dhdsdio_txroundup(bus, len);
+	if (len > end)
+		bzero(bus->txglomptr + end, len - end);
+
+	do {
+		ret = dhd_bcmsdh_send_buf(bus, bcmsdh_cur_sbwad(sdh), SDIO_FUNC_2, F2SYNC,
+		                      bus->txglomptr, len, NULL, NULL, NULL);
+		bus->f2txdata++;
+		ASSERT(ret != BCME_PENDING);
+
+		if (ret < 0) {
+			DHD_INFO(("%s: sdio error %d, abort command and terminate superframe.\n",
+			          __FUNCTION__, ret));
+			dhdsdio_txabort(bus);
+		}
+	} while ((ret < 0) && retrydata && retries++ < TXRETRIES);
+
+	bus->txglomframes++;
+	bus->txglompkts += nglom;
+
+done:
+	/* restore pkt buffer pointers before calling tx complete routine */
+	dhd_os_sdunlock(bus->dhd);
+	for (i = 0; i < nglom; i++) {
+		PKTPULL(osh, pkts[i], SDPCM_HDRLEN);
+		dhd_txcomplete(bus->dhd, pkts[i], ret != 0);
+	}
+	dhd_os_sdlock(bus->dhd);
+
+	for (i = 0; i < nglom; i++)
+		PKTFREE(osh, pkts[i], TRUE);
+
+	/* Whatever didn't fit goes out on its own */
+	for (i = nglom; i < npkts; i++) {
+		if (dhdsdio_txpkt(bus, pkts[i], chan, TRUE))
+			ret = BCME_ERROR;
+	}
+
+	return ret;
+}
+
 int
 dhd_bus_txdata(struct dhd_bus *bus, void *pkt)
 {
@@ -1111,13 +1267,14 @@ dhd_bus_txdata(struct dhd_bus *bus, void *pkt)
 static uint
 dhdsdio_sendfromq(dhd_bus_t *bus, uint maxframes)
 {
-	void *pkt;
+	void *pkts[DHD_TXGLOM_MAX];
 	uint32 intstatus = 0;
 	uint retries = 0;
 	int ret = 0, prec_out;
 	uint cnt = 0;
 	uint datalen;
 	uint8 tx_prec_map;
+	uint chan, n, i;
 
 	dhd_pub_t *dhd = bus->dhd;
 	sdpcmd_regs_t *regs = bus->regs;
@@ -1126,24 +1283,40 @@ dhdsdio_sendfromq(dhd_bus_t *bus, uint maxframes)
 
 	tx_prec_map = ~bus->flowcontrol;
 
+#ifndef SDTEST
+	chan = SDPCM_DATA_CHANNEL;
+#else
+	chan = (bus->ext_loop ? SDPCM_TEST_CHANNEL : SDPCM_DATA_CHANNEL);
+#endif
+
 	/* Send frames until the limit or some other event */
-	for (cnt = 0; (cnt < maxframes) && DATAOK(bus); cnt++) {
-		dhd_os_sdlock_txq(bus->dhd);
-		if ((pkt = pktq_mdeq(&bus->txq, tx_prec_map, &prec_out)) == NULL) {
-			dhd_os_sdunlock_txq(bus->dhd);
+	for (cnt = 0; (cnt < maxframes) && DATAOK(bus); cnt += n) {
+		if (TXGLOM_HOLD(bus))
 			break;
+
+		/* Take as many frames as one write (and the window) will carry;
+		 * a superframe counts against maxframes as a whole.
+		 */
+		n = bus->txglom ? TXGLOM_TARGET(bus) : 1;
+
+		dhd_os_sdlock_txq(bus->dhd);
+		for (i = 0; i < n; i++) {
+			if ((pkts[i] = pktq_mdeq(&bus->txq, tx_prec_map, &prec_out)) == NULL)
+				break;
 		}
 		dhd_os_sdunlock_txq(bus->dhd);
-		datalen = PKTLEN(bus->dhd->osh, pkt) - SDPCM_HDRLEN;
+		if ((n = i) == 0)
+			break;
 
-#ifndef SDTEST
-		ret = dhdsdio_txpkt(bus, pkt, SDPCM_DATA_CHANNEL, TRUE);
-#else
-		ret = dhdsdio_txpkt(bus, pkt,
-		        (bus->ext_loop ? SDPCM_TEST_CHANNEL : SDPCM_DATA_CHANNEL), TRUE);
-#endif
+		for (datalen = 0, i = 0; i < n; i++)
+			datalen += PKTLEN(bus->dhd->osh, pkts[i]) - SDPCM_HDRLEN;
+
+		if (n == 1)
+			ret = dhdsdio_txpkt(bus, pkts[0], chan, TRUE);
+		else
+			ret = dhdsdio_txglom(bus, pkts, n, chan);
 		if (ret)
-			bus->dhd->tx_errors++;
+			bus->dhd->tx_errors += n;
 		else
 			bus->dhd->dstats.tx_bytes += datalen;
 
@@ -1160,6 +1333,12 @@ dhdsdio_sendfromq(dhd_bus_t *bus, uint maxframes)
 		}
 	}
 
+	/* Anything sent restarts the flush countdown */
+	if (cnt) {
+		bus->txglom_tick = 0;
+		bus->txglom_flushnow = FALSE;
+	}
+
 	/* Deflow-control stack if needed */
 	if (dhd_doflow && dhd->up && (dhd->busstate == DHD_BUS_DATA) &&
 	    dhd->txoff && (pktq_len(&bus->txq) < FCLOW))
@@ -1378,6 +1557,9 @@ enum {
 	IOV_IDLECLOCK,
 	IOV_SD1IDLE,
 	IOV_SLEEP,
+	IOV_TXGLOM,
+	IOV_TXGLOMDEPTH,
+	IOV_TXGLOMFLUSH,
 	IOV_VARS
 };
 
@@ -1398,6 +1580,9 @@ const bcm_iovar_t dhdsdio_iovars[] = {
 	{"alignctl",	IOV_ALIGNCTL,	0,	IOVT_BOOL,	0 },
 	{"sdalign",	IOV_SDALIGN,	0,	IOVT_BOOL,	0 },
 	{"devreset",	IOV_DEVRESET,	0,	IOVT_BOOL,	0 },
+	{"txglom",	IOV_TXGLOM,	0,	IOVT_BOOL,	0 },
+	{"txglomdepth",	IOV_TXGLOMDEPTH, 0,	IOVT_UINT32,	0 },
+	{"txglomflush",	IOV_TXGLOMFLUSH, 0,	IOVT_UINT32,	0 },
 #ifdef DHD_DEBUG
 	{"sdreg",	IOV_SDREG,	0,	IOVT_BUFFER,	sizeof(sdreg_t) },
 	{"sbreg",	IOV_SBREG,	0,	IOVT_BUFFER,	sizeof(sdreg_t) },
@@ -1456,6 +1641,9 @@ dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 	            bus->fc_rcvd, bus->fc_xoff, bus->fc_xon);
 	bcm_bprintf(strbuf, "rxglomfail %d, rxglomframes %d, rxglompkts %d\n",
 	            bus->rxglomfail, bus->rxglomframes, bus->rxglompkts);
+	bcm_bprintf(strbuf, "txglom %d depth %d flush %d, txglomframes %d, txglompkts %d, "
+	            "txglomflushes %d\n", bus->txglom, bus->txglom_depth, bus->txglom_flush,
+	            bus->txglomframes, bus->txglompkts, bus->txglomflushes);
 	bcm_bprintf(strbuf, "f2rx (hdrs/data) %d (%d/%d), f2tx %d f1regs %d\n",
 	            (bus->f2rxhdrs + bus->f2rxdata), bus->f2rxhdrs, bus->f2rxdata,
 	            bus->f2txdata, bus->f1regdata);
@@ -1473,6 +1661,11 @@ dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 		dhd_dump_pct(strbuf, ", pkts/glom", bus->rxglompkts, bus->rxglomframes);
 		bcm_bprintf(strbuf, "\n");
 
+		dhd_dump_pct(strbuf, "Tx: glom pct", (100 * bus->txglompkts),
+		             bus->dhd->tx_packets);
+		dhd_dump_pct(strbuf, ", pkts/glom", bus->txglompkts, bus->txglomframes);
+		bcm_bprintf(strbuf, "\n");
+
 		dhd_dump_pct(strbuf, "Tx: pkts/f2wr", bus->dhd->tx_packets, bus->f2txdata);
 		dhd_dump_pct(strbuf, ", pkts/f1sd", bus->dhd->tx_packets, bus->f1regdata);
 		dhd_dump_pct(strbuf, ", pkts/sd", bus->dhd->tx_packets,
@@ -1522,6 +1715,7 @@ dhd_bus_clearcounts(dhd_pub_t *dhdp)
 	bus->rx_hdrfail = bus->rx_badhdr = bus->rx_badseq = 0;
 	bus->tx_sderrs = bus->fc_rcvd = bus->fc_xoff = bus->fc_xon = 0;
 	bus->rxglomfail = bus->rxglomframes = bus->rxglompkts = 0;
+	bus->txglomframes = bus->txglompkts = bus->txglomflushes = 0;
 	bus->f2rxhdrs = bus->f2rxdata = bus->f2txdata = bus->f1regdata = 0;
 }
 
@@ -1884,6 +2078,49 @@ dhdsdio_doiovar(dhd_bus_t *bus, const bcm_iovar_t *vi, uint32 actionid, const ch
 		bcopy(&int_val, arg, val_size);
 		break;
 
+	case IOV_GVAL(IOV_TXGLOM):
+		int_val = (int32)bus->txglom;
+		bcopy(&int_val, arg, val_size);
+		break;
+
+	case IOV_SVAL(IOV_TXGLOM):
+		/* The superframe buffer is only needed once glomming is asked for */
+		if (bool_val && !bus->txglombuf) {
+			if (!(bus->txglombuf = MALLOC(bus->dhd->osh, TXGLOM_BUFSZ))) {
+				DHD_ERROR(("%s: MALLOC of %d-byte txglombuf failed\n",
+				           __FUNCTION__, TXGLOM_BUFSZ));
+				bcmerror = BCME_NOMEM;
+				break;
+			}
+			bus->txglomptr = (uint8*)ROUNDUP((uintptr)bus->txglombuf, DHD_SDALIGN);
+		}
+		bus->txglom = bool_val;
+		bus->txglom_tick = 0;
+		bus->txglom_flushnow = FALSE;
+		break;
+
+	case IOV_GVAL(IOV_TXGLOMDEPTH):
+		int_val = (int32)bus->txglom_depth;
+		bcopy(&int_val, arg, val_size);
+		break;
+
+	case IOV_SVAL(IOV_TXGLOMDEPTH):
+		if ((int_val < 1) || (int_val > DHD_TXGLOM_MAX))
+			bcmerror = BCME_RANGE;
+		else
+			bus->txglom_depth = (uint)int_val;
+		break;
+
+	case IOV_GVAL(IOV_TXGLOMFLUSH):
+		int_val = (int32)bus->txglom_flush;
+		bcopy(&int_val, arg, val_size);
+		break;
+
+	case IOV_SVAL(IOV_TXGLOMFLUSH):
+		bus->txglom_flush = (uint)int_val;
+		bus->txglom_tick = 0;
+		break;
+
 #ifdef DHD_DEBUG
 	case IOV_GVAL(IOV_VARS):
 		if (bus->varsz < (uint)len)
@@ -3939,7 +4176,8 @@ clkwait:
 	} else if (bus->clkstate == CLK_PENDING) {
 		/* Awaiting I_CHIPACTIVE; don't resched */
 	} else if (bus->intstatus || bus->ipend ||
-	           (!bus->fcstate && pktq_mlen(&bus->txq, ~bus->flowcontrol) && DATAOK(bus)) ||
+	           (!bus->fcstate && pktq_mlen(&bus->txq, ~bus->flowcontrol) && DATAOK(bus) &&
+	            !TXGLOM_HOLD(bus)) ||
 			PKT_AVAILABLE()) {  /* Read multiple frames */
 		resched = TRUE;
 	}
@@ -4319,6 +4557,21 @@ dhd_bus_watchdog(dhd_pub_t *dhdp)
 		bus->lastintrs = bus->intrcount;
 	}
 
+	/* Release a partial tx superframe that has been held long enough */
+	if (bus->txglom && bus->txglom_flush && pktq_mlen(&bus->txq, ~bus->flowcontrol)) {
+		if (++bus->txglom_tick >= bus->txglom_flush) {
+			bus->txglom_tick = 0;
+			bus->txglom_flushnow = TRUE;
+			bus->txglomflushes++;
+			if (!bus->dpc_sched) {
+				bus->dpc_sched = TRUE;
+				dhd_sched_dpc(bus->dhd);
+			}
+		}
+	} else {
+		bus->txglom_tick = 0;
+	}
+
 
 #ifdef SDTEST
 	/* Generate packets if configured */
@@ -4829,6 +5082,11 @@ dhdsdio_probe_init(dhd_bus_t *bus, osl_t *osh, void *sdh)
 	}
 	bus->use_rxchain = (bool)bus->sd_rxchain;
 
+	/* Tx glomming needs dongle support, so it stays off until asked for */
+	bus->txglom = FALSE;
+	bus->txglom_depth = DHD_TXGLOM_DEPTH;
+	bus->txglom_flush = DHD_TXGLOM_FLUSH;
+
 	return TRUE;
 }
 
@@ -4917,6 +5175,12 @@ dhdsdio_release_malloc(dhd_bus_t *bus, osl_t *osh)
 #endif
 		bus->databuf = NULL;
 	}
+
+	if (bus->txglombuf) {
+		MFREE(osh, bus->txglombuf, TXGLOM_BUFSZ);
+		bus->txglomptr = bus->txglombuf = NULL;
+		bus->txglom = FALSE;
+	}
 }
 
 
@@ -37,6 +37,6 @@ include $(CLEAR_VARS)
 
 LOCAL_MODULE:= libpower
 
-LOCAL_SRC_FILES += power/power.c
+LOCAL_SRC_FILES += power/power.c power/wakelock.c
 
 include $(BUILD_STATIC_LIBRARY)
@@ -33,6 +33,33 @@ enum {
 int acquire_wake_lock(int lock, const char* id);
 int release_wake_lock(const char* id);
 
+// Reference counted locks: id is held from the first wake_lock_acquire()
+// until as many wake_lock_release() calls, or for timeout_ms after
+// wake_lock_acquire_timeout() (a later call replaces the timeout, 0 cancels
+// it), whichever is later.  acquire_wake_lock() and release_wake_lock() on
+// the same id hold and drop it once more, uncounted.  The kernel only hears
+// about the lock when it is first needed and when it is no longer needed.
+// All return 0 or an errno value.
+int wake_lock_acquire(const char* id);
+int wake_lock_release(const char* id);
+int wake_lock_acquire_timeout(const char* id, int64_t timeout_ms);
+
+// Keeps id held for linger_ms after it is no longer needed, so that a lock
+// taken and dropped at high frequency is written to the kernel once per
+// burst rather than twice per use.
+int wake_lock_set_linger(const char* id, int linger_ms);
+
+struct wake_lock_stats {
+    uint32_t requests;      // acquire and release calls
+    uint32_t writes;        // of those, how many reached the kernel
+    int held;               // in the kernel now
+    int64_t total_ns;       // time held in the kernel, including now
+    int64_t max_ns;         // longest single hold
+};
+
+// 0, or ENOENT if id was never used
+int wake_lock_get_stats(const char* id, struct wake_lock_stats* stats);
+
 // true if you want the screen on, false if you want it off
 int set_screen_state(int on);
 
@@ -24,6 +24,53 @@ extern "C" {
 int uevent_init();
 int uevent_next_event(char* buffer, int buffer_length);
 
+/*
+ * Batched interface.  Every wakeup receives all the events pending on the
+ * socket at once (up to UEVENT_BATCH), and uevent_next_event() hands out
+ * what is left of a batch before waiting again.  Only one thread may
+ * receive events, whichever function it uses.
+ */
+
+#define UEVENT_BATCH        32
+#define UEVENT_MSG_LEN      2048    /* the kernel's UEVENT_BUFFER_SIZE */
+
+struct uevent {
+    const char *action;     /* ACTION, e.g. "add", "change" */
+    const char *path;       /* DEVPATH */
+    const char *subsystem;  /* SUBSYSTEM */
+    const char *buffer;     /* "action@path\0KEY=value\0...", as received */
+    int length;
+};
+
+/* Uses the already open socket fd instead of the kernel's uevent socket,
+   e.g. one end of a SOCK_DGRAM socketpair to replay events.  Returns 1. */
+int uevent_init_fd(int fd);
+
+/* Waits for events and stores up to max of them in events.  They stay
+   valid until the next call that receives events.  Returns how many,
+   at least 1; 0 without waiting if max is less than 1, and 0 once recv()
+   has returned 0 (an empty message, or a socket that was shut down) and
+   every event received before has been handed out.  uevent_next_event()
+   returns 0 then too. */
+int uevent_next_events(struct uevent *events, int max);
+
+/* The value of key in event, or NULL. */
+const char *uevent_get(const struct uevent *event, const char *key);
+
+typedef void (*uevent_callback)(const struct uevent *event, void *data);
+
+/* Calls callback for every event uevent_dispatch() receives from the given
+   subsystem with the given action; NULL (or "") matches any.  May be
+   called from any thread.  Returns an id for uevent_unsubscribe(), or -1
+   if there are too many subscribers or the names are too long. */
+int uevent_subscribe(const char *subsystem, const char *action,
+                     uevent_callback callback, void *data);
+void uevent_unsubscribe(int id);
+
+/* Waits for events, calls the subscribers of each and returns how many
+   events were received. */
+int uevent_dispatch();
+
 #if __cplusplus
 } // extern "C"
 #endif
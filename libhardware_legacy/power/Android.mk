@@ -1,6 +1,6 @@
 # Copyright 2006 The Android Open Source Project
 
-LOCAL_SRC_FILES += power/power.c
+LOCAL_SRC_FILES += power/power.c power/wakelock.c
 
 ifeq ($(QEMU_HARDWARE),true)
   LOCAL_SRC_FILES += power/power_qemu.c
@@ -31,6 +31,7 @@
 #include <utils/Log.h>
 
 #include "qemu.h"
+#include "wakelock.h"
 #ifdef QEMU_POWER
 #include "power_qemu.h"
 #endif
@@ -97,6 +98,8 @@ initialize_fds(void)
             LOGE("initialize_fds failed g_error=%d\n", g_error);
             return;
         }
+        wakelock_init(g_fds[ACQUIRE_PARTIAL_WAKE_LOCK],
+                      g_fds[RELEASE_WAKE_LOCK]);
         g_initialized = 1;
     }
 }
@@ -110,16 +113,12 @@ acquire_wake_lock(int lock, const char* id)
 
     if (g_error) return g_error;
 
-    int fd;
-
-    if (lock == PARTIAL_WAKE_LOCK) {
-        fd = g_fds[ACQUIRE_PARTIAL_WAKE_LOCK];
-    }
-    else {
+    if (lock != PARTIAL_WAKE_LOCK) {
         return EINVAL;
     }
 
-    return write(fd, id, strlen(id));
+    // what write() returned, when every call wrote
+    return wakelock_hold(id, 1) ? -1 : (int)strlen(id);
 }
 
 int
@@ -131,8 +130,31 @@ release_wake_lock(const char* id)
 
     if (g_error) return g_error;
 
-    ssize_t len = write(g_fds[RELEASE_WAKE_LOCK], id, strlen(id));
-    return len >= 0;
+    return wakelock_hold(id, 0) == 0;
+}
+
+int
+wake_lock_acquire(const char* id)
+{
+    initialize_fds();
+    if (g_error) return g_error;
+    return wakelock_acquire(id);
+}
+
+int
+wake_lock_release(const char* id)
+{
+    initialize_fds();
+    if (g_error) return g_error;
+    return wakelock_release(id);
+}
+
+int
+wake_lock_acquire_timeout(const char* id, int64_t timeout_ms)
+{
+    initialize_fds();
+    if (g_error) return g_error;
+    return wakelock_acquire_timeout(id, timeout_ms);
 }
 
 int
@@ -0,0 +1,448 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <hardware_legacy/power.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+#include <pthread.h>
+
+#define LOG_TAG "power"
+#include <utils/Log.h>
+
+#include "wakelock.h"
+
+#define NAME_MAX_LEN    64
+#define HASH_SIZE       32
+
+/* The timed and lingering locks wait in a hashed timer wheel: slot
+   (expiry / TICK_NS) % WHEEL_SLOTS, so that adding, moving and removing a
+   timer is O(1).  Entries a revolution or more away share slots with
+   nearer ones and are skipped until their turn comes. */
+#ifndef TICK_NS
+#define TICK_NS         10000000LL      /* 10 ms */
+#endif
+#ifndef WHEEL_SLOTS
+#define WHEEL_SLOTS     512
+#endif
+
+struct wakelock {
+    char name[NAME_MAX_LEN];
+    struct wakelock *hash_next;
+
+    int count;              /* wake_lock_acquire() holds */
+    int hold;               /* acquire_wake_lock() hold */
+    int64_t timed_until;    /* wake_lock_acquire_timeout(), or 0 */
+    int linger_ms;
+    int64_t linger_until;   /* no longer needed, released then; or 0 */
+
+    /* timer wheel, while timed_until or linger_until is set */
+    int slot;               /* -1 if not in the wheel */
+    int64_t expires;
+    struct wakelock *timer_next;
+    struct wakelock **timer_pprev;
+
+    int held;               /* in the kernel */
+    int64_t held_since;
+    struct wake_lock_stats stats;
+};
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static int g_acquire_fd = -1;
+static int g_release_fd = -1;
+static struct wakelock *g_hash[HASH_SIZE];
+
+static struct wakelock *g_wheel[WHEEL_SLOTS];
+static int g_timers;
+static int64_t g_wheel_now;     /* everything due before this has expired */
+static int64_t g_timer_wake;    /* when the timer thread wakes up, or 0 */
+static pthread_cond_t g_timer_cond = PTHREAD_COND_INITIALIZER;
+static int g_timer_thread;
+
+static int64_t systemTime()
+{
+    struct timespec t;
+    t.tv_sec = t.tv_nsec = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec*1000000000LL + t.tv_nsec;
+}
+
+void
+wakelock_init(int acquire_fd, int release_fd)
+{
+    pthread_mutex_lock(&g_lock);
+    g_acquire_fd = acquire_fd;
+    g_release_fd = release_fd;
+    pthread_mutex_unlock(&g_lock);
+}
+
+static unsigned
+hash_name(const char *name)
+{
+    unsigned h = 0;
+    while (*name)
+        h = h * 31 + (unsigned char)*name++;
+    return h % HASH_SIZE;
+}
+
+/* called with g_lock held */
+static struct wakelock *
+find_lock(const char *id, int create)
+{
+    unsigned h = hash_name(id);
+    struct wakelock *w;
+
+    for (w = g_hash[h]; w; w = w->hash_next) {
+        if (!strcmp(w->name, id))
+            return w;
+    }
+    if (!create)
+        return NULL;
+    if (strlen(id) >= NAME_MAX_LEN) {
+        LOGE("wake lock name '%s' too long", id);
+        return NULL;
+    }
+    w = calloc(1, sizeof(*w));
+    if (!w)
+        return NULL;
+    strcpy(w->name, id);
+    w->slot = -1;
+    w->hash_next = g_hash[h];
+    g_hash[h] = w;
+    return w;
+}
+
+/* kernel ********************************************************************/
+
+static int
+kernel_write(struct wakelock *w, int acquire, int64_t now)
+{
+    int fd = acquire ? g_acquire_fd : g_release_fd;
+    if (write(fd, w->name, strlen(w->name)) < 0) {
+        int err = errno;
+        LOGE("%s wake lock %s failed: %s",
+             acquire ? "acquiring" : "releasing", w->name, strerror(err));
+        return err;
+    }
+    w->stats.writes++;
+    if (acquire) {
+        w->held = 1;
+        w->held_since = now;
+    } else if (w->held) {
+        int64_t held = now - w->held_since;
+        w->held = 0;
+        w->stats.total_ns += held;
+        if (held > w->stats.max_ns)
+            w->stats.max_ns = held;
+    }
+    return 0;
+}
+
+/* timer wheel ***************************************************************/
+
+static void *timer_thread(void *arg);
+
+static void
+timer_remove(struct wakelock *w)
+{
+    if (w->slot < 0)
+        return;
+    *w->timer_pprev = w->timer_next;
+    if (w->timer_next)
+        w->timer_next->timer_pprev = w->timer_pprev;
+    w->slot = -1;
+    g_timers--;
+}
+
+static void
+timer_set(struct wakelock *w, int64_t expires)
+{
+    int slot = (expires / TICK_NS) % WHEEL_SLOTS;
+
+    if (w->slot == slot && w->expires == expires)
+        return;
+    timer_remove(w);
+    w->expires = expires;
+    w->slot = slot;
+    w->timer_pprev = &g_wheel[slot];
+    w->timer_next = g_wheel[slot];
+    if (w->timer_next)
+        w->timer_next->timer_pprev = &w->timer_next;
+    g_wheel[slot] = w;
+    g_timers++;
+
+    if (!g_timer_thread) {
+        pthread_t thread;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if (pthread_create(&thread, &attr, timer_thread, NULL) == 0)
+            g_timer_thread = 1;
+        else
+            LOGE("cannot start the wake lock timer thread");
+        pthread_attr_destroy(&attr);
+    }
+    if (!g_timer_wake || expires < g_timer_wake)
+        pthread_cond_signal(&g_timer_cond);
+}
+
+/* lock state ****************************************************************/
+
+static int
+needed(struct wakelock *w)
+{
+    return w->count > 0 || w->hold || w->timed_until;
+}
+
+static void
+schedule(struct wakelock *w)
+{
+    int64_t expires = w->timed_until > w->linger_until ?
+        w->timed_until : w->linger_until;
+    if (expires)
+        timer_set(w, expires);
+    else
+        timer_remove(w);
+}
+
+/* Brings the kernel in line with what w needs.  Returns 0 or errno. */
+static int
+update(struct wakelock *w, int64_t now)
+{
+    int err = 0;
+
+    if (needed(w)) {
+        w->linger_until = 0;
+        if (!w->held)
+            err = kernel_write(w, 1, now);
+    } else if (w->held && !w->linger_until) {
+        if (w->linger_ms > 0)
+            w->linger_until = now + w->linger_ms * 1000000LL;
+        else
+            err = kernel_write(w, 0, now);
+    }
+    schedule(w);
+    return err;
+}
+
+static void
+expire(struct wakelock *w, int64_t now)
+{
+    if (w->timed_until && w->timed_until <= now)
+        w->timed_until = 0;
+    if (w->linger_until && w->linger_until <= now) {
+        w->linger_until = 0;
+        if (!needed(w) && w->held)
+            kernel_write(w, 0, now);
+        schedule(w);
+        return;
+    }
+    update(w, now);
+}
+
+static void *
+timer_thread(void *arg)
+{
+    pthread_mutex_lock(&g_lock);
+    g_wheel_now = systemTime();
+    while (1) {
+        int64_t now = systemTime();
+        int64_t next = 0;
+        int64_t tick, last;
+
+        /* expire whatever is due in the slots passed since last time */
+        tick = g_wheel_now / TICK_NS;
+        last = now / TICK_NS;
+        if (last - tick >= WHEEL_SLOTS)
+            tick = last - WHEEL_SLOTS + 1;
+        for (; tick <= last; tick++) {
+            struct wakelock *w = g_wheel[tick % WHEEL_SLOTS];
+            while (w) {
+                struct wakelock *next_w = w->timer_next;
+                if (w->expires <= now)
+                    expire(w, now);
+                w = next_w;
+            }
+        }
+        g_wheel_now = now;
+
+        /* sleep until the first slot with something due in this turn */
+        if (g_timers) {
+            next = now + (int64_t)WHEEL_SLOTS * TICK_NS;
+            for (tick = now / TICK_NS;
+                 tick <= (now + (int64_t)WHEEL_SLOTS * TICK_NS) / TICK_NS;
+                 tick++) {
+                struct wakelock *w = g_wheel[tick % WHEEL_SLOTS];
+                int found = 0;
+                for (; w; w = w->timer_next) {
+                    if (w->expires / TICK_NS == tick && w->expires < next) {
+                        next = w->expires;
+                        found = 1;
+                    }
+                }
+                if (found)
+                    break;
+            }
+        }
+
+        g_timer_wake = next;
+        if (!g_timers) {
+            pthread_cond_wait(&g_timer_cond, &g_lock);
+        } else {
+            struct timeval tv;
+            struct timespec ts;
+            int64_t abs;
+            gettimeofday(&tv, NULL);
+            abs = tv.tv_sec * 1000000000LL + tv.tv_usec * 1000LL + next - now;
+            ts.tv_sec = abs / 1000000000LL;
+            ts.tv_nsec = abs % 1000000000LL;
+            pthread_cond_timedwait(&g_timer_cond, &g_lock, &ts);
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+    return NULL;
+}
+
+/* API ***********************************************************************/
+
+int
+wakelock_hold(const char *id, int hold)
+{
+    struct wakelock *w;
+    int err = ENOMEM, was;
+
+    pthread_mutex_lock(&g_lock);
+    w = find_lock(id, 1);
+    if (w && !hold && !w->held) {
+        /* Not held as far as this process knows, but it may have been
+           acquired by an earlier instance of it or by someone else using
+           the same id: release_wake_lock() has always reached the kernel. */
+        w->stats.requests++;
+        w->hold = 0;
+        err = kernel_write(w, 0, systemTime());
+    } else if (w) {
+        w->stats.requests++;
+        was = w->hold;
+        w->hold = hold;
+        err = update(w, systemTime());
+        if (err)
+            w->hold = was;
+    }
+    pthread_mutex_unlock(&g_lock);
+    return err;
+}
+
+int
+wakelock_acquire(const char *id)
+{
+    struct wakelock *w;
+    int err = ENOMEM;
+
+    pthread_mutex_lock(&g_lock);
+    w = find_lock(id, 1);
+    if (w) {
+        w->stats.requests++;
+        w->count++;
+        err = update(w, systemTime());
+        if (err)
+            w->count--;
+    }
+    pthread_mutex_unlock(&g_lock);
+    return err;
+}
+
+int
+wakelock_release(const char *id)
+{
+    struct wakelock *w;
+    int err = EINVAL;
+
+    pthread_mutex_lock(&g_lock);
+    w = find_lock(id, 0);
+    if (w && w->count > 0) {
+        w->stats.requests++;
+        w->count--;
+        err = update(w, systemTime());
+    } else {
+        LOGE("wake lock %s released more often than acquired", id);
+    }
+    pthread_mutex_unlock(&g_lock);
+    return err;
+}
+
+int
+wakelock_acquire_timeout(const char *id, int64_t timeout_ms)
+{
+    struct wakelock *w;
+    int err = ENOMEM;
+
+    pthread_mutex_lock(&g_lock);
+    w = find_lock(id, 1);
+    if (w) {
+        int64_t now = systemTime();
+        int64_t was = w->timed_until;
+        w->stats.requests++;
+        w->timed_until = timeout_ms > 0 ? now + timeout_ms * 1000000LL : 0;
+        err = update(w, now);
+        if (err) {
+            w->timed_until = was;
+            schedule(w);
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+    return err;
+}
+
+int
+wake_lock_set_linger(const char *id, int linger_ms)
+{
+    struct wakelock *w;
+    int err = ENOMEM;
+
+    pthread_mutex_lock(&g_lock);
+    w = find_lock(id, 1);
+    if (w) {
+        w->linger_ms = linger_ms > 0 ? linger_ms : 0;
+        err = 0;
+    }
+    pthread_mutex_unlock(&g_lock);
+    return err;
+}
+
+int
+wake_lock_get_stats(const char *id, struct wake_lock_stats *stats)
+{
+    struct wakelock *w;
+    int err = ENOENT;
+
+    pthread_mutex_lock(&g_lock);
+    w = find_lock(id, 0);
+    if (w) {
+        *stats = w->stats;
+        stats->held = w->held;
+        if (w->held) {
+            int64_t held = systemTime() - w->held_since;
+            stats->total_ns += held;
+            if (held > stats->max_ns)
+                stats->max_ns = held;
+        }
+        err = 0;
+    }
+    pthread_mutex_unlock(&g_lock);
+    return err;
+}
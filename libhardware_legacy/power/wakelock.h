@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _POWER_WAKELOCK_H
+#define _POWER_WAKELOCK_H
+
+#include <stdint.h>
+
+/*
+ * The in-process side of the wake locks: which ids this process needs,
+ * counted, timed and lingering, and the writes to the kernel's acquire and
+ * release files when that changes.  power.c opens the files and checks
+ * for errors before calling in; wake_lock_set_linger() and
+ * wake_lock_get_stats() are implemented here directly.
+ */
+
+void wakelock_init(int acquire_fd, int release_fd);
+
+/* acquire_wake_lock() and release_wake_lock(): hold is 1 or 0.  Releasing
+   a lock this process does not hold is still written to the kernel. */
+int wakelock_hold(const char *id, int hold);
+
+int wakelock_acquire(const char *id);
+int wakelock_release(const char *id);
+int wakelock_acquire_timeout(const char *id, int64_t timeout_ms);
+
+#endif /* _POWER_WAKELOCK_H */
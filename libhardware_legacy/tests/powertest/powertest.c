@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Checks the wake lock layer against a fake sysfs: the acquire and release
+ * files are plain files in a temporary directory, and every write the
+ * kernel would have seen is in them.  Built with a small timer wheel, so
+ * that timeouts go round it a few times.  Ends with the cost of a
+ * high-frequency acquire/release pair written through every time, as
+ * before, and cached.
+ *
+ *   powertest
+ */
+
+#include <hardware_legacy/power.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "wakelock.h"
+
+#define MS 1000000LL
+
+static char acquire_path[256];
+static char release_path[256];
+static int acquire_fd;
+static int release_fd;
+static int errors;
+
+#define CHECK(cond, ...) do {                                   \
+        if (!(cond)) {                                          \
+            fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__);\
+            fprintf(stderr, __VA_ARGS__);                       \
+            fprintf(stderr, "\n");                              \
+            errors++;                                           \
+        }                                                       \
+    } while (0)
+
+static int64_t now_ns()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static void sleep_ms(int ms)
+{
+    usleep(ms * 1000);
+}
+
+/* how often id was written to the fake sysfs file at path */
+static int writes_of(const char *path, const char *id)
+{
+    char buf[65536];
+    int fd = open(path, O_RDONLY), n = 0, len;
+    char *p;
+
+    if (fd < 0)
+        return -1;
+    len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len < 0)
+        return -1;
+    buf[len] = '\0';
+    for (p = strstr(buf, id); p; p = strstr(p + strlen(id), id))
+        n++;
+    return n;
+}
+
+static int held(const char *id)
+{
+    struct wake_lock_stats stats;
+    if (wake_lock_get_stats(id, &stats))
+        return 0;
+    return stats.held;
+}
+
+static void expect_writes(const char *id, int acquires, int releases)
+{
+    int a = writes_of(acquire_path, id);
+    int r = writes_of(release_path, id);
+    CHECK(a == acquires && r == releases,
+          "%s: %d acquire and %d release writes, expected %d and %d",
+          id, a, r, acquires, releases);
+}
+
+/*****************************************************************************/
+
+/* acquire_wake_lock() and release_wake_lock(): not counted, repeated
+   acquires no longer reach the kernel; a release of a lock this process
+   does not hold still does, someone else may hold it */
+static void test_hold()
+{
+    const char *id = "A-hold";
+    int i;
+
+    for (i = 0; i < 3; i++)
+        CHECK(wakelock_hold(id, 1) == 0, "hold %d", i);
+    CHECK(held(id), "%s not held", id);
+    expect_writes(id, 1, 0);
+    for (i = 0; i < 3; i++)
+        CHECK(wakelock_hold(id, 0) == 0, "unhold %d", i);
+    CHECK(!held(id), "%s still held", id);
+    expect_writes(id, 1, 3);
+
+    CHECK(wakelock_hold("A-elsewhere", 0) == 0, "release of unknown lock");
+    expect_writes("A-elsewhere", 0, 1);
+}
+
+static void test_counted()
+{
+    const char *id = "B-counted";
+    int i;
+
+    for (i = 0; i < 3; i++)
+        CHECK(wakelock_acquire(id) == 0, "acquire %d", i);
+    for (i = 0; i < 2; i++)
+        CHECK(wakelock_release(id) == 0, "release %d", i);
+    CHECK(held(id), "%s dropped with a hold left", id);
+    expect_writes(id, 1, 0);
+    CHECK(wakelock_release(id) == 0, "last release");
+    CHECK(!held(id), "%s still held", id);
+    expect_writes(id, 1, 1);
+    CHECK(wakelock_release(id) == EINVAL, "release without acquire");
+    CHECK(wakelock_release("B-never") == EINVAL, "release of unknown lock");
+}
+
+/* the uncounted hold and the counted ones add up */
+static void test_mixed()
+{
+    const char *id = "C-mixed";
+
+    wakelock_acquire(id);
+    wakelock_hold(id, 1);
+    wakelock_hold(id, 0);
+    CHECK(held(id), "%s dropped by release_wake_lock()", id);
+    wakelock_hold(id, 1);
+    wakelock_release(id);
+    CHECK(held(id), "%s dropped with acquire_wake_lock() hold", id);
+    wakelock_hold(id, 0);
+    CHECK(!held(id), "%s still held", id);
+    expect_writes(id, 1, 1);
+}
+
+static void test_timed()
+{
+    const char *id = "D-timed";
+    const char *id2 = "D2-timed-counted";
+    const char *id3 = "D3-cancelled";
+    struct wake_lock_stats stats;
+
+    CHECK(wakelock_acquire_timeout(id, 50) == 0, "timed acquire");
+    CHECK(wakelock_acquire_timeout(id2, 50) == 0, "timed acquire 2");
+    wakelock_acquire(id2);
+    wakelock_acquire_timeout(id3, 1000);
+    wakelock_acquire_timeout(id3, 0);
+    CHECK(!held(id3), "%s held after its timeout was cancelled", id3);
+    CHECK(held(id), "%s not held", id);
+    sleep_ms(150);
+    CHECK(!held(id), "%s held after its timeout", id);
+    CHECK(held(id2), "%s dropped with a counted hold left", id2);
+    wakelock_release(id2);
+    CHECK(!held(id2), "%s still held", id2);
+    expect_writes(id, 1, 1);
+    expect_writes(id2, 1, 1);
+    expect_writes(id3, 1, 1);
+
+    wake_lock_get_stats(id, &stats);
+    CHECK(stats.max_ns >= 50 * MS && stats.max_ns < 140 * MS,
+          "%s held %lld ms for a 50 ms timeout", id, stats.max_ns / MS);
+
+    /* a later timeout replaces an earlier one, either way */
+    wakelock_acquire_timeout(id, 400);
+    wakelock_acquire_timeout(id, 50);
+    sleep_ms(150);
+    CHECK(!held(id), "%s held past its shortened timeout", id);
+}
+
+/* many timers at once, some going round the wheel several times */
+static void test_many_timers()
+{
+    enum { COUNT = 200 };
+    char ids[COUNT][16];
+    int timeouts[COUNT];
+    int64_t start = now_ns();
+    int i, late = 0, early = 0;
+
+    srand(1);
+    for (i = 0; i < COUNT; i++) {
+        snprintf(ids[i], sizeof(ids[i]), "T%03d", i);
+        timeouts[i] = 10 + rand() % 390;
+        wakelock_acquire_timeout(ids[i], timeouts[i]);
+    }
+    sleep_ms(600);
+    for (i = 0; i < COUNT; i++) {
+        struct wake_lock_stats stats;
+        wake_lock_get_stats(ids[i], &stats);
+        CHECK(!stats.held, "%s held after %lld ms, timeout %d ms", ids[i],
+              (now_ns() - start) / MS, timeouts[i]);
+        if (stats.max_ns < timeouts[i] * MS)
+            early++;
+        if (stats.max_ns > timeouts[i] * MS + 60 * MS)
+            late++;
+    }
+    CHECK(!early, "%d of %d timed locks released early", early, COUNT);
+    CHECK(!late, "%d of %d timed locks released late", late, COUNT);
+}
+
+static void test_linger()
+{
+    const char *id = "E-linger";
+    struct wake_lock_stats stats;
+    int i;
+
+    wake_lock_set_linger(id, 50);
+    for (i = 0; i < 1000; i++) {
+        wakelock_acquire(id);
+        wakelock_release(id);
+    }
+    CHECK(held(id), "%s released without lingering", id);
+    expect_writes(id, 1, 0);
+    sleep_ms(150);
+    CHECK(!held(id), "%s still held after lingering", id);
+    expect_writes(id, 1, 1);
+    wake_lock_get_stats(id, &stats);
+    CHECK(stats.requests == 2000 && stats.writes == 2,
+          "%s: %u requests, %u writes", id, stats.requests, stats.writes);
+}
+
+static void test_write_errors()
+{
+    const char *id = "F-error";
+    int bad = open(acquire_path, O_RDONLY);
+
+    wakelock_init(bad, release_fd);
+    CHECK(wakelock_acquire(id) == EBADF, "acquire with a read-only fd");
+    CHECK(!held(id), "%s held after a failed write", id);
+    CHECK(wakelock_release(id) == EINVAL, "count kept after a failed write");
+    CHECK(wakelock_hold(id, 1) == EBADF, "hold with a read-only fd");
+    wakelock_init(acquire_fd, release_fd);
+    CHECK(wakelock_hold(id, 1) == 0 && held(id), "hold once the fd works");
+    wakelock_hold(id, 0);
+    close(bad);
+}
+
+/*****************************************************************************/
+
+static void bench()
+{
+    enum { PAIRS = 100000 };
+    const char *id = "G-bench";
+    int64_t t;
+    int i;
+
+    /* every call written, as acquire_wake_lock() used to */
+    t = now_ns();
+    for (i = 0; i < PAIRS; i++) {
+        write(acquire_fd, id, strlen(id));
+        write(release_fd, id, strlen(id));
+    }
+    t = now_ns() - t;
+    printf("write every call     %6.0f ns/pair\n", (double)t / PAIRS);
+    ftruncate(acquire_fd, 0);
+    ftruncate(release_fd, 0);
+
+    /* counted, inside an outer hold */
+    wakelock_acquire(id);
+    t = now_ns();
+    for (i = 0; i < PAIRS; i++) {
+        wakelock_acquire(id);
+        wakelock_release(id);
+    }
+    t = now_ns() - t;
+    wakelock_release(id);
+    printf("counted, held        %6.0f ns/pair\n", (double)t / PAIRS);
+
+    /* lingering */
+    wake_lock_set_linger(id, 100);
+    t = now_ns();
+    for (i = 0; i < PAIRS; i++) {
+        wakelock_acquire(id);
+        wakelock_release(id);
+    }
+    t = now_ns() - t;
+    printf("lingering            %6.0f ns/pair\n", (double)t / PAIRS);
+    wake_lock_set_linger(id, 0);
+    wakelock_acquire(id);
+    wakelock_release(id);
+    expect_writes(id, 2, 2);
+}
+
+int main(int argc, char **argv)
+{
+    char dir[] = "/tmp/powertest.XXXXXX";
+
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    snprintf(acquire_path, sizeof(acquire_path),
+             "%s/acquire_partial_wake_lock", dir);
+    snprintf(release_path, sizeof(release_path), "%s/release_wake_lock", dir);
+    acquire_fd = open(acquire_path, O_RDWR | O_CREAT | O_APPEND, 0600);
+    release_fd = open(release_path, O_RDWR | O_CREAT | O_APPEND, 0600);
+    if (acquire_fd < 0 || release_fd < 0) {
+        perror("fake sysfs");
+        return 1;
+    }
+    wakelock_init(acquire_fd, release_fd);
+
+    test_hold();
+    test_counted();
+    test_mixed();
+    test_write_errors();
+    test_timed();
+    test_many_timers();
+    test_linger();
+    bench();
+
+    close(acquire_fd);
+    close(release_fd);
+    unlink(acquire_path);
+    unlink(release_path);
+    rmdir(dir);
+
+    if (errors) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+    printf("all passed\n");
+    return 0;
+}
@@ -0,0 +1,31 @@
+# Copyright (C) 2010 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+LOCAL_PATH:= $(call my-dir)
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	ueventtest.c \
+	../../uevent/uevent.c
+
+LOCAL_C_INCLUDES:= \
+	$(LOCAL_PATH)/../../include
+
+LOCAL_LDLIBS:= -lpthread -lrt
+
+LOCAL_MODULE:= ueventtest
+
+LOCAL_MODULE_TAGS:= tests
+
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,502 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Replays uevent floods through one end of a SOCK_DGRAM socketpair and
+ * reads them from the other, once one event per poll()/recv() as
+ * uevent_next_event() used to, and once with uevent_dispatch() and a few
+ * subscribers, checking that every subscriber saw exactly the events it
+ * asked for.  Prints events per second and per wakeup for both.
+ *
+ * Besides the built-in floods (USB storage hotplug, battery, headset
+ * switch), captured floods can be given as files: one event per paragraph,
+ * its first line "action@devpath" and then a KEY=value line per field, as
+ * "udevadm monitor --kernel --property" shows them.
+ *
+ *   ueventtest [-n events] [capture file...]
+ */
+
+#include <hardware_legacy/uevent.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#define MAX_FLOOD_EVENTS    256
+
+struct flood {
+    const char *name;
+    int count;
+    char *events[MAX_FLOOD_EVENTS];
+    int lengths[MAX_FLOOD_EVENTS];
+};
+
+static const char *usb_flood[] = {
+    "add@/devices/platform/msm_hsusb/usb1/1-1",
+    "add@/devices/platform/msm_hsusb/usb1/1-1/1-1:1.0",
+    "add@/devices/platform/msm_hsusb/usb1/1-1/1-1:1.0/host0",
+    "add@/devices/platform/msm_hsusb/usb1/1-1/1-1:1.0/host0/scsi_host/host0",
+    "add@/devices/platform/msm_hsusb/usb1/1-1/1-1:1.0/host0/target0:0:0",
+    "add@/devices/platform/msm_hsusb/usb1/1-1/1-1:1.0/host0/target0:0:0/0:0:0:0",
+    "add@/devices/virtual/bdi/8:0",
+    "add@/block/sda",
+    "add@/block/sda/sda1",
+    "change@/devices/platform/msm_hsusb/usb1/1-1",
+    "remove@/block/sda/sda1",
+    "remove@/block/sda",
+    "remove@/devices/virtual/bdi/8:0",
+    "remove@/devices/platform/msm_hsusb/usb1/1-1/1-1:1.0/host0/target0:0:0/0:0:0:0",
+    "remove@/devices/platform/msm_hsusb/usb1/1-1/1-1:1.0/host0/scsi_host/host0",
+    "remove@/devices/platform/msm_hsusb/usb1/1-1",
+    NULL
+};
+
+static const char *usb_subsystems[] = {
+    "usb", "usb", "scsi", "scsi_host", "scsi", "scsi", "bdi", "block",
+    "block", "usb", "block", "block", "bdi", "scsi", "scsi_host", "usb",
+};
+
+static int events_wanted = 20000;
+static int errors;
+
+/*****************************************************************************/
+
+static void add_event(struct flood *f, const char *header, const char **fields)
+{
+    char buf[UEVENT_MSG_LEN];
+    int len = 0, i;
+
+    if (f->count == MAX_FLOOD_EVENTS)
+        return;
+    len += snprintf(buf, sizeof(buf), "%s", header) + 1;
+    for (i = 0; fields[i] && len < (int)sizeof(buf); i++)
+        len += snprintf(buf + len, sizeof(buf) - len, "%s", fields[i]) + 1;
+    if (len > (int)sizeof(buf))
+        len = sizeof(buf);
+    f->events[f->count] = malloc(len);
+    memcpy(f->events[f->count], buf, len);
+    f->lengths[f->count++] = len;
+}
+
+/* "action@path" plus the fields the kernel adds for it */
+static void add_kernel_event(struct flood *f, const char *header,
+                             const char *subsystem, int seqnum,
+                             const char **extra)
+{
+    char action[32], path[256], sub[64], seq[32];
+    const char *fields[16];
+    const char *at = strchr(header, '@');
+    int n = 0;
+
+    snprintf(action, sizeof(action), "ACTION=%.*s", (int)(at - header), header);
+    snprintf(path, sizeof(path), "DEVPATH=%s", at + 1);
+    snprintf(sub, sizeof(sub), "SUBSYSTEM=%s", subsystem);
+    snprintf(seq, sizeof(seq), "SEQNUM=%d", seqnum);
+    fields[n++] = action;
+    fields[n++] = path;
+    fields[n++] = sub;
+    while (extra && *extra && n < 15)
+        fields[n++] = *extra++;
+    fields[n++] = seq;
+    fields[n] = NULL;
+    add_event(f, header, fields);
+}
+
+static void builtin_floods(struct flood *floods, int *nfloods)
+{
+    static const char *battery[] = {
+        "POWER_SUPPLY_NAME=battery", "POWER_SUPPLY_STATUS=Charging",
+        "POWER_SUPPLY_HEALTH=Good", "POWER_SUPPLY_PRESENT=1",
+        "POWER_SUPPLY_TECHNOLOGY=Li-ion", "POWER_SUPPLY_CAPACITY=57", NULL
+    };
+    static const char *h2w_on[] = {
+        "SWITCH_NAME=h2w", "SWITCH_STATE=1", NULL
+    };
+    static const char *h2w_off[] = {
+        "SWITCH_NAME=h2w", "SWITCH_STATE=0", NULL
+    };
+    struct flood *f;
+    int i;
+
+    f = floods + (*nfloods)++;
+    f->name = "usb storage hotplug";
+    for (i = 0; usb_flood[i]; i++)
+        add_kernel_event(f, usb_flood[i], usb_subsystems[i], 1000 + i, NULL);
+
+    f = floods + (*nfloods)++;
+    f->name = "battery";
+    for (i = 0; i < 4; i++) {
+        add_kernel_event(f, "change@/devices/platform/msm-battery/power_supply/battery",
+                         "power_supply", 2000 + i, battery);
+    }
+
+    f = floods + (*nfloods)++;
+    f->name = "headset switch";
+    for (i = 0; i < 8; i++) {
+        add_kernel_event(f, "change@/devices/virtual/switch/h2w", "switch",
+                         3000 + i, i % 2 ? h2w_off : h2w_on);
+    }
+}
+
+static int load_capture(const char *file, struct flood *f)
+{
+    char line[512];
+    char *fields[64];
+    char header[256] = "";
+    int nfields = 0, i;
+    FILE *in = fopen(file, "r");
+
+    if (!in) {
+        perror(file);
+        return -1;
+    }
+    f->name = file;
+    while (1) {
+        char *l = fgets(line, sizeof(line), in);
+        int len = l ? (int)strlen(l) : 0;
+        while (len > 0 && (l[len - 1] == '\n' || l[len - 1] == '\r'))
+            l[--len] = '\0';
+        if (!l || !len) {
+            if (header[0]) {
+                fields[nfields] = NULL;
+                add_event(f, header, (const char **)fields);
+            }
+            for (i = 0; i < nfields; i++)
+                free(fields[i]);
+            nfields = 0;
+            header[0] = '\0';
+            if (!l)
+                break;
+        } else if (!header[0]) {
+            snprintf(header, sizeof(header), "%s", l);
+        } else if (nfields < 63) {
+            fields[nfields++] = strdup(l);
+        }
+    }
+    fclose(in);
+    return f->count ? 0 : -1;
+}
+
+/*****************************************************************************/
+
+struct writer {
+    int fd;
+    struct flood *flood;
+    int repeat;
+};
+
+static const char end_event[] = "exit@/\0ACTION=exit\0SUBSYSTEM=ueventtest";
+
+static void *writer_thread(void *arg)
+{
+    struct writer *w = arg;
+    int r, i;
+
+    for (r = 0; r < w->repeat; r++) {
+        for (i = 0; i < w->flood->count; i++) {
+            if (send(w->fd, w->flood->events[i], w->flood->lengths[i], 0) < 0)
+                perror("send");
+        }
+    }
+    send(w->fd, end_event, sizeof(end_event), 0);
+    return NULL;
+}
+
+static double now_seconds()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void start_writer(struct writer *w, pthread_t *thread, int *sv,
+                         struct flood *f)
+{
+    int sz = 1024 * 1024;
+
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, sv) < 0) {
+        perror("socketpair");
+        exit(1);
+    }
+    setsockopt(sv[0], SOL_SOCKET, SO_RCVBUF, &sz, sizeof(sz));
+    setsockopt(sv[1], SOL_SOCKET, SO_SNDBUF, &sz, sizeof(sz));
+    w->fd = sv[1];
+    w->flood = f;
+    w->repeat = (events_wanted + f->count - 1) / f->count;
+    pthread_create(thread, NULL, writer_thread, w);
+}
+
+/* one poll() and one recv() per event, the way uevent_next_event() was */
+static void run_single(struct flood *f)
+{
+    char buf[UEVENT_MSG_LEN];
+    struct writer w;
+    pthread_t thread;
+    int sv[2], events = 0, wakeups = 0;
+    double start = now_seconds(), t;
+
+    start_writer(&w, &thread, sv, f);
+    while (1) {
+        struct pollfd fds;
+        int count;
+
+        fds.fd = sv[0];
+        fds.events = POLLIN;
+        fds.revents = 0;
+        if (poll(&fds, 1, -1) <= 0)
+            continue;
+        wakeups++;
+        count = recv(sv[0], buf, sizeof(buf), 0);
+        if (count == sizeof(end_event) && !memcmp(buf, end_event, count))
+            break;
+        if (count > 0)
+            events++;
+    }
+    t = now_seconds() - start;
+    pthread_join(thread, NULL);
+    close(sv[0]);
+    close(sv[1]);
+
+    printf("  single    %6d events %6d wakeups  %5.1f events/wakeup  %8.0f events/s\n",
+           events, wakeups, (double)events / wakeups, events / t);
+}
+
+struct counter {
+    int seen;
+    int done;
+};
+
+static void count_event(const struct uevent *event, void *data)
+{
+    ((struct counter *)data)->seen++;
+}
+
+static void end_of_flood(const struct uevent *event, void *data)
+{
+    ((struct counter *)data)->done = 1;
+}
+
+/* the subscribers: every subsystem in the flood, "add" from any subsystem,
+   and everything */
+static void run_batched(struct flood *f)
+{
+    struct writer w;
+    pthread_t thread;
+    int sv[2], ids[MAX_FLOOD_EVENTS + 3], nids = 0;
+    const char *subsystems[MAX_FLOOD_EVENTS];
+    struct counter counters[MAX_FLOOD_EVENTS], adds, all, end;
+    int expected[MAX_FLOOD_EVENTS], expected_adds = 0;
+    int nsub = 0, events = 0, wakeups = 0, i, j;
+    double start, t;
+
+    memset(counters, 0, sizeof(counters));
+    memset(expected, 0, sizeof(expected));
+    memset(&adds, 0, sizeof(adds));
+    memset(&all, 0, sizeof(all));
+    memset(&end, 0, sizeof(end));
+
+    for (i = 0; i < f->count; i++) {
+        struct uevent e;
+        const char *sub, *action;
+
+        e.buffer = f->events[i];
+        e.length = f->lengths[i];
+        sub = uevent_get(&e, "SUBSYSTEM");
+        action = uevent_get(&e, "ACTION");
+        if (!sub)
+            sub = "";
+        for (j = 0; j < nsub && strcmp(subsystems[j], sub); j++)
+            ;
+        if (j == nsub && sub[0] && nsub < 12) {
+            subsystems[nsub++] = sub;
+            ids[nids++] = uevent_subscribe(sub, NULL, count_event, counters + j);
+        }
+        if (j < nsub)
+            expected[j]++;
+        if (action && !strcmp(action, "add"))
+            expected_adds++;
+    }
+    ids[nids++] = uevent_subscribe(NULL, "add", count_event, &adds);
+    ids[nids++] = uevent_subscribe(NULL, NULL, count_event, &all);
+    ids[nids++] = uevent_subscribe("ueventtest", "exit", end_of_flood, &end);
+    for (i = 0; i < nids; i++) {
+        if (ids[i] < 0) {
+            fprintf(stderr, "FAIL %s: subscriber %d refused\n", f->name, i);
+            errors++;
+        }
+    }
+
+    start_writer(&w, &thread, sv, f);
+    uevent_init_fd(sv[0]);
+    start = now_seconds();
+    while (!end.done) {
+        events += uevent_dispatch();
+        wakeups++;
+    }
+    t = now_seconds() - start;
+    pthread_join(thread, NULL);
+    close(sv[0]);
+    close(sv[1]);
+    for (i = 0; i < nids; i++)
+        uevent_unsubscribe(ids[i]);
+
+    events--;   /* the end marker */
+    printf("  batched   %6d events %6d wakeups  %5.1f events/wakeup  %8.0f events/s\n",
+           events, wakeups, (double)events / wakeups, events / t);
+
+    for (j = 0; j < nsub; j++) {
+        if (counters[j].seen != expected[j] * w.repeat) {
+            fprintf(stderr, "FAIL %s: subsystem %s saw %d events, expected %d\n",
+                    f->name, subsystems[j], counters[j].seen,
+                    expected[j] * w.repeat);
+            errors++;
+        }
+    }
+    if (adds.seen != expected_adds * w.repeat) {
+        fprintf(stderr, "FAIL %s: %d add events, expected %d\n", f->name,
+                adds.seen, expected_adds * w.repeat);
+        errors++;
+    }
+    if (all.seen != events + 1 || events != f->count * w.repeat) {
+        fprintf(stderr, "FAIL %s: %d events seen, %d received, %d sent\n",
+                f->name, all.seen - 1, events, f->count * w.repeat);
+        errors++;
+    }
+}
+
+/* uevent_next_event() and uevent_next_events() share the batch, and both
+   keep the events whole and in order */
+static void test_mixed(struct flood *f)
+{
+    char buf[UEVENT_MSG_LEN];
+    struct uevent events[4];
+    int sv[2], i = 0, j, n, k;
+
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, sv) < 0) {
+        perror("socketpair");
+        exit(1);
+    }
+    for (k = 0; k < f->count && k < 10; k++)
+        send(sv[1], f->events[k], f->lengths[k], 0);
+    uevent_init_fd(sv[0]);
+
+    while (i < k) {
+        if (i % 3 == 0) {
+            n = uevent_next_event(buf, sizeof(buf));
+            if (n != f->lengths[i] || memcmp(buf, f->events[i], n)) {
+                fprintf(stderr, "FAIL mixed: event %d differs\n", i);
+                errors++;
+            }
+            i++;
+        } else {
+            n = uevent_next_events(events, 2);
+            for (j = 0; j < n; j++, i++) {
+                const char *path = uevent_get(events + j, "DEVPATH");
+                if (events[j].length != f->lengths[i] ||
+                        memcmp(events[j].buffer, f->events[i], f->lengths[i]) ||
+                        !path || strcmp(path, events[j].path)) {
+                    fprintf(stderr, "FAIL mixed: event %d differs\n", i);
+                    errors++;
+                }
+            }
+        }
+    }
+    close(sv[0]);
+    close(sv[1]);
+}
+
+/* an empty message ends the stream, as recv() returning 0 does: what was
+   queued before it is still handed out, and then both functions return 0
+   instead of polling forever */
+static void test_shutdown(struct flood *f)
+{
+    char buf[UEVENT_MSG_LEN];
+    struct uevent events[UEVENT_BATCH];
+    int sv[2], k, n, got = 0;
+
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, sv) < 0) {
+        perror("socketpair");
+        exit(1);
+    }
+    for (k = 0; k < f->count && k < 5; k++)
+        send(sv[1], f->events[k], f->lengths[k], 0);
+    send(sv[1], "", 0, 0);
+    uevent_init_fd(sv[0]);
+
+    if (uevent_next_events(events, 0) != 0) {
+        fprintf(stderr, "FAIL shutdown: events returned for max 0\n");
+        errors++;
+    }
+    while ((n = uevent_next_events(events, 2)) > 0)
+        got += n;
+    if (got != k) {
+        fprintf(stderr, "FAIL shutdown: %d events before the end, sent %d\n",
+                got, k);
+        errors++;
+    }
+    if (uevent_next_event(buf, sizeof(buf)) != 0 ||
+            uevent_next_events(events, UEVENT_BATCH) != 0) {
+        fprintf(stderr, "FAIL shutdown: events after the end\n");
+        errors++;
+    }
+    close(sv[0]);
+    close(sv[1]);
+}
+
+int main(int argc, char **argv)
+{
+    struct flood floods[16];
+    int nfloods = 0, i, j;
+
+    memset(floods, 0, sizeof(floods));
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            events_wanted = atoi(argv[++i]);
+        } else if (nfloods < 16) {
+            if (load_capture(argv[i], floods + nfloods) == 0)
+                nfloods++;
+            else
+                return 1;
+        }
+    }
+    if (!nfloods)
+        builtin_floods(floods, &nfloods);
+
+    test_mixed(floods);
+    test_shutdown(floods);
+    for (i = 0; i < nfloods; i++) {
+        printf("%s (%d events)\n", floods[i].name, floods[i].count);
+        run_single(floods + i);
+        run_batched(floods + i);
+    }
+    for (i = 0; i < nfloods; i++) {
+        for (j = 0; j < floods[i].count; j++)
+            free(floods[i].events[j]);
+    }
+
+    if (errors) {
+        printf("%d errors\n", errors);
+        return 1;
+    }
+    printf("all passed\n");
+    return 0;
+}
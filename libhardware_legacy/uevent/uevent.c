@@ -19,19 +19,57 @@
 #include <string.h>
 #include <unistd.h>
 #include <poll.h>
+#include <errno.h>
+#include <pthread.h>
 
 #include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <linux/netlink.h>
 
+/* big enough for a hotplug storm to wait while we handle the last batch */
+#define UEVENT_RCVBUF       (256*1024)
+
+#define MAX_SUBSCRIBERS     16
+#define MAX_FILTER_LEN      32
 
 static int fd = -1;
 
+/* the last batch received, and the next message in it to hand out */
+static char batch[UEVENT_BATCH][UEVENT_MSG_LEN + 1];
+static int batch_len[UEVENT_BATCH];
+static int batch_count;
+static int batch_next;
+/* recv() returned 0: the socket was shut down */
+static int stream_ended;
+
+#ifdef __NR_recvmmsg
+/* struct mmsghdr, which not every libc has */
+struct uevent_mmsghdr {
+    struct msghdr msg_hdr;
+    unsigned int msg_len;
+};
+
+static int have_recvmmsg = 1;
+#endif
+
+struct subscriber {
+    int used;
+    char subsystem[MAX_FILTER_LEN];
+    char action[MAX_FILTER_LEN];
+    uevent_callback callback;
+    void *data;
+};
+
+static pthread_mutex_t subscribers_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct subscriber subscribers[MAX_SUBSCRIBERS];
+
 /* Returns 0 on failure, 1 on success */
 int uevent_init()
 {
     struct sockaddr_nl addr;
-    int sz = 64*1024;
+    int sz = UEVENT_RCVBUF;
     int s;
 
     memset(&addr, 0, sizeof(addr));
@@ -43,36 +81,240 @@ int uevent_init()
     if(s < 0)
         return 0;
 
-    setsockopt(s, SOL_SOCKET, SO_RCVBUFFORCE, &sz, sizeof(sz));
+    /* SO_RCVBUFFORCE needs CAP_NET_ADMIN; otherwise take what rmem_max
+       allows */
+    if (setsockopt(s, SOL_SOCKET, SO_RCVBUFFORCE, &sz, sizeof(sz)) < 0)
+        setsockopt(s, SOL_SOCKET, SO_RCVBUF, &sz, sizeof(sz));
 
     if(bind(s, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
         close(s);
         return 0;
     }
 
-    fd = s;
+    uevent_init_fd(s);
     return (fd > 0);
 }
 
-int uevent_next_event(char* buffer, int buffer_length)
+int uevent_init_fd(int s)
+{
+    fd = s;
+    batch_count = 0;
+    batch_next = 0;
+    stream_ended = 0;
+    return 1;
+}
+
+/* Receives whatever is pending, without blocking; returns how many
+   messages.  An empty one is the end of the stream: what came before it
+   is kept, nothing after it is received. */
+static int receive_pending()
 {
-    while (1) {
+    int n;
+
+#ifdef __NR_recvmmsg
+    if (have_recvmmsg) {
+        struct uevent_mmsghdr msgs[UEVENT_BATCH];
+        struct iovec iov[UEVENT_BATCH];
+        int i, kept;
+
+        memset(msgs, 0, sizeof(msgs));
+        for (i = 0; i < UEVENT_BATCH; i++) {
+            iov[i].iov_base = batch[i];
+            iov[i].iov_len = UEVENT_MSG_LEN;
+            msgs[i].msg_hdr.msg_iov = iov + i;
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        n = syscall(__NR_recvmmsg, fd, msgs, UEVENT_BATCH, MSG_DONTWAIT, NULL);
+        if (n >= 0) {
+            /* drop truncated messages */
+            for (i = 0, kept = 0; i < n; i++) {
+                if (msgs[i].msg_len == 0) {
+                    stream_ended = 1;
+                    break;
+                }
+                if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+                    continue;
+                if (kept != i)
+                    memcpy(batch[kept], batch[i], msgs[i].msg_len);
+                batch_len[kept++] = msgs[i].msg_len;
+            }
+            return kept;
+        }
+        if (errno != ENOSYS)
+            return 0;
+        /* kernel older than 2.6.33 */
+        have_recvmmsg = 0;
+    }
+#endif
+
+    for (n = 0; n < UEVENT_BATCH; ) {
+        int count = recv(fd, batch[n], UEVENT_MSG_LEN, MSG_DONTWAIT);
+        if (count < 0)
+            break;
+        if (count == 0) {
+            stream_ended = 1;
+            break;
+        }
+        batch_len[n++] = count;
+    }
+    return n;
+}
+
+/* Makes sure there is a message left in the batch, waiting for one if
+   need be.  Returns 0 once the stream has ended and the batch is used
+   up. */
+static int fill_batch()
+{
+    while (batch_next >= batch_count) {
         struct pollfd fds;
         int nr;
-    
+
+        if (stream_ended)
+            return 0;
+
         fds.fd = fd;
         fds.events = POLLIN;
         fds.revents = 0;
         nr = poll(&fds, 1, -1);
-     
+
         if(nr > 0 && fds.revents == POLLIN) {
-            int count = recv(fd, buffer, buffer_length, 0);
-            if (count > 0) {
-                return count;
-            } 
+            batch_count = receive_pending();
+            batch_next = 0;
+        }
+    }
+    return 1;
+}
+
+int uevent_next_event(char* buffer, int buffer_length)
+{
+    int count;
+
+    if (!fill_batch())
+        return 0;
+    count = batch_len[batch_next];
+    if (count > buffer_length)
+        count = buffer_length;
+    memcpy(buffer, batch[batch_next], count);
+    batch_next++;
+    return count;
+}
+
+static void parse_event(int i, struct uevent *event)
+{
+    const char *s = batch[i];
+    const char *end = s + batch_len[i];
+
+    batch[i][batch_len[i]] = '\0';
+    event->action = "";
+    event->path = "";
+    event->subsystem = "";
+    event->buffer = s;
+    event->length = batch_len[i];
+
+    /* skip "action@path", then the fields */
+    s += strlen(s) + 1;
+    while (s < end) {
+        if (!strncmp(s, "ACTION=", 7))
+            event->action = s + 7;
+        else if (!strncmp(s, "DEVPATH=", 8))
+            event->path = s + 8;
+        else if (!strncmp(s, "SUBSYSTEM=", 10))
+            event->subsystem = s + 10;
+        s += strlen(s) + 1;
+    }
+}
+
+int uevent_next_events(struct uevent *events, int max)
+{
+    int n = 0;
+
+    if (max < 1 || !fill_batch())
+        return 0;
+    while (n < max && batch_next < batch_count)
+        parse_event(batch_next++, events + n++);
+    return n;
+}
+
+const char *uevent_get(const struct uevent *event, const char *key)
+{
+    const char *s = event->buffer;
+    const char *end = s + event->length;
+    size_t len = strlen(key);
+
+    s += strlen(s) + 1;
+    while (s < end) {
+        if (!strncmp(s, key, len) && s[len] == '=')
+            return s + len + 1;
+        s += strlen(s) + 1;
+    }
+    return NULL;
+}
+
+int uevent_subscribe(const char *subsystem, const char *action,
+                     uevent_callback callback, void *data)
+{
+    int id;
+
+    if (!subsystem)
+        subsystem = "";
+    if (!action)
+        action = "";
+    if (strlen(subsystem) >= MAX_FILTER_LEN || strlen(action) >= MAX_FILTER_LEN)
+        return -1;
+
+    pthread_mutex_lock(&subscribers_lock);
+    for (id = 0; id < MAX_SUBSCRIBERS; id++) {
+        struct subscriber *s = subscribers + id;
+        if (!s->used) {
+            strcpy(s->subsystem, subsystem);
+            strcpy(s->action, action);
+            s->callback = callback;
+            s->data = data;
+            s->used = 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&subscribers_lock);
+    return id < MAX_SUBSCRIBERS ? id : -1;
+}
+
+void uevent_unsubscribe(int id)
+{
+    if (id < 0 || id >= MAX_SUBSCRIBERS)
+        return;
+    pthread_mutex_lock(&subscribers_lock);
+    subscribers[id].used = 0;
+    pthread_mutex_unlock(&subscribers_lock);
+}
+
+static int matches(const char *filter, const char *value)
+{
+    return !filter[0] || !strcmp(filter, value);
+}
+
+int uevent_dispatch()
+{
+    struct uevent events[UEVENT_BATCH];
+    struct subscriber subs[MAX_SUBSCRIBERS];
+    int count, nsubs, i, j;
+
+    count = uevent_next_events(events, UEVENT_BATCH);
+
+    /* the callbacks run on a copy, so that they may subscribe and
+       unsubscribe */
+    pthread_mutex_lock(&subscribers_lock);
+    for (i = 0, nsubs = 0; i < MAX_SUBSCRIBERS; i++) {
+        if (subscribers[i].used)
+            subs[nsubs++] = subscribers[i];
+    }
+    pthread_mutex_unlock(&subscribers_lock);
+
+    for (i = 0; i < count; i++) {
+        for (j = 0; j < nsubs; j++) {
+            if (matches(subs[j].subsystem, events[i].subsystem) &&
+                    matches(subs[j].action, events[i].action))
+                subs[j].callback(events + i, subs[j].data);
         }
     }
-    
-    // won't get here
-    return 0;
+    return count;
 }
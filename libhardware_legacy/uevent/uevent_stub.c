@@ -31,3 +31,38 @@ int uevent_next_event(char* buffer, int buffer_length)
     // won't get here
     return 0;
 }
+
+int uevent_init_fd(int fd)
+{
+    return 1;
+}
+
+int uevent_next_events(struct uevent *events, int max)
+{
+    while (1) {
+        sleep(10000);
+    }
+
+    // won't get here
+    return 0;
+}
+
+const char *uevent_get(const struct uevent *event, const char *key)
+{
+    return NULL;
+}
+
+int uevent_subscribe(const char *subsystem, const char *action,
+                     uevent_callback callback, void *data)
+{
+    return 0;
+}
+
+void uevent_unsubscribe(int id)
+{
+}
+
+int uevent_dispatch()
+{
+    return uevent_next_events(NULL, 0);
+}
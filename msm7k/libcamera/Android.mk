@@ -13,9 +13,9 @@ include $(CLEAR_VARS)
 LOCAL_CFLAGS:=-fno-short-enums
 LOCAL_CFLAGS+=-DDLOPEN_LIBQCAMERA=$(DLOPEN_LIBQCAMERA)
 
-LOCAL_SRC_FILES:= QualcommCameraHardware.cpp
+LOCAL_SRC_FILES:= QualcommCameraHardware.cpp JpegFragmentList.cpp PreviewFrameRing.cpp
 
-LOCAL_SHARED_LIBRARIES:= libutils libbinder libui liblog libcamera_client
+LOCAL_SHARED_LIBRARIES:= libutils libcutils libbinder libui liblog libcamera_client
 ifneq ($(DLOPEN_LIBQCAMERA),1)
 LOCAL_SHARED_LIBRARIES+= liboemcamera
 else
@@ -26,5 +26,7 @@ LOCAL_MODULE:= libcamera
 
 include $(BUILD_SHARED_LIBRARY)
 
+include $(call all-makefiles-under,$(LOCAL_PATH))
+
 endif # not BUILD_TINY_ANDROID
 endif # not BUILD_OLD_LIBCAMERA
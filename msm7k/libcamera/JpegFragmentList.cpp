@@ -0,0 +1,257 @@
+/*
+** Copyright 2010, The Android Open-Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#define LOG_TAG "JpegFragmentList"
+#include <utils/Log.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "JpegFragmentList.h"
+
+namespace android {
+
+    JpegFragmentList::JpegFragmentList(uint8_t *base, size_t size)
+        : mBase(base),
+          mHeapSize(size),
+          mFragments(NULL),
+          mCount(0),
+          mCapacity(0),
+          mSize(0),
+          mBufferHead(0),
+          mBufferCount(0),
+          mNext(0)
+    {
+        memset(&mStats, 0, sizeof(mStats));
+    }
+
+    JpegFragmentList::~JpegFragmentList()
+    {
+        free(mFragments);
+    }
+
+    void JpegFragmentList::reset()
+    {
+        mCount = 0;
+        mSize = 0;
+        mBufferHead = 0;
+        mBufferCount = 0;
+        mNext = 0;
+        memset(&mStats, 0, sizeof(mStats));
+    }
+
+    uint8_t *JpegFragmentList::nextBuffer(size_t maxLen, size_t *len)
+    {
+        *len = 0;
+        if (mBufferCount == MAX_BUFFERS) {
+            LOGE("more than %d JPEG encoder buffers", MAX_BUFFERS);
+            return NULL;
+        }
+        // queued even when the heap is full, so that the add() for this
+        // buffer finds it
+        Buffer &b = mBuffers[(mBufferHead + mBufferCount) % MAX_BUFFERS];
+        b.offset = mNext;
+        b.len = 0;
+        if (mNext < mHeapSize)
+            b.len = mHeapSize - mNext < maxLen ? mHeapSize - mNext : maxLen;
+        mBufferCount++;
+        mNext += b.len;
+        if (!b.len)
+            return NULL;
+        *len = b.len;
+        return mBase + b.offset;
+    }
+
+    bool JpegFragmentList::append(size_t offset, size_t size)
+    {
+        if (mCount && mFragments[mCount - 1].offset + mFragments[mCount - 1].size
+                == offset) {
+            // written right after the previous one: same fragment as far as
+            // the image is concerned
+            mFragments[mCount - 1].size += size;
+            mSize += size;
+            return true;
+        }
+        if (mCount == mCapacity) {
+            size_t capacity = mCapacity ? mCapacity * 2 : 16;
+            Fragment *f = (Fragment *)realloc(mFragments,
+                                              capacity * sizeof(Fragment));
+            if (f == NULL) {
+                LOGE("out of memory for JPEG fragment %d", (int)mCount);
+                return false;
+            }
+            mFragments = f;
+            mCapacity = capacity;
+        }
+        mFragments[mCount].offset = offset;
+        mFragments[mCount].size = size;
+        mCount++;
+        mSize += size;
+        return true;
+    }
+
+    size_t JpegFragmentList::add(const uint8_t *data, size_t size)
+    {
+        if (!mBufferCount) {
+            LOGE("JPEG fragment for a buffer never handed out");
+            mStats.truncated += size;
+            return 0;
+        }
+        Buffer b = mBuffers[mBufferHead];
+        mBufferHead = (mBufferHead + 1) % MAX_BUFFERS;
+        mBufferCount--;
+
+        if (size > b.len) {
+            mStats.truncated += size - b.len;
+            size = b.len;
+        }
+        if (data == mBase + b.offset) {
+            mStats.inPlace += size;
+        } else {
+            memmove(mBase + b.offset, data, size);
+            mStats.copied += size;
+        }
+        bool kept = !size || append(b.offset, size);
+
+        if (!mBufferCount) {
+            // nothing outstanding: the next buffer goes right after this
+            mNext = b.offset + (kept ? size : 0);
+        }
+        return kept ? size : 0;
+    }
+
+    bool JpegFragmentList::contiguous() const
+    {
+        return mCount <= 1;
+    }
+
+    size_t JpegFragmentList::flatten()
+    {
+        if (!mCount)
+            return 0;
+        // every fragment moves down, so moving them in order never
+        // overwrites one that is still to be moved
+        size_t offset = mFragments[0].offset + mFragments[0].size;
+        for (size_t i = 1; i < mCount; i++) {
+            Fragment &f = mFragments[i];
+            if (f.offset != offset) {
+                memmove(mBase + offset, mBase + f.offset, f.size);
+                mStats.moved += f.size;
+            }
+            offset += f.size;
+        }
+        mFragments[0].size = mSize;
+        mCount = 1;
+        return mFragments[0].offset;
+    }
+
+    size_t JpegFragmentList::read(size_t pos, void *dst, size_t n) const
+    {
+        uint8_t *out = (uint8_t *)dst;
+        size_t done = 0;
+        for (size_t i = 0; i < mCount && done < n; i++) {
+            const Fragment &f = mFragments[i];
+            if (pos >= f.size) {
+                pos -= f.size;
+                continue;
+            }
+            size_t len = f.size - pos < n - done ? f.size - pos : n - done;
+            memcpy(out + done, mBase + f.offset + pos, len);
+            done += len;
+            pos = 0;
+        }
+        return done;
+    }
+
+    JpegEncoderBuffers::JpegEncoderBuffers()
+        : mFragments(NULL),
+          mEnc(NULL),
+          mCount(0)
+    {
+        memset(mBounce, 0, sizeof(mBounce));
+    }
+
+    JpegEncoderBuffers::~JpegEncoderBuffers()
+    {
+        release();
+    }
+
+    void JpegEncoderBuffers::start(JpegFragmentList *fragments,
+                                   camera_encode_mem_type *enc, int count)
+    {
+        release();
+        if (count > JpegFragmentList::MAX_BUFFERS) {
+            LOGE("%d JPEG encoder buffers, using %d", count,
+                 JpegFragmentList::MAX_BUFFERS);
+            count = JpegFragmentList::MAX_BUFFERS;
+        }
+        mFragments = fragments;
+        mEnc = enc;
+        mCount = count;
+
+        mFragments->reset();
+        for (int i = 0; i < mCount; i++) {
+            mBounce[i] = (uint8_t *)malloc(MAX_JPEG_ENCODE_BUF_LEN);
+            mEnc[i].buffer = mBounce[i];
+            mEnc[i].buf_len = MAX_JPEG_ENCODE_BUF_LEN;
+            mEnc[i].used_len = 0;
+            next(i);
+        }
+    }
+
+    size_t JpegEncoderBuffers::receive(int index, uint32_t size)
+    {
+        if (index < 0 || index >= mCount) {
+            LOGE("JPEG fragment from encoder buffer %d of %d", index, mCount);
+            return 0;
+        }
+        // Normally the encoder wrote this into the heap already, and this
+        // only records where.
+        size_t kept = mFragments->add(mEnc[index].buffer, size);
+        next(index);
+        mEnc[index].used_len = 0;
+        return kept;
+    }
+
+    // Points encoder buffer index at where its next fragment goes in the
+    // heap, or at its own buffer once the heap is full.
+
+    void JpegEncoderBuffers::next(int index)
+    {
+        camera_encode_mem_type *enc = mEnc + index;
+        size_t len;
+        uint8_t *buffer = mFragments->nextBuffer(MAX_JPEG_ENCODE_BUF_LEN, &len);
+        if (buffer != NULL) {
+            enc->buffer = buffer;
+            enc->buf_len = len;
+        } else {
+            enc->buffer = mBounce[index];
+            enc->buf_len = MAX_JPEG_ENCODE_BUF_LEN;
+        }
+    }
+
+    void JpegEncoderBuffers::release()
+    {
+        for (int i = 0; i < mCount; i++) {
+            free(mBounce[i]);
+            mBounce[i] = NULL;
+            memset(mEnc + i, 0, sizeof(camera_encode_mem_type));
+        }
+        mFragments = NULL;
+        mEnc = NULL;
+        mCount = 0;
+    }
+
+}; // namespace android
@@ -0,0 +1,153 @@
+/*
+** Copyright 2010, The Android Open-Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef ANDROID_HARDWARE_JPEG_FRAGMENT_LIST_H
+#define ANDROID_HARDWARE_JPEG_FRAGMENT_LIST_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "camera_ifc.h"
+
+namespace android {
+
+// The JPEG image being encoded, as the list of fragments the encoder
+// returned, kept in the memory of the JPEG heap.
+//
+// The encoder is given its output buffers out of the heap (nextBuffer()),
+// one after the other, so the fragments it returns are already where they
+// belong and add() only records them.  Once no buffer is outstanding the
+// next one starts right after the last fragment, so with one encoder
+// buffer the image is always contiguous.  With several, a fragment that
+// does not fill its buffer leaves a gap before the next one, and the image
+// is only contiguous once flatten() has moved the fragments together,
+// which is only needed when someone wants a single buffer.  A fragment the
+// encoder wrote somewhere else is copied into its buffer.
+
+class JpegFragmentList {
+public:
+    // encoder buffers outstanding at most
+    enum { MAX_BUFFERS = 4 };
+
+    struct Fragment {
+        size_t offset;      // in the heap
+        size_t size;
+    };
+
+    struct Stats {
+        size_t inPlace;     // bytes the encoder wrote where they stay
+        size_t copied;      // bytes copied in from outside the heap
+        size_t moved;       // bytes moved by flatten()
+        size_t truncated;   // bytes that did not fit
+    };
+
+    // base and size: the memory the image is assembled in
+    JpegFragmentList(uint8_t *base, size_t size);
+    ~JpegFragmentList();
+
+    // forgets the image, to start a new one
+    void reset();
+
+    // Where the encoder should write the next fragment, and in *len how
+    // much it may write there (at most maxLen); NULL when the heap is full.
+    // Every call is matched by one add(), in the same order.
+    uint8_t *nextBuffer(size_t maxLen, size_t *len);
+
+    // Records the fragment the encoder returned in the oldest outstanding
+    // buffer, found at data.  Returns the number of bytes kept, less than
+    // size if the heap is full.
+    size_t add(const uint8_t *data, size_t size);
+
+    size_t count() const { return mCount; }
+    const Fragment &fragment(size_t i) const { return mFragments[i]; }
+    // bytes in the image
+    size_t size() const { return mSize; }
+    bool contiguous() const;
+
+    // Moves the fragments together, unless they already are, and returns
+    // the offset of the image in the heap.
+    size_t flatten();
+
+    // Gathers up to n bytes of the image starting at pos into dst,
+    // without flattening it.  Returns the number of bytes read.
+    size_t read(size_t pos, void *dst, size_t n) const;
+
+    const Stats &stats() const { return mStats; }
+
+private:
+    JpegFragmentList(const JpegFragmentList &);
+    JpegFragmentList &operator=(const JpegFragmentList &);
+
+    struct Buffer {
+        size_t offset;
+        size_t len;
+    };
+
+    bool append(size_t offset, size_t size);
+
+    uint8_t *mBase;
+    size_t mHeapSize;
+    Fragment *mFragments;
+    size_t mCount;
+    size_t mCapacity;
+    size_t mSize;
+    Buffer mBuffers[MAX_BUFFERS];   // handed out, oldest first
+    size_t mBufferHead;
+    size_t mBufferCount;
+    size_t mNext;                   // where the next buffer starts
+    Stats mStats;
+};
+
+// The encoder's output buffers (camera_encode_mem_type) for an image
+// assembled in a JpegFragmentList: each one points at where its next
+// fragment goes in the heap, or at a malloc'd buffer of its own once the
+// heap is full, so that an oversized image is truncated rather than
+// written past the heap.
+
+class JpegEncoderBuffers {
+public:
+    JpegEncoderBuffers();
+    ~JpegEncoderBuffers();
+
+    // Starts a new image in fragments with count encoder buffers enc[],
+    // at most JpegFragmentList::MAX_BUFFERS, and gives each its first
+    // buffer.
+    void start(JpegFragmentList *fragments, camera_encode_mem_type *enc,
+               int count);
+
+    // Records the fragment of size bytes the encoder returned in
+    // enc[index] and gives that buffer the next one.  Returns the number
+    // of bytes kept, less than size if the heap is full.
+    size_t receive(int index, uint32_t size);
+
+    // Frees the encoder's own buffers and clears enc[].
+    void release();
+
+private:
+    JpegEncoderBuffers(const JpegEncoderBuffers &);
+    JpegEncoderBuffers &operator=(const JpegEncoderBuffers &);
+
+    void next(int index);
+
+    JpegFragmentList *mFragments;
+    camera_encode_mem_type *mEnc;
+    int mCount;
+    uint8_t *mBounce[JpegFragmentList::MAX_BUFFERS];
+};
+
+}; // namespace android
+
+#endif
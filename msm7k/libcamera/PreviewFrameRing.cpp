@@ -0,0 +1,235 @@
+/*
+** Copyright 2010, The Android Open-Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#define LOG_TAG "PreviewFrameRing"
+#include <utils/Log.h>
+#include <string.h>
+
+#include "PreviewFrameRing.h"
+
+namespace android {
+
+    PreviewFrameRing::PreviewFrameRing()
+        : mStopped(true),
+          mBase(NULL),
+          mBufferSize(0),
+          mCount(0),
+          mMaxQueued(0),
+          mOrderHead(0),
+          mOrderCount(0),
+          mQueued(0),
+          mPredicted(0)
+    {
+        memset(mSlots, 0, sizeof(mSlots));
+        memset(&mStats, 0, sizeof(mStats));
+    }
+
+    void PreviewFrameRing::start(const void *base, size_t bufferSize,
+                                 int count, int maxQueued)
+    {
+        Mutex::Autolock lock(&mLock);
+        if (count > MAX_SLOTS) {
+            LOGE("%d preview buffers, only using %d", count, MAX_SLOTS);
+            count = MAX_SLOTS;
+        }
+        mBase = (const uint8_t *)base;
+        mBufferSize = bufferSize;
+        mCount = count;
+        mMaxQueued = maxQueued;
+        memset(mSlots, 0, sizeof(mSlots));
+        for (int i = 0; i < MAX_SLOTS; i++)
+            mSlots[i].state = SLOT_DRIVER;
+        mOrderHead = 0;
+        mOrderCount = 0;
+        mQueued = 0;
+        mPredicted = 0;
+        memset(&mStats, 0, sizeof(mStats));
+        mStopped = false;
+    }
+
+    void PreviewFrameRing::stop()
+    {
+        Mutex::Autolock lock(&mLock);
+        mStopped = true;
+        mQueuedCond.broadcast();
+    }
+
+    int PreviewFrameRing::slotOf(const void *addr)
+    {
+        const uint8_t *p = (const uint8_t *)addr;
+        if (!mBufferSize || p < mBase ||
+                p >= mBase + mCount * mBufferSize)
+            return -1;
+        return (p - mBase) / mBufferSize;
+    }
+
+    int PreviewFrameRing::oldest(State state) const
+    {
+        for (int i = 0; i < mOrderCount; i++) {
+            int slot = mOrder[(mOrderHead + i) % MAX_SLOTS];
+            if (mSlots[slot].state == state)
+                return slot;
+        }
+        return -1;
+    }
+
+    int PreviewFrameRing::giveBack(nsecs_t now)
+    {
+        int n = 0;
+        while (mOrderCount && mSlots[mOrder[mOrderHead]].state == SLOT_DONE) {
+            Slot &s = mSlots[mOrder[mOrderHead]];
+            s.state = SLOT_DRIVER;
+            nsecs_t latency = now - s.received;
+            mStats.returnTotal += latency;
+            if (latency > mStats.returnMax)
+                mStats.returnMax = latency;
+            mOrderHead = (mOrderHead + 1) % MAX_SLOTS;
+            mOrderCount--;
+            n++;
+        }
+        return n;
+    }
+
+    int PreviewFrameRing::receive(const void *addr, nsecs_t now, int *release)
+    {
+        Mutex::Autolock lock(&mLock);
+        *release = 0;
+        if (mStopped)
+            return -1;
+
+        // The driver fills its buffers in turn, so the frame is almost
+        // always in the slot after the last one.
+        const uint8_t *p = (const uint8_t *)addr;
+        int slot = mPredicted;
+        if (p < mBase + slot * mBufferSize ||
+                p >= mBase + (slot + 1) * mBufferSize) {
+            slot = slotOf(addr);
+            if (slot < 0)
+                return -1;
+            mStats.mispredicted++;
+        }
+
+        Slot &s = mSlots[slot];
+        if (s.state != SLOT_DRIVER) {
+            LOGE("preview buffer %d received while not with the driver "
+                 "(state %d)", slot, s.state);
+            return -1;
+        }
+        s.state = SLOT_QUEUED;
+        s.released = false;
+        s.received = now;
+        mOrder[(mOrderHead + mOrderCount) % MAX_SLOTS] = slot;
+        mOrderCount++;
+        mQueued++;
+        mStats.frames++;
+        mPredicted = (slot + 1) % mCount;
+
+        if (mMaxQueued > 0) {
+            while (mQueued > mMaxQueued) {
+                mSlots[oldest(SLOT_QUEUED)].state = SLOT_DONE;
+                mQueued--;
+                mStats.dropped++;
+            }
+        }
+
+        *release = giveBack(now);
+        if (mOrderCount == mCount)
+            mStats.starved++;
+        mQueuedCond.signal();
+        return slot;
+    }
+
+    bool PreviewFrameRing::wait()
+    {
+        Mutex::Autolock lock(&mLock);
+        while (!mStopped && !mQueued)
+            mQueuedCond.wait(mLock);
+        return !mStopped;
+    }
+
+    int PreviewFrameRing::take(nsecs_t now)
+    {
+        Mutex::Autolock lock(&mLock);
+        int slot = oldest(SLOT_QUEUED);
+        if (slot < 0)
+            return -1;
+        Slot &s = mSlots[slot];
+        s.state = SLOT_DELIVERING;
+        mQueued--;
+        nsecs_t latency = now - s.received;
+        mStats.waitTotal += latency;
+        if (latency > mStats.waitMax)
+            mStats.waitMax = latency;
+        return slot;
+    }
+
+    int PreviewFrameRing::delivered(int slot, bool hold, nsecs_t now)
+    {
+        Mutex::Autolock lock(&mLock);
+        Slot &s = mSlots[slot];
+        if (s.state != SLOT_DELIVERING) {
+            LOGE("preview buffer %d delivered while in state %d",
+                 slot, s.state);
+            return 0;
+        }
+        mStats.delivered++;
+        s.state = hold && !s.released ? SLOT_CLIENT : SLOT_DONE;
+        s.released = false;
+        return giveBack(now);
+    }
+
+    int PreviewFrameRing::release(const void *addr, nsecs_t now)
+    {
+        Mutex::Autolock lock(&mLock);
+        int slot = slotOf(addr);
+        if (slot >= 0 && mSlots[slot].state == SLOT_DELIVERING) {
+            // the client let go before the callback even returned
+            mSlots[slot].released = true;
+            return 0;
+        }
+        if (slot < 0 || mSlots[slot].state != SLOT_CLIENT) {
+            // not a frame the client holds: let go of the oldest one it
+            // does, as if frames were always released in order
+            slot = oldest(SLOT_CLIENT);
+            if (slot < 0) {
+                LOGE("recording frame %p released, but none is held", addr);
+                return 0;
+            }
+            LOGW("recording frame %p released, but not held; releasing "
+                 "buffer %d instead", addr, slot);
+        }
+        mSlots[slot].state = SLOT_DONE;
+        return giveBack(now);
+    }
+
+    int PreviewFrameRing::count(State state) const
+    {
+        Mutex::Autolock lock(&mLock);
+        int n = 0;
+        for (int i = 0; i < mCount; i++) {
+            if (mSlots[i].state == state)
+                n++;
+        }
+        return n;
+    }
+
+    PreviewFrameRing::Stats PreviewFrameRing::stats() const
+    {
+        Mutex::Autolock lock(&mLock);
+        return mStats;
+    }
+
+}; // namespace android
@@ -0,0 +1,136 @@
+/*
+** Copyright 2010, The Android Open-Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef ANDROID_HARDWARE_PREVIEW_FRAME_RING_H
+#define ANDROID_HARDWARE_PREVIEW_FRAME_RING_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <utils/threads.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+// Who owns each buffer of the preview heap.
+//
+// The driver fills the buffers and hands them to us one at a time
+// (receive()); a separate thread passes them on to the callbacks (take(),
+// delivered()), and the recording client may keep a frame until it calls
+// releaseRecordingFrame() (release()).  libqcamera takes buffers back
+// strictly in the order it handed them out, one per
+// camera_release_frame() call, so a finished frame is only given back once
+// every older frame is finished too; the methods that finish frames
+// return how many buffers may go back to the driver.
+//
+// While frames wait for the delivery thread, at most maxQueued are kept:
+// when a newer one arrives the oldest waiting frame is dropped, so a slow
+// consumer skips frames instead of keeping buffers from the driver.  With
+// maxQueued 0 nothing is dropped.  A frame held up in the callbacks, or
+// by the recording client, still keeps every newer buffer from the
+// driver.
+//
+// Times are passed in by the caller so that the ring can be driven by a
+// simulated clock.
+
+class PreviewFrameRing {
+public:
+    enum { MAX_SLOTS = 8 };
+
+    enum State {
+        SLOT_DRIVER,        // being filled by the driver
+        SLOT_QUEUED,        // waiting for the delivery thread
+        SLOT_DELIVERING,    // in the callbacks
+        SLOT_CLIENT,        // kept by the recording client
+        SLOT_DONE,          // finished, waiting for older frames
+    };
+
+    struct Stats {
+        uint32_t frames;        // received from the driver
+        uint32_t delivered;
+        uint32_t dropped;
+        uint32_t starved;       // frames after which the driver had no buffer
+        uint32_t mispredicted;  // frames not in the slot after the last one
+        nsecs_t waitTotal;      // received -> delivery started
+        nsecs_t waitMax;
+        nsecs_t returnTotal;    // received -> given back to the driver
+        nsecs_t returnMax;
+    };
+
+    PreviewFrameRing();
+
+    // Starts over with count buffers of bufferSize bytes each, starting at
+    // base, all owned by the driver.
+    void start(const void *base, size_t bufferSize, int count, int maxQueued);
+    // Wakes up and fails wait(); frames still outstanding are forgotten.
+    void stop();
+
+    // A frame the driver filled in the buffer at addr.  Returns its slot,
+    // or -1 if addr is not one of ours; *release is set to the number of
+    // buffers to give back to the driver (frames dropped to make room).
+    int receive(const void *addr, nsecs_t now, int *release);
+
+    // Blocks until a frame is queued; false once stopped.
+    bool wait();
+    // The oldest queued frame, now being delivered, or -1 if none.
+    int take(nsecs_t now);
+    // The callbacks are done with slot; hold if the recording client kept
+    // it.  Returns the number of buffers to give back.
+    int delivered(int slot, bool hold, nsecs_t now);
+    // The recording client is done with the frame at addr.  Returns the
+    // number of buffers to give back.
+    int release(const void *addr, nsecs_t now);
+
+    State state(int slot) const { return mSlots[slot].state; }
+    int count(State state) const;
+    Stats stats() const;
+
+private:
+    PreviewFrameRing(const PreviewFrameRing &);
+    PreviewFrameRing &operator=(const PreviewFrameRing &);
+
+    struct Slot {
+        State state;
+        bool released;      // by the client, while still being delivered
+        nsecs_t received;
+    };
+
+    int slotOf(const void *addr);
+    int oldest(State state) const;
+    int giveBack(nsecs_t now);
+
+    mutable Mutex mLock;
+    Condition mQueuedCond;
+    bool mStopped;
+
+    const uint8_t *mBase;
+    size_t mBufferSize;
+    int mCount;
+    int mMaxQueued;
+    Slot mSlots[MAX_SLOTS];
+
+    // slots out of the driver's hands, in the order it handed them out
+    int mOrder[MAX_SLOTS];
+    int mOrderHead;
+    int mOrderCount;
+
+    int mQueued;
+    int mPredicted;     // slot the next frame is expected in
+    Stats mStats;
+};
+
+}; // namespace android
+
+#endif
@@ -24,6 +24,7 @@
 #include <utils/threads.h>
 #include <binder/MemoryHeapPmem.h>
 #include <utils/String16.h>
+#include <cutils/properties.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/ioctl.h>
@@ -501,6 +502,20 @@ namespace android {
         if (mJpegHeap != 0) {
             mJpegHeap->dump(fd, args);
         }
+        if (mPreviewThread != 0) {
+            PreviewFrameRing::Stats stats = mPreviewRing.stats();
+            uint32_t frames = stats.frames ? stats.frames : 1;
+            snprintf(buffer, 255, "preview frames %d: %d delivered, %d dropped, "
+                     "driver starved %d, mispredicted %d\n",
+                     stats.frames, stats.delivered, stats.dropped,
+                     stats.starved, stats.mispredicted);
+            write(fd, buffer, strlen(buffer));
+            snprintf(buffer, 255, "preview latency (us): wait avg %lld max %lld, "
+                     "return avg %lld max %lld\n",
+                     stats.waitTotal / frames / 1000, stats.waitMax / 1000,
+                     stats.returnTotal / frames / 1000, stats.returnMax / 1000);
+            write(fd, buffer, strlen(buffer));
+        }
         mParameters.dump(fd, args);
         return NO_ERROR;
     }
@@ -536,6 +551,17 @@ namespace android {
             return false;
         }
 
+        // How many frames may wait for a slow callback before the oldest
+        // is dropped; 0 never drops any.
+        char value[PROPERTY_VALUE_MAX];
+        property_get("debug.camera.preview.queue", value, "1");
+        mPreviewRing.start(mPreviewHeap->mHeap->base(),
+                           mPreviewHeap->mBufferSize,
+                           kPreviewBufferCount,
+                           atoi(value));
+        mPreviewThread = new PreviewThread(this);
+        mPreviewThread->run("CameraPreview", ANDROID_PRIORITY_DISPLAY);
+
 //      LINK_camera_af_init();
 
         return true;
@@ -543,6 +569,11 @@ namespace android {
 
     void QualcommCameraHardware::deinitPreview()
     {
+        if (mPreviewThread != NULL) {
+            mPreviewRing.stop();
+            mPreviewThread->requestExitAndWait();
+            mPreviewThread.clear();
+        }
         mPreviewHeap = NULL;
     }
 
@@ -591,12 +622,7 @@ namespace android {
 
         if (initJpegHeap) {
             LOGV("initRaw: initializing mJpegHeap.");
-            mJpegHeap =
-                new AshmemPool(mJpegMaxSize,
-                               kJpegBufferCount,
-                               0, // we do not know how big the picture wil be
-                               0,
-                               "jpeg");
+            mJpegHeap = new JpegPool(mJpegMaxSize, "jpeg");
             if (!mJpegHeap->initialized()) {
                 LOGE("initRaw X failed: error initializing mJpegHeap.");
                 mJpegHeap = NULL;
@@ -754,6 +780,7 @@ namespace android {
         else {
             LOGE("startPreview failed: sensor error.");
             mCameraState = QCS_ERROR;
+            deinitPreview();
         }
 
         LOGV("startPreview X");
@@ -793,7 +820,7 @@ namespace android {
         }
 
         LOGV("stopPreviewInternal: Freeing preview heap.");
-        mPreviewHeap = NULL;
+        deinitPreview();
         mPreviewCallback = NULL;
 
         LOGV("stopPreviewInternal: X Preview has stopped.");
@@ -855,11 +882,14 @@ namespace android {
             mRecordingCallback != NULL;
     }
 
+    // Not under mLock, so that the recording callback may release the frame
+    // it was given right away; mPreviewRing has its own lock.
+
     void QualcommCameraHardware::releaseRecordingFrame(
-        const sp<IMemory>& mem __attribute__((unused)))
+        const sp<IMemory>& mem)
     {
-        Mutex::Autolock l(&mLock);
-        LINK_camera_release_frame();
+        releasePreviewFrames(mPreviewRing.release(mem->pointer(),
+                                                  systemTime()));
     }
 
     status_t QualcommCameraHardware::autoFocus(autofocus_callback af_cb,
@@ -1202,10 +1232,11 @@ namespace android {
         return;
     }
 
+    // Called on the libqcamera thread: only queues the frame for
+    // deliverPreviewFrame(), which may drop older frames still waiting.
+
     void QualcommCameraHardware::receivePreviewFrame(camera_frame_type *frame)
     {
-        Mutex::Autolock cbLock(&mCallbackLock);
-
         // Ignore the first frame--there is a bug in the VFE pipeline and that
         // frame may be bad.
         if (++mPreviewCount == 1) {
@@ -1213,52 +1244,55 @@ namespace android {
             return;
         }
 
-        // Find the offset within the heap of the current buffer.
-        ssize_t offset = (uint32_t)frame->buf_Virt_Addr;
-        offset -= (uint32_t)mPreviewHeap->mHeap->base();
-        ssize_t frame_size = kRawFrameHeaderSize + frame->dx * frame->dy * 2;
-        if (offset + frame_size <=
-                (ssize_t)mPreviewHeap->mHeap->virtualSize()) {
-#if 0
-            // frame->buffer includes the header, frame->buf_Virt_Addr skips it
-            LOGV("PREVIEW FRAME CALLBACK "
-                 "base %p addr %p offset %ld "
-                 "framesz %dx%d=%ld (expect %d) rotation %d "
-                 "(index %ld) size %d header_size 0x%x",
-                 mPreviewHeap->mHeap->base(),
-                 frame->buf_Virt_Addr,
-                 offset,
-                 frame->dx, frame->dy,
-                 frame_size,
-                 mPreviewFrameSize,
-                 frame->rotation,
-                 offset / frame_size,
-                 mPreviewFrameSize, frame->header_size);
-#endif
-            offset /= frame_size;
+        int release;
+        if (mPreviewRing.receive(frame->buf_Virt_Addr, systemTime(),
+                                 &release) < 0) {
+            LOGE("Preview frame virtual address %p is out of range!",
+                 frame->buf_Virt_Addr);
+            return;
+        }
+        releasePreviewFrames(release);
+    }
+
+    // Called on mPreviewThread; returns false once preview is stopping.
+
+    bool QualcommCameraHardware::deliverPreviewFrame()
+    {
+        if (!mPreviewRing.wait())
+            return false;
+        int slot = mPreviewRing.take(systemTime());
+        if (slot < 0)
+            return true;
+
+        bool hold;
+        {
+            Mutex::Autolock cbLock(&mCallbackLock);
             if (mPreviewCallback != NULL)
-                mPreviewCallback(mPreviewHeap->mBuffers[offset],
+                mPreviewCallback(mPreviewHeap->mBuffers[slot],
                                  mPreviewCallbackCookie);
-            if (mRecordingCallback != NULL)
-                mRecordingCallback(mPreviewHeap->mBuffers[offset],
+            // When we are doing preview but not recording, we release every
+            // preview frame as soon as the callback returns.  However, when
+            // we are recording (whether or not we are also streaming the
+            // preview frames to the screen), we have the user explicitly
+            // release a preview frame via method releaseRecordingFrame().
+            // In this way we allow a video encoder which is potentially
+            // slower than the preview stream to skip frames.
+            hold = mRecordingCallback != NULL;
+            if (hold)
+                mRecordingCallback(mPreviewHeap->mBuffers[slot],
                                    mRecordingCallbackCookie);
-            else {
-                // When we are doing preview but not recording, we need to
-                // release every preview frame immediately so that the next
-                // preview frame is delivered.  However, when we are recording
-                // (whether or not we are also streaming the preview frames to
-                // the screen), we have the user explicitly release a preview
-                // frame via method releaseRecordingFrame().  In this way we
-                // allow a video encoder which is potentially slower than the
-                // preview stream to skip frames.  Note that we call
-                // LINK_camera_release_frame() in this method because we first
-                // need to check to see if mPreviewCallback != NULL, which
-                // requires holding mCallbackLock.
-                LINK_camera_release_frame();
-            }
         }
-        else LOGE("Preview frame virtual address %p is out of range!",
-                  frame->buf_Virt_Addr);
+        releasePreviewFrames(mPreviewRing.delivered(slot, hold, systemTime()));
+        return true;
+    }
+
+    // Gives count preview buffers back to libqcamera, which takes them back
+    // in the order it handed them out.
+
+    void QualcommCameraHardware::releasePreviewFrames(int count)
+    {
+        while (count-- > 0)
+            LINK_camera_release_frame();
     }
 
     void
@@ -1388,13 +1422,9 @@ namespace android {
             camera_handle.device = CAMERA_DEVICE_MEM;
             camera_handle.mem.encBuf_num =  MAX_JPEG_ENCODE_BUF_NUM;
 
-            for (int cnt = 0; cnt < MAX_JPEG_ENCODE_BUF_NUM; cnt++) {
-                camera_handle.mem.encBuf[cnt].buffer = (uint8_t *)
-                    malloc(MAX_JPEG_ENCODE_BUF_LEN);
-                camera_handle.mem.encBuf[cnt].buf_len =
-                    MAX_JPEG_ENCODE_BUF_LEN;
-                camera_handle.mem.encBuf[cnt].used_len = 0;
-            } /* for */
+            mJpegEncBuffers.start(&mJpegHeap->mFragments,
+                                  camera_handle.mem.encBuf,
+                                  MAX_JPEG_ENCODE_BUF_NUM);
 
             LINK_camera_encode_picture(frame, &camera_handle, camera_cb, this);
         }
@@ -1416,27 +1446,21 @@ namespace android {
         camera_encode_mem_type *enc =
             (camera_encode_mem_type *)encInfo->outPtr;
         int index = enc - camera_handle.mem.encBuf;
-        uint8_t *base = (uint8_t *)mJpegHeap->mHeap->base();
         uint32_t size = encInfo->size;
-        uint32_t remaining = mJpegHeap->mHeap->virtualSize();
-        remaining -= mJpegSize;
 
         LOGV("receiveJpegPictureFragment: (index %d status %d size %d)",
              index,
              encInfo->status,
              size);
 
-        if (size > remaining) {
+        uint32_t kept = mJpegEncBuffers.receive(index, size);
+        if (kept < size) {
             LOGE("receiveJpegPictureFragment: size %d exceeds what "
                  "remains in JPEG heap (%d), truncating",
                  size,
-                 remaining);
-            size = remaining;
+                 kept);
         }
-
-        camera_handle.mem.encBuf[index].used_len = 0;
-        memcpy(base + mJpegSize, enc->buffer, size);
-        mJpegSize += size;
+        mJpegSize = mJpegHeap->mFragments.size();
     }
 
     // This method is called by a libqcamera thread, different from the one on
@@ -1450,17 +1474,21 @@ namespace android {
         print_time();
         Mutex::Autolock cbLock(&mCallbackLock);
 
-        int index = 0;
-
         if (mJpegPictureCallback) {
             // The reason we do not allocate into mJpegHeap->mBuffers[offset] is
             // that the JPEG image's size will probably change from one snapshot
             // to the next, so we cannot reuse the MemoryBase object.
+            //
+            // The fragments are handed over where the encoder wrote them;
+            // they only need moving if the encoder left gaps between them.
+            JpegFragmentList &fragments = mJpegHeap->mFragments;
+            if (!fragments.contiguous()) {
+                LOGV("receiveJpegPicture: joining %d fragments",
+                     fragments.count());
+            }
+            size_t offset = fragments.flatten();
             sp<MemoryBase> buffer = new
-                MemoryBase(mJpegHeap->mHeap,
-                           index * mJpegHeap->mBufferSize +
-                           mJpegHeap->mFrameOffset,
-                           mJpegSize);
+                MemoryBase(mJpegHeap->mHeap, offset, mJpegSize);
             
             mJpegPictureCallback(buffer, mPictureCallbackCookie);
             buffer = NULL;
@@ -1472,13 +1500,7 @@ namespace android {
         mJpegHeap = NULL;
         mRawHeap = NULL;        
         
-        for (int cnt = 0; cnt < MAX_JPEG_ENCODE_BUF_NUM; cnt++) {
-            if (camera_handle.mem.encBuf[cnt].buffer != NULL) {
-                free(camera_handle.mem.encBuf[cnt].buffer);
-                memset(camera_handle.mem.encBuf + cnt, 0,
-                       sizeof(camera_encode_mem_type));
-            }
-        } /* for */
+        mJpegEncBuffers.release();
 
         print_time();
         LOGV("receiveJpegPicture: X callback done.");
@@ -2024,6 +2046,33 @@ namespace android {
             completeInitialization();
     }
 
+    QualcommCameraHardware::JpegPool::JpegPool(int buffer_size,
+                                               const char *name) :
+        QualcommCameraHardware::AshmemPool(buffer_size,
+                                           kJpegBufferCount,
+                                           0, // we do not know how big the picture wil be
+                                           0,
+                                           name),
+        mFragments((uint8_t *)mHeap->base(), mHeap->virtualSize())
+    {
+        // empty
+    }
+
+    status_t QualcommCameraHardware::JpegPool::dump(int fd, const Vector<String16>& args) const
+    {
+        AshmemPool::dump(fd, args);
+
+        const size_t SIZE = 256;
+        char buffer[SIZE];
+        const JpegFragmentList::Stats &stats = mFragments.stats();
+        snprintf(buffer, 255, "jpeg (%d bytes in %d fragments): %d written in place, "
+                 "%d copied, %d moved, %d truncated\n",
+                 mFragments.size(), mFragments.count(), stats.inPlace,
+                 stats.copied, stats.moved, stats.truncated);
+        write(fd, buffer, strlen(buffer));
+        return NO_ERROR;
+    }
+
     QualcommCameraHardware::PmemPool::PmemPool(const char *pmem_pool,
                                                int buffer_size, int num_buffers,
                                                int frame_size,
@@ -21,6 +21,9 @@
 #include <binder/MemoryBase.h>
 #include <binder/MemoryHeapBase.h>
 
+#include "JpegFragmentList.h"
+#include "PreviewFrameRing.h"
+
 extern "C" {
     #include <linux/android_pmem.h>
 }
@@ -88,6 +91,20 @@ private:
     int mRawWidth;
 
     void receivePreviewFrame(camera_frame_type *frame);
+    bool deliverPreviewFrame();
+    void releasePreviewFrames(int count);
+
+    // Passes the preview frames libqcamera hands us on to the preview and
+    // recording callbacks, so that a slow callback does not hold up
+    // libqcamera.
+
+    class PreviewThread : public Thread {
+    public:
+        PreviewThread(QualcommCameraHardware *hw) : mHardware(hw) { }
+    private:
+        virtual bool threadLoop() { return mHardware->deliverPreviewFrame(); }
+        QualcommCameraHardware *mHardware;
+    };
 
     static void stop_camera_cb(camera_cb_type cb,
             const void *client_data,
@@ -135,6 +152,15 @@ private:
                    const char *name);
     };
 
+    // The JPEG heap, and the image being encoded into it.  The encoder
+    // writes straight into the heap (see JpegFragmentList).
+
+    struct JpegPool : public AshmemPool {
+        JpegPool(int buffer_size, const char *name);
+        virtual status_t dump(int fd, const Vector<String16>& args) const;
+        JpegFragmentList mFragments;
+    };
+
     struct PmemPool : public MemPool {
         PmemPool(const char *pmem_pool,
                 int buffer_size, int num_buffers,
@@ -165,8 +191,10 @@ private:
     };
 
     sp<PreviewPmemPool> mPreviewHeap;
+    PreviewFrameRing mPreviewRing;
+    sp<PreviewThread> mPreviewThread;
     sp<RawPmemPool> mRawHeap;
-    sp<AshmemPool> mJpegHeap;
+    sp<JpegPool> mJpegHeap;
 
     void startCameraIfNecessary();
     bool initPreview();
@@ -228,6 +256,8 @@ private:
     */
     uint32_t mJpegSize;
     camera_handle_type camera_handle;
+    // camera_handle.mem.encBuf, pointed into mJpegHeap
+    JpegEncoderBuffers mJpegEncBuffers;
     camera_encode_properties_type encode_properties;
     camera_position_type pt;
 
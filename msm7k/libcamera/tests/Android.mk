@@ -0,0 +1,47 @@
+# Copyright (C) 2010 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+LOCAL_PATH:= $(call my-dir)
+
+# JPEG encoder fragment sequences replayed through JpegFragmentList
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	jpeg_fragment_replay.cpp \
+	../JpegFragmentList.cpp
+
+LOCAL_STATIC_LIBRARIES:= liblog
+
+LOCAL_MODULE:= jpeg_fragment_replay
+
+LOCAL_MODULE_TAGS:= tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# PreviewFrameRing against a simulated preview frame source
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	preview_ring_sim.cpp \
+	../PreviewFrameRing.cpp
+
+LOCAL_STATIC_LIBRARIES:= libutils liblog
+
+LOCAL_LDLIBS:= -lpthread
+
+LOCAL_MODULE:= preview_ring_sim
+
+LOCAL_MODULE_TAGS:= tests
+
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,338 @@
+/*
+** Copyright 2010, The Android Open-Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * Replays JPEG encoder fragment sequences through JpegEncoderBuffers and
+ * JpegFragmentList, which QualcommCameraHardware drives them with: a
+ * simulated encoder writes each fragment of a known byte stream into the
+ * buffer it was given (or, like an encoder that kept its own buffer,
+ * somewhere else), and the camera side records it and hands out the next
+ * buffer.  The image must read
+ * back as the stream both scattered and flattened, and in-place sequences
+ * must not have been copied, nor moved when the encoder had a single
+ * buffer.  Then times a 5 MP capture against copying every fragment, as
+ * before.
+ *
+ * A recorded sequence is a file of fragment sizes as the CAMERA_EXIT_CB_*
+ * callbacks reported them; a line "own" makes the encoder ignore the
+ * buffers it is given, and "buffers N" gives it N buffers to fill in
+ * turn.
+ *
+ *   jpeg_fragment_replay [sequence file...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "../JpegFragmentList.h"
+
+using namespace android;
+
+struct sequence_t {
+    const char *name;
+    std::vector<uint32_t> sizes;
+    bool ownBuffer;         // encoder ignores the buffer it is given
+    int buffers;            // encBuf_num
+    size_t heapSize;
+};
+
+static int sErrors;
+
+/*****************************************************************************/
+
+static inline uint8_t streamByte(size_t i)
+{
+    return (uint8_t)((i * 2654435761u) >> 13);
+}
+
+// the JPEG heap and camera_handle.mem.encBuf of QualcommCameraHardware,
+// started as receivePostLpmRawPicture does
+struct Camera {
+    Camera(uint8_t *heap, size_t size, int buffers)
+        : fragments(heap, size) {
+        memset(enc, 0, sizeof(enc));
+        encBuffers.start(&fragments, enc, buffers);
+    }
+
+    // what receiveJpegPictureFragment does
+    void receiveFragment(int index, uint32_t size) {
+        encBuffers.receive(index, size);
+    }
+
+    JpegFragmentList fragments;
+    camera_encode_mem_type enc[JpegFragmentList::MAX_BUFFERS];
+    JpegEncoderBuffers encBuffers;
+};
+
+// the encoder: returns the number of bytes of the stream it produced
+static size_t encode(Camera *cam, const sequence_t &seq, uint8_t *own)
+{
+    size_t pos = 0;
+    for (size_t i = 0; i < seq.sizes.size(); i++) {
+        int index = i % seq.buffers;
+        camera_encode_mem_type *enc = cam->enc + index;
+        uint8_t *out = seq.ownBuffer ? own : enc->buffer;
+        uint32_t size = seq.sizes[i];
+        if (!seq.ownBuffer && size > enc->buf_len)
+            size = enc->buf_len;
+        for (uint32_t k = 0; k < size; k++)
+            out[k] = streamByte(pos + k);
+        enc->used_len = size;
+        if (seq.ownBuffer)
+            enc->buffer = own;
+        pos += size;
+        cam->receiveFragment(index, size);
+    }
+    return pos;
+}
+
+static bool matches(const uint8_t *p, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        if (p[i] != streamByte(i))
+            return false;
+    return true;
+}
+
+static void replay(const sequence_t &seq)
+{
+    std::vector<uint8_t> heap(seq.heapSize);
+    std::vector<uint8_t> own(MAX_JPEG_ENCODE_BUF_LEN);
+    Camera cam(&heap[0], heap.size(), seq.buffers);
+    size_t produced = encode(&cam, seq, &own[0]);
+    JpegFragmentList &f = cam.fragments;
+    const JpegFragmentList::Stats &stats = f.stats();
+    size_t expected = produced < heap.size() ? produced : heap.size();
+    size_t truncated = stats.truncated;
+    size_t fragments = f.count();
+    bool contiguous = f.contiguous();
+
+    if (f.size() > expected || f.size() + truncated != produced) {
+        fprintf(stderr, "%s: kept %d of %d bytes, %d truncated\n", seq.name,
+                (int)f.size(), (int)produced, (int)stats.truncated);
+        sErrors++;
+    }
+    std::vector<uint8_t> gathered(f.size() + 1);
+    if (f.read(0, &gathered[0], f.size()) != f.size() ||
+            !matches(&gathered[0], f.size())) {
+        fprintf(stderr, "%s: scattered image differs\n", seq.name);
+        sErrors++;
+    }
+    size_t offset = f.flatten();
+    if (!f.contiguous() || !matches(&heap[offset], f.size())) {
+        fprintf(stderr, "%s: flattened image differs\n", seq.name);
+        sErrors++;
+    }
+    if (!seq.ownBuffer && stats.copied) {
+        fprintf(stderr, "%s: %d bytes copied\n", seq.name, (int)stats.copied);
+        sErrors++;
+    }
+    if ((contiguous || seq.buffers == 1) && stats.moved) {
+        fprintf(stderr, "%s: contiguous image moved\n", seq.name);
+        sErrors++;
+    }
+
+    printf("  %-24s %8d bytes  %3d fragments  in place %8d  copied %8d  "
+           "moved %8d  truncated %6d\n", seq.name, (int)f.size(),
+           (int)fragments, (int)stats.inPlace, (int)stats.copied,
+           (int)stats.moved, (int)stats.truncated);
+}
+
+/*****************************************************************************/
+
+static sequence_t fullBuffers(const char *name, size_t total, size_t heapSize)
+{
+    sequence_t seq;
+    seq.name = name;
+    seq.ownBuffer = false;
+    seq.buffers = 1;
+    seq.heapSize = heapSize;
+    for (; total > MAX_JPEG_ENCODE_BUF_LEN; total -= MAX_JPEG_ENCODE_BUF_LEN)
+        seq.sizes.push_back(MAX_JPEG_ENCODE_BUF_LEN);
+    seq.sizes.push_back(total);
+    return seq;
+}
+
+static std::vector<sequence_t> builtinSequences()
+{
+    std::vector<sequence_t> seqs;
+
+    // what the encoder normally does: full buffers, a short last one
+    seqs.push_back(fullBuffers("full buffers", 1234567, 2560*1920*2));
+
+    // headers first, then the scan data
+    sequence_t hdr = fullBuffers("header fragment", 800000, 1600*1200*2);
+    hdr.sizes.insert(hdr.sizes.begin(), 623);
+    seqs.push_back(hdr);
+
+    // flushed at restart markers
+    sequence_t odd;
+    odd.name = "odd sizes";
+    odd.ownBuffer = false;
+    odd.buffers = 1;
+    odd.heapSize = 2048*1536*2;
+    unsigned s = 1;
+    for (int i = 0; i < 200; i++)
+        odd.sizes.push_back(1 + rand_r(&s) % MAX_JPEG_ENCODE_BUF_LEN);
+    seqs.push_back(odd);
+
+    // an encoder that keeps writing into its own buffer
+    sequence_t own = fullBuffers("own buffer", 300000, 640*480*2);
+    own.ownBuffer = true;
+    seqs.push_back(own);
+
+    // two buffers in flight: short fragments leave gaps
+    sequence_t hdr2 = hdr;
+    hdr2.name = "header, 2 buffers";
+    hdr2.buffers = 2;
+    seqs.push_back(hdr2);
+    sequence_t odd3 = odd;
+    odd3.name = "odd sizes, 3 buffers";
+    odd3.buffers = 3;
+    seqs.push_back(odd3);
+    sequence_t own2 = own;
+    own2.name = "own buffer, 2 buffers";
+    own2.buffers = 2;
+    seqs.push_back(own2);
+
+    // more than the heap holds
+    seqs.push_back(fullBuffers("overflow", 700000, 640*480*2));
+    sequence_t ovOdd = odd;
+    ovOdd.name = "overflow, odd sizes";
+    ovOdd.heapSize = 600000;
+    seqs.push_back(ovOdd);
+    sequence_t ov2 = ovOdd;
+    ov2.name = "overflow, 2 buffers";
+    ov2.buffers = 2;
+    seqs.push_back(ov2);
+
+    seqs.push_back(fullBuffers("empty", 0, 4096));
+    return seqs;
+}
+
+static bool loadSequence(const char *path, sequence_t *seq)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return false;
+    }
+    seq->name = path;
+    seq->ownBuffer = false;
+    seq->buffers = 1;
+    size_t total = 0;
+    char line[64];
+    while (fgets(line, sizeof(line), f)) {
+        if (!strncmp(line, "own", 3)) {
+            seq->ownBuffer = true;
+            continue;
+        }
+        unsigned size;
+        if (sscanf(line, "buffers %u", &size) == 1) {
+            if (size < 1 || size > JpegFragmentList::MAX_BUFFERS) {
+                fprintf(stderr, "%s: %u buffers\n", path, size);
+                fclose(f);
+                return false;
+            }
+            seq->buffers = size;
+            continue;
+        }
+        if (sscanf(line, "%u", &size) == 1) {
+            seq->sizes.push_back(size);
+            total += size;
+        }
+    }
+    fclose(f);
+    seq->heapSize = total + seq->buffers * MAX_JPEG_ENCODE_BUF_LEN;
+    return true;
+}
+
+/*****************************************************************************/
+
+static long nsSince(const timespec &t0)
+{
+    timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0.tv_sec)*1000000000L + (t1.tv_nsec - t0.tv_nsec);
+}
+
+// the camera side of a 5 MP capture, without the encoding
+static void benchmark()
+{
+    const size_t heapSize = 2592*1944*2;
+    const size_t image = 3*1024*1024 + 12345;
+    const int runs = 20;
+    std::vector<uint8_t> heap(heapSize);
+    std::vector<uint8_t> bounce(MAX_JPEG_ENCODE_BUF_LEN);
+    memset(&bounce[0], 0x5a, bounce.size());
+    memset(&heap[0], 0, heap.size());
+
+    timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int r = 0; r < runs; r++) {
+        size_t size = 0;
+        for (size_t left = image; left; ) {
+            size_t n = left < MAX_JPEG_ENCODE_BUF_LEN ? left : MAX_JPEG_ENCODE_BUF_LEN;
+            memcpy(&heap[size], &bounce[0], n);
+            size += n;
+            left -= n;
+        }
+    }
+    long copyNs = nsSince(t0) / runs;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int r = 0; r < runs; r++) {
+        Camera cam(&heap[0], heap.size(), 1);
+        for (size_t left = image; left; ) {
+            size_t n = left < cam.enc[0].buf_len ? left : cam.enc[0].buf_len;
+            cam.receiveFragment(0, n);
+            left -= n;
+        }
+        cam.fragments.flatten();
+    }
+    long listNs = nsSince(t0) / runs;
+
+    printf("5 MP capture, %d KB JPEG in 16 KB fragments:\n"
+           "  copying fragments   %6.0f us\n"
+           "  in place            %6.0f us\n",
+           (int)(image / 1024), copyNs / 1000.0, listNs / 1000.0);
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<sequence_t> seqs;
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            sequence_t seq;
+            if (!loadSequence(argv[i], &seq))
+                return 1;
+            seqs.push_back(seq);
+        }
+    } else {
+        seqs = builtinSequences();
+    }
+
+    printf("replaying %d sequences:\n", (int)seqs.size());
+    for (size_t i = 0; i < seqs.size(); i++)
+        replay(seqs[i]);
+    benchmark();
+
+    printf("%s\n", sErrors ? "FAILED" : "passed");
+    return sErrors ? 1 : 0;
+}
@@ -0,0 +1,513 @@
+/*
+** Copyright 2010, The Android Open-Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * Runs PreviewFrameRing against a simulated frame source on a virtual
+ * clock: a driver with a few preview buffers captures a frame every frame
+ * interval into the next buffer it has (and misses the frame if it has
+ * none), gets buffers back strictly in the order it handed them out, and
+ * checks that none of them is still queued, being delivered or held by the
+ * recording client.  The consumer is the delivery thread, whose callbacks
+ * take a given time, plus a recording client keeping each frame for a
+ * while and releasing it, possibly out of order.
+ *
+ * A frame stuck in the callbacks for longer than the other buffers last
+ * still starves the driver, since every newer buffer has to wait for it;
+ * what the ring buys there is that the frames delivered afterwards are
+ * fresh ones.
+ *
+ * Every scenario also runs the way receivePreviewFrame() used to work,
+ * with the callbacks on the driver's thread, for comparison.  Then a
+ * short run with real threads checks that stopping wakes the delivery
+ * thread.
+ *
+ *   preview_ring_sim
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <deque>
+#include <queue>
+#include <vector>
+
+#include "../PreviewFrameRing.h"
+
+using namespace android;
+
+#define MS(x) ((nsecs_t)(x) * 1000000)
+
+// as in QualcommCameraHardware
+static const int kPreviewBufferCount = 4;
+static const int kRawFrameHeaderSize = 0x48;
+static const size_t kBufferSize = kRawFrameHeaderSize + 176 * 144 * 2;
+
+static int sErrors;
+
+#define CHECK(cond, ...) do {                                   \
+        if (!(cond)) {                                          \
+            fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__);\
+            fprintf(stderr, __VA_ARGS__);                       \
+            fprintf(stderr, "\n");                              \
+            sErrors++;                                          \
+        }                                                       \
+    } while (0)
+
+struct scenario_t {
+    const char *name;
+    int frames;
+    nsecs_t interval;
+    nsecs_t callback;       // time spent in the callbacks
+    nsecs_t stallEvery;     // every that many frames the callback takes
+    nsecs_t stall;          //   stall instead
+    bool recording;
+    nsecs_t hold;           // the recording client keeps a frame this long
+    nsecs_t holdJitter;     //   plus up to this much, so releases reorder
+    int maxQueued;
+    bool expectNoMisses;
+};
+
+struct result_t {
+    int captured;
+    int missed;
+    int delivered;
+    int dropped;
+    nsecs_t latencyTotal;   // captured -> callback
+    nsecs_t latencyMax;
+};
+
+/*****************************************************************************/
+
+static uint32_t sSeed;
+
+static uint32_t random32()
+{
+    sSeed = sSeed * 1103515245 + 12345;
+    return sSeed >> 8;
+}
+
+enum event_type { TICK, CALLBACK_DONE, CLIENT_RELEASE, RETURN };
+
+struct event_t {
+    nsecs_t when;
+    int seq;
+    event_type type;
+    int arg;
+    bool operator<(const event_t &e) const {
+        return when != e.when ? when > e.when : seq > e.seq;
+    }
+};
+
+struct Sim {
+    Sim(const scenario_t &sc) : sc(sc), now(0), seq(0) {
+        memset(&r, 0, sizeof(r));
+        memset(captured, 0, sizeof(captured));
+        memset(holding, 0, sizeof(holding));
+        memset(delivering, 0, sizeof(delivering));
+        heap = new uint8_t[kBufferSize * kPreviewBufferCount];
+        for (int i = 0; i < kPreviewBufferCount; i++)
+            driverFree.push_back(i);
+        sSeed = 1;
+    }
+    ~Sim() { delete[] heap; }
+
+    void schedule(nsecs_t when, event_type type, int arg) {
+        event_t e = { when, seq++, type, arg };
+        events.push(e);
+    }
+
+    nsecs_t callbackTime(int frame) const {
+        if (sc.stallEvery && frame % sc.stallEvery == sc.stallEvery - 1)
+            return sc.stall;
+        return sc.callback;
+    }
+
+    nsecs_t holdTime() {
+        return sc.hold + (sc.holdJitter ? random32() % sc.holdJitter : 0);
+    }
+
+    // frame addresses skip the header, like camera_frame_type.buf_Virt_Addr
+    const void *frameAddr(int slot) const {
+        return heap + slot * kBufferSize + kRawFrameHeaderSize;
+    }
+
+    int captureFrame() {
+        if (driverFree.empty()) {
+            r.missed++;
+            return -1;
+        }
+        int slot = driverFree.front();
+        driverFree.pop_front();
+        captured[slot] = now;
+        frameOf[slot] = r.captured++;
+        return slot;
+    }
+
+    void latency(int slot) {
+        nsecs_t l = now - captured[slot];
+        r.latencyTotal += l;
+        if (l > r.latencyMax)
+            r.latencyMax = l;
+    }
+
+    // runs the event loop until nothing is left to do
+    void run(void (Sim::*handle)(const event_t &)) {
+        schedule(0, TICK, 0);
+        while (!events.empty()) {
+            event_t e = events.top();
+            events.pop();
+            now = e.when;
+            (this->*handle)(e);
+        }
+    }
+
+    /* with PreviewFrameRing and the delivery thread *************************/
+
+    void giveBack(int n) {
+        for (int i = 0; i < n; i++) {
+            CHECK(!driverOut.empty(), "%s: buffer given back, none out",
+                  sc.name);
+            if (driverOut.empty())
+                return;
+            int slot = driverOut.front();
+            driverOut.pop_front();
+            CHECK(ring.state(slot) == PreviewFrameRing::SLOT_DRIVER,
+                  "%s: buffer %d given back in state %d", sc.name, slot,
+                  ring.state(slot));
+            CHECK(!holding[slot] && !delivering[slot],
+                  "%s: buffer %d given back while %s", sc.name, slot,
+                  holding[slot] ? "held by the client" : "being delivered");
+            driverFree.push_back(slot);
+        }
+    }
+
+    void tryDeliver() {
+        if (busy)
+            return;
+        int slot = ring.take(now);
+        if (slot < 0)
+            return;
+        CHECK(frameOf[slot] > lastDelivered, "%s: frame %d delivered "
+              "after frame %d", sc.name, frameOf[slot], lastDelivered);
+        lastDelivered = frameOf[slot];
+        busy = true;
+        delivering[slot] = true;
+        latency(slot);
+        schedule(now + callbackTime(frameOf[slot]), CALLBACK_DONE, slot);
+    }
+
+    void handleRing(const event_t &e) {
+        int release;
+        switch (e.type) {
+        case TICK: {
+            int slot = captureFrame();
+            if (slot >= 0) {
+                int got = ring.receive(frameAddr(slot), now, &release);
+                CHECK(got == slot, "%s: frame in buffer %d found in %d",
+                      sc.name, slot, got);
+                driverOut.push_back(slot);
+                giveBack(release);
+            }
+            if (e.arg + 1 < sc.frames)
+                schedule(now + sc.interval, TICK, e.arg + 1);
+            break;
+        }
+        case CALLBACK_DONE:
+            busy = false;
+            delivering[e.arg] = false;
+            r.delivered++;
+            if (sc.recording) {
+                holding[e.arg] = true;
+                schedule(now + holdTime(), CLIENT_RELEASE, e.arg);
+            }
+            giveBack(ring.delivered(e.arg, sc.recording, now));
+            break;
+        case CLIENT_RELEASE:
+            holding[e.arg] = false;
+            giveBack(ring.release(frameAddr(e.arg), now));
+            break;
+        default:
+            break;
+        }
+        tryDeliver();
+    }
+
+    result_t runRing() {
+        ring.start(heap, kBufferSize, kPreviewBufferCount, sc.maxQueued);
+        busy = false;
+        lastDelivered = -1;
+        run(&Sim::handleRing);
+
+        PreviewFrameRing::Stats stats = ring.stats();
+        r.dropped = stats.dropped;
+        CHECK((int)stats.frames == r.captured, "%s: %d frames received, "
+              "%d captured", sc.name, stats.frames, r.captured);
+        CHECK((int)stats.delivered == r.delivered, "%s: ring delivered %d, "
+              "sim %d", sc.name, stats.delivered, r.delivered);
+        CHECK(r.delivered + r.dropped == r.captured, "%s: %d delivered + "
+              "%d dropped != %d captured", sc.name, r.delivered, r.dropped,
+              r.captured);
+        CHECK(driverOut.empty(), "%s: %d buffers never given back",
+              sc.name, (int)driverOut.size());
+        CHECK(stats.mispredicted == 0, "%s: %d lookups mispredicted",
+              sc.name, stats.mispredicted);
+        if (sc.expectNoMisses) {
+            CHECK(r.missed == 0, "%s: driver missed %d frames", sc.name,
+                  r.missed);
+        }
+        ring.stop();
+        return r;
+    }
+
+    /* the callbacks on the driver's thread, as before ***********************/
+
+    void handleInline(const event_t &e) {
+        switch (e.type) {
+        case TICK: {
+            int slot = captureFrame();
+            if (slot >= 0) {
+                // the driver's thread is still in the previous callback
+                nsecs_t start = now > driverBusy ? now : driverBusy;
+                nsecs_t done = start + callbackTime(frameOf[slot]);
+                r.latencyTotal += start - now;
+                if (start - now > r.latencyMax)
+                    r.latencyMax = start - now;
+                driverBusy = done;
+                r.delivered++;
+                schedule(sc.recording ? done + holdTime() : done,
+                         RETURN, slot);
+            }
+            if (e.arg + 1 < sc.frames)
+                schedule(now + sc.interval, TICK, e.arg + 1);
+            break;
+        }
+        case RETURN:
+            driverFree.push_back(e.arg);
+            break;
+        default:
+            break;
+        }
+    }
+
+    result_t runInline() {
+        driverBusy = 0;
+        run(&Sim::handleInline);
+        return r;
+    }
+
+    const scenario_t &sc;
+    PreviewFrameRing ring;
+    uint8_t *heap;
+    nsecs_t now;
+    int seq;
+    std::priority_queue<event_t> events;
+    std::deque<int> driverFree;
+    std::deque<int> driverOut;
+    nsecs_t captured[kPreviewBufferCount];
+    int frameOf[kPreviewBufferCount];
+    bool holding[kPreviewBufferCount];
+    bool delivering[kPreviewBufferCount];
+    bool busy;
+    int lastDelivered;
+    nsecs_t driverBusy;
+    result_t r;
+};
+
+static void print(const char *how, const result_t &r)
+{
+    printf("  %-7s captured %4d missed %4d delivered %4d dropped %4d  "
+           "latency avg %6.1f ms max %6.1f ms\n",
+           how, r.captured, r.missed, r.delivered, r.dropped,
+           r.delivered ? r.latencyTotal / 1e6 / r.delivered : 0.0,
+           r.latencyMax / 1e6);
+}
+
+static void runScenario(const scenario_t &sc)
+{
+    printf("%s\n", sc.name);
+    Sim ring(sc);
+    print("ring", ring.runRing());
+    Sim inline_(sc);
+    print("inline", inline_.runInline());
+}
+
+/*****************************************************************************/
+
+// ownership corner cases the scenarios do not reach
+static void testCorners()
+{
+    uint8_t heap[kBufferSize * kPreviewBufferCount];
+    PreviewFrameRing ring;
+    int release;
+
+    ring.start(heap, kBufferSize, kPreviewBufferCount, 1);
+    CHECK(ring.receive(heap - 1, 0, &release) < 0, "address below the heap");
+    CHECK(ring.receive(heap + sizeof(heap), 0, &release) < 0,
+          "address past the heap");
+
+    // out of turn: found by division, counted
+    CHECK(ring.receive(heap + 2 * kBufferSize + 5, 0, &release) == 2,
+          "buffer 2 out of turn");
+    CHECK(ring.stats().mispredicted == 1, "misprediction not counted");
+    CHECK(ring.receive(heap + 2 * kBufferSize, 0, &release) < 0,
+          "buffer 2 received twice");
+
+    // released by the client before its callback returned
+    CHECK(ring.take(1) == 2, "take buffer 2");
+    CHECK(ring.release(heap + 2 * kBufferSize, 2) == 0, "early release");
+    CHECK(ring.delivered(2, true, 3) == 1, "early release not honoured");
+    CHECK(ring.state(2) == PreviewFrameRing::SLOT_DRIVER, "buffer 2 back");
+
+    // a held frame keeps newer finished ones from the driver
+    ring.receive(heap + 3 * kBufferSize, 10, &release);
+    ring.receive(heap, 11, &release);
+    CHECK(release == 1 && ring.stats().dropped == 1,
+          "oldest waiting frame not dropped");
+    CHECK(ring.take(12) == 0, "take buffer 0");
+    CHECK(ring.delivered(0, true, 13) == 0, "buffer 0 held");
+    ring.receive(heap + kBufferSize, 14, &release);
+    CHECK(ring.take(15) == 1 && ring.delivered(1, false, 16) == 0,
+          "buffer 1 given back before buffer 0");
+    CHECK(ring.count(PreviewFrameRing::SLOT_DONE) == 1, "buffer 1 done");
+    // unknown address: the oldest held frame goes, as before
+    CHECK(ring.release(NULL, 17) == 2, "buffers 0 and 1 not given back");
+    CHECK(ring.count(PreviewFrameRing::SLOT_DRIVER) == kPreviewBufferCount,
+          "all buffers back with the driver");
+    CHECK(ring.release(heap, 18) == 0, "nothing held");
+
+    // maxQueued 0 keeps every frame
+    ring.start(heap, kBufferSize, kPreviewBufferCount, 0);
+    for (int i = 0; i < kPreviewBufferCount; i++) {
+        CHECK(ring.receive(heap + i * kBufferSize, i, &release) == i &&
+              release == 0, "keep frame %d", i);
+    }
+    CHECK(ring.stats().starved == 1, "driver starved once");
+    ring.stop();
+    CHECK(ring.receive(heap, 5, &release) < 0, "received after stop");
+}
+
+/*****************************************************************************/
+
+struct threaded_t {
+    PreviewFrameRing ring;
+    uint8_t heap[kBufferSize * kPreviewBufferCount];
+    int delivered;
+    int released;
+    Mutex lock;
+};
+
+static void *deliveryThread(void *arg)
+{
+    threaded_t *t = (threaded_t *)arg;
+    while (t->ring.wait()) {
+        int slot = t->ring.take(systemTime());
+        if (slot < 0)
+            continue;
+        usleep(3000);
+        int n = t->ring.delivered(slot, false, systemTime());
+        Mutex::Autolock l(t->lock);
+        t->delivered++;
+        t->released += n;
+    }
+    return NULL;
+}
+
+// the HAL's threads for real: libqcamera's calling receive() and the
+// delivery thread
+static void testThreads()
+{
+    threaded_t *t = new threaded_t;
+    t->delivered = 0;
+    t->released = 0;
+    t->ring.start(t->heap, kBufferSize, kPreviewBufferCount, 1);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, deliveryThread, t);
+    std::deque<int> out;
+    int fill = 0, received = 0, missed = 0;
+    for (int i = 0; i < 200; i++) {
+        int release = 0;
+        {
+            Mutex::Autolock l(t->lock);
+            release = t->released;
+            t->released = 0;
+        }
+        while (release-- > 0 && !out.empty())
+            out.pop_front();
+        if ((int)out.size() == kPreviewBufferCount) {
+            missed++;
+        } else {
+            // buffers come back in order, so the driver fills them in turn
+            int slot = fill;
+            fill = (fill + 1) % kPreviewBufferCount;
+            int r;
+            CHECK(t->ring.receive(t->heap + slot * kBufferSize,
+                                  systemTime(), &r) == slot,
+                  "threads: frame %d", i);
+            received++;
+            out.push_back(slot);
+            while (r-- > 0)
+                out.pop_front();
+        }
+        usleep(i % 50 < 25 ? 1000 : 5000);
+    }
+    t->ring.stop();
+    pthread_join(thread, NULL);
+
+    PreviewFrameRing::Stats stats = t->ring.stats();
+    printf("threads: received %d missed %d delivered %d dropped %d\n",
+           received, missed, stats.delivered, stats.dropped);
+    CHECK((int)stats.frames == received, "threads: frames %d received %d",
+          stats.frames, received);
+    CHECK((int)stats.delivered == t->delivered, "threads: delivered");
+    CHECK((int)(stats.delivered + stats.dropped) <= received &&
+          (int)(stats.delivered + stats.dropped) >= received - 2,
+          "threads: %d delivered + %d dropped, %d received",
+          stats.delivered, stats.dropped, received);
+    CHECK(missed == 0, "threads: driver missed %d frames", missed);
+    delete t;
+}
+
+/*****************************************************************************/
+
+static const scenario_t sScenarios[] = {
+    // name                  frames  interval callback stall/every recording hold jitter queue noMiss
+    { "fast preview",          300, MS(33),  MS(5),   0, 0,          false, 0,       0,       1, true },
+    { "slow preview",          300, MS(33),  MS(50),  0, 0,          false, 0,       0,       1, true },
+    { "preview stalls",        300, MS(33),  MS(5),   30, MS(400),   false, 0,       0,       1, false },
+    { "slow preview, keep all",300, MS(33),  MS(50),  0, 0,          false, 0,       0,       0, false },
+    { "recording",             300, MS(33),  MS(5),   0, 0,          true,  MS(40),  0,       1, true },
+    { "slow encoder",          300, MS(33),  MS(5),   0, 0,          true,  MS(150), 0,       1, false },
+    { "encoder out of order",  300, MS(33),  MS(5),   0, 0,          true,  MS(20),  MS(60),  1, false },
+    { "encoder stalls",        300, MS(33),  MS(5),   25, MS(300),   true,  MS(30),  0,       2, false },
+};
+
+int main(int argc, char **argv)
+{
+    testCorners();
+    for (size_t i = 0; i < sizeof(sScenarios) / sizeof(sScenarios[0]); i++)
+        runScenario(sScenarios[i]);
+    testThreads();
+
+    if (sErrors) {
+        printf("%d errors\n", sErrors);
+        return 1;
+    }
+    printf("all passed\n");
+    return 0;
+}
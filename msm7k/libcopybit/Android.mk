@@ -40,3 +40,5 @@ LOCAL_C_INCLUDES += hardware/libhardware/modules/gralloc
 LOCAL_CFLAGS += -DCOPYBIT_QSD8K=1
 include $(BUILD_SHARED_LIBRARY)
 endif
+
+include $(call all-makefiles-under,$(LOCAL_PATH))
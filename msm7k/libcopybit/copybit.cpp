@@ -27,6 +27,8 @@
 #include <unistd.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
 
 #include <sys/ioctl.h>
 #include <sys/types.h>
@@ -35,6 +37,8 @@
 #include <hardware/copybit.h>
 
 #include "gralloc_priv.h"
+#include "copybit_batch.h"
+#include "mdp_backend.h"
 
 #define DEBUG_MDP_ERRORS 1
 
@@ -50,14 +54,47 @@
 #error "Unsupported MDP version"
 #endif
 
+/** lists queued for the MDP at most; a pass longer than that waits */
+#define MAX_BATCHES         (4)
+
 /******************************************************************************/
 
+/** an mdp_blit_req_list with room for a full batch */
+struct blit_list_t {
+    uint32_t count;
+    struct mdp_blit_req req[MDP_MAX_BLIT_REQS];
+};
+
 /** State information for each device instance */
 struct copybit_context_t {
-    struct copybit_device_t device;
-    int     mFD;
+    struct copybit_batch_device_t device;
+    struct mdp_backend_t *mBackend;
     uint8_t mAlpha;
     uint8_t mFlags;
+    bool    mBatching;
+
+    /* the list being filled, in the slot of batch mQueued+1 */
+    struct blit_list_t *mCurrent;
+    struct blit_list_t mLists[MAX_BATCHES];
+
+    /* the rest is shared with the submission thread */
+    pthread_mutex_t mLock;
+    pthread_cond_t mSubmitted;
+    pthread_cond_t mCompleted;
+    pthread_t mThread;
+    bool    mThreadRunning;
+    bool    mExit;
+    uint32_t mQueued;       // last batch handed over
+    uint32_t mDone;         // last batch the MDP finished
+    uint32_t mFailed;       // first failed batch not yet waited on
+    int     mError;         // and its error, or 0
+    struct copybit_batch_stats_t mStats;
+};
+
+/** framebuffer backend */
+struct fb_backend_t {
+    struct mdp_backend_t backend;
+    int     mFD;
 };
 
 /**
@@ -205,9 +242,9 @@ static void set_infos(struct copybit_context_t *dev, struct mdp_blit_req *req) {
 /** copy the bits */
 static int msm_copybit(struct copybit_context_t *dev, void const *list) 
 {
-    int err = ioctl(dev->mFD, MSMFB_BLIT,
-                    (struct mdp_blit_req_list const*)list);
-    LOGE_IF(err<0, "copyBits failed (%s)", strerror(errno));
+    int err = dev->mBackend->blit(dev->mBackend,
+                                  (struct mdp_blit_req_list const*)list);
+    LOGE_IF(err<0, "copyBits failed (%s)", strerror(-err));
     if (err == 0) {
         return 0;
     } else {
@@ -237,8 +274,129 @@ static int msm_copybit(struct copybit_context_t *dev, void const *list)
             );
         }
 #endif
-        return -errno;
+        return err;
+    }
+}
+
+/** wrap-safe a <= b for batch numbers */
+static inline bool seq_reached(uint32_t a, uint32_t b) {
+    return (int32_t)(b - a) >= 0;
+}
+
+/** record what the MDP did with a batch. Call with mLock held */
+static void complete_batch(struct copybit_context_t *ctx, uint32_t seq, int err)
+{
+    ctx->mDone = seq;
+    if (err && !ctx->mError) {
+        ctx->mError = err;
+        ctx->mFailed = seq;
+    }
+    pthread_cond_broadcast(&ctx->mCompleted);
+}
+
+static void *submit_thread(void *arg)
+{
+    struct copybit_context_t *ctx = (struct copybit_context_t *)arg;
+    pthread_mutex_lock(&ctx->mLock);
+    while (ctx->mDone != ctx->mQueued || !ctx->mExit) {
+        if (ctx->mDone == ctx->mQueued) {
+            pthread_cond_wait(&ctx->mSubmitted, &ctx->mLock);
+            continue;
+        }
+        uint32_t seq = ctx->mDone + 1;
+        struct blit_list_t *list = &ctx->mLists[seq % MAX_BATCHES];
+        pthread_mutex_unlock(&ctx->mLock);
+
+        int err = msm_copybit(ctx, list);
+
+        pthread_mutex_lock(&ctx->mLock);
+        complete_batch(ctx, seq, err);
+    }
+    pthread_mutex_unlock(&ctx->mLock);
+    return 0;
+}
+
+/** start the submission thread if it isn't; without it batches run inline */
+static void start_submit_thread(struct copybit_context_t *ctx)
+{
+    if (ctx->mThreadRunning)
+        return;
+    if (pthread_create(&ctx->mThread, 0, submit_thread, ctx)) {
+        LOGE("couldn't start the MDP submission thread, blitting inline");
+        return;
+    }
+    ctx->mThreadRunning = true;
+}
+
+/** the request to fill next, in a new list if none is being filled */
+static struct mdp_blit_req *next_req(struct copybit_context_t *ctx)
+{
+    if (!ctx->mCurrent) {
+        // the slot is free once the batch MAX_BATCHES before is done
+        uint32_t seq = ctx->mQueued + 1;
+        pthread_mutex_lock(&ctx->mLock);
+        if (!seq_reached(seq - MAX_BATCHES, ctx->mDone)) {
+            ctx->mStats.waits++;
+            do {
+                pthread_cond_wait(&ctx->mCompleted, &ctx->mLock);
+            } while (!seq_reached(seq - MAX_BATCHES, ctx->mDone));
+        }
+        pthread_mutex_unlock(&ctx->mLock);
+        ctx->mCurrent = &ctx->mLists[seq % MAX_BATCHES];
+        ctx->mCurrent->count = 0;
+    }
+    return &ctx->mCurrent->req[ctx->mCurrent->count];
+}
+
+/** hand the list being filled to the MDP */
+static void submit_list(struct copybit_context_t *ctx)
+{
+    struct blit_list_t *list = ctx->mCurrent;
+    if (!list || !list->count)
+        return;
+    ctx->mCurrent = 0;
+
+    pthread_mutex_lock(&ctx->mLock);
+    ctx->mStats.batches++;
+    ctx->mStats.requests += list->count;
+    uint32_t seq = ++ctx->mQueued;
+    if (ctx->mThreadRunning) {
+        ctx->mStats.asyncBatches++;
+        pthread_cond_signal(&ctx->mSubmitted);
+        pthread_mutex_unlock(&ctx->mLock);
+    } else {
+        pthread_mutex_unlock(&ctx->mLock);
+        int err = msm_copybit(ctx, list);
+        pthread_mutex_lock(&ctx->mLock);
+        complete_batch(ctx, seq, err);
+        pthread_mutex_unlock(&ctx->mLock);
+    }
+}
+
+/** keep the request just filled in, submitting its list once full */
+static void commit_req(struct copybit_context_t *ctx)
+{
+    if (++ctx->mCurrent->count == MDP_MAX_BLIT_REQS)
+        submit_list(ctx);
+}
+
+/** wait for the MDP to finish batch seq and everything before it */
+static int wait_batch(struct copybit_context_t *ctx, uint32_t seq)
+{
+    int err = 0;
+    pthread_mutex_lock(&ctx->mLock);
+    if (!seq_reached(seq, ctx->mDone)) {
+        ctx->mStats.waits++;
+        do {
+            pthread_cond_wait(&ctx->mCompleted, &ctx->mLock);
+        } while (!seq_reached(seq, ctx->mDone));
+    }
+    if (ctx->mError && seq_reached(ctx->mFailed, seq)) {
+        err = ctx->mError;
+        ctx->mError = 0;
     }
+    pthread_mutex_unlock(&ctx->mLock);
+    return err;
 }
 
 /*****************************************************************************/
@@ -349,11 +507,6 @@ static int stretch_copybit(
     struct copybit_context_t* ctx = (struct copybit_context_t*)dev;
     int status = 0;
     if (ctx) {
-        struct {
-            uint32_t count;
-            struct mdp_blit_req req[12];
-        } list;
-
         if (ctx->mAlpha < 255) {
             switch (src->format) {
                 // we don't support plane alpha with RGBA formats
@@ -377,32 +530,27 @@ static int stretch_copybit(
         if (dst->w > MAX_DIMENSION || dst->h > MAX_DIMENSION)
             return -EINVAL;
 
-        const uint32_t maxCount = sizeof(list.req)/sizeof(list.req[0]);
         const struct copybit_rect_t bounds = { 0, 0, dst->w, dst->h };
         struct copybit_rect_t clip;
-        list.count = 0;
-        status = 0;
-        while ((status == 0) && region->next(region, &clip)) {
+        while (region->next(region, &clip)) {
             intersect(&clip, &bounds, &clip);
-            mdp_blit_req* req = &list.req[list.count];
+            mdp_blit_req* req = next_req(ctx);
             set_infos(ctx, req);
             set_image(&req->dst, dst);
             set_image(&req->src, src);
             set_rects(ctx, req, dst_rect, src_rect, &clip);
 
-            if (req->src_rect.w<=0 || req->src_rect.h<=0)
+            if ((int)req->src_rect.w<=0 || (int)req->src_rect.h<=0)
                 continue;
 
-            if (req->dst_rect.w<=0 || req->dst_rect.h<=0)
+            if ((int)req->dst_rect.w<=0 || (int)req->dst_rect.h<=0)
                 continue;
 
-            if (++list.count == maxCount) {
-                status = msm_copybit(ctx, &list);
-                list.count = 0;
-            }
+            commit_req(ctx);
         }
-        if ((status == 0) && list.count) {
-            status = msm_copybit(ctx, &list);
+        if (!ctx->mBatching) {
+            submit_list(ctx);
+            status = wait_batch(ctx, ctx->mQueued);
         }
     } else {
         status = -EINVAL;
@@ -422,48 +570,147 @@ static int blit_copybit(
     return stretch_copybit(dev, dst, src, &dr, &sr, region);
 }
 
+/** Start queuing blits */
+static int begin_copybit(struct copybit_batch_device_t *dev)
+{
+    struct copybit_context_t* ctx = (struct copybit_context_t*)dev;
+    if (!ctx)
+        return -EINVAL;
+    // a pass is worth overlapping with the MDP
+    start_submit_thread(ctx);
+    ctx->mBatching = true;
+    return 0;
+}
+
+/** Submit the queued blits */
+static int flush_copybit(struct copybit_batch_device_t *dev, uint32_t *fence)
+{
+    struct copybit_context_t* ctx = (struct copybit_context_t*)dev;
+    if (!ctx)
+        return -EINVAL;
+    ctx->mBatching = false;
+    submit_list(ctx);
+    if (fence) {
+        *fence = ctx->mQueued;
+        return 0;
+    }
+    return wait_batch(ctx, ctx->mQueued);
+}
+
+/** Wait for the MDP to reach a fence */
+static int wait_copybit(struct copybit_batch_device_t *dev, uint32_t fence)
+{
+    struct copybit_context_t* ctx = (struct copybit_context_t*)dev;
+    if (!ctx)
+        return -EINVAL;
+    return wait_batch(ctx, fence);
+}
+
+static void get_stats_copybit(struct copybit_batch_device_t *dev,
+                              struct copybit_batch_stats_t *stats)
+{
+    struct copybit_context_t* ctx = (struct copybit_context_t*)dev;
+    pthread_mutex_lock(&ctx->mLock);
+    *stats = ctx->mStats;
+    pthread_mutex_unlock(&ctx->mLock);
+}
+
 /*****************************************************************************/
 
+static int fb_blit(struct mdp_backend_t *be, struct mdp_blit_req_list const *list)
+{
+    struct fb_backend_t *fb = (struct fb_backend_t *)be;
+    return ioctl(fb->mFD, MSMFB_BLIT, list) < 0 ? -errno : 0;
+}
+
+static void fb_close(struct mdp_backend_t *be)
+{
+    struct fb_backend_t *fb = (struct fb_backend_t *)be;
+    if (fb->mFD >= 0)
+        close(fb->mFD);
+    free(fb);
+}
+
 /** Close the copybit device */
 static int close_copybit(struct hw_device_t *dev) 
 {
     struct copybit_context_t* ctx = (struct copybit_context_t*)dev;
     if (ctx) {
-        close(ctx->mFD);
+        // whatever is queued still goes out before the MDP is let go
+        ctx->mBatching = false;
+        submit_list(ctx);
+        if (ctx->mThreadRunning) {
+            pthread_mutex_lock(&ctx->mLock);
+            ctx->mExit = true;
+            pthread_cond_signal(&ctx->mSubmitted);
+            pthread_mutex_unlock(&ctx->mLock);
+            pthread_join(ctx->mThread, 0);
+        }
+        pthread_cond_destroy(&ctx->mCompleted);
+        pthread_cond_destroy(&ctx->mSubmitted);
+        pthread_mutex_destroy(&ctx->mLock);
+        ctx->mBackend->close(ctx->mBackend);
         free(ctx);
     }
     return 0;
 }
 
-/** Open a new instance of a copybit device using name */
-static int open_copybit(const struct hw_module_t* module, const char* name,
-        struct hw_device_t** device)
+/** Open a copybit device blitting through backend */
+int copybit_open_backend(const struct hw_module_t* module,
+        struct mdp_backend_t* backend, struct hw_device_t** device)
 {
-    int status = -EINVAL;
     copybit_context_t *ctx;
     ctx = (copybit_context_t *)malloc(sizeof(copybit_context_t));
+    if (!ctx) {
+        backend->close(backend);
+        return -ENOMEM;
+    }
     memset(ctx, 0, sizeof(*ctx));
 
-    ctx->device.common.tag = HARDWARE_DEVICE_TAG;
-    ctx->device.common.version = 1;
-    ctx->device.common.module = const_cast<hw_module_t*>(module);
-    ctx->device.common.close = close_copybit;
-    ctx->device.set_parameter = set_parameter_copybit;
-    ctx->device.get = get;
-    ctx->device.blit = blit_copybit;
-    ctx->device.stretch = stretch_copybit;
+    ctx->device.device.common.tag = HARDWARE_DEVICE_TAG;
+    ctx->device.device.common.version = COPYBIT_BATCH_API_VERSION;
+    ctx->device.device.common.module = const_cast<hw_module_t*>(module);
+    ctx->device.device.common.close = close_copybit;
+    ctx->device.device.set_parameter = set_parameter_copybit;
+    ctx->device.device.get = get;
+    ctx->device.device.blit = blit_copybit;
+    ctx->device.device.stretch = stretch_copybit;
+    ctx->device.begin = begin_copybit;
+    ctx->device.flush = flush_copybit;
+    ctx->device.wait = wait_copybit;
+    ctx->device.get_stats = get_stats_copybit;
+    ctx->mBackend = backend;
     ctx->mAlpha = MDP_ALPHA_NOP;
     ctx->mFlags = 0;
-    ctx->mFD = open("/dev/graphics/fb0", O_RDWR, 0);
+    pthread_mutex_init(&ctx->mLock, 0);
+    pthread_cond_init(&ctx->mSubmitted, 0);
+    pthread_cond_init(&ctx->mCompleted, 0);
+
+    *device = &ctx->device.device.common;
+    return 0;
+}
+
+/** Open a new instance of a copybit device using name */
+static int open_copybit(const struct hw_module_t* module, const char* name,
+        struct hw_device_t** device)
+{
+    int status = -EINVAL;
+    fb_backend_t *fb;
+    fb = (fb_backend_t *)malloc(sizeof(fb_backend_t));
+    if (!fb)
+        return -ENOMEM;
+    fb->backend.blit = fb_blit;
+    fb->backend.close = fb_close;
+    fb->mFD = open("/dev/graphics/fb0", O_RDWR, 0);
     
-    if (ctx->mFD < 0) {
+    if (fb->mFD < 0) {
         status = errno;
         LOGE("Error opening frame buffer errno=%d (%s)",
              status, strerror(status));
         status = -status;
     } else {
         struct fb_fix_screeninfo finfo;
-        if (ioctl(ctx->mFD, FBIOGET_FSCREENINFO, &finfo) == 0) {
+        if (ioctl(fb->mFD, FBIOGET_FSCREENINFO, &finfo) == 0) {
             if (strcmp(finfo.id, "msmfb") == 0) {
                 /* Success */
                 status = 0;
@@ -478,9 +725,9 @@ static int open_copybit(const struct hw_module_t* module, const char* name,
     }
 
     if (status == 0) {
-        *device = &ctx->device.common;
+        status = copybit_open_backend(module, &fb->backend, device);
     } else {
-        close_copybit(&ctx->device.common);
+        fb_close(&fb->backend);
     }
     return status;
 }
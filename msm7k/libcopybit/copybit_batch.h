@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_COPYBIT_BATCH_H
+#define ANDROID_COPYBIT_BATCH_H
+
+#include <hardware/copybit.h>
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/**
+ * copybit devices opened from the MSM modules report this in
+ * common.version and can be cast to copybit_batch_device_t.
+ */
+#define COPYBIT_BATCH_API_VERSION   2
+
+struct copybit_batch_stats_t {
+    /* MDP blit lists submitted */
+    uint32_t batches;
+    /* blit requests in them */
+    uint32_t requests;
+    /* lists that ran on the submission thread */
+    uint32_t asyncBatches;
+    /* calls that had to wait for the MDP */
+    uint32_t waits;
+};
+
+/**
+ * Request-list extension of copybit_device_t.
+ *
+ * Outside of a pass, blit() and stretch() behave as always: they return
+ * once the MDP is done with the operation. Between begin() and flush() they
+ * only validate and queue the operation; the queue goes to the MDP in lists
+ * as large as the driver takes, in the order the operations were made, so
+ * a later operation may read what an earlier one wrote.
+ *
+ * flush() may return before the MDP is done, with a fence to wait() on.
+ * Until then the caller must not touch the destinations nor change the
+ * sources of the pass.
+ */
+struct copybit_batch_device_t {
+    struct copybit_device_t device;
+
+    /**
+     * Start queuing blit() and stretch() calls.
+     *
+     * @return 0 if successful
+     */
+    int (*begin)(struct copybit_batch_device_t *dev);
+
+    /**
+     * Submit what was queued since begin() and end the pass.
+     *
+     * @param fence NULL to wait for the MDP to finish, otherwise where the
+     *        fence of the pass is returned without waiting
+     *
+     * @return 0 if successful; without a fence, also the first error the
+     *         MDP reported for the pass or an earlier one not yet waited on
+     */
+    int (*flush)(struct copybit_batch_device_t *dev, uint32_t *fence);
+
+    /**
+     * Wait until the MDP is done with everything submitted up to a fence.
+     *
+     * @return 0 if successful, or the first error the MDP reported for
+     *         what was submitted up to the fence and not yet waited on
+     */
+    int (*wait)(struct copybit_batch_device_t *dev, uint32_t fence);
+
+    void (*get_stats)(struct copybit_batch_device_t *dev,
+                      struct copybit_batch_stats_t *stats);
+};
+
+__END_DECLS
+
+#endif  // ANDROID_COPYBIT_BATCH_H
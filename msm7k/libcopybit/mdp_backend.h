@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COPYBIT_MDP_BACKEND_H
+#define COPYBIT_MDP_BACKEND_H
+
+#include <hardware/hardware.h>
+
+#include <linux/msm_mdp.h>
+
+/*****************************************************************************/
+
+/**
+ * What the copybit device needs from the MDP: MSMFB_BLIT on the framebuffer
+ * in the module, a software blitter in the tests.
+ */
+struct mdp_backend_t {
+    /* runs a whole list and returns 0 or -errno once it is done */
+    int (*blit)(struct mdp_backend_t *be, struct mdp_blit_req_list const *list);
+    void (*close)(struct mdp_backend_t *be);
+};
+
+/** most requests a list is given to the MDP with */
+#define MDP_MAX_BLIT_REQS   32
+
+/**
+ * Open a copybit device on top of a backend, which the device closes when
+ * it is closed, even if this fails.
+ */
+int copybit_open_backend(const struct hw_module_t *module,
+                         struct mdp_backend_t *backend,
+                         struct hw_device_t **device);
+
+#endif  // COPYBIT_MDP_BACKEND_H
@@ -0,0 +1,39 @@
+# Copyright (C) 2010 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+LOCAL_PATH:= $(call my-dir)
+
+# request lists and async submission against a software MDP
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	copybit_batch_test.cpp \
+	../copybit.cpp
+
+# msm_mdp.h only comes with the target kernel headers
+LOCAL_C_INCLUDES += \
+	hardware/msm7k/libgralloc \
+	bionic/libc/kernel/common
+
+LOCAL_CFLAGS += -DCOPYBIT_MSM7K=1
+
+LOCAL_STATIC_LIBRARIES:= liblog
+
+LOCAL_LDLIBS:= -lpthread
+
+LOCAL_MODULE:= copybit_batch_test
+
+LOCAL_MODULE_TAGS:= tests
+
+include $(BUILD_HOST_EXECUTABLE)
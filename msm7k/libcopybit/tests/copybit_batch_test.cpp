@@ -0,0 +1,621 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Runs the copybit device against a simulated MDP that does the blits in
+ * software and sleeps for roughly what MSMFB_BLIT costs on the target for
+ * each list (the k*Us below). The timed frames skip the software drawing.
+ *
+ * A composition pass (a stretched wallpaper under a dirty region, icons
+ * scaled, flipped and rotated with their own clip rects, an offscreen
+ * layer drawn and then composed, a translucent rotated video frame) is
+ * drawn three ways: one blocking stretch() per layer as before, as a
+ * request list flushed and waited on, and as a request list flushed with
+ * a fence the compositor waits on after doing other work. The three must
+ * leave the same pixels, the lists must be full, and errors must come
+ * back from wait(). Then prints the time per frame of each.
+ *
+ *   copybit_batch_test [frames] [seed]
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <map>
+#include <vector>
+
+#include <cutils/log.h>
+#include <hardware/copybit.h>
+
+#include "gralloc_priv.h"
+#include "../copybit_batch.h"
+#include "../mdp_backend.h"
+
+extern struct copybit_module_t HAL_MODULE_INFO_SYM;
+
+// simulated MDP costs
+static const long kListUs       = 150;      // MSMFB_BLIT setup and interrupt
+static const long kReqUs        = 4;        // each request in a list
+static const long kWorkUs       = 1500;     // compositor work after flushing
+
+static int sErrors;
+
+/*****************************************************************************/
+
+static long nsSince(const timespec& t0)
+{
+    timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0.tv_sec)*1000000000L + (t1.tv_nsec - t0.tv_nsec);
+}
+
+static void spin(long ns)
+{
+    timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    while (nsSince(t0) < ns)
+        ;
+}
+
+static int bytesPerPixel(uint32_t format)
+{
+    return format == MDP_RGB_565 ? 2 : 4;
+}
+
+/** pixel as a, r, g, b bytes in a uint32_t */
+static uint32_t readPixel(const uint8_t* p, uint32_t format)
+{
+    switch (format) {
+    case MDP_RGB_565: {
+        uint32_t v = p[0] | (p[1] << 8);
+        uint32_t r = (v >> 11) & 0x1f, g = (v >> 5) & 0x3f, b = v & 0x1f;
+        return 0xff000000 | ((r << 3 | r >> 2) << 16) |
+                ((g << 2 | g >> 4) << 8) | (b << 3 | b >> 2);
+    }
+    case MDP_RGBX_8888:
+        return 0xff000000 | (p[0] << 16) | (p[1] << 8) | p[2];
+    case MDP_RGBA_8888:
+        return (p[3] << 24) | (p[0] << 16) | (p[1] << 8) | p[2];
+    case MDP_BGRA_8888:
+        return (p[3] << 24) | (p[2] << 16) | (p[1] << 8) | p[0];
+    }
+    return 0;
+}
+
+static void writePixel(uint8_t* p, uint32_t format, uint32_t c)
+{
+    uint8_t a = c >> 24, r = c >> 16, g = c >> 8, b = c;
+    switch (format) {
+    case MDP_RGB_565: {
+        uint16_t v = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+        p[0] = v;
+        p[1] = v >> 8;
+        break;
+    }
+    case MDP_RGBX_8888:
+    case MDP_RGBA_8888:
+        p[0] = r; p[1] = g; p[2] = b; p[3] = a;
+        break;
+    case MDP_BGRA_8888:
+        p[0] = b; p[1] = g; p[2] = r; p[3] = a;
+        break;
+    }
+}
+
+/** premultiplied source over destination, then plane alpha */
+static uint32_t blend(uint32_t s, uint32_t d, uint32_t alpha, bool srcAlpha)
+{
+    uint32_t sa = srcAlpha ? s >> 24 : 0xff;
+    uint32_t out = 0;
+    for (int shift=0 ; shift<32 ; shift+=8) {
+        uint32_t sc = (s >> shift) & 0xff;
+        uint32_t dc = (d >> shift) & 0xff;
+        if (shift == 24)
+            sc = sa;
+        uint32_t c = sc + dc * (255 - sa) / 255;
+        if (alpha != MDP_ALPHA_NOP)
+            c = (c * alpha + dc * (255 - alpha)) / 255;
+        out |= (c > 255 ? 255 : c) << shift;
+    }
+    return out;
+}
+
+/*****************************************************************************/
+
+/** the MDP, in software */
+struct SimMdp {
+    mdp_backend_t   backend;
+    std::map<int, uint8_t*> memory;     // memory_id -> buffer
+    uint32_t        lists;
+    uint32_t        requests;
+    long            listUs;
+    long            reqUs;
+    bool            draw;       // off when only the timing matters
+};
+
+static bool inside(const mdp_rect& r, const mdp_img& img)
+{
+    return r.x + r.w <= img.width && r.y + r.h <= img.height;
+}
+
+static int simBlitOne(SimMdp* mdp, const mdp_blit_req& req)
+{
+    std::map<int, uint8_t*>::iterator s = mdp->memory.find(req.src.memory_id);
+    std::map<int, uint8_t*>::iterator d = mdp->memory.find(req.dst.memory_id);
+    if (s == mdp->memory.end() || d == mdp->memory.end())
+        return -EINVAL;
+    if (!inside(req.src_rect, req.src) || !inside(req.dst_rect, req.dst))
+        return -EINVAL;
+    if (!req.src_rect.w || !req.src_rect.h || !req.dst_rect.w || !req.dst_rect.h)
+        return -EINVAL;
+
+    const uint8_t* src = s->second + req.src.offset;
+    uint8_t* dst = d->second + req.dst.offset;
+    const int sbpp = bytesPerPixel(req.src.format);
+    const int dbpp = bytesPerPixel(req.dst.format);
+    const bool rot90 = req.flags & MDP_ROT_90;
+    const bool srcAlpha = req.src.format == MDP_RGBA_8888 ||
+                          req.src.format == MDP_BGRA_8888;
+    const uint32_t uw = rot90 ? req.dst_rect.h : req.dst_rect.w;
+    const uint32_t vh = rot90 ? req.dst_rect.w : req.dst_rect.h;
+
+    for (uint32_t dy=0 ; dy<req.dst_rect.h ; dy++) {
+        for (uint32_t dx=0 ; dx<req.dst_rect.w ; dx++) {
+            uint32_t u = rot90 ? dy : dx;
+            uint32_t v = rot90 ? req.dst_rect.w - 1 - dx : dy;
+            uint32_t sx = u * req.src_rect.w / uw;
+            uint32_t sy = v * req.src_rect.h / vh;
+            if (req.flags & MDP_FLIP_LR)
+                sx = req.src_rect.w - 1 - sx;
+            if (req.flags & MDP_FLIP_UD)
+                sy = req.src_rect.h - 1 - sy;
+            const uint8_t* sp = src + ((req.src_rect.y + sy) * req.src.width +
+                    req.src_rect.x + sx) * sbpp;
+            uint8_t* dp = dst + ((req.dst_rect.y + dy) * req.dst.width +
+                    req.dst_rect.x + dx) * dbpp;
+            uint32_t c = blend(readPixel(sp, req.src.format),
+                    readPixel(dp, req.dst.format), req.alpha, srcAlpha);
+            writePixel(dp, req.dst.format, c);
+        }
+    }
+    return 0;
+}
+
+static int simBlit(mdp_backend_t* be, mdp_blit_req_list const* list)
+{
+    SimMdp* mdp = (SimMdp*)be;
+    mdp->lists++;
+    mdp->requests += list->count;
+    if (list->count > MDP_MAX_BLIT_REQS) {
+        fprintf(stderr, "list of %u requests\n", list->count);
+        sErrors++;
+    }
+    int err = 0;
+    for (uint32_t i=0 ; i<list->count && !err && mdp->draw ; i++)
+        err = simBlitOne(mdp, list->req[i]);
+    usleep(mdp->listUs + mdp->reqUs * list->count);
+    return err;
+}
+
+static void simClose(mdp_backend_t* be)
+{
+}
+
+/*****************************************************************************/
+
+struct image_t {
+    private_handle_t*       hnd;
+    copybit_image_t         img;
+    std::vector<uint8_t>    mem;
+};
+
+enum { FB, LAYER, WALLPAPER, VIDEO, ICON0, ICON1, ICON2, ICON3, BAD, NUM_IMAGES };
+
+static const struct { int w, h, format; } kImages[NUM_IMAGES] = {
+    { 320, 480, COPYBIT_FORMAT_RGB_565 },       // framebuffer
+    { 128, 128, COPYBIT_FORMAT_RGBA_8888 },     // offscreen layer
+    { 160, 240, COPYBIT_FORMAT_RGBX_8888 },
+    { 176, 144, COPYBIT_FORMAT_RGB_565 },
+    {  48,  48, COPYBIT_FORMAT_RGBA_8888 },
+    {  48,  48, COPYBIT_FORMAT_BGRA_8888 },
+    {  64,  32, COPYBIT_FORMAT_RGBA_8888 },
+    {  40,  40, COPYBIT_FORMAT_RGB_565 },
+    {  16,  16, COPYBIT_FORMAT_RGB_565 },       // never given to the MDP
+};
+
+static image_t sImages[NUM_IMAGES];
+
+static void createImages(SimMdp* mdp)
+{
+    for (int i=0 ; i<NUM_IMAGES ; i++) {
+        image_t& im = sImages[i];
+        int bpp = kImages[i].format == COPYBIT_FORMAT_RGB_565 ? 2 : 4;
+        im.mem.resize(kImages[i].w * kImages[i].h * bpp);
+        im.hnd = new private_handle_t(100 + i, im.mem.size(), 0);
+        im.img.w = kImages[i].w;
+        im.img.h = kImages[i].h;
+        im.img.format = kImages[i].format;
+        im.img.base = &im.mem[0];
+        im.img.handle = im.hnd;
+        if (i != BAD)
+            mdp->memory[im.hnd->fd] = &im.mem[0];
+    }
+}
+
+/** fill the sources with noise (premultiplied where they have alpha) and
+ *  the destinations with a known background */
+static void resetImages(unsigned seed)
+{
+    for (int i=0 ; i<NUM_IMAGES ; i++) {
+        image_t& im = sImages[i];
+        if (i == FB || i == LAYER) {
+            memset(&im.mem[0], i == FB ? 0x3c : 0, im.mem.size());
+            continue;
+        }
+        unsigned s = seed + i;
+        for (size_t k=0 ; k<im.mem.size() ; k++)
+            im.mem[k] = rand_r(&s);
+        if (im.img.format == COPYBIT_FORMAT_RGBA_8888 ||
+                im.img.format == COPYBIT_FORMAT_BGRA_8888) {
+            for (size_t k=0 ; k<im.mem.size() ; k+=4) {
+                uint8_t a = im.mem[k+3];
+                for (int c=0 ; c<3 ; c++)
+                    im.mem[k+c] = im.mem[k+c] * a / 255;
+            }
+        }
+    }
+}
+
+/*****************************************************************************/
+
+struct rect_region_t {
+    copybit_region_t        base;
+    const copybit_rect_t*   rects;
+    int                     count;
+    mutable int             next;
+};
+
+static int regionNext(copybit_region_t const* region, copybit_rect_t* rect)
+{
+    const rect_region_t* r = (const rect_region_t*)region;
+    if (r->next >= r->count)
+        return 0;
+    *rect = r->rects[r->next++];
+    return 1;
+}
+
+struct op_t {
+    int             dst;
+    int             src;
+    copybit_rect_t  dstRect;
+    copybit_rect_t  srcRect;
+    int             transform;
+    int             alpha;
+    std::vector<copybit_rect_t> clip;
+};
+
+static copybit_rect_t makeRect(int l, int t, int r, int b)
+{
+    copybit_rect_t rect = { l, t, r, b };
+    return rect;
+}
+
+static int randIn(unsigned* s, int lo, int hi)
+{
+    return lo + rand_r(s) % (hi - lo + 1);
+}
+
+/** a composition pass */
+static std::vector<op_t> makeFrame(unsigned seed)
+{
+    std::vector<op_t> ops;
+    unsigned s = seed;
+    const int W = kImages[FB].w, H = kImages[FB].h;
+
+    // wallpaper stretched under a dirty region of 24 rects
+    op_t wall;
+    wall.dst = FB;
+    wall.src = WALLPAPER;
+    wall.dstRect = makeRect(0, 0, W, H);
+    wall.srcRect = makeRect(0, 0, kImages[WALLPAPER].w, kImages[WALLPAPER].h);
+    wall.transform = 0;
+    wall.alpha = 255;
+    for (int y=0 ; y<6 ; y++)
+        for (int x=0 ; x<4 ; x++)
+            wall.clip.push_back(makeRect(x*W/4, y*H/6, (x+1)*W/4, (y+1)*H/6));
+    ops.push_back(wall);
+
+    // icons, some of them partly covered
+    for (int i=0 ; i<30 ; i++) {
+        op_t op;
+        op.dst = FB;
+        op.src = ICON0 + rand_r(&s) % 4;
+        int sw = kImages[op.src].w, sh = kImages[op.src].h;
+        int dw = randIn(&s, 16, 120), dh = randIn(&s, 16, 120);
+        int l = randIn(&s, -20, W - 20), t = randIn(&s, -20, H - 20);
+        op.dstRect = makeRect(l, t, l + dw, t + dh);
+        // set_rects() only gets whole sources right, as SurfaceFlinger
+        // gives it
+        op.srcRect = makeRect(0, 0, sw, sh);
+        op.transform = rand_r(&s) % 8;
+        op.alpha = kImages[op.src].format == COPYBIT_FORMAT_RGB_565 ?
+                randIn(&s, 64, 255) : 255;
+        int n = randIn(&s, 1, 4);
+        for (int k=0 ; k<n ; k++) {
+            int cl = randIn(&s, l - 10, l + dw), ct = randIn(&s, t - 10, t + dh);
+            op.clip.push_back(makeRect(cl, ct, cl + randIn(&s, 8, dw),
+                    ct + randIn(&s, 8, dh)));
+        }
+        ops.push_back(op);
+    }
+
+    // an offscreen layer drawn first, then composed rotated
+    for (int k=0 ; k<2 ; k++) {
+        op_t op;
+        op.dst = LAYER;
+        op.src = k ? ICON1 : ICON0;
+        op.dstRect = makeRect(k*40, k*40, k*40 + 88, k*40 + 88);
+        op.srcRect = makeRect(0, 0, 48, 48);
+        op.transform = k ? COPYBIT_TRANSFORM_FLIP_H : 0;
+        op.alpha = 255;
+        op.clip.push_back(makeRect(0, 0, 128, 128));
+        ops.push_back(op);
+    }
+    op_t layer;
+    layer.dst = FB;
+    layer.src = LAYER;
+    layer.dstRect = makeRect(100, 200, 300, 400);
+    layer.srcRect = makeRect(0, 0, 128, 128);
+    layer.transform = COPYBIT_TRANSFORM_ROT_90;
+    layer.alpha = 255;
+    layer.clip.push_back(makeRect(100, 200, 200, 300));
+    layer.clip.push_back(makeRect(200, 200, 300, 300));
+    layer.clip.push_back(makeRect(100, 300, 300, 400));
+    ops.push_back(layer);
+
+    // a translucent video frame, rotated to the portrait framebuffer
+    op_t video;
+    video.dst = FB;
+    video.src = VIDEO;
+    video.dstRect = makeRect(20, 40, 20 + 288, 40 + 352);
+    video.srcRect = makeRect(0, 0, kImages[VIDEO].w, kImages[VIDEO].h);
+    video.transform = COPYBIT_TRANSFORM_ROT_90;
+    video.alpha = 0x80;
+    video.clip.push_back(makeRect(0, 0, W, H/2));
+    video.clip.push_back(makeRect(0, H/2, W, H));
+    ops.push_back(video);
+    return ops;
+}
+
+static int runOp(copybit_device_t* dev, const op_t& op)
+{
+    rect_region_t region;
+    region.base.next = regionNext;
+    region.rects = &op.clip[0];
+    region.count = op.clip.size();
+    region.next = 0;
+    dev->set_parameter(dev, COPYBIT_TRANSFORM, op.transform);
+    dev->set_parameter(dev, COPYBIT_PLANE_ALPHA, op.alpha);
+    return dev->stretch(dev, &sImages[op.dst].img, &sImages[op.src].img,
+            &op.dstRect, &op.srcRect, &region.base);
+}
+
+enum { PER_CALL, PASS_WAIT, PASS_FENCE, NUM_MODES };
+static const char* const kModes[] = {
+    "stretch() per layer", "request list, flush", "request list, fence",
+};
+
+/** draws a frame; returns 0 or the first error */
+static int drawFrame(copybit_batch_device_t* dev, const std::vector<op_t>& ops,
+        int mode)
+{
+    int err = 0;
+    if (mode == PER_CALL) {
+        for (size_t i=0 ; i<ops.size() ; i++) {
+            int e = runOp(&dev->device, ops[i]);
+            if (!err)
+                err = e;
+        }
+        spin(kWorkUs * 1000);
+        return err;
+    }
+    dev->begin(dev);
+    for (size_t i=0 ; i<ops.size() ; i++) {
+        int e = runOp(&dev->device, ops[i]);
+        if (!err)
+            err = e;
+    }
+    if (mode == PASS_WAIT) {
+        int e = dev->flush(dev, 0);
+        spin(kWorkUs * 1000);
+        return err ? err : e;
+    }
+    uint32_t fence;
+    dev->flush(dev, &fence);
+    spin(kWorkUs * 1000);
+    int e = dev->wait(dev, fence);
+    return err ? err : e;
+}
+
+/*****************************************************************************/
+
+static copybit_batch_device_t* openDevice(SimMdp* mdp)
+{
+    hw_device_t* dev;
+    int err = copybit_open_backend(&HAL_MODULE_INFO_SYM.common,
+            &mdp->backend, &dev);
+    if (err || dev->version < COPYBIT_BATCH_API_VERSION) {
+        fprintf(stderr, "couldn't open the device (%s)\n", strerror(-err));
+        exit(1);
+    }
+    return (copybit_batch_device_t*)dev;
+}
+
+/** a plain copy and a flipped one come out as computed here */
+static void checkSimple(SimMdp* mdp)
+{
+    copybit_batch_device_t* dev = openDevice(mdp);
+    resetImages(7);
+    image_t& src = sImages[ICON3];
+    image_t& dst = sImages[FB];
+    copybit_rect_t dr = makeRect(10, 20, 50, 60);
+    copybit_rect_t sr = makeRect(0, 0, 40, 40);
+    copybit_rect_t all = makeRect(0, 0, 320, 480);
+    rect_region_t region = { { regionNext }, &all, 1, 0 };
+    for (int transform=0 ; transform<=COPYBIT_TRANSFORM_ROT_180 ;
+            transform+=COPYBIT_TRANSFORM_ROT_180) {
+        region.next = 0;
+        dev->device.set_parameter(&dev->device, COPYBIT_TRANSFORM, transform);
+        int err = dev->device.stretch(&dev->device, &dst.img, &src.img,
+                &dr, &sr, &region.base);
+        if (err)
+            sErrors++;
+        const uint16_t* s = (const uint16_t*)&src.mem[0];
+        const uint16_t* d = (const uint16_t*)&dst.mem[0];
+        for (int y=0 ; y<40 ; y++) {
+            for (int x=0 ; x<40 ; x++) {
+                int sx = transform ? 39 - x : x, sy = transform ? 39 - y : y;
+                if (d[(20 + y)*320 + 10 + x] != s[sy*40 + sx]) {
+                    fprintf(stderr, "transform %d: wrong pixel at %d,%d\n",
+                            transform, x, y);
+                    sErrors++;
+                    y = 40;
+                    break;
+                }
+            }
+        }
+    }
+    copybit_close(&dev->device);
+}
+
+/** MDP errors come back once, from the wait covering them */
+static void checkErrors(SimMdp* mdp)
+{
+    copybit_batch_device_t* dev = openDevice(mdp);
+    op_t bad;
+    bad.dst = FB;
+    bad.src = BAD;
+    bad.dstRect = makeRect(0, 0, 16, 16);
+    bad.srcRect = makeRect(0, 0, 16, 16);
+    bad.transform = 0;
+    bad.alpha = 255;
+    bad.clip.push_back(makeRect(0, 0, 16, 16));
+
+    if (runOp(&dev->device, bad) != -EINVAL) {
+        fprintf(stderr, "failed stretch() not reported\n");
+        sErrors++;
+    }
+
+    std::vector<op_t> ops = makeFrame(3);
+    ops.insert(ops.begin() + 5, bad);
+    uint32_t fence;
+    dev->begin(dev);
+    for (size_t i=0 ; i<ops.size() ; i++)
+        runOp(&dev->device, ops[i]);
+    dev->flush(dev, &fence);
+    int first = dev->wait(dev, fence);
+    int second = dev->wait(dev, fence);
+    if (first != -EINVAL || second != 0) {
+        fprintf(stderr, "failed pass reported %d then %d\n", first, second);
+        sErrors++;
+    }
+    copybit_close(&dev->device);
+}
+
+int main(int argc, char** argv)
+{
+    int frames = (argc > 1) ? atoi(argv[1]) : 100;
+    unsigned seed = (argc > 2) ? atoi(argv[2]) : 1;
+
+    SimMdp mdp;
+    mdp.backend.blit = simBlit;
+    mdp.backend.close = simClose;
+    mdp.listUs = kListUs;
+    mdp.reqUs = kReqUs;
+    mdp.draw = true;
+    createImages(&mdp);
+
+    checkSimple(&mdp);
+    checkErrors(&mdp);
+
+    // same pixels whichever way the frame is submitted
+    std::vector<op_t> ops = makeFrame(seed);
+    std::vector<uint8_t> golden[2];
+    copybit_batch_stats_t stats[NUM_MODES];
+    uint32_t lists[NUM_MODES];
+    for (int mode=0 ; mode<NUM_MODES ; mode++) {
+        copybit_batch_device_t* dev = openDevice(&mdp);
+        resetImages(seed);
+        mdp.lists = 0;
+        int err = drawFrame(dev, ops, mode);
+        if (err) {
+            fprintf(stderr, "%s: %s\n", kModes[mode], strerror(-err));
+            sErrors++;
+        }
+        dev->get_stats(dev, &stats[mode]);
+        lists[mode] = mdp.lists;
+        copybit_close(&dev->device);
+        if (mode == PER_CALL) {
+            golden[0] = sImages[FB].mem;
+            golden[1] = sImages[LAYER].mem;
+        } else if (sImages[FB].mem != golden[0] ||
+                sImages[LAYER].mem != golden[1]) {
+            fprintf(stderr, "%s: different pixels\n", kModes[mode]);
+            sErrors++;
+        }
+        if (stats[mode].requests != stats[PER_CALL].requests) {
+            fprintf(stderr, "%s: %u requests, %u per layer\n", kModes[mode],
+                    stats[mode].requests, stats[PER_CALL].requests);
+            sErrors++;
+        }
+        uint32_t full = (stats[mode].requests + MDP_MAX_BLIT_REQS - 1) /
+                MDP_MAX_BLIT_REQS;
+        if (mode != PER_CALL && stats[mode].batches != full) {
+            fprintf(stderr, "%s: %u lists for %u requests\n", kModes[mode],
+                    stats[mode].batches, stats[mode].requests);
+            sErrors++;
+        }
+        if (lists[mode] != stats[mode].batches) {
+            fprintf(stderr, "%s: %u lists submitted, %u ran\n", kModes[mode],
+                    stats[mode].batches, lists[mode]);
+            sErrors++;
+        }
+    }
+
+    printf("%u requests per frame, at most %d per list\n",
+            stats[PER_CALL].requests, MDP_MAX_BLIT_REQS);
+    // the host CPU drawing the pixels would compete with the compositor
+    mdp.draw = false;
+    for (int mode=0 ; mode<NUM_MODES ; mode++) {
+        copybit_batch_device_t* dev = openDevice(&mdp);
+        timespec t0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (int f=0 ; f<frames ; f++)
+            drawFrame(dev, ops, mode);
+        long ns = nsSince(t0);
+        copybit_batch_stats_t s;
+        dev->get_stats(dev, &s);
+        copybit_close(&dev->device);
+        printf("  %-20s %3u lists  %6.0f us per frame  (waited %u times)\n",
+                kModes[mode], lists[mode], ns / 1000.0 / frames, s.waits);
+    }
+
+    printf("%s\n", sErrors ? "FAILED" : "passed");
+    return sErrors ? 1 : 0;
+}
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <string.h>
+#include <unistd.h>
+
 #include <cutils/log.h>
 
 #include "allocator.h"
@@ -163,3 +166,335 @@ SimpleBestFitAllocator::chunk_t* SimpleBestFitAllocator::dealloc(size_t start)
     }
     return 0;
 }
+
+// ----------------------------------------------------------------------------
+
+const int SegregatedFitAllocator::kMemoryAlign = 32;
+
+SegregatedFitAllocator::SegregatedFitAllocator()
+    : mHeapSize(0), mPageUnits(1), mFlBitmap(0),
+      mBuckets(0), mBucketMask(0), mUsedChunks(0), mSpare(0),
+      mFreeUnits(0), mFreeChunks(0), mAllocs(0), mFrees(0), mFailures(0)
+{
+    memset(mSlBitmap, 0, sizeof(mSlBitmap));
+    memset(mFree, 0, sizeof(mFree));
+}
+
+SegregatedFitAllocator::SegregatedFitAllocator(size_t size)
+    : mHeapSize(0), mPageUnits(1), mFlBitmap(0),
+      mBuckets(0), mBucketMask(0), mUsedChunks(0), mSpare(0),
+      mFreeUnits(0), mFreeChunks(0), mAllocs(0), mFrees(0), mFailures(0)
+{
+    memset(mSlBitmap, 0, sizeof(mSlBitmap));
+    memset(mFree, 0, sizeof(mFree));
+    setSize(size);
+}
+
+SegregatedFitAllocator::~SegregatedFitAllocator()
+{
+    while(!mList.isEmpty()) {
+        delete mList.remove(mList.head());
+    }
+    while (mSpare) {
+        chunk_t* next = mSpare->next;
+        delete mSpare;
+        mSpare = next;
+    }
+    delete [] mBuckets;
+}
+
+ssize_t SegregatedFitAllocator::setSize(size_t size)
+{
+    Locker::Autolock _l(mLock);
+    if (mHeapSize != 0) return -EINVAL;
+    size_t pagesize = getpagesize();
+    mHeapSize = ((size + pagesize-1) & ~(pagesize-1));
+    mPageUnits = pagesize / kMemoryAlign;
+    mBucketMask = 63;
+    mBuckets = new chunk_t*[mBucketMask + 1];
+    memset(mBuckets, 0, (mBucketMask + 1) * sizeof(chunk_t*));
+    chunk_t* node = newChunk(0, mHeapSize / kMemoryAlign);
+    mList.insertHead(node);
+    insertFree(node);
+    return size;
+}
+
+size_t SegregatedFitAllocator::size() const
+{
+    return mHeapSize;
+}
+
+ssize_t SegregatedFitAllocator::allocate(size_t size, uint32_t flags)
+{
+    Locker::Autolock _l(mLock);
+    if (mHeapSize == 0) return -EINVAL;
+    ssize_t offset = alloc(size, flags);
+    return offset;
+}
+
+ssize_t SegregatedFitAllocator::deallocate(size_t offset)
+{
+    Locker::Autolock _l(mLock);
+    if (mHeapSize == 0) return -EINVAL;
+    return dealloc(offset);
+}
+
+void SegregatedFitAllocator::getStats(allocator_stats_t* stats) const
+{
+    Locker::Autolock _l(mLock);
+    size_t largest = 0;
+    if (mFlBitmap) {
+        int fl = 31 - __builtin_clz(mFlBitmap);
+        int sl = 31 - __builtin_clz(mSlBitmap[fl]);
+        for (chunk_t* c = mFree[fl*SL_COUNT + sl] ; c ; c = c->listNext) {
+            if (c->size > largest) largest = c->size;
+        }
+    }
+    stats->heapSize = mHeapSize;
+    stats->free = mFreeUnits * kMemoryAlign;
+    stats->allocated = mHeapSize - stats->free;
+    stats->largestFree = largest * kMemoryAlign;
+    stats->usedChunks = mUsedChunks;
+    stats->freeChunks = mFreeChunks;
+    stats->allocs = mAllocs;
+    stats->frees = mFrees;
+    stats->failures = mFailures;
+}
+
+/*
+ * Sizes below SL_COUNT units get a class each; above that, every power of
+ * two range [2^n, 2^(n+1)) is cut in SL_COUNT equal classes.
+ */
+int SegregatedFitAllocator::classIndex(size_t size)
+{
+    if (size < SL_COUNT) {
+        return size;
+    }
+    int fl = 31 - __builtin_clz(size);
+    int sl = (size >> (fl - SL_SHIFT)) & (SL_COUNT - 1);
+    return (fl - SL_SHIFT + 1) * SL_COUNT + sl;
+}
+
+// first class whose chunks are all at least 'size' units
+int SegregatedFitAllocator::classIndexAtLeast(size_t size)
+{
+    if (size >= SL_COUNT) {
+        int fl = 31 - __builtin_clz(size);
+        size += (1 << (fl - SL_SHIFT)) - 1;
+    }
+    return classIndex(size);
+}
+
+int SegregatedFitAllocator::findNonEmpty(int index) const
+{
+    int fl = index / SL_COUNT;
+    if (fl >= FL_COUNT) return -1;
+    uint32_t bits = mSlBitmap[fl] & (0xFF << (index % SL_COUNT));
+    if (!bits) {
+        uint32_t flBits = mFlBitmap & ~((2U << fl) - 1);
+        if (!flBits) return -1;
+        fl = __builtin_ctz(flBits);
+        bits = mSlBitmap[fl];
+    }
+    return fl*SL_COUNT + __builtin_ctz(bits);
+}
+
+SegregatedFitAllocator::chunk_t* SegregatedFitAllocator::newChunk(
+        size_t start, size_t size)
+{
+    chunk_t* c = mSpare;
+    if (c) {
+        mSpare = c->next;
+    } else {
+        c = new chunk_t;
+    }
+    c->start = start;
+    c->size = size;
+    c->free = 1;
+    c->prev = c->next = 0;
+    c->listPrev = c->listNext = 0;
+    return c;
+}
+
+void SegregatedFitAllocator::deleteChunk(chunk_t* chunk)
+{
+    chunk->next = mSpare;
+    mSpare = chunk;
+}
+
+void SegregatedFitAllocator::insertFree(chunk_t* chunk)
+{
+    int index = classIndex(chunk->size);
+    chunk->free = 1;
+    chunk->listPrev = 0;
+    chunk->listNext = mFree[index];
+    if (chunk->listNext) chunk->listNext->listPrev = chunk;
+    mFree[index] = chunk;
+    mSlBitmap[index / SL_COUNT] |= 1 << (index % SL_COUNT);
+    mFlBitmap |= 1U << (index / SL_COUNT);
+    mFreeUnits += chunk->size;
+    mFreeChunks++;
+}
+
+void SegregatedFitAllocator::removeFree(chunk_t* chunk)
+{
+    int index = classIndex(chunk->size);
+    if (chunk->listPrev) chunk->listPrev->listNext = chunk->listNext;
+    else                 mFree[index] = chunk->listNext;
+    if (chunk->listNext) chunk->listNext->listPrev = chunk->listPrev;
+    if (!mFree[index]) {
+        mSlBitmap[index / SL_COUNT] &= ~(1 << (index % SL_COUNT));
+        if (!mSlBitmap[index / SL_COUNT])
+            mFlBitmap &= ~(1U << (index / SL_COUNT));
+    }
+    chunk->listPrev = chunk->listNext = 0;
+    mFreeUnits -= chunk->size;
+    mFreeChunks--;
+}
+
+size_t SegregatedFitAllocator::alignPad(size_t start) const
+{
+    return -start & (mPageUnits - 1);
+}
+
+SegregatedFitAllocator::chunk_t* SegregatedFitAllocator::findFit(size_t size)
+{
+    // good fit: a few chunks from the class 'size' falls in
+    const int first = classIndex(size);
+    chunk_t* best = 0;
+    int scanned = 0;
+    for (chunk_t* c = mFree[first] ; c && scanned < MAX_SCAN ;
+            c = c->listNext, scanned++) {
+        if (c->size >= size + alignPad(c->start) &&
+                (!best || c->size < best->size)) {
+            best = c;
+        }
+    }
+    if (best) return best;
+
+    // any chunk from this class up is big enough whatever its alignment
+    const int sure = classIndexAtLeast(size + mPageUnits - 1);
+    int index = findNonEmpty(sure);
+    if (index >= 0) return mFree[index];
+
+    // nearly out of memory: look at everything that could still fit
+    for (index = findNonEmpty(first) ; index >= 0 && index < sure ;
+            index = findNonEmpty(index + 1)) {
+        for (chunk_t* c = mFree[index] ; c ; c = c->listNext) {
+            if (c->size >= size + alignPad(c->start))
+                return c;
+        }
+    }
+    return 0;
+}
+
+void SegregatedFitAllocator::hashInsert(chunk_t* chunk)
+{
+    if (mUsedChunks > mBucketMask) {
+        hashGrow();
+    }
+    size_t h = (chunk->start ^ (chunk->start >> 7)) & mBucketMask;
+    chunk->listPrev = 0;
+    chunk->listNext = mBuckets[h];
+    mBuckets[h] = chunk;
+    mUsedChunks++;
+}
+
+SegregatedFitAllocator::chunk_t* SegregatedFitAllocator::hashRemove(size_t start)
+{
+    size_t h = (start ^ (start >> 7)) & mBucketMask;
+    chunk_t** link = &mBuckets[h];
+    while (*link) {
+        chunk_t* c = *link;
+        if (c->start == start) {
+            *link = c->listNext;
+            c->listNext = 0;
+            mUsedChunks--;
+            return c;
+        }
+        link = &c->listNext;
+    }
+    return 0;
+}
+
+void SegregatedFitAllocator::hashGrow()
+{
+    size_t mask = mBucketMask * 2 + 1;
+    chunk_t** buckets = new chunk_t*[mask + 1];
+    memset(buckets, 0, (mask + 1) * sizeof(chunk_t*));
+    for (size_t i=0 ; i<=mBucketMask ; i++) {
+        chunk_t* c = mBuckets[i];
+        while (c) {
+            chunk_t* next = c->listNext;
+            size_t h = (c->start ^ (c->start >> 7)) & mask;
+            c->listNext = buckets[h];
+            buckets[h] = c;
+            c = next;
+        }
+    }
+    delete [] mBuckets;
+    mBuckets = buckets;
+    mBucketMask = mask;
+}
+
+ssize_t SegregatedFitAllocator::alloc(size_t size, uint32_t flags)
+{
+    if (size == 0) {
+        return 0;
+    }
+    size = (size + kMemoryAlign-1) / kMemoryAlign;
+    chunk_t* chunk = findFit(size);
+    if (!chunk) {
+        mFailures++;
+        return -ENOMEM;
+    }
+
+    removeFree(chunk);
+    const size_t pad = alignPad(chunk->start);
+    if (pad) {
+        chunk_t* split = newChunk(chunk->start, pad);
+        chunk->start += pad;
+        chunk->size -= pad;
+        mList.insertBefore(chunk, split);
+        insertFree(split);
+    }
+    if (chunk->size > size) {
+        chunk_t* split = newChunk(chunk->start + size, chunk->size - size);
+        chunk->size = size;
+        mList.insertAfter(chunk, split);
+        insertFree(split);
+    }
+    chunk->free = 0;
+    hashInsert(chunk);
+    mAllocs++;
+    return (chunk->start)*kMemoryAlign;
+}
+
+ssize_t SegregatedFitAllocator::dealloc(size_t start)
+{
+    chunk_t* cur = hashRemove(start / kMemoryAlign);
+    if (!cur) {
+        LOGE("no block allocated at offset 0x%08lX", (unsigned long)start);
+        return -ENOENT;
+    }
+    mFrees++;
+
+    // merge with free neighbours
+    chunk_t* p = cur->prev;
+    if (p && p->free) {
+        removeFree(p);
+        p->size += cur->size;
+        mList.remove(cur);
+        deleteChunk(cur);
+        cur = p;
+    }
+    chunk_t* n = cur->next;
+    if (n && n->free) {
+        removeFree(n);
+        cur->size += n->size;
+        mList.remove(n);
+        deleteChunk(n);
+    }
+    insertFree(cur);
+    return 0;
+}
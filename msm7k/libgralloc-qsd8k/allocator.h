@@ -126,4 +126,105 @@ private:
     size_t              mHeapSize;
 };
 
+// ----------------------------------------------------------------------------
+
+struct allocator_stats_t {
+    size_t      heapSize;
+    size_t      allocated;      // bytes in use
+    size_t      free;           // bytes available
+    size_t      largestFree;    // biggest single free chunk, in bytes
+    size_t      usedChunks;
+    size_t      freeChunks;
+    uint32_t    allocs;
+    uint32_t    frees;
+    uint32_t    failures;
+};
+
+/*
+ * Drop-in replacement for SimpleBestFitAllocator with O(1) allocate and
+ * free.
+ *
+ * Free chunks are kept in segregated lists, two levels deep as in TLSF:
+ * a power of two range split into 8 linear classes, with bitmaps telling
+ * which lists are non-empty. Allocated chunks are found by offset through
+ * a hash table. Allocations are still page aligned and rounded up to
+ * kMemoryAlign, and neighbouring free chunks are still merged on free.
+ */
+class SegregatedFitAllocator
+{
+public:
+
+    SegregatedFitAllocator();
+    SegregatedFitAllocator(size_t size);
+    ~SegregatedFitAllocator();
+
+    ssize_t     setSize(size_t size);
+
+    ssize_t     allocate(size_t size, uint32_t flags = 0);
+    ssize_t     deallocate(size_t offset);
+    size_t      size() const;
+
+    void        getStats(allocator_stats_t* stats) const;
+
+private:
+    struct chunk_t {
+        size_t              start;
+        size_t              size;
+        int                 free;
+        // neighbours in address order
+        mutable chunk_t*    prev;
+        mutable chunk_t*    next;
+        // free list links while free, hash chain (listNext) while in use
+        chunk_t*            listPrev;
+        chunk_t*            listNext;
+    };
+
+    enum {
+        SL_SHIFT    = 3,
+        SL_COUNT    = 1 << SL_SHIFT,
+        FL_COUNT    = 30,
+        // chunks looked at in the best matching list before settling for
+        // one from a bigger class
+        MAX_SCAN    = 8,
+    };
+
+    static int  classIndex(size_t size);
+    static int  classIndexAtLeast(size_t size);
+
+    chunk_t*    newChunk(size_t start, size_t size);
+    void        deleteChunk(chunk_t* chunk);
+    void        insertFree(chunk_t* chunk);
+    void        removeFree(chunk_t* chunk);
+    int         findNonEmpty(int index) const;
+    size_t      alignPad(size_t start) const;
+    chunk_t*    findFit(size_t size);
+    void        hashInsert(chunk_t* chunk);
+    chunk_t*    hashRemove(size_t start);
+    void        hashGrow();
+
+    ssize_t     alloc(size_t size, uint32_t flags);
+    ssize_t     dealloc(size_t start);
+
+    static const int    kMemoryAlign;
+    mutable Locker      mLock;
+    LinkedList<chunk_t> mList;
+    size_t              mHeapSize;
+    size_t              mPageUnits;
+
+    uint32_t            mFlBitmap;
+    uint8_t             mSlBitmap[FL_COUNT];
+    chunk_t*            mFree[FL_COUNT * SL_COUNT];
+
+    chunk_t**           mBuckets;
+    size_t              mBucketMask;
+    size_t              mUsedChunks;
+    chunk_t*            mSpare;         // recycled chunk_t nodes
+
+    size_t              mFreeUnits;
+    size_t              mFreeChunks;
+    uint32_t            mAllocs;
+    uint32_t            mFrees;
+    uint32_t            mFailures;
+};
+
 #endif /* GRALLOC_ALLOCATOR_H_ */
@@ -43,7 +43,7 @@
 
 /*****************************************************************************/
 
-static SimpleBestFitAllocator sAllocator;
+static SegregatedFitAllocator sAllocator;
 
 /*****************************************************************************/
 
@@ -32,3 +32,5 @@ LOCAL_STATIC_LIBRARIES := libpower
 LOCAL_WHOLE_STATIC_LIBRARIES := librpc
 # LOCAL_PRELINK_MODULE := false
 include $(BUILD_SHARED_LIBRARY)
+
+include $(call all-makefiles-under,$(LOCAL_PATH))
@@ -4,42 +4,88 @@
 #include <debug.h>
 #include <pthread.h>
 #include <sys/select.h>
+#include <sys/time.h>
 
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include <hardware_legacy/power.h>
 
+/* Every process that links librpc (rild, camera, gps) takes a wake lock of
+   its own, "rpc-interface-<pid>": while the lock lingers it is not acquired
+   in the kernel again, which is only safe if no other process can release
+   it meanwhile. */
 #define ANDROID_WAKE_LOCK_NAME "rpc-interface"
 
+/* How long the wake lock stays held after the last RPC is handled, so that
+   a burst of messages takes and drops it in the kernel only once. */
+#define WAKE_LOCK_LINGER_MS 100
+
+static pthread_once_t wake_lock_once = PTHREAD_ONCE_INIT;
+static char wake_lock_name[sizeof(ANDROID_WAKE_LOCK_NAME) + 16];
+
+static void
+initWakeLock() {
+    snprintf(wake_lock_name, sizeof(wake_lock_name), "%s-%d",
+             ANDROID_WAKE_LOCK_NAME, (int)getpid());
+    wake_lock_set_linger(wake_lock_name, WAKE_LOCK_LINGER_MS);
+}
+
+/* Counted: the RX, callback and server threads each hold it while they
+   handle a message. */
 void
 grabPartialWakeLock() {
-    acquire_wake_lock(PARTIAL_WAKE_LOCK, ANDROID_WAKE_LOCK_NAME);
+    pthread_once(&wake_lock_once, initWakeLock);
+    wake_lock_acquire(wake_lock_name);
 }
 
 void
 releaseWakeLock() {
-    release_wake_lock(ANDROID_WAKE_LOCK_NAME);
+    pthread_once(&wake_lock_once, initWakeLock);
+    wake_lock_release(wake_lock_name);
 }
 
+/* Number of finished call contexts a client keeps around for reuse. */
+#define MAX_IDLE_CALLS 4
+
+/* One outstanding RPC.  Every call encodes its arguments into and decodes
+   its results from an XDR of its own, so any number of threads can have a
+   call in flight on the same client.  The RX thread hands each reply to
+   the call with the matching XID.
+*/
+typedef struct rpc_call {
+    xdr_s_type xdr;
+    struct rpc_call *next;
+    pthread_cond_t done_cond;
+    /* 1 when the reply has been copied in, -1 if the client went away */
+    int done;
+} rpc_call;
+
 struct CLIENT {
     xdr_s_type *xdr;
     struct CLIENT *next;
     /* common attribute struct for setting up recursive mutexes */
     pthread_mutexattr_t lock_attr;
 
-    /* We insist that there is only one outstanding call for a client at any
-       time, and we use this mutex to enforce the rule.  When we start
-       supporting multiple outstanding RPCs on a client, we will have to
-       maintain a queue of them, and match incoming replies (by the XID of the
-       incoming packet).  For now, we just block until we get that reply.
-    */
+    /* Protects the XID counter and the idle call contexts. */
     pthread_mutex_t lock;
+    uint32 next_xid;
+    rpc_call *idle_calls;
+    int num_idle_calls;
 
+    /* Protects the list of calls waiting for a reply.  wait_reply is
+       signalled when the last call returns while the client is being
+       destroyed.
+    */
     pthread_mutex_t wait_reply_lock;
     pthread_cond_t wait_reply;
+    rpc_call *pending_calls;
+    int num_calls;
+    int destroying;
 
     pthread_mutex_t input_xdr_lock;
     pthread_cond_t input_xdr_wait;
@@ -180,6 +226,94 @@ static void *cb_context(void *__u)
     return NULL;
 }
 
+/* Takes the call with the given XID (network order) off the pending list.
+   Called with wait_reply_lock held.
+*/
+static rpc_call *unlink_call(CLIENT *client, uint32 xid)
+{
+    rpc_call **link = &client->pending_calls;
+    for (; *link; link = &(*link)->next) {
+        rpc_call *call = *link;
+        if (((uint32 *)call->xdr.out_msg)[RPC_OFFSET] == xid) {
+            *link = call->next;
+            call->next = NULL;
+            return call;
+        }
+    }
+    return NULL;
+}
+
+/* Copies the reply sitting in the client's input buffer to the call it
+   answers and wakes that call up.  Called with wait_reply_lock held.
+*/
+static void deliver_reply(CLIENT *client)
+{
+    xdr_s_type *in = client->xdr;
+    uint32 xid = ((uint32 *)in->in_msg)[RPC_OFFSET];
+    rpc_call *call = unlink_call(client, xid);
+    if (!call) {
+        /* most likely the call timed out already */
+        E("%08x:%08x dropping reply with unknown XID %d.\n",
+          in->x_prog, in->x_vers, ntohl(xid));
+        return;
+    }
+    memcpy(call->xdr.in_msg, in->in_msg, in->in_len);
+    call->xdr.in_len = in->in_len;
+    call->xdr.in_next = in->in_next;
+    call->done = 1;
+    pthread_cond_signal(&call->done_cond);
+}
+
+static rpc_call *get_call(CLIENT *client)
+{
+    rpc_call *call;
+
+    pthread_mutex_lock(&client->lock);
+    call = client->idle_calls;
+    if (call) {
+        client->idle_calls = call->next;
+        client->num_idle_calls--;
+    }
+    pthread_mutex_unlock(&client->lock);
+
+    if (!call) {
+        call = calloc(1, sizeof(rpc_call));
+        if (!call)
+            return NULL;
+        pthread_cond_init(&call->done_cond, NULL);
+    }
+    call->next = NULL;
+    call->done = 0;
+    call->xdr.xops = client->xdr->xops;
+    call->xdr.fd = client->xdr->fd;
+    call->xdr.is_client = 1;
+    call->xdr.x_prog = client->xdr->x_prog;
+    call->xdr.x_vers = client->xdr->x_vers;
+
+    /* XDR_MSG_START() bumps the XID before writing it out */
+    pthread_mutex_lock(&client->lock);
+    call->xdr.xid = client->next_xid++;
+    pthread_mutex_unlock(&client->lock);
+    return call;
+}
+
+static void put_call(CLIENT *client, rpc_call *call)
+{
+    pthread_mutex_lock(&client->lock);
+    if (client->num_idle_calls < MAX_IDLE_CALLS) {
+        call->next = client->idle_calls;
+        client->idle_calls = call;
+        client->num_idle_calls++;
+        call = NULL;
+    }
+    pthread_mutex_unlock(&client->lock);
+
+    if (call) {
+        pthread_cond_destroy(&call->done_cond);
+        free(call);
+    }
+}
+
 static void *rx_context(void *__u __attribute__((unused)))
 {
     int n;
@@ -221,25 +355,34 @@ static void *rx_context(void *__u __attribute__((unused)))
                     D("%08x:%08x reading data.\n",
                       client->xdr->x_prog, client->xdr->x_vers);
                     grabPartialWakeLock();
-                    client->xdr->xops->read(client->xdr);
+                    if (!client->xdr->xops->read(client->xdr)) {
+                        E("%08x:%08x error reading packet.\n",
+                          client->xdr->x_prog, client->xdr->x_vers);
+                        pthread_mutex_unlock(&client->input_xdr_lock);
+                        releaseWakeLock();
+                        continue;
+                    }
                     client->input_xdr_busy = 1;
                     pthread_mutex_unlock(&client->input_xdr_lock);
 
                     if (((uint32 *)(client->xdr->in_msg))[RPC_OFFSET+1] == 
                         htonl(RPC_MSG_REPLY)) {
-                        /* Wake up the RPC client to receive its data. */
+                        /* Hand the reply to the call waiting for it. */
                         D("%08x:%08x received REPLY (XID %d), "
                           "grabbing mutex to wake up client.\n",
                           client->xdr->x_prog,
                           client->xdr->x_vers,
                           ntohl(((uint32 *)client->xdr->in_msg)[RPC_OFFSET]));
                         pthread_mutex_lock(&client->wait_reply_lock);
-                        D("%08x:%08x got mutex, waking up client.\n",
-                          client->xdr->x_prog,
-                          client->xdr->x_vers);
-                        pthread_cond_signal(&client->wait_reply);
+                        deliver_reply(client);
                         pthread_mutex_unlock(&client->wait_reply_lock);
 
+                        /* The reply was copied out, the buffer is free. */
+                        pthread_mutex_lock(&client->input_xdr_lock);
+                        client->input_xdr_busy = 0;
+                        pthread_cond_signal(&client->input_xdr_wait);
+                        pthread_mutex_unlock(&client->input_xdr_lock);
+
                         releaseWakeLock();
                     }
                     else {
@@ -302,11 +445,29 @@ clnt_call(
     opaque_auth verf;
     rpc_reply_header reply_header;
     enum clnt_stat ret = RPC_SUCCESS;
+    struct timespec deadline;
+    int timed;
+    rpc_call *call;
+    xdr_s_type *xdr;
 
-    xdr_s_type *xdr = client->xdr;
-
-    pthread_mutex_lock(&client->lock);
+    /* A zero timeout waits forever, as clnt_call() always used to. */
+    timed = timeout.tv_sec > 0 || timeout.tv_usec > 0;
+    if (timed) {
+        struct timeval now;
+        gettimeofday(&now, NULL);
+        deadline.tv_sec = now.tv_sec + timeout.tv_sec +
+            (now.tv_usec + timeout.tv_usec) / 1000000;
+        deadline.tv_nsec = ((now.tv_usec + timeout.tv_usec) % 1000000) * 1000;
+    }
 
+    call = get_call(client);
+    if (!call) {
+        E("%08x:%08x out of memory for call\n",
+          client->xdr->x_prog,
+          client->xdr->x_vers);
+        return RPC_SYSTEMERROR;
+    }
+    xdr = &call->xdr;
 
     cred.oa_flavor = AUTH_NONE;
     cred.oa_length = 0;
@@ -338,38 +499,64 @@ clnt_call(
         goto out;
     }
 
-    /* Finish message - blocking */
+    /* Queue the call before sending it, the reply may beat us back. */
     pthread_mutex_lock(&client->wait_reply_lock);
+    if (client->destroying) {
+        pthread_mutex_unlock(&client->wait_reply_lock);
+        ret = RPC_CANTSEND;
+        E("%08x:%08x call on a client being destroyed\n",
+          client->xdr->x_prog,
+          client->xdr->x_vers);
+        goto out;
+    }
+    call->next = client->pending_calls;
+    client->pending_calls = call;
+    client->num_calls++;
+    pthread_mutex_unlock(&client->wait_reply_lock);
+
     D("%08x:%08x sending call (XID %d).\n",
-      client->xdr->x_prog, client->xdr->x_vers, client->xdr->xid);
+      client->xdr->x_prog, client->xdr->x_vers, xdr->xid);
     if (!XDR_MSG_SEND(xdr)) {
         ret = RPC_CANTSEND;
         E("error in XDR_MSG_SEND\n");
+        pthread_mutex_lock(&client->wait_reply_lock);
+        unlink_call(client, ((uint32 *)xdr->out_msg)[RPC_OFFSET]);
         goto out_unlock;
     }
 
     D("%08x:%08x waiting for reply.\n",
       client->xdr->x_prog, client->xdr->x_vers);
-    pthread_cond_wait(&client->wait_reply, &client->wait_reply_lock);
-    D("%08x:%08x received reply.\n", client->xdr->x_prog, client->xdr->x_vers);
-
-    if (((uint32 *)xdr->out_msg)[RPC_OFFSET] != 
-        ((uint32 *)xdr->in_msg)[RPC_OFFSET]) {
-        E("%08x:%08x XID mismatch: got %d, expecting %d.\n",
-          client->xdr->x_prog, client->xdr->x_vers,
-          ntohl(((uint32 *)xdr->in_msg)[RPC_OFFSET]),
-          ntohl(((uint32 *)xdr->out_msg)[RPC_OFFSET]));
+    pthread_mutex_lock(&client->wait_reply_lock);
+    while (!call->done) {
+        if (!timed) {
+            pthread_cond_wait(&call->done_cond, &client->wait_reply_lock);
+        } else if (pthread_cond_timedwait(&call->done_cond,
+                                          &client->wait_reply_lock,
+                                          &deadline) == ETIMEDOUT &&
+                   !call->done) {
+            unlink_call(client, ((uint32 *)xdr->out_msg)[RPC_OFFSET]);
+            ret = RPC_TIMEDOUT;
+            E("%08x:%08x call timed out (XID %d).\n",
+              client->xdr->x_prog, client->xdr->x_vers, xdr->xid);
+            goto out_unlock;
+        }
+    }
+    if (call->done < 0) {
         ret = RPC_CANTRECV;
+        E("%08x:%08x client destroyed during call.\n",
+          client->xdr->x_prog, client->xdr->x_vers);
         goto out_unlock;
     }
+    pthread_mutex_unlock(&client->wait_reply_lock);
+    D("%08x:%08x received reply.\n", client->xdr->x_prog, client->xdr->x_vers);
 
     D("%08x:%08x decoding reply header.\n",
       client->xdr->x_prog, client->xdr->x_vers);
-    if (!xdr_recv_reply_header (client->xdr, &reply_header)) {
+    if (!xdr_recv_reply_header (xdr, &reply_header)) {
         E("%08x:%08x error reading reply header.\n",
           client->xdr->x_prog, client->xdr->x_vers);
         ret = RPC_CANTRECV;
-        goto out_unlock;
+        goto out_lock;
     }
 
     /* Check that other side accepted and responded */
@@ -378,13 +565,13 @@ clnt_call(
         ret = reply_header.u.dr.stat + RPC_VERSMISMATCH;
         E("%08x:%08x call was not accepted.\n",
           (uint32_t)client->xdr->x_prog, client->xdr->x_vers);
-        goto out_unlock;
+        goto out_lock;
     } else if (reply_header.u.ar.stat != RPC_ACCEPT_SUCCESS) {
         /* Offset to map returned error into clnt_stat */
         ret = reply_header.u.ar.stat + RPC_AUTHERROR;
         E("%08x:%08x call failed with an authentication error.\n",
           (uint32_t)client->xdr->x_prog, client->xdr->x_vers);
-        goto out_unlock;
+        goto out_lock;
     }
 
     xdr->x_op = XDR_DECODE;
@@ -393,23 +580,20 @@ clnt_call(
         ret = RPC_CANTDECODERES;
         E("%08x:%08x error decoding results.\n",
           client->xdr->x_prog, client->xdr->x_vers);
-        goto out_unlock;
+        goto out_lock;
     }
 
     D("%08x:%08x call success.\n",
       client->xdr->x_prog, client->xdr->x_vers);
 
+  out_lock:
+    pthread_mutex_lock(&client->wait_reply_lock);
   out_unlock:
-    pthread_mutex_lock(&client->input_xdr_lock);
-    D("%08x:%08x marking input buffer as free.\n",
-      client->xdr->x_prog, client->xdr->x_vers);
-    client->input_xdr_busy = 0;
-    pthread_cond_signal(&client->input_xdr_wait);
-    pthread_mutex_unlock(&client->input_xdr_lock);
-
+    if (--client->num_calls == 0 && client->destroying)
+        pthread_cond_broadcast(&client->wait_reply);
     pthread_mutex_unlock(&client->wait_reply_lock);
   out:
-    pthread_mutex_unlock(&client->lock);
+    put_call(client, call);
     return ret;
 } /* clnt_call */
 
@@ -591,11 +775,27 @@ CLIENT *clnt_create(
 
 void clnt_destroy(CLIENT *client) {
     if (client) {
-        pthread_mutex_lock(&client->lock);
+        rpc_call *call;
+
         D("%08x:%08x destroying client\n",
           client->xdr->x_prog,
           client->xdr->x_vers);
 
+        /* Fail the calls still waiting for a reply and let them return. */
+        pthread_mutex_lock(&client->wait_reply_lock);
+        client->destroying = 1;
+        while ((call = client->pending_calls) != NULL) {
+            client->pending_calls = call->next;
+            call->next = NULL;
+            call->done = -1;
+            pthread_cond_signal(&call->done_cond);
+        }
+        while (client->num_calls)
+            pthread_cond_wait(&client->wait_reply, &client->wait_reply_lock);
+        pthread_mutex_unlock(&client->wait_reply_lock);
+
+        pthread_mutex_lock(&client->lock);
+
 
         if (!client->cb_stop) {
             /* The callback thread is running, we need to stop it */
@@ -645,6 +845,12 @@ void clnt_destroy(CLIENT *client) {
         pthread_cond_destroy(&client->wait_reply);
         xdr_destroy_common(client->xdr);
 
+        while ((call = client->idle_calls) != NULL) {
+            client->idle_calls = call->next;
+            pthread_cond_destroy(&call->done_cond);
+            free(call);
+        }
+
         // FIXME: what happens when we lock the client while destroying it,
         // and another thread locks the mutex in clnt_call, and then we 
         // call pthread_mutex_destroy?  Does destroy automatically unlock and
@@ -72,8 +72,10 @@ extern "C" {
 #define RPC_MSG_VERSION    ((u_long) 2)
 
 #include <inttypes.h>
+#include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
+#include <sys/types.h>
 
 typedef int bool_t; /* This has to be a long, as it is used for XDR boolean too, which is a 4-byte value */
 typedef unsigned long rpcprog_t;
@@ -30,29 +30,16 @@ static bool_t xdr_std_msg_start(xdr_s_type *xdr,
                                  rpc_msg_e_type rpc_msg_type)
 {
 
-    /* xid is does not matter under our set of assumptions: that for a single
-     * program/version channel, communication is synchronous.  If several
-     * processes attempt to call functions on a program, then the rpcrouter
-     * driver will ensure that the calls are properly muxed, because the
-     * processes will have separate PIDs, and the rpcrouter driver uses PIDs to
-     * keep track of RPC transactions.  For multiple threads in the same
-     * process accessing the same program, we serialize access in clnt_call()
-     * by locking a mutex around the RPC call.  If threads in the same process
-     * call into different programs, then there is no issue, again because of
-     * the use of a mutex in clnt_call().
-     * 
-     * NOTE: This comment assumes that the only way we talk to the RPC router
-     *       from a client is by using clnt_call(), which is the case for all
-     *       client code generated by rpcgen().
+    /* Several threads of a process may have calls outstanding on the same
+     * program/version channel at once: clnt_call() gives every call its own
+     * XDR, seeded from a per-client counter, and the client RX thread matches
+     * replies to calls by the XID written here.  Calls from different
+     * processes are told apart by the rpcrouter driver, which tracks
+     * transactions by PID.
      *
-     * NOTE: The RPC router driver will soon be able to open a separate device
-     *       file for each program/version channel.  This will allow for
-     *       natural multiplexing among clients, as we won't have to rely on
-     *       the mutex for the case where different programs are being called
-     *       into by separate threads in the same process.  When this happens,
-     *       we'll need to optimize the RPC library to add a separate mutex for
-     *       each program/version channel, which will require some sort of
-     *       registry.
+     * NOTE: This assumes that the only way we talk to the RPC router from a
+     *       client is by using clnt_call(), which is the case for all client
+     *       code generated by rpcgen().
      */
 
     if (rpc_msg_type == RPC_MSG_CALL) xdr->xid++;
@@ -0,0 +1,30 @@
+LOCAL_PATH:= $(call my-dir)
+
+# clnt_call() checks and throughput benchmark over a loopback fake router,
+# which stands in for ops.c
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	rpc_bench.c \
+	fake_router.c \
+	../xdr.c \
+	../rpc.c \
+	../svc.c \
+	../clnt.c \
+	../svc_clnt_common.c
+
+LOCAL_C_INCLUDES:= \
+	$(LOCAL_PATH)/.. \
+	hardware/libhardware_legacy/include
+
+LOCAL_CFLAGS:= -fno-short-enums -DRPC_OFFSET=0
+
+LOCAL_STATIC_LIBRARIES:= liblog
+
+LOCAL_LDLIBS += -lpthread
+
+LOCAL_MODULE:= librpc_bench
+
+LOCAL_MODULE_TAGS:= tests
+
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,214 @@
+/*
+** Copyright 2010, The Android Open-Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License"); 
+** you may not use this file except in compliance with the License. 
+** You may obtain a copy of the License at 
+**
+**     http://www.apache.org/licenses/LICENSE-2.0 
+**
+** Unless required by applicable law or agreed to in writing, software 
+** distributed under the License is distributed on an "AS IS" BASIS, 
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. 
+** See the License for the specific language governing permissions and 
+** limitations under the License.
+*/
+
+#include <rpc/rpc.h>
+#include <arpa/inet.h>
+#include <debug.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "fake_router.h"
+
+#define MAX_QUEUED_REPLIES 256
+
+typedef struct {
+    long long due;              /* us */
+    uint32 msg[7];
+} queued_reply;
+
+typedef struct {
+    int fd;
+    int count;
+    queued_reply replies[MAX_QUEUED_REPLIES];   /* sorted by due time */
+} modem;
+
+static volatile unsigned latency_us = 100;
+static volatile unsigned num_calls;
+
+void fake_router_set_latency(unsigned usec)
+{
+    latency_us = usec;
+}
+
+unsigned fake_router_calls()
+{
+    return __sync_fetch_and_add(&num_calls, 0);
+}
+
+static long long now_us()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+static void queue_reply(modem *m, const uint32 *call, int words)
+{
+    /* xid, msg type, rpc version, prog, vers, proc, cred (2), verf (2) */
+    uint32 proc = ntohl(call[RPC_OFFSET+5]);
+    uint32 value = words > RPC_OFFSET+10 ? ntohl(call[RPC_OFFSET+10]) : 0;
+    uint32 delay = words > RPC_OFFSET+11 ? ntohl(call[RPC_OFFSET+11]) : 0;
+    queued_reply r;
+    int i;
+
+    __sync_fetch_and_add(&num_calls, 1);
+    if (proc == FAKE_PROC_DROP)
+        return;
+    if (m->count == MAX_QUEUED_REPLIES) {
+        E("fake router: reply queue full, dropping XID %d\n",
+          ntohl(call[RPC_OFFSET]));
+        return;
+    }
+
+    r.due = now_us() + latency_us + delay;
+    r.msg[0] = call[RPC_OFFSET];            /* xid */
+    r.msg[1] = htonl(RPC_MSG_REPLY);
+    r.msg[2] = htonl(RPC_MSG_ACCEPTED);
+    r.msg[3] = htonl(AUTH_NONE);            /* verf */
+    r.msg[4] = 0;
+    r.msg[5] = htonl(RPC_ACCEPT_SUCCESS);
+    r.msg[6] = htonl(value);
+
+    for (i = m->count; i > 0 && m->replies[i-1].due > r.due; i--)
+        m->replies[i] = m->replies[i-1];
+    m->replies[i] = r;
+    m->count++;
+}
+
+static void *modem_thread(void *arg)
+{
+    modem *m = (modem *)arg;
+    uint32 buf[RPCROUTER_MSGSIZE_MAX / 4];
+
+    for (;;) {
+        struct pollfd pfd;
+        int timeout = -1;
+        long long now = now_us();
+
+        while (m->count && m->replies[0].due <= now) {
+            send(m->fd, m->replies[0].msg, sizeof(m->replies[0].msg),
+                 MSG_NOSIGNAL);
+            memmove(m->replies, m->replies + 1,
+                    --m->count * sizeof(queued_reply));
+        }
+        if (m->count)
+            timeout = (int)((m->replies[0].due - now + 999) / 1000);
+
+        pfd.fd = m->fd;
+        pfd.events = POLLIN;
+        if (m->count && m->replies[0].due - now < 1000) {
+            /* poll() has ms resolution, spin on short deadlines */
+            timeout = 0;
+        }
+        if (poll(&pfd, 1, timeout) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (pfd.revents & POLLIN) {
+            int n = read(m->fd, buf, sizeof(buf));
+            if (n <= 0)
+                break;      /* client closed its end */
+            if (n >= (RPC_OFFSET+10) * 4 &&
+                buf[RPC_OFFSET+1] == htonl(RPC_MSG_CALL))
+                queue_reply(m, buf, n / 4);
+        } else if (pfd.revents & (POLLHUP | POLLERR)) {
+            break;
+        }
+    }
+    close(m->fd);
+    free(m);
+    return NULL;
+}
+
+/* The transport used by the XDR layer, see ops.c */
+
+int r_open(const char *router)
+{
+    int fds[2];
+    modem *m;
+    pthread_t thread;
+
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) < 0) {
+        E("error opening %s: %s\n", router, strerror(errno));
+        return -1;
+    }
+    m = calloc(1, sizeof(modem));
+    m->fd = fds[1];
+    pthread_create(&thread, NULL, modem_thread, m);
+    pthread_detach(thread);
+    return fds[0];
+}
+
+void r_close(int handle)
+{
+    if(close(handle) < 0) E("error: %s\n", strerror(errno));
+}
+
+int r_read(int handle, char *buf, uint32 size)
+{
+    int rc = read(handle, buf, size);
+    if (rc < 0)
+        E("error reading RPC packet: %d (%s)\n", errno, strerror(errno));
+    return rc;
+}
+
+int r_write(int handle, const char *buf, uint32 size)
+{
+    int rc = write(handle, buf, size);
+    if (rc < 0)
+        E("error writing RPC packet: %d (%s)\n", errno, strerror(errno));
+    return rc;
+}
+
+int r_control(int handle, const uint32 cmd, void *arg)
+{
+    return 0;
+}
+
+/* no wakelocks on the host */
+
+int acquire_wake_lock(int lock, const char* id)
+{
+    return 0;
+}
+
+int release_wake_lock(const char* id)
+{
+    return 0;
+}
+
+int wake_lock_acquire(const char* id)
+{
+    return 0;
+}
+
+int wake_lock_release(const char* id)
+{
+    return 0;
+}
+
+int wake_lock_set_linger(const char* id, int linger_ms)
+{
+    return 0;
+}
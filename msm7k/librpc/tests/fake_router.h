@@ -0,0 +1,39 @@
+/*
+** Copyright 2010, The Android Open-Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License"); 
+** you may not use this file except in compliance with the License. 
+** You may obtain a copy of the License at 
+**
+**     http://www.apache.org/licenses/LICENSE-2.0 
+**
+** Unless required by applicable law or agreed to in writing, software 
+** distributed under the License is distributed on an "AS IS" BASIS, 
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. 
+** See the License for the specific language governing permissions and 
+** limitations under the License.
+*/
+
+#ifndef FAKE_ROUTER_H
+#define FAKE_ROUTER_H
+
+/* Loopback stand-in for the rpcrouter driver.  It replaces ops.c: every
+   r_open() gets a socketpair whose far end is served by a "modem" thread
+   that answers calls after a configurable round-trip latency.  Replies to
+   calls in flight together are sent back as they come due, so a client
+   that pipelines its calls sees the latency overlap.
+
+   All procedures take two uint32 arguments (value, extra delay in us) and
+   return one uint32.
+*/
+
+#define FAKE_PROC_ECHO  1   /* returns value after the latency + delay */
+#define FAKE_PROC_DROP  2   /* never answers */
+
+/* Round-trip latency applied to every call, in microseconds. */
+void fake_router_set_latency(unsigned usec);
+
+/* Number of calls the modem side has received. */
+unsigned fake_router_calls();
+
+#endif /* FAKE_ROUTER_H */
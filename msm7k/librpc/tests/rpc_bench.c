@@ -0,0 +1,221 @@
+/*
+** Copyright 2010, The Android Open-Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License"); 
+** you may not use this file except in compliance with the License. 
+** You may obtain a copy of the License at 
+**
+**     http://www.apache.org/licenses/LICENSE-2.0 
+**
+** Unless required by applicable law or agreed to in writing, software 
+** distributed under the License is distributed on an "AS IS" BASIS, 
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. 
+** See the License for the specific language governing permissions and 
+** limitations under the License.
+*/
+
+/* Multi-threaded clnt_call() checks and throughput benchmark against the
+   loopback router in fake_router.c.
+
+     rpc_bench [calls per thread] [latency us]
+*/
+
+#include <rpc/rpc.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "fake_router.h"
+
+#define TEST_PROG 0x30000099
+#define TEST_VERS 0x00010001
+
+typedef struct {
+    uint32 value;
+    uint32 delay;
+} test_args;
+
+static bool_t xdr_test_args(XDR *xdr, test_args *args)
+{
+    return XDR_SEND_UINT32(xdr, &args->value) &&
+           XDR_SEND_UINT32(xdr, &args->delay);
+}
+
+static bool_t xdr_test_result(XDR *xdr, uint32 *result)
+{
+    return XDR_RECV_UINT32(xdr, result);
+}
+
+static CLIENT *client;
+static int errors;
+
+static long long now_us()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+static enum clnt_stat call(u_long proc, uint32 value, uint32 delay,
+                           int timeout_ms, uint32 *result)
+{
+    test_args args;
+    struct timeval tv;
+    args.value = value;
+    args.delay = delay;
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    return clnt_call(client, proc,
+                     (xdrproc_t)xdr_test_args, (caddr_t)&args,
+                     (xdrproc_t)xdr_test_result, (caddr_t)result, tv);
+}
+
+/* ------------------------------------------------------------------------ */
+
+typedef struct {
+    uint32 value;
+    uint32 delay;
+    long long finished;
+    enum clnt_stat stat;
+    uint32 result;
+} slow_call;
+
+static void *slow_call_thread(void *arg)
+{
+    slow_call *c = (slow_call *)arg;
+    c->stat = call(FAKE_PROC_ECHO, c->value, c->delay, 0, &c->result);
+    c->finished = now_us();
+    return NULL;
+}
+
+static void check_out_of_order()
+{
+    slow_call slow = { 1111, 200000, 0, RPC_FAILED, 0 };
+    pthread_t thread;
+    uint32 result = 0;
+    long long done;
+
+    pthread_create(&thread, NULL, slow_call_thread, &slow);
+    usleep(20000);
+    /* must not queue up behind the slow call */
+    if (call(FAKE_PROC_ECHO, 2222, 0, 0, &result) != RPC_SUCCESS ||
+            result != 2222) {
+        fprintf(stderr, "fast call failed (result %u)\n", result);
+        errors++;
+    }
+    done = now_us();
+    pthread_join(thread, NULL);
+    if (slow.stat != RPC_SUCCESS || slow.result != 1111) {
+        fprintf(stderr, "slow call failed (%d, result %u)\n",
+                slow.stat, slow.result);
+        errors++;
+    }
+    if (slow.finished < done) {
+        fprintf(stderr, "fast call waited for the slow one\n");
+        errors++;
+    }
+}
+
+static void check_timeouts()
+{
+    uint32 result = 0;
+    long long t0 = now_us();
+    enum clnt_stat stat = call(FAKE_PROC_DROP, 1, 0, 100, &result);
+    long long waited = now_us() - t0;
+    if (stat != RPC_TIMEDOUT || waited < 100000 || waited > 300000) {
+        fprintf(stderr, "dropped call: stat %d after %lld ms\n",
+                stat, waited / 1000);
+        errors++;
+    }
+
+    /* the reply shows up after the caller gave up and must be ignored */
+    stat = call(FAKE_PROC_ECHO, 3333, 150000, 50, &result);
+    if (stat != RPC_TIMEDOUT) {
+        fprintf(stderr, "late call: stat %d\n", stat);
+        errors++;
+    }
+    usleep(200000);
+    if (call(FAKE_PROC_ECHO, 4444, 0, 1000, &result) != RPC_SUCCESS ||
+            result != 4444) {
+        fprintf(stderr, "call after a late reply failed (result %u)\n",
+                result);
+        errors++;
+    }
+}
+
+/* ------------------------------------------------------------------------ */
+
+typedef struct {
+    int id;
+    int calls;
+    int failures;
+} worker;
+
+static void *worker_thread(void *arg)
+{
+    worker *w = (worker *)arg;
+    int i;
+    for (i = 0; i < w->calls; i++) {
+        uint32 value = (w->id << 20) | i;
+        uint32 result = 0;
+        if (call(FAKE_PROC_ECHO, value, 0, 5000, &result) != RPC_SUCCESS ||
+                result != value)
+            w->failures++;
+    }
+    return NULL;
+}
+
+static void bench(int threads, int calls)
+{
+    pthread_t tid[64];
+    worker w[64];
+    long long t0, elapsed;
+    int i, failures = 0;
+
+    t0 = now_us();
+    for (i = 0; i < threads; i++) {
+        w[i].id = i;
+        w[i].calls = calls;
+        w[i].failures = 0;
+        pthread_create(&tid[i], NULL, worker_thread, &w[i]);
+    }
+    for (i = 0; i < threads; i++) {
+        pthread_join(tid[i], NULL);
+        failures += w[i].failures;
+    }
+    elapsed = now_us() - t0;
+    printf("%2d threads: %8.0f calls/s, %6.0f us per call%s\n",
+           threads, threads * calls * 1e6 / elapsed,
+           (double)elapsed * threads / (threads * calls),
+           failures ? " (FAILURES)" : "");
+    errors += failures;
+}
+
+int main(int argc, char **argv)
+{
+    int calls = argc > 1 ? atoi(argv[1]) : 500;
+    unsigned latency = argc > 2 ? atoi(argv[2]) : 500;
+    int threads;
+
+    client = clnt_create(NULL, TEST_PROG, TEST_VERS, NULL);
+    if (!client) {
+        fprintf(stderr, "clnt_create failed\n");
+        return 1;
+    }
+
+    fake_router_set_latency(1000);
+    check_out_of_order();
+    check_timeouts();
+
+    fake_router_set_latency(latency);
+    printf("round trip latency %u us, %d calls per thread\n", latency, calls);
+    for (threads = 1; threads <= 16; threads *= 2)
+        bench(threads, calls);
+
+    clnt_destroy(client);
+    printf("%s\n", errors ? "FAILED" : "passed");
+    return errors ? 1 : 0;
+}
@@ -27,7 +27,8 @@ LOCAL_SRC_FILES += \
     loc_eng.cpp \
     loc_eng_ioctl.cpp \
     loc_eng_xtra.cpp \
-    loc_eng_ni.cpp
+    loc_eng_ni.cpp \
+    loc_eng_evt_queue.cpp
 
 LOCAL_CFLAGS += \
     -fno-short-enums 
@@ -41,5 +42,7 @@ LOCAL_C_INCLUDES:= \
 LOCAL_PRELINK_MODULE := false
 include $(BUILD_SHARED_LIBRARY)
 
+include $(call all-makefiles-under,$(LOCAL_PATH))
+
 endif # not BUILD_TINY_ANDROID
 
@@ -94,7 +94,7 @@ static void loc_eng_process_conn_request (const rpc_loc_server_request_s_type *s
 static void* loc_eng_process_deferred_action (void* arg);
 static void loc_eng_process_atl_deferred_action (boolean data_connection_succeeded,
         boolean data_connection_closed);
-static void loc_eng_delete_aiding_data_deferred_action (void);
+static void loc_eng_delete_aiding_data_deferred_action (GpsAidingData aiding_data_for_deletion);
 
 static int set_agps_server();
 
@@ -201,7 +201,7 @@ static int loc_eng_init(GpsCallbacks* callbacks)
     pthread_cond_init  (&(loc_eng_data.deferred_action_cond) , NULL);
     loc_eng_data.deferred_action_thread_need_exit = FALSE;
  
-    loc_eng_data.loc_event = 0;
+    loc_eng_evt_queue_init (&loc_eng_data.evt_queue);
     loc_eng_data.data_connection_succeeded = FALSE;
     loc_eng_data.data_connection_closed = FALSE;
     loc_eng_data.data_connection_failed = FALSE;
@@ -268,6 +268,8 @@ static void loc_eng_cleanup()
     // clean up
     (void) loc_close (loc_eng_data.client_handle);
 
+    loc_eng_evt_queue_log_stats (&loc_eng_data.evt_queue);
+
     pthread_mutex_destroy (&loc_eng_data.deferred_action_mutex);
     pthread_cond_destroy  (&loc_eng_data.deferred_action_cond);
 
@@ -670,12 +672,24 @@ static int32 loc_event_cb(
     LOGV ("loc_event_cb, client = %d, loc_event = 0x%x", (int32) client_handle, (uint32) loc_event);
     if (client_handle == loc_eng_data.client_handle)
     {
-        pthread_mutex_lock(&loc_eng_data.deferred_action_mutex);
-        loc_eng_data.loc_event = loc_event;
-        memcpy(&loc_eng_data.loc_event_payload, loc_event_payload, sizeof(*loc_event_payload));
+        // The deferred action thread may be the one waiting for this report
+        // in loc_eng_ioctl, so it cannot be queued behind it
+        if (loc_event & RPC_LOC_EVENT_IOCTL_REPORT)
+        {
+            (void) loc_eng_ioctl_process_cb (loc_eng_data.client_handle,
+                                    &(loc_event_payload->rpc_loc_event_payload_u_type_u.ioctl_report));
+            loc_event &= ~RPC_LOC_EVENT_IOCTL_REPORT;
+        }
 
-        pthread_cond_signal  (&loc_eng_data.deferred_action_cond);
-        pthread_mutex_unlock (&loc_eng_data.deferred_action_mutex);
+        if (loc_event != 0)
+        {
+            pthread_mutex_lock(&loc_eng_data.deferred_action_mutex);
+            if (loc_eng_evt_queue_put (&loc_eng_data.evt_queue, loc_event, loc_event_payload))
+            {
+                pthread_cond_signal (&loc_eng_data.deferred_action_cond);
+            }
+            pthread_mutex_unlock (&loc_eng_data.deferred_action_mutex);
+        }
     }
     else
     {
@@ -1148,7 +1162,7 @@ SIDE EFFECTS
    N/A
 
 ===========================================================================*/
-static void loc_eng_delete_aiding_data_deferred_action (void)
+static void loc_eng_delete_aiding_data_deferred_action (GpsAidingData aiding_data_for_deletion)
 {
     // Currently, we only support deletion of all aiding data,
     // since the Android defined aiding data mask matches with modem,
@@ -1160,13 +1174,13 @@ static void loc_eng_delete_aiding_data_deferred_action (void)
     ioctl_data.disc = RPC_LOC_IOCTL_DELETE_ASSIST_DATA;
 
     assist_data_ptr = &(ioctl_data.rpc_loc_ioctl_data_u_type_u.assist_data_delete);
-    if (loc_eng_data.aiding_data_for_deletion == GPS_DELETE_ALL)
+    if (aiding_data_for_deletion == GPS_DELETE_ALL)
     {
         assist_data_ptr->type = RPC_LOC_ASSIST_DATA_ALL;
     }
     else
     {
-        assist_data_ptr->type = loc_eng_data.aiding_data_for_deletion;
+        assist_data_ptr->type = aiding_data_for_deletion;
     }
     memset (&(assist_data_ptr->reserved), 0, sizeof (assist_data_ptr->reserved));
 
@@ -1303,13 +1317,6 @@ static void loc_eng_process_loc_event (rpc_loc_event_mask_type loc_event,
         }
     }
 
-    if (loc_event & RPC_LOC_EVENT_IOCTL_REPORT)
-    {
-        // Process the received RPC_LOC_EVENT_IOCTL_REPORT
-        (void) loc_eng_ioctl_process_cb (loc_eng_data.client_handle,
-                                &(loc_event_payload->rpc_loc_event_payload_u_type_u.ioctl_report));
-    }
-
     if (loc_event & RPC_LOC_EVENT_LOCATION_SERVER_REQUEST)
     {
         loc_eng_process_conn_request (&(loc_event_payload->rpc_loc_event_payload_u_type_u.loc_server_request));
@@ -1331,6 +1338,37 @@ static void loc_eng_process_loc_event (rpc_loc_event_mask_type loc_event,
 #endif /* DEBUG_MOCK_NI == 1 */
 }
 
+// Event being processed by the deferred action thread
+static loc_eng_evt_s_type loc_eng_deferred_evt;
+
+/*===========================================================================
+FUNCTION loc_eng_deferred_action_pending
+
+DESCRIPTION
+   Checks whether the deferred action thread has anything to do. Must be
+   called with deferred_action_mutex held.
+
+DEPENDENCIES
+   None
+
+RETURN VALUE
+   TRUE if there is work for the deferred action thread
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static boolean loc_eng_deferred_action_pending (void)
+{
+    return (loc_eng_data.evt_queue.count != 0 ||
+            loc_eng_data.agps_status != 0 ||
+            loc_eng_data.data_connection_succeeded ||
+            loc_eng_data.data_connection_closed ||
+            loc_eng_data.data_connection_failed ||
+            (loc_eng_data.aiding_data_for_deletion != 0 &&
+             loc_eng_data.engine_status != GPS_STATUS_SESSION_BEGIN));
+}
+
 /*===========================================================================
 FUNCTION loc_eng_process_deferred_action
 
@@ -1369,13 +1407,16 @@ static void* loc_eng_process_deferred_action (void* arg)
         boolean         data_connection_closed;
         boolean         data_connection_failed;
 
-        rpc_loc_event_mask_type         loc_event;
-        rpc_loc_event_payload_u_type    loc_event_payload;
+        boolean         have_evt;
 
-        // Wait until we are signalled to do a deferred action, or exit
+        // Wait until there is a deferred action to do, or exit
         pthread_mutex_lock(&loc_eng_data.deferred_action_mutex);
-        pthread_cond_wait(&loc_eng_data.deferred_action_cond,
-                            &loc_eng_data.deferred_action_mutex);
+        while (loc_eng_data.deferred_action_thread_need_exit == FALSE &&
+               loc_eng_deferred_action_pending() == FALSE)
+        {
+            pthread_cond_wait(&loc_eng_data.deferred_action_cond,
+                                &loc_eng_data.deferred_action_mutex);
+        }
 
         if (loc_eng_data.deferred_action_thread_need_exit == TRUE)
         {
@@ -1383,15 +1424,16 @@ static void* loc_eng_process_deferred_action (void* arg)
             break;
         }
 
-        // copy anything we need before releasing the mutex
-        loc_event = loc_eng_data.loc_event;
-        if (loc_event != 0) {
-            memcpy(&loc_event_payload, &loc_eng_data.loc_event_payload, sizeof(loc_event_payload));
-            loc_eng_data.loc_event = 0;
-        }
+        // copy anything we need before releasing the mutex, one event at a time
+        have_evt = loc_eng_evt_queue_get (&loc_eng_data.evt_queue, &loc_eng_deferred_evt);
 
-        engine_status = loc_eng_data.agps_status;
-        aiding_data_for_deletion = loc_eng_data.aiding_data_for_deletion;
+        engine_status = loc_eng_data.engine_status;
+        aiding_data_for_deletion = 0;
+        if (engine_status != GPS_STATUS_SESSION_BEGIN)
+        {
+            aiding_data_for_deletion = loc_eng_data.aiding_data_for_deletion;
+            loc_eng_data.aiding_data_for_deletion = 0;
+        }
         status.status = loc_eng_data.agps_status;
         loc_eng_data.agps_status = 0;
         data_connection_succeeded = loc_eng_data.data_connection_succeeded;
@@ -1404,14 +1446,14 @@ static void* loc_eng_process_deferred_action (void* arg)
         // perform all actions after releasing the mutex to avoid blocking RPCs from the ARM9
         pthread_mutex_unlock(&(loc_eng_data.deferred_action_mutex));
 
-        if (loc_event != 0) {
-            loc_eng_process_loc_event(loc_event, &loc_event_payload);
+        if (have_evt) {
+            loc_eng_process_loc_event(loc_eng_deferred_evt.loc_event, &loc_eng_deferred_evt.payload);
         }
 
         // send_delete_aiding_data must be done when GPS engine is off
-        if ((engine_status != GPS_STATUS_SESSION_BEGIN) && (aiding_data_for_deletion != 0))
+        if (aiding_data_for_deletion != 0)
         {
-            loc_eng_delete_aiding_data_deferred_action ();
+            loc_eng_delete_aiding_data_deferred_action (aiding_data_for_deletion);
         }
 
         if (data_connection_succeeded || data_connection_closed || data_connection_failed)
@@ -47,6 +47,7 @@ typedef unsigned char boolean;
 
 #include <loc_eng_ioctl.h>
 #include <loc_eng_xtra.h>
+#include <loc_eng_evt_queue.h>
 #include <hardware_legacy/gps_ni.h>
 
 #define LOC_IOCTL_DEFAULT_TIMEOUT 1000 // 1000 milli-seconds
@@ -68,9 +69,8 @@ typedef struct
 
     loc_eng_ioctl_data_s_type      ioctl_data;
 
-    // data from loc_event_cb
-    rpc_loc_event_mask_type         loc_event;
-    rpc_loc_event_payload_u_type    loc_event_payload;
+    // Events from loc_event_cb waiting for the deferred action thread
+    loc_eng_evt_queue_s_type       evt_queue;
 
     boolean                        data_connection_succeeded;
     boolean                        data_connection_closed;
@@ -0,0 +1,448 @@
+/******************************************************************************
+  @file:  loc_eng_evt_queue.cpp
+  @brief:  queue of location events for the deferred action thread
+
+  DESCRIPTION
+     Bounded queue between loc_event_cb and the deferred action thread.
+
+     What happens to an event depends on its type:
+     - satellite reports and assistance data requests are coalesced, a new
+       one replaces the one still pending,
+     - NMEA reports are queued, but are the first to go when the queue is
+       full, together with satellite reports,
+     - everything else is queued and only dropped if the queue is full of
+       events that cannot be dropped.
+
+  INITIALIZATION AND SEQUENCING REQUIREMENTS
+     Every function must be called with loc_eng_data.deferred_action_mutex
+     held.
+
+******************************************************************************/
+
+#define LOG_NDDEBUG 0
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <hardware_legacy/gps.h>
+
+#include <rpc/rpc.h>
+#include <loc_api_rpc_glue.h>
+#include <loc_eng.h>
+
+#define LOG_TAG "lib_locapi"
+#include <utils/Log.h>
+
+typedef enum
+{
+    // Always delivered, unless the queue is full of other such events
+    LOC_ENG_EVT_POLICY_KEEP,
+    // Delivered in order, dropped first when the queue is full
+    LOC_ENG_EVT_POLICY_DROPPABLE,
+    // Only the latest is delivered, dropped first when the queue is full
+    LOC_ENG_EVT_POLICY_LATEST
+} loc_eng_evt_policy_e_type;
+
+static const struct
+{
+    rpc_loc_event_mask_type        loc_event;
+    loc_eng_evt_policy_e_type      policy;
+    const char                    *name;
+} loc_eng_evt_info[LOC_ENG_EVT_MAX] =
+{
+    { RPC_LOC_EVENT_PARSED_POSITION_REPORT,     LOC_ENG_EVT_POLICY_KEEP,      "position"   },
+    { RPC_LOC_EVENT_SATELLITE_REPORT,           LOC_ENG_EVT_POLICY_LATEST,    "satellite"  },
+    { RPC_LOC_EVENT_NMEA_POSITION_REPORT,       LOC_ENG_EVT_POLICY_DROPPABLE, "nmea"       },
+    { RPC_LOC_EVENT_STATUS_REPORT,              LOC_ENG_EVT_POLICY_KEEP,      "status"     },
+    { RPC_LOC_EVENT_NI_NOTIFY_VERIFY_REQUEST,   LOC_ENG_EVT_POLICY_KEEP,      "ni"         },
+    { RPC_LOC_EVENT_ASSISTANCE_DATA_REQUEST,    LOC_ENG_EVT_POLICY_LATEST,    "assistance" },
+    { RPC_LOC_EVENT_LOCATION_SERVER_REQUEST,    LOC_ENG_EVT_POLICY_KEEP,      "server"     },
+};
+
+/*===========================================================================
+FUNCTION    loc_eng_evt_copy_string
+
+DESCRIPTION
+   Copies a counted string into the space left in an NI string buffer and
+   points the payload at the copy. Strings that do not fit are truncated.
+
+RETURN VALUE
+   N/A
+
+===========================================================================*/
+static void loc_eng_evt_copy_string (char **buf_ptr, uint32 *buf_left,
+        char **val_ptr, u_int *len_ptr)
+{
+    u_int len = *len_ptr;
+
+    if (*val_ptr == NULL)
+    {
+        *len_ptr = 0;
+        return;
+    }
+
+    if (*buf_left == 0)
+    {
+        *val_ptr = NULL;
+        *len_ptr = 0;
+        return;
+    }
+
+    // Leave room for a terminator, some of these are printed as strings
+    if (len > *buf_left - 1)
+    {
+        len = *buf_left - 1;
+    }
+
+    memcpy (*buf_ptr, *val_ptr, len);
+    (*buf_ptr)[len] = '\0';
+
+    *val_ptr = *buf_ptr;
+    *len_ptr = len;
+    *buf_ptr += len + 1;
+    *buf_left -= len + 1;
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_evt_copy_ni
+
+DESCRIPTION
+   Copies the strings an NI request points to into the event.
+
+RETURN VALUE
+   N/A
+
+===========================================================================*/
+static void loc_eng_evt_copy_ni (loc_eng_evt_s_type *evt_ptr)
+{
+    rpc_loc_ni_event_s_type *ni_req = &(evt_ptr->payload.rpc_loc_event_payload_u_type_u.ni_request);
+    char   *buf = evt_ptr->data.ni_strings;
+    uint32  buf_left = sizeof (evt_ptr->data.ni_strings);
+
+    if (ni_req->event == RPC_LOC_NI_EVENT_SUPL_NOTIFY_VERIFY_REQ)
+    {
+        rpc_loc_ni_supl_notify_verify_req_s_type *supl_req =
+            &(ni_req->payload.rpc_loc_ni_event_payload_u_type_u.supl_req);
+        rpc_loc_server_addr_u_type *slp_addr =
+            &(supl_req->supl_slp_session_id.slp_address.addr_info);
+
+        loc_eng_evt_copy_string (&buf, &buf_left,
+                &(supl_req->requestor_id.requestor_id_string.requestor_id_string_val),
+                &(supl_req->requestor_id.requestor_id_string.requestor_id_string_len));
+        loc_eng_evt_copy_string (&buf, &buf_left,
+                &(supl_req->client_name.client_name_string.client_name_string_val),
+                &(supl_req->client_name.client_name_string.client_name_string_len));
+
+        if (slp_addr->disc == RPC_LOC_SERVER_ADDR_URL)
+        {
+            loc_eng_evt_copy_string (&buf, &buf_left,
+                    &(slp_addr->rpc_loc_server_addr_u_type_u.url.addr.addr_val),
+                    &(slp_addr->rpc_loc_server_addr_u_type_u.url.addr.addr_len));
+        }
+    }
+    else if (ni_req->event == RPC_LOC_NI_EVENT_UMTS_CP_NOTIFY_VERIFY_REQ)
+    {
+        rpc_loc_ni_umts_cp_notify_verify_req_s_type *umts_cp_req =
+            &(ni_req->payload.rpc_loc_ni_event_payload_u_type_u.umts_cp_req);
+
+        loc_eng_evt_copy_string (&buf, &buf_left,
+                &(umts_cp_req->notification_text.notification_text_val),
+                &(umts_cp_req->notification_text.notification_text_len));
+        loc_eng_evt_copy_string (&buf, &buf_left,
+                &(umts_cp_req->ext_client_address_data.ext_client_address.ext_client_address_val),
+                &(umts_cp_req->ext_client_address_data.ext_client_address.ext_client_address_len));
+        loc_eng_evt_copy_string (&buf, &buf_left,
+                &(umts_cp_req->requestor_id.requestor_id_string.requestor_id_string_val),
+                &(umts_cp_req->requestor_id.requestor_id_string.requestor_id_string_len));
+        loc_eng_evt_copy_string (&buf, &buf_left,
+                &(umts_cp_req->codeword_string.lcs_codeword_string.lcs_codeword_string_val),
+                &(umts_cp_req->codeword_string.lcs_codeword_string.lcs_codeword_string_len));
+    }
+    // VX requests carry no pointers
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_evt_copy
+
+DESCRIPTION
+   Copies an event payload, and everything it points to, into an event.
+   The source may be an RPC payload or the payload of another event.
+
+RETURN VALUE
+   N/A
+
+===========================================================================*/
+static void loc_eng_evt_copy (loc_eng_evt_s_type *evt_ptr, loc_eng_evt_e_type type,
+        const rpc_loc_event_payload_u_type *loc_event_payload)
+{
+    evt_ptr->type = type;
+    evt_ptr->loc_event = loc_eng_evt_info[type].loc_event;
+    memcpy (&(evt_ptr->payload), loc_event_payload, sizeof (evt_ptr->payload));
+
+    switch (type)
+    {
+        case LOC_ENG_EVT_SATELLITE:
+        {
+            rpc_loc_gnss_info_s_type *gnss_report = &(evt_ptr->payload.rpc_loc_event_payload_u_type_u.gnss_report);
+            u_int sv_list_len = gnss_report->sv_list.sv_list_len;
+
+            if (gnss_report->sv_list.sv_list_val == NULL)
+            {
+                sv_list_len = 0;
+            }
+            // loc_eng_report_sv never reports more than GPS_MAX_SVS
+            if (sv_list_len > GPS_MAX_SVS)
+            {
+                sv_list_len = GPS_MAX_SVS;
+            }
+            memcpy (evt_ptr->data.sv_list, gnss_report->sv_list.sv_list_val,
+                    sv_list_len * sizeof (rpc_loc_sv_info_s_type));
+
+            gnss_report->sv_list.sv_list_val = evt_ptr->data.sv_list;
+            gnss_report->sv_list.sv_list_len = sv_list_len;
+            // sv_count is used to index the list
+            if (gnss_report->sv_count > sv_list_len)
+            {
+                gnss_report->sv_count = sv_list_len;
+            }
+            break;
+        }
+
+        case LOC_ENG_EVT_NMEA:
+        {
+            rpc_loc_nmea_report_s_type *nmea_report = &(evt_ptr->payload.rpc_loc_event_payload_u_type_u.nmea_report);
+            u_int nmea_len = nmea_report->nmea_sentences.nmea_sentences_len;
+
+            if (nmea_report->nmea_sentences.nmea_sentences_val == NULL)
+            {
+                nmea_len = 0;
+            }
+            if (nmea_len > RPC_LOC_API_MAX_NMEA_STRING_LENGTH)
+            {
+                nmea_len = RPC_LOC_API_MAX_NMEA_STRING_LENGTH;
+            }
+            memcpy (evt_ptr->data.nmea, nmea_report->nmea_sentences.nmea_sentences_val, nmea_len);
+            evt_ptr->data.nmea[nmea_len] = '\0';
+
+            nmea_report->nmea_sentences.nmea_sentences_val = evt_ptr->data.nmea;
+            nmea_report->nmea_sentences.nmea_sentences_len = nmea_len;
+            break;
+        }
+
+        case LOC_ENG_EVT_NI:
+            loc_eng_evt_copy_ni (evt_ptr);
+            break;
+
+        case LOC_ENG_EVT_ASSISTANCE:
+            // Only the request type is used, the server lists are not kept
+            memset (&(evt_ptr->payload.rpc_loc_event_payload_u_type_u.assist_data_request.payload),
+                    0,
+                    sizeof (rpc_loc_assist_data_request_payload_u_type));
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_evt_queue_remove
+
+DESCRIPTION
+   Removes the event at a position in the queue and frees its slot.
+
+RETURN VALUE
+   N/A
+
+===========================================================================*/
+static void loc_eng_evt_queue_remove (loc_eng_evt_queue_s_type *queue_ptr, int pos)
+{
+    int i;
+    uint8 slot = queue_ptr->order[(queue_ptr->head + pos) % LOC_ENG_EVT_QUEUE_SIZE];
+
+    for (i = pos; i < queue_ptr->count - 1; i++)
+    {
+        queue_ptr->order[(queue_ptr->head + i) % LOC_ENG_EVT_QUEUE_SIZE] =
+            queue_ptr->order[(queue_ptr->head + i + 1) % LOC_ENG_EVT_QUEUE_SIZE];
+    }
+    queue_ptr->count--;
+
+    queue_ptr->free_slots[queue_ptr->free_count++] = slot;
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_evt_queue_init
+
+DESCRIPTION
+   Empties the queue and clears the statistics.
+
+RETURN VALUE
+   N/A
+
+===========================================================================*/
+void loc_eng_evt_queue_init (loc_eng_evt_queue_s_type *queue_ptr)
+{
+    int i;
+
+    memset (queue_ptr, 0, sizeof (loc_eng_evt_queue_s_type));
+
+    for (i = 0; i < LOC_ENG_EVT_QUEUE_SIZE; i++)
+    {
+        queue_ptr->free_slots[i] = LOC_ENG_EVT_QUEUE_SIZE - 1 - i;
+    }
+    queue_ptr->free_count = LOC_ENG_EVT_QUEUE_SIZE;
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_evt_queue_put
+
+DESCRIPTION
+   Queues a copy of an event received from the location engine. If the
+   queue is full, the oldest satellite or NMEA report makes room for it.
+
+   Events with more than one mask bit set are queued as the first type
+   found, the payload only holds one of them.
+
+RETURN VALUE
+   TRUE                 if the event is going to be delivered
+   FALSE                if it was dropped or is not handled here
+
+===========================================================================*/
+boolean loc_eng_evt_queue_put (loc_eng_evt_queue_s_type *queue_ptr,
+        rpc_loc_event_mask_type loc_event,
+        const rpc_loc_event_payload_u_type *loc_event_payload)
+{
+    int type, pos;
+    uint8 slot = 0;
+
+    for (type = 0; type < LOC_ENG_EVT_MAX; type++)
+    {
+        if (loc_event & loc_eng_evt_info[type].loc_event)
+        {
+            break;
+        }
+    }
+
+    if (type == LOC_ENG_EVT_MAX)
+    {
+        LOGD ("loc_eng_evt_queue_put: event 0x%x not handled\n", (uint32) loc_event);
+        return FALSE;
+    }
+
+    queue_ptr->received[type]++;
+
+    if (loc_eng_evt_info[type].policy == LOC_ENG_EVT_POLICY_LATEST)
+    {
+        for (pos = 0; pos < queue_ptr->count; pos++)
+        {
+            slot = queue_ptr->order[(queue_ptr->head + pos) % LOC_ENG_EVT_QUEUE_SIZE];
+            if (queue_ptr->slots[slot].type == type)
+            {
+                // Takes the place of the pending one
+                loc_eng_evt_copy (&(queue_ptr->slots[slot]), (loc_eng_evt_e_type) type, loc_event_payload);
+                queue_ptr->coalesced[type]++;
+                return TRUE;
+            }
+        }
+    }
+
+    if (queue_ptr->free_count == 0)
+    {
+        for (pos = 0; pos < queue_ptr->count; pos++)
+        {
+            slot = queue_ptr->order[(queue_ptr->head + pos) % LOC_ENG_EVT_QUEUE_SIZE];
+            if (loc_eng_evt_info[queue_ptr->slots[slot].type].policy != LOC_ENG_EVT_POLICY_KEEP)
+            {
+                break;
+            }
+        }
+
+        if (pos == queue_ptr->count)
+        {
+            queue_ptr->dropped[type]++;
+            LOGW ("loc_eng_evt_queue_put: queue full, %s event dropped\n", loc_eng_evt_info[type].name);
+            return FALSE;
+        }
+
+        queue_ptr->dropped[queue_ptr->slots[slot].type]++;
+        LOGV ("loc_eng_evt_queue_put: queue full, pending %s event dropped\n",
+                loc_eng_evt_info[queue_ptr->slots[slot].type].name);
+        loc_eng_evt_queue_remove (queue_ptr, pos);
+    }
+
+    slot = queue_ptr->free_slots[--queue_ptr->free_count];
+    loc_eng_evt_copy (&(queue_ptr->slots[slot]), (loc_eng_evt_e_type) type, loc_event_payload);
+
+    queue_ptr->order[(queue_ptr->head + queue_ptr->count) % LOC_ENG_EVT_QUEUE_SIZE] = slot;
+    queue_ptr->count++;
+
+    if (queue_ptr->count > queue_ptr->max_count)
+    {
+        queue_ptr->max_count = queue_ptr->count;
+    }
+
+    return TRUE;
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_evt_queue_get
+
+DESCRIPTION
+   Takes the oldest event off the queue. The event is copied out, so its
+   slot can be reused as soon as the mutex is released.
+
+RETURN VALUE
+   TRUE                 if an event was copied to evt_ptr
+   FALSE                if the queue is empty
+
+===========================================================================*/
+boolean loc_eng_evt_queue_get (loc_eng_evt_queue_s_type *queue_ptr,
+        loc_eng_evt_s_type *evt_ptr)
+{
+    loc_eng_evt_s_type *slot_ptr;
+
+    if (queue_ptr->count == 0)
+    {
+        return FALSE;
+    }
+
+    slot_ptr = &(queue_ptr->slots[queue_ptr->order[queue_ptr->head]]);
+    loc_eng_evt_copy (evt_ptr, slot_ptr->type, &(slot_ptr->payload));
+
+    queue_ptr->free_slots[queue_ptr->free_count++] = queue_ptr->order[queue_ptr->head];
+    queue_ptr->head = (queue_ptr->head + 1) % LOC_ENG_EVT_QUEUE_SIZE;
+    queue_ptr->count--;
+
+    return TRUE;
+}
+
+/*===========================================================================
+FUNCTION    loc_eng_evt_queue_log_stats
+
+DESCRIPTION
+   Logs how many events of each type were received, coalesced and dropped.
+
+RETURN VALUE
+   N/A
+
+===========================================================================*/
+void loc_eng_evt_queue_log_stats (const loc_eng_evt_queue_s_type *queue_ptr)
+{
+    int type;
+
+    for (type = 0; type < LOC_ENG_EVT_MAX; type++)
+    {
+        if (queue_ptr->received[type] != 0)
+        {
+            LOGD ("loc_eng_evt_queue: %s events received %u, coalesced %u, dropped %u\n",
+                    loc_eng_evt_info[type].name,
+                    queue_ptr->received[type],
+                    queue_ptr->coalesced[type],
+                    queue_ptr->dropped[type]);
+        }
+    }
+    LOGD ("loc_eng_evt_queue: at most %u of %d events pending\n",
+            queue_ptr->max_count, LOC_ENG_EVT_QUEUE_SIZE);
+}
@@ -0,0 +1,95 @@
+/******************************************************************************
+  @file:  loc_eng_evt_queue.h
+  @brief:  queue of location events for the deferred action thread
+
+  DESCRIPTION
+     Location events are received on the RPC callback thread(s) and are
+     processed on the deferred action thread. This module holds the events
+     in between. Each event is deep copied into a fixed slot, so the RPC
+     payload can be released as soon as the callback returns.
+
+     The queue has no lock of its own, every function must be called with
+     loc_eng_data.deferred_action_mutex held.
+
+  INITIALIZATION AND SEQUENCING REQUIREMENTS
+
+******************************************************************************/
+
+#ifndef LOC_ENG_EVT_QUEUE_H
+#define LOC_ENG_EVT_QUEUE_H
+
+// Number of events that can be pending for the deferred action thread
+#define LOC_ENG_EVT_QUEUE_SIZE      16
+
+// Room for the strings of one NI request
+#define LOC_ENG_EVT_NI_STRINGS_SIZE 1024
+
+// Location event types, one per event mask bit that is handed over
+typedef enum
+{
+    LOC_ENG_EVT_POSITION = 0,
+    LOC_ENG_EVT_SATELLITE,
+    LOC_ENG_EVT_NMEA,
+    LOC_ENG_EVT_STATUS,
+    LOC_ENG_EVT_NI,
+    LOC_ENG_EVT_ASSISTANCE,
+    LOC_ENG_EVT_SERVER,
+    LOC_ENG_EVT_MAX
+} loc_eng_evt_e_type;
+
+// Storage for the data a payload points to
+typedef union
+{
+    rpc_loc_sv_info_s_type         sv_list[GPS_MAX_SVS];
+    char                           nmea[RPC_LOC_API_MAX_NMEA_STRING_LENGTH + 1];
+    char                           ni_strings[LOC_ENG_EVT_NI_STRINGS_SIZE];
+} loc_eng_evt_data_u_type;
+
+typedef struct
+{
+    loc_eng_evt_e_type             type;
+    // Single event mask bit, as expected by loc_eng_process_loc_event
+    rpc_loc_event_mask_type        loc_event;
+    // Pointers in the payload point into data below
+    rpc_loc_event_payload_u_type   payload;
+    loc_eng_evt_data_u_type        data;
+} loc_eng_evt_s_type;
+
+typedef struct
+{
+    loc_eng_evt_s_type             slots[LOC_ENG_EVT_QUEUE_SIZE];
+    // Pending slots in arrival order, a ring starting at head
+    uint8                          order[LOC_ENG_EVT_QUEUE_SIZE];
+    uint8                          head;
+    uint8                          count;
+    // Slots not in use
+    uint8                          free_slots[LOC_ENG_EVT_QUEUE_SIZE];
+    uint8                          free_count;
+
+    // Statistics, per event type
+    uint32                         received[LOC_ENG_EVT_MAX];
+    // Replaced by a newer event of the same type before delivery
+    uint32                         coalesced[LOC_ENG_EVT_MAX];
+    // Lost because the queue was full
+    uint32                         dropped[LOC_ENG_EVT_MAX];
+    uint32                         max_count;
+} loc_eng_evt_queue_s_type;
+
+extern void loc_eng_evt_queue_init (loc_eng_evt_queue_s_type *queue_ptr);
+
+extern boolean loc_eng_evt_queue_put
+(
+    loc_eng_evt_queue_s_type            *queue_ptr,
+    rpc_loc_event_mask_type              loc_event,
+    const rpc_loc_event_payload_u_type  *loc_event_payload
+);
+
+extern boolean loc_eng_evt_queue_get
+(
+    loc_eng_evt_queue_s_type            *queue_ptr,
+    loc_eng_evt_s_type                  *evt_ptr
+);
+
+extern void loc_eng_evt_queue_log_stats (const loc_eng_evt_queue_s_type *queue_ptr);
+
+#endif // LOC_ENG_EVT_QUEUE_H
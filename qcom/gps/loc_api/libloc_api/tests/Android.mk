@@ -0,0 +1,33 @@
+LOCAL_PATH := $(call my-dir)
+
+# Floods the loc_event_cb path of libloc_api over a fake loc API
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    loc_eng_flood.cpp \
+    fake_loc_api.cpp \
+    ../loc_eng.cpp \
+    ../loc_eng_ioctl.cpp \
+    ../loc_eng_xtra.cpp \
+    ../loc_eng_ni.cpp \
+    ../loc_eng_evt_queue.cpp
+
+LOCAL_CFLAGS += \
+    -fno-short-enums \
+    -include $(LOCAL_PATH)/host_compat.h
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/.. \
+    $(LOCAL_PATH)/../../libloc_api-rpc \
+    $(LOCAL_PATH)/../../libloc_api-rpc/rpc_inc \
+    hardware/msm7k/librpc
+
+LOCAL_STATIC_LIBRARIES := liblog
+
+LOCAL_LDLIBS += -lpthread
+
+LOCAL_MODULE := loc_eng_flood
+
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_HOST_EXECUTABLE)
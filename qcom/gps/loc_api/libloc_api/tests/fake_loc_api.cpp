@@ -0,0 +1,182 @@
+/******************************************************************************
+  @file:  fake_loc_api.cpp
+  @brief:  host stand-in for the loc API RPC glue
+
+  DESCRIPTION
+     See fake_loc_api.h. Also stubs out the few system calls libloc_api
+     makes that the host does not have, and implements host_compat.h.
+
+******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#include <cutils/properties.h>
+#include <cutils/sched_policy.h>
+#include <utils/SystemClock.h>
+
+#include <loc_apicb_appinit.h>
+
+#include "fake_loc_api.h"
+
+#define FAKE_LOC_API_MAX_IOCTL_TYPES 32
+
+static pthread_mutex_t fake_lock = PTHREAD_MUTEX_INITIALIZER;
+static loc_event_cb_f_type *fake_event_cb;
+
+static struct
+{
+    rpc_loc_ioctl_e_type type;
+    int                  count;
+} fake_ioctls[FAKE_LOC_API_MAX_IOCTL_TYPES];
+
+loc_event_cb_f_type *fake_loc_api_event_cb (void)
+{
+    loc_event_cb_f_type *event_cb;
+
+    pthread_mutex_lock (&fake_lock);
+    event_cb = fake_event_cb;
+    pthread_mutex_unlock (&fake_lock);
+
+    return event_cb;
+}
+
+int fake_loc_api_ioctl_count (rpc_loc_ioctl_e_type ioctl_type)
+{
+    int i, count = 0;
+
+    pthread_mutex_lock (&fake_lock);
+    for (i = 0; i < FAKE_LOC_API_MAX_IOCTL_TYPES; i++)
+    {
+        if (fake_ioctls[i].count != 0 && fake_ioctls[i].type == ioctl_type)
+        {
+            count = fake_ioctls[i].count;
+            break;
+        }
+    }
+    pthread_mutex_unlock (&fake_lock);
+
+    return count;
+}
+
+int loc_api_glue_init (void)
+{
+    return 1;
+}
+
+void loc_apicb_app_deinit (void)
+{
+}
+
+rpc_loc_client_handle_type loc_open (rpc_loc_event_mask_type event_reg_mask,
+        loc_event_cb_f_type *event_callback)
+{
+    pthread_mutex_lock (&fake_lock);
+    fake_event_cb = event_callback;
+    pthread_mutex_unlock (&fake_lock);
+
+    return FAKE_LOC_API_HANDLE;
+}
+
+int32 loc_close (rpc_loc_client_handle_type handle)
+{
+    pthread_mutex_lock (&fake_lock);
+    fake_event_cb = NULL;
+    pthread_mutex_unlock (&fake_lock);
+
+    return RPC_LOC_API_SUCCESS;
+}
+
+int32 loc_start_fix (rpc_loc_client_handle_type handle)
+{
+    return RPC_LOC_API_SUCCESS;
+}
+
+int32 loc_stop_fix (rpc_loc_client_handle_type handle)
+{
+    return RPC_LOC_API_SUCCESS;
+}
+
+int32 loc_ioctl (rpc_loc_client_handle_type handle,
+        rpc_loc_ioctl_e_type ioctl_type,
+        rpc_loc_ioctl_data_u_type *ioctl_data)
+{
+    rpc_loc_event_payload_u_type payload;
+    loc_event_cb_f_type *event_cb;
+    int i;
+
+    pthread_mutex_lock (&fake_lock);
+    for (i = 0; i < FAKE_LOC_API_MAX_IOCTL_TYPES; i++)
+    {
+        if (fake_ioctls[i].count == 0 || fake_ioctls[i].type == ioctl_type)
+        {
+            fake_ioctls[i].type = ioctl_type;
+            fake_ioctls[i].count++;
+            break;
+        }
+    }
+    event_cb = fake_event_cb;
+    pthread_mutex_unlock (&fake_lock);
+
+    // The modem answers before the RPC returns, loc_eng_ioctl has to cope
+    memset (&payload, 0, sizeof (payload));
+    payload.disc = RPC_LOC_EVENT_IOCTL_REPORT;
+    payload.rpc_loc_event_payload_u_type_u.ioctl_report.type = ioctl_type;
+    payload.rpc_loc_event_payload_u_type_u.ioctl_report.status = RPC_LOC_API_SUCCESS;
+
+    if (event_cb != NULL)
+    {
+        event_cb (handle, RPC_LOC_EVENT_IOCTL_REPORT, &payload);
+    }
+
+    return RPC_LOC_API_SUCCESS;
+}
+
+int property_get (const char *key, char *value, const char *default_value)
+{
+    int len = 0;
+
+    if (default_value != NULL)
+    {
+        len = strlen (default_value);
+        memcpy (value, default_value, len + 1);
+    }
+
+    return len;
+}
+
+int set_sched_policy (int tid, SchedPolicy policy)
+{
+    return 0;
+}
+
+pid_t loc_host_gettid (void)
+{
+    return syscall (SYS_gettid);
+}
+
+size_t loc_host_strlcpy (char *dst, const char *src, size_t size)
+{
+    size_t len = strlen (src);
+
+    if (size != 0)
+    {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy (dst, src, n);
+        dst[n] = '\0';
+    }
+
+    return len;
+}
+
+namespace android {
+
+int64_t elapsedRealtime ()
+{
+    return 0;
+}
+
+}; // namespace android
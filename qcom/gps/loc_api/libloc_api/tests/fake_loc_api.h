@@ -0,0 +1,26 @@
+/******************************************************************************
+  @file:  fake_loc_api.h
+  @brief:  host stand-in for the loc API RPC glue
+
+  DESCRIPTION
+     Implements the loc_* calls libloc_api makes to the modem, so the
+     library can run on the host. loc_open keeps the event callback for the
+     test to call, loc_ioctl answers every ioctl with a successful
+     RPC_LOC_EVENT_IOCTL_REPORT before it returns.
+
+******************************************************************************/
+
+#ifndef FAKE_LOC_API_H
+#define FAKE_LOC_API_H
+
+#include <loc_api_rpc_glue.h>
+
+#define FAKE_LOC_API_HANDLE 1
+
+// Callback passed to loc_open, NULL before that
+extern loc_event_cb_f_type *fake_loc_api_event_cb (void);
+
+// Number of loc_ioctl calls of a type
+extern int fake_loc_api_ioctl_count (rpc_loc_ioctl_e_type ioctl_type);
+
+#endif // FAKE_LOC_API_H
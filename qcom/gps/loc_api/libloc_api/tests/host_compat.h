@@ -0,0 +1,33 @@
+/******************************************************************************
+  @file:  host_compat.h
+  @brief:  bionic calls libloc_api uses that glibc lacks
+
+  DESCRIPTION
+     Forced into every file of the host test build, implemented in
+     fake_loc_api.cpp.
+
+******************************************************************************/
+
+#ifndef HOST_COMPAT_H
+#define HOST_COMPAT_H
+
+// Declared first, so a C library that has them is not redefined
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+extern pid_t loc_host_gettid (void);
+extern size_t loc_host_strlcpy (char *dst, const char *src, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define gettid   loc_host_gettid
+#define strlcpy  loc_host_strlcpy
+
+#endif // HOST_COMPAT_H
@@ -0,0 +1,607 @@
+/******************************************************************************
+  @file:  loc_eng_flood.cpp
+  @brief:  floods the libloc_api event path
+
+  DESCRIPTION
+     Runs libloc_api against fake_loc_api.cpp and calls the loc_open
+     callback the way the RPC callback threads do: two threads, every report
+     type, at a 10 Hz fix rate and then in a burst against a stalled
+     deferred action thread.
+
+     The senders scribble over their payload as soon as the callback
+     returns, so everything delivered has to be a copy. Checks:
+     - every position and status report is delivered, in order,
+     - every satellite and NMEA report is delivered intact, or counted as
+       coalesced or dropped,
+     - nothing is dropped at 10 Hz,
+     - the callback does not wait for the deferred action thread.
+
+       loc_eng_flood [seconds at 10 Hz]
+
+******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#include <hardware_legacy/gps.h>
+#include <hardware_legacy/gps_ni.h>
+
+#include <rpc/rpc.h>
+#include <loc_api_rpc_glue.h>
+#include <loc_eng.h>
+
+#include "fake_loc_api.h"
+
+#define NMEA_PER_FIX        6
+#define BURST_FIXES         10
+#define MAX_CB_LATENCY_US   20000
+
+static const char requestor_id[] = "flood-requestor";
+static const char client_name[]  = "flood-client";
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  cond = PTHREAD_COND_INITIALIZER;
+
+// What the senders sent and the callbacks got, under lock
+static struct
+{
+    int positions;
+    int satellites;
+    int nmea;
+    int status;
+    int ni;
+    int assistance;
+    int server;
+} sent, delivered;
+
+static int last_position = -1;
+static int errors;
+static long long max_cb_latency_us;
+
+// Set to stall the deferred action thread in the next location callback
+static int stall;
+static int stalled;
+
+static long long now_us (void)
+{
+    struct timeval tv;
+    gettimeofday (&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+static void error (const char *what, int seq)
+{
+    fprintf (stderr, "error: %s (%d)\n", what, seq);
+    pthread_mutex_lock (&lock);
+    errors++;
+    pthread_mutex_unlock (&lock);
+}
+
+/*
+ * Callbacks from the deferred action thread
+ */
+
+static void location_cb (GpsLocation *location)
+{
+    int seq = (int) location->latitude;
+
+    pthread_mutex_lock (&lock);
+    if (seq != last_position + 1 || location->timestamp != (GpsUtcTime) seq)
+    {
+        pthread_mutex_unlock (&lock);
+        error ("position out of order", seq);
+        pthread_mutex_lock (&lock);
+    }
+    last_position = seq;
+    delivered.positions++;
+
+    if (stall)
+    {
+        stalled = 1;
+        pthread_cond_broadcast (&cond);
+        while (stall)
+        {
+            pthread_cond_wait (&cond, &lock);
+        }
+    }
+    pthread_mutex_unlock (&lock);
+}
+
+static void status_cb (GpsStatus *status)
+{
+    pthread_mutex_lock (&lock);
+    delivered.status++;
+    pthread_mutex_unlock (&lock);
+}
+
+static void sv_status_cb (GpsSvStatus *sv_status)
+{
+    int seq = (int) sv_status->sv_list[0].snr;
+    int i;
+
+    if (sv_status->num_svs != 4 + seq % 8)
+    {
+        error ("satellite count", seq);
+    }
+    for (i = 0; i < sv_status->num_svs; i++)
+    {
+        if (sv_status->sv_list[i].prn != i + 1 || sv_status->sv_list[i].snr != (float) seq)
+        {
+            error ("satellite list", seq);
+            break;
+        }
+    }
+
+    pthread_mutex_lock (&lock);
+    delivered.satellites++;
+    pthread_mutex_unlock (&lock);
+}
+
+static int make_nmea (char *buf, int seq)
+{
+    int len = sprintf (buf, "$GPGGA,%d,", seq);
+
+    // Up to the longest report the modem sends
+    while (len < 20 + (seq * 97) % (RPC_LOC_API_MAX_NMEA_STRING_LENGTH - 20))
+    {
+        buf[len] = 'A' + len % 26;
+        len++;
+    }
+    buf[len] = '\0';
+
+    return len;
+}
+
+static void nmea_cb (GpsUtcTime timestamp, const char *nmea, int length)
+{
+    char expected[RPC_LOC_API_MAX_NMEA_STRING_LENGTH + 1];
+    int seq = -1;
+
+    if (sscanf (nmea, "$GPGGA,%d,", &seq) != 1 ||
+        length != make_nmea (expected, seq) ||
+        memcmp (nmea, expected, length) != 0)
+    {
+        error ("nmea sentence", seq);
+    }
+
+    pthread_mutex_lock (&lock);
+    delivered.nmea++;
+    pthread_mutex_unlock (&lock);
+}
+
+static void download_request_cb (void)
+{
+    pthread_mutex_lock (&lock);
+    delivered.assistance++;
+    pthread_mutex_unlock (&lock);
+}
+
+static void agps_status_cb (AGpsStatus *status)
+{
+    pthread_mutex_lock (&lock);
+    delivered.server++;
+    pthread_mutex_unlock (&lock);
+}
+
+static const GpsNiInterface *ni_interface;
+
+static void ni_notify_cb (GpsNiNotification *notification)
+{
+    char expected[GPS_NI_SHORT_STRING_MAXLEN];
+    int i;
+
+    for (i = 0; requestor_id[i] != '\0'; i++)
+    {
+        sprintf (&expected[i * 2], "%02X", requestor_id[i]);
+    }
+    if (strcmp (notification->requestor_id, expected) != 0)
+    {
+        error ("ni requestor id", 0);
+    }
+
+    pthread_mutex_lock (&lock);
+    delivered.ni++;
+    pthread_mutex_unlock (&lock);
+
+    ni_interface->respond (notification->notification_id, GPS_NI_RESPONSE_ACCEPT);
+}
+
+static GpsCallbacks callbacks = { location_cb, status_cb, sv_status_cb, nmea_cb };
+static GpsXtraCallbacks xtra_callbacks = { download_request_cb };
+static AGpsCallbacks agps_callbacks = { agps_status_cb };
+static GpsNiCallbacks ni_callbacks = { ni_notify_cb };
+
+/*
+ * Senders, standing in for the RPC callback threads
+ */
+
+static void send (rpc_loc_event_mask_type loc_event, rpc_loc_event_payload_u_type *payload)
+{
+    long long start = now_us ();
+
+    payload->disc = loc_event;
+    fake_loc_api_event_cb () (FAKE_LOC_API_HANDLE, loc_event, payload);
+
+    start = now_us () - start;
+    pthread_mutex_lock (&lock);
+    if (start > max_cb_latency_us)
+    {
+        max_cb_latency_us = start;
+    }
+    pthread_mutex_unlock (&lock);
+
+    // The RPC layer frees the payload once the callback returns
+    memset (payload, 0x5a, sizeof (*payload));
+}
+
+static void send_position (int seq)
+{
+    rpc_loc_event_payload_u_type payload;
+    rpc_loc_parsed_position_s_type *pos = &payload.rpc_loc_event_payload_u_type_u.parsed_location_report;
+
+    memset (&payload, 0, sizeof (payload));
+    pos->valid_mask = RPC_LOC_POS_VALID_SESSION_STATUS | RPC_LOC_POS_VALID_TIMESTAMP_UTC |
+                      RPC_LOC_POS_VALID_LATITUDE | RPC_LOC_POS_VALID_LONGITUDE;
+    pos->session_status = RPC_LOC_SESS_STATUS_SUCCESS;
+    pos->timestamp_utc = seq;
+    pos->latitude = seq;
+    pos->longitude = -seq;
+    send (RPC_LOC_EVENT_PARSED_POSITION_REPORT, &payload);
+}
+
+static void send_satellites (int seq)
+{
+    rpc_loc_event_payload_u_type payload;
+    rpc_loc_gnss_info_s_type *gnss = &payload.rpc_loc_event_payload_u_type_u.gnss_report;
+    rpc_loc_sv_info_s_type sv_list[RPC_LOC_API_MAX_SV_COUNT];
+    int i, count = 4 + seq % 8;
+
+    memset (&payload, 0, sizeof (payload));
+    memset (sv_list, 0, sizeof (sv_list));
+    for (i = 0; i < count; i++)
+    {
+        sv_list[i].valid_mask = RPC_LOC_SV_INFO_VALID_SYSTEM | RPC_LOC_SV_INFO_VALID_SNR;
+        sv_list[i].system = RPC_LOC_SV_SYSTEM_GPS;
+        sv_list[i].prn = i + 1;
+        sv_list[i].snr = seq;
+    }
+    gnss->valid_mask = RPC_LOC_GNSS_INFO_VALID_SV_COUNT | RPC_LOC_GNSS_INFO_VALID_SV_LIST;
+    gnss->sv_count = count;
+    gnss->sv_list.sv_list_len = count;
+    gnss->sv_list.sv_list_val = sv_list;
+    send (RPC_LOC_EVENT_SATELLITE_REPORT, &payload);
+    memset (sv_list, 0x5a, sizeof (sv_list));
+}
+
+static void send_nmea (int seq)
+{
+    rpc_loc_event_payload_u_type payload;
+    rpc_loc_nmea_report_s_type *nmea = &payload.rpc_loc_event_payload_u_type_u.nmea_report;
+    char sentences[RPC_LOC_API_MAX_NMEA_STRING_LENGTH + 1];
+
+    memset (&payload, 0, sizeof (payload));
+    nmea->length = make_nmea (sentences, seq);
+    nmea->nmea_sentences.nmea_sentences_len = nmea->length;
+    nmea->nmea_sentences.nmea_sentences_val = sentences;
+    send (RPC_LOC_EVENT_NMEA_POSITION_REPORT, &payload);
+    memset (sentences, 0x5a, sizeof (sentences));
+}
+
+static void send_status (rpc_loc_engine_state_e_type engine_state)
+{
+    rpc_loc_event_payload_u_type payload;
+    rpc_loc_status_event_s_type *status = &payload.rpc_loc_event_payload_u_type_u.status_report;
+
+    memset (&payload, 0, sizeof (payload));
+    status->event = RPC_LOC_STATUS_EVENT_ENGINE_STATE;
+    status->payload.disc = RPC_LOC_STATUS_EVENT_ENGINE_STATE;
+    status->payload.rpc_loc_status_event_payload_u_type_u.engine_state = engine_state;
+    send (RPC_LOC_EVENT_STATUS_REPORT, &payload);
+}
+
+static void send_ni (void)
+{
+    rpc_loc_event_payload_u_type payload;
+    rpc_loc_ni_event_s_type *ni = &payload.rpc_loc_event_payload_u_type_u.ni_request;
+    rpc_loc_ni_supl_notify_verify_req_s_type *supl;
+    char requestor[sizeof (requestor_id)];
+    char client[sizeof (client_name)];
+
+    memcpy (requestor, requestor_id, sizeof (requestor));
+    memcpy (client, client_name, sizeof (client));
+
+    memset (&payload, 0, sizeof (payload));
+    ni->event = RPC_LOC_NI_EVENT_SUPL_NOTIFY_VERIFY_REQ;
+    ni->payload.disc = RPC_LOC_NI_EVENT_SUPL_NOTIFY_VERIFY_REQ;
+    supl = &ni->payload.rpc_loc_ni_event_payload_u_type_u.supl_req;
+    supl->notification_priv_type = RPC_LOC_NI_USER_NOTIFY_ONLY;
+    supl->flags = RPC_LOC_NI_CLIENT_NAME_PRESENT | RPC_LOC_NI_REQUESTOR_ID_PRESENT;
+    supl->requestor_id.requestor_id_string.requestor_id_string_len = strlen (requestor);
+    supl->requestor_id.requestor_id_string.requestor_id_string_val = requestor;
+    supl->requestor_id.string_len = strlen (requestor);
+    supl->client_name.client_name_string.client_name_string_len = strlen (client);
+    supl->client_name.client_name_string.client_name_string_val = client;
+    supl->client_name.string_len = strlen (client);
+    send (RPC_LOC_EVENT_NI_NOTIFY_VERIFY_REQUEST, &payload);
+    memset (requestor, 0x5a, sizeof (requestor));
+    memset (client, 0x5a, sizeof (client));
+}
+
+static void send_assistance (void)
+{
+    rpc_loc_event_payload_u_type payload;
+
+    memset (&payload, 0, sizeof (payload));
+    payload.rpc_loc_event_payload_u_type_u.assist_data_request.event = RPC_LOC_ASSIST_DATA_PREDICTED_ORBITS_REQ;
+    send (RPC_LOC_EVENT_ASSISTANCE_DATA_REQUEST, &payload);
+}
+
+static void send_server (rpc_loc_server_request_e_type event)
+{
+    rpc_loc_event_payload_u_type payload;
+    rpc_loc_server_request_s_type *server = &payload.rpc_loc_event_payload_u_type_u.loc_server_request;
+
+    memset (&payload, 0, sizeof (payload));
+    server->event = event;
+    server->payload.disc = event;
+    server->payload.rpc_loc_server_request_u_type_u.open_req.conn_handle = 7;
+    send (RPC_LOC_EVENT_LOCATION_SERVER_REQUEST, &payload);
+}
+
+typedef struct
+{
+    int first_fix;
+    int fixes;
+    int period_us;
+} sender_args;
+
+// Positions and satellites, as the fix engine reports them
+static void *fix_sender (void *arg)
+{
+    sender_args *args = (sender_args *) arg;
+    int i;
+
+    for (i = args->first_fix; i < args->first_fix + args->fixes; i++)
+    {
+        send_position (i);
+        send_satellites (i);
+        pthread_mutex_lock (&lock);
+        sent.positions++;
+        sent.satellites++;
+        pthread_mutex_unlock (&lock);
+        if (args->period_us != 0)
+        {
+            usleep (args->period_us);
+        }
+    }
+
+    return NULL;
+}
+
+// NMEA and the occasional request, from a second callback thread
+static void *nmea_sender (void *arg)
+{
+    sender_args *args = (sender_args *) arg;
+    int i, j;
+
+    for (i = args->first_fix; i < args->first_fix + args->fixes; i++)
+    {
+        for (j = 0; j < NMEA_PER_FIX; j++)
+        {
+            send_nmea (i * NMEA_PER_FIX + j);
+        }
+        pthread_mutex_lock (&lock);
+        sent.nmea += NMEA_PER_FIX;
+        pthread_mutex_unlock (&lock);
+
+        if (i % 5 == 0)
+        {
+            send_assistance ();
+            pthread_mutex_lock (&lock);
+            sent.assistance++;
+            pthread_mutex_unlock (&lock);
+        }
+        if (args->period_us != 0)
+        {
+            usleep (args->period_us);
+        }
+    }
+
+    return NULL;
+}
+
+static void run_senders (int first_fix, int fixes, int period_us)
+{
+    sender_args args = { first_fix, fixes, period_us };
+    pthread_t fix_thread, nmea_thread;
+
+    pthread_create (&fix_thread, NULL, fix_sender, &args);
+    pthread_create (&nmea_thread, NULL, nmea_sender, &args);
+    pthread_join (fix_thread, NULL);
+    pthread_join (nmea_thread, NULL);
+}
+
+static int queue_idle (void)
+{
+    int idle;
+
+    pthread_mutex_lock (&loc_eng_data.deferred_action_mutex);
+    idle = (loc_eng_data.evt_queue.count == 0);
+    pthread_mutex_unlock (&loc_eng_data.deferred_action_mutex);
+
+    return idle;
+}
+
+// Waits for the deferred action thread to catch up with the queue
+static void drain (void)
+{
+    int i;
+
+    for (i = 0; i < 500 && !queue_idle (); i++)
+    {
+        usleep (10000);
+    }
+    // and for the last event taken off it
+    usleep (50000);
+}
+
+static int check_counts (const char *phase, int expect_no_loss)
+{
+    loc_eng_evt_queue_s_type stats;
+    int failed = 0;
+
+    pthread_mutex_lock (&loc_eng_data.deferred_action_mutex);
+    memcpy (&stats, &loc_eng_data.evt_queue, sizeof (stats));
+    pthread_mutex_unlock (&loc_eng_data.deferred_action_mutex);
+
+    pthread_mutex_lock (&lock);
+
+    printf ("%s: positions %d/%d, satellites %d/%d (%u coalesced, %u dropped), "
+            "nmea %d/%d (%u dropped), status %d/%d, ni %d/%d, assistance %d/%d, "
+            "at most %u queued, callback at most %lld us\n",
+            phase,
+            delivered.positions, sent.positions,
+            delivered.satellites, sent.satellites,
+            stats.coalesced[LOC_ENG_EVT_SATELLITE], stats.dropped[LOC_ENG_EVT_SATELLITE],
+            delivered.nmea, sent.nmea, stats.dropped[LOC_ENG_EVT_NMEA],
+            delivered.status, sent.status,
+            delivered.ni, sent.ni,
+            delivered.assistance, sent.assistance,
+            stats.max_count, max_cb_latency_us);
+
+    if (delivered.positions != sent.positions || delivered.status != sent.status ||
+        delivered.ni != sent.ni)
+    {
+        fprintf (stderr, "%s: position, status or ni report lost\n", phase);
+        failed = 1;
+    }
+
+    if (delivered.satellites + (int) stats.coalesced[LOC_ENG_EVT_SATELLITE] +
+            (int) stats.dropped[LOC_ENG_EVT_SATELLITE] != sent.satellites ||
+        delivered.nmea + (int) stats.dropped[LOC_ENG_EVT_NMEA] != sent.nmea ||
+        delivered.assistance + (int) stats.coalesced[LOC_ENG_EVT_ASSISTANCE] +
+            (int) stats.dropped[LOC_ENG_EVT_ASSISTANCE] != sent.assistance)
+    {
+        fprintf (stderr, "%s: reports unaccounted for\n", phase);
+        failed = 1;
+    }
+
+    if (expect_no_loss &&
+        (stats.dropped[LOC_ENG_EVT_SATELLITE] != 0 || stats.dropped[LOC_ENG_EVT_NMEA] != 0))
+    {
+        fprintf (stderr, "%s: reports dropped\n", phase);
+        failed = 1;
+    }
+
+    if (max_cb_latency_us > MAX_CB_LATENCY_US)
+    {
+        fprintf (stderr, "%s: callback blocked for %lld us\n", phase, max_cb_latency_us);
+        failed = 1;
+    }
+
+    pthread_mutex_unlock (&lock);
+
+    return failed;
+}
+
+int main (int argc, char **argv)
+{
+    int seconds = argc > 1 ? atoi (argv[1]) : 3;
+    const GpsInterface *gps;
+    int failed = 0;
+    int fixes;
+
+    gps = gps_get_hardware_interface ();
+    if (gps == NULL || gps->init (&callbacks) != 0)
+    {
+        fprintf (stderr, "gps init failed\n");
+        return 1;
+    }
+    ((const GpsXtraInterface *) gps->get_extension (GPS_XTRA_INTERFACE))->init (&xtra_callbacks);
+    ((const AGpsInterface *) gps->get_extension (AGPS_INTERFACE))->init (&agps_callbacks);
+    ni_interface = (const GpsNiInterface *) gps->get_extension (GPS_NI_INTERFACE);
+    ni_interface->init (&ni_callbacks);
+
+    // The deferred action thread sets the engine lock through loc_eng_ioctl
+    drain ();
+    if (fake_loc_api_ioctl_count (RPC_LOC_IOCTL_SET_ENGINE_LOCK) != 1)
+    {
+        fprintf (stderr, "engine lock ioctl not sent\n");
+        failed = 1;
+    }
+
+    // 10 Hz, every type of report, nothing may be lost
+    send_status (RPC_LOC_ENGINE_STATE_ON);
+    send_server (RPC_LOC_SERVER_REQUEST_OPEN);
+    send_ni ();
+    pthread_mutex_lock (&lock);
+    sent.status++;
+    sent.server++;
+    sent.ni++;
+    pthread_mutex_unlock (&lock);
+
+    fixes = seconds * 10;
+    run_senders (0, fixes, 100000);
+    drain ();
+    failed |= check_counts ("10 Hz", 1);
+
+    // Deleting aiding data waits for the engine to go off, and is done once
+    gps->delete_aiding_data (GPS_DELETE_ALL);
+    send_status (RPC_LOC_ENGINE_STATE_OFF);
+    pthread_mutex_lock (&lock);
+    sent.status++;
+    pthread_mutex_unlock (&lock);
+    drain ();
+    if (fake_loc_api_ioctl_count (RPC_LOC_IOCTL_DELETE_ASSIST_DATA) != 1)
+    {
+        fprintf (stderr, "aiding data deleted %d times\n",
+                fake_loc_api_ioctl_count (RPC_LOC_IOCTL_DELETE_ASSIST_DATA));
+        failed = 1;
+    }
+
+    // Back to back, with the deferred action thread stuck in a callback
+    pthread_mutex_lock (&lock);
+    stall = 1;
+    pthread_mutex_unlock (&lock);
+    send_position (fixes);
+    pthread_mutex_lock (&lock);
+    sent.positions++;
+    while (!stalled)
+    {
+        pthread_cond_wait (&cond, &lock);
+    }
+    pthread_mutex_unlock (&lock);
+
+    send_status (RPC_LOC_ENGINE_STATE_ON);
+    send_server (RPC_LOC_SERVER_REQUEST_CLOSE);
+    pthread_mutex_lock (&lock);
+    sent.status++;
+    sent.server++;
+    pthread_mutex_unlock (&lock);
+    run_senders (fixes + 1, BURST_FIXES, 0);
+
+    pthread_mutex_lock (&lock);
+    stall = 0;
+    pthread_cond_broadcast (&cond);
+    pthread_mutex_unlock (&lock);
+    drain ();
+    failed |= check_counts ("burst", 0);
+
+    pthread_mutex_lock (&lock);
+    if (delivered.server == 0 || errors != 0)
+    {
+        fprintf (stderr, "%d reports corrupted, %d server requests delivered\n",
+                errors, delivered.server);
+        failed = 1;
+    }
+    pthread_mutex_unlock (&lock);
+
+    gps->cleanup ();
+
+    printf ("%s\n", failed ? "FAILED" : "PASSED");
+    return failed;
+}
@@ -42,3 +42,5 @@ LOCAL_LDLIBS += -lpthread
 
 include $(BUILD_STATIC_LIBRARY)
 endif # ANDROID_BIONIC_TRANSITION
+
+include $(call all-makefiles-under,$(LOCAL_PATH))
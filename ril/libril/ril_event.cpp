@@ -25,6 +25,8 @@
 #include <ril_event.h>
 #include <string.h>
 #include <sys/time.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
 #include <time.h>
 
 #include <pthread.h>
@@ -65,11 +67,20 @@ static pthread_mutex_t listMutex;
     } while(0);
 #endif
 
-static fd_set readFds;
-static int nfds = 0;
+// epoll_wait() batch size, not a limit on the number of watches
+#define MAX_EPOLL_EVENTS 32
+
+static int epollFd = -1;
+
+// fires when the earliest timer expires; -1 if the kernel has no timerfd,
+// in which case epoll_wait() times out instead, with 1ms resolution
+static int timerFd = -1;
+
+// binary min-heap of timers ordered by timeout, ev->index is the position
+static struct ril_event ** timer_heap = NULL;
+static int timer_count = 0;
+static int timer_capacity = 0;
 
-static struct ril_event * watch_table[MAX_FD_EVENTS];
-static struct ril_event timer_list;
 static struct ril_event pending_list;
 
 #define DEBUG 0
@@ -133,26 +144,158 @@ static void removeFromList(struct ril_event * ev)
     ev->prev = NULL;
 }
 
+// timerfd isn't in every libc yet, go through the syscalls
+static int createTimerFd()
+{
+#ifdef __NR_timerfd_create
+    int fd = syscall(__NR_timerfd_create, CLOCK_MONOTONIC, 0);
+    if (fd >= 0) {
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    return fd;
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
 
-static void removeWatch(struct ril_event * ev, int index)
+static int setTimerFd(const struct timeval * tv)
 {
-    watch_table[index] = NULL;
-    ev->index = -1;
+#ifdef __NR_timerfd_settime
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    if (tv != NULL) {
+        its.it_value.tv_sec = tv->tv_sec;
+        its.it_value.tv_nsec = tv->tv_usec * 1000;
+        if (its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0) {
+            // a zero value would disarm it
+            its.it_value.tv_nsec = 1;
+        }
+    }
+    return syscall(__NR_timerfd_settime, timerFd, 0, &its, NULL);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
 
-    FD_CLR(ev->fd, &readFds);
+static int calcNextTimeout(struct timeval * tv)
+{
+    struct timeval now;
 
-    if (ev->fd+1 == nfds) {
-        int n = 0;
+    if (timer_count == 0) {
+        // no pending timers
+        return -1;
+    }
 
-        for (int i = 0; i < MAX_FD_EVENTS; i++) {
-            struct ril_event * rev = watch_table[i];
+    getNow(&now);
 
-            if ((rev != NULL) && (rev->fd > n)) {
-                n = rev->fd;
-            }
+    struct ril_event * tev = timer_heap[0];
+    dlog("~~~~ now = %ds + %dus ~~~~", (int)now.tv_sec, (int)now.tv_usec);
+    dlog("~~~~ next = %ds + %dus ~~~~",
+            (int)tev->timeout.tv_sec, (int)tev->timeout.tv_usec);
+    if (timercmp(&tev->timeout, &now, >)) {
+        timersub(&tev->timeout, &now, tv);
+    } else {
+        // timer already expired.
+        tv->tv_sec = tv->tv_usec = 0;
+    }
+    return 0;
+}
+
+// point the timerfd at the earliest timer, called with the mutex held
+static void armTimer()
+{
+    struct timeval tv;
+
+    if (timerFd < 0) {
+        return;
+    }
+    if (setTimerFd(calcNextTimeout(&tv) < 0 ? NULL : &tv) < 0) {
+        LOGE("ril_event: timerfd_settime error (%d)", errno);
+    }
+}
+
+static void heapSet(int i, struct ril_event * ev)
+{
+    timer_heap[i] = ev;
+    ev->index = i;
+}
+
+static void heapUp(int i)
+{
+    struct ril_event * ev = timer_heap[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!timercmp(&ev->timeout, &timer_heap[parent]->timeout, <)) {
+            break;
+        }
+        heapSet(i, timer_heap[parent]);
+        i = parent;
+    }
+    heapSet(i, ev);
+}
+
+static void heapDown(int i)
+{
+    struct ril_event * ev = timer_heap[i];
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= timer_count) {
+            break;
+        }
+        if (child + 1 < timer_count && timercmp(&timer_heap[child + 1]->timeout,
+                &timer_heap[child]->timeout, <)) {
+            child++;
+        }
+        if (!timercmp(&timer_heap[child]->timeout, &ev->timeout, <)) {
+            break;
+        }
+        heapSet(i, timer_heap[child]);
+        i = child;
+    }
+    heapSet(i, ev);
+}
+
+static bool heapInsert(struct ril_event * ev)
+{
+    if (timer_count == timer_capacity) {
+        int capacity = timer_capacity ? timer_capacity * 2 : 16;
+        struct ril_event ** heap = (struct ril_event **)
+                realloc(timer_heap, capacity * sizeof(struct ril_event *));
+        if (heap == NULL) {
+            return false;
         }
-        nfds = n + 1;
-        dlog("~~~~ nfds = %d ~~~~", nfds);
+        timer_heap = heap;
+        timer_capacity = capacity;
+    }
+    heapSet(timer_count++, ev);
+    heapUp(ev->index);
+    return true;
+}
+
+static void heapRemove(struct ril_event * ev)
+{
+    int i = ev->index;
+    struct ril_event * last = timer_heap[--timer_count];
+    ev->index = -1;
+    if (last != ev) {
+        heapSet(i, last);
+        if (i > 0 && timercmp(&last->timeout, &timer_heap[(i - 1) / 2]->timeout, <)) {
+            heapUp(i);
+        } else {
+            heapDown(i);
+        }
+    }
+}
+
+static void removeWatch(struct ril_event * ev)
+{
+    ev->index = -1;
+
+    if (epoll_ctl(epollFd, EPOLL_CTL_DEL, ev->fd, NULL) < 0) {
+        dlog("~~~~ EPOLL_CTL_DEL fd %d error (%d) ~~~~", ev->fd, errno);
     }
 }
 
@@ -161,38 +304,45 @@ static void processTimeouts()
     dlog("~~~~ +processTimeouts ~~~~");
     MUTEX_ACQUIRE();
     struct timeval now;
-    struct ril_event * tev = timer_list.next;
-    struct ril_event * next;
 
     getNow(&now);
-    // walk list, see if now >= ev->timeout for any events
+    // pop every timer with now >= ev->timeout, earliest first
 
     dlog("~~~~ Looking for timers <= %ds + %dus ~~~~", (int)now.tv_sec, (int)now.tv_usec);
-    while ((tev != &timer_list) && (timercmp(&now, &tev->timeout, >))) {
+    bool fired = false;
+    while (timer_count > 0 && !timercmp(&timer_heap[0]->timeout, &now, >)) {
         // Timer expired
         dlog("~~~~ firing timer ~~~~");
-        next = tev->next;
-        removeFromList(tev);
+        struct ril_event * tev = timer_heap[0];
+        heapRemove(tev);
         addToList(tev, &pending_list);
-        tev = next;
+        fired = true;
+    }
+    if (fired) {
+        armTimer();
     }
     MUTEX_RELEASE();
     dlog("~~~~ -processTimeouts ~~~~");
 }
 
-static void processReadReadies(fd_set * rfds, int n)
+static void processReadReadies(struct epoll_event * events, int n)
 {
     dlog("~~~~ +processReadReadies (%d) ~~~~", n);
     MUTEX_ACQUIRE();
 
-    for (int i = 0; (i < MAX_FD_EVENTS) && (n > 0); i++) {
-        struct ril_event * rev = watch_table[i];
-        if (rev != NULL && FD_ISSET(rev->fd, rfds)) {
-            addToList(rev, &pending_list);
-            if (rev->persist == false) {
-                removeWatch(rev, i);
-            }
-            n--;
+    for (int i = 0; i < n; i++) {
+        struct ril_event * rev = (struct ril_event *)events[i].data.ptr;
+        if (rev == NULL) {
+            // the timerfd, already drained
+            continue;
+        }
+        // may have been removed since epoll_wait() returned
+        if (rev->index < 0 || rev->next != NULL) {
+            continue;
+        }
+        addToList(rev, &pending_list);
+        if (rev->persist == false) {
+            removeWatch(rev);
         }
     }
 
@@ -213,40 +363,37 @@ static void firePending()
     dlog("~~~~ -firePending ~~~~");
 }
 
-static int calcNextTimeout(struct timeval * tv)
-{
-    struct ril_event * tev = timer_list.next;
-    struct timeval now;
-
-    getNow(&now);
-
-    // Sorted list, so calc based on first node
-    if (tev == &timer_list) {
-        // no pending timers
-        return -1;
-    }
-
-    dlog("~~~~ now = %ds + %dus ~~~~", (int)now.tv_sec, (int)now.tv_usec);
-    dlog("~~~~ next = %ds + %dus ~~~~",
-            (int)tev->timeout.tv_sec, (int)tev->timeout.tv_usec);
-    if (timercmp(&tev->timeout, &now, >)) {
-        timersub(&tev->timeout, &now, tv);
-    } else {
-        // timer already expired.
-        tv->tv_sec = tv->tv_usec = 0;
-    }
-    return 0;
-}
-
 // Initialize internal data structs
 void ril_event_init()
 {
     MUTEX_INIT();
 
-    FD_ZERO(&readFds);
-    init_list(&timer_list);
     init_list(&pending_list);
-    memset(watch_table, 0, sizeof(watch_table));
+    free(timer_heap);
+    timer_heap = NULL;
+    timer_count = timer_capacity = 0;
+
+    epollFd = epoll_create(MAX_EPOLL_EVENTS);
+    if (epollFd < 0) {
+        LOGE("ril_event: epoll_create error (%d)", errno);
+        return;
+    }
+    fcntl(epollFd, F_SETFD, FD_CLOEXEC);
+
+    timerFd = createTimerFd();
+    if (timerFd >= 0) {
+        struct epoll_event eev;
+        memset(&eev, 0, sizeof(eev));
+        eev.events = EPOLLIN;
+        eev.data.ptr = NULL;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &eev) < 0) {
+            close(timerFd);
+            timerFd = -1;
+        }
+    }
+    if (timerFd < 0) {
+        LOGW("ril_event: no timerfd (%d), timers have 1ms resolution", errno);
+    }
 }
 
 // Initialize an event
@@ -267,16 +414,17 @@ void ril_event_add(struct ril_event * ev)
 {
     dlog("~~~~ +ril_event_add ~~~~");
     MUTEX_ACQUIRE();
-    for (int i = 0; i < MAX_FD_EVENTS; i++) {
-        if (watch_table[i] == NULL) {
-            watch_table[i] = ev;
-            ev->index = i;
-            dlog("~~~~ added at %d ~~~~", i);
+    if (ev->index < 0) {
+        struct epoll_event eev;
+        memset(&eev, 0, sizeof(eev));
+        eev.events = EPOLLIN;
+        eev.data.ptr = ev;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, ev->fd, &eev) == 0) {
+            ev->index = 0;
+            dlog("~~~~ added fd %d ~~~~", ev->fd);
             dump_event(ev);
-            FD_SET(ev->fd, &readFds);
-            if (ev->fd >= nfds) nfds = ev->fd+1;
-            dlog("~~~~ nfds = %d ~~~~", nfds);
-            break;
+        } else {
+            LOGE("ril_event: can't watch fd %d (%d)", ev->fd, errno);
         }
     }
     MUTEX_RELEASE();
@@ -289,95 +437,96 @@ void ril_timer_add(struct ril_event * ev, struct timeval * tv)
     dlog("~~~~ +ril_timer_add ~~~~");
     MUTEX_ACQUIRE();
 
-    struct ril_event * list;
     if (tv != NULL) {
-        // add to timer list
-        list = timer_list.next;
+        // add to timer heap
+        if (ev->fd < 0 && ev->index >= 0) {
+            // rescheduled before it fired
+            heapRemove(ev);
+        }
         ev->fd = -1; // make sure fd is invalid
 
         struct timeval now;
         getNow(&now);
         timeradd(&now, tv, &ev->timeout);
 
-        // keep list sorted
-        while (timercmp(&list->timeout, &ev->timeout, < )
-                && (list != &timer_list)) {
-            list = list->next;
+        if (!heapInsert(ev)) {
+            LOGE("ril_event: out of memory for timer");
+        } else if (ev->index == 0) {
+            // new earliest timer
+            armTimer();
         }
-        // list now points to the first event older than ev
-        addToList(ev, list);
     }
 
     MUTEX_RELEASE();
     dlog("~~~~ -ril_timer_add ~~~~");
 }
 
-// Remove event from watch or timer list
+// Remove event from watch list or cancel a timer
 void ril_event_del(struct ril_event * ev)
 {
     dlog("~~~~ +ril_event_del ~~~~");
     MUTEX_ACQUIRE();
 
-    if (ev->index < 0 || ev->index >= MAX_FD_EVENTS) {
-        return;
+    if (ev->index >= 0) {
+        if (ev->fd < 0) {
+            bool first = (ev->index == 0);
+            heapRemove(ev);
+            if (first) {
+                armTimer();
+            }
+        } else {
+            removeWatch(ev);
+        }
     }
 
-    removeWatch(ev, ev->index);
-
     MUTEX_RELEASE();
     dlog("~~~~ -ril_event_del ~~~~");
 }
 
-#if DEBUG
-static void printReadies(fd_set * rfds)
-{
-    for (int i = 0; (i < MAX_FD_EVENTS); i++) {
-        struct ril_event * rev = watch_table[i];
-        if (rev != NULL && FD_ISSET(rev->fd, rfds)) {
-          dlog("DON: fd=%d is ready", rev->fd);
-        }
-    }
-}
-#else
-#define printReadies(rfds) do {} while(0)
-#endif
-
 void ril_event_loop()
 {
     int n;
-    fd_set rfds;
+    int timeout;
     struct timeval tv;
-    struct timeval * ptv;
-
+    struct epoll_event events[MAX_EPOLL_EVENTS];
 
     for (;;) {
 
-        // make local copy of read fd_set
-        memcpy(&rfds, &readFds, sizeof(fd_set));
-        if (-1 == calcNextTimeout(&tv)) {
-            // no pending timers; block indefinitely
-            dlog("~~~~ no timers; blocking indefinitely ~~~~");
-            ptv = NULL;
-        } else {
-            dlog("~~~~ blocking for %ds + %dus ~~~~", (int)tv.tv_sec, (int)tv.tv_usec);
-            ptv = &tv;
+        timeout = -1;
+        if (timerFd < 0) {
+            MUTEX_ACQUIRE();
+            if (-1 == calcNextTimeout(&tv)) {
+                // no pending timers; block indefinitely
+                dlog("~~~~ no timers; blocking indefinitely ~~~~");
+            } else {
+                dlog("~~~~ blocking for %ds + %dus ~~~~", (int)tv.tv_sec, (int)tv.tv_usec);
+                // round up so we don't spin just short of the deadline
+                timeout = tv.tv_sec * 1000 + (tv.tv_usec + 999) / 1000;
+            }
+            MUTEX_RELEASE();
         }
-        printReadies(&rfds);
-        n = select(nfds, &rfds, NULL, NULL, ptv);
-        printReadies(&rfds);
+        n = epoll_wait(epollFd, events, MAX_EPOLL_EVENTS, timeout);
         dlog("~~~~ %d events fired ~~~~", n);
         if (n < 0) {
             if (errno == EINTR) continue;
 
-            LOGE("ril_event: select error (%d)", errno);
+            LOGE("ril_event: epoll_wait error (%d)", errno);
             // bail?
             return;
         }
 
+        // Drain the timerfd before timers are re-armed
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.ptr == NULL) {
+                uint64_t expirations;
+                read(timerFd, &expirations, sizeof(expirations));
+                break;
+            }
+        }
         // Check for timeouts
         processTimeouts();
         // Check for read-ready
-        processReadReadies(&rfds, n);
+        processReadReadies(events, n);
         // Fire away
         firePending();
     }
@@ -15,9 +15,6 @@
 ** limitations under the License.
 */
 
-// Max number of fd's we watch at any one time.  Increase if necessary.
-#define MAX_FD_EVENTS 8
-
 typedef void (*ril_event_cb)(int fd, short events, void *userdata);
 
 struct ril_event {
@@ -25,6 +22,8 @@ struct ril_event {
     struct ril_event *prev;
 
     int fd;
+    // timers: position in the timer heap; fds: 0 while watched.
+    // -1 when the event isn't registered.
     int index;
     bool persist;
     struct timeval timeout;
@@ -44,7 +43,7 @@ void ril_event_add(struct ril_event * ev);
 // Add timer event
 void ril_timer_add(struct ril_event * ev, struct timeval * tv);
 
-// Remove event from watch list
+// Remove event from watch list or cancel a timer
 void ril_event_del(struct ril_event * ev);
 
 // Event loop
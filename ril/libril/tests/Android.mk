@@ -0,0 +1,24 @@
+# Copyright 2010 The Android Open Source Project
+
+LOCAL_PATH:= $(call my-dir)
+
+# ril_event loop benchmark
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+    ril_event_bench.cpp \
+    ../ril_event.cpp
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+
+LOCAL_STATIC_LIBRARIES := \
+    libutils \
+    libcutils
+
+LOCAL_MODULE:= ril_event_bench
+
+LOCAL_MODULE_TAGS:= tests
+
+LOCAL_LDLIBS += -lpthread -lrt
+
+include $(BUILD_HOST_EXECUTABLE)
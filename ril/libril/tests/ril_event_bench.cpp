@@ -0,0 +1,243 @@
+/* //device/libs/telephony/tests/ril_event_bench.cpp
+**
+** Copyright 2010, The Android Open Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * Host benchmark for the ril_event loop: arms and cancels thousands of
+ * timers, then pushes traffic through thousands of watched socketpairs,
+ * with ril_event_loop() running on its own thread as in rild.
+ *
+ *   ril_event_bench [watches] [timers] [rounds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include <ril_event.h>
+
+struct timer_info {
+    struct ril_event event;
+    long long deadline;     // ns, CLOCK_MONOTONIC
+    bool cancelled;
+};
+
+struct watch_info {
+    struct ril_event event;
+    int fds[2];
+};
+
+static volatile int s_timersFired;
+static volatile int s_cancelledFired;
+static volatile long long s_lateSum;
+static volatile long long s_lateMax;
+static volatile int s_reads;
+static volatile int s_oneShots;
+
+static long long nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void timerCallback(int fd, short flags, void *param)
+{
+    timer_info * t = (timer_info *)param;
+    long long late = nowNs() - t->deadline;
+    if (t->cancelled) {
+        __sync_fetch_and_add(&s_cancelledFired, 1);
+    }
+    // only the loop thread writes these
+    s_lateSum += late;
+    if (late > s_lateMax) s_lateMax = late;
+    __sync_fetch_and_add(&s_timersFired, 1);
+}
+
+static void readCallback(int fd, short flags, void *param)
+{
+    char buf[64];
+    int n;
+    do {
+        n = read(fd, buf, sizeof(buf));
+        if (n > 0) __sync_fetch_and_add(&s_reads, n);
+    } while (n > 0 || (n < 0 && errno == EINTR));
+}
+
+static void oneShotCallback(int fd, short flags, void *param)
+{
+    readCallback(fd, flags, param);
+    __sync_fetch_and_add(&s_oneShots, 1);
+}
+
+static void * loopThread(void * arg)
+{
+    ril_event_loop();
+    fprintf(stderr, "ril_event_loop() returned\n");
+    exit(1);
+    return NULL;
+}
+
+static int get(volatile int * counter)
+{
+    return __atomic_load_n(counter, __ATOMIC_SEQ_CST);
+}
+
+// waits for *counter to reach target, false after 10s
+static bool waitFor(volatile int * counter, int target)
+{
+    long long limit = nowNs() + 10000000000LL;
+    while (get(counter) < target) {
+        if (nowNs() > limit) return false;
+        usleep(1000);
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int watches = (argc > 1) ? atoi(argv[1]) : 2000;
+    int timers = (argc > 2) ? atoi(argv[2]) : 20000;
+    int rounds = (argc > 3) ? atoi(argv[3]) : 50;
+    int errors = 0;
+
+    // two fds per watch
+    struct rlimit rl;
+    getrlimit(RLIMIT_NOFILE, &rl);
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+    if ((rlim_t)(2 * watches + 32) > rl.rlim_cur) {
+        watches = (rl.rlim_cur - 32) / 2;
+        printf("fd limit: using %d watches\n", watches);
+    }
+
+    ril_event_init();
+    pthread_t tid;
+    pthread_create(&tid, NULL, loopThread, NULL);
+
+    // timers: random timeouts up to 200ms, plus every fourth one set
+    // well in the future and cancelled
+    timer_info * tinfo = new timer_info[timers];
+    srand(1);
+    long long t0 = nowNs();
+    for (int i = 0; i < timers; i++) {
+        struct timeval tv;
+        long us = 1000 + rand() % 200000;
+        if (i % 4 == 0) us += 2000000;
+        tv.tv_sec = us / 1000000;
+        tv.tv_usec = us % 1000000;
+        tinfo[i].cancelled = false;
+        tinfo[i].deadline = nowNs() + us * 1000LL;
+        ril_event_set(&tinfo[i].event, -1, false, timerCallback, &tinfo[i]);
+        ril_timer_add(&tinfo[i].event, &tv);
+    }
+    long long addNs = nowNs() - t0;
+    int cancelled = 0;
+    t0 = nowNs();
+    for (int i = 0; i < timers; i += 4) {
+        tinfo[i].cancelled = true;
+        ril_event_del(&tinfo[i].event);
+        cancelled++;
+    }
+    long long delNs = nowNs() - t0;
+    if (!waitFor(&s_timersFired, timers - cancelled)) {
+        fprintf(stderr, "only %d of %d timers fired\n",
+                get(&s_timersFired), timers - cancelled);
+        errors++;
+    }
+    usleep(250000);
+    if (get(&s_timersFired) != timers - cancelled || get(&s_cancelledFired)) {
+        fprintf(stderr, "%d timers fired, %d of them cancelled\n",
+                get(&s_timersFired), get(&s_cancelledFired));
+        errors++;
+    }
+    printf("timers   %6d: add %5.0f ns, cancel %5.0f ns, lateness avg %.0f us max %.0f us\n",
+            timers, (double)addNs / timers, (double)delNs / (cancelled ? cancelled : 1),
+            (double)s_lateSum / (get(&s_timersFired) ? get(&s_timersFired) : 1) / 1000.0,
+            (double)s_lateMax / 1000.0);
+
+    // persistent watches, one byte per socket per round
+    watch_info * winfo = new watch_info[watches];
+    for (int i = 0; i < watches; i++) {
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, winfo[i].fds) < 0) {
+            fprintf(stderr, "socketpair: %s\n", strerror(errno));
+            return 1;
+        }
+        ril_event_set(&winfo[i].event, winfo[i].fds[0], true, readCallback, NULL);
+    }
+    t0 = nowNs();
+    for (int i = 0; i < watches; i++) {
+        ril_event_add(&winfo[i].event);
+    }
+    long long watchAddNs = nowNs() - t0;
+
+    t0 = nowNs();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < watches; i++) {
+            write(winfo[i].fds[1], "x", 1);
+        }
+        if (!waitFor(&s_reads, (r + 1) * watches)) {
+            fprintf(stderr, "round %d: %d of %d bytes read\n",
+                    r, get(&s_reads), (r + 1) * watches);
+            errors++;
+            break;
+        }
+    }
+    long long trafficNs = nowNs() - t0;
+
+    t0 = nowNs();
+    for (int i = 0; i < watches; i++) {
+        ril_event_del(&winfo[i].event);
+    }
+    long long watchDelNs = nowNs() - t0;
+
+    // removed watches must stay quiet
+    int reads = get(&s_reads);
+    for (int i = 0; i < watches; i++) {
+        write(winfo[i].fds[1], "x", 1);
+    }
+    usleep(50000);
+    if (get(&s_reads) != reads) {
+        fprintf(stderr, "%d reads on removed watches\n", get(&s_reads) - reads);
+        errors++;
+    }
+    printf("watches  %6d: add %5.0f ns, del %5.0f ns, %d rounds at %.0f events/s\n",
+            watches, (double)watchAddNs / watches, (double)watchDelNs / watches,
+            rounds, (double)watches * rounds * 1e9 / trafficNs);
+
+    // a one-shot watch fires once and is dropped
+    ril_event_set(&winfo[0].event, winfo[0].fds[0], false, oneShotCallback, NULL);
+    ril_event_add(&winfo[0].event);
+    write(winfo[0].fds[1], "y", 1);
+    waitFor(&s_oneShots, 1);
+    write(winfo[0].fds[1], "z", 1);
+    usleep(50000);
+    if (get(&s_oneShots) != 1) {
+        fprintf(stderr, "one-shot watch fired %d times\n", get(&s_oneShots));
+        errors++;
+    }
+
+    printf("%s\n", errors ? "FAILED" : "passed");
+    // ril_event_loop() never returns
+    exit(errors ? 1 : 0);
+}
@@ -22,7 +22,7 @@ LOCAL_MODULE_TAGS:= debug
 include $(BUILD_EXECUTABLE)
 
 include $(CLEAR_VARS)
-LOCAL_SRC_FILES:= AudioHardware.cpp alsa_mixer.c alsa_pcm.c
+LOCAL_SRC_FILES:= AudioHardware.cpp PolyphaseResampler.cpp alsa_mixer.c alsa_pcm.c
 LOCAL_MODULE:= libaudio
 LOCAL_STATIC_LIBRARIES:= libaudiointerface
 LOCAL_SHARED_LIBRARIES:= libc libcutils libutils libmedia libhardware_legacy
@@ -47,3 +47,5 @@ ifeq ($(BOARD_HAVE_BLUETOOTH),true)
   LOCAL_CFLAGS += -DWITH_A2DP
 endif
 include $(BUILD_SHARED_LIBRARY)
+
+include $(call all-makefiles-under,$(LOCAL_PATH))
@@ -33,6 +33,7 @@
 #include <fcntl.h>
 
 #include "AudioHardware.h"
+#include "PolyphaseResampler.h"
 #include <media/AudioRecord.h>
 #include <hardware_legacy/power.h>
 
@@ -1642,164 +1643,18 @@ size_t AudioHardware::AudioStreamInALSA::getBufferSize(uint32_t sampleRate, int
 //------------------------------------------------------------------------------
 
 /*
- * 2.30 fixed point FIR filter coefficients for conversion 44100 -> 22050.
- * (Works equivalently for 22010 -> 11025 or any other halving, of course.)
- *
- * Transition band from about 18 kHz, passband ripple < 0.1 dB,
- * stopband ripple at about -55 dB, linear phase.
- *
- * Design and display in MATLAB or Octave using:
- *
- * filter = fir1(19, 0.5); filter = round(filter * 2**30); freqz(filter * 2**-30);
+ * The capture path always runs at AUDIO_HW_OUT_SAMPLERATE; DownSampler
+ * converts it to the client rate in a single polyphase filtering step
+ * (see PolyphaseResampler) instead of the former chain of 2:1 FIR stages
+ * followed by linear interpolation.
  */
-static const int32_t filter_22khz_coeff[] = {
-    2089257, 2898328, -5820678, -10484531,
-    19038724, 30542725, -50469415, -81505260,
-    152544464, 478517512, 478517512, 152544464,
-    -81505260, -50469415, 30542725, 19038724,
-    -10484531, -5820678, 2898328, 2089257,
-};
-#define NUM_COEFF_22KHZ (sizeof(filter_22khz_coeff) / sizeof(filter_22khz_coeff[0]))
-#define OVERLAP_22KHZ (NUM_COEFF_22KHZ - 2)
-
-/*
- * Convolution of signals A and reverse(B). (In our case, the filter response
- * is symmetric, so the reversing doesn't matter.)
- * A is taken to be in 0.16 fixed-point, and B is taken to be in 2.30 fixed-point.
- * The answer will be in 16.16 fixed-point, unclipped.
- *
- * This function would probably be the prime candidate for SIMD conversion if
- * you want more speed.
- */
-int32_t fir_convolve(const int16_t* a, const int32_t* b, int num_samples)
-{
-        int32_t sum = 1 << 13;
-        for (int i = 0; i < num_samples; ++i) {
-                sum += a[i] * (b[i] >> 16);
-        }
-        return sum >> 14;
-}
-
-/* Clip from 16.16 fixed-point to 0.16 fixed-point. */
-int16_t clip(int32_t x)
-{
-    if (x < -32768) {
-        return -32768;
-    } else if (x > 32767) {
-        return 32767;
-    } else {
-        return x;
-    }
-}
-
-/*
- * Convert a chunk from 44 kHz to 22 kHz. Will update num_samples_in and num_samples_out
- * accordingly, since it may leave input samples in the buffer due to overlap.
- *
- * Input and output are taken to be in 0.16 fixed-point.
- */
-void resample_2_1(int16_t* input, int16_t* output, int* num_samples_in, int* num_samples_out)
-{
-    if (*num_samples_in < (int)NUM_COEFF_22KHZ) {
-        *num_samples_out = 0;
-        return;
-    }
-
-    int odd_smp = *num_samples_in & 0x1;
-    int num_samples = *num_samples_in - odd_smp - OVERLAP_22KHZ;
-
-    for (int i = 0; i < num_samples; i += 2) {
-            output[i / 2] = clip(fir_convolve(input + i, filter_22khz_coeff, NUM_COEFF_22KHZ));
-    }
-
-    memmove(input, input + num_samples, (OVERLAP_22KHZ + odd_smp) * sizeof(*input));
-    *num_samples_out = num_samples / 2;
-    *num_samples_in = OVERLAP_22KHZ + odd_smp;
-}
-
-/*
- * 2.30 fixed point FIR filter coefficients for conversion 22050 -> 16000,
- * or 11025 -> 8000.
- *
- * Transition band from about 14 kHz, passband ripple < 0.1 dB,
- * stopband ripple at about -50 dB, linear phase.
- *
- * Design and display in MATLAB or Octave using:
- *
- * filter = fir1(23, 16000 / 22050); filter = round(filter * 2**30); freqz(filter * 2**-30);
- */
-static const int32_t filter_16khz_coeff[] = {
-    2057290, -2973608, 1880478, 4362037,
-    -14639744, 18523609, -1609189, -38502470,
-    78073125, -68353935, -59103896, 617555440,
-    617555440, -59103896, -68353935, 78073125,
-    -38502470, -1609189, 18523609, -14639744,
-    4362037, 1880478, -2973608, 2057290,
-};
-#define NUM_COEFF_16KHZ (sizeof(filter_16khz_coeff) / sizeof(filter_16khz_coeff[0]))
-#define OVERLAP_16KHZ (NUM_COEFF_16KHZ - 1)
-
-/*
- * Convert a chunk from 22 kHz to 16 kHz. Will update num_samples_in and
- * num_samples_out accordingly, since it may leave input samples in the buffer
- * due to overlap.
- *
- * This implementation is rather ad-hoc; it first low-pass filters the data
- * into a temporary buffer, and then converts chunks of 441 input samples at a
- * time into 320 output samples by simple linear interpolation. A better
- * implementation would use a polyphase filter bank to do these two operations
- * in one step.
- *
- * Input and output are taken to be in 0.16 fixed-point.
- */
-
-#define RESAMPLE_16KHZ_SAMPLES_IN 441
-#define RESAMPLE_16KHZ_SAMPLES_OUT 320
-
-void resample_441_320(int16_t* input, int16_t* output, int* num_samples_in, int* num_samples_out)
-{
-    const int num_blocks = (*num_samples_in - OVERLAP_16KHZ) / RESAMPLE_16KHZ_SAMPLES_IN;
-    if (num_blocks < 1) {
-        *num_samples_out = 0;
-        return;
-    }
-
-    for (int i = 0; i < num_blocks; ++i) {
-        uint32_t tmp[RESAMPLE_16KHZ_SAMPLES_IN];
-        for (int j = 0; j < RESAMPLE_16KHZ_SAMPLES_IN; ++j) {
-            tmp[j] = fir_convolve(input + i * RESAMPLE_16KHZ_SAMPLES_IN + j,
-                          filter_16khz_coeff,
-                          NUM_COEFF_16KHZ);
-        }
-
-        const float step_float = (float)RESAMPLE_16KHZ_SAMPLES_IN / (float)RESAMPLE_16KHZ_SAMPLES_OUT;
-
-        uint32_t in_sample_num = 0;   // 16.16 fixed point
-        const uint32_t step = (uint32_t)(step_float * 65536.0f + 0.5f);  // 16.16 fixed point
-        for (int j = 0; j < RESAMPLE_16KHZ_SAMPLES_OUT; ++j, in_sample_num += step) {
-            const uint32_t whole = in_sample_num >> 16;
-            const uint32_t frac = (in_sample_num & 0xffff);  // 0.16 fixed point
-            const int32_t s1 = tmp[whole];
-            const int32_t s2 = tmp[whole + 1];
-            *output++ = clip(s1 + (((s2 - s1) * (int32_t)frac) >> 16));
-        }
-    }
-
-    const int samples_consumed = num_blocks * RESAMPLE_16KHZ_SAMPLES_IN;
-    memmove(input, input + samples_consumed, (*num_samples_in - samples_consumed) * sizeof(*input));
-    *num_samples_in -= samples_consumed;
-    *num_samples_out = RESAMPLE_16KHZ_SAMPLES_OUT * num_blocks;
-}
-
-
 AudioHardware::DownSampler::DownSampler(uint32_t outSampleRate,
                                     uint32_t channelCount,
                                     uint32_t frameCount,
                                     AudioHardware::BufferProvider* provider)
     :  mStatus(NO_INIT), mProvider(provider), mSampleRate(outSampleRate),
        mChannelCount(channelCount), mFrameCount(frameCount),
-       mInLeft(NULL), mInRight(NULL), mTmpLeft(NULL), mTmpRight(NULL),
-       mTmp2Left(NULL), mTmp2Right(NULL), mOutLeft(NULL), mOutRight(NULL)
+       mResampler(NULL)
 
 {
     LOGV("AudioHardware::DownSampler() cstor %p SR %d channels %d frames %d",
@@ -1811,37 +1666,28 @@ AudioHardware::DownSampler::DownSampler(uint32_t outSampleRate,
         return;
     }
 
-    mInLeft = new int16_t[mFrameCount];
-    mInRight = new int16_t[mFrameCount];
-    mTmpLeft = new int16_t[mFrameCount];
-    mTmpRight = new int16_t[mFrameCount];
-    mTmp2Left = new int16_t[mFrameCount];
-    mTmp2Right = new int16_t[mFrameCount];
-    mOutLeft = new int16_t[mFrameCount];
-    mOutRight = new int16_t[mFrameCount];
+    mResampler = new PolyphaseResampler(AUDIO_HW_OUT_SAMPLERATE, mSampleRate,
+                                        mChannelCount);
+    if (mResampler->initCheck() != 0) {
+        LOGW("AudioHardware::DownSampler cstor: no filter for %d -> %d",
+             AUDIO_HW_OUT_SAMPLERATE, mSampleRate);
+        return;
+    }
+    LOGV("AudioHardware::DownSampler() %d/%d polyphase, %d taps, %s kernel",
+         mResampler->interpolation(), mResampler->decimation(),
+         mResampler->taps(), PolyphaseResampler::kernelName(mResampler->kernel()));
 
     mStatus = NO_ERROR;
 }
 
 AudioHardware::DownSampler::~DownSampler()
 {
-    if (mInLeft) delete[] mInLeft;
-    if (mInRight) delete[] mInRight;
-    if (mTmpLeft) delete[] mTmpLeft;
-    if (mTmpRight) delete[] mTmpRight;
-    if (mTmp2Left) delete[] mTmp2Left;
-    if (mTmp2Right) delete[] mTmp2Right;
-    if (mOutLeft) delete[] mOutLeft;
-    if (mOutRight) delete[] mOutRight;
+    if (mResampler) delete mResampler;
 }
 
 void AudioHardware::DownSampler::reset()
 {
-    mInInBuf = 0;
-    mInTmpBuf = 0;
-    mInTmp2Buf = 0;
-    mOutBufPos = 0;
-    mInOutBuf = 0;
+    if (mResampler) mResampler->reset();
 }
 
 
@@ -1855,155 +1701,29 @@ int AudioHardware::DownSampler::resample(int16_t* out, size_t *outFrameCount)
         return BAD_VALUE;
     }
 
-    int16_t *outLeft = mTmp2Left;
-    int16_t *outRight = mTmp2Left;
-    if (mSampleRate == 22050) {
-        outLeft = mTmpLeft;
-        outRight = mTmpRight;
-    } else if (mSampleRate == 8000){
-        outLeft = mOutLeft;
-        outRight = mOutRight;
-    }
-
-    int outFrames = 0;
-    int remaingFrames = *outFrameCount;
-
-    if (mInOutBuf) {
-        int frames = (remaingFrames > mInOutBuf) ? mInOutBuf : remaingFrames;
-
-       
-		
-        if (mChannelCount == 2) {
-            for (int i = 0; i < frames; ++i) {
-                out[i * 2] = outLeft[mOutBufPos + i];
-                out[i * 2 + 1] = outRight[mOutBufPos + i];
-            }
-        }
-		else
-        {
-        	 for (int i = 0; i < frames; ++i) {
-            	out[i] = outLeft[mOutBufPos + i];
-            }
-        }
-        remaingFrames -= frames;
-        mInOutBuf -= frames;
-        mOutBufPos += frames;
-        outFrames += frames;
-    }
+    size_t outFrames = 0;
+    size_t remaingFrames = *outFrameCount;
 
     while (remaingFrames) {
-        LOGW_IF((mInOutBuf != 0), "mInOutBuf should be 0 here");
-
         AudioHardware::BufferProvider::Buffer buf;
-        buf.frameCount =  mFrameCount - mInInBuf;
+        buf.frameCount = mFrameCount;
         int ret = mProvider->getNextBuffer(&buf);
         if (buf.raw == NULL) {
             *outFrameCount = outFrames;
             return ret;
         }
 
-        for (size_t i = 0; i < buf.frameCount; ++i) {
-            mInLeft[i + mInInBuf] = buf.i16[i];
-        }
-        if (mChannelCount == 2) {
-            for (size_t i = 0; i < buf.frameCount; ++i) {
-                mInLeft[i + mInInBuf] = buf.i16[i * 2];
-                mInRight[i + mInInBuf] = buf.i16[i * 2 + 1];
-            }
-        }
-        mInInBuf += buf.frameCount;
+        // only the input actually consumed is released, the rest stays
+        // with the provider for the next call
+        size_t inFrames = buf.frameCount;
+        size_t frames = remaingFrames;
+        mResampler->resample(buf.i16, &inFrames,
+                             out + outFrames * mChannelCount, &frames);
+        buf.frameCount = inFrames;
         mProvider->releaseBuffer(&buf);
 
-        /* 44010 -> 22050 */
-        {
-            int samples_in_left = mInInBuf;
-            int samples_out_left;
-            resample_2_1(mInLeft, mTmpLeft + mInTmpBuf, &samples_in_left, &samples_out_left);
-
-            if (mChannelCount == 2) {
-                int samples_in_right = mInInBuf;
-                int samples_out_right;
-                resample_2_1(mInRight, mTmpRight + mInTmpBuf, &samples_in_right, &samples_out_right);
-            }
-
-            mInInBuf = samples_in_left;
-            mInTmpBuf += samples_out_left;
-            mInOutBuf = samples_out_left;
-        }
-
-        if (mSampleRate == 11025 || mSampleRate == 8000) {
-            /* 22050 - > 11025 */
-            int samples_in_left = mInTmpBuf;
-            int samples_out_left;
-            resample_2_1(mTmpLeft, mTmp2Left + mInTmp2Buf, &samples_in_left, &samples_out_left);
-
-            if (mChannelCount == 2) {
-                int samples_in_right = mInTmpBuf;
-                int samples_out_right;
-                resample_2_1(mTmpRight, mTmp2Right + mInTmp2Buf, &samples_in_right, &samples_out_right);
-            }
-
-
-            mInTmpBuf = samples_in_left;
-            mInTmp2Buf += samples_out_left;
-            mInOutBuf = samples_out_left;
-
-            if (mSampleRate == 8000) {
-                /* 11025 -> 8000*/
-                int samples_in_left = mInTmp2Buf;
-                int samples_out_left;
-                resample_441_320(mTmp2Left, mOutLeft, &samples_in_left, &samples_out_left);
-
-                if (mChannelCount == 2) {
-                    int samples_in_right = mInTmp2Buf;
-                    int samples_out_right;
-                    resample_441_320(mTmp2Right, mOutRight, &samples_in_right, &samples_out_right);
-                }
-
-                mInTmp2Buf = samples_in_left;
-                mInOutBuf = samples_out_left;
-            } else {
-                mInTmp2Buf = 0;
-            }
-
-        } else if (mSampleRate == 16000) {
-            /* 22050 -> 16000*/
-            int samples_in_left = mInTmpBuf;
-            int samples_out_left;
-            resample_441_320(mTmpLeft, mTmp2Left, &samples_in_left, &samples_out_left);
-
-            if (mChannelCount == 2) {
-                int samples_in_right = mInTmpBuf;
-                int samples_out_right;
-                resample_441_320(mTmpRight, mTmp2Right, &samples_in_right, &samples_out_right);
-            }
-
-            mInTmpBuf = samples_in_left;
-            mInOutBuf = samples_out_left;
-        } else {
-            mInTmpBuf = 0;
-        }
-
-        int frames = (remaingFrames > mInOutBuf) ? mInOutBuf : remaingFrames;
-
-        
-		
-        if (mChannelCount == 2) {
-            for (int i = 0; i < frames; ++i) {
-                out[(outFrames + i) * 2] = outLeft[i];
-                out[(outFrames + i) * 2 + 1] = outRight[i];
-            }
-        }
-		else
-		{
-			for (int i = 0; i < frames; ++i) {
-            out[outFrames + i] = outLeft[i];
-            }
-        }
         remaingFrames -= frames;
         outFrames += frames;
-        mOutBufPos = frames;
-        mInOutBuf -= frames;
     }
 
     return 0;
@@ -35,6 +35,8 @@ extern "C" {
 
 namespace android {
 
+class PolyphaseResampler;
+
 // TODO: determine actual audio DSP and hardware latency
 // Additionnal latency introduced by audio DSP and hardware in ms
 #define AUDIO_HW_OUT_LATENCY_MS 0
@@ -264,19 +266,7 @@ private:
         uint32_t mSampleRate;
         uint32_t mChannelCount;
         uint32_t mFrameCount;
-        int16_t *mInLeft;
-        int16_t *mInRight;
-        int16_t *mTmpLeft;
-        int16_t *mTmpRight;
-        int16_t *mTmp2Left;
-        int16_t *mTmp2Right;
-        int16_t *mOutLeft;
-        int16_t *mOutRight;
-        int mInInBuf;
-        int mInTmpBuf;
-        int mInTmp2Buf;
-        int mOutBufPos;
-        int mInOutBuf;
+        PolyphaseResampler *mResampler;
     };
 
 
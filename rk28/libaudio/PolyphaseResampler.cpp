@@ -0,0 +1,371 @@
+/*
+** Copyright 2010, The Android Open-Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "PolyphaseResampler.h"
+
+namespace android {
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Filter design. With the input upsampled by L, the prototype low-pass
+ * has its -6 dB point at 90% of the lower of the two Nyquist frequencies.
+ * It gets 32 taps per phase for every input sample per output sample,
+ * which with a Kaiser window of beta 6 puts the transition band at about
+ * 0.8..1.0 x Nyquist with -60 dB stopband rejection.
+ */
+static const double   kCutoff = 0.9;
+static const double   kKaiserBeta = 6.0;
+static const uint32_t kTapsPerZeroCrossing = 32;
+static const uint32_t kMaxTaps = 512;
+
+// input samples buffered per channel beyond the filter context
+static const size_t   kBlockFrames = 512;
+
+struct PolyphaseResampler::Bank {
+    uint32_t    L;
+    uint32_t    M;
+    uint32_t    taps;
+    int16_t*    coefs;
+    Bank*       next;
+};
+
+static pthread_mutex_t sBankLock = PTHREAD_MUTEX_INITIALIZER;
+static PolyphaseResampler::Bank* sBanks = 0;
+
+static uint32_t gcd(uint32_t a, uint32_t b)
+{
+    while (b) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// zeroth order modified Bessel function of the first kind
+static double bessel_i0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+const PolyphaseResampler::Bank* PolyphaseResampler::getBank(uint32_t L, uint32_t M)
+{
+    pthread_mutex_lock(&sBankLock);
+    Bank* bank = sBanks;
+    while (bank && (bank->L != L || bank->M != M)) {
+        bank = bank->next;
+    }
+    if (bank) {
+        pthread_mutex_unlock(&sBankLock);
+        return bank;
+    }
+
+    const uint32_t maxLM = (L > M) ? L : M;
+    uint32_t taps = (kTapsPerZeroCrossing * maxLM + L - 1) / L;
+    taps = (taps + 7) & ~7;     // whole SIMD blocks
+    if (taps > kMaxTaps) {
+        pthread_mutex_unlock(&sBankLock);
+        return 0;
+    }
+
+    const uint32_t N = taps * L;
+    const double fc = 0.5 * kCutoff / maxLM;   // relative to L x input rate
+    const double center = (N - 1) / 2.0;
+    const double i0Beta = bessel_i0(kKaiserBeta);
+    double* h = new double[N];
+    for (uint32_t n = 0; n < N; ++n) {
+        double t = n - center;
+        double s = (t == 0) ? 2.0 * fc : sin(2.0 * M_PI * fc * t) / (M_PI * t);
+        double r = t / center;
+        double w = bessel_i0(kKaiserBeta * sqrt(1.0 - r * r)) / i0Beta;
+        h[n] = s * w;
+    }
+
+    bank = new Bank;
+    bank->L = L;
+    bank->M = M;
+    bank->taps = taps;
+    bank->coefs = new int16_t[N];
+    for (uint32_t p = 0; p < L; ++p) {
+        // phase p applies h[p + k*L] to x[i-k]; store it time reversed
+        // and normalized to unity DC gain
+        int16_t* c = bank->coefs + p * taps;
+        double sum = 0;
+        for (uint32_t k = 0; k < taps; ++k) {
+            sum += h[p + k * L];
+        }
+        int32_t total = 0;
+        uint32_t peak = 0;
+        for (uint32_t k = 0; k < taps; ++k) {
+            double v = floor(h[p + k * L] / sum * 32768.0 + 0.5);
+            if (v > 32767) v = 32767;
+            if (v < -32768) v = -32768;
+            c[taps - 1 - k] = (int16_t)v;
+            total += (int32_t)v;
+            if (abs(c[taps - 1 - k]) > abs(c[peak])) peak = taps - 1 - k;
+        }
+        int32_t fixed = c[peak] + (32768 - total);
+        if (fixed > 32767) fixed = 32767;
+        c[peak] = (int16_t)fixed;
+    }
+    delete[] h;
+
+    bank->next = sBanks;
+    sBanks = bank;
+    pthread_mutex_unlock(&sBankLock);
+    return bank;
+}
+
+// ----------------------------------------------------------------------------
+// Dot product kernels, n is a multiple of 8. All of them accumulate the
+// exact products in 32 bits so they agree bit for bit.
+
+static int32_t dot_scalar(const int16_t* x, const int16_t* h, int n)
+{
+    int32_t sum = 0;
+    for (int i = 0; i < n; ++i) {
+        sum += x[i] * h[i];
+    }
+    return sum;
+}
+
+#if defined(__ARM_NEON__)
+static int32_t dot_neon(const int16_t* x, const int16_t* h, int n)
+{
+    int32x4_t acc0 = vdupq_n_s32(0);
+    int32x4_t acc1 = vdupq_n_s32(0);
+    for (int i = 0; i < n; i += 8) {
+        int16x8_t a = vld1q_s16(x + i);
+        int16x8_t b = vld1q_s16(h + i);
+        acc0 = vmlal_s16(acc0, vget_low_s16(a), vget_low_s16(b));
+        acc1 = vmlal_s16(acc1, vget_high_s16(a), vget_high_s16(b));
+    }
+    int32x4_t acc = vaddq_s32(acc0, acc1);
+    int32x2_t s = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+    s = vpadd_s32(s, s);
+    return vget_lane_s32(s, 0);
+}
+#endif
+
+#if defined(__SSE2__)
+static int32_t dot_sse2(const int16_t* x, const int16_t* h, int n)
+{
+    __m128i acc = _mm_setzero_si128();
+    for (int i = 0; i < n; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(x + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(h + i));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(a, b));
+    }
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(acc);
+}
+#endif
+
+bool PolyphaseResampler::hasKernel(kernel_t kernel)
+{
+    switch (kernel) {
+    case KERNEL_SCALAR:
+    case KERNEL_BEST:
+        return true;
+#if defined(__ARM_NEON__)
+    case KERNEL_NEON:
+        return true;
+#endif
+#if defined(__SSE2__)
+    case KERNEL_SSE2:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+const char* PolyphaseResampler::kernelName(kernel_t kernel)
+{
+    switch (kernel) {
+    case KERNEL_SCALAR: return "scalar";
+    case KERNEL_NEON:   return "neon";
+    case KERNEL_SSE2:   return "sse2";
+    default:            return "best";
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+PolyphaseResampler::PolyphaseResampler(uint32_t inRate, uint32_t outRate,
+                                       uint32_t channelCount, kernel_t kernel)
+    :  mStatus(-EINVAL), mL(0), mM(0), mTaps(0), mChannelCount(channelCount),
+       mKernel(KERNEL_SCALAR), mDot(dot_scalar), mCoefs(0),
+       mHistory(0), mCapacity(0), mAvail(0), mIndex(0), mPhase(0)
+{
+    if (inRate == 0 || outRate == 0 || channelCount == 0 ||
+            !hasKernel(kernel)) {
+        return;
+    }
+
+    uint32_t g = gcd(inRate, outRate);
+    mL = outRate / g;
+    mM = inRate / g;
+
+    const Bank* bank = getBank(mL, mM);
+    if (bank == 0) {
+        return;
+    }
+    mTaps = bank->taps;
+    mCoefs = bank->coefs;
+
+    if (kernel == KERNEL_BEST) {
+#if defined(__ARM_NEON__)
+        kernel = KERNEL_NEON;
+#elif defined(__SSE2__)
+        kernel = KERNEL_SSE2;
+#else
+        kernel = KERNEL_SCALAR;
+#endif
+    }
+    mKernel = kernel;
+#if defined(__ARM_NEON__)
+    if (kernel == KERNEL_NEON) mDot = dot_neon;
+#endif
+#if defined(__SSE2__)
+    if (kernel == KERNEL_SSE2) mDot = dot_sse2;
+#endif
+
+    mCapacity = mTaps - 1 + kBlockFrames;
+    mHistory = new int16_t[mCapacity * mChannelCount];
+    reset();
+    mStatus = 0;
+}
+
+PolyphaseResampler::~PolyphaseResampler()
+{
+    delete[] mHistory;
+}
+
+void PolyphaseResampler::reset()
+{
+    if (mHistory == 0) return;
+    // start from silence
+    memset(mHistory, 0, mCapacity * mChannelCount * sizeof(int16_t));
+    mAvail = mTaps - 1;
+    mIndex = mTaps - 1;
+    mPhase = 0;
+}
+
+void PolyphaseResampler::resample(const int16_t* in, size_t* inFrames,
+                                  int16_t* out, size_t* outFrames)
+{
+    if (mStatus != 0) {
+        *inFrames = 0;
+        *outFrames = 0;
+        return;
+    }
+
+    const size_t C = mChannelCount;
+    size_t inUsed = 0;
+    size_t outMade = 0;
+
+    while (outMade < *outFrames) {
+        if (mIndex >= mAvail) {
+            if (inUsed == *inFrames) break;
+
+            // drop what the next output doesn't need any more
+            size_t drop = mIndex - (mTaps - 1);
+            if (drop > mAvail) drop = mAvail;
+            if (drop) {
+                for (size_t c = 0; c < C; ++c) {
+                    int16_t* h = mHistory + c * mCapacity;
+                    memmove(h, h + drop, (mAvail - drop) * sizeof(int16_t));
+                }
+                mAvail -= drop;
+                mIndex -= drop;
+            }
+
+            size_t n = *inFrames - inUsed;
+            if (n > mCapacity - mAvail) n = mCapacity - mAvail;
+            const int16_t* src = in + inUsed * C;
+            for (size_t c = 0; c < C; ++c) {
+                int16_t* h = mHistory + c * mCapacity + mAvail;
+                for (size_t i = 0; i < n; ++i) {
+                    h[i] = src[i * C + c];
+                }
+            }
+            mAvail += n;
+            inUsed += n;
+            continue;
+        }
+
+        // outputs computable from what is buffered
+        size_t count = 0;
+        size_t index = mIndex;
+        uint32_t phase = mPhase;
+        while (index < mAvail && outMade + count < *outFrames) {
+            phase += mM;
+            index += phase / mL;
+            phase %= mL;
+            count++;
+        }
+
+        for (size_t c = 0; c < C; ++c) {
+            const int16_t* h = mHistory + c * mCapacity;
+            int16_t* dst = out + outMade * C + c;
+            index = mIndex;
+            phase = mPhase;
+            for (size_t j = 0; j < count; ++j) {
+                int32_t acc = mDot(h + index - (mTaps - 1),
+                                   mCoefs + phase * mTaps, mTaps);
+                acc = (acc + (1 << 14)) >> 15;
+                if (acc > 32767) acc = 32767;
+                if (acc < -32768) acc = -32768;
+                dst[j * C] = (int16_t)acc;
+                phase += mM;
+                index += phase / mL;
+                phase %= mL;
+            }
+        }
+        mIndex = index;
+        mPhase = phase;
+        outMade += count;
+    }
+
+    *inFrames = inUsed;
+    *outFrames = outMade;
+}
+
+// ----------------------------------------------------------------------------
+
+}; // namespace android
@@ -0,0 +1,102 @@
+/*
+** Copyright 2010, The Android Open-Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef ANDROID_POLYPHASE_RESAMPLER_H
+#define ANDROID_POLYPHASE_RESAMPLER_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+namespace android {
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Rational ratio sample rate converter for 16 bit PCM.
+ *
+ * The ratio inRate:outRate is reduced to M:L and a Kaiser windowed sinc
+ * low-pass is split into L phases of mTaps coefficients each, so every
+ * output sample is a single mTaps long dot product against the input
+ * history. Coefficient banks are in Q15, computed once per ratio and
+ * shared by all resamplers using that ratio.
+ *
+ * The dot product has a portable fixed-point reference and NEON / SSE2
+ * versions that give bit-identical results.
+ */
+class PolyphaseResampler
+{
+public:
+    enum kernel_t {
+        KERNEL_SCALAR = 0,
+        KERNEL_NEON,
+        KERNEL_SSE2,
+        KERNEL_BEST,
+    };
+
+    PolyphaseResampler(uint32_t inRate, uint32_t outRate,
+                       uint32_t channelCount, kernel_t kernel = KERNEL_BEST);
+    ~PolyphaseResampler();
+
+    // 0 if the resampler is usable, negative errno otherwise
+    int         initCheck() const { return mStatus; }
+    void        reset();
+
+    /*
+     * Converts interleaved frames. On return *inFrames holds the number of
+     * input frames consumed and *outFrames the number of frames written;
+     * input is only consumed while there is room for the output it makes.
+     */
+    void        resample(const int16_t* in, size_t* inFrames,
+                         int16_t* out, size_t* outFrames);
+
+    uint32_t    interpolation() const { return mL; }
+    uint32_t    decimation() const { return mM; }
+    uint32_t    taps() const { return mTaps; }
+    kernel_t    kernel() const { return mKernel; }
+
+    static bool hasKernel(kernel_t kernel);
+    static const char* kernelName(kernel_t kernel);
+
+    typedef int32_t (*dot_fn)(const int16_t* x, const int16_t* h, int n);
+
+    // coefficient bank shared by every resampler with the same ratio
+    struct Bank;
+
+private:
+    static const Bank* getBank(uint32_t L, uint32_t M);
+
+    int         mStatus;
+    uint32_t    mL;
+    uint32_t    mM;
+    uint32_t    mTaps;
+    uint32_t    mChannelCount;
+    kernel_t    mKernel;
+    dot_fn      mDot;
+    const int16_t* mCoefs;  // mL phases of mTaps, time reversed
+
+    // per channel input history, mTaps-1 samples of context + new input
+    int16_t*    mHistory;
+    size_t      mCapacity;
+    size_t      mAvail;     // samples in each channel's history
+    size_t      mIndex;     // newest input sample of the next output
+    uint32_t    mPhase;
+};
+
+// ----------------------------------------------------------------------------
+
+}; // namespace android
+
+#endif // ANDROID_POLYPHASE_RESAMPLER_H
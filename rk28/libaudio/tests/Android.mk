@@ -0,0 +1,9 @@
+LOCAL_PATH:= $(call my-dir)
+
+# offline SNR/throughput harness for the capture resampler
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES:= resampler_bench.cpp ../PolyphaseResampler.cpp
+LOCAL_MODULE:= resampler_bench
+LOCAL_LDLIBS:= -lm -lpthread
+LOCAL_MODULE_TAGS:= tests
+include $(BUILD_HOST_EXECUTABLE)
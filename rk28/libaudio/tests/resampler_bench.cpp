@@ -0,0 +1,214 @@
+/*
+** Copyright 2010, The Android Open-Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+/*
+ * Offline SNR and throughput harness for PolyphaseResampler.
+ *
+ * For every ratio it measures the SNR of an in-band tone against an ideal
+ * sine, the rejection of a tone just above the output Nyquist frequency,
+ * checks that the SIMD kernels match the fixed-point reference bit for
+ * bit, and times each kernel on stereo input fed in HAL sized periods.
+ *
+ *   resampler_bench [seconds]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../PolyphaseResampler.h"
+
+using namespace android;
+
+static const size_t kPeriodFrames = 2048;
+
+struct ratio_t {
+    uint32_t in;
+    uint32_t out;
+};
+
+static const ratio_t kRatios[] = {
+    { 44100, 8000 }, { 44100, 11025 }, { 44100, 16000 }, { 44100, 22050 },
+    { 48000, 8000 }, { 48000, 16000 }, { 48000, 44100 },
+    { 16000, 8000 }, { 8000, 16000 },
+};
+
+static void make_tone(int16_t* buf, size_t frames, uint32_t channels,
+                      double freq, uint32_t rate, double amplitude)
+{
+    for (size_t i = 0; i < frames; ++i) {
+        int16_t v = (int16_t)floor(amplitude * 32767.0 *
+                sin(2.0 * M_PI * freq * i / rate) + 0.5);
+        for (uint32_t c = 0; c < channels; ++c) {
+            buf[i * channels + c] = v;
+        }
+    }
+}
+
+// runs a whole buffer through, in HAL sized periods; returns frames out
+static size_t run(PolyphaseResampler& r, const int16_t* in, size_t inFrames,
+                  int16_t* out, size_t outCapacity, uint32_t channels)
+{
+    size_t used = 0, made = 0;
+    while (used < inFrames && made < outCapacity) {
+        size_t n = inFrames - used;
+        if (n > kPeriodFrames) n = kPeriodFrames;
+        size_t o = outCapacity - made;
+        r.resample(in + used * channels, &n, out + made * channels, &o);
+        used += n;
+        made += o;
+        if (n == 0 && o == 0) break;
+    }
+    return made;
+}
+
+// least squares fit of a sine of known frequency, returns SNR in dB
+static double fit_snr(const int16_t* y, size_t n, uint32_t stride,
+                      double freq, uint32_t rate)
+{
+    double ss = 0, cc = 0, sc = 0, ys = 0, yc = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double s = sin(2.0 * M_PI * freq * i / rate);
+        double c = cos(2.0 * M_PI * freq * i / rate);
+        double v = y[i * stride];
+        ss += s * s; cc += c * c; sc += s * c;
+        ys += v * s; yc += v * c;
+    }
+    double det = ss * cc - sc * sc;
+    double a = (ys * cc - yc * sc) / det;
+    double b = (yc * ss - ys * sc) / det;
+    double sig = 0, err = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double fit = a * sin(2.0 * M_PI * freq * i / rate) +
+                     b * cos(2.0 * M_PI * freq * i / rate);
+        double e = y[i * stride] - fit;
+        sig += fit * fit;
+        err += e * e;
+    }
+    return 10.0 * log10(sig / (err > 0 ? err : 1e-9));
+}
+
+static double rms(const int16_t* y, size_t n, uint32_t stride)
+{
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += (double)y[i * stride] * y[i * stride];
+    }
+    return sqrt(sum / (n ? n : 1));
+}
+
+static double now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = (argc > 1) ? atof(argv[1]) : 10.0;
+    if (seconds <= 0) seconds = 10.0;
+    const uint32_t channels = 2;
+    int failures = 0;
+
+    printf("%-13s %5s %5s %9s %9s %8s", "ratio", "L/M", "taps",
+           "SNR(dB)", "stop(dB)", "exact");
+    for (int k = 0; k < PolyphaseResampler::KERNEL_BEST; ++k) {
+        if (PolyphaseResampler::hasKernel((PolyphaseResampler::kernel_t)k)) {
+            printf(" %8s(x rt)", PolyphaseResampler::kernelName(
+                    (PolyphaseResampler::kernel_t)k));
+        }
+    }
+    printf("\n");
+
+    for (size_t i = 0; i < sizeof(kRatios) / sizeof(kRatios[0]); ++i) {
+        const ratio_t& ratio = kRatios[i];
+        const size_t inFrames = (size_t)(seconds * ratio.in);
+        const size_t outCapacity = (size_t)(seconds * ratio.out) + 64;
+        int16_t* in = new int16_t[inFrames * channels];
+        int16_t* ref = new int16_t[outCapacity * channels];
+        int16_t* out = new int16_t[outCapacity * channels];
+        uint32_t lowRate = ratio.in < ratio.out ? ratio.in : ratio.out;
+
+        PolyphaseResampler scalar(ratio.in, ratio.out, channels,
+                                  PolyphaseResampler::KERNEL_SCALAR);
+        if (scalar.initCheck()) {
+            printf("%u->%u: init failed\n", ratio.in, ratio.out);
+            failures++;
+            continue;
+        }
+        const size_t skip = scalar.taps() * 2;
+
+        // in-band tone
+        const double tone = lowRate * 0.17;
+        make_tone(in, inFrames, channels, tone, ratio.in, 0.5);
+        size_t made = run(scalar, in, inFrames, ref, outCapacity, channels);
+        double snr = fit_snr(ref + skip * channels, made - skip, channels,
+                             tone, ratio.out);
+
+        // tone just above the output Nyquist frequency, if there is one
+        double stop = 0;
+        if (ratio.out < ratio.in) {
+            PolyphaseResampler s2(ratio.in, ratio.out, channels,
+                                  PolyphaseResampler::KERNEL_SCALAR);
+            make_tone(in, inFrames, channels, ratio.out * 0.53, ratio.in, 0.5);
+            size_t m = run(s2, in, inFrames, out, outCapacity, channels);
+            double r = rms(out + skip * channels, m - skip, channels);
+            stop = 20.0 * log10((r > 0 ? r : 0.5) / (0.5 * 32767.0 / sqrt(2.0)));
+            make_tone(in, inFrames, channels, tone, ratio.in, 0.5);
+        }
+
+        char name[32];
+        snprintf(name, sizeof(name), "%u->%u", ratio.in, ratio.out);
+        printf("%-13s %5u %5u %9.1f %9.1f", name,
+               scalar.interpolation(), scalar.taps(), snr, stop);
+
+        // bit exactness of every kernel against the reference
+        bool exact = true;
+        for (int k = 1; k < PolyphaseResampler::KERNEL_BEST; ++k) {
+            PolyphaseResampler::kernel_t kernel = (PolyphaseResampler::kernel_t)k;
+            if (!PolyphaseResampler::hasKernel(kernel)) continue;
+            PolyphaseResampler r(ratio.in, ratio.out, channels, kernel);
+            size_t m = run(r, in, inFrames, out, outCapacity, channels);
+            if (m != made || memcmp(out, ref, m * channels * sizeof(int16_t))) {
+                exact = false;
+            }
+        }
+        printf(" %8s", exact ? "yes" : "NO");
+        if (!exact || snr < 50.0) failures++;
+
+        // throughput, as a multiple of real time
+        for (int k = 0; k < PolyphaseResampler::KERNEL_BEST; ++k) {
+            PolyphaseResampler::kernel_t kernel = (PolyphaseResampler::kernel_t)k;
+            if (!PolyphaseResampler::hasKernel(kernel)) continue;
+            PolyphaseResampler r(ratio.in, ratio.out, channels, kernel);
+            double t0 = now_ms();
+            run(r, in, inFrames, out, outCapacity, channels);
+            double ms = now_ms() - t0;
+            printf(" %14.1f", seconds * 1000.0 / (ms > 0 ? ms : 1e-3));
+        }
+        printf("\n");
+
+        delete[] in;
+        delete[] ref;
+        delete[] out;
+    }
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
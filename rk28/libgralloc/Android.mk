@@ -26,9 +26,13 @@ LOCAL_SRC_FILES := 	\
 	allocator.cpp 	\
 	gralloc.cpp 	\
 	framebuffer.cpp \
-	mapper.cpp
+	luma.cpp 	\
+	mapper.cpp 	\
+	pmem.cpp
 
 LOCAL_MODULE := gralloc.rk28board
 LOCAL_CFLAGS:= -DLOG_TAG=\"gralloc\"
 
 include $(BUILD_SHARED_LIBRARY)
+
+include $(call all-makefiles-under,$(LOCAL_PATH))
@@ -40,6 +40,7 @@
 
 #include "gralloc_priv.h"
 #include "gr.h"
+#include "luma.h"
 
 #include <cutils/properties.h>
 
@@ -99,193 +100,32 @@ static int gRGB565_2_Luma = 0;
 static int gRotate = 0;
 static int gSkipPost = 1;
 static int gPixel_format_l8=0;
-#define RGB2Luma_4bit(r,g,b)        ((77*r+150*g+29*b)>>12)
+static luma_engine_t const* gLumaEngine = 0;
+// damage not yet converted into each luma page, in RGB565 coordinates
+static luma_rect_t gLumaDamage[NUM_BUFFERS];
 
-void RGB565_2_Luma_0(unsigned short *luma, unsigned short *Src, unsigned int width)
+static void luma_post_damage(private_module_t* m, unsigned int page,
+        unsigned short *gray, unsigned short *rgb_buf)
 {
-    unsigned int i;
-    unsigned int r, g, b, g0, g1, g2, g3;
-    unsigned int rgb_data;
-
-    for (i=0; i<width; i++)
-    {
-        rgb_data = *Src++;
-        r = (rgb_data & 0xf800)>>8;
-        g = (rgb_data & 0x07e0)>>3;
-        b = (rgb_data & 0x1f)<<3;       
-        g0 = RGB2Luma_4bit(r, g, b);
-
-        rgb_data = *Src++;      
-        r = (rgb_data & 0xf800)>>8;
-        g = (rgb_data & 0x07e0)>>3;
-        b = (rgb_data & 0x1f)<<3;               
-        g1 = RGB2Luma_4bit(r, g, b);
-
-        rgb_data = *Src++;      
-        r = (rgb_data & 0xf800)>>8;
-        g = (rgb_data & 0x07e0)>>3;
-        b = (rgb_data & 0x1f)<<3;               
-        g2 = RGB2Luma_4bit(r, g, b);
-
-        rgb_data = *Src++;      
-        r = (rgb_data & 0xf800)>>8;
-        g = (rgb_data & 0x07e0)>>3;
-        b = (rgb_data & 0x1f)<<3;       
-        g3 = RGB2Luma_4bit(r, g, b);
-        *luma++ = (g0 & 0x0F) | ((g1 & 0xF)<<4) | ((g2 & 0xF)<<8)| ((g3 & 0xF)<<12);
+    const int w = m->info.xres;
+    const int h = m->info.yres;
+    luma_rect_t rect = { 0, 0, w, h };
+    if (m->info.reserved[0] == 0x54445055) { // "UPDT"
+        rect.l = m->info.reserved[1] & 0xFFFF;
+        rect.t = m->info.reserved[1] >> 16;
+        rect.r = m->info.reserved[2] & 0xFFFF;
+        rect.b = m->info.reserved[2] >> 16;
     }
-}
 
-static void RGB565_2_Luma_90(unsigned short *luma, unsigned short *Src,
-                unsigned int width, unsigned int height) {
-        unsigned int i;
-        unsigned int r, g, b, g0, g1, g2, g3;
-        unsigned int rgb_data;
-        for (i = 0; i < height; i += 4) {
-                rgb_data = *Src;
-                Src += width;
-                r = (rgb_data & 0xf800) >> 8;
-                g = (rgb_data & 0x07e0) >> 3;
-                b = (rgb_data & 0x001f) << 3;
-                g0 = RGB2Luma_4bit(r, g, b);
-                rgb_data = *Src;
-                Src += width;
-                r = (rgb_data & 0xf800) >> 8;
-                g = (rgb_data & 0x07e0) >> 3;
-                b = (rgb_data & 0x001f) << 3;
-                g1 = RGB2Luma_4bit(r, g, b);
-                rgb_data = *Src;
-                Src += width;
-                r = (rgb_data & 0xf800) >> 8;
-                g = (rgb_data & 0x07e0) >> 3;
-                b = (rgb_data & 0x001f) << 3;
-                g2 = RGB2Luma_4bit(r, g, b);
-                rgb_data = *Src;
-                Src += width;
-                r = (rgb_data & 0xf800) >> 8;
-                g = (rgb_data & 0x07e0) >> 3;
-                b = (rgb_data & 0x001f) << 3;
-                g3 = RGB2Luma_4bit(r, g, b);
-                *luma++ = (g0 & 0xF) | ((g1 & 0xF) << 4) | ((g2 & 0xF) << 8) | ((g3
-                                & 0xF) << 12);
-        }
-}
-
-void RGB565_2_Luma_180(unsigned short *luma, unsigned short *Src, unsigned int width)
-{
-    unsigned int i;
-    unsigned int r, g, b, g0, g1, g2, g3;
-    unsigned int rgb_data;
-
-    for (i=0; i<width; i+=4)
-    {
-        rgb_data = *Src--;
-        r = (rgb_data&0xf800)>>8;
-        g = (rgb_data&0x07e0)>>3;
-        b = (rgb_data&0x001f)<<3;
-        g0 = RGB2Luma_4bit(r, g, b);
-
-        rgb_data = *Src--;
-        r = (rgb_data&0xf800)>>8;
-        g = (rgb_data&0x07e0)>>3;
-        b = (rgb_data&0x001f)<<3;
-        g1 = RGB2Luma_4bit(r, g, b);
-
-        rgb_data = *Src--;
-        r = (rgb_data&0xf800)>>8;
-        g = (rgb_data&0x07e0)>>3;
-        b = (rgb_data&0x001f)<<3;
-        g2 = RGB2Luma_4bit(r, g, b);
-
-        rgb_data = *Src--;
-        r = (rgb_data&0xf800)>>8;
-        g = (rgb_data&0x07e0)>>3;
-        b = (rgb_data&0x001f)<<3;
-        g3 = RGB2Luma_4bit(r, g, b);
-        *luma++ = (g0 & 0xF) | ((g1 & 0xF)<<4) | ((g2 & 0xF)<<8)| ((g3 & 0xF)<<12);
-    }
-}
-
-
-void RGB565_2_Luma_270(unsigned short *luma, unsigned short *Src, unsigned int width, unsigned int height)
-{
-    unsigned int i;
-    unsigned int r, g, b, g0, g1, g2, g3;
-    unsigned int rgb_data;
-
-    for (i=0; i<height; i+=4)
-    {
-        rgb_data = *Src;
-        Src -= width;
-        r = (rgb_data&0xf800)>>8;
-        g = (rgb_data&0x07e0)>>3;
-        b = (rgb_data&0x001f)<<3;
-        g0 = RGB2Luma_4bit(r, g, b);
-
-        rgb_data = *Src;
-        Src -= width;
-        r = (rgb_data&0xf800)>>8;
-        g = (rgb_data&0x07e0)>>3;
-        b = (rgb_data&0x001f)<<3;
-        g1 = RGB2Luma_4bit(r, g, b);
-
-        rgb_data = *Src;
-        Src -= width;
-        r = (rgb_data&0xf800)>>8;
-        g = (rgb_data&0x07e0)>>3;
-        b = (rgb_data&0x001f)<<3;
-        g2 = RGB2Luma_4bit(r, g, b);
-
-        rgb_data = *Src;
-        Src -= width;
-        r = (rgb_data&0xf800)>>8;
-        g = (rgb_data&0x07e0)>>3;
-        b = (rgb_data&0x001f)<<3;
-        g3 = RGB2Luma_4bit(r, g, b);
-        *luma++ = (g0 & 0xF) | ((g1 & 0xF)<<4) | ((g2 & 0xF)<<8)| ((g3 & 0xF)<<12);
-    }
-}
-
-static void RGB565_2_Luma(unsigned short *gray, unsigned short *rgb_buf, int w, int h) {
-    int i, j;
-    switch(gRotate)
-    {
-        case 0:
-            for (j=0;j<h;j++)
-            {
-                RGB565_2_Luma_0(gray, rgb_buf, w>>2);
-                rgb_buf += w;
-                gray += (w>>2);
-            }
-            break;
-        case 1:
-            rgb_buf += (w - 1);
-              for(j=0; j<w; j++)
-              {
-                RGB565_2_Luma_90(gray, rgb_buf, w, h);
-                rgb_buf -= 1;
-                gray += (h>>2);
-              }           
-            break;
-        case 2:
-            rgb_buf += (h*w - 1) ;
-            for(j=0; j<h; j++)
-            {
-                RGB565_2_Luma_180(gray, rgb_buf, w);
-                rgb_buf -= w;
-                gray += (w>>2);
-            }
-            break;
-        case 3:
-            rgb_buf += (h*w - w) ;
-            for(j=0; j<w; j++)
-            {
-                RGB565_2_Luma_270(gray, rgb_buf, w, h);
-                rgb_buf += 1;
-                gray += (h>>2);
-            }
-            break;
+    // the other pages haven't seen this damage yet, they will pick it up
+    // the next time they are posted
+    for (int i=0 ; i<NUM_BUFFERS ; i++) {
+        luma_rect_union(gLumaDamage[i], rect);
     }
+    if (page >= NUM_BUFFERS)
+        page = 0;
+    luma_convert(gLumaEngine, gRotate, gray, rgb_buf, w, h, &gLumaDamage[page]);
+    luma_rect_set_empty(gLumaDamage[page]);
 }
 /////////////////////////////
 #define LUMA_2_565 4
@@ -344,8 +184,10 @@ static int fb_post(struct framebuffer_device_t* dev, buffer_handle_t buffer)
                     0, 0, m->info.xres, m->info.yres,
                     &fb_buffer_vaddr);
           
-            RGB565_2_Luma((unsigned short *)(fb_buffer_vaddr + offset / LUMA_2_565), (unsigned short *)buffer_vaddr, 
-                    m->info.xres, m->info.yres);
+            const size_t bufferSize = m->finfo.line_length * m->info.yres * LUMA_2_565;
+            luma_post_damage(m, offset / bufferSize,
+                    (unsigned short *)(fb_buffer_vaddr + offset / LUMA_2_565),
+                    (unsigned short *)buffer_vaddr);
             
             m->base.unlock(&m->base, m->framebuffer);
             m->base.unlock(&m->base, buffer);
@@ -359,6 +201,8 @@ static int fb_post(struct framebuffer_device_t* dev, buffer_handle_t buffer)
                 return -errno;
             }
             m->currentBuffer = buffer;
+            // the update rect only applies to this post
+            m->info.reserved[0] = 0;
         }
         //////////////////////////////
         else {
@@ -394,11 +238,12 @@ static int fb_post(struct framebuffer_device_t* dev, buffer_handle_t buffer)
         if(!gRGB565_2_Luma) {
             memcpy(fb_vaddr, buffer_vaddr, m->finfo.line_length * m->info.yres);
         } else {
-            RGB565_2_Luma((unsigned short *)fb_vaddr, (unsigned short *)buffer_vaddr, m->info.xres, m->info.yres);
+            luma_post_damage(m, 0, (unsigned short *)fb_vaddr, (unsigned short *)buffer_vaddr);
         }
         
         m->base.unlock(&m->base, buffer); 
         m->base.unlock(&m->base, m->framebuffer); 
+        m->info.reserved[0] = 0;
     }
     
     return 0;
@@ -467,6 +312,13 @@ int mapFrameBufferLocked(struct private_module_t* module)
             LOGW("jeffy persist.sys.luma-rotate fb");
         }
         LOGW("jeffy gRotate:%d", gRotate);
+
+        if (property_get("debug.gralloc.luma_engine", property, NULL) > 0) {
+            gLumaEngine = luma_engine_get(property);
+        } else {
+            gLumaEngine = luma_engine_get(NULL);
+        }
+        LOGI("luma engine: %s", gLumaEngine->name);
         
         info.bits_per_pixel = 4;
         info.red.offset     = 0;
@@ -495,6 +347,14 @@ int mapFrameBufferLocked(struct private_module_t* module)
      */
     info.yres_virtual = info.yres * NUM_BUFFERS;
 
+    if(gRGB565_2_Luma) {
+        // nothing has been converted yet
+        for (int k=0 ; k<NUM_BUFFERS ; k++) {
+            luma_rect_t full = { 0, 0, info.xres, info.yres };
+            gLumaDamage[k] = full;
+        }
+    }
+
 
     uint32_t flags = PAGE_FLIP;
     if (ioctl(fd, FBIOPUT_VSCREENINFO, &info) == -1) {
@@ -672,6 +532,8 @@ int fb_device_open(hw_module_t const* module, const char* name,
             if (atoi(property) == 1) {
                 LOGW("jeffy ro.rgb565-2-luma fb");
                 gRGB565_2_Luma = 1;
+                // only the dirty area gets converted on post
+                dev->device.setUpdateRect = fb_setUpdateRect;
             }
         }
         if(!gRGB565_2_Luma) {
@@ -43,6 +43,18 @@ inline size_t roundUpToPageSize(size_t x) {
 int mapFrameBufferLocked(struct private_module_t* module);
 int terminateBuffer(gralloc_module_t const* module, private_handle_t* hnd);
 
+// how often gralloc_lock/gralloc_unlock took their slow paths, since start
+struct gralloc_lock_stats_t {
+    int32_t     retries;        // lockState changed under a compare-and-swap
+    int32_t     yields;         // retry loops that gave up the CPU
+    int32_t     busy;           // conflicting locks refused with -EBUSY
+    int32_t     maps;           // buffers mmapped by gralloc_lock
+    int32_t     mapWaits;       // locks that found another thread mapping
+    int32_t     mapSleeps;      // ... and slept on the futex for it
+};
+
+void gralloc_get_lock_stats(gralloc_lock_stats_t* stats);
+
 /*****************************************************************************/
 
 class Locker {
@@ -35,17 +35,17 @@
 #include <hardware/gralloc.h>
 
 #include "gralloc_priv.h"
-#include "allocator.h"
-
-#if HAVE_ANDROID_OS
-#include <linux/android_pmem.h>
-#endif
+#include "pmem.h"
 
 #include <cutils/properties.h>
 
 /*****************************************************************************/
 
-static SimpleBestFitAllocator sAllocator;
+static PmemHeap sPmemHeap;
+
+#if HAVE_ANDROID_OS
+static AndroidPmemDevice sPmemDevice;
+#endif
 
 /*****************************************************************************/
 
@@ -206,33 +206,20 @@ static int gralloc_alloc_framebuffer(alloc_device_t* dev,
 
 static int init_pmem_area_locked(private_module_t* m)
 {
-    int err = 0;
 #if HAVE_ANDROID_OS // should probably define HAVE_PMEM somewhere
-    int master_fd = open("/dev/pmem", O_RDWR, 0);
-    if (master_fd >= 0) {
-        
-        size_t size;
-        pmem_region region;
-        if (ioctl(master_fd, PMEM_GET_TOTAL_SIZE, &region) < 0) {
-            LOGE("PMEM_GET_TOTAL_SIZE failed, limp mode");
-            size = 8<<20;   // 8 MiB
-        } else {
-            size = region.len;
-        }
-        sAllocator.setSize(size);
+    // "sync" zeroes each new buffer in the allocating thread, as gralloc
+    // used to, instead of zeroing freed buffers in the background
+    bool asyncScrub = true;
+    char property[PROPERTY_VALUE_MAX];
+    if (property_get("debug.gralloc.pmem_scrub", property, NULL) > 0 &&
+            !strcmp(property, "sync")) {
+        asyncScrub = false;
+    }
 
-        void* base = mmap(0, size, 
-                PROT_READ|PROT_WRITE, MAP_SHARED, master_fd, 0);
-        if (base == MAP_FAILED) {
-            err = -errno;
-            base = 0;
-            close(master_fd);
-            master_fd = -1;
-        }
-        m->pmem_master = master_fd;
-        m->pmem_master_base = base;
-    } else {
-        err = -errno;
+    int err = sPmemHeap.init(&sPmemDevice, asyncScrub);
+    if (err == 0) {
+        m->pmem_master = sPmemHeap.masterFd();
+        m->pmem_master_base = sPmemHeap.base();
     }
     return err;
 #else
@@ -303,36 +290,13 @@ try_ashmem:
             base = m->pmem_master_base;
             lockState |= private_handle_t::LOCK_STATE_MAPPED;
 
-            offset = sAllocator.allocate(size);
-            if (offset < 0) {
-                // no more pmem memory
-                err = -ENOMEM;
-            } else {
-                struct pmem_region sub = { offset, size };
-                
-                // now create the "sub-heap"
-                fd = open("/dev/pmem", O_RDWR, 0);
-                err = fd < 0 ? fd : 0;
-                
-                // and connect to it
-                if (err == 0)
-                    err = ioctl(fd, PMEM_CONNECT, m->pmem_master);
-
-                // and make it available to the client process
-                if (err == 0)
-                    err = ioctl(fd, PMEM_MAP, &sub);
-
-                if (err < 0) {
-                    err = -errno;
-                    close(fd);
-                    sAllocator.deallocate(offset);
-                    fd = -1;
-                }
-				err = ioctl(fd, PMEM_GET_PHYS, &sub);
-				if(err == 0)
-				pbase = (void*)sub.offset;
-                //LOGD_IF(!err, "allocating pmem size=%d, offset=%d", size, offset);
-                memset((char*)base + offset, 0, size);
+            // the heap hands out zeroed memory through an fd already
+            // connected to the master, so this is just PMEM_MAP
+            size_t pmemOffset;
+            err = sPmemHeap.allocate(size, &fd, &pmemOffset);
+            if (err == 0) {
+                offset = pmemOffset;
+                pbase = (void*)sPmemHeap.phys();
             }
         } else {
             if ((usage & GRALLOC_USAGE_HW_2D) == 0) {
@@ -466,17 +430,11 @@ static int gralloc_free(alloc_device_t* dev,
 #if HAVE_ANDROID_OS
         if (hnd->flags & private_handle_t::PRIV_FLAGS_USES_PMEM) {
             if (hnd->fd >= 0) {
-                struct pmem_region sub = { hnd->offset, hnd->size };
-                int err = ioctl(hnd->fd, PMEM_UNMAP, &sub);
+                // leaks the memory if PMEM_UNMAP fails, see PmemHeap::free
+                int err = sPmemHeap.free(hnd->fd, hnd->offset, hnd->size);
                 LOGE_IF(err<0, "PMEM_UNMAP failed (%s), "
                         "fd=%d, sub.offset=%lu, sub.size=%lu",
-                        strerror(errno), hnd->fd, hnd->offset, hnd->size);
-                if (err == 0) {
-                    // we can't deallocate the memory in case of UNMAP failure
-                    // because it would give that process access to someone else's
-                    // surfaces, which would be a security breach.
-                    sAllocator.deallocate(hnd->offset);
-                }
+                        strerror(-err), hnd->fd, hnd->offset, hnd->size);
             }
         }
 #endif // HAVE_ANDROID_OS
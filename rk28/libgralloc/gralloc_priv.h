@@ -79,7 +79,11 @@ struct private_handle_t {
     enum {
         LOCK_STATE_WRITE     =   1<<31,
         LOCK_STATE_MAPPED    =   1<<30,
-        LOCK_STATE_READ_MASK =   0x3FFFFFFF
+        // a thread is mapping the buffer; others wait for it
+        LOCK_STATE_MAPPING   =   1<<29,
+        // and some of them sleep on the futex at lockState
+        LOCK_STATE_WAITERS   =   1<<28,
+        LOCK_STATE_READ_MASK =   0x0FFFFFFF
     };
 
     // file-descriptors
@@ -0,0 +1,536 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include "luma.h"
+
+/*****************************************************************************/
+
+/*
+ * Output geometry, for a w x h source (out[row][col], in[y][x]):
+ *
+ *   rotation 0:    out[y][x]           = in[y][x]          rows of w/4
+ *   rotation 1:    out[w-1-x][y]       = in[y][x]          rows of h/4
+ *   rotation 2:    out[h-1-y][w-1-x]   = in[y][x]          rows of w/4
+ *   rotation 3:    out[x][h-1-y]       = in[y][x]          rows of h/4
+ *
+ * Every kernel must produce exactly the same nibbles as the scalar one.
+ */
+
+#define RGB2Luma_4bit(r,g,b)        ((77*r+150*g+29*b)>>12)
+
+/*****************************************************************************/
+// scalar kernels, these are the reference implementation
+
+static void RGB565_2_Luma_0(uint16_t *luma, uint16_t const *Src, unsigned int width)
+{
+    unsigned int i;
+    unsigned int r, g, b, g0, g1, g2, g3;
+    unsigned int rgb_data;
+
+    for (i=0; i<width; i++)
+    {
+        rgb_data = *Src++;
+        r = (rgb_data & 0xf800)>>8;
+        g = (rgb_data & 0x07e0)>>3;
+        b = (rgb_data & 0x1f)<<3;
+        g0 = RGB2Luma_4bit(r, g, b);
+
+        rgb_data = *Src++;
+        r = (rgb_data & 0xf800)>>8;
+        g = (rgb_data & 0x07e0)>>3;
+        b = (rgb_data & 0x1f)<<3;
+        g1 = RGB2Luma_4bit(r, g, b);
+
+        rgb_data = *Src++;
+        r = (rgb_data & 0xf800)>>8;
+        g = (rgb_data & 0x07e0)>>3;
+        b = (rgb_data & 0x1f)<<3;
+        g2 = RGB2Luma_4bit(r, g, b);
+
+        rgb_data = *Src++;
+        r = (rgb_data & 0xf800)>>8;
+        g = (rgb_data & 0x07e0)>>3;
+        b = (rgb_data & 0x1f)<<3;
+        g3 = RGB2Luma_4bit(r, g, b);
+        *luma++ = (g0 & 0x0F) | ((g1 & 0xF)<<4) | ((g2 & 0xF)<<8)| ((g3 & 0xF)<<12);
+    }
+}
+
+static void RGB565_2_Luma_90(uint16_t *luma, uint16_t const *Src,
+                unsigned int width, unsigned int height) {
+        unsigned int i;
+        unsigned int r, g, b, g0, g1, g2, g3;
+        unsigned int rgb_data;
+        for (i = 0; i < height; i += 4) {
+                rgb_data = *Src;
+                Src += width;
+                r = (rgb_data & 0xf800) >> 8;
+                g = (rgb_data & 0x07e0) >> 3;
+                b = (rgb_data & 0x001f) << 3;
+                g0 = RGB2Luma_4bit(r, g, b);
+                rgb_data = *Src;
+                Src += width;
+                r = (rgb_data & 0xf800) >> 8;
+                g = (rgb_data & 0x07e0) >> 3;
+                b = (rgb_data & 0x001f) << 3;
+                g1 = RGB2Luma_4bit(r, g, b);
+                rgb_data = *Src;
+                Src += width;
+                r = (rgb_data & 0xf800) >> 8;
+                g = (rgb_data & 0x07e0) >> 3;
+                b = (rgb_data & 0x001f) << 3;
+                g2 = RGB2Luma_4bit(r, g, b);
+                rgb_data = *Src;
+                Src += width;
+                r = (rgb_data & 0xf800) >> 8;
+                g = (rgb_data & 0x07e0) >> 3;
+                b = (rgb_data & 0x001f) << 3;
+                g3 = RGB2Luma_4bit(r, g, b);
+                *luma++ = (g0 & 0xF) | ((g1 & 0xF) << 4) | ((g2 & 0xF) << 8) | ((g3
+                                & 0xF) << 12);
+        }
+}
+
+static void RGB565_2_Luma_180(uint16_t *luma, uint16_t const *Src, unsigned int width)
+{
+    unsigned int i;
+    unsigned int r, g, b, g0, g1, g2, g3;
+    unsigned int rgb_data;
+
+    for (i=0; i<width; i+=4)
+    {
+        rgb_data = *Src--;
+        r = (rgb_data&0xf800)>>8;
+        g = (rgb_data&0x07e0)>>3;
+        b = (rgb_data&0x001f)<<3;
+        g0 = RGB2Luma_4bit(r, g, b);
+
+        rgb_data = *Src--;
+        r = (rgb_data&0xf800)>>8;
+        g = (rgb_data&0x07e0)>>3;
+        b = (rgb_data&0x001f)<<3;
+        g1 = RGB2Luma_4bit(r, g, b);
+
+        rgb_data = *Src--;
+        r = (rgb_data&0xf800)>>8;
+        g = (rgb_data&0x07e0)>>3;
+        b = (rgb_data&0x001f)<<3;
+        g2 = RGB2Luma_4bit(r, g, b);
+
+        rgb_data = *Src--;
+        r = (rgb_data&0xf800)>>8;
+        g = (rgb_data&0x07e0)>>3;
+        b = (rgb_data&0x001f)<<3;
+        g3 = RGB2Luma_4bit(r, g, b);
+        *luma++ = (g0 & 0xF) | ((g1 & 0xF)<<4) | ((g2 & 0xF)<<8)| ((g3 & 0xF)<<12);
+    }
+}
+
+static void RGB565_2_Luma_270(uint16_t *luma, uint16_t const *Src, unsigned int width, unsigned int height)
+{
+    unsigned int i;
+    unsigned int r, g, b, g0, g1, g2, g3;
+    unsigned int rgb_data;
+
+    for (i=0; i<height; i+=4)
+    {
+        rgb_data = *Src;
+        Src -= width;
+        r = (rgb_data&0xf800)>>8;
+        g = (rgb_data&0x07e0)>>3;
+        b = (rgb_data&0x001f)<<3;
+        g0 = RGB2Luma_4bit(r, g, b);
+
+        rgb_data = *Src;
+        Src -= width;
+        r = (rgb_data&0xf800)>>8;
+        g = (rgb_data&0x07e0)>>3;
+        b = (rgb_data&0x001f)<<3;
+        g1 = RGB2Luma_4bit(r, g, b);
+
+        rgb_data = *Src;
+        Src -= width;
+        r = (rgb_data&0xf800)>>8;
+        g = (rgb_data&0x07e0)>>3;
+        b = (rgb_data&0x001f)<<3;
+        g2 = RGB2Luma_4bit(r, g, b);
+
+        rgb_data = *Src;
+        Src -= width;
+        r = (rgb_data&0xf800)>>8;
+        g = (rgb_data&0x07e0)>>3;
+        b = (rgb_data&0x001f)<<3;
+        g3 = RGB2Luma_4bit(r, g, b);
+        *luma++ = (g0 & 0xF) | ((g1 & 0xF)<<4) | ((g2 & 0xF)<<8)| ((g3 & 0xF)<<12);
+    }
+}
+
+static void scalar_rotate_0(uint16_t* luma, uint16_t const* rgb,
+        int w, int h, luma_rect_t const* rc)
+{
+    for (int y=rc->t ; y<rc->b ; y++) {
+        RGB565_2_Luma_0(luma + y*(w>>2) + (rc->l>>2),
+                rgb + y*w + rc->l, (rc->r - rc->l)>>2);
+    }
+}
+
+static void scalar_rotate_90(uint16_t* luma, uint16_t const* rgb,
+        int w, int h, luma_rect_t const* rc)
+{
+    for (int j=w-rc->r ; j<w-rc->l ; j++) {
+        RGB565_2_Luma_90(luma + j*(h>>2) + (rc->t>>2),
+                rgb + rc->t*w + (w-1-j), w, rc->b - rc->t);
+    }
+}
+
+static void scalar_rotate_180(uint16_t* luma, uint16_t const* rgb,
+        int w, int h, luma_rect_t const* rc)
+{
+    for (int j=h-rc->b ; j<h-rc->t ; j++) {
+        RGB565_2_Luma_180(luma + j*(w>>2) + ((w-rc->r)>>2),
+                rgb + (h-1-j)*w + (rc->r-1), rc->r - rc->l);
+    }
+}
+
+static void scalar_rotate_270(uint16_t* luma, uint16_t const* rgb,
+        int w, int h, luma_rect_t const* rc)
+{
+    for (int j=rc->l ; j<rc->r ; j++) {
+        RGB565_2_Luma_270(luma + j*(h>>2) + ((h-rc->b)>>2),
+                rgb + (rc->b-1)*w + j, w, rc->b - rc->t);
+    }
+}
+
+/*****************************************************************************/
+// SWAR kernels: four RGB565 pixels per 64-bit word, little-endian only.
+//
+// With r,g,b expanded to 8 bits the weighted sum peaks at 64088, so each
+// 16-bit lane can be multiplied in place without spilling into its
+// neighbour and the whole word goes through the scalar formula at once.
+
+static const uint64_t kLaneR    = 0x00F800F800F800F8ULL;
+static const uint64_t kLaneG    = 0x00FC00FC00FC00FCULL;
+static const uint64_t kLaneB    = 0x00F800F800F800F8ULL;
+static const uint64_t kLaneLuma = 0x000F000F000F000FULL;
+
+// columns processed per pass by the rotating kernels
+static const int kStrip = 32;
+
+static inline uint64_t swar_load(uint16_t const* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t swar_luma4(uint64_t p) {
+    uint64_t r = (p >> 8) & kLaneR;
+    uint64_t g = (p >> 3) & kLaneG;
+    uint64_t b = (p << 3) & kLaneB;
+    return ((r*77 + g*150 + b*29) >> 12) & kLaneLuma;
+}
+
+// lanes 0..3 into nibbles 0..3
+static inline uint16_t swar_pack(uint64_t y) {
+    y |= y >> 12;
+    y |= y >> 24;
+    return uint16_t(y);
+}
+
+// lanes 3..0 into nibbles 0..3
+static inline uint16_t swar_pack_reversed(uint64_t y) {
+    return uint16_t((y >> 48) | (y >> 28) | (y >> 8) | (y << 12));
+}
+
+static inline void swar_scatter(uint16_t* dst, int stride, uint64_t c) {
+    // lane i goes to dst + i*stride
+    dst[0]        = uint16_t(c);
+    dst[stride]   = uint16_t(c >> 16);
+    dst[stride*2] = uint16_t(c >> 32);
+    dst[stride*3] = uint16_t(c >> 48);
+}
+
+static void swar_rotate_0(uint16_t* luma, uint16_t const* rgb,
+        int w, int h, luma_rect_t const* rc)
+{
+    for (int y=rc->t ; y<rc->b ; y++) {
+        uint16_t const* s = rgb + y*w + rc->l;
+        uint16_t* d = luma + y*(w>>2) + (rc->l>>2);
+        for (int x=rc->l ; x<rc->r ; x+=4, s+=4) {
+            *d++ = swar_pack(swar_luma4(swar_load(s)));
+        }
+    }
+}
+
+static void swar_rotate_180(uint16_t* luma, uint16_t const* rgb,
+        int w, int h, luma_rect_t const* rc)
+{
+    for (int y=rc->t ; y<rc->b ; y++) {
+        uint16_t const* s = rgb + y*w + rc->r - 4;
+        uint16_t* d = luma + (h-1-y)*(w>>2) + ((w-rc->r)>>2);
+        for (int x=rc->l ; x<rc->r ; x+=4, s-=4) {
+            *d++ = swar_pack_reversed(swar_luma4(swar_load(s)));
+        }
+    }
+}
+
+/*
+ * The 90/270 kernels read 4x4 tiles with contiguous loads instead of
+ * walking the source column by column. Packing the four rows of a tile
+ * nibble-wise leaves, in each 16-bit lane, the output word for that
+ * column, which is then scattered to its destination row. Tiles are
+ * visited in vertical strips so both sides stay cache resident.
+ */
+static void swar_rotate_90(uint16_t* luma, uint16_t const* rgb,
+        int w, int h, luma_rect_t const* rc)
+{
+    const int stride = h>>2;
+    for (int x0=rc->l ; x0<rc->r ; x0+=kStrip) {
+        const int x1 = (x0+kStrip < rc->r) ? x0+kStrip : rc->r;
+        for (int y=rc->t ; y<rc->b ; y+=4) {
+            uint16_t const* s = rgb + y*w;
+            for (int x=x0 ; x<x1 ; x+=4) {
+                uint64_t c = swar_luma4(swar_load(s + x));
+                c |= swar_luma4(swar_load(s + w   + x)) << 4;
+                c |= swar_luma4(swar_load(s + w*2 + x)) << 8;
+                c |= swar_luma4(swar_load(s + w*3 + x)) << 12;
+                // column x+i lands on row w-1-x-i
+                swar_scatter(luma + (w-1-x)*stride + (y>>2), -stride, c);
+            }
+        }
+    }
+}
+
+static void swar_rotate_270(uint16_t* luma, uint16_t const* rgb,
+        int w, int h, luma_rect_t const* rc)
+{
+    const int stride = h>>2;
+    for (int x0=rc->l ; x0<rc->r ; x0+=kStrip) {
+        const int x1 = (x0+kStrip < rc->r) ? x0+kStrip : rc->r;
+        for (int y=rc->t ; y<rc->b ; y+=4) {
+            uint16_t const* s = rgb + y*w;
+            for (int x=x0 ; x<x1 ; x+=4) {
+                uint64_t c = swar_luma4(swar_load(s + w*3 + x));
+                c |= swar_luma4(swar_load(s + w*2 + x)) << 4;
+                c |= swar_luma4(swar_load(s + w   + x)) << 8;
+                c |= swar_luma4(swar_load(s       + x)) << 12;
+                // column x+i lands on row x+i
+                swar_scatter(luma + x*stride + ((h-4-y)>>2), stride, c);
+            }
+        }
+    }
+}
+
+/*****************************************************************************/
+// NEON kernels: eight pixels per q register, SWAR for the leftovers.
+
+#if defined(__ARM_NEON__)
+
+static inline uint16x8_t neon_luma8(uint16x8_t p) {
+    uint16x8_t r = vandq_u16(vshrq_n_u16(p, 8), vdupq_n_u16(0xF8));
+    uint16x8_t g = vandq_u16(vshrq_n_u16(p, 3), vdupq_n_u16(0xFC));
+    uint16x8_t b = vandq_u16(vshlq_n_u16(p, 3), vdupq_n_u16(0xF8));
+    uint16x8_t y = vmulq_n_u16(r, 77);
+    y = vmlaq_n_u16(y, g, 150);
+    y = vmlaq_n_u16(y, b, 29);
+    return vshrq_n_u16(y, 12);
+}
+
+static inline uint16x8_t neon_reverse(uint16x8_t v) {
+    v = vrev64q_u16(v);
+    return vcombine_u16(vget_high_u16(v), vget_low_u16(v));
+}
+
+// 16 lumas in pixel order into 4 output words
+static inline void neon_pack16(uint16_t* d, uint16x8_t a, uint16x8_t b) {
+    uint16x8x2_t u = vuzpq_u16(a, b);
+    uint16x8_t pairs = vorrq_u16(u.val[0], vshlq_n_u16(u.val[1], 4));
+    vst1_u16(d, vreinterpret_u16_u8(vmovn_u16(pairs)));
+}
+
+static inline uint16x8_t neon_tile(uint16_t const* s0, uint16_t const* s1,
+        uint16_t const* s2, uint16_t const* s3) {
+    uint16x8_t c = neon_luma8(vld1q_u16(s0));
+    c = vorrq_u16(c, vshlq_n_u16(neon_luma8(vld1q_u16(s1)), 4));
+    c = vorrq_u16(c, vshlq_n_u16(neon_luma8(vld1q_u16(s2)), 8));
+    c = vorrq_u16(c, vshlq_n_u16(neon_luma8(vld1q_u16(s3)), 12));
+    return c;
+}
+
+static inline void neon_scatter(uint16_t* d, int stride, uint16x8_t c) {
+    vst1q_lane_u16(d,          c, 0);
+    vst1q_lane_u16(d+stride,   c, 1);
+    vst1q_lane_u16(d+stride*2, c, 2);
+    vst1q_lane_u16(d+stride*3, c, 3);
+    vst1q_lane_u16(d+stride*4, c, 4);
+    vst1q_lane_u16(d+stride*5, c, 5);
+    vst1q_lane_u16(d+stride*6, c, 6);
+    vst1q_lane_u16(d+stride*7, c, 7);
+}
+
+static void neon_rotate_0(uint16_t* luma, uint16_t const* rgb,
+        int w, int h, luma_rect_t const* rc)
+{
+    for (int y=rc->t ; y<rc->b ; y++) {
+        uint16_t const* s = rgb + y*w + rc->l;
+        uint16_t* d = luma + y*(w>>2) + (rc->l>>2);
+        int x = rc->l;
+        for ( ; x+16<=rc->r ; x+=16, s+=16, d+=4) {
+            neon_pack16(d, neon_luma8(vld1q_u16(s)), neon_luma8(vld1q_u16(s+8)));
+        }
+        for ( ; x<rc->r ; x+=4, s+=4) {
+            *d++ = swar_pack(swar_luma4(swar_load(s)));
+        }
+    }
+}
+
+static void neon_rotate_180(uint16_t* luma, uint16_t const* rgb,
+        int w, int h, luma_rect_t const* rc)
+{
+    for (int y=rc->t ; y<rc->b ; y++) {
+        uint16_t const* s = rgb + y*w + rc->r;
+        uint16_t* d = luma + (h-1-y)*(w>>2) + ((w-rc->r)>>2);
+        int x = rc->l;
+        for ( ; x+16<=rc->r ; x+=16, d+=4) {
+            s -= 16;
+            uint16x8_t lo = neon_luma8(vld1q_u16(s));
+            uint16x8_t hi = neon_luma8(vld1q_u16(s+8));
+            neon_pack16(d, neon_reverse(hi), neon_reverse(lo));
+        }
+        for ( ; x<rc->r ; x+=4) {
+            s -= 4;
+            *d++ = swar_pack_reversed(swar_luma4(swar_load(s)));
+        }
+    }
+}
+
+static void neon_rotate_90(uint16_t* luma, uint16_t const* rgb,
+        int w, int h, luma_rect_t const* rc)
+{
+    const int stride = h>>2;
+    for (int x0=rc->l ; x0<rc->r ; x0+=kStrip) {
+        const int x1 = (x0+kStrip < rc->r) ? x0+kStrip : rc->r;
+        for (int y=rc->t ; y<rc->b ; y+=4) {
+            uint16_t const* s = rgb + y*w;
+            uint16_t* d = luma + (y>>2);
+            int x = x0;
+            for ( ; x+8<=x1 ; x+=8) {
+                uint16x8_t c = neon_tile(s+x, s+w+x, s+w*2+x, s+w*3+x);
+                neon_scatter(d + (w-1-x)*stride, -stride, c);
+            }
+            for ( ; x<x1 ; x+=4) {
+                uint64_t c = swar_luma4(swar_load(s + x));
+                c |= swar_luma4(swar_load(s + w   + x)) << 4;
+                c |= swar_luma4(swar_load(s + w*2 + x)) << 8;
+                c |= swar_luma4(swar_load(s + w*3 + x)) << 12;
+                swar_scatter(d + (w-1-x)*stride, -stride, c);
+            }
+        }
+    }
+}
+
+static void neon_rotate_270(uint16_t* luma, uint16_t const* rgb,
+        int w, int h, luma_rect_t const* rc)
+{
+    const int stride = h>>2;
+    for (int x0=rc->l ; x0<rc->r ; x0+=kStrip) {
+        const int x1 = (x0+kStrip < rc->r) ? x0+kStrip : rc->r;
+        for (int y=rc->t ; y<rc->b ; y+=4) {
+            uint16_t const* s = rgb + y*w;
+            uint16_t* d = luma + ((h-4-y)>>2);
+            int x = x0;
+            for ( ; x+8<=x1 ; x+=8) {
+                uint16x8_t c = neon_tile(s+w*3+x, s+w*2+x, s+w+x, s+x);
+                neon_scatter(d + x*stride, stride, c);
+            }
+            for ( ; x<x1 ; x+=4) {
+                uint64_t c = swar_luma4(swar_load(s + w*3 + x));
+                c |= swar_luma4(swar_load(s + w*2 + x)) << 4;
+                c |= swar_luma4(swar_load(s + w   + x)) << 8;
+                c |= swar_luma4(swar_load(s       + x)) << 12;
+                swar_scatter(d + x*stride, stride, c);
+            }
+        }
+    }
+}
+
+#endif // __ARM_NEON__
+
+/*****************************************************************************/
+
+static const luma_engine_t sEngines[] = {
+    { "scalar", { scalar_rotate_0, scalar_rotate_90,
+                  scalar_rotate_180, scalar_rotate_270 } },
+    { "swar",   { swar_rotate_0, swar_rotate_90,
+                  swar_rotate_180, swar_rotate_270 } },
+#if defined(__ARM_NEON__)
+    { "neon",   { neon_rotate_0, neon_rotate_90,
+                  neon_rotate_180, neon_rotate_270 } },
+#endif
+};
+
+static const int sNumEngines = sizeof(sEngines) / sizeof(sEngines[0]);
+
+int luma_engine_count()
+{
+    return sNumEngines;
+}
+
+luma_engine_t const* luma_engine_at(int index)
+{
+    if (index < 0 || index >= sNumEngines)
+        return NULL;
+    return &sEngines[index];
+}
+
+luma_engine_t const* luma_engine_get(const char* name)
+{
+    if (name) {
+        for (int i=0 ; i<sNumEngines ; i++) {
+            if (!strcmp(sEngines[i].name, name))
+                return &sEngines[i];
+        }
+    }
+    return &sEngines[sNumEngines-1];
+}
+
+void luma_convert(luma_engine_t const* engine, int rotation,
+        uint16_t* luma, uint16_t const* rgb, int w, int h,
+        luma_rect_t const* rect)
+{
+    luma_rect_t rc = { 0, 0, w, h };
+    if (rect) {
+        // clip, then widen to the 4x4 grid the output is packed on
+        rc = *rect;
+        if (rc.l < 0) rc.l = 0;
+        if (rc.t < 0) rc.t = 0;
+        if (rc.r > w) rc.r = w;
+        if (rc.b > h) rc.b = h;
+        if (luma_rect_is_empty(rc))
+            return;
+        rc.l &= ~3;
+        rc.t &= ~3;
+        rc.r = (rc.r + 3) & ~3;
+        rc.b = (rc.b + 3) & ~3;
+    }
+    engine->rotate[rotation & 3](luma, rgb, w, h, &rc);
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GRALLOC_LUMA_H_
+#define GRALLOC_LUMA_H_
+
+#include <stdint.h>
+
+/*****************************************************************************/
+
+/*
+ * RGB565 to 4-bit luma conversion for the e-ink panel.
+ *
+ * The source is a w x h RGB565 buffer; the destination packs four luma
+ * nibbles per uint16_t and is laid out according to the panel rotation
+ * (0, 90, 180 or 270 degrees, encoded 0..3 like fb_var_screeninfo.rotate).
+ * w and h must both be multiples of 4.
+ *
+ * Conversions can be restricted to a damage rectangle expressed in source
+ * coordinates; it is widened to the 4-pixel grid before being converted.
+ */
+
+struct luma_rect_t {
+    int l, t, r, b;     // right/bottom exclusive
+};
+
+typedef void (*luma_rotate_fn)(uint16_t* luma, uint16_t const* rgb,
+        int w, int h, luma_rect_t const* rect);
+
+struct luma_engine_t {
+    const char*     name;
+    // one kernel per rotation, called with a clipped, 4-aligned rect
+    luma_rotate_fn  rotate[4];
+};
+
+/* number of engines available on this build, best one last */
+int luma_engine_count();
+luma_engine_t const* luma_engine_at(int index);
+
+/* engine by name ("scalar", "swar", "neon"), or the best one if name is
+ * NULL or unknown */
+luma_engine_t const* luma_engine_get(const char* name);
+
+/* converts the part of 'rgb' covered by 'rect' (the whole frame if NULL) */
+void luma_convert(luma_engine_t const* engine, int rotation,
+        uint16_t* luma, uint16_t const* rgb, int w, int h,
+        luma_rect_t const* rect);
+
+/*****************************************************************************/
+
+inline bool luma_rect_is_empty(luma_rect_t const& r) {
+    return (r.l >= r.r) || (r.t >= r.b);
+}
+
+inline void luma_rect_set_empty(luma_rect_t& r) {
+    r.l = r.t = r.r = r.b = 0;
+}
+
+inline void luma_rect_union(luma_rect_t& dst, luma_rect_t const& src) {
+    if (luma_rect_is_empty(src))
+        return;
+    if (luma_rect_is_empty(dst)) {
+        dst = src;
+        return;
+    }
+    if (src.l < dst.l) dst.l = src.l;
+    if (src.t < dst.t) dst.t = src.t;
+    if (src.r > dst.r) dst.r = src.r;
+    if (src.b > dst.b) dst.b = src.b;
+}
+
+#endif /* GRALLOC_LUMA_H_ */
@@ -19,11 +19,15 @@
 #include <pthread.h>
 #include <unistd.h>
 #include <string.h>
+#include <sched.h>
 
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 
+#include <linux/futex.h>
+
 #include <cutils/log.h>
 #include <cutils/atomic.h>
 
@@ -31,6 +35,7 @@
 #include <hardware/gralloc.h>
 
 #include "gralloc_priv.h"
+#include "gr.h"
 
 
 // we need this for now because pmem cannot mmap at an offset
@@ -92,7 +97,113 @@ static int gralloc_unmap(gralloc_module_t const* module,
 
 /*****************************************************************************/
 
-static pthread_mutex_t sMapLock = PTHREAD_MUTEX_INITIALIZER; 
+/*
+ * lockState only ever changes by compare-and-swap, and a failed swap means
+ * another thread's update went through, so lock and unlock never wait on
+ * one another: they retry, giving up the CPU after LOCK_SPINS failures in
+ * a row in case the other thread was preempted. Conflicting locks fail
+ * with -EBUSY as before.
+ *
+ * Mapping is where a thread may have to wait. The first thread to lock a
+ * buffer for software access claims LOCK_STATE_MAPPING and mmaps it; the
+ * others spin for MAP_SPINS rounds, then set LOCK_STATE_WAITERS and sleep
+ * on the futex at lockState until the mapper is done. Each buffer maps on
+ * its own, there is no global map lock.
+ */
+
+enum {
+    LOCK_SPINS  = 16,
+    MAP_SPINS   = 100,
+};
+
+static gralloc_lock_stats_t sLockStats;
+
+static inline void count(int32_t* counter)
+{
+    android_atomic_inc(counter);
+}
+
+static inline void backoff(int* spins)
+{
+    if (++*spins >= LOCK_SPINS) {
+        count(&sLockStats.yields);
+        sched_yield();
+        *spins = 0;
+    }
+}
+
+static inline void futex_wait(volatile int32_t* addr, int32_t value)
+{
+    syscall(__NR_futex, addr, FUTEX_WAIT, value, NULL, NULL, 0);
+}
+
+static inline void futex_wake_all(volatile int32_t* addr)
+{
+    syscall(__NR_futex, addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+static int gralloc_map_shared(gralloc_module_t const* module,
+        private_handle_t* hnd)
+{
+    volatile int32_t* state = (volatile int32_t*)&hnd->lockState;
+    bool waited = false;
+    int spins = 0;
+
+    for (;;) {
+        int32_t current_value = *state;
+        if (current_value & private_handle_t::LOCK_STATE_MAPPED)
+            return 0;
+
+        if (!(current_value & private_handle_t::LOCK_STATE_MAPPING)) {
+            if (android_atomic_cmpxchg(current_value,
+                    current_value | private_handle_t::LOCK_STATE_MAPPING,
+                    state)) {
+                count(&sLockStats.retries);
+                continue;
+            }
+
+            void* vaddr;
+            int err = gralloc_map(module, hnd, &vaddr);
+            if (err == 0)
+                count(&sLockStats.maps);
+
+            // publish hnd->base, and let the waiters in either way; after
+            // a failure the next one tries to map it itself
+            int32_t new_value;
+            do {
+                current_value = *state;
+                new_value = current_value & ~(private_handle_t::LOCK_STATE_MAPPING |
+                        private_handle_t::LOCK_STATE_WAITERS);
+                if (err == 0)
+                    new_value |= private_handle_t::LOCK_STATE_MAPPED;
+            } while (android_atomic_cmpxchg(current_value, new_value, state));
+            if (current_value & private_handle_t::LOCK_STATE_WAITERS)
+                futex_wake_all(state);
+            return err;
+        }
+
+        // another thread is mapping it
+        if (!waited) {
+            count(&sLockStats.mapWaits);
+            waited = true;
+        }
+        if (spins++ < MAP_SPINS)
+            continue;
+        if (!(current_value & private_handle_t::LOCK_STATE_WAITERS) &&
+                android_atomic_cmpxchg(current_value,
+                        current_value | private_handle_t::LOCK_STATE_WAITERS,
+                        state)) {
+            continue;
+        }
+        count(&sLockStats.mapSleeps);
+        futex_wait(state, current_value | private_handle_t::LOCK_STATE_WAITERS);
+    }
+}
+
+void gralloc_get_lock_stats(gralloc_lock_stats_t* stats)
+{
+    *stats = sLockStats;
+}
 
 /*****************************************************************************/
 
@@ -178,6 +289,9 @@ int terminateBuffer(gralloc_module_t const* module,
     return 0;
 }
 
+int gralloc_unlock(gralloc_module_t const* module,
+        buffer_handle_t handle);
+
 int gralloc_lock(gralloc_module_t const* module,
         buffer_handle_t handle, int usage,
         int l, int t, int w, int h,
@@ -189,19 +303,21 @@ int gralloc_lock(gralloc_module_t const* module,
     int err = 0;
     private_handle_t* hnd = (private_handle_t*)handle;
     int32_t current_value, new_value;
-    int retry;
+    int spins = 0;
 
-    do {
+    for (;;) {
         current_value = hnd->lockState;
         new_value = current_value;
 
         if (current_value & private_handle_t::LOCK_STATE_WRITE) {
             // already locked for write 
+            count(&sLockStats.busy);
             LOGE("handle %p already locked for write", handle);
             return -EBUSY;
         } else if (current_value & private_handle_t::LOCK_STATE_READ_MASK) {
             // already locked for read
             if (usage & (GRALLOC_USAGE_SW_WRITE_MASK | GRALLOC_USAGE_HW_RENDER)) {
+                count(&sLockStats.busy);
                 LOGE("handle %p already locked for read", handle);
                 return -EBUSY;
             } else {
@@ -218,9 +334,13 @@ int gralloc_lock(gralloc_module_t const* module,
         }
         new_value++;
 
-        retry = android_atomic_cmpxchg(current_value, new_value, 
-                (volatile int32_t*)&hnd->lockState);
-    } while (retry);
+        if (!android_atomic_cmpxchg(current_value, new_value, 
+                (volatile int32_t*)&hnd->lockState)) {
+            break;
+        }
+        count(&sLockStats.retries);
+        backoff(&spins);
+    }
 
     if (new_value & private_handle_t::LOCK_STATE_WRITE) {
         // locking for write, store the tid
@@ -229,17 +349,13 @@ int gralloc_lock(gralloc_module_t const* module,
 
     if (usage & (GRALLOC_USAGE_SW_READ_MASK | GRALLOC_USAGE_SW_WRITE_MASK)) {
         if (!(current_value & private_handle_t::LOCK_STATE_MAPPED)) {
-            // we need to map for real
-            pthread_mutex_t* const lock = &sMapLock;
-            pthread_mutex_lock(lock);
-            if (!(hnd->lockState & private_handle_t::LOCK_STATE_MAPPED)) {
-                err = gralloc_map(module, handle, vaddr);
-                if (err == 0) {
-                    android_atomic_or(private_handle_t::LOCK_STATE_MAPPED,
-                            (volatile int32_t*)&(hnd->lockState));
-                }
+            // we need to map for real, unless someone beats us to it
+            err = gralloc_map_shared(module, hnd);
+            if (err) {
+                // the caller won't unlock a buffer it failed to lock
+                gralloc_unlock(module, handle);
+                return err;
             }
-            pthread_mutex_unlock(lock);
         }
         *vaddr = (void*)hnd->base;
     }
@@ -255,8 +371,9 @@ int gralloc_unlock(gralloc_module_t const* module,
 
     private_handle_t* hnd = (private_handle_t*)handle;
     int32_t current_value, new_value;
+    int spins = 0;
 
-    do {
+    for (;;) {
         current_value = hnd->lockState;
         new_value = current_value;
 
@@ -275,8 +392,13 @@ int gralloc_unlock(gralloc_module_t const* module,
 
         new_value--;
 
-    } while (android_atomic_cmpxchg(current_value, new_value, 
-            (volatile int32_t*)&hnd->lockState));
+        if (!android_atomic_cmpxchg(current_value, new_value, 
+                (volatile int32_t*)&hnd->lockState)) {
+            break;
+        }
+        count(&sLockStats.retries);
+        backoff(&spins);
+    }
 
     return 0;
 }
@@ -0,0 +1,344 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#include <cutils/log.h>
+
+#include "pmem.h"
+
+#if HAVE_ANDROID_OS
+#include <linux/android_pmem.h>
+#endif
+
+/*****************************************************************************/
+
+#if HAVE_ANDROID_OS
+
+int AndroidPmemDevice::openMaster(size_t* size, void** base, size_t* phys)
+{
+    int fd = open("/dev/pmem", O_RDWR, 0);
+    if (fd < 0)
+        return -errno;
+
+    pmem_region region;
+    if (ioctl(fd, PMEM_GET_TOTAL_SIZE, &region) < 0) {
+        LOGE("PMEM_GET_TOTAL_SIZE failed, limp mode");
+        *size = 8<<20;   // 8 MiB
+    } else {
+        *size = region.len;
+    }
+
+    void* b = mmap(0, *size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    if (b == MAP_FAILED) {
+        int err = -errno;
+        close(fd);
+        return err;
+    }
+
+    // connected fds report the master's allocation, so this is the same
+    // for every buffer
+    if (ioctl(fd, PMEM_GET_PHYS, &region) < 0) {
+        LOGE("PMEM_GET_PHYS failed (%s)", strerror(errno));
+        region.offset = 0;
+    }
+    *base = b;
+    *phys = region.offset;
+    return fd;
+}
+
+int AndroidPmemDevice::connect(int master)
+{
+    int fd = open("/dev/pmem", O_RDWR, 0);
+    if (fd < 0)
+        return -errno;
+    if (ioctl(fd, PMEM_CONNECT, master) < 0) {
+        int err = -errno;
+        close(fd);
+        return err;
+    }
+    return fd;
+}
+
+int AndroidPmemDevice::map(int fd, size_t offset, size_t size)
+{
+    struct pmem_region sub = { offset, size };
+    return ioctl(fd, PMEM_MAP, &sub) < 0 ? -errno : 0;
+}
+
+int AndroidPmemDevice::unmap(int fd, size_t offset, size_t size)
+{
+    struct pmem_region sub = { offset, size };
+    return ioctl(fd, PMEM_UNMAP, &sub) < 0 ? -errno : 0;
+}
+
+#endif // HAVE_ANDROID_OS
+
+/*****************************************************************************/
+
+PmemHeap::PmemHeap()
+    : mDevice(0), mMaster(-1), mBase(0), mSize(0), mPhys(0), mAsync(false),
+      mRunning(false), mExit(false), mJobHead(0), mJobCount(0),
+      mGeneration(0), mFdCount(0)
+{
+    pthread_mutex_init(&mLock, 0);
+    pthread_cond_init(&mWork, 0);
+    pthread_cond_init(&mDone, 0);
+    memset(&mStats, 0, sizeof(mStats));
+}
+
+PmemHeap::~PmemHeap()
+{
+    if (mRunning) {
+        pthread_mutex_lock(&mLock);
+        mExit = true;
+        pthread_cond_signal(&mWork);
+        pthread_mutex_unlock(&mLock);
+        pthread_join(mThread, 0);
+    }
+    while (mFdCount)
+        close(mFds[--mFdCount]);
+    pthread_cond_destroy(&mDone);
+    pthread_cond_destroy(&mWork);
+    pthread_mutex_destroy(&mLock);
+}
+
+int PmemHeap::init(PmemDevice* device, bool asyncScrub)
+{
+    int fd = device->openMaster(&mSize, &mBase, &mPhys);
+    if (fd < 0)
+        return fd;
+    mDevice = device;
+    mMaster = fd;
+    mAllocator.setSize(mSize);
+
+    if (!asyncScrub)
+        return 0;
+    if (pthread_create(&mThread, 0, scrubThread, this)) {
+        LOGE("couldn't start the PMEM scrubber, zeroing on allocation");
+        return 0;
+    }
+    mRunning = true;
+    mAsync = true;
+
+    // nothing is known to be zero yet, so the whole heap goes through the
+    // scrubber once
+    size_t slice = INIT_SLICE;
+    if (slice < mSize / (MAX_JOBS/2))
+        slice = roundUpToPageSize(mSize / (MAX_JOBS/2));
+    allocator_stats_t stats;
+    mAllocator.getStats(&stats);
+    while (stats.largestFree) {
+        size_t size = stats.largestFree < slice ? stats.largestFree : slice;
+        ssize_t offset = mAllocator.allocate(size);
+        if (offset < 0)
+            break;
+        if (!queueScrub(offset, size))
+            scrubNow(offset, size);
+        mAllocator.getStats(&stats);
+    }
+    return 0;
+}
+
+int PmemHeap::allocate(size_t size, int* pFd, size_t* pOffset)
+{
+    ssize_t offset;
+
+    if (mAsync) {
+        pthread_mutex_lock(&mLock);
+        uint32_t generation = mGeneration;
+        pthread_mutex_unlock(&mLock);
+        while ((offset = mAllocator.allocate(size)) < 0) {
+            // memory on its way back from the scrubber may be enough
+            pthread_mutex_lock(&mLock);
+            if (generation == mGeneration) {
+                if (mStats.scrubPending == 0) {
+                    pthread_mutex_unlock(&mLock);
+                    break;
+                }
+                mStats.waits++;
+                while (generation == mGeneration)
+                    pthread_cond_wait(&mDone, &mLock);
+            }
+            generation = mGeneration;
+            pthread_mutex_unlock(&mLock);
+        }
+    } else {
+        offset = mAllocator.allocate(size);
+    }
+    if (offset < 0)
+        return -ENOMEM;
+
+    int fd = takeFd();
+    int err = fd < 0 ? fd : mDevice->map(fd, offset, size);
+    if (err < 0) {
+        if (fd >= 0)
+            close(fd);
+        // never handed out, so still clean
+        mAllocator.deallocate(offset);
+        return err;
+    }
+
+    if (!mAsync) {
+        memset((char*)mBase + offset, 0, size);
+        pthread_mutex_lock(&mLock);
+        mStats.syncScrubs++;
+        pthread_mutex_unlock(&mLock);
+    }
+    *pFd = fd;
+    *pOffset = offset;
+    return 0;
+}
+
+int PmemHeap::free(int fd, size_t offset, size_t size)
+{
+    int err = mDevice->unmap(fd, offset, size);
+    if (err < 0) {
+        // we can't deallocate the memory in case of UNMAP failure
+        // because it would give that process access to someone else's
+        // surfaces, which would be a security breach.
+        return err;
+    }
+    if (!mAsync) {
+        mAllocator.deallocate(offset);
+    } else if (!queueScrub(offset, size)) {
+        scrubNow(offset, size);
+    }
+    return 0;
+}
+
+void PmemHeap::flush()
+{
+    pthread_mutex_lock(&mLock);
+    while (mStats.scrubPending)
+        pthread_cond_wait(&mDone, &mLock);
+    pthread_mutex_unlock(&mLock);
+}
+
+void PmemHeap::getStats(pmem_heap_stats_t* stats) const
+{
+    pthread_mutex_lock(&mLock);
+    *stats = mStats;
+    pthread_mutex_unlock(&mLock);
+}
+
+void PmemHeap::getAllocatorStats(allocator_stats_t* stats) const
+{
+    mAllocator.getStats(stats);
+}
+
+/*****************************************************************************/
+
+bool PmemHeap::queueScrub(size_t offset, size_t size)
+{
+    pthread_mutex_lock(&mLock);
+    if (mJobCount == MAX_JOBS) {
+        pthread_mutex_unlock(&mLock);
+        return false;
+    }
+    job_t& job = mJobs[(mJobHead + mJobCount) % MAX_JOBS];
+    job.offset = offset;
+    job.size = size;
+    mJobCount++;
+    mStats.scrubPending += size;
+    pthread_cond_signal(&mWork);
+    pthread_mutex_unlock(&mLock);
+    return true;
+}
+
+void PmemHeap::scrubNow(size_t offset, size_t size)
+{
+    memset((char*)mBase + offset, 0, size);
+    mAllocator.deallocate(offset);
+    pthread_mutex_lock(&mLock);
+    mStats.syncScrubs++;
+    pthread_mutex_unlock(&mLock);
+}
+
+int PmemHeap::takeFd()
+{
+    int fd = -1;
+    pthread_mutex_lock(&mLock);
+    if (mFdCount) {
+        fd = mFds[--mFdCount];
+        mStats.connectHits++;
+        pthread_cond_signal(&mWork);
+    } else {
+        mStats.connectMisses++;
+    }
+    pthread_mutex_unlock(&mLock);
+    if (fd < 0)
+        fd = mDevice->connect(mMaster);
+    return fd;
+}
+
+void* PmemHeap::scrubThread(void* arg)
+{
+    // ANDROID_PRIORITY_BACKGROUND: zeroing must not steal the CPU from
+    // the threads drawing into the buffers
+    setpriority(PRIO_PROCESS, 0, 10);
+    static_cast<PmemHeap*>(arg)->scrubLoop();
+    return 0;
+}
+
+void PmemHeap::scrubLoop()
+{
+    bool connectFailed = false;
+
+    pthread_mutex_lock(&mLock);
+    while (!mExit) {
+        if (mJobCount) {
+            job_t job = mJobs[mJobHead];
+            mJobHead = (mJobHead + 1) % MAX_JOBS;
+            mJobCount--;
+            pthread_mutex_unlock(&mLock);
+
+            memset((char*)mBase + job.offset, 0, job.size);
+            mAllocator.deallocate(job.offset);
+
+            pthread_mutex_lock(&mLock);
+            mStats.scrubPending -= job.size;
+            mStats.scrubbed++;
+            mGeneration++;
+            pthread_cond_broadcast(&mDone);
+            continue;
+        }
+        // only this thread adds fds, so there is still room after connect()
+        if (mFdCount < SPARE_FDS && !connectFailed) {
+            pthread_mutex_unlock(&mLock);
+            int fd = mDevice->connect(mMaster);
+            pthread_mutex_lock(&mLock);
+            if (fd >= 0) {
+                mFds[mFdCount++] = fd;
+            } else {
+                // try again when an fd is taken
+                LOGE("couldn't connect a spare PMEM fd (%s)", strerror(-fd));
+                connectFailed = true;
+            }
+            continue;
+        }
+        pthread_cond_wait(&mWork, &mLock);
+        connectFailed = false;
+    }
+    pthread_mutex_unlock(&mLock);
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GRALLOC_PMEM_H_
+#define GRALLOC_PMEM_H_
+
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "allocator.h"
+
+// ----------------------------------------------------------------------------
+
+/*
+ * The PMEM driver calls the heap makes. The tests run the heap against a
+ * simulated device on the host.
+ */
+class PmemDevice
+{
+public:
+    virtual ~PmemDevice() { }
+
+    // opens and maps the whole PMEM area; returns the master fd or -errno
+    virtual int     openMaster(size_t* size, void** base, size_t* phys) = 0;
+    // a new fd connected to the master, ready to map(); or -errno
+    virtual int     connect(int master) = 0;
+    virtual int     map(int fd, size_t offset, size_t size) = 0;
+    virtual int     unmap(int fd, size_t offset, size_t size) = 0;
+};
+
+#if HAVE_ANDROID_OS
+class AndroidPmemDevice : public PmemDevice
+{
+public:
+    virtual int     openMaster(size_t* size, void** base, size_t* phys);
+    virtual int     connect(int master);
+    virtual int     map(int fd, size_t offset, size_t size);
+    virtual int     unmap(int fd, size_t offset, size_t size);
+};
+#endif
+
+// ----------------------------------------------------------------------------
+
+struct pmem_heap_stats_t {
+    size_t      scrubPending;   // freed bytes not yet zeroed
+    uint32_t    scrubbed;       // chunks zeroed by the scrubber thread
+    uint32_t    syncScrubs;     // chunks zeroed by the caller
+    uint32_t    waits;          // allocations that waited for the scrubber
+    uint32_t    connectHits;    // allocations given an already connected fd
+    uint32_t    connectMisses;
+};
+
+/*
+ * The gralloc PMEM heap: the master mapping, the allocator carving it up,
+ * and the per-buffer fds the clients map their buffer through.
+ *
+ * New buffers must read as zero. With async scrubbing a freed chunk goes
+ * back to the allocator only after a background thread has zeroed it (the
+ * whole heap is queued that way at init), so anything the allocator hands
+ * out is already clean. An allocation that finds the heap full while
+ * chunks are waiting to be zeroed waits for them rather than failing.
+ * Without it every new buffer is zeroed on the spot, as before.
+ *
+ * The same thread keeps a few fds opened and connected to the master, so
+ * an allocation only needs PMEM_MAP. The physical address of the area is
+ * read once at init.
+ */
+class PmemHeap
+{
+public:
+
+    PmemHeap();
+    ~PmemHeap();
+
+    // returns 0 or -errno. The device must outlive the heap, and the master
+    // fd and mapping are never released, as before.
+    int         init(PmemDevice* device, bool asyncScrub);
+
+    int         masterFd() const { return mMaster; }
+    void*       base() const { return mBase; }
+    size_t      size() const { return mSize; }
+    // physical address of the heap; a buffer's is this plus its offset
+    size_t      phys() const { return mPhys; }
+
+    // a zeroed buffer mapped through its own new fd; returns 0 or -errno
+    int         allocate(size_t size, int* fd, size_t* offset);
+    // unmaps the buffer from fd and recycles its memory; the caller still
+    // owns (and closes) fd
+    int         free(int fd, size_t offset, size_t size);
+
+    // waits until every freed chunk has been zeroed
+    void        flush();
+
+    void        getStats(pmem_heap_stats_t* stats) const;
+    void        getAllocatorStats(allocator_stats_t* stats) const;
+
+private:
+    enum {
+        // chunks waiting for the scrubber; beyond that the caller zeroes
+        MAX_JOBS        = 256,
+        // connected fds kept ready
+        SPARE_FDS       = 4,
+        // the heap is queued for its first scrub in pieces this big, so
+        // early allocations don't wait for all of it
+        INIT_SLICE      = 1024*1024,
+    };
+
+    struct job_t {
+        size_t      offset;
+        size_t      size;
+    };
+
+    static void* scrubThread(void* arg);
+    void        scrubLoop();
+    bool        queueScrub(size_t offset, size_t size);
+    void        scrubNow(size_t offset, size_t size);
+    int         takeFd();
+
+    PmemDevice*             mDevice;
+    SegregatedFitAllocator  mAllocator;
+    int                     mMaster;
+    void*                   mBase;
+    size_t                  mSize;
+    size_t                  mPhys;
+    bool                    mAsync;
+
+    mutable pthread_mutex_t mLock;
+    pthread_cond_t          mWork;      // scrubber: jobs or fds wanted
+    pthread_cond_t          mDone;      // allocators: a job finished
+    pthread_t               mThread;
+    bool                    mRunning;
+    bool                    mExit;
+
+    job_t                   mJobs[MAX_JOBS];
+    int                     mJobHead;
+    int                     mJobCount;
+    uint32_t                mGeneration;    // bumped as each job finishes
+
+    int                     mFds[SPARE_FDS];
+    int                     mFdCount;
+
+    pmem_heap_stats_t       mStats;
+};
+
+#endif /* GRALLOC_PMEM_H_ */
@@ -0,0 +1,83 @@
+# Copyright (C) 2010 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+LOCAL_PATH:= $(call my-dir)
+
+# golden image test and benchmark for the RGB565 to luma engines
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	luma_test.cpp \
+	../luma.cpp
+
+LOCAL_MODULE:= gralloc_luma_test
+
+LOCAL_MODULE_TAGS:= tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# PMEM allocator latency / fragmentation benchmark
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	allocator_bench.cpp \
+	../allocator.cpp
+
+# the allocator's debug dump only exists in target builds
+LOCAL_CFLAGS:= -DNDEBUG
+
+LOCAL_STATIC_LIBRARIES:= liblog libcutils
+
+LOCAL_MODULE:= gralloc_allocator_bench
+
+LOCAL_MODULE_TAGS:= tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# PMEM heap allocation latency against a simulated PMEM device
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	pmem_bench.cpp \
+	../pmem.cpp \
+	../allocator.cpp
+
+LOCAL_CFLAGS:= -DNDEBUG
+
+LOCAL_STATIC_LIBRARIES:= liblog libcutils
+
+LOCAL_LDLIBS:= -lpthread
+
+LOCAL_MODULE:= gralloc_pmem_bench
+
+LOCAL_MODULE_TAGS:= tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# gralloc_lock/gralloc_unlock from many threads, with the contention counters
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	mapper_stress.cpp \
+	../mapper.cpp
+
+LOCAL_STATIC_LIBRARIES:= liblog libcutils
+
+LOCAL_LDLIBS:= -lpthread -ldl
+
+LOCAL_MODULE:= gralloc_mapper_stress
+
+LOCAL_MODULE_TAGS:= tests
+
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Replays the same randomized gralloc-like trace (mostly 4K-64K textures,
+ * now and then a 1-4MB buffer, on a 32MB heap) through the PMEM
+ * allocators and reports per-call latency, failures and fragmentation.
+ * Every allocation is checked to be page aligned and to overlap nothing.
+ *
+ *   allocator_bench [ops] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+#include "../allocator.h"
+
+static const size_t kHeapSize = 32*1024*1024;
+
+struct op_t {
+    int     id;         // allocation this op creates or frees
+    size_t  size;       // 0 for a free
+};
+
+struct result_t {
+    std::vector<long> lat;
+    int     failures;
+    size_t  liveAtFirstFailure;
+    int     errors;
+};
+
+/*****************************************************************************/
+
+static std::vector<op_t> makeTrace(int count, unsigned seed)
+{
+    std::vector<op_t> trace;
+    std::vector<int> live;
+    srand(seed);
+    int next = 0;
+    while ((int)trace.size() < count) {
+        // keep between a few and a few hundred buffers alive
+        bool doAlloc = live.size() < 8 ||
+                (live.size() < 400 && (rand() % 100) < 52);
+        op_t op;
+        if (doAlloc) {
+            op.id = next++;
+            if (rand() % 100 < 3) {
+                op.size = (1 + rand() % 4) * 1024*1024 - (rand() % 4096);
+            } else {
+                op.size = 4096 + rand() % (60*1024);
+            }
+            live.push_back(op.id);
+        } else {
+            int i = rand() % live.size();
+            op.id = live[i];
+            op.size = 0;
+            live[i] = live.back();
+            live.pop_back();
+        }
+        trace.push_back(op);
+    }
+    return trace;
+}
+
+static long nsSince(const timespec& t0)
+{
+    timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0.tv_sec)*1000000000L + (t1.tv_nsec - t0.tv_nsec);
+}
+
+template <typename ALLOCATOR>
+static void run(ALLOCATOR& a, const std::vector<op_t>& trace, result_t* r)
+{
+    const size_t pagesize = getpagesize();
+    const size_t pages = kHeapSize / pagesize;
+    std::vector<ssize_t> offsets(trace.size(), -1);
+    std::vector<size_t> sizes(trace.size(), 0);
+    std::vector<char> owner(pages, 0);
+    size_t live = 0;
+
+    r->lat.clear();
+    r->lat.reserve(trace.size());
+    r->failures = 0;
+    r->liveAtFirstFailure = 0;
+    r->errors = 0;
+
+    for (size_t k=0 ; k<trace.size() ; k++) {
+        const op_t& op = trace[k];
+        timespec t0;
+        if (op.size) {
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            ssize_t offset = a.allocate(op.size);
+            r->lat.push_back(nsSince(t0));
+            if (offset < 0) {
+                if (!r->failures++)
+                    r->liveAtFirstFailure = live;
+                continue;
+            }
+            if (offset % pagesize) {
+                fprintf(stderr, "offset 0x%08lx not page aligned\n", (long)offset);
+                r->errors++;
+            }
+            size_t first = offset / pagesize;
+            size_t last = (offset + op.size - 1) / pagesize;
+            if (last >= pages) {
+                fprintf(stderr, "offset 0x%08lx past the heap\n", (long)offset);
+                r->errors++;
+                continue;
+            }
+            for (size_t p=first ; p<=last ; p++) {
+                if (owner[p]) {
+                    fprintf(stderr, "page %lu allocated twice\n", (unsigned long)p);
+                    r->errors++;
+                }
+                owner[p] = 1;
+            }
+            offsets[op.id] = offset;
+            sizes[op.id] = op.size;
+            live += op.size;
+        } else if (offsets[op.id] >= 0) {
+            ssize_t offset = offsets[op.id];
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            ssize_t err = a.deallocate(offset);
+            r->lat.push_back(nsSince(t0));
+            if (err) {
+                fprintf(stderr, "free of 0x%08lx failed\n", (long)offset);
+                r->errors++;
+            }
+            size_t first = offset / pagesize;
+            size_t last = (offset + sizes[op.id] - 1) / pagesize;
+            for (size_t p=first ; p<=last ; p++)
+                owner[p] = 0;
+            offsets[op.id] = -1;
+            live -= sizes[op.id];
+        }
+    }
+
+    // a bogus free must be refused
+    if (a.deallocate(kHeapSize - pagesize/2) != -ENOENT) {
+        fprintf(stderr, "bogus free accepted\n");
+        r->errors++;
+    }
+}
+
+static void report(const char* name, result_t* r)
+{
+    std::vector<long>& lat = r->lat;
+    std::sort(lat.begin(), lat.end());
+    double sum = 0;
+    for (size_t i=0 ; i<lat.size() ; i++)
+        sum += lat[i];
+    printf("%-14s avg %7.0f ns  p99 %7ld ns  max %8ld ns  failures %d",
+            name, lat.empty() ? 0.0 : sum / lat.size(),
+            lat.empty() ? 0 : lat[lat.size()*99/100],
+            lat.empty() ? 0 : lat.back(), r->failures);
+    if (r->failures)
+        printf(" (first with %lu KB live)",
+                (unsigned long)(r->liveAtFirstFailure / 1024));
+    printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+    int count = (argc > 1) ? atoi(argv[1]) : 200000;
+    unsigned seed = (argc > 2) ? atoi(argv[2]) : 1;
+    std::vector<op_t> trace = makeTrace(count, seed);
+
+    result_t simple, segregated;
+    {
+        SimpleBestFitAllocator a(kHeapSize);
+        run(a, trace, &simple);
+    }
+    allocator_stats_t stats;
+    {
+        SegregatedFitAllocator a(kHeapSize);
+        run(a, trace, &segregated);
+        a.getStats(&stats);
+    }
+
+    report("best-fit", &simple);
+    report("segregated", &segregated);
+    printf("segregated end state: %lu KB free in %lu chunks, "
+            "largest %lu KB (%.1f%% fragmented)\n",
+            (unsigned long)(stats.free / 1024),
+            (unsigned long)stats.freeChunks,
+            (unsigned long)(stats.largestFree / 1024),
+            stats.free ? 100.0 * (1.0 - double(stats.largestFree) / stats.free) : 0.0);
+
+    int errors = simple.errors + segregated.errors;
+    if (stats.allocated + stats.free != stats.heapSize) {
+        fprintf(stderr, "stats don't add up\n");
+        errors++;
+    }
+    printf("%s\n", errors ? "FAILED" : "passed");
+    return errors ? 1 : 0;
+}
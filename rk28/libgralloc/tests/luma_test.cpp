@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host-side golden image test and throughput benchmark for the RGB565 to
+ * 4-bit luma engines used by the e-ink framebuffer.
+ *
+ *   luma_test            run the golden image checks
+ *   luma_test -b [n]     also benchmark every engine, n frames per case
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../luma.h"
+
+static const int kWidth  = 600;
+static const int kHeight = 800;
+
+/*****************************************************************************/
+
+// per-pixel reference, written straight from the output geometry
+static void golden(uint16_t* out, uint16_t const* in, int w, int h, int rot)
+{
+    int ow = (rot & 1) ? h : w;
+    memset(out, 0, (w*h/4)*sizeof(uint16_t));
+    for (int y=0 ; y<h ; y++) {
+        for (int x=0 ; x<w ; x++) {
+            unsigned p = in[y*w + x];
+            unsigned r = (p & 0xf800) >> 8;
+            unsigned g = (p & 0x07e0) >> 3;
+            unsigned b = (p & 0x001f) << 3;
+            unsigned v = ((77*r + 150*g + 29*b) >> 12) & 0xF;
+            int row, col;
+            switch (rot) {
+                case 0:  row = y;       col = x;        break;
+                case 1:  row = w-1-x;   col = y;        break;
+                case 2:  row = h-1-y;   col = w-1-x;    break;
+                default: row = x;       col = h-1-y;    break;
+            }
+            out[row*(ow/4) + col/4] |= v << ((col & 3) * 4);
+        }
+    }
+}
+
+static void fill_random(uint16_t* buf, int n, unsigned seed)
+{
+    srand(seed);
+    for (int i=0 ; i<n ; i++)
+        buf[i] = uint16_t(rand());
+}
+
+static int compare(const char* what, luma_engine_t const* e, int rot,
+        uint16_t const* a, uint16_t const* b, int n)
+{
+    for (int i=0 ; i<n ; i++) {
+        if (a[i] != b[i]) {
+            printf("FAIL %-6s rot=%d %s: word %d is %04x, expected %04x\n",
+                    e->name, rot, what, i, a[i], b[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int run_golden()
+{
+    const int w = kWidth, h = kHeight, n = w*h, nl = n/4;
+    uint16_t* src  = new uint16_t[n];
+    uint16_t* src2 = new uint16_t[n];
+    uint16_t* ref  = new uint16_t[nl];
+    uint16_t* out  = new uint16_t[nl];
+    int failures = 0;
+
+    // some rects deliberately off the 4-pixel grid or partly off-screen
+    static const luma_rect_t rects[] = {
+        { 0, 0, kWidth, kHeight },
+        { 13, 7, 14, 9 },                   // blinking caret
+        { 100, 200, 356, 233 },
+        { kWidth-5, kHeight-3, kWidth+40, kHeight+40 },
+        { -8, -8, 3, 3 },
+    };
+    const int numRects = sizeof(rects)/sizeof(rects[0]);
+
+    fill_random(src, n, 1);
+    for (int e=0 ; e<luma_engine_count() ; e++) {
+        luma_engine_t const* engine = luma_engine_at(e);
+        for (int rot=0 ; rot<4 ; rot++) {
+            golden(ref, src, w, h, rot);
+            memset(out, 0xA5, nl*sizeof(uint16_t));
+            luma_convert(engine, rot, out, src, w, h, NULL);
+            failures += compare("full frame", engine, rot, out, ref, nl);
+
+            // damage a rect and convert only that rect over the old image
+            for (int i=0 ; i<numRects ; i++) {
+                luma_rect_t const& rc = rects[i];
+                memcpy(src2, src, n*sizeof(uint16_t));
+                for (int y=rc.t ; y<rc.b ; y++) {
+                    for (int x=rc.l ; x<rc.r ; x++) {
+                        if (x>=0 && y>=0 && x<w && y<h)
+                            src2[y*w + x] = uint16_t(rand());
+                    }
+                }
+                golden(ref, src, w, h, rot);
+                memcpy(out, ref, nl*sizeof(uint16_t));
+                luma_convert(engine, rot, out, src2, w, h, &rc);
+                golden(ref, src2, w, h, rot);
+                char what[64];
+                snprintf(what, sizeof(what), "rect %d", i);
+                failures += compare(what, engine, rot, out, ref, nl);
+            }
+        }
+        printf("%-6s golden %s\n", engine->name, failures ? "FAILED" : "ok");
+    }
+
+    delete [] src;
+    delete [] src2;
+    delete [] ref;
+    delete [] out;
+    return failures;
+}
+
+/*****************************************************************************/
+
+static double now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1000.0 + ts.tv_nsec/1000000.0;
+}
+
+static void run_benchmark(int frames)
+{
+    const int w = kWidth, h = kHeight, n = w*h;
+    uint16_t* src = new uint16_t[n];
+    uint16_t* out = new uint16_t[n/4];
+    fill_random(src, n, 2);
+
+    const luma_rect_t caret = { 300, 400, 302, 424 };
+    const luma_rect_t line  = { 0, 400, kWidth, 424 };
+    struct { const char* name; luma_rect_t const* rc; } cases[] = {
+        { "full",  NULL },
+        { "line",  &line },
+        { "caret", &caret },
+    };
+
+    printf("\n%-6s %-6s %4s %12s %12s\n", "engine", "case", "rot",
+            "ms/frame", "Mpix/s");
+    for (int c=0 ; c<3 ; c++) {
+        for (int rot=0 ; rot<4 ; rot++) {
+            for (int e=0 ; e<luma_engine_count() ; e++) {
+                luma_engine_t const* engine = luma_engine_at(e);
+                int reps = cases[c].rc ? frames*20 : frames;
+                double t0 = now_ms();
+                for (int i=0 ; i<reps ; i++)
+                    luma_convert(engine, rot, out, src, w, h, cases[c].rc);
+                double ms = (now_ms() - t0) / reps;
+                luma_rect_t const* rc = cases[c].rc;
+                double pix = rc ? double(rc->r-rc->l)*(rc->b-rc->t) : double(n);
+                printf("%-6s %-6s %4d %12.4f %12.1f\n", engine->name,
+                        cases[c].name, rot*90, ms, pix / (ms*1000.0));
+            }
+        }
+    }
+
+    delete [] src;
+    delete [] out;
+}
+
+int main(int argc, char** argv)
+{
+    int failures = run_golden();
+    if (argc > 1 && !strcmp(argv[1], "-b")) {
+        int frames = (argc > 2) ? atoi(argv[2]) : 50;
+        run_benchmark(frames > 0 ? frames : 50);
+    }
+    return failures ? 1 : 0;
+}
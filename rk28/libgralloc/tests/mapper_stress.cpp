@@ -0,0 +1,330 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Hammers gralloc_lock/gralloc_unlock from several threads on a few
+ * buffers, the way camera, video and UI threads share them: writers fill
+ * the buffer with a stamp, readers check they never see a torn one, and
+ * texture users lock without mapping. Every round starts from freshly
+ * registered buffers so the threads also race to map them. mmap() is
+ * wrapped so that some rounds map slowly, making the other threads wait
+ * for the mapping, and some fail every other mmap().
+ *
+ * Checks that a write lock excludes everyone else, that each buffer is
+ * mapped exactly once per round and always at the same address, and that
+ * no lock is left behind; then prints the lock rate and the contention
+ * counters.
+ *
+ *   mapper_stress [threads] [rounds] [locks per thread per round]
+ */
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <cutils/log.h>
+#include <hardware/gralloc.h>
+
+#include "../gralloc_priv.h"
+#include "../gr.h"
+
+extern int gralloc_lock(gralloc_module_t const* module,
+        buffer_handle_t handle, int usage,
+        int l, int t, int w, int h,
+        void** vaddr);
+
+extern int gralloc_unlock(gralloc_module_t const* module,
+        buffer_handle_t handle);
+
+extern int gralloc_register_buffer(gralloc_module_t const* module,
+        buffer_handle_t handle);
+
+extern int gralloc_unregister_buffer(gralloc_module_t const* module,
+        buffer_handle_t handle);
+
+static const int kBuffers = 8;
+static const int kBufferSize = 64*1024;
+
+struct shadow_t {
+    volatile int32_t    readers;
+    volatile int32_t    writers;
+    void* volatile      vaddr;      // where the buffer is mapped this round
+};
+
+struct worker_t {
+    pthread_t   thread;
+    int         role;
+    unsigned    seed;
+    int         locks;
+    int         busy;
+    int         mapFailures;
+    int         errors;
+};
+
+enum { WRITER, READER, TEXTURE };
+static const char* const kRoles[] = { "writer", "reader", "texture" };
+
+static private_handle_t* sHandles[kBuffers];
+static shadow_t sShadow[kBuffers];
+static int sLocksPerRound;
+static pthread_barrier_t sStart, sDone;
+static volatile bool sExit;
+static volatile int sMapDelayUs;
+static volatile int sMapFailEvery;
+static volatile int32_t sMapCalls;
+
+/*****************************************************************************/
+
+extern "C" void* mmap(void* addr, size_t length, int prot, int flags,
+        int fd, off_t offset)
+{
+    typedef void* (*mmap_t)(void*, size_t, int, int, int, off_t);
+    static mmap_t realMmap;
+    if (!realMmap)
+        realMmap = (mmap_t)dlsym(RTLD_NEXT, "mmap");
+
+    int n = __sync_fetch_and_add(&sMapCalls, 1);
+    if (sMapFailEvery && n % sMapFailEvery == 0) {
+        errno = ENOMEM;
+        return MAP_FAILED;
+    }
+    if (sMapDelayUs)
+        usleep(sMapDelayUs);
+    return realMmap(addr, length, prot, flags, fd, offset);
+}
+
+static void checkStamp(worker_t* w, const uint32_t* p)
+{
+    uint32_t stamp = p[0];
+    if (p[kBufferSize/8] != stamp || p[kBufferSize/4 - 1] != stamp) {
+        fprintf(stderr, "torn read: %08x %08x %08x\n",
+                stamp, p[kBufferSize/8], p[kBufferSize/4 - 1]);
+        w->errors++;
+    }
+}
+
+static void checkAddress(worker_t* w, int b, void* vaddr)
+{
+    void* expected = __sync_val_compare_and_swap(&sShadow[b].vaddr,
+            (void*)0, vaddr);
+    if (expected && expected != vaddr) {
+        fprintf(stderr, "buffer %d at %p and %p\n", b, expected, vaddr);
+        w->errors++;
+    }
+}
+
+static void lockOnce(worker_t* w)
+{
+    int b = rand_r(&w->seed) % kBuffers;
+    shadow_t* s = &sShadow[b];
+    int usage;
+    switch (w->role) {
+        case WRITER:  usage = GRALLOC_USAGE_SW_WRITE_OFTEN; break;
+        case READER:  usage = GRALLOC_USAGE_SW_READ_OFTEN;  break;
+        default:      usage = GRALLOC_USAGE_HW_TEXTURE;     break;
+    }
+
+    void* vaddr = 0;
+    int err = gralloc_lock(0, sHandles[b], usage, 0, 0, 1, 1, &vaddr);
+    if (err == -EBUSY) {
+        w->busy++;
+        return;
+    }
+    if (err == -ENOMEM && sMapFailEvery) {
+        w->mapFailures++;
+        return;
+    }
+    if (err) {
+        fprintf(stderr, "lock failed (%s)\n", strerror(-err));
+        w->errors++;
+        return;
+    }
+    w->locks++;
+
+    if (w->role == WRITER) {
+        if (__sync_fetch_and_add(&s->writers, 1) || s->readers) {
+            fprintf(stderr, "buffer %d write locked while in use\n", b);
+            w->errors++;
+        }
+        checkAddress(w, b, vaddr);
+        uint32_t* p = (uint32_t*)vaddr;
+        uint32_t stamp = rand_r(&w->seed);
+        p[0] = stamp;
+        p[kBufferSize/8] = stamp;
+        p[kBufferSize/4 - 1] = stamp;
+        __sync_fetch_and_sub(&s->writers, 1);
+    } else {
+        __sync_fetch_and_add(&s->readers, 1);
+        if (s->writers) {
+            fprintf(stderr, "buffer %d read locked while written\n", b);
+            w->errors++;
+        }
+        if (w->role == READER) {
+            checkAddress(w, b, vaddr);
+            checkStamp(w, (const uint32_t*)vaddr);
+        }
+        __sync_fetch_and_sub(&s->readers, 1);
+    }
+
+    err = gralloc_unlock(0, sHandles[b]);
+    if (err) {
+        fprintf(stderr, "unlock failed (%s)\n", strerror(-err));
+        w->errors++;
+    }
+}
+
+static void* workerLoop(void* arg)
+{
+    worker_t* w = (worker_t*)arg;
+    for (;;) {
+        pthread_barrier_wait(&sStart);
+        if (sExit)
+            break;
+        for (int i=0 ; i<sLocksPerRound ; i++)
+            lockOnce(w);
+        pthread_barrier_wait(&sDone);
+    }
+    return 0;
+}
+
+static long nsSince(const timespec& t0)
+{
+    timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0.tv_sec)*1000000000L + (t1.tv_nsec - t0.tv_nsec);
+}
+
+/*****************************************************************************/
+
+int main(int argc, char** argv)
+{
+    int threads = (argc > 1) ? atoi(argv[1]) : 6;
+    int rounds = (argc > 2) ? atoi(argv[2]) : 50;
+    sLocksPerRound = (argc > 3) ? atoi(argv[3]) : 20000;
+    int errors = 0;
+
+    if (threads < 1)
+        threads = 1;
+
+    for (int b=0 ; b<kBuffers ; b++) {
+        char path[] = "/tmp/mapper_stressXXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0 || ftruncate(fd, kBufferSize) < 0) {
+            perror("buffer");
+            return 1;
+        }
+        unlink(path);
+        sHandles[b] = new private_handle_t(fd, kBufferSize, 0);
+        // as if it came from another process, so it gets mapped here
+        sHandles[b]->pid = getpid() + 1;
+    }
+
+    worker_t* workers = new worker_t[threads];
+    pthread_barrier_init(&sStart, 0, threads + 1);
+    pthread_barrier_init(&sDone, 0, threads + 1);
+    for (int i=0 ; i<threads ; i++) {
+        memset(&workers[i], 0, sizeof(workers[i]));
+        workers[i].role = i % 3;
+        workers[i].seed = i + 1;
+        pthread_create(&workers[i].thread, 0, workerLoop, &workers[i]);
+    }
+
+    // refused locks are logged, and there are a lot of them
+    fflush(stderr);
+    int savedStderr = dup(2);
+    int devnull = open("/dev/null", O_WRONLY);
+    dup2(devnull, 2);
+
+    long ns = 0;
+    for (int r=0 ; r<rounds ; r++) {
+        gralloc_lock_stats_t before, after;
+        for (int b=0 ; b<kBuffers ; b++) {
+            gralloc_register_buffer(0, sHandles[b]);
+            sShadow[b].vaddr = 0;
+        }
+        gralloc_get_lock_stats(&before);
+        sMapDelayUs = (r % 4 == 1) ? 500 : 0;
+        sMapFailEvery = (r % 4 == 3) ? 2 : 0;
+
+        timespec t0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        pthread_barrier_wait(&sStart);
+        pthread_barrier_wait(&sDone);
+        ns += nsSince(t0);
+
+        gralloc_get_lock_stats(&after);
+        for (int b=0 ; b<kBuffers ; b++) {
+            if (sHandles[b]->lockState & ~private_handle_t::LOCK_STATE_MAPPED) {
+                dprintf(savedStderr, "round %d: buffer %d left in state %08x\n",
+                        r, b, sHandles[b]->lockState);
+                errors++;
+            }
+            gralloc_unregister_buffer(0, sHandles[b]);
+        }
+        int mapped = 0;
+        for (int b=0 ; b<kBuffers ; b++)
+            mapped += sShadow[b].vaddr != 0;
+        if (after.maps - before.maps != mapped) {
+            dprintf(savedStderr, "round %d: %d buffers used, %d mmaps\n",
+                    r, mapped, after.maps - before.maps);
+            errors++;
+        }
+    }
+
+    sExit = true;
+    pthread_barrier_wait(&sStart);
+    for (int i=0 ; i<threads ; i++)
+        pthread_join(workers[i].thread, 0);
+
+    fflush(stderr);
+    dup2(savedStderr, 2);
+    close(devnull);
+    close(savedStderr);
+
+    long locks = 0, busy = 0, mapFailures = 0;
+    int counts[3] = { 0, 0, 0 };
+    for (int i=0 ; i<threads ; i++) {
+        locks += workers[i].locks;
+        busy += workers[i].busy;
+        mapFailures += workers[i].mapFailures;
+        errors += workers[i].errors;
+        counts[workers[i].role]++;
+    }
+    gralloc_lock_stats_t stats;
+    gralloc_get_lock_stats(&stats);
+
+    printf("%d threads (%d %s, %d %s, %d %s), %d buffers, %d rounds\n",
+            threads, counts[WRITER], kRoles[WRITER], counts[READER],
+            kRoles[READER], counts[TEXTURE], kRoles[TEXTURE], kBuffers, rounds);
+    printf("%ld locks, %ld refused, %ld failed to map, %.2fM lock calls/s\n",
+            locks, busy, mapFailures, ns ? (locks + busy) * 1e3 / ns : 0.0);
+    printf("retries %d, yields %d, busy %d, maps %d, map waits %d, "
+            "map sleeps %d\n", stats.retries, stats.yields, stats.busy,
+            stats.maps, stats.mapWaits, stats.mapSleeps);
+    if (stats.busy != busy) {
+        fprintf(stderr, "busy counter %d, threads saw %ld\n", stats.busy, busy);
+        errors++;
+    }
+    printf("%s\n", errors ? "FAILED" : "passed");
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,337 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Runs PmemHeap against a simulated PMEM device, once zeroing on
+ * allocation and once scrubbing in the background, and reports the
+ * allocation latency distribution of each.
+ *
+ * The device is a 32MB anonymous mapping filled with garbage. Its driver
+ * calls spin for roughly what they cost on the target (the k*Ns below)
+ * and check that no two fds ever map the same pages. The client side
+ * replays a gralloc-like trace (textures, now and then a 1-4MB buffer,
+ * a few 600KB window buffers being recycled) with a pause between calls,
+ * checks every new buffer reads as zero and scribbles over it.
+ *
+ *   pmem_bench [ops] [pause in us] [seed]
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "../pmem.h"
+
+static const size_t kHeapSize   = 32*1024*1024;
+static const size_t kPhys       = 0x60000000;
+
+// simulated driver costs
+static const long kOpenNs       = 15000;    // open("/dev/pmem")
+static const long kConnectNs    = 5000;     // PMEM_CONNECT
+static const long kMapNs        = 20000;    // PMEM_MAP / PMEM_UNMAP
+static const long kGetPhysNs    = 5000;     // PMEM_GET_PHYS, old path only
+
+/*****************************************************************************/
+
+static long nsSince(const timespec& t0)
+{
+    timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0.tv_sec)*1000000000L + (t1.tv_nsec - t0.tv_nsec);
+}
+
+static void spin(long ns)
+{
+    timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    while (nsSince(t0) < ns)
+        ;
+}
+
+class SimPmemDevice : public PmemDevice
+{
+public:
+    SimPmemDevice() : mBase(0), mErrors(0) { }
+
+    ~SimPmemDevice() {
+        if (mBase)
+            munmap(mBase, kHeapSize);
+    }
+
+    virtual int openMaster(size_t* size, void** base, size_t* phys) {
+        mBase = (char*)mmap(0, kHeapSize, PROT_READ|PROT_WRITE,
+                MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+        if (mBase == MAP_FAILED)
+            return -errno;
+        // whatever the last user left there
+        memset(mBase, 0xa5, kHeapSize);
+        *size = kHeapSize;
+        *base = mBase;
+        *phys = kPhys;
+        return open("/dev/null", O_RDWR);
+    }
+
+    virtual int connect(int master) {
+        spin(kOpenNs + kConnectNs);
+        return open("/dev/null", O_RDWR);
+    }
+
+    virtual int map(int fd, size_t offset, size_t size) {
+        spin(kMapNs);
+        Locker::Autolock _l(mLock);
+        if (mMapped.count(fd)) {
+            fprintf(stderr, "fd %d mapped twice\n", fd);
+            mErrors++;
+            return -EINVAL;
+        }
+        std::map<size_t, size_t>::iterator i = mRegions.lower_bound(offset);
+        if ((i != mRegions.end() && i->first < offset + size) ||
+                (i != mRegions.begin() && (--i)->first + i->second > offset)) {
+            fprintf(stderr, "0x%08lx mapped by two fds\n", (unsigned long)offset);
+            mErrors++;
+        }
+        mRegions[offset] = size;
+        mMapped[fd] = offset;
+        return 0;
+    }
+
+    virtual int unmap(int fd, size_t offset, size_t size) {
+        spin(kMapNs);
+        Locker::Autolock _l(mLock);
+        if (!mMapped.count(fd) || mMapped[fd] != offset) {
+            fprintf(stderr, "bad unmap of fd %d\n", fd);
+            mErrors++;
+            return -EINVAL;
+        }
+        mMapped.erase(fd);
+        mRegions.erase(offset);
+        return 0;
+    }
+
+    int errors() const { return mErrors; }
+
+private:
+    char*                   mBase;
+    Locker                  mLock;
+    std::map<int, size_t>   mMapped;    // fd -> offset
+    std::map<size_t, size_t> mRegions;  // offset -> size
+    int                     mErrors;
+};
+
+/*****************************************************************************/
+
+struct op_t {
+    int     id;         // allocation this op creates or frees
+    size_t  size;       // 0 for a free
+};
+
+struct result_t {
+    std::vector<long> allocLat;
+    std::vector<long> freeLat;
+    int     failures;
+    int     errors;
+    long    initNs;
+    pmem_heap_stats_t stats;
+};
+
+static std::vector<op_t> makeTrace(int count, unsigned seed)
+{
+    std::vector<op_t> trace;
+    std::vector<int> live;
+    srand(seed);
+    int next = 0;
+    while ((int)trace.size() < count) {
+        bool doAlloc = live.size() < 8 ||
+                (live.size() < 120 && (rand() % 100) < 52);
+        op_t op;
+        if (doAlloc) {
+            op.id = next++;
+            int kind = rand() % 100;
+            if (kind < 3) {
+                op.size = (1 + rand() % 4) * 1024*1024;
+            } else if (kind < 20) {
+                op.size = 480*320*4;
+            } else {
+                op.size = 4096 + rand() % (60*1024);
+            }
+            op.size = roundUpToPageSize(op.size);
+            live.push_back(op.id);
+        } else {
+            int i = rand() % live.size();
+            op.id = live[i];
+            op.size = 0;
+            live[i] = live.back();
+            live.pop_back();
+        }
+        trace.push_back(op);
+    }
+    return trace;
+}
+
+static bool isZero(const char* p, size_t size)
+{
+    static const char zero[4096] = { 0 };
+    for (size_t i=0 ; i<size ; i+=sizeof(zero)) {
+        size_t n = std::min(sizeof(zero), size - i);
+        if (memcmp(p + i, zero, n))
+            return false;
+    }
+    return true;
+}
+
+static void run(bool async, const std::vector<op_t>& trace, long pauseUs,
+        result_t* r)
+{
+    SimPmemDevice device;
+    PmemHeap heap;
+    std::vector<int> fds(trace.size(), -1);
+    std::vector<size_t> offsets(trace.size(), 0);
+    std::vector<size_t> sizes(trace.size(), 0);
+
+    r->allocLat.clear();
+    r->freeLat.clear();
+    r->failures = 0;
+    r->errors = 0;
+
+    timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (heap.init(&device, async)) {
+        fprintf(stderr, "init failed\n");
+        r->errors++;
+        return;
+    }
+    heap.flush();
+    r->initNs = nsSince(t0);
+    char* base = (char*)heap.base();
+
+    for (size_t k=0 ; k<trace.size() ; k++) {
+        const op_t& op = trace[k];
+        if (op.size) {
+            int fd;
+            size_t offset;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            int err = heap.allocate(op.size, &fd, &offset);
+            if (!async && !err) {
+                // what the old code also paid for on every allocation
+                spin(kGetPhysNs);
+            }
+            r->allocLat.push_back(nsSince(t0));
+            if (err) {
+                r->failures++;
+                continue;
+            }
+            if (!isZero(base + offset, op.size)) {
+                fprintf(stderr, "buffer at 0x%08lx not zeroed\n",
+                        (unsigned long)offset);
+                r->errors++;
+            }
+            memset(base + offset, 0x5a, op.size);
+            fds[op.id] = fd;
+            offsets[op.id] = offset;
+            sizes[op.id] = op.size;
+        } else if (fds[op.id] >= 0) {
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            int err = heap.free(fds[op.id], offsets[op.id], sizes[op.id]);
+            r->freeLat.push_back(nsSince(t0));
+            if (err) {
+                fprintf(stderr, "free of 0x%08lx failed\n",
+                        (unsigned long)offsets[op.id]);
+                r->errors++;
+            }
+            close(fds[op.id]);
+            fds[op.id] = -1;
+        }
+        if (pauseUs)
+            usleep(pauseUs);
+    }
+
+    for (size_t id=0 ; id<fds.size() ; id++) {
+        if (fds[id] >= 0) {
+            heap.free(fds[id], offsets[id], sizes[id]);
+            close(fds[id]);
+        }
+    }
+    heap.flush();
+    heap.getStats(&r->stats);
+
+    // everything back, in one piece and clean
+    allocator_stats_t astats;
+    heap.getAllocatorStats(&astats);
+    if (astats.allocated || astats.largestFree != kHeapSize) {
+        fprintf(stderr, "heap not whole again: %lu bytes in use\n",
+                (unsigned long)astats.allocated);
+        r->errors++;
+    }
+    if (async && !isZero(base, kHeapSize)) {
+        fprintf(stderr, "heap not clean after the last scrub\n");
+        r->errors++;
+    }
+    r->errors += device.errors();
+}
+
+static void reportLatency(const char* what, std::vector<long>& lat)
+{
+    std::sort(lat.begin(), lat.end());
+    double sum = 0;
+    for (size_t i=0 ; i<lat.size() ; i++)
+        sum += lat[i];
+    if (lat.empty()) {
+        printf("  %-6s no calls\n", what);
+        return;
+    }
+    printf("  %-6s avg %6.0f us  p50 %6.0f us  p90 %6.0f us  p99 %6.0f us  "
+            "max %6.0f us\n", what, sum / lat.size() / 1000.0,
+            lat[lat.size()/2] / 1000.0, lat[lat.size()*9/10] / 1000.0,
+            lat[lat.size()*99/100] / 1000.0, lat.back() / 1000.0);
+}
+
+static void report(const char* name, result_t* r)
+{
+    printf("%s (init %.1f ms)\n", name, r->initNs / 1e6);
+    reportLatency("alloc", r->allocLat);
+    reportLatency("free", r->freeLat);
+    printf("  failures %d, waits %u, zeroed %u in the background and %u "
+            "inline, fds ready %u/%u\n",
+            r->failures, r->stats.waits, r->stats.scrubbed,
+            r->stats.syncScrubs, r->stats.connectHits,
+            r->stats.connectHits + r->stats.connectMisses);
+}
+
+int main(int argc, char** argv)
+{
+    int count = (argc > 1) ? atoi(argv[1]) : 20000;
+    long pauseUs = (argc > 2) ? atol(argv[2]) : 100;
+    unsigned seed = (argc > 3) ? atoi(argv[3]) : 1;
+    std::vector<op_t> trace = makeTrace(count, seed);
+
+    result_t sync, async;
+    run(false, trace, pauseUs, &sync);
+    run(true, trace, pauseUs, &async);
+
+    report("zero on allocation", &sync);
+    report("background scrub", &async);
+
+    int errors = sync.errors + async.errors;
+    printf("%s\n", errors ? "FAILED" : "passed");
+    return errors ? 1 : 0;
+}
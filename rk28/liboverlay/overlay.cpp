@@ -31,7 +31,10 @@
 #include <cutils/log.h>
 #include <cutils/ashmem.h>
 #include <cutils/atomic.h>
+#include <cutils/properties.h>
 #include <linux/fb.h>
+
+#include "overlay_queue.h"
 /*****************************************************************************/
 
 #define LOG_FUNCTION_NAME    //LOGD(" %s ###### Calling %s() ######",  __FILE__,  __FUNCTION__);
@@ -39,6 +42,9 @@
 //#define LOGD(msg...)
 //#define LOGI(msg...)
 
+// buffers the decoder can have in flight between queue and dequeue
+#define NUM_OVERLAY_BUFFERS     4
+
 struct overlay_control_context_t {
     struct overlay_control_device_t device;
     /* our private state goes below here */
@@ -56,6 +62,7 @@ struct overlay_data_context_t {
     int num_buffers;
     size_t *buffers_len;
     void **buffers;
+    OverlayBufferQueue* queue;
 };
 
 typedef struct
@@ -253,7 +260,7 @@ static overlay_t* overlay_createOverlay(struct overlay_control_device_t *dev,
     if (fd < 0)
         return NULL;
 
-    if ( (overlay = new overlay_object(fd, w, h, format, 1, 16)) == NULL )
+    if ( (overlay = new overlay_object(fd, w, h, format, NUM_OVERLAY_BUFFERS, 16)) == NULL )
     {
         LOGE("Failed to create overlay object\n");
         close( fd );
@@ -552,6 +559,21 @@ int overlay_initialize(struct overlay_data_device_t *dev,
     ctx->buffer_size  = handle_buffer_size(handle);
     ctx->buffers      = new void* [1];
 
+    int y_plane_size = ((ctx->width + 15) & 0xfffffff0) * ((ctx->height + 15) & 0xfffffff0);
+    char value[PROPERTY_VALUE_MAX];
+    property_get("debug.overlay.vsync", value, "0");
+    bool vsync = (atoi(value) == 1);
+
+    // a re-initialized device drops the ring of its previous handle
+    delete ctx->queue;
+    ctx->queue = new OverlayBufferQueue(ctx->ctl_fd, y_plane_size,
+            handle_num_buffers(handle), vsync, &overlay_fb_kernel_ops);
+    if (ctx->queue->start() < 0) {
+        delete ctx->queue;
+        ctx->queue = NULL;
+        return -EPERM;
+    }
+    ctx->num_buffers  = ctx->queue->numBuffers();
 
     LOGI("Overlay initialize/width=%d/height=%d/ctx->buffers[0]=%08lx\n", ctx->width, ctx->height, (unsigned long)(ctx->buffers[0]));
 
@@ -577,7 +599,10 @@ int overlay_dequeueBuffer(struct overlay_data_device_t *dev,
     /* blocks until a buffer is available and return an opaque structure
      * representing this buffer.
      */
-    return -EINVAL;
+    struct overlay_data_context_t* ctx = (struct overlay_data_context_t*)dev;
+    if (ctx->queue == NULL)
+        return -EINVAL;
+    return ctx->queue->dequeue(buf);
 }
 
 
@@ -585,25 +610,17 @@ int overlay_queueBuffer(struct overlay_data_device_t *dev,
         overlay_buffer_t buffer)
 {
     struct overlay_data_context_t* ctx = (struct overlay_data_context_t*)dev;
-    int y_plane_size = ((ctx->width + 15) & 0xfffffff0) * ((ctx->height + 15) & 0xfffffff0);
     //LOGD("<%s>     width = %d, height = %d", __FUNCTION__, ctx->width, ctx->height);
-    int data[2];
 
     //LOGI("overlay_queueBuffer/width=%d/height=%d/ctx->buffers[0]=%08lx\n",
     //    ctx->width, ctx->height, (unsigned long)(ctx->buffers[0]));
 
-    ctx->num_buffers = 1;
+    if (ctx->queue == NULL)
+        return -EINVAL;
 
-    data[0] = *(int *)buffer;
-    data[1] = (int)(data[0] + y_plane_size);
-    //LOGD("<%s>   data[0] = 0x%x, data[1] = 0x%x", __FUNCTION__, data[0], data[1]);
-    if (ioctl(ctx->ctl_fd, 0x5002, data) == -1) {
-        LOGE("ioctl fb1 0x5002 fail!\n");
-        return -1;
-    }
-
-    /* Mark this buffer for posting and recycle or free overlay_buffer_t. */
-    return 0;
+    /* Mark this buffer for posting; the posting thread hands it to fb1
+     * (ioctl 0x5002) and releases it once it is off screen. */
+    return ctx->queue->queue(buffer);
 }
 
 
@@ -758,6 +775,7 @@ static int overlay_data_close(struct hw_device_t *dev)
     struct overlay_data_context_t* ctx = (struct overlay_data_context_t*)dev;
     if (ctx) {
 
+        delete ctx->queue;
         delete(ctx->buffers);
         /* free all resources associated with this device here
          * in particular all pending overlay_buffer_t if needed.
@@ -0,0 +1,282 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "RKOverlay"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <linux/fb.h>
+
+#include <cutils/log.h>
+
+#include "overlay_queue.h"
+
+#ifndef FBIO_WAITFORVSYNC
+#define FBIO_WAITFORVSYNC       _IOW('F', 0x20, uint32_t)
+#endif
+
+/*****************************************************************************/
+
+static int kernel_ioctl(void* cookie, int fd, int request, void* arg)
+{
+    return ioctl(fd, request, arg);
+}
+
+const overlay_fb_ops_t overlay_fb_kernel_ops = {
+    ioctl: kernel_ioctl,
+    cookie: 0
+};
+
+/*****************************************************************************/
+
+OverlayBufferQueue::OverlayBufferQueue(int fd, int yPlaneSize, int numBuffers,
+        bool vsyncPaced, const overlay_fb_ops_t* ops)
+    : mFd(fd), mYPlaneSize(yPlaneSize),
+      mNumBuffers(numBuffers < 2 ? 2 :
+              (numBuffers > MAX_BUFFERS ? MAX_BUFFERS : numBuffers)),
+      mVsyncPaced(vsyncPaced), mOps(ops ? ops : &overlay_fb_kernel_ops),
+      mRunning(false), mExit(false),
+      mPendingHead(0), mPendingCount(0),
+      mReleasedHead(0), mReleasedCount(0),
+      mDisplayed(-1), mPosting(false)
+{
+    pthread_mutex_init(&mLock, 0);
+    pthread_cond_init(&mCond, 0);
+    memset(mSlots, 0, sizeof(mSlots));
+    memset(&mStats, 0, sizeof(mStats));
+}
+
+OverlayBufferQueue::~OverlayBufferQueue()
+{
+    stop();
+    pthread_cond_destroy(&mCond);
+    pthread_mutex_destroy(&mLock);
+}
+
+int OverlayBufferQueue::start()
+{
+    pthread_mutex_lock(&mLock);
+    int err = 0;
+    if (!mRunning) {
+        mExit = false;
+        err = -pthread_create(&mThread, NULL, postThread, this);
+        mRunning = (err == 0);
+    }
+    pthread_mutex_unlock(&mLock);
+    if (err)
+        LOGE("can't start overlay posting thread (%s)", strerror(-err));
+    return err;
+}
+
+void OverlayBufferQueue::stop()
+{
+    pthread_mutex_lock(&mLock);
+    bool running = mRunning;
+    mExit = true;
+    mRunning = false;
+    pthread_cond_broadcast(&mCond);
+    pthread_mutex_unlock(&mLock);
+    if (running)
+        pthread_join(mThread, NULL);
+}
+
+int OverlayBufferQueue::findSlotLocked(void* buffer) const
+{
+    for (int i=0 ; i<mNumBuffers ; i++) {
+        if (mSlots[i].state != SLOT_FREE && mSlots[i].buffer == buffer)
+            return i;
+    }
+    return -1;
+}
+
+void OverlayBufferQueue::removeFifo(int* fifo, int head, int* count, int i)
+{
+    for (int k=0 ; k<*count ; k++) {
+        if (fifo[(head + k) % MAX_BUFFERS] == i) {
+            for ( ; k<*count-1 ; k++) {
+                int next = (head + k + 1) % MAX_BUFFERS;
+                fifo[(head + k) % MAX_BUFFERS] = fifo[next];
+            }
+            (*count)--;
+            return;
+        }
+    }
+}
+
+int OverlayBufferQueue::reclaimSlotLocked()
+{
+    for (int i=0 ; i<mNumBuffers ; i++) {
+        if (mSlots[i].state == SLOT_FREE)
+            return i;
+    }
+    if (mReleasedCount) {
+        int i = mReleased[mReleasedHead];
+        mReleasedHead = (mReleasedHead + 1) % MAX_BUFFERS;
+        mReleasedCount--;
+        mSlots[i].state = SLOT_FREE;
+        mStats.recycled++;
+        return i;
+    }
+    return -1;
+}
+
+int OverlayBufferQueue::queue(void* buffer)
+{
+    if (buffer == NULL)
+        return -EINVAL;
+
+    pthread_mutex_lock(&mLock);
+    int i = findSlotLocked(buffer);
+    if (i >= 0 && mSlots[i].state == SLOT_QUEUED) {
+        // still waiting to be posted: the client wrote the new frame over
+        // the old one, which moves to the end of the queue with it
+        removeFifo(mPending, mPendingHead, &mPendingCount, i);
+        mStats.dropped++;
+        mStats.overwritten++;
+    } else if (i >= 0 && mSlots[i].state == SLOT_DISPLAYED) {
+        // written while scanned out, posted again below
+        mStats.overwritten++;
+    } else if (i >= 0 && mSlots[i].state == SLOT_RELEASED) {
+        // queued again without a dequeue, drop it from the released FIFO
+        removeFifo(mReleased, mReleasedHead, &mReleasedCount, i);
+    }
+    while (i < 0) {
+        if (mExit) {
+            pthread_mutex_unlock(&mLock);
+            return -EPIPE;
+        }
+        i = reclaimSlotLocked();
+        if (i < 0)
+            pthread_cond_wait(&mCond, &mLock);
+    }
+
+    // read now: the client may reuse the handle as soon as we return
+    mSlots[i].buffer = buffer;
+    mSlots[i].phys = *(int *)buffer;
+    mSlots[i].state = SLOT_QUEUED;
+    mPending[(mPendingHead + mPendingCount) % MAX_BUFFERS] = i;
+    mPendingCount++;
+    mStats.queued++;
+    if (uint32_t(mPendingCount) > mStats.max_pending)
+        mStats.max_pending = mPendingCount;
+    pthread_cond_broadcast(&mCond);
+    pthread_mutex_unlock(&mLock);
+    return 0;
+}
+
+int OverlayBufferQueue::dequeue(void** buffer)
+{
+    pthread_mutex_lock(&mLock);
+    for (;;) {
+        if (mReleasedCount) {
+            int i = mReleased[mReleasedHead];
+            mReleasedHead = (mReleasedHead + 1) % MAX_BUFFERS;
+            mReleasedCount--;
+            mSlots[i].state = SLOT_DEQUEUED;
+            *buffer = mSlots[i].buffer;
+            pthread_mutex_unlock(&mLock);
+            return 0;
+        }
+        if (mExit) {
+            pthread_mutex_unlock(&mLock);
+            return -EPIPE;
+        }
+        if (!mPendingCount && !mPosting) {
+            // nothing in flight, nothing will ever be released
+            pthread_mutex_unlock(&mLock);
+            return -EAGAIN;
+        }
+        pthread_cond_wait(&mCond, &mLock);
+    }
+}
+
+void OverlayBufferQueue::getStats(overlay_queue_stats_t* stats)
+{
+    pthread_mutex_lock(&mLock);
+    *stats = mStats;
+    pthread_mutex_unlock(&mLock);
+}
+
+/*****************************************************************************/
+
+void* OverlayBufferQueue::postThread(void* arg)
+{
+    static_cast<OverlayBufferQueue*>(arg)->postLoop();
+    return NULL;
+}
+
+int OverlayBufferQueue::post(slot_t* slot)
+{
+    int data[2];
+    data[0] = slot->phys;
+    data[1] = (int)(data[0] + mYPlaneSize);
+    if (mOps->ioctl(mOps->cookie, mFd, RK_FBIOSET_YUV_ADDR, data) == -1) {
+        int err = errno;
+        LOGE("ioctl fb1 0x5002 fail!\n");
+        return -err;
+    }
+    if (mVsyncPaced) {
+        // the old buffer is scanned out until the next vsync
+        uint32_t crtc = 0;
+        if (mOps->ioctl(mOps->cookie, mFd, FBIO_WAITFORVSYNC, &crtc) == -1) {
+            LOGW("FBIO_WAITFORVSYNC failed, vsync pacing disabled");
+            mVsyncPaced = false;
+        }
+    }
+    return 0;
+}
+
+void OverlayBufferQueue::postLoop()
+{
+    pthread_mutex_lock(&mLock);
+    while (!mExit) {
+        if (!mPendingCount) {
+            pthread_cond_wait(&mCond, &mLock);
+            continue;
+        }
+        int i = mPending[mPendingHead];
+        mPendingHead = (mPendingHead + 1) % MAX_BUFFERS;
+        mPendingCount--;
+        mSlots[i].state = SLOT_DISPLAYED;
+        slot_t slot = mSlots[i];
+        mPosting = true;
+        pthread_mutex_unlock(&mLock);
+
+        int err = post(&slot);
+
+        pthread_mutex_lock(&mLock);
+        mPosting = false;
+        int done = i;
+        if (err) {
+            mStats.post_errors++;
+        } else {
+            mStats.posted++;
+            done = mDisplayed;
+            mDisplayed = i;
+        }
+        // queue() may have taken the buffer back meanwhile
+        if (done >= 0 && done != mDisplayed &&
+                mSlots[done].state == SLOT_DISPLAYED) {
+            mSlots[done].state = SLOT_RELEASED;
+            mReleased[(mReleasedHead + mReleasedCount) % MAX_BUFFERS] = done;
+            mReleasedCount++;
+            mStats.released++;
+        }
+        pthread_cond_broadcast(&mCond);
+    }
+    pthread_mutex_unlock(&mLock);
+}
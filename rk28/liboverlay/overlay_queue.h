@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RK28_OVERLAY_QUEUE_H_
+#define RK28_OVERLAY_QUEUE_H_
+
+#include <stdint.h>
+#include <pthread.h>
+
+/*****************************************************************************/
+
+/* fb1 private ioctls used by the data device */
+#define RK_FBIOSET_YUV_ADDR     0x5002
+
+/*
+ * Everything the queue needs from the fb1 driver goes through these hooks
+ * so the ring can run against a simulated device on a host.
+ */
+struct overlay_fb_ops_t {
+    int (*ioctl)(void* cookie, int fd, int request, void* arg);
+    void* cookie;
+};
+
+/* the real driver, plain ioctl(2) */
+extern const overlay_fb_ops_t overlay_fb_kernel_ops;
+
+struct overlay_queue_stats_t {
+    uint32_t queued;
+    uint32_t posted;
+    uint32_t released;
+    uint32_t recycled;      // released buffers reclaimed without a dequeue
+    uint32_t dropped;       // frames replaced by a queue() before being posted
+    uint32_t overwritten;   // buffers queued again while queued or on screen
+    uint32_t post_errors;
+    uint32_t max_pending;
+};
+
+/*
+ * N-slot ring between the video decoder and fb1.
+ *
+ * queue() hands a buffer (an overlay_buffer_t pointing at the physical
+ * address of its Y plane) to the posting thread and returns right away.
+ * The posting thread feeds buffers to the driver in order; a buffer is
+ * released once a newer one has replaced it on screen, after the next
+ * vsync when pacing is on. dequeue() blocks until a released buffer is
+ * available and gives it back to the caller.
+ *
+ * Clients that never dequeue keep working: the oldest released buffer is
+ * reclaimed whenever queue() needs a slot. Such a client also reuses
+ * buffers blindly, so it may write into one that is still queued or on
+ * screen, which tears that frame; the queue counts these in overwritten.
+ * A buffer queued again while still waiting to be posted moves to the end
+ * of the queue, and the frame it held is dropped.
+ */
+class OverlayBufferQueue
+{
+public:
+    enum {
+        SLOT_FREE = 0,
+        SLOT_DEQUEUED,      // owned by the client
+        SLOT_QUEUED,        // waiting for the posting thread
+        SLOT_DISPLAYED,     // being scanned out
+        SLOT_RELEASED,      // off screen, waiting for dequeue()
+    };
+
+    enum { MAX_BUFFERS = 16 };
+
+    OverlayBufferQueue(int fd, int yPlaneSize, int numBuffers,
+            bool vsyncPaced, const overlay_fb_ops_t* ops);
+    ~OverlayBufferQueue();
+
+    int     start();
+    void    stop();
+
+    int     queue(void* buffer);
+    int     dequeue(void** buffer);
+
+    int     numBuffers() const { return mNumBuffers; }
+    void    getStats(overlay_queue_stats_t* stats);
+
+private:
+    struct slot_t {
+        void*   buffer;
+        int     phys;       // Y plane address, read from buffer by queue()
+        int     state;
+    };
+
+    static void* postThread(void* arg);
+    void    postLoop();
+    int     post(slot_t* slot);
+    int     findSlotLocked(void* buffer) const;
+    int     reclaimSlotLocked();
+    static void removeFifo(int* fifo, int head, int* count, int i);
+
+    const int                   mFd;
+    const int                   mYPlaneSize;
+    const int                   mNumBuffers;
+    bool                        mVsyncPaced;
+    const overlay_fb_ops_t*     mOps;
+
+    pthread_mutex_t             mLock;
+    pthread_cond_t              mCond;
+    pthread_t                   mThread;
+    bool                        mRunning;
+    bool                        mExit;
+
+    slot_t                      mSlots[MAX_BUFFERS];
+    // FIFOs of slot indices
+    int                         mPending[MAX_BUFFERS];
+    int                         mPendingHead;
+    int                         mPendingCount;
+    int                         mReleased[MAX_BUFFERS];
+    int                         mReleasedHead;
+    int                         mReleasedCount;
+    int                         mDisplayed;
+    bool                        mPosting;
+
+    overlay_queue_stats_t       mStats;
+};
+
+#endif /* RK28_OVERLAY_QUEUE_H_ */
@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Stress test for the overlay buffer ring against a simulated fb1.
+ *
+ * The fake driver latches the address given to ioctl 0x5002 either right
+ * away or, when vsync pacing is on, at the next vsync tick of a free
+ * 1 kHz "panel". It checks that frames reach the screen in the
+ * order they were queued, and the client checks that it never gets back a
+ * buffer that is still on screen.
+ *
+ * The legacy runs never dequeue and reuse kLegacyBuffers buffers blindly,
+ * fewer than the ring has slots, as the old decoders do. They write into
+ * buffers that are still queued or on screen, which tears those frames:
+ * these are counted, and a torn frame may reach the screen out of order.
+ *
+ *   overlay_queue_test [frames]
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <linux/fb.h>
+
+#include "../overlay_queue.h"
+
+#ifndef FBIO_WAITFORVSYNC
+#define FBIO_WAITFORVSYNC       _IOW('F', 0x20, uint32_t)
+#endif
+
+static const int kNumClientBuffers = 6;
+static const int kLegacyBuffers = 3;
+static const int kQueueSlots = 4;
+static const int kYPlaneSize = 320*240;
+static const int kVsyncPeriodUs = 1000;
+
+struct client_buffer_t {
+    int phys;       // what overlay_buffer_t points at
+    int seq;
+    bool torn;      // rewritten while queued or on screen
+};
+
+struct fake_fb1_t {
+    pthread_mutex_t lock;
+    client_buffer_t* buffers;
+    int latched;        // index on screen, -1 if none
+    int pending;        // index waiting for vsync
+    int lastSeq;
+    bool lastTorn;
+    int errors;
+    int posts;
+    int vsyncs;
+};
+
+static int find_buffer(fake_fb1_t* fb, int phys)
+{
+    for (int i=0 ; i<kNumClientBuffers ; i++) {
+        if (fb->buffers[i].phys == phys)
+            return i;
+    }
+    return -1;
+}
+
+static int fake_ioctl(void* cookie, int fd, int request, void* arg)
+{
+    fake_fb1_t* fb = (fake_fb1_t*)cookie;
+    if (request == RK_FBIOSET_YUV_ADDR) {
+        int* data = (int*)arg;
+        pthread_mutex_lock(&fb->lock);
+        int i = find_buffer(fb, data[0]);
+        if (i < 0 || data[1] != data[0] + kYPlaneSize) {
+            printf("bad addresses %08x/%08x\n", data[0], data[1]);
+            fb->errors++;
+        } else {
+            if (fb->buffers[i].seq <= fb->lastSeq && !fb->lastTorn &&
+                    !fb->buffers[i].torn) {
+                printf("frame %d posted after %d\n", fb->buffers[i].seq,
+                        fb->lastSeq);
+                fb->errors++;
+            }
+            fb->lastSeq = fb->buffers[i].seq;
+            fb->lastTorn = fb->buffers[i].torn;
+            fb->buffers[i].torn = false;
+            fb->pending = i;
+            fb->posts++;
+        }
+        pthread_mutex_unlock(&fb->lock);
+        return 0;
+    }
+    if (request == (int)FBIO_WAITFORVSYNC) {
+        usleep(kVsyncPeriodUs);
+        pthread_mutex_lock(&fb->lock);
+        fb->latched = fb->pending;
+        fb->vsyncs++;
+        pthread_mutex_unlock(&fb->lock);
+        return 0;
+    }
+    errno = EINVAL;
+    return -1;
+}
+
+/*****************************************************************************/
+
+static double now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1000.0 + ts.tv_nsec/1000000.0;
+}
+
+static int run(const char* name, int frames, bool vsync, bool dequeue)
+{
+    client_buffer_t buffers[kNumClientBuffers];
+    for (int i=0 ; i<kNumClientBuffers ; i++) {
+        buffers[i].phys = 0x40000000 + i*0x100000;
+        buffers[i].seq = -1;
+        buffers[i].torn = false;
+    }
+
+    fake_fb1_t fb;
+    memset(&fb, 0, sizeof(fb));
+    pthread_mutex_init(&fb.lock, 0);
+    fb.buffers = buffers;
+    fb.latched = fb.pending = fb.lastSeq = -1;
+
+    overlay_fb_ops_t ops = { fake_ioctl, &fb };
+    OverlayBufferQueue* q = new OverlayBufferQueue(3, kYPlaneSize, kQueueSlots,
+            vsync, &ops);
+    q->start();
+
+    int failures = 0;
+    int torn = 0;
+    int next = 0;
+    double t0 = now_ms();
+    for (int seq=0 ; seq<frames ; seq++) {
+        client_buffer_t* b;
+        if (!dequeue) {
+            // legacy client: reuse blindly
+            b = &buffers[next++ % kLegacyBuffers];
+        } else if (next < kNumClientBuffers) {
+            b = &buffers[next++];
+        } else {
+            void* out;
+            int err = q->dequeue(&out);
+            if (err) {
+                printf("%s: dequeue failed (%d)\n", name, err);
+                failures++;
+                break;
+            }
+            b = (client_buffer_t*)out;
+            pthread_mutex_lock(&fb.lock);
+            int i = b - buffers;
+            if (i == fb.latched || (!vsync && i == fb.pending)) {
+                printf("%s: got buffer %d back while on screen\n", name, i);
+                failures++;
+            }
+            pthread_mutex_unlock(&fb.lock);
+        }
+        pthread_mutex_lock(&fb.lock);
+        int i = b - buffers;
+        if (b->seq > fb.lastSeq || i == fb.latched || i == fb.pending) {
+            // not posted yet, or on screen: this write tears it
+            b->torn = true;
+            torn++;
+        }
+        b->seq = seq;
+        pthread_mutex_unlock(&fb.lock);
+        if (q->queue(b) < 0) {
+            printf("%s: queue failed\n", name);
+            failures++;
+            break;
+        }
+    }
+    // let the ring drain
+    overlay_queue_stats_t st;
+    q->getStats(&st);
+    while (int(st.posted + st.dropped) < frames && now_ms() - t0 < 10000) {
+        usleep(1000);
+        q->getStats(&st);
+    }
+    double ms = now_ms() - t0;
+    delete q;
+
+    if (fb.errors || st.post_errors)
+        failures++;
+    if (dequeue && (torn || st.overwritten)) {
+        printf("%s: %d frames torn, %u buffers overwritten\n", name, torn,
+                st.overwritten);
+        failures++;
+    }
+    if (fb.lastSeq != frames-1) {
+        printf("%s: last frame on screen is %d, expected %d\n", name,
+                fb.lastSeq, frames-1);
+        failures++;
+    }
+    printf("%-16s %s  %6d frames %8.1f fps  queued=%u posted=%u released=%u "
+            "recycled=%u dropped=%u overwritten=%u torn=%d max_pending=%u "
+            "vsyncs=%d\n",
+            name, failures ? "FAIL" : "ok  ", frames, frames*1000.0/ms,
+            st.queued, st.posted, st.released, st.recycled, st.dropped,
+            st.overwritten, torn, st.max_pending, fb.vsyncs);
+    return failures;
+}
+
+int main(int argc, char** argv)
+{
+    int frames = (argc > 1) ? atoi(argv[1]) : 2000;
+    if (frames <= 0)
+        frames = 2000;
+
+    int failures = 0;
+    failures += run("dequeue",        frames, false, true);
+    failures += run("dequeue+vsync",  frames, true,  true);
+    failures += run("legacy",         frames, false, false);
+    failures += run("legacy+vsync",   frames, true,  false);
+    return failures ? 1 : 0;
+}
@@ -2,6 +2,7 @@ LOCAL_PATH := $(call my-dir)
 include $(CLEAR_VARS)
 
 LOCAL_SRC_FILES := \
+    ColorConversion.cpp \
     stagefright_overlay_output.cpp \
     TIHardwareRenderer.cpp \
     TIOMXPlugin.cpp
@@ -24,3 +25,4 @@ LOCAL_MODULE := libstagefrighthw
 
 include $(BUILD_SHARED_LIBRARY)
 
+include $(call all-makefiles-under,$(LOCAL_PATH))
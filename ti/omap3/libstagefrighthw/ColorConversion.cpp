@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2009 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ColorConversion.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+namespace android {
+
+// return a byte offset from any pointer
+static inline const void *byteOffset(const void* p, size_t offset) {
+    return ((uint8_t*)p + offset);
+}
+
+void convertYuv420ToYuv422Scalar(
+        int width, int height, const void *src, void *dst) {
+    // calculate total number of pixels, and offsets to U and V planes
+    int pixelCount = height * width;
+    int srcLineLength = width / 4;
+    int destLineLength = width / 2;
+    uint32_t* ySrc = (uint32_t*) src;
+    const uint16_t* uSrc = (const uint16_t*) byteOffset(src, pixelCount);
+    const uint16_t* vSrc = (const uint16_t*) byteOffset(uSrc, pixelCount >> 2);
+    uint32_t *p = (uint32_t*) dst;
+
+    // convert lines
+    for (int i = 0; i < height; i += 2) {
+
+        // upsample by repeating the UV values on adjacent lines
+        // to save memory accesses, we handle 2 adjacent lines at a time
+        // convert 4 pixels in 2 adjacent lines at a time
+        for (int j = 0; j < srcLineLength; j++) {
+
+            // fetch 4 Y values for each line
+            uint32_t y0 = ySrc[0];
+            uint32_t y1 = ySrc[srcLineLength];
+            ySrc++;
+
+            // fetch 2 U/V values
+            uint32_t u = *uSrc++;
+            uint32_t v = *vSrc++;
+
+            // assemble first U/V pair, leave holes for Y's
+            uint32_t uv = (u | (v << 16)) & 0x00ff00ff;
+
+            // OR y values and write to memory
+            p[0] = ((y0 & 0xff) << 8) | ((y0 & 0xff00) << 16) | uv;
+            p[destLineLength] = ((y1 & 0xff) << 8) | ((y1 & 0xff00) << 16) | uv;
+            p++;
+
+            // assemble second U/V pair, leave holes for Y's
+            uv = ((u >> 8) | (v << 8)) & 0x00ff00ff;
+
+            // OR y values and write to memory
+            p[0] = ((y0 >> 8) & 0xff00) | (y0 & 0xff000000) | uv;
+            p[destLineLength] = ((y1 >> 8) & 0xff00) | (y1 & 0xff000000) | uv;
+            p++;
+        }
+
+        // skip the next y line, we already converted it
+        ySrc += srcLineLength;
+        p += destLineLength;
+    }
+}
+
+#if defined(__ARM_NEON__)
+
+// 16 pixels of 2 lines at a time: the even and odd Y's are split by the
+// load, and U Y V Y put back together by the store. The last width % 16
+// pixels are done 4 at a time.
+static void convertLinePairNeon(
+        int width,
+        const uint8_t *y0, const uint8_t *y1,
+        const uint8_t *u, const uint8_t *v,
+        uint8_t *d0, uint8_t *d1) {
+    int x = 0;
+
+    for (; x + 16 <= width; x += 16) {
+        uint8x8x2_t ya = vld2_u8(y0 + x);
+        uint8x8x2_t yb = vld2_u8(y1 + x);
+        uint8x8x4_t out;
+
+        out.val[0] = vld1_u8(u + x / 2);
+        out.val[2] = vld1_u8(v + x / 2);
+
+        out.val[1] = ya.val[0];
+        out.val[3] = ya.val[1];
+        vst4_u8(d0 + x * 2, out);
+
+        out.val[1] = yb.val[0];
+        out.val[3] = yb.val[1];
+        vst4_u8(d1 + x * 2, out);
+    }
+
+    for (; x < width; x += 4) {
+        uint8_t u0 = u[x / 2], u1 = u[x / 2 + 1];
+        uint8_t v0 = v[x / 2], v1 = v[x / 2 + 1];
+        uint8_t *p0 = d0 + x * 2;
+        uint8_t *p1 = d1 + x * 2;
+
+        p0[0] = u0; p0[1] = y0[x];     p0[2] = v0; p0[3] = y0[x + 1];
+        p0[4] = u1; p0[5] = y0[x + 2]; p0[6] = v1; p0[7] = y0[x + 3];
+        p1[0] = u0; p1[1] = y1[x];     p1[2] = v0; p1[3] = y1[x + 1];
+        p1[4] = u1; p1[5] = y1[x + 2]; p1[6] = v1; p1[7] = y1[x + 3];
+    }
+}
+
+#endif
+
+void convertYuv420ToYuv422(
+        int width, int height, const void *src, void *dst) {
+#if defined(__ARM_NEON__)
+    if (width % 4 == 0 && height % 2 == 0) {
+        const uint8_t *y = (const uint8_t *)src;
+        const uint8_t *u = y + width * height;
+        const uint8_t *v = u + width * height / 4;
+        uint8_t *d = (uint8_t *)dst;
+
+        for (int i = 0; i < height; i += 2) {
+            convertLinePairNeon(
+                    width, y, y + width, u, v, d, d + width * 2);
+
+            y += width * 2;
+            u += width / 2;
+            v += width / 2;
+            d += width * 4;
+        }
+        return;
+    }
+#endif
+
+    convertYuv420ToYuv422Scalar(width, height, src, dst);
+}
+
+}  // namespace android
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2009 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COLOR_CONVERSION_H_
+
+#define COLOR_CONVERSION_H_
+
+namespace android {
+
+// Converts a YUV420 planar frame to CbYCrY (UYVY) interleaved 4:2:2, the
+// format of the overlay buffers. Each chroma line is used for both luma
+// lines it covers. Uses NEON where the CPU has it.
+void convertYuv420ToYuv422(
+        int width, int height, const void *src, void *dst);
+
+// The same conversion 4 pixels at a time in 32-bit words, what
+// convertYuv420ToYuv422 uses without NEON or for widths that are not a
+// multiple of 4. The NEON version must match it byte for byte.
+void convertYuv420ToYuv422Scalar(
+        int width, int height, const void *src, void *dst);
+
+}  // namespace android
+
+#endif  // COLOR_CONVERSION_H_
@@ -18,6 +18,7 @@
 #include <utils/Log.h>
 
 #include "TIHardwareRenderer.h"
+#include "ColorConversion.h"
 
 #include <media/stagefright/MediaDebug.h>
 #include <surfaceflinger/ISurface.h>
@@ -45,6 +46,7 @@ TIHardwareRenderer::TIHardwareRenderer(
       mInitCheck(NO_INIT),
       mFrameSize(mDecodedWidth * mDecodedHeight * 2),
       mIsFirstFrame(true),
+      mZeroCopy(false),
       mIndex(0) {
     CHECK(mISurface.get() != NULL);
     CHECK(mDecodedWidth > 0);
@@ -86,60 +88,26 @@ TIHardwareRenderer::~TIHardwareRenderer() {
     }
 }
 
-// return a byte offset from any pointer
-static inline const void *byteOffset(const void* p, size_t offset) {
-    return ((uint8_t*)p + offset);
+size_t TIHardwareRenderer::getOverlayBufferCount() const {
+    return mOverlayAddresses.size();
 }
 
-static void convertYuv420ToYuv422(
-        int width, int height, const void *src, void *dst) {
-    // calculate total number of pixels, and offsets to U and V planes
-    int pixelCount = height * width;
-    int srcLineLength = width / 4;
-    int destLineLength = width / 2;
-    uint32_t* ySrc = (uint32_t*) src;
-    const uint16_t* uSrc = (const uint16_t*) byteOffset(src, pixelCount);
-    const uint16_t* vSrc = (const uint16_t*) byteOffset(uSrc, pixelCount >> 2);
-    uint32_t *p = (uint32_t*) dst;
-
-    // convert lines
-    for (int i = 0; i < height; i += 2) {
-
-        // upsample by repeating the UV values on adjacent lines
-        // to save memory accesses, we handle 2 adjacent lines at a time
-        // convert 4 pixels in 2 adjacent lines at a time
-        for (int j = 0; j < srcLineLength; j++) {
-
-            // fetch 4 Y values for each line
-            uint32_t y0 = ySrc[0];
-            uint32_t y1 = ySrc[srcLineLength];
-            ySrc++;
-
-            // fetch 2 U/V values
-            uint32_t u = *uSrc++;
-            uint32_t v = *vSrc++;
-
-            // assemble first U/V pair, leave holes for Y's
-            uint32_t uv = (u | (v << 16)) & 0x00ff00ff;
-
-            // OR y values and write to memory
-            p[0] = ((y0 & 0xff) << 8) | ((y0 & 0xff00) << 16) | uv;
-            p[destLineLength] = ((y1 & 0xff) << 8) | ((y1 & 0xff00) << 16) | uv;
-            p++;
-
-            // assemble second U/V pair, leave holes for Y's
-            uv = ((u >> 8) | (v << 8)) & 0x00ff00ff;
-
-            // OR y values and write to memory
-            p[0] = ((y0 >> 8) & 0xff00) | (y0 & 0xff000000) | uv;
-            p[destLineLength] = ((y1 >> 8) & 0xff00) | (y1 & 0xff000000) | uv;
-            p++;
-        }
+void *TIHardwareRenderer::getOverlayBufferAddress(size_t index) const {
+    if (index >= mOverlayAddresses.size()) {
+        return NULL;
+    }
+
+    return mOverlayAddresses[index];
+}
 
-        // skip the next y line, we already converted it
-        ySrc += srcLineLength;
-        p += destLineLength;
+ssize_t TIHardwareRenderer::findOverlayBuffer(const void *data) const {
+    for (size_t i = 0; i < mOverlayAddresses.size(); ++i) {
+        if (mOverlayAddresses[i] == data) {
+            return i;
+        }
     }
+
+    return -1;
 }
 
 void TIHardwareRenderer::render(
@@ -150,32 +118,24 @@ void TIHardwareRenderer::render(
         return;
     }
 
-#if 0
-    size_t i = 0;
-    for (; i < mOverlayAddresses.size(); ++i) {
-        if (mOverlayAddresses[i] == data) {
-            break;
-        }
+    // If the decoder was given the overlay buffers to decode into, the
+    // frame is already where the display wants it and only has to be
+    // queued. Only possible when the decoder outputs CbYCrY itself.
+    ssize_t index = -1;
+    if (mColorFormat == OMX_COLOR_FormatCbYCrY) {
+        index = findOverlayBuffer(data);
+    }
 
-        if (mIsFirstFrame) {
-            LOGI("overlay buffer #%d: %p", i, mOverlayAddresses[i]);
+    if (index >= 0) {
+        if (!mZeroCopy) {
+            LOGI("decoder writes to overlay buffers, not copying frames");
+            mZeroCopy = true;
         }
-    }
 
-    if (i == mOverlayAddresses.size()) {
-        LOGE("No suitable overlay buffer found.");
+        queueOverlayBuffer(index);
         return;
     }
 
-    mOverlay->queueBuffer((void *)i);
-
-    overlay_buffer_t overlay_buffer;
-    if (!mIsFirstFrame) {
-        CHECK_EQ(mOverlay->dequeueBuffer(&overlay_buffer), OK);
-    } else {
-        mIsFirstFrame = false;
-    }
-#else
     if (mColorFormat == OMX_COLOR_FormatYUV420Planar) {
         convertYuv420ToYuv422(
                 mDecodedWidth, mDecodedHeight, data, mOverlayAddresses[mIndex]);
@@ -185,16 +145,22 @@ void TIHardwareRenderer::render(
         memcpy(mOverlayAddresses[mIndex], data, size);
     }
 
-    if (mOverlay->queueBuffer((void *)mIndex) == ALL_BUFFERS_FLUSHED) {
-        mIsFirstFrame = true;
-        if (mOverlay->queueBuffer((void *)mIndex) != 0) {
-            return;
-        }
+    if (!queueOverlayBuffer(mIndex)) {
+        return;
     }
 
     if (++mIndex == mOverlayAddresses.size()) {
         mIndex = 0;
     }
+}
+
+bool TIHardwareRenderer::queueOverlayBuffer(size_t index) {
+    if (mOverlay->queueBuffer((void *)index) == ALL_BUFFERS_FLUSHED) {
+        mIsFirstFrame = true;
+        if (mOverlay->queueBuffer((void *)index) != 0) {
+            return false;
+        }
+    }
 
     overlay_buffer_t overlay_buffer;
     if (!mIsFirstFrame) {
@@ -202,13 +168,12 @@ void TIHardwareRenderer::render(
 
         if (err == ALL_BUFFERS_FLUSHED) {
             mIsFirstFrame = true;
-        } else {
-            return;
         }
     } else {
         mIsFirstFrame = false;
     }
-#endif
+
+    return true;
 }
 
 }  // namespace android
@@ -44,6 +44,13 @@ public:
     virtual void render(
             const void *data, size_t size, void *platformPrivate);
 
+    // The overlay buffers, mFrameSize bytes of CbYCrY each. A decoder that
+    // outputs CbYCrY can be handed these (OMX_UseBuffer) and render() will
+    // then queue its frames to the display without copying them.
+    size_t getOverlayBufferCount() const;
+    void *getOverlayBufferAddress(size_t index) const;
+    size_t getOverlayBufferSize() const { return mFrameSize; }
+
 private:
     sp<ISurface> mISurface;
     size_t mDisplayWidth, mDisplayHeight;
@@ -54,8 +61,12 @@ private:
     sp<Overlay> mOverlay;
     Vector<void *> mOverlayAddresses;
     bool mIsFirstFrame;
+    bool mZeroCopy;
     size_t mIndex;
 
+    ssize_t findOverlayBuffer(const void *data) const;
+    bool queueOverlayBuffer(size_t index);
+
     TIHardwareRenderer(const TIHardwareRenderer &);
     TIHardwareRenderer &operator=(const TIHardwareRenderer &);
 };
@@ -0,0 +1,53 @@
+LOCAL_PATH := $(call my-dir)
+
+# Checks convertYuv420ToYuv422 against the scalar converter
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    yuv422_test.cpp \
+    ../ColorConversion.cpp
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+
+LOCAL_MODULE := stagefrighthw_yuv422_test
+
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# Same test with the NEON path built over a plain C arm_neon.h, so that its
+# loads, stores and strides get checked on the host too
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    yuv422_test.cpp \
+    ../ColorConversion.cpp
+
+LOCAL_CFLAGS += -D__ARM_NEON__
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/neon_emu \
+    $(LOCAL_PATH)/..
+
+LOCAL_MODULE := stagefrighthw_yuv422_neon_emu_test
+
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# Times the converter and the scalar version on a 720p frame
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    yuv422_bench.cpp \
+    ../ColorConversion.cpp
+
+LOCAL_CFLAGS += -O2
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+
+LOCAL_MODULE := stagefrighthw_yuv422_bench
+
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_HOST_EXECUTABLE)
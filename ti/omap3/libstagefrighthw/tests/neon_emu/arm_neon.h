@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2009 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The few NEON intrinsics ColorConversion.cpp uses, in plain C, so that
+// its NEON path can be built and checked on the host.
+
+#ifndef NEON_EMU_ARM_NEON_H_
+
+#define NEON_EMU_ARM_NEON_H_
+
+#include <stdint.h>
+
+typedef struct { uint8_t lane[8]; } uint8x8_t;
+typedef struct { uint8x8_t val[2]; } uint8x8x2_t;
+typedef struct { uint8x8_t val[4]; } uint8x8x4_t;
+
+static inline uint8x8_t vld1_u8(const uint8_t *p) {
+    uint8x8_t r;
+    for (int i = 0; i < 8; ++i) {
+        r.lane[i] = p[i];
+    }
+    return r;
+}
+
+static inline uint8x8x2_t vld2_u8(const uint8_t *p) {
+    uint8x8x2_t r;
+    for (int i = 0; i < 8; ++i) {
+        r.val[0].lane[i] = p[2 * i];
+        r.val[1].lane[i] = p[2 * i + 1];
+    }
+    return r;
+}
+
+static inline void vst4_u8(uint8_t *p, uint8x8x4_t v) {
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            p[4 * i + j] = v.val[j].lane[i];
+        }
+    }
+}
+
+#endif  // NEON_EMU_ARM_NEON_H_
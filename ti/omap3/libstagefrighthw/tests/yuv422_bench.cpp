@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2009 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Times convertYuv420ToYuv422 against the scalar converter.
+//
+//   stagefrighthw_yuv422_bench [width height [frames]]
+//
+// Defaults to 300 frames of 1280x720.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ColorConversion.h"
+
+using namespace android;
+
+typedef void (*ConvertFunc)(int width, int height, const void *src, void *dst);
+
+static int64_t nowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int64_t timeConvert(
+        ConvertFunc convert, int width, int height, int frames,
+        const uint8_t *src, uint8_t *dst) {
+    // once to fault the pages in
+    convert(width, height, src, dst);
+
+    int64_t start = nowUs();
+    for (int i = 0; i < frames; ++i) {
+        convert(width, height, src, dst);
+    }
+
+    return nowUs() - start;
+}
+
+int main(int argc, char **argv) {
+    int width = 1280;
+    int height = 720;
+    int frames = 300;
+
+    if (argc >= 3) {
+        width = atoi(argv[1]);
+        height = atoi(argv[2]);
+    }
+    if (argc >= 4) {
+        frames = atoi(argv[3]);
+    }
+
+    if (width <= 0 || height <= 0 || frames <= 0) {
+        fprintf(stderr, "usage: %s [width height [frames]]\n", argv[0]);
+        return 1;
+    }
+
+    size_t srcSize = width * height * 3 / 2;
+    size_t dstSize = width * height * 2;
+    uint8_t *src = (uint8_t *)malloc(srcSize);
+    uint8_t *dst = (uint8_t *)malloc(dstSize);
+
+    for (size_t i = 0; i < srcSize; ++i) {
+        src[i] = i * 7 + (i >> 9);
+    }
+
+    int64_t scalarUs = timeConvert(
+            convertYuv420ToYuv422Scalar, width, height, frames, src, dst);
+    int64_t fastUs = timeConvert(
+            convertYuv420ToYuv422, width, height, frames, src, dst);
+
+    double mpix = (double)width * height * frames / 1e6;
+
+    printf("%dx%d, %d frames\n", width, height, frames);
+    printf("  scalar:    %8.1f us/frame %8.1f Mpixel/s\n",
+           (double)scalarUs / frames, mpix * 1e6 / scalarUs);
+    printf("  converter: %8.1f us/frame %8.1f Mpixel/s (%.2fx)\n",
+           (double)fastUs / frames, mpix * 1e6 / fastUs,
+           (double)scalarUs / fastUs);
+
+    free(dst);
+    free(src);
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2009 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Checks that convertYuv420ToYuv422 produces the same bytes as the scalar
+// converter for frame sizes that do and do not fill the vector loops, and
+// for buffers at every alignment. Exits non-zero on the first mismatch.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ColorConversion.h"
+
+using namespace android;
+
+static const uint8_t kCanary = 0xa5;
+static const size_t kGuard = 64;
+
+static uint32_t gSeed = 1;
+
+static uint8_t nextByte() {
+    gSeed = gSeed * 1103515245 + 12345;
+    return gSeed >> 16;
+}
+
+static bool checkSize(int width, int height, size_t srcAlign, size_t dstAlign) {
+    size_t srcSize = width * height * 3 / 2;
+    size_t dstSize = width * height * 2;
+
+    uint8_t *src = (uint8_t *)malloc(srcSize + 16);
+    uint8_t *expected = (uint8_t *)malloc(dstSize + kGuard);
+    uint8_t *actual = (uint8_t *)malloc(dstSize + 16 + kGuard);
+
+    uint8_t *s = src + srcAlign;
+    for (size_t i = 0; i < srcSize; ++i) {
+        s[i] = nextByte();
+    }
+
+    memset(expected, kCanary, dstSize + kGuard);
+    memset(actual, kCanary, dstSize + 16 + kGuard);
+
+    uint8_t *d = actual + dstAlign;
+
+    convertYuv420ToYuv422Scalar(width, height, s, expected);
+    convertYuv420ToYuv422(width, height, s, d);
+
+    bool ok = true;
+    for (size_t i = 0; i < dstSize + kGuard; ++i) {
+        if (d[i] != expected[i]) {
+            fprintf(stderr, "%dx%d src+%zu dst+%zu: byte %zu is 0x%02x, "
+                    "expected 0x%02x\n", width, height, srcAlign, dstAlign,
+                    i, d[i], expected[i]);
+            ok = false;
+            break;
+        }
+    }
+
+    for (size_t i = 0; ok && i < dstAlign; ++i) {
+        if (actual[i] != kCanary) {
+            fprintf(stderr, "%dx%d: wrote before the destination\n",
+                    width, height);
+            ok = false;
+        }
+    }
+
+    free(actual);
+    free(expected);
+    free(src);
+
+    return ok;
+}
+
+int main() {
+    int checked = 0;
+
+    // every width up to a few times the widest vector loop, so that all
+    // the tail lengths come up, both on their own and after vector loops
+    for (int width = 4; width <= 80; width += 2) {
+        for (int height = 2; height <= 8; height += 2) {
+            if (!checkSize(width, height, 0, 0)) {
+                return 1;
+            }
+            ++checked;
+        }
+    }
+
+    for (size_t srcAlign = 0; srcAlign < 8; ++srcAlign) {
+        for (size_t dstAlign = 0; dstAlign < 8; ++dstAlign) {
+            if (!checkSize(52, 6, srcAlign, dstAlign)
+                    || !checkSize(64, 4, srcAlign, dstAlign)) {
+                return 1;
+            }
+            checked += 2;
+        }
+    }
+
+    static const struct { int width, height; } kFrames[] = {
+        { 176, 144 }, { 320, 240 }, { 352, 288 }, { 480, 352 },
+        { 640, 480 }, { 720, 480 }, { 800, 480 }, { 1280, 720 },
+    };
+
+    for (size_t i = 0; i < sizeof(kFrames) / sizeof(kFrames[0]); ++i) {
+        if (!checkSize(kFrames[i].width, kFrames[i].height, 0, 0)) {
+            return 1;
+        }
+        ++checked;
+    }
+
+    printf("%d frame sizes match the scalar converter\n", checked);
+
+    return 0;
+}
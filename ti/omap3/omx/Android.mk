@@ -12,6 +12,7 @@ RESOURCE_MANAGER_ENABLED := 0
 PERF_INSTRUMENTATION := 0
 PERF_CUSTOMIZABLE := 1
 PERF_READER := 1
+OMX_TI_RUNTIME := 0
 
 TI_OMX_CFLAGS := -Wall -fpic -pipe -DSTATIC_TABLE -O0 -DOMAP_3430
 ifeq ($(RESOURCE_MANAGER_ENABLED),1)
@@ -20,6 +21,9 @@ endif
 ifeq ($(PERF_INSTRUMENTATION),1)
 TI_OMX_CFLAGS += -D__PERF_INSTRUMENTATION__
 endif
+ifeq ($(OMX_TI_RUNTIME),1)
+TI_OMX_CFLAGS += -DOMX_TI_RUNTIME
+endif
 ifeq ($(BUILD_WITH_TI_AUDIO),1)
 TI_OMX_CFLAGS += -DBUILD_WITH_TI_AUDIO
 BUILD_AAC_DECODER := 1
@@ -65,7 +69,8 @@ TI_OMX_COMP_C_INCLUDES := \
 	$(TI_BRIDGE_INCLUDES) \
 	$(TI_OMX_SYSTEM)/lcml/inc \
 	$(TI_OMX_SYSTEM)/common/inc \
-	$(TI_OMX_SYSTEM)/perf/inc 
+	$(TI_OMX_SYSTEM)/perf/inc \
+	$(TI_OMX_SYSTEM)/omx_runtime/inc
 
 
 ifeq ($(PERF_INSTRUMENTATION),1)
@@ -80,6 +85,9 @@ endif
 #call to common omx & system components
 include $(TI_OMX_SYSTEM)/omx_core/src/Android.mk
 include $(TI_OMX_SYSTEM)/lcml/src/Android.mk
+include $(TI_OMX_SYSTEM)/lcml/tests/Android.mk
+include $(TI_OMX_SYSTEM)/omx_runtime/src/Android.mk
+include $(TI_OMX_SYSTEM)/omx_runtime/tests/Android.mk
 
 #call to audio
 include $(TI_OMX_AUDIO)/aac_dec/src/Android.mk
@@ -127,6 +135,7 @@ include $(TI_OMX_TOP)/core_plugin/Android.mk
 
 #call to ti_omx_config_parser
 include $(TI_OMX_TOP)/ti_omx_config_parser/Android.mk
+include $(TI_OMX_TOP)/ti_omx_config_parser/tests/Android.mk
 
 endif
 
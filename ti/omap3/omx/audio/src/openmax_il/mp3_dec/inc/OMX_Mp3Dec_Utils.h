@@ -46,6 +46,10 @@
 #include <OMX_TI_Debug.h>
 #include "LCML_DspCodec.h"
 
+#ifdef OMX_TI_RUNTIME
+#include "OMX_TI_Runtime.h"
+#endif
+
 #ifdef UNDER_CE
 #include <windows.h>
 #include <oaf_osal.h>
@@ -570,6 +574,13 @@ typedef struct MP3DEC_COMPONENT_PRIVATE
     /** The component thread handle */
     pthread_t ComponentThread;
 
+#ifdef OMX_TI_RUNTIME
+    /** The loop the component thread runs */
+    OMX_TI_RT_LOOP *pRtLoop;
+
+    /** Commands and buffers for the component thread */
+    OMX_TI_RT_CHANNEL *pRtChannel;
+#else
     /** The pipes for sending buffers to the thread */
     int dataPipe[2];
 
@@ -578,6 +589,7 @@ typedef struct MP3DEC_COMPONENT_PRIVATE
 
     /** The pipes for sending command data to the thread */
     int cmdDataPipe[2];
+#endif
 
     /** Set to indicate component is stopping */
     OMX_U32 bIsEOFSent;
@@ -901,6 +913,8 @@ OMX_ERRORTYPE MP3DEC_LCML_Callback (TUsnCodecEvent event,void * args [10]);
 * component are done by this function. 
 *
 * @param pComponentPrivate  This is component's private date structure.
+* @param command  The command, as given to SendCommand.
+* @param commandData  Its parameter, or the mark for OMX_CommandMarkBuffer.
 *
 * @pre          None
 *
@@ -914,7 +928,9 @@ OMX_ERRORTYPE MP3DEC_LCML_Callback (TUsnCodecEvent event,void * args [10]);
 *  @see         None
 */
 /* ================================================================================ * */
-OMX_U32 MP3DEC_HandleCommand (MP3DEC_COMPONENT_PRIVATE *pComponentPrivate);
+OMX_U32 MP3DEC_HandleCommand (MP3DEC_COMPONENT_PRIVATE *pComponentPrivate,
+                              OMX_COMMANDTYPE command,
+                              OMX_U32 commandData);
 
 /* ================================================================================= * */
 /**
@@ -1065,6 +1081,9 @@ void MP3DEC_ClearPending(MP3DEC_COMPONENT_PRIVATE *pComponentPrivate, OMX_BUFFER
 OMX_U32 MP3DEC_IsPending(MP3DEC_COMPONENT_PRIVATE *pComponentPrivate, OMX_BUFFERHEADERTYPE *pBufHdr, OMX_DIRTYPE eDir);
 OMX_U32 MP3DEC_IsValid(MP3DEC_COMPONENT_PRIVATE *pComponentPrivate, OMX_U8 *pBuffer, OMX_DIRTYPE eDir) ;
 void* MP3DEC_ComponentThread (void* pThreadData);
+#ifdef OMX_TI_RUNTIME
+extern const OMX_TI_RT_CALLBACKS MP3DEC_RtCallbacks;
+#endif
 
 /*  =========================================================================*/
 /*  func    GetBits                                                          */
@@ -17,6 +17,10 @@ LOCAL_C_INCLUDES := $(TI_OMX_COMP_C_INCLUDES) \
 LOCAL_SHARED_LIBRARIES := $(TI_OMX_COMP_SHARED_LIBRARIES) \
         liblog
 
+ifeq ($(OMX_TI_RUNTIME),1)
+LOCAL_STATIC_LIBRARIES := libOMX_TI_Runtime
+endif
+
 LOCAL_LDLIBS += \
 	-lpthread \
 	-ldl \
@@ -82,6 +82,106 @@
 
 #include "OMX_Mp3Dec_Utils.h"
 
+/* ================================================================================= * */
+/**
+* @fn MP3DEC_ProcessCommand() Hands a command to MP3DEC_HandleCommand and,
+* once the component has been taken back to loaded, tells the application.
+*
+* @param pComponentPrivate This is component's private date structure.
+* @param command The command.
+* @param commandData Its parameter.
+*
+* @pre          None
+*
+* @post         None
+*
+*  @return      None
+*
+*  @see         None
+*/
+/* ================================================================================ * */
+static void MP3DEC_ProcessCommand (MP3DEC_COMPONENT_PRIVATE *pComponentPrivate,
+                                   OMX_COMMANDTYPE command,
+                                   OMX_U32 commandData)
+{
+    OMX_COMPONENTTYPE *pHandle = pComponentPrivate->pHandle;
+    OMX_U32 nRet;
+
+    nRet = MP3DEC_HandleCommand (pComponentPrivate, command, commandData);
+    if (nRet == EXIT_COMPONENT_THRD) {
+        OMX_PRDSP2(pComponentPrivate->dbg, "Exiting from Component thread\n");
+        MP3DEC_CleanupInitParams(pHandle);
+        OMX_PRSTATE2(pComponentPrivate->dbg, "****************** Component State Set to Loaded\n\n");
+
+        pComponentPrivate->curState = OMX_StateLoaded;
+#ifdef __PERF_INSTRUMENTATION__
+        PERF_Boundary(pComponentPrivate->pPERFcomp,PERF_BoundaryComplete | PERF_BoundaryCleanup);
+#endif
+        if(pComponentPrivate->bPreempted == 0){
+            pComponentPrivate->cbInfo.EventHandler(pHandle, pHandle->pApplicationPrivate,
+                                                   OMX_EventCmdComplete,
+                                                   OMX_ErrorNone,pComponentPrivate->curState, 
+                                                   NULL);
+        }else{
+            pComponentPrivate->cbInfo.EventHandler(pHandle, 
+                                                   pHandle->pApplicationPrivate,
+                                                   OMX_EventError,
+                                                   OMX_ErrorResourcesLost,
+                                                   OMX_TI_ErrorMajor, 
+                                                   NULL);
+            pComponentPrivate->bPreempted = 0;
+        }
+    }
+}
+
+static void MP3DEC_ReportTimeout (MP3DEC_COMPONENT_PRIVATE *pComponentPrivate)
+{
+    OMX_PRSTATE2(pComponentPrivate->dbg, "\n\n\n!!!!!  Component Time Out !!!!!!!!!!!! \n");
+    OMX_PRSTATE2(pComponentPrivate->dbg, "Current State: %d \n", pComponentPrivate->curState);
+
+    OMX_PRDSP2(pComponentPrivate->dbg, "%d:: lcml_nCntOp = %lu\n",__LINE__,pComponentPrivate->lcml_nCntOp);
+    OMX_PRDSP2(pComponentPrivate->dbg, "%d : lcml_nCntIp = %lu\n",__LINE__,pComponentPrivate->lcml_nCntIp);
+    OMX_PRDSP2(pComponentPrivate->dbg, "%d : lcml_nCntIpRes = %lu\n",__LINE__,pComponentPrivate->lcml_nCntIpRes);
+    OMX_PRDSP2(pComponentPrivate->dbg, "%d :: lcml_nCntOpReceived = %lu\n",__LINE__,pComponentPrivate->lcml_nCntOpReceived);
+}
+
+#ifdef OMX_TI_RUNTIME
+static OMX_TI_RT_RESULT MP3DEC_RtCommand (OMX_PTR pPrivate, const OMX_TI_RT_MSG *pMsg)
+{
+    MP3DEC_ProcessCommand ((MP3DEC_COMPONENT_PRIVATE *)pPrivate,
+                           (OMX_COMMANDTYPE)pMsg->nCmd,
+                           pMsg->nParam);
+    return OMX_TI_RT_Continue;
+}
+
+static OMX_TI_RT_RESULT MP3DEC_RtData (OMX_PTR pPrivate, const OMX_TI_RT_MSG *pMsg)
+{
+    MP3DEC_COMPONENT_PRIVATE *pComponentPrivate = (MP3DEC_COMPONENT_PRIVATE *)pPrivate;
+    OMX_ERRORTYPE eError;
+
+    OMX_PRCOMM2(pComponentPrivate->dbg, ":: DATA ring is set in Component Thread\n");
+    eError = MP3DEC_HandleDataBuf_FromApp ((OMX_BUFFERHEADERTYPE *)pMsg->pData,
+                                           pComponentPrivate);
+    if (eError != OMX_ErrorNone) {
+        OMX_ERROR2(pComponentPrivate->dbg, ":: Error From HandleDataBuf_FromApp\n");
+        return OMX_TI_RT_Stop;
+    }
+
+    return OMX_TI_RT_Continue;
+}
+
+static void MP3DEC_RtTimeout (OMX_PTR pPrivate)
+{
+    MP3DEC_ReportTimeout ((MP3DEC_COMPONENT_PRIVATE *)pPrivate);
+}
+
+const OMX_TI_RT_CALLBACKS MP3DEC_RtCallbacks = {
+    MP3DEC_RtCommand,
+    MP3DEC_RtData,
+    MP3DEC_RtTimeout
+};
+#endif
+
 /* ================================================================================= * */
 /**
 * @fn MP3DEC_ComponentThread() This is component thread that keeps listening for
@@ -100,11 +200,12 @@
 /* ================================================================================ * */
 void* MP3DEC_ComponentThread (void* pThreadData)
 {
+#ifndef OMX_TI_RUNTIME
     int status;
     struct timespec tv;
     int fdmax;
     fd_set rfds;
-    OMX_U32 nRet;
+#endif
     OMX_ERRORTYPE eError = OMX_ErrorNone;
     MP3DEC_COMPONENT_PRIVATE* pComponentPrivate = (MP3DEC_COMPONENT_PRIVATE*)pThreadData;
     OMX_COMPONENTTYPE *pHandle = pComponentPrivate->pHandle;
@@ -122,6 +223,19 @@ void* MP3DEC_ComponentThread (void* pThreadData)
                                                PERF_ModuleAudioDecode);
 #endif
 
+#ifdef OMX_TI_RUNTIME
+    eError = OMX_TI_RT_LoopRun (pComponentPrivate->pRtLoop);
+    if (eError != OMX_ErrorNone) {
+        OMX_ERROR4(pComponentPrivate->dbg, ":: Error in the runtime loop\n");
+        pComponentPrivate->cbInfo.EventHandler (pHandle,
+                                                pHandle->pApplicationPrivate,
+                                                OMX_EventError,
+                                                OMX_ErrorInsufficientResources, 
+                                                OMX_TI_ErrorSevere,
+                                                "Error from COmponent Thread in poll");
+    }
+    OMX_PRINT1(pComponentPrivate->dbg, ":: Comp Thrd Exiting here...\n");
+#else
     fdmax = pComponentPrivate->cmdPipe[0];
 
     if (pComponentPrivate->dataPipe[0] > fdmax) {
@@ -152,13 +266,7 @@ void* MP3DEC_ComponentThread (void* pThreadData)
 
 
         if (0 == status) {
-            OMX_PRSTATE2(pComponentPrivate->dbg, "\n\n\n!!!!!  Component Time Out !!!!!!!!!!!! \n");
-            OMX_PRSTATE2(pComponentPrivate->dbg, "Current State: %d \n", pComponentPrivate->curState);
-         
-            OMX_PRDSP2(pComponentPrivate->dbg, "%d:: lcml_nCntOp = %lu\n",__LINE__,pComponentPrivate->lcml_nCntOp);
-            OMX_PRDSP2(pComponentPrivate->dbg, "%d : lcml_nCntIp = %lu\n",__LINE__,pComponentPrivate->lcml_nCntIp);
-            OMX_PRDSP2(pComponentPrivate->dbg, "%d : lcml_nCntIpRes = %lu\n",__LINE__,pComponentPrivate->lcml_nCntIpRes);
-            OMX_PRDSP2(pComponentPrivate->dbg, "%d :: lcml_nCntOpReceived = %lu\n",__LINE__,pComponentPrivate->lcml_nCntOpReceived);
+            MP3DEC_ReportTimeout (pComponentPrivate);
 
             if (pComponentPrivate->bExitCompThrd == 1) {
                 OMX_ERROR4(pComponentPrivate->dbg, ":: Comp Thrd Exiting here...\n");
@@ -192,35 +300,27 @@ void* MP3DEC_ComponentThread (void* pThreadData)
                 break;
             }
         } else if (FD_ISSET (pComponentPrivate->cmdPipe[0], &rfds)) {
-            OMX_PRCOMM2(pComponentPrivate->dbg, ":: CMD pipe is set in Component Thread\n");
-            nRet = MP3DEC_HandleCommand (pComponentPrivate);
-            if (nRet == EXIT_COMPONENT_THRD) {
-                OMX_PRDSP2(pComponentPrivate->dbg, "Exiting from Component thread\n");
-                MP3DEC_CleanupInitParams(pHandle);
-                OMX_PRSTATE2(pComponentPrivate->dbg, "****************** Component State Set to Loaded\n\n");
+            OMX_COMMANDTYPE command;
+            OMX_U32 commandData;
 
-                pComponentPrivate->curState = OMX_StateLoaded;
-#ifdef __PERF_INSTRUMENTATION__
-                PERF_Boundary(pComponentPrivate->pPERFcomp,PERF_BoundaryComplete | PERF_BoundaryCleanup);
-#endif			
-                if(pComponentPrivate->bPreempted == 0){
-                    pComponentPrivate->cbInfo.EventHandler(pHandle, pHandle->pApplicationPrivate,
-                                                           OMX_EventCmdComplete,
-                                                           OMX_ErrorNone,pComponentPrivate->curState, 
-                                                           NULL);
-                }else{
-                    pComponentPrivate->cbInfo.EventHandler(pHandle, 
-                                                           pHandle->pApplicationPrivate,
-                                                           OMX_EventError,
-                                                           OMX_ErrorResourcesLost,
-                                                           OMX_TI_ErrorMajor, 
-                                                           NULL);
-                    pComponentPrivate->bPreempted = 0;
-                }
+            OMX_PRCOMM2(pComponentPrivate->dbg, ":: CMD pipe is set in Component Thread\n");
+            if (read(pComponentPrivate->cmdPipe[0], &command, sizeof (command)) == -1 ||
+                read(pComponentPrivate->cmdDataPipe[0], &commandData, sizeof (commandData)) == -1) {
+                OMX_ERROR4(pComponentPrivate->dbg, ":: Error while reading the command pipes\n");
+                pComponentPrivate->cbInfo.EventHandler (pHandle, 
+                                                        pHandle->pApplicationPrivate,
+                                                        OMX_EventError, 
+                                                        OMX_ErrorHardware,
+                                                        OMX_TI_ErrorSevere,
+                                                        NULL);
+                continue;
             }
+
+            MP3DEC_ProcessCommand (pComponentPrivate, command, commandData);
         }   
     }
 EXIT:
+#endif
 
     pComponentPrivate->bCompThreadStarted = 0;
 
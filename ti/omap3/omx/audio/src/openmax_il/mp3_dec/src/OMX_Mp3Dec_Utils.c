@@ -401,6 +401,26 @@ OMX_ERRORTYPE Mp3Dec_StartCompThread(OMX_HANDLETYPE pComponent)
     pComponentPrivate->num_Reclaimed_Op_Buff = 0;
     pComponentPrivate->bIsEOFSent = 0;
 
+#ifdef OMX_TI_RUNTIME
+    eError = OMX_TI_RT_LoopCreate(&pComponentPrivate->pRtLoop, 1000);
+    if (OMX_ErrorNone != eError) {
+        MP3D_OMX_ERROR_EXIT(eError, OMX_ErrorInsufficientResources,
+                            "Runtime Loop Creation Failed");
+    }
+
+    eError = OMX_TI_RT_ChannelCreate(&pComponentPrivate->pRtChannel,
+                                     pComponentPrivate->pRtLoop,
+                                     OMX_TI_RT_CMD_DEPTH,
+                                     2 * MP3D_MAX_NUM_OF_BUFS,
+                                     &MP3DEC_RtCallbacks,
+                                     pComponentPrivate);
+    if (OMX_ErrorNone != eError) {
+        OMX_TI_RT_LoopDestroy(pComponentPrivate->pRtLoop);
+        pComponentPrivate->pRtLoop = NULL;
+        MP3D_OMX_ERROR_EXIT(eError, OMX_ErrorInsufficientResources,
+                            "Runtime Channel Creation Failed");
+    }
+#else
     nRet = pipe (pComponentPrivate->dataPipe);
     if (0 != nRet) {
         MP3D_OMX_ERROR_EXIT(eError, OMX_ErrorInsufficientResources,
@@ -418,6 +438,7 @@ OMX_ERRORTYPE Mp3Dec_StartCompThread(OMX_HANDLETYPE pComponent)
         MP3D_OMX_ERROR_EXIT(eError, OMX_ErrorInsufficientResources,
                             "Pipe Creation Failed");
     }
+#endif
 
 
 #ifdef UNDER_CE
@@ -428,6 +449,12 @@ OMX_ERRORTYPE Mp3Dec_StartCompThread(OMX_HANDLETYPE pComponent)
                            MP3DEC_ComponentThread, pComponentPrivate);
 #endif                                       
     if ((0 != nRet) || (!pComponentPrivate->ComponentThread)) {
+#ifdef OMX_TI_RUNTIME
+        OMX_TI_RT_ChannelDestroy(pComponentPrivate->pRtChannel);
+        pComponentPrivate->pRtChannel = NULL;
+        OMX_TI_RT_LoopDestroy(pComponentPrivate->pRtLoop);
+        pComponentPrivate->pRtLoop = NULL;
+#endif
         MP3D_OMX_ERROR_EXIT(eError, OMX_ErrorInsufficientResources,
                             "Thread Creation Failed");
     }
@@ -465,7 +492,9 @@ OMX_ERRORTYPE MP3DEC_FreeCompResources(OMX_HANDLETYPE pComponent)
         pHandle->pComponentPrivate;
     OMX_ERRORTYPE eError = OMX_ErrorNone;
     OMX_U32 nIpBuf=0, nOpBuf=0;
+#ifndef OMX_TI_RUNTIME
     int nRet=0;
+#endif
 
     OMX_PRINT1(pComponentPrivate->dbg, ":: Mp3Dec_FreeCompResources\n");
 
@@ -476,6 +505,12 @@ OMX_ERRORTYPE MP3DEC_FreeCompResources(OMX_HANDLETYPE pComponent)
     }
     OMX_PRCOMM2(pComponentPrivate->dbg, ":: Closing pipess.....\n");
 
+#ifdef OMX_TI_RUNTIME
+    OMX_TI_RT_ChannelDestroy(pComponentPrivate->pRtChannel);
+    pComponentPrivate->pRtChannel = NULL;
+    OMX_TI_RT_LoopDestroy(pComponentPrivate->pRtLoop);
+    pComponentPrivate->pRtLoop = NULL;
+#else
     nRet = close (pComponentPrivate->dataPipe[0]);
     if (0 != nRet && OMX_ErrorNone == eError) {
         eError = OMX_ErrorHardware;
@@ -507,6 +542,7 @@ OMX_ERRORTYPE MP3DEC_FreeCompResources(OMX_HANDLETYPE pComponent)
     if (0 != nRet && OMX_ErrorNone == eError) {
         eError = OMX_ErrorHardware;
     }
+#endif
 
     if (pComponentPrivate->bPortDefsAllocated) {
 
@@ -578,6 +614,8 @@ static void signalAlloBufThresholdIfNecessary(
  * component are done by this function. 
  *
  * @param pComponentPrivate  This is component's private date structure.
+ * @param command  The command, as given to SendCommand.
+ * @param commandData  Its parameter, or the mark for OMX_CommandMarkBuffer.
  *
  * @pre          None
  *
@@ -592,18 +630,18 @@ static void signalAlloBufThresholdIfNecessary(
  */
 /* ================================================================================ * */
 
-OMX_U32 MP3DEC_HandleCommand (MP3DEC_COMPONENT_PRIVATE *pComponentPrivate)
+OMX_U32 MP3DEC_HandleCommand (MP3DEC_COMPONENT_PRIVATE *pComponentPrivate,
+                              OMX_COMMANDTYPE command,
+                              OMX_U32 commandData)
 {
-    OMX_U32 i,ret = 0;
+    OMX_U32 i;
     OMX_U16 arr[24];
     OMX_ERRORTYPE eError = OMX_ErrorNone;
     char *pArgs = "damedesuStr";
     OMX_U32 pValues[4];
     OMX_U32 pValues1[4];
     OMX_COMPONENTTYPE *pHandle =(OMX_COMPONENTTYPE *) pComponentPrivate->pHandle;
-    OMX_COMMANDTYPE command;
     OMX_STATETYPE commandedState;
-    OMX_U32 commandData;
     OMX_HANDLETYPE pLcmlHandle = pComponentPrivate->pLcmlHandle;
 
 #ifdef RESOURCE_MANAGER_ENABLED
@@ -612,29 +650,6 @@ OMX_U32 MP3DEC_HandleCommand (MP3DEC_COMPONENT_PRIVATE *pComponentPrivate)
     
     OMX_PRINT1(pComponentPrivate->dbg, ":: >>> Entering HandleCommand Function\n");
 
-    ret = read(pComponentPrivate->cmdPipe[0], &command, sizeof (command));
-    if(ret == -1){
-        MP3D_OMX_ERROR_EXIT(eError, 
-                            OMX_ErrorHardware,
-                            "Error while reading the command pipe");
-        pComponentPrivate->cbInfo.EventHandler (pHandle, 
-                                                pHandle->pApplicationPrivate,
-                                                OMX_EventError, 
-                                                eError,
-                                                OMX_TI_ErrorSevere,
-                                                NULL);
-    }
-    ret = read(pComponentPrivate->cmdDataPipe[0], &commandData, sizeof (commandData));
-    if(ret == -1){
-        MP3D_OMX_ERROR_EXIT(eError, OMX_ErrorHardware,
-                            "Error while reading the commandData pipe");
-        pComponentPrivate->cbInfo.EventHandler (pHandle, 
-                                                pHandle->pApplicationPrivate,
-                                                OMX_EventError, 
-                                                eError,
-                                                OMX_TI_ErrorSevere,
-                                                NULL);
-    }
     OMX_PRDSP2(pComponentPrivate->dbg, "---------------------------------------------\n");
     OMX_PRDSP2(pComponentPrivate->dbg, ":: command = %d\n",command);
     OMX_PRDSP2(pComponentPrivate->dbg, ":: commandData = %ld\n",commandData);
@@ -3611,8 +3626,12 @@ void MP3_ResourceManagerCallback(RMPROXY_COMMANDDATATYPE cbData)
     if (*(cbData.RM_Error) == OMX_RmProxyCallback_ResourcesPreempted) {
         if (pCompPrivate->curState == OMX_StateExecuting ||
             pCompPrivate->curState == OMX_StatePause) {
+#ifdef OMX_TI_RUNTIME
+            OMX_TI_RT_SendCommand(pCompPrivate->pRtChannel, Cmd, state, NULL);
+#else
             write (pCompPrivate->cmdPipe[1], &Cmd, sizeof(Cmd));
             write (pCompPrivate->cmdDataPipe[1], &state ,sizeof(OMX_U32));
+#endif
             pCompPrivate->bPreempted = 1;
         }
     }
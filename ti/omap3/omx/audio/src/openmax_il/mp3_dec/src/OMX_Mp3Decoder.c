@@ -541,7 +541,7 @@ static OMX_ERRORTYPE SendCommand (OMX_HANDLETYPE phandle,
                                   OMX_U32 nParam,OMX_PTR pCmdData)
 {
     OMX_ERRORTYPE eError = OMX_ErrorNone;
-    int nRet;
+    int nRet = 0;
     OMX_COMPONENTTYPE *pHandle = (OMX_COMPONENTTYPE *)phandle;
     MP3DEC_COMPONENT_PRIVATE *pCompPrivate = NULL;
 
@@ -632,6 +632,16 @@ static OMX_ERRORTYPE SendCommand (OMX_HANDLETYPE phandle,
     }
 
 
+#ifdef OMX_TI_RUNTIME
+    if (Cmd == OMX_CommandMarkBuffer) {
+        nParam = (OMX_U32)pCmdData;
+    }
+
+    eError = OMX_TI_RT_SendCommand(pCompPrivate->pRtChannel, Cmd, nParam, pCmdData);
+    if (eError != OMX_ErrorNone) {
+        MP3D_OMX_ERROR_EXIT(eError,OMX_ErrorHardware,"post failed: OMX_ErrorHardware");
+    }
+#else
     nRet = write (pCompPrivate->cmdPipe[1], &Cmd, sizeof(Cmd));
     if (nRet == -1) {
         MP3D_OMX_ERROR_EXIT(eError,OMX_ErrorHardware,"write failed: OMX_ErrorHardware");
@@ -652,6 +662,7 @@ static OMX_ERRORTYPE SendCommand (OMX_HANDLETYPE phandle,
             MP3D_OMX_ERROR_EXIT(eError,OMX_ErrorHardware,"write failed: OMX_ErrorHardware");
         }
     }
+#endif
     OMX_PRINT2(pCompPrivate->dbg, ":: MP3DEC:SendCommand - nRet = %d\n",nRet);
 
 
@@ -1556,8 +1567,12 @@ static OMX_ERRORTYPE EmptyThisBuffer (OMX_HANDLETYPE pComponent,
     pComponentPrivate->pMarkData = pBuffer->pMarkData;
     pComponentPrivate->hMarkTargetComponent = pBuffer->hMarkTargetComponent;
 
+#ifdef OMX_TI_RUNTIME
+    ret = OMX_TI_RT_SendData(pComponentPrivate->pRtChannel, pBuffer) == OMX_ErrorNone ? 0 : -1;
+#else
     ret = write (pComponentPrivate->dataPipe[1], &pBuffer,
                  sizeof(OMX_BUFFERHEADERTYPE*));
+#endif
     if (ret == -1) {
         MP3D_OMX_ERROR_EXIT(eError,OMX_ErrorHardware,"write failed: OMX_ErrorHardware");
     }else{
@@ -1682,8 +1697,12 @@ static OMX_ERRORTYPE FillThisBuffer (OMX_HANDLETYPE pComponent,
     OMX_PRCOMM2(pComponentPrivate->dbg, "Sending Emptied OUT buff %p\n",pBuffer);
     OMX_PRCOMM2(pComponentPrivate->dbg, "------------------------------------------\n");
 
+#ifdef OMX_TI_RUNTIME
+    nRet = OMX_TI_RT_SendData(pComponentPrivate->pRtChannel, pBuffer) == OMX_ErrorNone ? 0 : -1;
+#else
     nRet = write (pComponentPrivate->dataPipe[1], &pBuffer,
                   sizeof (OMX_BUFFERHEADERTYPE*));
+#endif
     if (nRet == -1) {
         MP3D_OMX_ERROR_EXIT(eError,OMX_ErrorHardware,"write failed: OMX_ErrorHardware");
     }else{
@@ -1752,7 +1771,11 @@ static OMX_ERRORTYPE ComponentDeInit(OMX_HANDLETYPE pHandle)
 #endif
 
     pComponentPrivate->bExitCompThrd = 1;
+#ifdef OMX_TI_RUNTIME
+    OMX_TI_RT_LoopStop(pComponentPrivate->pRtLoop);
+#else
     write (pComponentPrivate->cmdPipe[1], &pComponentPrivate->bExitCompThrd, sizeof(OMX_U16));
+#endif
     k = pthread_join(pComponentPrivate->ComponentThread, (void*)&k2);
     if(0 != k) {
         if (OMX_ErrorNone == eError) {
@@ -0,0 +1,399 @@
+/*
+ * Copyright (C) Texas Instruments - http://www.ti.com/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/** OMX_TI_Bitstream.h
+ *  Start code search and bit reading for the config buffer parsers of the
+ *  video decoder and of ti_omx_config_parser.
+ *
+ *  OMX_TI_FindStartCode looks at the stream a machine word at a time: a
+ *  word with no zero byte in it cannot hold the first byte of 00 00 01, so
+ *  on coded data, where zero bytes are rare, most of the buffer is passed
+ *  over without looking at single bytes.
+ *
+ *  OMX_TI_BITREADER keeps 64 bits of the stream in a register and only
+ *  goes back to memory when a read runs past them.  Bits past the end of
+ *  the buffer read as 0.
+ *
+ *  OMX_TI_FindAvcSps and OMX_TI_ParseAvcSps are the video decoder's H.264
+ *  config parse, here so that ti_omx_config_parser's test runs the same
+ *  code against the byte at a time original.
+ *
+ *  Everything is inline so C components and the C++ parser library can
+ *  both use it without linking anything.
+ */
+
+#ifndef __OMX_TI_BITSTREAM_H__
+#define __OMX_TI_BITSTREAM_H__
+
+#include <string.h>
+
+#include <OMX_Types.h>
+
+/* Machine word the start code search reads at a time */
+typedef unsigned long OMX_TI_BS_WORD;
+
+#define OMX_TI_BS_ONES      ((OMX_TI_BS_WORD)~0UL / 0xFF)
+#define OMX_TI_BS_HIGHS     (OMX_TI_BS_ONES * 0x80)
+#define OMX_TI_BS_HASZERO(_w) \
+    ((((_w) - OMX_TI_BS_ONES) & ~(_w) & OMX_TI_BS_HIGHS) != 0)
+
+/* ======================================================================= */
+/**
+ * OMX_TI_FindPrefix() returns the offset of the first 00 00 nThird whose
+ * three bytes all lie in [nFrom, nEnd), or nEnd if there is none.
+ * nThird must not be 0.
+ */
+/* ======================================================================= */
+static inline OMX_U32 OMX_TI_FindPrefix(const OMX_U8 *pBuf, OMX_U32 nFrom,
+                                        OMX_U32 nEnd, OMX_U8 nThird)
+{
+    OMX_U32 i = nFrom;
+    OMX_U32 nLast;
+    OMX_U32 nWord;
+    OMX_U32 nMisalign;
+    OMX_TI_BS_WORD w;
+
+    if (nEnd < 3 || nFrom > nEnd - 3) {
+        return nEnd;
+    }
+    nLast = nEnd - 3;
+
+    for (;;) {
+        /* An aligned word with no zero byte cannot hold the start of a
+         * prefix, so everything up to its end can be passed over */
+        nMisalign = (OMX_U32)((unsigned long)(pBuf + i) & (sizeof(w) - 1));
+        if (nMisalign <= i - nFrom) {
+            nWord = i - nMisalign;
+            while (nWord + sizeof(w) <= nEnd) {
+                memcpy(&w, pBuf + nWord, sizeof(w));
+                if (OMX_TI_BS_HASZERO(w)) {
+                    break;
+                }
+                nWord += sizeof(w);
+                i = nWord;
+            }
+        }
+        if (i > nLast) {
+            return nEnd;
+        }
+        /* Then three, two or one bytes at a time, depending on which of
+         * the next three could still start a prefix */
+        if (pBuf[i + 2] != 0 && pBuf[i + 2] != nThird) {
+            i += 3;
+        }
+        else if (pBuf[i + 1] != 0) {
+            i += 2;
+        }
+        else if (pBuf[i] == 0 && pBuf[i + 2] == nThird) {
+            return i;
+        }
+        else {
+            i++;
+        }
+        if (i > nLast) {
+            return nEnd;
+        }
+    }
+}
+
+/* Start code, 00 00 01 */
+static inline OMX_U32 OMX_TI_FindStartCode(const OMX_U8 *pBuf, OMX_U32 nFrom,
+                                           OMX_U32 nEnd)
+{
+    return OMX_TI_FindPrefix(pBuf, nFrom, nEnd, 0x01);
+}
+
+/* ======================================================================= */
+/**
+ * OMX_TI_CopyRbsp() copies [nFrom, nEnd) of an H.264 NAL unit to pDst,
+ * leaving out the emulation prevention byte of every 00 00 03 inside the
+ * range, and returns the number of bytes written.
+ */
+/* ======================================================================= */
+static inline OMX_U32 OMX_TI_CopyRbsp(OMX_U8 *pDst, const OMX_U8 *pSrc,
+                                      OMX_U32 nFrom, OMX_U32 nEnd)
+{
+    OMX_U32 nOut = 0;
+    OMX_U32 nEpb;
+
+    while (nFrom < nEnd) {
+        nEpb = OMX_TI_FindPrefix(pSrc, nFrom, nEnd, 0x03);
+        if (nEpb == nEnd) {
+            memcpy(pDst + nOut, pSrc + nFrom, nEnd - nFrom);
+            nOut += nEnd - nFrom;
+            break;
+        }
+        memcpy(pDst + nOut, pSrc + nFrom, nEpb + 2 - nFrom);
+        nOut += nEpb + 2 - nFrom;
+        nFrom = nEpb + 3;
+    }
+    return nOut;
+}
+
+typedef struct OMX_TI_BITREADER {
+    const OMX_U8 *pData;
+    OMX_U32 nSize;              /* bytes */
+    OMX_U32 nBitPos;            /* bits read so far */
+    OMX_U64 nCache;             /* 8 bytes from nCacheByte, first in the MSB */
+    OMX_U32 nCacheByte;
+} OMX_TI_BITREADER;
+
+static inline void OMX_TI_BitReaderFill(OMX_TI_BITREADER *pReader,
+                                        OMX_U32 nByte)
+{
+    const OMX_U8 *p = pReader->pData + nByte;
+    OMX_U64 nCache = 0;
+    OMX_U32 i;
+
+    if (nByte + 8 <= pReader->nSize) {
+        nCache = ((OMX_U64)p[0] << 56) | ((OMX_U64)p[1] << 48) |
+                 ((OMX_U64)p[2] << 40) | ((OMX_U64)p[3] << 32) |
+                 ((OMX_U64)p[4] << 24) | ((OMX_U64)p[5] << 16) |
+                 ((OMX_U64)p[6] << 8)  |  (OMX_U64)p[7];
+    }
+    else {
+        for (i = 0; i < 8; i++) {
+            nCache <<= 8;
+            if (nByte + i < pReader->nSize) {
+                nCache |= p[i];
+            }
+        }
+    }
+    pReader->nCache = nCache;
+    pReader->nCacheByte = nByte;
+}
+
+static inline void OMX_TI_BitReaderInit(OMX_TI_BITREADER *pReader,
+                                        const OMX_U8 *pData, OMX_U32 nSize)
+{
+    pReader->pData = pData;
+    pReader->nSize = nSize;
+    pReader->nBitPos = 0;
+    OMX_TI_BitReaderFill(pReader, 0);
+}
+
+/* The next nBits bits, 1 to 32, without moving on */
+static inline OMX_U32 OMX_TI_ShowBits(OMX_TI_BITREADER *pReader, OMX_U32 nBits)
+{
+    OMX_U32 nByte = pReader->nBitPos >> 3;
+    OMX_U32 nShift = pReader->nBitPos - (pReader->nCacheByte << 3);
+
+    if (nByte < pReader->nCacheByte || nShift + nBits > 64) {
+        OMX_TI_BitReaderFill(pReader, nByte);
+        nShift = pReader->nBitPos & 7;
+    }
+    return (OMX_U32)((pReader->nCache << nShift) >> (64 - nBits));
+}
+
+static inline OMX_U32 OMX_TI_ReadBits(OMX_TI_BITREADER *pReader, OMX_U32 nBits)
+{
+    OMX_U32 nVal = OMX_TI_ShowBits(pReader, nBits);
+
+    pReader->nBitPos += nBits;
+    return nVal;
+}
+
+/* Exp-Golomb ue(v).  No valid syntax element has a code with more than 31
+ * leading zeros; longer ones are read as VIDDEC_UVLC_dec reads them, which
+ * keeps the low 32 bits of the value. */
+static inline OMX_U32 OMX_TI_ReadUE(OMX_TI_BITREADER *pReader)
+{
+    OMX_U32 nBits = OMX_TI_ShowBits(pReader, 32);
+    OMX_U32 nLeading = 0;
+
+    while (nBits == 0 && pReader->nBitPos < (pReader->nSize << 3)) {
+        nLeading += 32;
+        pReader->nBitPos += 32;
+        nBits = OMX_TI_ShowBits(pReader, 32);
+    }
+    if (nBits == 0) {
+        return 0xFFFFFFFF;      /* no 1 bit before the end of the buffer */
+    }
+    nLeading += __builtin_clz(nBits);
+    pReader->nBitPos += nLeading & 31;
+    if (nLeading < 32) {
+        return OMX_TI_ReadBits(pReader, nLeading + 1) - 1;
+    }
+    pReader->nBitPos += nLeading - 31;
+    return OMX_TI_ReadBits(pReader, 32) - 1;
+}
+
+/* ======================================================================= */
+/**
+ * OMX_TI_CountPrefixes() returns how many 00 00 nThird lie in the buffer,
+ * not counting one that ends on its last byte.  The video decoder counts
+ * the start codes of an H.264 config buffer with it to tell whether the
+ * SPS and PPS have both arrived.
+ */
+/* ======================================================================= */
+static inline OMX_U32 OMX_TI_CountPrefixes(const OMX_U8 *pBuf, OMX_U32 nLen,
+                                           OMX_U8 nThird)
+{
+    OMX_U32 nPos = 0;
+    OMX_U32 nCount = 0;
+
+    if (nLen < 4) {
+        return 0;
+    }
+    for (;;) {
+        nPos = OMX_TI_FindPrefix(pBuf, nPos, nLen - 1, nThird);
+        if (nPos == nLen - 1) {
+            break;
+        }
+        nCount++;
+        nPos += 3;
+    }
+    return nCount;
+}
+
+/* ======================================================================= */
+/**
+ * OMX_TI_FindAvcSps() looks for the first sequence parameter set NAL unit
+ * of an H.264 byte stream.  On success *pnFrom is the offset of the byte
+ * after its NAL header and *pnEnd that of the start code ending it.  A NAL
+ * unit with no start code after it is not taken, as the decoder cannot
+ * tell whether it is complete.
+ */
+/* ======================================================================= */
+static inline OMX_BOOL OMX_TI_FindAvcSps(const OMX_U8 *pBuf, OMX_U32 nLen,
+                                         OMX_U32 *pnFrom, OMX_U32 *pnEnd)
+{
+    OMX_U32 nPos = 0;
+    OMX_U32 nNext;
+    OMX_U32 nNalUnitType;
+
+    if (nLen < 4) {
+        return OMX_FALSE;
+    }
+    do {
+        /* start codes followed by at least one byte */
+        nNext = OMX_TI_FindStartCode(pBuf, nPos, nLen - 1);
+        if (nNext < nLen - 1) {
+            nPos = nNext + 3;
+        }
+        else if (nPos < nLen - 3) {
+            nPos = nLen - 3;
+        }
+        nNext = OMX_TI_FindStartCode(pBuf, nPos, nLen - 1);
+        if (nNext == nLen - 1) {
+            return OMX_FALSE;
+        }
+        nNalUnitType = pBuf[nPos] & 0x1F;
+        nPos++;
+    } while (nNalUnitType != 7);
+
+    *pnFrom = nPos;
+    *pnEnd = nNext;
+    return OMX_TRUE;
+}
+
+/* The fields of an H.264 sequence parameter set up to the frame cropping,
+ * as far as the baseline and main profile layout goes */
+typedef struct OMX_TI_AVC_SPS {
+    OMX_U32 nProfileIdc;
+    OMX_U32 nConstraintSet0Flag;
+    OMX_U32 nConstraintSet1Flag;
+    OMX_U32 nConstraintSet2Flag;
+    OMX_U32 nReservedZero5bits;
+    OMX_U32 nLevelIdc;
+    OMX_U32 nSeqParameterSetId;
+    OMX_U32 nLog2MaxFrameNumMinus4;
+    OMX_U32 nPicOrderCntType;
+    OMX_U32 nLog2MaxPicOrderCntLsbMinus4;
+    OMX_S32 nOffsetForNonRefPic;
+    OMX_S32 nOffsetForTopToBottomField;
+    OMX_U32 nNumRefFramesInPicOrderCntCycle;
+    OMX_U32 nNumRefFrames;
+    OMX_U32 nGapsInFrameNumValueAllowedFlag;
+    OMX_U32 nPicWidthInMbsMinus1;
+    OMX_U32 nPicHeightInMapUnitsMinus1;
+    OMX_U32 nFrameMbsOnlyFlag;
+    OMX_U32 nMBAdaptiveFrameFieldFlag;
+    OMX_U32 nDirect8x8InferenceFlag;
+    OMX_U32 nFrameCroppingFlag;
+    OMX_U32 nFrameCropLeftOffset;
+    OMX_U32 nFrameCropRightOffset;
+    OMX_U32 nFrameCropTopOffset;
+    OMX_U32 nFrameCropBottomOffset;
+} OMX_TI_AVC_SPS;
+
+/* ======================================================================= */
+/**
+ * OMX_TI_ParseAvcSps() reads the SPS RBSP (emulation prevention bytes
+ * already removed, starting at profile_idc) in pRbsp.  Fields that are not
+ * present in the stream are left 0.
+ */
+/* ======================================================================= */
+static inline void OMX_TI_ParseAvcSps(const OMX_U8 *pRbsp, OMX_U32 nSize,
+                                      OMX_TI_AVC_SPS *pSps)
+{
+    OMX_TI_BITREADER sRbsp;
+    OMX_U32 i;
+
+    memset(pSps, 0, sizeof(*pSps));
+    OMX_TI_BitReaderInit(&sRbsp, pRbsp, nSize);
+
+    pSps->nProfileIdc = OMX_TI_ReadBits(&sRbsp, 8);
+    pSps->nConstraintSet0Flag = OMX_TI_ReadBits(&sRbsp, 1);
+    pSps->nConstraintSet1Flag = OMX_TI_ReadBits(&sRbsp, 1);
+    pSps->nConstraintSet2Flag = OMX_TI_ReadBits(&sRbsp, 1);
+    pSps->nReservedZero5bits = OMX_TI_ReadBits(&sRbsp, 5);
+    pSps->nLevelIdc = OMX_TI_ReadBits(&sRbsp, 8);
+    pSps->nSeqParameterSetId = OMX_TI_ReadUE(&sRbsp);
+    pSps->nLog2MaxFrameNumMinus4 = OMX_TI_ReadUE(&sRbsp);
+    pSps->nPicOrderCntType = OMX_TI_ReadUE(&sRbsp);
+
+    if (pSps->nPicOrderCntType == 0) {
+        pSps->nLog2MaxPicOrderCntLsbMinus4 = OMX_TI_ReadUE(&sRbsp);
+    }
+    else if (pSps->nPicOrderCntType == 1) {
+        /* delta_pic_order_always_zero_flag */
+        OMX_TI_ReadBits(&sRbsp, 1);
+        pSps->nOffsetForNonRefPic = OMX_TI_ReadUE(&sRbsp);
+        if (pSps->nOffsetForNonRefPic > 1) {
+            pSps->nOffsetForNonRefPic = pSps->nOffsetForNonRefPic & 0x1 ?
+                                        pSps->nOffsetForNonRefPic >> 1 :
+                                        -(pSps->nOffsetForNonRefPic >> 1);
+        }
+        pSps->nOffsetForTopToBottomField = OMX_TI_ReadUE(&sRbsp);
+        pSps->nNumRefFramesInPicOrderCntCycle = OMX_TI_ReadUE(&sRbsp);
+        for (i = 0; i < pSps->nNumRefFramesInPicOrderCntCycle; i++) {
+            OMX_TI_ReadUE(&sRbsp); /* offset_for_ref_frame[i] */
+        }
+    }
+
+    pSps->nNumRefFrames = OMX_TI_ReadUE(&sRbsp);
+    pSps->nGapsInFrameNumValueAllowedFlag = OMX_TI_ReadBits(&sRbsp, 1);
+    pSps->nPicWidthInMbsMinus1 = OMX_TI_ReadUE(&sRbsp);
+    pSps->nPicHeightInMapUnitsMinus1 = OMX_TI_ReadUE(&sRbsp);
+    pSps->nFrameMbsOnlyFlag = OMX_TI_ReadBits(&sRbsp, 1);
+    if (!pSps->nFrameMbsOnlyFlag) {
+        pSps->nMBAdaptiveFrameFieldFlag = OMX_TI_ReadBits(&sRbsp, 1);
+    }
+    pSps->nDirect8x8InferenceFlag = OMX_TI_ReadBits(&sRbsp, 1);
+    pSps->nFrameCroppingFlag = OMX_TI_ReadBits(&sRbsp, 1);
+    if (pSps->nFrameCroppingFlag) {
+        pSps->nFrameCropLeftOffset = OMX_TI_ReadUE(&sRbsp);
+        pSps->nFrameCropRightOffset = OMX_TI_ReadUE(&sRbsp);
+        pSps->nFrameCropTopOffset = OMX_TI_ReadUE(&sRbsp);
+        pSps->nFrameCropBottomOffset = OMX_TI_ReadUE(&sRbsp);
+    }
+}
+
+#endif /* __OMX_TI_BITSTREAM_H__ */
@@ -48,7 +48,8 @@ typedef enum
     EMMCodecControlDestroy,
     EMMCodecControlAlgCtrl,
     EMMCodecControlStrmCtrl,
-    EMMCodecControlUsnEos
+    EMMCodecControlUsnEos,
+    EMMCodecControlUnMapBuffer
 }TControlCmd;
 
 
@@ -39,7 +39,16 @@
 #define MAX_STREAMS             10
 
 /* 720p implementation */
-#define MAX_DMM_BUFFERS 20
+#define MAX_DMM_BUFFERS 32
+/* Hash buckets for the mapped buffer cache, a power of 2 */
+#define DMM_CACHE_BUCKETS 64
+
+/* Communication structures: one per input and output queue slot, each in
+ * its own slot COMM_STRUCT_OFFSET bytes in so neighbours never share a
+ * cache line.  The pool is mapped to the DSP once. */
+#define COMM_POOL_SIZE          (2 * QUEUE_SIZE)
+#define COMM_SLOT_SIZE          (sizeof(TArmDspCommunicationStruct) + 256)
+#define COMM_STRUCT_OFFSET      128
 
 /*DSP specific*/
 #define DSP_DOF_IMAGE           "baseimage.dof"
@@ -292,9 +301,18 @@ typedef struct LCML_DSP_INTERFACE
 #ifdef __PERF_INSTRUMENTATION__
     PERF_OBJHANDLE pPERF, pPERFcomp;
 #endif
+    /* Client buffers kept mapped while ReUseMap is set, hashed on their ARM
+     * address.  Chains hold 1-based indices so a zeroed handle is empty. */
     DMM_BUFFER_OBJ mapped_dmm_buffers[MAX_DMM_BUFFERS];
+    OMX_U8 mapped_dmm_next[MAX_DMM_BUFFERS];
+    OMX_U8 mapped_dmm_hash[DMM_CACHE_BUCKETS];
     OMX_U32 mapped_buffer_count;
     OMX_BOOL ReUseMap;
+    /* Communication structure pool, set up by the first QueueBuffer */
+    char *pCommPool;
+    DMM_BUFFER_OBJ commPoolDmmBuf;
+    OMX_U8 commPoolFree[COMM_POOL_SIZE];
+    OMX_U32 commPoolFreeCount;
     pthread_mutex_t m_isStopped_mutex;
 
 }LCML_DSP_INTERFACE;
@@ -61,6 +61,7 @@
 #include <string.h>
 #include "usn.h"
 #include <sys/time.h>
+#include <malloc.h>
 
 #define CEXEC_DONE 1
 /*DSP_HNODE hDasfNode;*/
@@ -118,6 +119,19 @@ static OMX_ERRORTYPE DmmUnMap(DSP_HPROCESSOR ProcHandle,
                               struct OMX_TI_Debug dbg);
 static OMX_ERRORTYPE DeleteDspResource(LCML_DSP_INTERFACE *hInterface);
 static OMX_ERRORTYPE FreeResources(LCML_DSP_INTERFACE *hInterface);
+static TArmDspCommunicationStruct *AllocCommStruct(LCML_DSP_INTERFACE *phandle);
+static OMX_ERRORTYPE MapCommStruct(LCML_DSP_INTERFACE *phandle,
+                                   TArmDspCommunicationStruct *pStruct,
+                                   DMM_BUFFER_OBJ *pDmmBuf);
+static void FreeCommStruct(LCML_DSP_INTERFACE *phandle,
+                           TArmDspCommunicationStruct *pStruct,
+                           DMM_BUFFER_OBJ *pDmmBuf);
+static void DestroyCommPool(LCML_DSP_INTERFACE *phandle);
+static DMM_BUFFER_OBJ *DmmCacheLookup(LCML_DSP_INTERFACE *phandle, void *pArmPtr);
+static DMM_BUFFER_OBJ *DmmCacheInsert(LCML_DSP_INTERFACE *phandle, DMM_BUFFER_OBJ *pDmmBuf);
+static OMX_BOOL DmmCacheRemove(LCML_DSP_INTERFACE *phandle, void *pArmPtr);
+static void DmmCacheClear(LCML_DSP_INTERFACE *phandle);
+static OMX_BOOL DmmCacheHolds(LCML_DSP_INTERFACE *phandle, TArmDspCommunicationStruct *pStruct);
 
 void* MessagingThread(void *arg);
 
@@ -865,7 +879,6 @@ static OMX_ERRORTYPE QueueBuffer (OMX_HANDLETYPE hComponent,
     OMX_U32 streamId = 0;
     DSP_STATUS status;
     OMX_ERRORTYPE eError = OMX_ErrorNone;
-    char * tmp2=NULL;
     DMM_BUFFER_OBJ* pDmmBuf=NULL;
     int commandId;
     struct DSP_MSG msg;
@@ -892,14 +905,12 @@ static OMX_ERRORTYPE QueueBuffer (OMX_HANDLETYPE hComponent,
                        PERF_ModuleSocketNode);
 #endif
     pthread_mutex_lock(&phandle->mutex);
-    LCML_MALLOC(tmp2,sizeof(TArmDspCommunicationStruct) + 256,char);
-    if (tmp2 == NULL)
+    phandle->commStruct = AllocCommStruct(phandle);
+    if (phandle->commStruct == NULL)
     {
             eError = OMX_ErrorInsufficientResources;
             goto MUTEX_UNLOCK;
     }
-    memset(tmp2,0,sizeof(TArmDspCommunicationStruct)+256);
-    phandle->commStruct = (TArmDspCommunicationStruct *)(tmp2 + 128);
     phandle->commStruct->iBufferPtr = (OMX_U32) buffer;
     phandle->commStruct->iBufferSize = bufferLen;
     phandle->commStruct->iParamPtr = (OMX_U32) auxInfo;
@@ -972,11 +983,8 @@ static OMX_ERRORTYPE QueueBuffer (OMX_HANDLETYPE hComponent,
     {
         OMX_ERROR4 (((LCML_CODEC_INTERFACE *)hComponent)->dbg, "Unrecognized buffer type..");
         eError = OMX_ErrorBadParameter;
-        if(tmp2)
-        {
-            free(tmp2);
-            phandle->commStruct = NULL;
-        }
+        FreeCommStruct(phandle, phandle->commStruct, NULL);
+        phandle->commStruct = NULL;
         goto MUTEX_UNLOCK;
     }
     commandId = USN_GPPMSG_SET_BUFF|streamId;
@@ -992,52 +1000,55 @@ static OMX_ERRORTYPE QueueBuffer (OMX_HANDLETYPE hComponent,
     phandle->commStruct->iArmbufferArg = (OMX_U32)buffer;
     if ((buffer != NULL) && (bufferLen != 0))
     {
-        OMX_U32 i;
         DSP_STATUS status;
 
         if (phandle->ReUseMap)
         {
+            DMM_BUFFER_OBJ *pCached = DmmCacheLookup(phandle, buffer);
+
+            if (pCached != NULL && pCached->nSize < bufferLen)
+            {
+                /* Same address but a bigger buffer: the client reallocated it */
+                DmmCacheRemove(phandle, buffer);
+                pCached = NULL;
+            }
+
             mappedBufferFound = false;
-            for(i = 0; i <= phandle->mapped_buffer_count; i++)
+            if (pCached != NULL)
             {
-                if(phandle->mapped_dmm_buffers[i].pAllocated == buffer)
+                mappedBufferFound = true;
+                *pDmmBuf = *pCached;
+                 OMX_PRBUFFER1 (((LCML_CODEC_INTERFACE *)hComponent)->dbg, "Re-using pDmmBuf %p mapped %p\n", pDmmBuf, pDmmBuf->pMapped);
+
+                if(bufType == EMMCodecInputBuffer)
                 {
-                    mappedBufferFound = true;
-                    *pDmmBuf = phandle->mapped_dmm_buffers[i];
-                     OMX_PRBUFFER1 (((LCML_CODEC_INTERFACE *)hComponent)->dbg, "Re-using pDmmBuf %p mapped %p\n", pDmmBuf, pDmmBuf->pMapped);
+                    /* Issue a memory flush for input buffer to ensure cache coherency */
+                    status = DSPProcessor_FlushMemory(phandle->dspCodec->hProc, pDmmBuf->pAllocated, bufferSizeUsed, (bufferSizeUsed > 512*1024) ? 3: 0);
+                    if(DSP_FAILED(status))
+                    {
+                        goto MUTEX_UNLOCK;
+                    }
+                }
 
-                    if(bufType == EMMCodecInputBuffer)
+                else if(bufType == EMMCodecOuputBuffer)
+                {
+                    /* Issue an memory invalidate for output buffer */
+                    if (bufferLen > 512*1024)
                     {
-                        /* Issue a memory flush for input buffer to ensure cache coherency */
-                        status = DSPProcessor_FlushMemory(phandle->dspCodec->hProc, pDmmBuf->pAllocated, bufferSizeUsed, (bufferSizeUsed > 512*1024) ? 3: 0);
+                        status = DSPProcessor_FlushMemory(phandle->dspCodec->hProc, pDmmBuf->pAllocated, bufferLen, 3);
                         if(DSP_FAILED(status))
                         {
                             goto MUTEX_UNLOCK;
                         }
                     }
-
-                    else if(bufType == EMMCodecOuputBuffer)
+                    else
                     {
-                        /* Issue an memory invalidate for output buffer */
-                        if (bufferLen > 512*1024)
-                        {
-                            status = DSPProcessor_FlushMemory(phandle->dspCodec->hProc, pDmmBuf->pAllocated, bufferLen, 3);
-                            if(DSP_FAILED(status))
-                            {
-                                goto MUTEX_UNLOCK;
-                            }
-                        }
-                        else
+                        status = DSPProcessor_InvalidateMemory(phandle->dspCodec->hProc, pDmmBuf->pAllocated, bufferLen);
+                        if(DSP_FAILED(status))
                         {
-                            status = DSPProcessor_InvalidateMemory(phandle->dspCodec->hProc, pDmmBuf->pAllocated, bufferLen);
-                            if(DSP_FAILED(status))
-                            {
-                                goto MUTEX_UNLOCK;
-                            }
+                            goto MUTEX_UNLOCK;
                         }
                     }
-
-                    break;
                 }
             }
 
@@ -1060,10 +1071,8 @@ static OMX_ERRORTYPE QueueBuffer (OMX_HANDLETYPE hComponent,
                 phandle->commStruct->iBufferPtr = (OMX_U32) pDmmBuf->pMapped;
                 /* storing reserve address for buffer */
                 pDmmBuf->bufReserved = pDmmBuf->pReserved;
-                if(phandle->mapped_buffer_count <= MAX_DMM_BUFFERS)
-                {
-                    phandle->mapped_dmm_buffers[phandle->mapped_buffer_count++] = *pDmmBuf;
-                }
+                /* if the cache is full it is unmapped on return like any other */
+                DmmCacheInsert(phandle, pDmmBuf);
             }
         phandle->commStruct->iBufferPtr = (OMX_U32) pDmmBuf->pMapped;
         }
@@ -1113,7 +1122,7 @@ static OMX_ERRORTYPE QueueBuffer (OMX_HANDLETYPE hComponent,
         pDmmBuf->paramReserved = pDmmBuf->pReserved;
     }
 
-    eError = DmmMap(phandle->dspCodec->hProc, sizeof(TArmDspCommunicationStruct),(void *)phandle->commStruct, (pDmmBuf), ((LCML_CODEC_INTERFACE *)hComponent)->dbg);
+    eError = MapCommStruct(phandle, phandle->commStruct, pDmmBuf);
     if (eError != OMX_ErrorNone)
     {
         goto MUTEX_UNLOCK;
@@ -1243,29 +1252,9 @@ static OMX_ERRORTYPE ControlCodec(OMX_HANDLETYPE hComponent,
                 pthread_mutex_unlock(&phandle->m_isStopped_mutex);
             }
 
-            if (phandle->ReUseMap)
-            {
-                OMX_U32 i;
-
-                /* Unmap buffers */
-                for(i=0; i< phandle->mapped_buffer_count; i++)
-                {
-                    DmmUnMap(phandle->dspCodec->hProc,(void*)phandle->mapped_dmm_buffers[i].pMapped,
-                            phandle->mapped_dmm_buffers[i].bufReserved, ((LCML_CODEC_INTERFACE *)hComponent)->dbg);
-                }
-
-                for(i = 0; i <= phandle->mapped_buffer_count; i++)
-                {
-                    phandle->mapped_dmm_buffers[i].pAllocated = 0;
-                    phandle->mapped_dmm_buffers[i].pReserved = 0;
-                    phandle->mapped_dmm_buffers[i].pMapped = 0;
-                    phandle->mapped_dmm_buffers[i].bufReserved = 0;
-                    phandle->mapped_dmm_buffers[i].paramReserved = 0;
-                    phandle->mapped_dmm_buffers[i].nSize = 0;
-                }
-
-                phandle->mapped_buffer_count = 0;
-            }
+            /* Unmap buffers */
+            DmmCacheClear(phandle);
+            DestroyCommPool(phandle);
 
             DeleteDspResource (phandle);
 
@@ -1434,6 +1423,18 @@ static OMX_ERRORTYPE ControlCodec(OMX_HANDLETYPE hComponent,
             break;
         }
 
+        /* the client is freeing a buffer queued with MapReuse: drop its mapping */
+        case EMMCodecControlUnMapBuffer:
+        {
+            pthread_mutex_lock(&phandle->mutex);
+            if (!DmmCacheRemove(phandle, args[0]))
+            {
+                eError = OMX_ErrorBadParameter;
+            }
+            pthread_mutex_unlock(&phandle->mutex);
+            break;
+        }
+
     }
 
 EXIT:
@@ -1561,6 +1562,287 @@ EXIT:
     return eError;
 }
 
+/** ========================================================================
+* AllocCommStruct () takes a zeroed communication structure for QueueBuffer
+* from the pool, creating and mapping the pool the first time.  If the pool
+* is exhausted or could not be mapped the structure comes from the heap and
+* is mapped on its own, as it used to be.
+*
+* @param phandle  - LCML handle, with its mutex held
+*
+* @retval pointer to the structure, NULL if out of memory
+** ==========================================================================*/
+static TArmDspCommunicationStruct *AllocCommStruct(LCML_DSP_INTERFACE *phandle)
+{
+    OMX_ERRORTYPE eError;
+    OMX_U32 nPoolSize = ROUND_TO_PAGESIZE(COMM_POOL_SIZE * COMM_SLOT_SIZE);
+    char *pSlot;
+    OMX_U32 i;
+
+    if (phandle->pCommPool == NULL)
+    {
+        /* page aligned, so slot offsets are offsets into the DSP mapping too */
+        phandle->pCommPool = (char *)memalign(DMM_PAGE_SIZE, nPoolSize);
+        if (phandle->pCommPool != NULL)
+        {
+            memset(phandle->pCommPool, 0, nPoolSize);
+            eError = DmmMap(phandle->dspCodec->hProc, nPoolSize, phandle->pCommPool,
+                            &phandle->commPoolDmmBuf,
+                            ((LCML_CODEC_INTERFACE *)phandle->pCodecinterfacehandle)->dbg);
+            if (eError != OMX_ErrorNone)
+            {
+                free(phandle->pCommPool);
+                phandle->pCommPool = NULL;
+            }
+            else
+            {
+                for (i = 0; i < COMM_POOL_SIZE; i++)
+                {
+                    phandle->commPoolFree[i] = COMM_POOL_SIZE - 1 - i;
+                }
+                phandle->commPoolFreeCount = COMM_POOL_SIZE;
+            }
+        }
+    }
+
+    if (phandle->pCommPool != NULL && phandle->commPoolFreeCount > 0)
+    {
+        pSlot = phandle->pCommPool +
+                phandle->commPoolFree[--phandle->commPoolFreeCount] * COMM_SLOT_SIZE;
+    }
+    else
+    {
+        LCML_MALLOC(pSlot, COMM_SLOT_SIZE, char);
+        if (pSlot == NULL)
+        {
+            return NULL;
+        }
+    }
+    memset(pSlot, 0, COMM_SLOT_SIZE);
+    return (TArmDspCommunicationStruct *)(pSlot + COMM_STRUCT_OFFSET);
+}
+
+/* The pool slot holding a communication structure, or NULL if from the heap */
+static char *CommPoolSlot(LCML_DSP_INTERFACE *phandle, TArmDspCommunicationStruct *pStruct)
+{
+    char *pSlot = (char *)pStruct - COMM_STRUCT_OFFSET;
+
+    if (phandle->pCommPool != NULL && pSlot >= phandle->pCommPool &&
+        pSlot < phandle->pCommPool + COMM_POOL_SIZE * COMM_SLOT_SIZE)
+    {
+        return pSlot;
+    }
+    return NULL;
+}
+
+/** ========================================================================
+* MapCommStruct () gives the DSP address of a communication structure in
+* pDmmBuf->pMapped.  Pool structures are already mapped and only need their
+* cache lines written back, so iArmArg is filled in first; others are mapped
+* here and reserved in pDmmBuf->pReserved.
+*
+* @param phandle  - LCML handle
+* @param pStruct  - structure from AllocCommStruct
+* @param pDmmBuf  - DMM object of the queue slot
+*
+* @retval OMX_ErrorNone  - Success
+*         OMX_ErrorInsufficientResources  -  mapping failed
+** ==========================================================================*/
+static OMX_ERRORTYPE MapCommStruct(LCML_DSP_INTERFACE *phandle,
+                                   TArmDspCommunicationStruct *pStruct,
+                                   DMM_BUFFER_OBJ *pDmmBuf)
+{
+    char *pSlot = CommPoolSlot(phandle, pStruct);
+    DSP_STATUS status;
+
+    if (pSlot == NULL)
+    {
+        return DmmMap(phandle->dspCodec->hProc, sizeof(TArmDspCommunicationStruct),
+                      (void *)pStruct, pDmmBuf,
+                      ((LCML_CODEC_INTERFACE *)phandle->pCodecinterfacehandle)->dbg);
+    }
+
+    pDmmBuf->pMapped = (char *)phandle->commPoolDmmBuf.pMapped + ((char *)pStruct - phandle->pCommPool);
+    pDmmBuf->pReserved = NULL;
+    /* the structure must be complete before it is written back */
+    pStruct->iArmArg = (OMX_U32)pDmmBuf->pMapped;
+    status = DSPProcessor_FlushMemory(phandle->dspCodec->hProc, pStruct,
+                                      sizeof(TArmDspCommunicationStruct), 0);
+    if (DSP_FAILED(status))
+    {
+        return OMX_ErrorHardware;
+    }
+    return OMX_ErrorNone;
+}
+
+/** ========================================================================
+* FreeCommStruct () returns a communication structure to the pool, or
+* unmaps and frees it if it came from the heap.
+*
+* @param phandle  - LCML handle, with its mutex held
+* @param pStruct  - structure from AllocCommStruct
+* @param pDmmBuf  - DMM object of the queue slot, NULL if never mapped
+** ==========================================================================*/
+static void FreeCommStruct(LCML_DSP_INTERFACE *phandle,
+                           TArmDspCommunicationStruct *pStruct,
+                           DMM_BUFFER_OBJ *pDmmBuf)
+{
+    char *pSlot = CommPoolSlot(phandle, pStruct);
+
+    if (pSlot != NULL)
+    {
+        phandle->commPoolFree[phandle->commPoolFreeCount++] =
+            (OMX_U8)((pSlot - phandle->pCommPool) / COMM_SLOT_SIZE);
+        return;
+    }
+
+    if (pDmmBuf != NULL)
+    {
+        DmmUnMap(phandle->dspCodec->hProc, pDmmBuf->pMapped, pDmmBuf->pReserved,
+                 ((LCML_CODEC_INTERFACE *)phandle->pCodecinterfacehandle)->dbg);
+    }
+    pSlot = (char *)pStruct - COMM_STRUCT_OFFSET;
+    LCML_FREE(pSlot);
+}
+
+/* Unmaps and frees the pool; nothing may be in flight */
+static void DestroyCommPool(LCML_DSP_INTERFACE *phandle)
+{
+    if (phandle->pCommPool == NULL)
+    {
+        return;
+    }
+    DmmUnMap(phandle->dspCodec->hProc, phandle->commPoolDmmBuf.pMapped,
+             phandle->commPoolDmmBuf.pReserved,
+             ((LCML_CODEC_INTERFACE *)phandle->pCodecinterfacehandle)->dbg);
+    free(phandle->pCommPool);
+    phandle->pCommPool = NULL;
+    phandle->commPoolFreeCount = 0;
+}
+
+/* Client buffers are at least word aligned and often page aligned */
+static OMX_U32 DmmCacheHash(void *pArmPtr)
+{
+    OMX_U32 key = (OMX_U32)pArmPtr;
+
+    return ((key >> 4) ^ (key >> 12) ^ (key >> 20)) & (DMM_CACHE_BUCKETS - 1);
+}
+
+/** ========================================================================
+* DmmCacheLookup () finds the mapping of a client buffer kept for ReUseMap.
+*
+* @param phandle  - LCML handle, with its mutex held
+* @param pArmPtr  - ARM address of the buffer
+*
+* @retval the cached DMM object, NULL if the buffer is not mapped
+** ==========================================================================*/
+static DMM_BUFFER_OBJ *DmmCacheLookup(LCML_DSP_INTERFACE *phandle, void *pArmPtr)
+{
+    OMX_U32 n = phandle->mapped_dmm_hash[DmmCacheHash(pArmPtr)];
+
+    while (n != 0)
+    {
+        if (phandle->mapped_dmm_buffers[n - 1].pAllocated == pArmPtr)
+        {
+            return &phandle->mapped_dmm_buffers[n - 1];
+        }
+        n = phandle->mapped_dmm_next[n - 1];
+    }
+    return NULL;
+}
+
+/** ========================================================================
+* DmmCacheInsert () keeps a freshly mapped client buffer for later
+* QueueBuffer calls.
+*
+* @param phandle  - LCML handle, with its mutex held
+* @param pDmmBuf  - the mapping, with bufReserved set
+*
+* @retval the cached copy, NULL if the cache is full
+** ==========================================================================*/
+static DMM_BUFFER_OBJ *DmmCacheInsert(LCML_DSP_INTERFACE *phandle, DMM_BUFFER_OBJ *pDmmBuf)
+{
+    OMX_U32 bucket = DmmCacheHash(pDmmBuf->pAllocated);
+    OMX_U32 i;
+
+    if (phandle->mapped_buffer_count >= MAX_DMM_BUFFERS)
+    {
+        return NULL;
+    }
+    for (i = 0; phandle->mapped_dmm_buffers[i].pAllocated != NULL; i++)
+    {
+        /* a free entry is there since the count is below the maximum */
+    }
+
+    phandle->mapped_dmm_buffers[i] = *pDmmBuf;
+    phandle->mapped_dmm_next[i] = phandle->mapped_dmm_hash[bucket];
+    phandle->mapped_dmm_hash[bucket] = (OMX_U8)(i + 1);
+    phandle->mapped_buffer_count++;
+    return &phandle->mapped_dmm_buffers[i];
+}
+
+/** ========================================================================
+* DmmCacheRemove () unmaps a cached client buffer, which must not be queued
+* to the DSP any more.
+*
+* @param phandle  - LCML handle, with its mutex held
+* @param pArmPtr  - ARM address of the buffer
+*
+* @retval OMX_TRUE if the buffer was cached
+** ==========================================================================*/
+static OMX_BOOL DmmCacheRemove(LCML_DSP_INTERFACE *phandle, void *pArmPtr)
+{
+    OMX_U8 *pLink = &phandle->mapped_dmm_hash[DmmCacheHash(pArmPtr)];
+    DMM_BUFFER_OBJ *pDmmBuf;
+    OMX_U32 i;
+
+    while (*pLink != 0)
+    {
+        i = *pLink - 1;
+        pDmmBuf = &phandle->mapped_dmm_buffers[i];
+        if (pDmmBuf->pAllocated == pArmPtr)
+        {
+            DmmUnMap(phandle->dspCodec->hProc, pDmmBuf->pMapped, pDmmBuf->bufReserved,
+                     ((LCML_CODEC_INTERFACE *)phandle->pCodecinterfacehandle)->dbg);
+            *pLink = phandle->mapped_dmm_next[i];
+            phandle->mapped_dmm_next[i] = 0;
+            memset(pDmmBuf, 0, sizeof(DMM_BUFFER_OBJ));
+            phandle->mapped_buffer_count--;
+            return OMX_TRUE;
+        }
+        pLink = &phandle->mapped_dmm_next[i];
+    }
+    return OMX_FALSE;
+}
+
+/* Unmaps every cached client buffer */
+static void DmmCacheClear(LCML_DSP_INTERFACE *phandle)
+{
+    OMX_U32 i;
+
+    for (i = 0; i < MAX_DMM_BUFFERS; i++)
+    {
+        if (phandle->mapped_dmm_buffers[i].pAllocated != NULL)
+        {
+            DmmUnMap(phandle->dspCodec->hProc, phandle->mapped_dmm_buffers[i].pMapped,
+                     phandle->mapped_dmm_buffers[i].bufReserved,
+                     ((LCML_CODEC_INTERFACE *)phandle->pCodecinterfacehandle)->dbg);
+        }
+    }
+    memset(phandle->mapped_dmm_buffers, 0, sizeof(phandle->mapped_dmm_buffers));
+    memset(phandle->mapped_dmm_next, 0, sizeof(phandle->mapped_dmm_next));
+    memset(phandle->mapped_dmm_hash, 0, sizeof(phandle->mapped_dmm_hash));
+    phandle->mapped_buffer_count = 0;
+}
+
+/* Whether the buffer of a returned structure stays mapped in the cache */
+static OMX_BOOL DmmCacheHolds(LCML_DSP_INTERFACE *phandle, TArmDspCommunicationStruct *pStruct)
+{
+    DMM_BUFFER_OBJ *pDmmBuf = DmmCacheLookup(phandle, (void *)pStruct->iArmbufferArg);
+
+    return (pDmmBuf != NULL && (OMX_U32)pDmmBuf->pMapped == pStruct->iBufferPtr) ? OMX_TRUE : OMX_FALSE;
+}
+
 /** ========================================================================
 * FreeResources () method is used to allocate the memory using DMM.
 *
@@ -1603,7 +1885,7 @@ OMX_ERRORTYPE FreeResources (LCML_DSP_INTERFACE *hInterface)
                 codec->g_aNotificationObjects[2] = NULL;
             }
  #endif
-            OMX_DBG_CLOSE((struct OMX_TI_Debug )(((LCML_CODEC_INTERFACE*)hInterface->pCodecinterfacehandle)->dbg));
+            OMX_DBG_CLOSE(((LCML_CODEC_INTERFACE*)hInterface->pCodecinterfacehandle)->dbg);
             LCML_FREE(((LCML_CODEC_INTERFACE*)hInterface->pCodecinterfacehandle));
             hInterface->pCodecinterfacehandle = NULL;
         }
@@ -1851,7 +2133,6 @@ void* MessagingThread(void* arg)
 
                         if (tmpDspStructAddress != NULL)
                         {
-                            char *tmp2 = NULL;
 
                             status = DSPProcessor_InvalidateMemory(hDSPInterface->dspCodec->hProc, tmpDspStructAddress, sizeof(TArmDspCommunicationStruct));
                             if(DSP_FAILED(status))
@@ -1887,7 +2168,7 @@ void* MessagingThread(void* arg)
                                         "GOT MESSAGE EMMCodecBufferProcessed and now unmapping buufer %lx\n size=%ld",
                                              tmpDspStructAddress ->iBufferPtr, tmpDspStructAddress ->iBufferSize);
                                 /* 720p implementation */
-                                if (!hDSPInterface->ReUseMap)
+                                if (!DmmCacheHolds(hDSPInterface, tmpDspStructAddress))
                                 {
                                     DmmUnMap(hDSPInterface->dspCodec->hProc,
                                             (void*)tmpDspStructAddress->iBufferPtr,
@@ -1907,14 +2188,7 @@ void* MessagingThread(void* arg)
 
                             OMX_PRINT2 (((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg, 
                                     "GOT MESSAGE EMMCodecBufferProcessed  and now unmapping  structure =0x%p\n",tmpDspStructAddress );
-                            DmmUnMap(hDSPInterface->dspCodec->hProc, pDmmBuf->pMapped, pDmmBuf->pReserved, ((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg);
-                            tmp2 = (char *)tmpDspStructAddress;
-                            tmp2 = (tmp2 - 128);
-                            if (tmp2)
-                            {
-                                LCML_FREE(tmp2);
-                                tmp2 = NULL;
-                            }
+                            FreeCommStruct(hDSPInterface, tmpDspStructAddress, pDmmBuf);
 
                             /* free(tmpDspStructAddress); */
                             tmpDspStructAddress = NULL;
@@ -1950,7 +2224,6 @@ void* MessagingThread(void* arg)
                                         "LCMLSTOP: %d hDSPInterface->Arminputstorage[i] = %p\n", i, hDSPInterface->Arminputstorage[i]);
                                 if (hDSPInterface->Arminputstorage[i] != NULL)
                                 {
-                                    char *tmp2 = NULL;
                                     /* callback the component with the buffers that are being freed */
                                     tmpDspStructAddress = hDSPInterface->Arminputstorage[i] ;
 
@@ -1978,7 +2251,7 @@ void* MessagingThread(void* arg)
                                             (void *)msg.dwArg1);
                                     if (tmpDspStructAddress->iBufferPtr != (OMX_U32)NULL)
                                     {
-                                        if (!hDSPInterface->ReUseMap)
+                                        if (!DmmCacheHolds(hDSPInterface, tmpDspStructAddress))
                                         {
                                             DmmUnMap(hDSPInterface->dspCodec->hProc,
                                                     (void*)tmpDspStructAddress->iBufferPtr,
@@ -1992,20 +2265,9 @@ void* MessagingThread(void* arg)
                                                  (void*)tmpDspStructAddress->iParamPtr,
                                                  pDmmBuf->paramReserved, ((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg);
                                     }
-                                    DmmUnMap(hDSPInterface->dspCodec->hProc, pDmmBuf->pMapped, pDmmBuf->pReserved, ((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg);
-
-                                    if (NULL != tmpDspStructAddress)
-                                    {
-                                        tmp2 = (char*)tmpDspStructAddress;
-                                        tmp2 = ( tmp2 - 128);
-                                    }
                                     OMX_PRINT1 (((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg, 
                                             "%d :: LCML:: FreeResources\n",__LINE__);
-                                    if (tmp2)
-                                    {
-                                        LCML_FREE(tmp2);
-                                        tmp2 = NULL;
-                                    }
+                                    FreeCommStruct(hDSPInterface, tmpDspStructAddress, pDmmBuf);
                                     hDSPInterface->Arminputstorage[i] = NULL;
                                     tmpDspStructAddress     = NULL;
 #ifdef __PERF_INSTRUMENTATION__
@@ -2022,7 +2284,6 @@ void* MessagingThread(void* arg)
                                         "LCMLSTOP: %d hDSPInterface->Armoutputstorage[k] = %p\n", k, hDSPInterface->Armoutputstorage[k]);
                                 if (hDSPInterface->Armoutputstorage[k] != NULL)
                                 {
-                                    char * tmp2 = NULL;
                                     tmpDspStructAddress = hDSPInterface->Armoutputstorage[k] ;
 
                                     pDmmBuf = hDSPInterface ->dspCodec->OutDmmBuffer;
@@ -2048,7 +2309,7 @@ void* MessagingThread(void* arg)
                                     {
                                         OMX_PRINT1 (((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg, 
                                                 "tmpDspStructAddress ->iBufferPtr is not NULL\n");
-                                        if (!hDSPInterface->ReUseMap)
+                                        if (!DmmCacheHolds(hDSPInterface, tmpDspStructAddress))
                                         {
                                             DmmUnMap(hDSPInterface->dspCodec->hProc,
                                                     (void*)tmpDspStructAddress->iBufferPtr,
@@ -2064,19 +2325,11 @@ void* MessagingThread(void* arg)
                                                  (void*)tmpDspStructAddress->iParamPtr,
                                                  pDmmBuf->paramReserved, ((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg);
                                     }
-                                    DmmUnMap(hDSPInterface->dspCodec->hProc, pDmmBuf->pMapped, pDmmBuf->pReserved, ((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg);
-
-                                    tmp2 = (char *) tmpDspStructAddress;
-                                    tmp2 = ( tmp2 - 128);
                                     OMX_PRINT1 (((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg, 
                                             "%d :: LCML:: FreeResources\n",__LINE__);
-                                    if(tmp2)
-                                    {
-                                        LCML_FREE(tmp2);
-                                        tmp2 = NULL;
-                                    }
-                                    tmpDspStructAddress->iBufSizeUsed = 0;
-                                    args[8] = (void *) tmpDspStructAddress->iBufSizeUsed ;
+                                    FreeCommStruct(hDSPInterface, tmpDspStructAddress, pDmmBuf);
+                                    /* the structure is already released */
+                                    args[8] = (void *) 0;
 
                                     hDSPInterface->Armoutputstorage[k] = NULL;
                                     tmpDspStructAddress = NULL;
@@ -2167,7 +2420,6 @@ void* MessagingThread(void* arg)
                                         "LCMLFLUSH: %d hDSPInterface->Arminputstorage[i] = %p\n", i, hDSPInterface->Arminputstorage[i]);
                                 if (hDSPInterface->Arminputstorage[i] != NULL)
                                 {
-                                    char *tmp2 = NULL;
                                     tmpDspStructAddress = hDSPInterface->Arminputstorage[i] ;
 
                                     pDmmBuf = hDSPInterface ->dspCodec->InDmmBuffer;
@@ -2196,7 +2448,7 @@ void* MessagingThread(void* arg)
                                     if (tmpDspStructAddress->iBufferPtr != (OMX_U32)NULL)
                                     {
                                         /* 720p implementation */
-                                        if (!hDSPInterface->ReUseMap)
+                                        if (!DmmCacheHolds(hDSPInterface, tmpDspStructAddress))
                                         {
                                             DmmUnMap(hDSPInterface->dspCodec->hProc,
                                                     (void*)tmpDspStructAddress->iBufferPtr,
@@ -2212,21 +2464,9 @@ void* MessagingThread(void* arg)
                                                  pDmmBuf->paramReserved, 
                                                  ((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg);
                                     }
-                                    DmmUnMap(hDSPInterface->dspCodec->hProc, pDmmBuf->pMapped, pDmmBuf->pReserved, 
-                                            ((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg);
-
-                                    if (NULL != tmpDspStructAddress)
-                                    {
-                                        tmp2 = (char*)tmpDspStructAddress;
-                                        tmp2 = ( tmp2 - 128);
-                                    }
                                     OMX_PRINT1 (((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg, 
                                             "%d :: LCML:: FreeResources\n",__LINE__);
-                                    if (tmp2)
-                                    {
-                                        LCML_FREE(tmp2);
-                                        tmp2 = NULL;
-                                    }
+                                    FreeCommStruct(hDSPInterface, tmpDspStructAddress, pDmmBuf);
                                     hDSPInterface->Arminputstorage[i] = NULL;
                                     tmpDspStructAddress     = NULL;
 #ifdef __PERF_INSTRUMENTATION__
@@ -2271,7 +2511,6 @@ void* MessagingThread(void* arg)
                                         "LCMLFLUSH: %d hDSPInterface->Armoutputstorage[i] = %p\n", i, hDSPInterface->Armoutputstorage[i]);
                                 if (hDSPInterface->Armoutputstorage[i] != NULL)
                                 {
-                                    char * tmp2 = NULL;
                                     tmpDspStructAddress = hDSPInterface->Armoutputstorage[i] ;
 
                                     pDmmBuf = hDSPInterface ->dspCodec->OutDmmBuffer;
@@ -2298,7 +2537,7 @@ void* MessagingThread(void* arg)
                                         /* 720p implementation */
                                         OMX_PRINT1 (((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg, 
                                                 "tmpDspStructAddress ->iBufferPtr is not NULL\n");
-                                        if (!hDSPInterface->ReUseMap)
+                                        if (!DmmCacheHolds(hDSPInterface, tmpDspStructAddress))
                                         {
                                             DmmUnMap(hDSPInterface->dspCodec->hProc,
                                                     (void*)tmpDspStructAddress->iBufferPtr,
@@ -2316,20 +2555,11 @@ void* MessagingThread(void* arg)
                                                  pDmmBuf->paramReserved, 
                                                  ((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg);
                                     }
-                                    DmmUnMap(hDSPInterface->dspCodec->hProc, pDmmBuf->pMapped, pDmmBuf->pReserved, 
-                                            ((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg);
-
-                                    tmp2 = (char *) tmpDspStructAddress;
-                                    tmp2 = ( tmp2 - 128);
                                     OMX_PRINT1 (((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg, 
                                             "%d :: LCML:: FreeResources\n",__LINE__);
-                                    if(tmp2)
-                                    {
-                                        LCML_FREE(tmp2);
-                                        tmp2 = NULL;
-                                    }
-                                    tmpDspStructAddress->iBufSizeUsed = 0;
-                                    args[8] = (void *) tmpDspStructAddress->iBufSizeUsed ;
+                                    FreeCommStruct(hDSPInterface, tmpDspStructAddress, pDmmBuf);
+                                    /* the structure is already released */
+                                    args[8] = (void *) 0;
 
                                     hDSPInterface->Armoutputstorage[i] = NULL;
                                     tmpDspStructAddress = NULL;
@@ -2375,7 +2605,6 @@ void* MessagingThread(void* arg)
                                         "LCMLFLUSH (port 2): %d hDSPInterface->Arminputstorage[i] = %p (stream ID %lu)\n", i, hDSPInterface->Arminputstorage[i], streamId);
                                 if ((hDSPInterface->Arminputstorage[i] != NULL) && (hDSPInterface->Arminputstorage[i]->iStreamID == streamId))
                                 {
-                                    char *tmp2 = NULL;
                                     tmpDspStructAddress = hDSPInterface->Arminputstorage[i] ;
 
                                     pDmmBuf = hDSPInterface ->dspCodec->InDmmBuffer;
@@ -2403,7 +2632,7 @@ void* MessagingThread(void* arg)
                                     if (tmpDspStructAddress->iBufferPtr != (OMX_U32)NULL)
                                     {
                                         /* 720p implementation */
-                                        if (!hDSPInterface->ReUseMap)
+                                        if (!DmmCacheHolds(hDSPInterface, tmpDspStructAddress))
                                         {
                                             DmmUnMap(hDSPInterface->dspCodec->hProc,
                                                     (void*)tmpDspStructAddress->iBufferPtr,
@@ -2417,18 +2646,9 @@ void* MessagingThread(void* arg)
                                                  (void*)tmpDspStructAddress->iParamPtr,
                                                  pDmmBuf->paramReserved, ((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg);
                                     }
-                                    DmmUnMap(hDSPInterface->dspCodec->hProc, pDmmBuf->pMapped, pDmmBuf->pReserved,
-                                            ((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg);
-
-                                    tmp2 = (char*)tmpDspStructAddress;
-                                    tmp2 = ( tmp2 - 128);
                                     OMX_PRINT1 (((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg, 
                                             "%d :: LCML:: FreeResources\n",__LINE__);
-                                    if (tmp2)
-                                    {
-                                        LCML_FREE(tmp2);
-                                        tmp2 = NULL;
-                                    }
+                                    FreeCommStruct(hDSPInterface, tmpDspStructAddress, pDmmBuf);
                                     hDSPInterface->Arminputstorage[i] = NULL;
                                     tmpDspStructAddress     = NULL;
 #ifdef __PERF_INSTRUMENTATION__
@@ -2457,7 +2677,6 @@ void* MessagingThread(void* arg)
                                         "LCMLFLUSH: %d hDSPInterface->Armoutputstorage[i] = %p (stream id %lu)\n", i, hDSPInterface->Armoutputstorage[i], streamId);
                                 if ((hDSPInterface->Armoutputstorage[i] != NULL) && (hDSPInterface->Armoutputstorage[i]->iStreamID == streamId))
                                 {
-                                    char * tmp2 = NULL;
                                     tmpDspStructAddress = hDSPInterface->Armoutputstorage[i] ;
 
                                     pDmmBuf = hDSPInterface ->dspCodec->OutDmmBuffer;
@@ -2484,7 +2703,7 @@ void* MessagingThread(void* arg)
                                         /* 720p implementation */
                                         OMX_PRINT1 (((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg, 
                                                 "tmpDspStructAddress ->iBufferPtr is not NULL\n");
-                                        if (!hDSPInterface->ReUseMap)
+                                        if (!DmmCacheHolds(hDSPInterface, tmpDspStructAddress))
                                         {
                                             DmmUnMap(hDSPInterface->dspCodec->hProc,
                                                     (void*)tmpDspStructAddress->iBufferPtr,
@@ -2502,20 +2721,11 @@ void* MessagingThread(void* arg)
                                                  pDmmBuf->paramReserved,
                                                  ((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg);
                                     }
-                                    DmmUnMap(hDSPInterface->dspCodec->hProc, pDmmBuf->pMapped, pDmmBuf->pReserved,
-                                            ((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg);
-
-                                    tmp2 = (char *) tmpDspStructAddress;
-                                    tmp2 = ( tmp2 - 128);
                                     OMX_PRINT1 (((LCML_CODEC_INTERFACE *)((LCML_DSP_INTERFACE *)arg)->pCodecinterfacehandle)->dbg, 
                                             "%d :: LCML:: FreeResources\n",__LINE__);
-                                    if(tmp2)
-                                    {
-                                        LCML_FREE(tmp2);
-                                        tmp2 = NULL;
-                                    }
-                                    tmpDspStructAddress->iBufSizeUsed = 0;
-                                    args[8] = (void *) tmpDspStructAddress->iBufSizeUsed ;
+                                    FreeCommStruct(hDSPInterface, tmpDspStructAddress, pDmmBuf);
+                                    /* the structure is already released */
+                                    args[8] = (void *) 0;
 
                                     hDSPInterface->Armoutputstorage[i] = NULL;
                                     tmpDspStructAddress = NULL;
@@ -0,0 +1,30 @@
+ifeq ($(BUILD_LCML_TEST),1)
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+
+# LCML built against MockBridge instead of libbridge, runs on the host
+LOCAL_SRC_FILES:= \
+	../src/LCML_DspCodec.c \
+	MockBridge.c \
+	LCMLBench.c
+
+LOCAL_C_INCLUDES := \
+	$(TI_OMX_INCLUDES) \
+	$(TI_BRIDGE_INCLUDES) \
+	$(TI_OMX_SYSTEM)/common/inc \
+	$(TI_OMX_SYSTEM)/lcml/inc \
+	$(TI_OMX_SYSTEM)/lcml/tests
+
+LOCAL_STATIC_LIBRARIES := liblog
+
+LOCAL_LDLIBS += -lpthread
+
+LOCAL_CFLAGS := -Wall -DOMAP_3430
+
+LOCAL_MODULE_TAGS := tests
+
+LOCAL_MODULE:= LCML_Bench
+
+include $(BUILD_HOST_EXECUTABLE)
+endif
@@ -0,0 +1,367 @@
+/*
+ * Copyright (C) Texas Instruments - http://www.ti.com/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/** LCMLBench.c
+ *  Runs LCML against MockBridge and a socket node that hands every buffer
+ *  straight back, and reports what QueueBuffer costs per buffer: time and
+ *  bridge calls.  The node checks that each communication structure and
+ *  buffer it is given resolves to the ARM buffer the client queued, and the
+ *  run fails if anything is left mapped or reserved at the end.
+ *
+ *  Usage: LCML_Bench [buffers per run]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include <OMX_Types.h>
+#include <OMX_Core.h>
+#include "LCML_DspCodec.h"
+#include "usn.h"
+#include "MockBridge.h"
+
+#define DEPTH           4       /* buffers in flight per port */
+#define REALLOC_EVERY   500     /* buffers between reallocations, MapReuse */
+
+typedef struct BENCH_BUFFER {
+    OMX_U8 *pData;
+    OMX_U32 nSize;
+    int busy;
+} BENCH_BUFFER;
+
+typedef struct BENCH_RUN {
+    const char *name;
+    OMX_U32 inSize;
+    OMX_U32 outSize;
+    int reuse;
+} BENCH_RUN;
+
+static pthread_mutex_t gMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gCond = PTHREAD_COND_INITIALIZER;
+static BENCH_BUFFER gBuffers[2 * DEPTH];     /* even input, odd output */
+static int gStopped;
+static int gErrors;
+
+/* LCML keeps ARM addresses in 32 bits, so buffers must live below 4G */
+static OMX_U8 *AllocBuffer(OMX_U32 nSize)
+{
+    void *p = mmap(NULL, nSize, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+
+    return (p == MAP_FAILED) ? NULL : (OMX_U8 *)p;
+}
+
+static void FreeBuffer(OMX_U8 *pData, OMX_U32 nSize)
+{
+    munmap(pData, nSize);
+}
+
+static unsigned long long NowNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* The socket node: check what arrived, then return it */
+static void NodeHandler(const struct DSP_MSG *pMsg)
+{
+    struct DSP_MSG reply = *pMsg;
+    TArmDspCommunicationStruct *pStruct;
+    OMX_U8 *pData;
+
+    if ((pMsg->dwCmd & 0xffffff00) == USN_GPPMSG_STOP)
+    {
+        reply.dwCmd = USN_DSPACK_STOP;
+        MockBridge_Reply(&reply);
+        return;
+    }
+    if ((pMsg->dwCmd & 0xffffff00) != USN_GPPMSG_SET_BUFF)
+    {
+        return;
+    }
+
+    pStruct = MockBridge_Translate(pMsg->dwArg1, sizeof(TArmDspCommunicationStruct));
+    if (pStruct == NULL)
+    {
+        fprintf(stderr, "node: structure at 0x%lx is not mapped\n", pMsg->dwArg1);
+        gErrors++;
+        return;
+    }
+    pData = MockBridge_Translate(pStruct->iBufferPtr, pStruct->iBufferSize);
+    if (pData == NULL || (OMX_U32)(unsigned long)pData != pStruct->iArmbufferArg)
+    {
+        fprintf(stderr, "node: buffer 0x%lx maps to %p, not 0x%lx\n",
+                pStruct->iBufferPtr, pData, pStruct->iArmbufferArg);
+        gErrors++;
+    }
+    else if (*(OMX_U32 *)pData != pStruct->iUsrArg)
+    {
+        /* a stale mapping would show the old buffer's contents */
+        fprintf(stderr, "node: buffer holds %lu, expected %lu\n",
+                *(OMX_U32 *)pData, pStruct->iUsrArg);
+        gErrors++;
+    }
+    if (pMsg->dwCmd & 1)
+    {
+        pStruct->iBufSizeUsed = pStruct->iBufferSize;
+    }
+
+    reply.dwCmd = USN_DSPMSG_BUFF_FREE | (pMsg->dwCmd & 0xff);
+    MockBridge_Reply(&reply);
+}
+
+static void Callback(TUsnCodecEvent event, void *args[10])
+{
+    int i;
+
+    pthread_mutex_lock(&gMutex);
+    if (event == EMMCodecBufferProcessed)
+    {
+        for (i = 0; i < 2 * DEPTH; i++)
+        {
+            if (gBuffers[i].busy && (void *)gBuffers[i].pData == args[1])
+            {
+                gBuffers[i].busy = 0;
+                break;
+            }
+        }
+        if (i == 2 * DEPTH)
+        {
+            fprintf(stderr, "callback: unknown buffer %p\n", args[1]);
+            gErrors++;
+        }
+    }
+    else if (event == EMMCodecProcessingStoped)
+    {
+        gStopped = 1;
+    }
+    pthread_cond_broadcast(&gCond);
+    pthread_mutex_unlock(&gMutex);
+}
+
+static int CompareU64(const void *a, const void *b)
+{
+    unsigned long long x = *(const unsigned long long *)a;
+    unsigned long long y = *(const unsigned long long *)b;
+
+    return (x > y) - (x < y);
+}
+
+static LCML_DSP_INTERFACE *Open(void)
+{
+    static struct DSP_UUID uuid;
+    static OMX_U16 crPhArgs[] = { END_OF_CR_PHASE_ARGS };
+    LCML_CALLBACKTYPE callbacks;
+    OMX_HANDLETYPE hLcml = NULL;
+    LCML_DSP_INTERFACE *pLcml;
+    LCML_DSP *pDsp;
+
+    if (GetHandle(&hLcml) != OMX_ErrorNone)
+    {
+        return NULL;
+    }
+    pLcml = (LCML_DSP_INTERFACE *)hLcml;
+    pDsp = pLcml->dspCodec;
+    pDsp->NodeInfo.nNumOfDLLs = 0;
+    pDsp->NodeInfo.AllUUIDs[0].uuid = &uuid;
+    pDsp->pCrPhArgs = crPhArgs;
+    pDsp->DeviceInfo.TypeofDevice = 0;
+    pDsp->In_BufInfo.DataTrMethod = DMM_METHOD;
+    pDsp->Out_BufInfo.DataTrMethod = DMM_METHOD;
+
+    callbacks.LCML_Callback = Callback;
+    if (LCML_InitMMCodec(pLcml->pCodecinterfacehandle, NULL, NULL, NULL, &callbacks) != OMX_ErrorNone)
+    {
+        return NULL;
+    }
+    return pLcml;
+}
+
+static int Run(const BENCH_RUN *pRun, int nBuffers)
+{
+    LCML_DSP_INTERFACE *pLcml;
+    OMX_HANDLETYPE hCodec;
+    MOCK_BRIDGE_STATS stats;
+    unsigned long long *pTimes;
+    unsigned long long total = 0, start, t;
+    unsigned long calls;
+    int n, i, reallocs = 0;
+    void *args[10] = {0};
+
+    gStopped = 0;
+    gErrors = 0;
+    for (i = 0; i < 2 * DEPTH; i++)
+    {
+        gBuffers[i].nSize = (i & 1) ? pRun->outSize : pRun->inSize;
+        gBuffers[i].pData = AllocBuffer(gBuffers[i].nSize);
+        gBuffers[i].busy = 0;
+        if (gBuffers[i].pData == NULL)
+        {
+            fprintf(stderr, "%s: out of memory\n", pRun->name);
+            return -1;
+        }
+    }
+    pTimes = malloc(nBuffers * sizeof(*pTimes));
+
+    pLcml = Open();
+    if (pLcml == NULL || pTimes == NULL)
+    {
+        fprintf(stderr, "%s: LCML initialisation failed\n", pRun->name);
+        return -1;
+    }
+    hCodec = pLcml->pCodecinterfacehandle;
+    MockBridge_ResetStats();
+
+    start = NowNs();
+    for (n = 0; n < nBuffers; n++)
+    {
+        BENCH_BUFFER *pBuf = &gBuffers[n % (2 * DEPTH)];
+        int output = n & 1;
+        TMMCodecBufferType type;
+
+        pthread_mutex_lock(&gMutex);
+        while (pBuf->busy)
+        {
+            pthread_cond_wait(&gCond, &gMutex);
+        }
+        pBuf->busy = 1;
+        pthread_mutex_unlock(&gMutex);
+
+        if (pRun->reuse && n > 0 && n % REALLOC_EVERY == 0)
+        {
+            /* the client frees and reallocates a buffer; the address is
+             * likely to come back the same, with different pages behind it */
+            args[0] = pBuf->pData;
+            if (LCML_ControlCodec(hCodec, EMMCodecControlUnMapBuffer, args) != OMX_ErrorNone ||
+                MockBridge_Mappings(pBuf->pData) != 0)
+            {
+                fprintf(stderr, "%s: %p still mapped after unmap\n", pRun->name, pBuf->pData);
+                gErrors++;
+            }
+            FreeBuffer(pBuf->pData, pBuf->nSize);
+            pBuf->pData = AllocBuffer(pBuf->nSize);
+            reallocs++;
+        }
+        *(OMX_U32 *)pBuf->pData = n;
+
+        if (pRun->reuse)
+        {
+            type = output ? EMMCodecOutputBufferMapReuse : EMMCodecInputBufferMapReuse;
+        }
+        else
+        {
+            type = output ? EMMCodecOuputBuffer : EMMCodecInputBuffer;
+        }
+
+        t = NowNs();
+        if (LCML_QueueBuffer(hCodec, type, pBuf->pData, pBuf->nSize,
+                             output ? 0 : pBuf->nSize, NULL, 0,
+                             (OMX_U8 *)(unsigned long)n) != OMX_ErrorNone)
+        {
+            fprintf(stderr, "%s: QueueBuffer %d failed\n", pRun->name, n);
+            gErrors++;
+            break;
+        }
+        pTimes[n] = NowNs() - t;
+        total += pTimes[n];
+    }
+
+    pthread_mutex_lock(&gMutex);
+    for (i = 0; i < 2 * DEPTH; i++)
+    {
+        while (gBuffers[i].busy)
+        {
+            pthread_cond_wait(&gCond, &gMutex);
+        }
+    }
+    pthread_mutex_unlock(&gMutex);
+    t = NowNs() - start;
+    MockBridge_GetStats(&stats);
+
+    LCML_ControlCodec(hCodec, MMCodecControlStop, args);
+    pthread_mutex_lock(&gMutex);
+    while (!gStopped)
+    {
+        pthread_cond_wait(&gCond, &gMutex);
+    }
+    pthread_mutex_unlock(&gMutex);
+    LCML_ControlCodec(hCodec, EMMCodecControlDestroy, args);
+
+    qsort(pTimes, n, sizeof(*pTimes), CompareU64);
+    calls = stats.reserve + stats.unreserve + stats.map + stats.unmap +
+            stats.flush + stats.invalidate + stats.putMessage;
+    printf("%-14s %6d buffers  QueueBuffer avg %6.2f us p99 %6.2f us  "
+           "round trip %6.2f us  bridge calls/buffer %5.2f (map %.2f unmap %.2f)",
+           pRun->name, n, total / 1000.0 / n, pTimes[n * 99 / 100] / 1000.0,
+           t / 1000.0 / n, (double)calls / n,
+           (double)stats.map / n, (double)stats.unmap / n);
+    if (reallocs)
+    {
+        printf("  reallocs %d", reallocs);
+    }
+    printf("\n");
+
+    MockBridge_GetStats(&stats);
+    if (stats.liveMapped || stats.liveReserved)
+    {
+        fprintf(stderr, "%s: %lu mappings and %lu reservations leaked\n",
+                pRun->name, stats.liveMapped, stats.liveReserved);
+        gErrors++;
+    }
+    gErrors += stats.errors;
+
+    for (i = 0; i < 2 * DEPTH; i++)
+    {
+        FreeBuffer(gBuffers[i].pData, gBuffers[i].nSize);
+    }
+    free(pTimes);
+    return gErrors;
+}
+
+int main(int argc, char *argv[])
+{
+    /* syscall round trip, then page table work per 4K page */
+    static const MOCK_BRIDGE_COST cost = { 1500, 250, 100 };
+    static const BENCH_RUN runs[] = {
+        { "audio",        4096,   8192,   0 },
+        { "audio reuse",  4096,   8192,   1 },
+        { "video",        65536,  460800, 0 },
+        { "video reuse",  65536,  460800, 1 },
+    };
+    int nBuffers = (argc > 1) ? atoi(argv[1]) : 20000;
+    int errors = 0;
+    unsigned int i;
+
+    MockBridge_Init(&cost, NodeHandler);
+    for (i = 0; i < sizeof(runs) / sizeof(runs[0]); i++)
+    {
+        int e = Run(&runs[i], nBuffers);
+
+        errors += (e < 0) ? 1 : e;
+    }
+
+    printf("%s\n", errors ? "FAILED" : "passed");
+    return errors ? 1 : 0;
+}
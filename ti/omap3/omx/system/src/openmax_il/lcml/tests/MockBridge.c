@@ -0,0 +1,492 @@
+/*
+ * Copyright (C) Texas Instruments - http://www.ti.com/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/** MockBridge.c
+ *  Host implementation of the libbridge calls LCML makes.  See MockBridge.h.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "MockBridge.h"
+
+#define MOCK_PAGE_SIZE      4096
+#define MOCK_DSP_BASE       0x20000000UL
+#define MOCK_DSP_END        0x80000000UL
+#define MOCK_MAX_REGIONS    256
+#define MOCK_MSG_QUEUE      64
+
+typedef struct MOCK_REGION {
+    DWORD dspAddr;
+    ULONG size;
+    void *mpuAddr;      /* mappings only */
+} MOCK_REGION;
+
+static pthread_mutex_t gLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gMsgCond = PTHREAD_COND_INITIALIZER;
+
+static MOCK_BRIDGE_COST gCost;
+static MOCK_NODE_HANDLER gHandler;
+static MOCK_BRIDGE_STATS gStats;
+
+/* kept sorted on dspAddr so free space is found between neighbours */
+static MOCK_REGION gReserved[MOCK_MAX_REGIONS];
+static int gNumReserved;
+static MOCK_REGION gMapped[MOCK_MAX_REGIONS];
+static int gNumMapped;
+
+static struct DSP_MSG gMsgQueue[MOCK_MSG_QUEUE];
+static int gMsgHead;
+static int gMsgCount;
+
+static int gNode;       /* handles only need to be distinct and non-NULL */
+static int gProc;
+
+static unsigned long long NowNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Spins for the modelled cost of a call; the caller pays it in CPU time */
+static void Spend(unsigned long ns)
+{
+    unsigned long long end = NowNs() + ns;
+
+    while (NowNs() < end)
+    {
+    }
+}
+
+static ULONG Pages(void *pMpuAddr, ULONG ulSize)
+{
+    ULONG first = (ULONG)pMpuAddr / MOCK_PAGE_SIZE;
+    ULONG last = ((ULONG)pMpuAddr + ulSize + MOCK_PAGE_SIZE - 1) / MOCK_PAGE_SIZE;
+
+    return last - first;
+}
+
+void MockBridge_Init(const MOCK_BRIDGE_COST *pCost, MOCK_NODE_HANDLER handler)
+{
+    pthread_mutex_lock(&gLock);
+    gCost = *pCost;
+    gHandler = handler;
+    memset(&gStats, 0, sizeof(gStats));
+    gNumReserved = 0;
+    gNumMapped = 0;
+    gMsgHead = 0;
+    gMsgCount = 0;
+    pthread_mutex_unlock(&gLock);
+}
+
+void MockBridge_Reply(const struct DSP_MSG *pMsg)
+{
+    pthread_mutex_lock(&gLock);
+    if (gMsgCount == MOCK_MSG_QUEUE)
+    {
+        fprintf(stderr, "MockBridge: node message queue overflow\n");
+        gStats.errors++;
+    }
+    else
+    {
+        gMsgQueue[(gMsgHead + gMsgCount) % MOCK_MSG_QUEUE] = *pMsg;
+        gMsgCount++;
+        pthread_cond_broadcast(&gMsgCond);
+    }
+    pthread_mutex_unlock(&gLock);
+}
+
+void *MockBridge_Translate(DWORD dwDspAddr, ULONG ulSize)
+{
+    void *pMpuAddr = NULL;
+    int i;
+
+    pthread_mutex_lock(&gLock);
+    for (i = 0; i < gNumMapped; i++)
+    {
+        if (dwDspAddr >= gMapped[i].dspAddr &&
+            dwDspAddr + ulSize <= gMapped[i].dspAddr + gMapped[i].size)
+        {
+            pMpuAddr = (char *)gMapped[i].mpuAddr + (dwDspAddr - gMapped[i].dspAddr);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&gLock);
+    return pMpuAddr;
+}
+
+int MockBridge_Mappings(const void *pMpuAddr)
+{
+    int i, n = 0;
+
+    pthread_mutex_lock(&gLock);
+    for (i = 0; i < gNumMapped; i++)
+    {
+        if ((const char *)pMpuAddr >= (char *)gMapped[i].mpuAddr &&
+            (const char *)pMpuAddr < (char *)gMapped[i].mpuAddr + gMapped[i].size)
+        {
+            n++;
+        }
+    }
+    pthread_mutex_unlock(&gLock);
+    return n;
+}
+
+void MockBridge_GetStats(MOCK_BRIDGE_STATS *pStats)
+{
+    pthread_mutex_lock(&gLock);
+    *pStats = gStats;
+    pStats->liveReserved = gNumReserved;
+    pStats->liveMapped = gNumMapped;
+    pthread_mutex_unlock(&gLock);
+}
+
+void MockBridge_ResetStats(void)
+{
+    pthread_mutex_lock(&gLock);
+    memset(&gStats, 0, sizeof(gStats));
+    pthread_mutex_unlock(&gLock);
+}
+
+/* -------------------------------------------------------------------- */
+/* DSPManager                                                           */
+/* -------------------------------------------------------------------- */
+
+DBAPI DspManager_Open(UINT argc, PVOID argp)
+{
+    return DSP_SOK;
+}
+
+DBAPI DspManager_Close(UINT argc, PVOID argp)
+{
+    return DSP_SOK;
+}
+
+DBAPI DSPManager_RegisterObject(struct DSP_UUID *pUuid, DSP_DCDOBJTYPE objType,
+                                CHAR *pszPathName)
+{
+    return DSP_SOK;
+}
+
+DBAPI DSPManager_UnregisterObject(struct DSP_UUID *pUuid, DSP_DCDOBJTYPE objType)
+{
+    return DSP_SOK;
+}
+
+/* Only the node message notification (index 0) is ever signalled */
+DBAPI DSPManager_WaitForEvents(struct DSP_NOTIFICATION **aNotifications,
+                               UINT uCount, OUT UINT *puIndex, UINT uTimeout)
+{
+    struct timespec deadline;
+    DSP_STATUS status = DSP_SOK;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += uTimeout / 1000;
+    deadline.tv_nsec += (uTimeout % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&gLock);
+    while (gMsgCount == 0)
+    {
+        if (pthread_cond_timedwait(&gMsgCond, &gLock, &deadline) == ETIMEDOUT)
+        {
+            status = DSP_ETIMEOUT;
+            break;
+        }
+    }
+    if (gMsgCount != 0)
+    {
+        status = DSP_SOK;
+        *puIndex = 0;
+    }
+    pthread_mutex_unlock(&gLock);
+    return status;
+}
+
+/* -------------------------------------------------------------------- */
+/* DSPProcessor                                                         */
+/* -------------------------------------------------------------------- */
+
+DBAPI DSPProcessor_Attach(UINT uProcessor,
+                          OPTIONAL CONST struct DSP_PROCESSORATTRIN *pAttrIn,
+                          OUT DSP_HPROCESSOR *phProcessor)
+{
+    *phProcessor = &gProc;
+    return DSP_SOK;
+}
+
+DBAPI DSPProcessor_Detach(DSP_HPROCESSOR hProcessor)
+{
+    return DSP_SOK;
+}
+
+DBAPI DSPProcessor_RegisterNotify(DSP_HPROCESSOR hProcessor, UINT uEventMask,
+                                  UINT uNotifyType, struct DSP_NOTIFICATION *hNotification)
+{
+    return DSP_SOK;
+}
+
+DBAPI DSPProcessor_GetState(DSP_HPROCESSOR hProcessor,
+                            OUT struct DSP_PROCESSORSTATE *pProcStatus,
+                            UINT uStateInfoSize)
+{
+    memset(pProcStatus, 0, uStateInfoSize);
+    return DSP_SOK;
+}
+
+DBAPI DSPProcessor_ReserveMemory(DSP_HPROCESSOR hProcessor, ULONG ulSize,
+                                 PVOID *ppRsvAddr)
+{
+    DWORD addr = MOCK_DSP_BASE;
+    int i;
+
+    ulSize = (ulSize + MOCK_PAGE_SIZE - 1) & ~(MOCK_PAGE_SIZE - 1);
+
+    pthread_mutex_lock(&gLock);
+    Spend(gCost.ioctl);
+    gStats.reserve++;
+    /* first fit */
+    for (i = 0; i < gNumReserved; i++)
+    {
+        if (addr + ulSize <= gReserved[i].dspAddr)
+        {
+            break;
+        }
+        addr = gReserved[i].dspAddr + gReserved[i].size;
+    }
+    if (gNumReserved == MOCK_MAX_REGIONS || addr + ulSize > MOCK_DSP_END)
+    {
+        gStats.errors++;
+        pthread_mutex_unlock(&gLock);
+        return DSP_EMEMORY;
+    }
+    memmove(&gReserved[i + 1], &gReserved[i], (gNumReserved - i) * sizeof(MOCK_REGION));
+    gReserved[i].dspAddr = addr;
+    gReserved[i].size = ulSize;
+    gReserved[i].mpuAddr = NULL;
+    gNumReserved++;
+    pthread_mutex_unlock(&gLock);
+
+    *ppRsvAddr = (PVOID)addr;
+    return DSP_SOK;
+}
+
+DBAPI DSPProcessor_UnReserveMemory(DSP_HPROCESSOR hProcessor, PVOID pRsvAddr)
+{
+    int i;
+
+    pthread_mutex_lock(&gLock);
+    Spend(gCost.ioctl);
+    gStats.unreserve++;
+    for (i = 0; i < gNumReserved; i++)
+    {
+        if (gReserved[i].dspAddr == (DWORD)pRsvAddr)
+        {
+            memmove(&gReserved[i], &gReserved[i + 1], (gNumReserved - i - 1) * sizeof(MOCK_REGION));
+            gNumReserved--;
+            pthread_mutex_unlock(&gLock);
+            return DSP_SOK;
+        }
+    }
+    fprintf(stderr, "MockBridge: unreserve of unknown address %p\n", pRsvAddr);
+    gStats.errors++;
+    pthread_mutex_unlock(&gLock);
+    return DSP_EHANDLE;
+}
+
+/* The DSP address keeps the offset of the ARM buffer in its page, as the
+ * real bridge does */
+DBAPI DSPProcessor_Map(DSP_HPROCESSOR hProcessor, PVOID pMpuAddr, ULONG ulSize,
+                       PVOID pReqAddr, PVOID *ppMapAddr, ULONG ulMapAttr)
+{
+    DWORD addr = (DWORD)pReqAddr + ((ULONG)pMpuAddr & (MOCK_PAGE_SIZE - 1));
+    int i;
+
+    pthread_mutex_lock(&gLock);
+    Spend(gCost.ioctl + gCost.mapPerPage * Pages(pMpuAddr, ulSize));
+    gStats.map++;
+    for (i = 0; i < gNumReserved; i++)
+    {
+        if (addr >= gReserved[i].dspAddr &&
+            addr + ulSize <= gReserved[i].dspAddr + gReserved[i].size)
+        {
+            break;
+        }
+    }
+    if (i == gNumReserved || gNumMapped == MOCK_MAX_REGIONS)
+    {
+        fprintf(stderr, "MockBridge: map of %p outside a reservation\n", pMpuAddr);
+        gStats.errors++;
+        pthread_mutex_unlock(&gLock);
+        return DSP_EINVALIDARG;
+    }
+    gMapped[gNumMapped].dspAddr = addr;
+    gMapped[gNumMapped].size = ulSize;
+    gMapped[gNumMapped].mpuAddr = pMpuAddr;
+    gNumMapped++;
+    pthread_mutex_unlock(&gLock);
+
+    *ppMapAddr = (PVOID)addr;
+    return DSP_SOK;
+}
+
+DBAPI DSPProcessor_UnMap(DSP_HPROCESSOR hProcessor, PVOID pMapAddr)
+{
+    int i;
+
+    pthread_mutex_lock(&gLock);
+    gStats.unmap++;
+    for (i = 0; i < gNumMapped; i++)
+    {
+        if (gMapped[i].dspAddr == (DWORD)pMapAddr)
+        {
+            Spend(gCost.ioctl + gCost.unmapPerPage * Pages(gMapped[i].mpuAddr, gMapped[i].size));
+            gMapped[i] = gMapped[--gNumMapped];
+            pthread_mutex_unlock(&gLock);
+            return DSP_SOK;
+        }
+    }
+    Spend(gCost.ioctl);
+    fprintf(stderr, "MockBridge: unmap of unknown address %p\n", pMapAddr);
+    gStats.errors++;
+    pthread_mutex_unlock(&gLock);
+    return DSP_EHANDLE;
+}
+
+DBAPI DSPProcessor_FlushMemory(DSP_HPROCESSOR hProcessor, PVOID pMpuAddr,
+                               ULONG ulSize, ULONG ulFlags)
+{
+    pthread_mutex_lock(&gLock);
+    Spend(gCost.ioctl);
+    gStats.flush++;
+    pthread_mutex_unlock(&gLock);
+    return DSP_SOK;
+}
+
+DBAPI DSPProcessor_InvalidateMemory(DSP_HPROCESSOR hProcessor, PVOID pMpuAddr,
+                                    ULONG ulSize)
+{
+    pthread_mutex_lock(&gLock);
+    Spend(gCost.ioctl);
+    gStats.invalidate++;
+    pthread_mutex_unlock(&gLock);
+    return DSP_SOK;
+}
+
+/* -------------------------------------------------------------------- */
+/* DSPNode                                                              */
+/* -------------------------------------------------------------------- */
+
+DBAPI DSPNode_Allocate(DSP_HPROCESSOR hProcessor, IN CONST struct DSP_UUID *pNodeID,
+                       IN CONST OPTIONAL struct DSP_CBDATA *pArgs,
+                       IN OPTIONAL struct DSP_NODEATTRIN *pAttrIn,
+                       OUT DSP_HNODE *phNode)
+{
+    *phNode = &gNode;
+    return DSP_SOK;
+}
+
+DBAPI DSPNode_Connect(DSP_HNODE hNode, UINT uStream, DSP_HNODE hOtherNode,
+                      UINT uOtherStream, IN OPTIONAL struct DSP_STRMATTR *pAttr)
+{
+    return DSP_SOK;
+}
+
+DBAPI DSPNode_ConnectEx(DSP_HNODE hNode, UINT uStream, DSP_HNODE hOtherNode,
+                        UINT uOtherStream, IN OPTIONAL struct DSP_STRMATTR *pAttr,
+                        IN OPTIONAL struct DSP_CBDATA *pConnParam)
+{
+    return DSP_SOK;
+}
+
+DBAPI DSPNode_Create(DSP_HNODE hNode)
+{
+    return DSP_SOK;
+}
+
+DBAPI DSPNode_Run(DSP_HNODE hNode)
+{
+    return DSP_SOK;
+}
+
+DBAPI DSPNode_RegisterNotify(DSP_HNODE hNode, UINT uEventMask, UINT uNotifyType,
+                             struct DSP_NOTIFICATION *hNotification)
+{
+    return DSP_SOK;
+}
+
+DBAPI DSPNode_GetAttr(DSP_HNODE hNode, OUT struct DSP_NODEATTR *pAttr, UINT uAttrSize)
+{
+    memset(pAttr, 0, uAttrSize);
+    pAttr->iNodeInfo.nsExecutionState = NODE_RUNNING;
+    return DSP_SOK;
+}
+
+DBAPI DSPNode_Terminate(DSP_HNODE hNode, DSP_STATUS *pStatus)
+{
+    *pStatus = DSP_SOK;
+    return DSP_SOK;
+}
+
+DBAPI DSPNode_Delete(DSP_HNODE hNode)
+{
+    return DSP_SOK;
+}
+
+DBAPI DSPNode_PutMessage(DSP_HNODE hNode, IN CONST struct DSP_MSG *pMessage,
+                         UINT uTimeout)
+{
+    pthread_mutex_lock(&gLock);
+    Spend(gCost.ioctl);
+    gStats.putMessage++;
+    pthread_mutex_unlock(&gLock);
+
+    if (gHandler != NULL)
+    {
+        gHandler(pMessage);
+    }
+    return DSP_SOK;
+}
+
+DBAPI DSPNode_GetMessage(DSP_HNODE hNode, OUT struct DSP_MSG *pMessage, UINT uTimeout)
+{
+    DSP_STATUS status = DSP_ETIMEOUT;
+
+    pthread_mutex_lock(&gLock);
+    Spend(gCost.ioctl);
+    gStats.getMessage++;
+    if (gMsgCount != 0)
+    {
+        *pMessage = gMsgQueue[gMsgHead];
+        gMsgHead = (gMsgHead + 1) % MOCK_MSG_QUEUE;
+        gMsgCount--;
+        status = DSP_SOK;
+    }
+    pthread_mutex_unlock(&gLock);
+    return status;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) Texas Instruments - http://www.ti.com/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/** MockBridge.h
+ *  A host stand-in for libbridge, enough of it to run LCML.  DSP address
+ *  space is reserved and mapped for real (the DSP side can translate a DSP
+ *  address back to the ARM buffer behind it), every ioctl costs a modelled
+ *  amount of CPU time, and messages put to the node go to a handler that
+ *  plays the socket node.
+ */
+
+#ifndef __MOCK_BRIDGE_H__
+#define __MOCK_BRIDGE_H__
+
+#include <dbapi.h>
+
+/* Time the calls cost the caller, in ns: a fixed syscall price plus, for
+ * maps and unmaps, a price per 4K page for the page table walk */
+typedef struct MOCK_BRIDGE_COST {
+    unsigned long ioctl;
+    unsigned long mapPerPage;
+    unsigned long unmapPerPage;
+} MOCK_BRIDGE_COST;
+
+typedef struct MOCK_BRIDGE_STATS {
+    unsigned long reserve;
+    unsigned long unreserve;
+    unsigned long map;
+    unsigned long unmap;
+    unsigned long flush;
+    unsigned long invalidate;
+    unsigned long putMessage;
+    unsigned long getMessage;
+    unsigned long liveReserved;     /* reservations not given back */
+    unsigned long liveMapped;       /* mappings not undone */
+    unsigned long errors;           /* bad addresses, double unmaps ... */
+} MOCK_BRIDGE_STATS;
+
+/* Called for each DSPNode_PutMessage, on the caller's thread */
+typedef void (*MOCK_NODE_HANDLER)(const struct DSP_MSG *pMsg);
+
+void MockBridge_Init(const MOCK_BRIDGE_COST *pCost, MOCK_NODE_HANDLER handler);
+
+/* Queues a message from the node and signals the node notification */
+void MockBridge_Reply(const struct DSP_MSG *pMsg);
+
+/* ARM address behind ulSize bytes at a DSP address, NULL if any is unmapped */
+void *MockBridge_Translate(DWORD dwDspAddr, ULONG ulSize);
+
+/* Number of live mappings covering an ARM address */
+int MockBridge_Mappings(const void *pMpuAddr);
+
+void MockBridge_GetStats(MOCK_BRIDGE_STATS *pStats);
+void MockBridge_ResetStats(void);
+
+#endif /* __MOCK_BRIDGE_H__ */
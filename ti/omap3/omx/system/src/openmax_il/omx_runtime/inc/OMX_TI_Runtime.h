@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) Texas Instruments - http://www.ti.com/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/** OMX_TI_Runtime.h
+ *  Component thread runtime, an alternative to the cmdPipe/dataPipe and
+ *  pselect loop each component thread runs.
+ *
+ *  A component opens a channel on a loop.  The channel carries two rings,
+ *  commands and buffers, each written by the OMX API calls (SendCommand,
+ *  EmptyThisBuffer, FillThisBuffer) and read by the loop thread, which
+ *  hands every message to the component's callbacks.  Posting a message is
+ *  a store to the ring; the loop's eventfd is only written when the loop
+ *  thread has gone to sleep, so a busy component takes buffers without a
+ *  syscall.  One loop can serve several channels, and so several
+ *  components, from a single thread.
+ *
+ *  Each ring has one reader, the loop.  Writers are serialised by a mutex
+ *  on the ring, which costs no syscall unless two OMX callers really do
+ *  post to the same component at the same time.  Every post is stamped
+ *  from a sequence of the channel, and the loop always takes the message
+ *  with the lower stamp of the two rings, so commands and buffers are
+ *  handled in the order they were posted.
+ */
+
+#ifndef __OMX_TI_RUNTIME_H__
+#define __OMX_TI_RUNTIME_H__
+
+#include <pthread.h>
+
+#include <OMX_Types.h>
+#include <OMX_Core.h>
+
+/* Default ring sizes, in messages.  A data ring needs room for every buffer
+ * the component can have queued, that is all the buffers of both ports. */
+#define OMX_TI_RT_CMD_DEPTH         16
+#define OMX_TI_RT_DATA_DEPTH        64
+
+/* What a callback wants done with its channel */
+typedef enum OMX_TI_RT_RESULT {
+    OMX_TI_RT_Continue = 0,
+    OMX_TI_RT_Stop              /* stop the loop, as OMX_TI_RT_LoopStop */
+} OMX_TI_RT_RESULT;
+
+typedef struct OMX_TI_RT_MSG {
+    OMX_U32 nCmd;               /* OMX_COMMANDTYPE, 0 on the data ring */
+    OMX_U32 nParam;
+    OMX_PTR pData;              /* command data or buffer header */
+    OMX_U32 nSeq;               /* posting order on the channel, set on post */
+} OMX_TI_RT_MSG;
+
+typedef struct OMX_TI_RT_CALLBACKS {
+    OMX_TI_RT_RESULT (*Command)(OMX_PTR pPrivate, const OMX_TI_RT_MSG *pMsg);
+    OMX_TI_RT_RESULT (*Data)(OMX_PTR pPrivate, const OMX_TI_RT_MSG *pMsg);
+    /* Optional, called when the loop has been idle for its timeout */
+    void (*Timeout)(OMX_PTR pPrivate);
+} OMX_TI_RT_CALLBACKS;
+
+typedef struct OMX_TI_RT_RING {
+    OMX_TI_RT_MSG *pSlots;
+    OMX_U32 nMask;
+    volatile OMX_U32 nHead;     /* next slot to read, loop thread only */
+    volatile OMX_U32 nTail;     /* next slot to write, under writeLock */
+    pthread_mutex_t writeLock;
+} OMX_TI_RT_RING;
+
+typedef struct OMX_TI_RT_STATS {
+    OMX_U32 nCommands;          /* messages handed to callbacks */
+    OMX_U32 nBuffers;
+    OMX_U32 nWakeups;           /* times the loop thread slept and woke */
+    OMX_U32 nSignals;           /* eventfd writes by posters */
+    OMX_U32 nTimeouts;
+    OMX_U32 nRingFull;          /* posts refused for a full ring */
+} OMX_TI_RT_STATS;
+
+typedef struct OMX_TI_RT_LOOP OMX_TI_RT_LOOP;
+
+typedef struct OMX_TI_RT_CHANNEL {
+    OMX_TI_RT_LOOP *pLoop;
+    OMX_TI_RT_RING cmdRing;
+    OMX_TI_RT_RING dataRing;
+    volatile OMX_U32 nPostSeq;  /* stamp of the next message posted */
+    const OMX_TI_RT_CALLBACKS *pCallbacks;
+    OMX_PTR pPrivate;
+    struct OMX_TI_RT_CHANNEL *pNext;
+} OMX_TI_RT_CHANNEL;
+
+struct OMX_TI_RT_LOOP {
+    int wakeFd[2];              /* eventfd twice, or a pipe without one */
+    volatile OMX_U32 bSleeping;
+    volatile OMX_U32 bStop;
+    OMX_U32 nTimeoutMs;
+    pthread_mutex_t channelLock;    /* held while callbacks run */
+    OMX_TI_RT_CHANNEL *pChannels;
+    OMX_TI_RT_STATS stats;
+};
+
+/* nTimeoutMs is how long the loop sleeps before the Timeout callbacks run,
+ * the pselect timeout of the old loops */
+OMX_ERRORTYPE OMX_TI_RT_LoopCreate(OMX_TI_RT_LOOP **ppLoop, OMX_U32 nTimeoutMs);
+
+/* Runs the loop on the calling thread until OMX_TI_RT_LoopStop, or until a
+ * callback returns OMX_TI_RT_Stop */
+OMX_ERRORTYPE OMX_TI_RT_LoopRun(OMX_TI_RT_LOOP *pLoop);
+
+/* From any thread.  The loop returns once the callback it is in, if any,
+ * has.  Messages still queued are not handed out. */
+void OMX_TI_RT_LoopStop(OMX_TI_RT_LOOP *pLoop);
+
+/* The loop must not be running and must have no channels left */
+void OMX_TI_RT_LoopDestroy(OMX_TI_RT_LOOP *pLoop);
+
+void OMX_TI_RT_GetStats(OMX_TI_RT_LOOP *pLoop, OMX_TI_RT_STATS *pStats);
+
+/* Depths are rounded up to a power of 2, 0 picks the default.  The loop
+ * may be running.  Not to be called from a callback of the same loop. */
+OMX_ERRORTYPE OMX_TI_RT_ChannelCreate(OMX_TI_RT_CHANNEL **ppChannel,
+                                      OMX_TI_RT_LOOP *pLoop,
+                                      OMX_U32 nCmdDepth,
+                                      OMX_U32 nDataDepth,
+                                      const OMX_TI_RT_CALLBACKS *pCallbacks,
+                                      OMX_PTR pPrivate);
+
+/* Detaches from the loop, waiting for a callback of it in progress to
+ * return.  Not to be called from a callback of the same loop. */
+void OMX_TI_RT_ChannelDestroy(OMX_TI_RT_CHANNEL *pChannel);
+
+/* Commands and buffers of a channel reach the callbacks in the order they
+ * were posted: a buffer posted before a command is handed out before it,
+ * and the other way round.  Posts that race from two threads are ordered
+ * as they were stamped.
+ * A post to a full ring fails with OMX_ErrorInsufficientResources rather
+ * than waiting, so the callbacks may post to their own channel. */
+OMX_ERRORTYPE OMX_TI_RT_SendCommand(OMX_TI_RT_CHANNEL *pChannel,
+                                    OMX_U32 nCmd,
+                                    OMX_U32 nParam,
+                                    OMX_PTR pCmdData);
+
+OMX_ERRORTYPE OMX_TI_RT_SendData(OMX_TI_RT_CHANNEL *pChannel,
+                                 OMX_PTR pBuffer);
+
+#endif /* __OMX_TI_RUNTIME_H__ */
@@ -0,0 +1,16 @@
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	OMX_TI_Runtime.c
+
+LOCAL_C_INCLUDES += \
+	$(TI_OMX_INCLUDES) \
+	$(TI_OMX_SYSTEM)/omx_runtime/inc
+
+LOCAL_CFLAGS := $(TI_OMX_CFLAGS)
+
+LOCAL_MODULE:= libOMX_TI_Runtime
+
+include $(BUILD_STATIC_LIBRARY)
@@ -0,0 +1,473 @@
+/*
+ * Copyright (C) Texas Instruments - http://www.ti.com/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/** OMX_TI_Runtime.c
+ *  See OMX_TI_Runtime.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "OMX_TI_Runtime.h"
+
+/* Messages a channel may hand out before the loop moves to the next one */
+#define OMX_TI_RT_BATCH             16
+
+static int OMX_TI_RT_OpenWakeFd(int wakeFd[2])
+{
+#ifdef __NR_eventfd2
+    int fd = syscall(__NR_eventfd2, 0, O_NONBLOCK);
+
+    if (fd >= 0) {
+        wakeFd[0] = wakeFd[1] = fd;
+        return 0;
+    }
+#endif
+
+    /* kernels before 2.6.27 */
+    if (pipe(wakeFd) != 0) {
+        return -1;
+    }
+    fcntl(wakeFd[0], F_SETFL, O_NONBLOCK);
+    fcntl(wakeFd[1], F_SETFL, O_NONBLOCK);
+
+    return 0;
+}
+
+static void OMX_TI_RT_CloseWakeFd(int wakeFd[2])
+{
+    close(wakeFd[0]);
+    if (wakeFd[1] != wakeFd[0]) {
+        close(wakeFd[1]);
+    }
+}
+
+static void OMX_TI_RT_Wake(OMX_TI_RT_LOOP *pLoop)
+{
+    /* 8 bytes for the eventfd; a full pipe is already a wakeup */
+    OMX_U64 nValue = 1;
+    ssize_t nRet = write(pLoop->wakeFd[1], &nValue, sizeof(nValue));
+
+    (void)nRet;
+    __sync_fetch_and_add(&pLoop->stats.nSignals, 1);
+}
+
+static void OMX_TI_RT_DrainWakeFd(OMX_TI_RT_LOOP *pLoop)
+{
+    OMX_U64 nValue[8];
+
+    while (read(pLoop->wakeFd[0], nValue, sizeof(nValue)) > 0) {
+        if (pLoop->wakeFd[0] == pLoop->wakeFd[1]) {
+            break;
+        }
+    }
+}
+
+static OMX_U32 OMX_TI_RT_RoundDepth(OMX_U32 nDepth, OMX_U32 nDefault)
+{
+    OMX_U32 nSize = 1;
+
+    if (nDepth == 0) {
+        nDepth = nDefault;
+    }
+    while (nSize < nDepth) {
+        nSize <<= 1;
+    }
+
+    return nSize;
+}
+
+static OMX_ERRORTYPE OMX_TI_RT_RingInit(OMX_TI_RT_RING *pRing, OMX_U32 nSize)
+{
+    pRing->pSlots = (OMX_TI_RT_MSG *)calloc(nSize, sizeof(OMX_TI_RT_MSG));
+    if (pRing->pSlots == NULL) {
+        return OMX_ErrorInsufficientResources;
+    }
+
+    pRing->nMask = nSize - 1;
+    pRing->nHead = 0;
+    pRing->nTail = 0;
+    pthread_mutex_init(&pRing->writeLock, NULL);
+
+    return OMX_ErrorNone;
+}
+
+static void OMX_TI_RT_RingDeinit(OMX_TI_RT_RING *pRing)
+{
+    if (pRing->pSlots != NULL) {
+        pthread_mutex_destroy(&pRing->writeLock);
+        free(pRing->pSlots);
+        pRing->pSlots = NULL;
+    }
+}
+
+static OMX_BOOL OMX_TI_RT_RingEmpty(OMX_TI_RT_RING *pRing)
+{
+    return pRing->nHead == pRing->nTail ? OMX_TRUE : OMX_FALSE;
+}
+
+/* Loop thread only, copies out the oldest message without taking it */
+static OMX_BOOL OMX_TI_RT_RingPeek(OMX_TI_RT_RING *pRing, OMX_TI_RT_MSG *pMsg)
+{
+    OMX_U32 nHead = pRing->nHead;
+
+    if (nHead == pRing->nTail) {
+        return OMX_FALSE;
+    }
+
+    /* the slot was written before nTail moved past it */
+    __sync_synchronize();
+    *pMsg = pRing->pSlots[nHead & pRing->nMask];
+
+    return OMX_TRUE;
+}
+
+/* Loop thread only, after OMX_TI_RT_RingPeek found a message */
+static void OMX_TI_RT_RingDrop(OMX_TI_RT_RING *pRing)
+{
+    /* the slot has been read before a writer can see it free */
+    __sync_synchronize();
+    pRing->nHead = pRing->nHead + 1;
+}
+
+static OMX_ERRORTYPE OMX_TI_RT_RingPut(OMX_TI_RT_CHANNEL *pChannel,
+                                      OMX_TI_RT_RING *pRing,
+                                      const OMX_TI_RT_MSG *pMsg)
+{
+    OMX_ERRORTYPE eError = OMX_ErrorNone;
+    OMX_TI_RT_LOOP *pLoop = pChannel->pLoop;
+    OMX_U32 nTail;
+
+    pthread_mutex_lock(&pRing->writeLock);
+
+    /* waiting here for the loop could never end when the loop thread is
+     * the poster, and would hold off every other writer meanwhile */
+    nTail = pRing->nTail;
+    if (nTail - pRing->nHead > pRing->nMask) {
+        __sync_fetch_and_add(&pLoop->stats.nRingFull, 1);
+        OMX_TI_RT_Wake(pLoop);
+        eError = OMX_ErrorInsufficientResources;
+        goto EXIT;
+    }
+
+    /* stamped under the ring lock, so that the stamps of a ring only grow
+     * from its head to its tail */
+    pRing->pSlots[nTail & pRing->nMask] = *pMsg;
+    pRing->pSlots[nTail & pRing->nMask].nSeq =
+        __sync_fetch_and_add(&pChannel->nPostSeq, 1);
+
+    /* the slot is written before the loop can see it */
+    __sync_synchronize();
+    pRing->nTail = nTail + 1;
+
+    /* and nTail is out before bSleeping is looked at, the loop does the
+     * opposite: sets bSleeping and then looks at nTail */
+    __sync_synchronize();
+    if (pLoop->bSleeping &&
+        __sync_bool_compare_and_swap(&pLoop->bSleeping, 1, 0)) {
+        OMX_TI_RT_Wake(pLoop);
+    }
+
+EXIT:
+    pthread_mutex_unlock(&pRing->writeLock);
+    return eError;
+}
+
+OMX_ERRORTYPE OMX_TI_RT_LoopCreate(OMX_TI_RT_LOOP **ppLoop, OMX_U32 nTimeoutMs)
+{
+    OMX_TI_RT_LOOP *pLoop;
+
+    pLoop = (OMX_TI_RT_LOOP *)calloc(1, sizeof(OMX_TI_RT_LOOP));
+    if (pLoop == NULL) {
+        return OMX_ErrorInsufficientResources;
+    }
+
+    if (OMX_TI_RT_OpenWakeFd(pLoop->wakeFd) != 0) {
+        free(pLoop);
+        return OMX_ErrorInsufficientResources;
+    }
+
+    pLoop->nTimeoutMs = nTimeoutMs;
+    pthread_mutex_init(&pLoop->channelLock, NULL);
+
+    *ppLoop = pLoop;
+    return OMX_ErrorNone;
+}
+
+void OMX_TI_RT_LoopDestroy(OMX_TI_RT_LOOP *pLoop)
+{
+    if (pLoop == NULL) {
+        return;
+    }
+
+    OMX_TI_RT_CloseWakeFd(pLoop->wakeFd);
+    pthread_mutex_destroy(&pLoop->channelLock);
+    free(pLoop);
+}
+
+void OMX_TI_RT_LoopStop(OMX_TI_RT_LOOP *pLoop)
+{
+    pLoop->bStop = 1;
+    __sync_synchronize();
+    OMX_TI_RT_Wake(pLoop);
+}
+
+void OMX_TI_RT_GetStats(OMX_TI_RT_LOOP *pLoop, OMX_TI_RT_STATS *pStats)
+{
+    __sync_synchronize();
+    *pStats = pLoop->stats;
+}
+
+/* Hands out up to OMX_TI_RT_BATCH messages of a channel, in the order they
+ * were posted.  Returns how many, or -1 if a callback asked for the loop to
+ * stop. */
+static int OMX_TI_RT_Dispatch(OMX_TI_RT_LOOP *pLoop, OMX_TI_RT_CHANNEL *pChannel)
+{
+    OMX_TI_RT_MSG cmdMsg, dataMsg;
+    OMX_BOOL bCmd, bData;
+    OMX_TI_RT_RESULT eResult;
+    int nCount = 0;
+
+    while (nCount < OMX_TI_RT_BATCH && !pLoop->bStop) {
+        /* A message seen in one ring was posted after anything already in
+         * the other ring when it was seen, so a command found while the
+         * data ring looked empty sends us back to the data ring, for a
+         * buffer posted meanwhile but before it. */
+        bData = OMX_TI_RT_RingPeek(&pChannel->dataRing, &dataMsg);
+        __sync_synchronize();
+        bCmd = OMX_TI_RT_RingPeek(&pChannel->cmdRing, &cmdMsg);
+        if (bCmd && !bData) {
+            __sync_synchronize();
+            bData = OMX_TI_RT_RingPeek(&pChannel->dataRing, &dataMsg);
+        }
+
+        /* the lower stamp was posted first, the stamps may wrap */
+        if (bCmd && (!bData || (OMX_S32)(cmdMsg.nSeq - dataMsg.nSeq) < 0)) {
+            OMX_TI_RT_RingDrop(&pChannel->cmdRing);
+            pLoop->stats.nCommands++;
+            eResult = pChannel->pCallbacks->Command(pChannel->pPrivate, &cmdMsg);
+        } else if (bData) {
+            OMX_TI_RT_RingDrop(&pChannel->dataRing);
+            pLoop->stats.nBuffers++;
+            eResult = pChannel->pCallbacks->Data(pChannel->pPrivate, &dataMsg);
+        } else {
+            break;
+        }
+
+        nCount++;
+        if (eResult == OMX_TI_RT_Stop) {
+            pLoop->bStop = 1;
+            return -1;
+        }
+    }
+
+    return nCount;
+}
+
+static OMX_BOOL OMX_TI_RT_Pending(OMX_TI_RT_LOOP *pLoop)
+{
+    OMX_TI_RT_CHANNEL *pChannel;
+
+    for (pChannel = pLoop->pChannels; pChannel != NULL; pChannel = pChannel->pNext) {
+        if (!OMX_TI_RT_RingEmpty(&pChannel->cmdRing) ||
+            !OMX_TI_RT_RingEmpty(&pChannel->dataRing)) {
+            return OMX_TRUE;
+        }
+    }
+
+    return OMX_FALSE;
+}
+
+OMX_ERRORTYPE OMX_TI_RT_LoopRun(OMX_TI_RT_LOOP *pLoop)
+{
+    OMX_ERRORTYPE eError = OMX_ErrorNone;
+    OMX_TI_RT_CHANNEL *pChannel;
+    struct pollfd pfd;
+    int nHandled, nRet;
+
+    pfd.fd = pLoop->wakeFd[0];
+    pfd.events = POLLIN;
+
+    while (!pLoop->bStop) {
+        nHandled = 0;
+
+        pthread_mutex_lock(&pLoop->channelLock);
+        for (pChannel = pLoop->pChannels; pChannel != NULL; pChannel = pChannel->pNext) {
+            nRet = OMX_TI_RT_Dispatch(pLoop, pChannel);
+            if (nRet < 0) {
+                break;
+            }
+            nHandled += nRet;
+        }
+        pthread_mutex_unlock(&pLoop->channelLock);
+
+        if (nHandled != 0 || pLoop->bStop) {
+            continue;
+        }
+
+        /* going to sleep: say so, then look once more, so that a post
+         * either is seen here or sees bSleeping and signals */
+        pLoop->bSleeping = 1;
+        __sync_synchronize();
+
+        pthread_mutex_lock(&pLoop->channelLock);
+        if (OMX_TI_RT_Pending(pLoop) || pLoop->bStop) {
+            pthread_mutex_unlock(&pLoop->channelLock);
+            pLoop->bSleeping = 0;
+            continue;
+        }
+        pthread_mutex_unlock(&pLoop->channelLock);
+
+        nRet = poll(&pfd, 1, pLoop->nTimeoutMs != 0 ? (int)pLoop->nTimeoutMs : -1);
+        pLoop->bSleeping = 0;
+        pLoop->stats.nWakeups++;
+
+        if (nRet > 0) {
+            OMX_TI_RT_DrainWakeFd(pLoop);
+        } else if (nRet == 0) {
+            pLoop->stats.nTimeouts++;
+
+            pthread_mutex_lock(&pLoop->channelLock);
+            for (pChannel = pLoop->pChannels; pChannel != NULL; pChannel = pChannel->pNext) {
+                if (pChannel->pCallbacks->Timeout != NULL) {
+                    pChannel->pCallbacks->Timeout(pChannel->pPrivate);
+                }
+            }
+            pthread_mutex_unlock(&pLoop->channelLock);
+        } else if (errno != EINTR) {
+            eError = OMX_ErrorHardware;
+            break;
+        }
+    }
+
+    return eError;
+}
+
+OMX_ERRORTYPE OMX_TI_RT_ChannelCreate(OMX_TI_RT_CHANNEL **ppChannel,
+                                      OMX_TI_RT_LOOP *pLoop,
+                                      OMX_U32 nCmdDepth,
+                                      OMX_U32 nDataDepth,
+                                      const OMX_TI_RT_CALLBACKS *pCallbacks,
+                                      OMX_PTR pPrivate)
+{
+    OMX_ERRORTYPE eError = OMX_ErrorNone;
+    OMX_TI_RT_CHANNEL *pChannel;
+    OMX_TI_RT_CHANNEL **ppLast;
+
+    if (pLoop == NULL || pCallbacks == NULL ||
+        pCallbacks->Command == NULL || pCallbacks->Data == NULL) {
+        return OMX_ErrorBadParameter;
+    }
+
+    pChannel = (OMX_TI_RT_CHANNEL *)calloc(1, sizeof(OMX_TI_RT_CHANNEL));
+    if (pChannel == NULL) {
+        return OMX_ErrorInsufficientResources;
+    }
+
+    eError = OMX_TI_RT_RingInit(&pChannel->cmdRing,
+                                OMX_TI_RT_RoundDepth(nCmdDepth, OMX_TI_RT_CMD_DEPTH));
+    if (eError != OMX_ErrorNone) {
+        goto EXIT;
+    }
+
+    eError = OMX_TI_RT_RingInit(&pChannel->dataRing,
+                                OMX_TI_RT_RoundDepth(nDataDepth, OMX_TI_RT_DATA_DEPTH));
+    if (eError != OMX_ErrorNone) {
+        goto EXIT;
+    }
+
+    pChannel->pLoop = pLoop;
+    pChannel->pCallbacks = pCallbacks;
+    pChannel->pPrivate = pPrivate;
+
+    /* at the end, the loop serves channels in the order they came */
+    pthread_mutex_lock(&pLoop->channelLock);
+    for (ppLast = &pLoop->pChannels; *ppLast != NULL; ppLast = &(*ppLast)->pNext) {
+    }
+    *ppLast = pChannel;
+    pthread_mutex_unlock(&pLoop->channelLock);
+
+EXIT:
+    if (eError != OMX_ErrorNone) {
+        OMX_TI_RT_RingDeinit(&pChannel->dataRing);
+        OMX_TI_RT_RingDeinit(&pChannel->cmdRing);
+        free(pChannel);
+        pChannel = NULL;
+    }
+
+    *ppChannel = pChannel;
+    return eError;
+}
+
+void OMX_TI_RT_ChannelDestroy(OMX_TI_RT_CHANNEL *pChannel)
+{
+    OMX_TI_RT_LOOP *pLoop;
+    OMX_TI_RT_CHANNEL **ppEntry;
+
+    if (pChannel == NULL) {
+        return;
+    }
+
+    pLoop = pChannel->pLoop;
+
+    pthread_mutex_lock(&pLoop->channelLock);
+    for (ppEntry = &pLoop->pChannels; *ppEntry != NULL; ppEntry = &(*ppEntry)->pNext) {
+        if (*ppEntry == pChannel) {
+            *ppEntry = pChannel->pNext;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&pLoop->channelLock);
+
+    OMX_TI_RT_RingDeinit(&pChannel->dataRing);
+    OMX_TI_RT_RingDeinit(&pChannel->cmdRing);
+    free(pChannel);
+}
+
+OMX_ERRORTYPE OMX_TI_RT_SendCommand(OMX_TI_RT_CHANNEL *pChannel,
+                                    OMX_U32 nCmd,
+                                    OMX_U32 nParam,
+                                    OMX_PTR pCmdData)
+{
+    OMX_TI_RT_MSG msg;
+
+    msg.nCmd = nCmd;
+    msg.nParam = nParam;
+    msg.pData = pCmdData;
+    msg.nSeq = 0;
+
+    return OMX_TI_RT_RingPut(pChannel, &pChannel->cmdRing, &msg);
+}
+
+OMX_ERRORTYPE OMX_TI_RT_SendData(OMX_TI_RT_CHANNEL *pChannel, OMX_PTR pBuffer)
+{
+    OMX_TI_RT_MSG msg;
+
+    msg.nCmd = 0;
+    msg.nParam = 0;
+    msg.pData = pBuffer;
+    msg.nSeq = 0;
+
+    return OMX_TI_RT_RingPut(pChannel, &pChannel->dataRing, &msg);
+}
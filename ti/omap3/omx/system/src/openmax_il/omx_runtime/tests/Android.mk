@@ -0,0 +1,25 @@
+ifeq ($(BUILD_OMX_RUNTIME_TEST),1)
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+
+# Buffer round trips through the runtime against the cmdPipe/dataPipe loop,
+# runs on the host
+LOCAL_SRC_FILES:= \
+	../src/OMX_TI_Runtime.c \
+	OMXRuntimeBench.c
+
+LOCAL_C_INCLUDES := \
+	$(TI_OMX_INCLUDES) \
+	$(TI_OMX_SYSTEM)/omx_runtime/inc
+
+LOCAL_LDLIBS += -lpthread
+
+LOCAL_CFLAGS := -Wall -O2
+
+LOCAL_MODULE_TAGS := tests
+
+LOCAL_MODULE:= OMX_TI_RuntimeBench
+
+include $(BUILD_HOST_EXECUTABLE)
+endif
@@ -0,0 +1,459 @@
+/*
+ * Copyright (C) Texas Instruments - http://www.ti.com/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/** OMXRuntimeBench.c
+ *  Sends buffers round trip through a component thread, as EmptyThisBuffer
+ *  and EmptyBufferDone do, and reports round trips per second for:
+ *
+ *    pipe      the cmdPipe/dataPipe pselect loop of the components, one
+ *              thread per component
+ *    runtime   OMX_TI_Runtime, one loop thread per component
+ *    shared    OMX_TI_Runtime, one loop thread for all the components
+ *
+ *  Each client keeps DEPTH buffers in flight and posts a command every
+ *  CMD_EVERY buffers.  The component checks that buffers and commands come
+ *  in the order they were sent, and counts buffers that overtake a command
+ *  sent before them, and commands that overtake buffers sent before them.
+ *  The pipe loop looks at dataPipe first, so it lets the first happen; the
+ *  runtime must let neither.  The run fails on a wrong order, anything
+ *  overtaken with the runtime, or a buffer that goes missing.
+ *
+ *  Usage: OMX_TI_RuntimeBench [round trips per component]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/select.h>
+
+#include <OMX_Types.h>
+#include <OMX_Core.h>
+#include "OMX_TI_Runtime.h"
+
+#define DEPTH           8       /* buffers in flight per component */
+#define CMD_EVERY       64      /* buffers between commands */
+#define MAX_COMPONENTS  4
+
+typedef enum BENCH_MODE {
+    BENCH_PIPE,
+    BENCH_RUNTIME,
+    BENCH_SHARED
+} BENCH_MODE;
+
+typedef struct BENCH_BUFFER {
+    OMX_U32 nSeq;               /* order the client sent it in */
+    OMX_U32 nCmdsBefore;        /* commands the client had sent by then */
+    struct BENCH_BUFFER *pNext;
+} BENCH_BUFFER;
+
+typedef struct BENCH_COMPONENT {
+    /* client side */
+    pthread_t client;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    BENCH_BUFFER buffers[DEPTH];
+    BENCH_BUFFER *pFree;        /* given back by the component */
+    int bWaiting;
+    OMX_U32 nSent;
+    OMX_U32 nCmdsSent;
+
+    /* component side */
+    OMX_U32 nExpectSeq;
+    OMX_U32 nCmds;
+    OMX_U32 nOvertaken;         /* buffers handled before an earlier command */
+    OMX_U32 nCmdsEarly;         /* commands handled before an earlier buffer */
+    OMX_U32 nErrors;
+
+    /* pipe mode */
+    pthread_t thread;
+    int dataPipe[2];
+    int cmdPipe[2];
+    int cmdDataPipe[2];
+    volatile int bExit;
+    OMX_U32 nSyscalls;
+
+    /* runtime modes */
+    OMX_TI_RT_LOOP *pLoop;
+    OMX_TI_RT_CHANNEL *pChannel;
+} BENCH_COMPONENT;
+
+static BENCH_MODE gMode;
+static OMX_U32 gRoundTrips = 200000;
+
+static double NowSeconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* EmptyBufferDone, on the component thread */
+static void BufferDone(BENCH_COMPONENT *pComp, BENCH_BUFFER *pBuffer)
+{
+    pthread_mutex_lock(&pComp->mutex);
+    pBuffer->pNext = pComp->pFree;
+    pComp->pFree = pBuffer;
+    if (pComp->bWaiting) {
+        pthread_cond_signal(&pComp->cond);
+    }
+    pthread_mutex_unlock(&pComp->mutex);
+}
+
+static void HandleCommand(BENCH_COMPONENT *pComp, OMX_U32 nCmd, OMX_U32 nParam)
+{
+    if (nCmd != OMX_CommandMarkBuffer || nParam != pComp->nCmds) {
+        pComp->nErrors++;
+    }
+    /* command nParam was sent right before buffer nParam * CMD_EVERY */
+    if (pComp->nExpectSeq < nParam * CMD_EVERY) {
+        pComp->nCmdsEarly++;
+    }
+    pComp->nCmds++;
+}
+
+static void HandleBuffer(BENCH_COMPONENT *pComp, BENCH_BUFFER *pBuffer)
+{
+    if (pBuffer->nSeq != pComp->nExpectSeq) {
+        pComp->nErrors++;
+    }
+    if (pBuffer->nCmdsBefore > pComp->nCmds) {
+        pComp->nOvertaken++;
+    }
+    pComp->nExpectSeq = pBuffer->nSeq + 1;
+
+    BufferDone(pComp, pBuffer);
+}
+
+/* The loop of MP3DEC_ComponentThread */
+static void *PipeThread(void *pArg)
+{
+    BENCH_COMPONENT *pComp = (BENCH_COMPONENT *)pArg;
+    struct timespec tv;
+    fd_set rfds;
+    sigset_t set;
+    int fdmax, status;
+
+    fdmax = pComp->cmdPipe[0];
+    if (pComp->dataPipe[0] > fdmax) {
+        fdmax = pComp->dataPipe[0];
+    }
+
+    while (1) {
+        FD_ZERO(&rfds);
+        FD_SET(pComp->cmdPipe[0], &rfds);
+        FD_SET(pComp->dataPipe[0], &rfds);
+        tv.tv_sec = 1;
+        tv.tv_nsec = 0;
+
+        sigemptyset(&set);
+        sigaddset(&set, SIGALRM);
+        status = pselect(fdmax + 1, &rfds, NULL, NULL, &tv, &set);
+        pComp->nSyscalls++;
+
+        if (pComp->bExit) {
+            break;
+        }
+
+        if (status <= 0) {
+            continue;
+        } else if (FD_ISSET(pComp->dataPipe[0], &rfds)) {
+            BENCH_BUFFER *pBuffer = NULL;
+
+            if (read(pComp->dataPipe[0], &pBuffer, sizeof(pBuffer)) != sizeof(pBuffer)) {
+                pComp->nErrors++;
+                continue;
+            }
+            pComp->nSyscalls++;
+            HandleBuffer(pComp, pBuffer);
+        } else if (FD_ISSET(pComp->cmdPipe[0], &rfds)) {
+            OMX_U32 nCmd, nParam;
+
+            if (read(pComp->cmdPipe[0], &nCmd, sizeof(nCmd)) != sizeof(nCmd) ||
+                read(pComp->cmdDataPipe[0], &nParam, sizeof(nParam)) != sizeof(nParam)) {
+                pComp->nErrors++;
+                continue;
+            }
+            pComp->nSyscalls += 2;
+            HandleCommand(pComp, nCmd, nParam);
+        }
+    }
+
+    return NULL;
+}
+
+static OMX_TI_RT_RESULT RtCommand(OMX_PTR pPrivate, const OMX_TI_RT_MSG *pMsg)
+{
+    HandleCommand((BENCH_COMPONENT *)pPrivate, pMsg->nCmd, pMsg->nParam);
+    return OMX_TI_RT_Continue;
+}
+
+static OMX_TI_RT_RESULT RtData(OMX_PTR pPrivate, const OMX_TI_RT_MSG *pMsg)
+{
+    HandleBuffer((BENCH_COMPONENT *)pPrivate, (BENCH_BUFFER *)pMsg->pData);
+    return OMX_TI_RT_Continue;
+}
+
+static const OMX_TI_RT_CALLBACKS gRtCallbacks = {
+    RtCommand,
+    RtData,
+    NULL
+};
+
+static void *LoopThread(void *pArg)
+{
+    OMX_TI_RT_LoopRun((OMX_TI_RT_LOOP *)pArg);
+    return NULL;
+}
+
+static int SendCommand(BENCH_COMPONENT *pComp, OMX_U32 nCmd, OMX_U32 nParam)
+{
+    if (gMode == BENCH_PIPE) {
+        if (write(pComp->cmdPipe[1], &nCmd, sizeof(nCmd)) != sizeof(nCmd) ||
+            write(pComp->cmdDataPipe[1], &nParam, sizeof(nParam)) != sizeof(nParam)) {
+            return -1;
+        }
+        return 0;
+    }
+
+    return OMX_TI_RT_SendCommand(pComp->pChannel, nCmd, nParam, NULL) == OMX_ErrorNone ? 0 : -1;
+}
+
+static int SendBuffer(BENCH_COMPONENT *pComp, BENCH_BUFFER *pBuffer)
+{
+    if (gMode == BENCH_PIPE) {
+        return write(pComp->dataPipe[1], &pBuffer, sizeof(pBuffer)) == sizeof(pBuffer) ? 0 : -1;
+    }
+
+    return OMX_TI_RT_SendData(pComp->pChannel, pBuffer) == OMX_ErrorNone ? 0 : -1;
+}
+
+/* The application: EmptyThisBuffer whenever it has a buffer back */
+static void *ClientThread(void *pArg)
+{
+    BENCH_COMPONENT *pComp = (BENCH_COMPONENT *)pArg;
+    BENCH_BUFFER *pBuffer;
+
+    while (pComp->nSent < gRoundTrips) {
+        pthread_mutex_lock(&pComp->mutex);
+        while (pComp->pFree == NULL) {
+            pComp->bWaiting = 1;
+            pthread_cond_wait(&pComp->cond, &pComp->mutex);
+            pComp->bWaiting = 0;
+        }
+        pBuffer = pComp->pFree;
+        pComp->pFree = pBuffer->pNext;
+        pthread_mutex_unlock(&pComp->mutex);
+
+        if (pComp->nSent % CMD_EVERY == 0) {
+            if (SendCommand(pComp, OMX_CommandMarkBuffer, pComp->nCmdsSent) != 0) {
+                pComp->nErrors++;
+            }
+            pComp->nCmdsSent++;
+        }
+
+        pBuffer->nSeq = pComp->nSent++;
+        pBuffer->nCmdsBefore = pComp->nCmdsSent;
+        if (SendBuffer(pComp, pBuffer) != 0) {
+            pComp->nErrors++;
+        }
+    }
+
+    /* wait for everything to come back */
+    pthread_mutex_lock(&pComp->mutex);
+    while (1) {
+        int nFree = 0;
+
+        for (pBuffer = pComp->pFree; pBuffer != NULL; pBuffer = pBuffer->pNext) {
+            nFree++;
+        }
+        if (nFree == DEPTH) {
+            break;
+        }
+        pComp->bWaiting = 1;
+        pthread_cond_wait(&pComp->cond, &pComp->mutex);
+        pComp->bWaiting = 0;
+    }
+    pthread_mutex_unlock(&pComp->mutex);
+
+    return NULL;
+}
+
+static int Run(const char *name, BENCH_MODE eMode, int nComponents)
+{
+    BENCH_COMPONENT comps[MAX_COMPONENTS];
+    OMX_TI_RT_LOOP *pShared = NULL;
+    pthread_t sharedThread;
+    OMX_TI_RT_STATS stats;
+    OMX_U32 nSignals = 0, nWakeups = 0, nSyscalls = 0, nErrors = 0;
+    OMX_U32 nOvertaken = 0, nCmdsEarly = 0;
+    double start, elapsed;
+    int i, j;
+
+    gMode = eMode;
+    memset(comps, 0, sizeof(comps));
+
+    if (eMode == BENCH_SHARED) {
+        OMX_TI_RT_LoopCreate(&pShared, 1000);
+    }
+
+    for (i = 0; i < nComponents; i++) {
+        BENCH_COMPONENT *pComp = &comps[i];
+
+        pthread_mutex_init(&pComp->mutex, NULL);
+        pthread_cond_init(&pComp->cond, NULL);
+        for (j = 0; j < DEPTH; j++) {
+            pComp->buffers[j].pNext = pComp->pFree;
+            pComp->pFree = &pComp->buffers[j];
+        }
+
+        if (eMode == BENCH_PIPE) {
+            if (pipe(pComp->dataPipe) != 0 || pipe(pComp->cmdPipe) != 0 ||
+                pipe(pComp->cmdDataPipe) != 0) {
+                perror("pipe");
+                exit(1);
+            }
+            pthread_create(&pComp->thread, NULL, PipeThread, pComp);
+        } else {
+            if (eMode == BENCH_RUNTIME) {
+                OMX_TI_RT_LoopCreate(&pComp->pLoop, 1000);
+            }
+            OMX_TI_RT_ChannelCreate(&pComp->pChannel,
+                                    eMode == BENCH_SHARED ? pShared : pComp->pLoop,
+                                    0, DEPTH, &gRtCallbacks, pComp);
+            if (eMode == BENCH_RUNTIME) {
+                pthread_create(&pComp->thread, NULL, LoopThread, pComp->pLoop);
+            }
+        }
+    }
+
+    if (eMode == BENCH_SHARED) {
+        pthread_create(&sharedThread, NULL, LoopThread, pShared);
+    }
+
+    start = NowSeconds();
+    for (i = 0; i < nComponents; i++) {
+        pthread_create(&comps[i].client, NULL, ClientThread, &comps[i]);
+    }
+    for (i = 0; i < nComponents; i++) {
+        pthread_join(comps[i].client, NULL);
+    }
+    elapsed = NowSeconds() - start;
+
+    for (i = 0; i < nComponents; i++) {
+        BENCH_COMPONENT *pComp = &comps[i];
+
+        if (eMode == BENCH_PIPE) {
+            OMX_U32 nWake = 1;
+
+            pComp->bExit = 1;
+            write(pComp->cmdPipe[1], &nWake, sizeof(nWake));
+            pthread_join(pComp->thread, NULL);
+            nSyscalls += pComp->nSyscalls;
+
+            /* plus the writes of the client */
+            nSyscalls += pComp->nSent + 2 * pComp->nCmdsSent;
+            close(pComp->dataPipe[0]);
+            close(pComp->dataPipe[1]);
+            close(pComp->cmdPipe[0]);
+            close(pComp->cmdPipe[1]);
+            close(pComp->cmdDataPipe[0]);
+            close(pComp->cmdDataPipe[1]);
+        } else if (eMode == BENCH_RUNTIME) {
+            OMX_TI_RT_LoopStop(pComp->pLoop);
+            pthread_join(pComp->thread, NULL);
+            OMX_TI_RT_GetStats(pComp->pLoop, &stats);
+            nSignals += stats.nSignals;
+            nWakeups += stats.nWakeups;
+            OMX_TI_RT_ChannelDestroy(pComp->pChannel);
+            OMX_TI_RT_LoopDestroy(pComp->pLoop);
+        }
+
+        if (pComp->nExpectSeq != gRoundTrips || pComp->nCmds != pComp->nCmdsSent) {
+            fprintf(stderr, "%s: component %d saw %lu buffers and %lu commands, "
+                    "expected %lu and %lu\n", name, i,
+                    (unsigned long)pComp->nExpectSeq, (unsigned long)pComp->nCmds,
+                    (unsigned long)gRoundTrips, (unsigned long)pComp->nCmdsSent);
+            nErrors++;
+        }
+        nErrors += pComp->nErrors;
+        nOvertaken += pComp->nOvertaken;
+        nCmdsEarly += pComp->nCmdsEarly;
+
+        pthread_mutex_destroy(&pComp->mutex);
+        pthread_cond_destroy(&pComp->cond);
+    }
+
+    if (eMode == BENCH_SHARED) {
+        OMX_TI_RT_LoopStop(pShared);
+        pthread_join(sharedThread, NULL);
+        OMX_TI_RT_GetStats(pShared, &stats);
+        nSignals = stats.nSignals;
+        nWakeups = stats.nWakeups;
+        for (i = 0; i < nComponents; i++) {
+            OMX_TI_RT_ChannelDestroy(comps[i].pChannel);
+        }
+        OMX_TI_RT_LoopDestroy(pShared);
+    }
+
+    if (eMode != BENCH_PIPE) {
+        /* each signal is a write and each wakeup a poll and a read */
+        nSyscalls = nSignals + 2 * nWakeups;
+    }
+
+    if (eMode != BENCH_PIPE) {
+        nErrors += nOvertaken + nCmdsEarly;
+    }
+
+    printf("%-8s x%d  %10.0f round trips/s  %5.2f syscalls/buffer  "
+           "%6lu commands overtaken  %6lu buffers overtaken%s\n",
+           name, nComponents,
+           (double)gRoundTrips * nComponents / elapsed,
+           (double)nSyscalls / ((double)gRoundTrips * nComponents),
+           (unsigned long)nOvertaken,
+           (unsigned long)nCmdsEarly,
+           nErrors != 0 ? "  FAILED" : "");
+
+    return nErrors != 0;
+}
+
+int main(int argc, char **argv)
+{
+    int nFailed = 0;
+
+    if (argc > 1) {
+        gRoundTrips = strtoul(argv[1], NULL, 0);
+    }
+
+    printf("%lu round trips per component, %d buffers in flight\n",
+           (unsigned long)gRoundTrips, DEPTH);
+
+    nFailed += Run("pipe", BENCH_PIPE, 1);
+    nFailed += Run("runtime", BENCH_RUNTIME, 1);
+    nFailed += Run("pipe", BENCH_PIPE, MAX_COMPONENTS);
+    nFailed += Run("runtime", BENCH_RUNTIME, MAX_COMPONENTS);
+    nFailed += Run("shared", BENCH_SHARED, MAX_COMPONENTS);
+
+    printf("%s\n", nFailed ? "FAILED" : "PASSED");
+    return nFailed != 0;
+}
@@ -19,6 +19,7 @@
 #include "ti_m4v_config_parser.h"
 #include "oscl_mem.h"
 #include "oscl_dll.h"
+#include "OMX_TI_Bitstream.h"
 OSCL_DLL_ENTRY_POINT_DEFAULT()
 
 #define PV_CLZ(A,B) while (((B) & 0x8000) == 0) {(B) <<=1; A++;}
@@ -36,29 +37,14 @@ static const uint32 mask[33] =
     0xffffffff
 };
 
+// Offset of the first 0x00 0x00 0x01 in ptr, size if there is none
 int32 LocateFrameHeader(uint8 *ptr, int32 size)
 {
-    int32 count = 0;
-    int32 i = size;
-
     if (size < 1)
     {
         return 0;
     }
-    while (i--)
-    {
-        if ((count > 1) && (*ptr == 0x01))
-        {
-            i += 2;
-            break;
-        }
-
-        if (*ptr++)
-            count = 0;
-        else
-            count++;
-    }
-    return (size - (i + 1));
+    return (int32)OMX_TI_FindStartCode(ptr, 0, size);
 }
 
 void movePointerTo(mp4StreamType *psBits, int32 pos)
@@ -776,9 +762,20 @@ int16 DecodeUserData(mp4StreamType *pStream)
 
     uint32 codeword;
     int16 iErrorStat;
+    uint32 next_sc;
 
     iErrorStat = ReadBits(pStream, 32, &codeword);
     if (iErrorStat) return iErrorStat;
+
+    if ((pStream->dataBitPos & 7) == 0)
+    {
+        /* Discard user data for now, up to the next start code. */
+        next_sc = OMX_TI_FindStartCode(pStream->data, pStream->dataBitPos >> 3, pStream->numBytes);
+        pStream->dataBitPos = next_sc << 3;
+        pStream->bitPos = 32; /* reload bitBuf on the next read */
+        return (next_sc == pStream->numBytes) ? -2 : 0;
+    }
+
     iErrorStat = ShowBits(pStream, 24, &codeword);
     if (iErrorStat) return iErrorStat;
 
@@ -801,6 +798,7 @@ OSCL_EXPORT_REF int16 iGetAVCConfigInfo(uint8 *buffer, int32 length, int32 *widt
     uint16 sps_length, pps_length;
     int32 size;
     int32 i = 0;
+    int32 next_sc;
     uint8* sps = NULL;
     uint8* temp = (uint8 *)OSCL_MALLOC(sizeof(uint8) * length);
     uint8* pps = NULL;
@@ -837,19 +835,15 @@ OSCL_EXPORT_REF int16 iGetAVCConfigInfo(uint8 *buffer, int32 length, int32 *widt
         {
             sps += i;
 
-            sps_length = 0;
             // search for the next start code
-            while (!(sps[sps_length] == 0 && sps[sps_length+1] == 0 && sps[sps_length+2] == 1) &&
-                    sps_length < length - i - 2)
-            {
-                sps_length++;
-            }
+            next_sc = (int32)OMX_TI_FindStartCode(sps, 0, length - i);
 
-            if (sps_length >= length - i - 2)
+            if (next_sc >= length - i - 2)
             {
                 OSCL_FREE(temp);
                 return MP4_INVALID_VOL_PARAM;
             }
+            sps_length = next_sc;
 
             pps_length = length - i - sps_length - 3;
             pps = sps + sps_length + 3;
@@ -1278,21 +1272,23 @@ void Parser_EBSPtoRBSP(uint8 *nal_unit, int32 *size)
     int32 i, j;
     int32 count = 0;
 
-
-    for (i = 0; i < *size; i++)
+    // Nothing moves up to the first 0x03 that follows exactly two zeros
+    i = 0;
+    while (i < *size)
     {
-        if (count == 2 && nal_unit[i] == 0x03)
+        i = (int32)OMX_TI_FindPrefix(nal_unit, i, *size, 0x03);
+        if (i == *size)
         {
             break;
         }
-
-        if (nal_unit[i])
-            count = 0;
-        else
-            count++;
+        if (i == 0 || nal_unit[i-1] != 0)
+        {
+            i += 2;
+            break;
+        }
+        i += 3;
     }
 
-    count = 0;
     j = i++;
     for (;i < *size; i++)
     {
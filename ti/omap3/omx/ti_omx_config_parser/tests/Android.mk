@@ -0,0 +1,47 @@
+ifeq ($(BUILD_TI_CONFIG_PARSER_TEST),1)
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+
+# Scans, RBSP copies, bit reads and whole config parses against the byte at
+# a time code in bitstream_ref.h, runs on the host. Extra arguments are
+# H.264 or MPEG-4 config buffers to add to the generated ones.
+LOCAL_SRC_FILES:= \
+	../src/ti_m4v_config_parser.cpp \
+	ConfigParserTest.cpp
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/oscl_host \
+	$(LOCAL_PATH)/../inc \
+	$(TI_OMX_SYSTEM)/common/inc \
+	$(TI_OMX_INCLUDES)
+
+LOCAL_CFLAGS := -Wall
+
+LOCAL_MODULE_TAGS := tests
+
+LOCAL_MODULE:= TIConfigParserTest
+
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+# MB/s of the old and new scans, RBSP copy and ue(v) reads
+LOCAL_SRC_FILES:= \
+	BitstreamBench.cpp
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/oscl_host \
+	$(TI_OMX_SYSTEM)/common/inc \
+	$(TI_OMX_INCLUDES)
+
+LOCAL_LDLIBS += -lrt
+
+LOCAL_CFLAGS := -Wall -O2
+
+LOCAL_MODULE_TAGS := tests
+
+LOCAL_MODULE:= TIBitstreamBench
+
+include $(BUILD_HOST_EXECUTABLE)
+endif
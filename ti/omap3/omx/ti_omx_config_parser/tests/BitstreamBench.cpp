@@ -0,0 +1,191 @@
+/* ------------------------------------------------------------------
+ * Copyright (C) 1998-2009 PacketVideo
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ * -------------------------------------------------------------------
+ */
+// Times OMX_TI_Bitstream.h against the byte at a time code it replaced
+// (bitstream_ref.h) and prints MB/s for both:
+//
+//   scan      counting start codes, as VIDDEC_ScanConfigBufferAVC
+//   locate    walking the start codes with LocateFrameHeader
+//   rbsp      removing emulation prevention bytes, as the decoder does
+//   ue        reading ue(v) codes, as the SPS parse does
+//
+// on coded-like data, where few bytes are zero, and on data with 30% zero
+// bytes.  The results of both versions are compared as they run.
+//
+// Usage: BitstreamBench [buffer size in MB]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "oscl_types.h"
+#include "OMX_TI_Bitstream.h"
+#include "bitstream_ref.h"
+
+#define SLACK 16
+
+static uint32 gSeed = 1;
+
+static uint32 nextRand()
+{
+    gSeed = gSeed * 1103515245 + 12345;
+    return gSeed >> 8;
+}
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *what, const char *data, uint32 bytes,
+                   double refTime, double newTime, bool same)
+{
+    printf("%-8s %-8s  old %8.1f MB/s  new %8.1f MB/s  x%5.1f%s\n",
+           what, data, bytes / refTime / 1e6, bytes / newTime / 1e6,
+           refTime / newTime, same ? "" : "  MISMATCH");
+}
+
+// Random bytes with zeroPercent zeros, a start code every ~8 KB and
+// an emulation prevention byte every ~1 KB
+static void fill(uint8 *buf, uint32 len, uint32 zeroPercent)
+{
+    uint32 i;
+
+    memset(buf + len, 0, SLACK);
+    for (i = 0; i < len; i++)
+        buf[i] = (nextRand() % 100 < zeroPercent) ? 0 : 1 + nextRand() % 255;
+    for (i = 0; i + 4 < len; i += 512 + nextRand() % 1024)
+    {
+        buf[i] = 0;
+        buf[i + 1] = 0;
+        buf[i + 2] = (nextRand() % 8 == 0) ? 0x01 : 0x03;
+    }
+}
+
+static bool benchData(const char *name, uint8 *buf, uint32 len)
+{
+    uint8 *out0 = (uint8 *)malloc(len + SLACK);
+    uint8 *out1 = (uint8 *)malloc(len + SLACK);
+    double t0, t1, t2;
+    uint32 refCount, newCount, pos;
+    int32 refSum, newSum, off;
+    bool same, allSame = true;
+
+    t0 = now();
+    refCount = RefScanConfigBuffer(buf, len, 0x000001);
+    t1 = now();
+    newCount = 0;
+    for (pos = 0; (pos = OMX_TI_FindStartCode(buf, pos, len - 1)) != len - 1; pos += 3)
+        newCount++;
+    t2 = now();
+    same = refCount == newCount;
+    allSame &= same;
+    report("scan", name, len, t1 - t0, t2 - t1, same);
+
+    t0 = now();
+    refSum = 0;
+    for (off = 0; off < (int32)len; off += 3)
+    {
+        off += RefLocateFrameHeader(buf + off, len - off);
+        refSum += off;
+    }
+    t1 = now();
+    newSum = 0;
+    for (off = 0; off < (int32)len; off += 3)
+    {
+        off += (int32)OMX_TI_FindStartCode(buf, off, len) - off;
+        newSum += off;
+    }
+    t2 = now();
+    same = refSum == newSum;
+    allSame &= same;
+    report("locate", name, len, t1 - t0, t2 - t1, same);
+
+    t0 = now();
+    refCount = RefDecoderRbsp(out0, buf, 0, len);
+    t1 = now();
+    newCount = OMX_TI_CopyRbsp(out1, buf, 0, len);
+    t2 = now();
+    same = refCount == newCount && memcmp(out0, out1, refCount) == 0;
+    allSame &= same;
+    report("rbsp", name, len, t1 - t0, t2 - t1, same);
+
+    free(out0);
+    free(out1);
+    return allSame;
+}
+
+// ue(v) codes of the sizes an SPS has, 1 to 13 bits
+static bool benchUE(uint32 len)
+{
+    uint8 *buf = (uint8 *)calloc(len + SLACK, 1);
+    OMX_TI_BITREADER reader;
+    uint32 bitPos = 0, pos, count = 0, i;
+    uint32 refSum = 0, newSum = 0;
+    double t0, t1, t2;
+
+    while (bitPos + 13 < len * 8)
+    {
+        uint32 code = 1 + nextRand() % 64;
+        uint32 bits = 0;
+        while ((code >> bits) > 1)
+            bits++;
+        bitPos += bits;
+        for (i = 0; i <= bits; i++, bitPos++)
+            if ((code >> (bits - i)) & 1)
+                buf[bitPos >> 3] |= 0x80 >> (bitPos & 7);
+        count++;
+    }
+
+    t0 = now();
+    pos = 0;
+    for (i = 0; i < count; i++)
+        refSum += RefUVLC(&pos, buf);
+    t1 = now();
+    OMX_TI_BitReaderInit(&reader, buf, len);
+    for (i = 0; i < count; i++)
+        newSum += OMX_TI_ReadUE(&reader);
+    t2 = now();
+    report("ue", "codes", len, t1 - t0, t2 - t1, refSum == newSum);
+    free(buf);
+    return refSum == newSum;
+}
+
+int main(int argc, char **argv)
+{
+    uint32 len = (argc > 1 ? atoi(argv[1]) : 16) << 20;
+    uint8 *buf = (uint8 *)malloc(len + SLACK);
+    bool ok = true;
+
+    if (len == 0 || buf == NULL)
+    {
+        printf("usage: BitstreamBench [buffer size in MB]\n");
+        return 1;
+    }
+
+    fill(buf, len, 1);
+    ok &= benchData("coded", buf, len);
+    fill(buf, len, 30);
+    ok &= benchData("zeros", buf, len);
+    ok &= benchUE(len / 4);
+
+    free(buf);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,791 @@
+/* ------------------------------------------------------------------
+ * Copyright (C) 1998-2009 PacketVideo
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ * -------------------------------------------------------------------
+ */
+// Runs a corpus of streams through OMX_TI_Bitstream.h and the config
+// parser and checks every result against the byte at a time code they
+// replaced (bitstream_ref.h):
+//
+//   - start code scans as the video decoder and LocateFrameHeader do them,
+//     from every starting offset, at every buffer alignment
+//   - config buffer start code counts
+//   - emulation prevention removal, decoder and Parser_EBSPtoRBSP
+//   - bit and ue(v) reads against VIDDEC_GetBits and VIDDEC_UVLC_dec
+//   - the decoder's H.264 SPS parse, old and new, and iGetAVCConfigInfo /
+//     iGetM4VConfigInfo against the sizes the streams were written with
+//
+// The corpus is generated: H.264 and MPEG-4 config headers, random data
+// with start codes and emulation prevention bytes mixed in, and every
+// short buffer.  Files given on the command line are added to it.
+//
+// Usage: ConfigParserTest [stream files]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "oscl_types.h"
+#include "ti_m4v_config_parser.h"
+#include "OMX_TI_Bitstream.h"
+#include "bitstream_ref.h"
+
+// Not in ti_m4v_config_parser.h
+int32 LocateFrameHeader(uint8 *ptr, int32 size);
+
+#define SLACK 16    // zeroed bytes after every buffer, the old code reads past the end
+
+static int gFailures = 0;
+static uint32 gSeed = 1;
+
+static uint32 nextRand()
+{
+    gSeed = gSeed * 1103515245 + 12345;
+    return gSeed >> 8;
+}
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            if (++gFailures > 20) exit(1); \
+        } \
+    } while (0)
+
+// ------------------------------------------------------------------
+// Stream writing
+
+struct BitWriter
+{
+    uint8 buf[1024];
+    uint32 bitPos;
+};
+
+static void bwInit(BitWriter *bw)
+{
+    memset(bw->buf, 0, sizeof(bw->buf));
+    bw->bitPos = 0;
+}
+
+static void bwPut(BitWriter *bw, uint32 nBits, uint32 value)
+{
+    while (nBits--)
+    {
+        if ((value >> nBits) & 1)
+            bw->buf[bw->bitPos >> 3] |= 0x80 >> (bw->bitPos & 7);
+        bw->bitPos++;
+    }
+}
+
+static void bwPutUE(BitWriter *bw, uint32 value)
+{
+    uint32 code = value + 1;
+    uint32 len = 0;
+
+    while ((code >> len) > 1)
+        len++;
+    bwPut(bw, len, 0);
+    bwPut(bw, len + 1, code);
+}
+
+static void bwPutSE(BitWriter *bw, int32 value)
+{
+    bwPutUE(bw, value > 0 ? 2 * value - 1 : -2 * value);
+}
+
+// rbsp_trailing_bits
+static uint32 bwFinish(BitWriter *bw)
+{
+    bwPut(bw, 1, 1);
+    while (bw->bitPos & 7)
+        bwPut(bw, 1, 0);
+    return bw->bitPos >> 3;
+}
+
+// Escapes a NAL unit into out, returns the escaped length
+static uint32 escapeNal(uint8 *out, const uint8 *nal, uint32 len)
+{
+    uint32 n = 0, zeros = 0, i;
+
+    for (i = 0; i < len; i++)
+    {
+        if (zeros == 2 && nal[i] <= 3)
+        {
+            out[n++] = 0x03;
+            zeros = 0;
+        }
+        out[n++] = nal[i];
+        zeros = nal[i] ? 0 : zeros + 1;
+    }
+    return n;
+}
+
+struct Stream
+{
+    char name[64];
+    uint8 *data;
+    uint32 len;
+};
+
+static Stream *gCorpus = NULL;
+static int gCorpusCount = 0;
+static int gCorpusSize = 0;
+
+static Stream *addStream(const char *name, const uint8 *data, uint32 len)
+{
+    Stream *s;
+
+    if (gCorpusCount == gCorpusSize)
+    {
+        gCorpusSize = gCorpusSize ? gCorpusSize * 2 : 64;
+        gCorpus = (Stream *)realloc(gCorpus, gCorpusSize * sizeof(Stream));
+    }
+    s = &gCorpus[gCorpusCount++];
+    snprintf(s->name, sizeof(s->name), "%s", name);
+    s->data = (uint8 *)calloc(len + SLACK, 1);
+    memcpy(s->data, data, len);
+    s->len = len;
+    return s;
+}
+
+// ------------------------------------------------------------------
+// H.264 config buffers
+
+struct SpsParams
+{
+    uint32 profile;
+    uint32 level;
+    uint32 pocType;
+    uint32 numRefFrames;
+    uint32 widthMbs;
+    uint32 heightMbs;
+    uint32 crop[4];         // left, right, top, bottom
+    bool longStartCode;
+    uint32 entropyCodingMode;
+};
+
+static uint32 writeSps(uint8 *out, const SpsParams *p)
+{
+    BitWriter bw;
+    uint32 i;
+
+    bwInit(&bw);
+    bwPut(&bw, 8, 0x67);
+    bwPut(&bw, 8, p->profile);
+    bwPut(&bw, 8, 0);               // constraint flags, reserved_zero_5bits
+    bwPut(&bw, 8, p->level);
+    bwPutUE(&bw, 0);                // seq_parameter_set_id
+    if (p->profile == H264_PROFILE_IDC_HIGH)
+    {
+        bwPutUE(&bw, 1);            // chroma_format_idc
+        bwPutUE(&bw, 0);            // bit_depth_luma_minus8
+        bwPutUE(&bw, 0);            // bit_depth_chroma_minus8
+        bwPut(&bw, 1, 0);           // qpprime_y_zero_transform_bypass_flag
+        // no scaling matrix, se_v does not return the deltas the parser
+        // would need to get through one
+        bwPut(&bw, 1, 0);
+    }
+    bwPutUE(&bw, 0);                // log2_max_frame_num_minus4
+    bwPutUE(&bw, p->pocType);
+    if (p->pocType == 0)
+    {
+        bwPutUE(&bw, 2);            // log2_max_pic_order_cnt_lsb_minus4
+    }
+    else if (p->pocType == 1)
+    {
+        bwPut(&bw, 1, 0);           // delta_pic_order_always_zero_flag
+        bwPutSE(&bw, -3);           // offset_for_non_ref_pic
+        bwPutSE(&bw, 2);            // offset_for_top_to_bottom_field
+        bwPutUE(&bw, 3);
+        for (i = 0; i < 3; i++)
+            bwPutSE(&bw, (int32)i - 1);
+    }
+    bwPutUE(&bw, p->numRefFrames);
+    bwPut(&bw, 1, 0);               // gaps_in_frame_num_value_allowed_flag
+    bwPutUE(&bw, p->widthMbs - 1);
+    bwPutUE(&bw, p->heightMbs - 1);
+    bwPut(&bw, 1, 1);               // frame_mbs_only_flag
+    bwPut(&bw, 1, 1);               // direct_8x8_inference_flag
+    if (p->crop[0] | p->crop[1] | p->crop[2] | p->crop[3])
+    {
+        bwPut(&bw, 1, 1);
+        for (i = 0; i < 4; i++)
+            bwPutUE(&bw, p->crop[i]);
+    }
+    else
+    {
+        bwPut(&bw, 1, 0);
+    }
+    bwPut(&bw, 1, 0);               // vui_parameters_present_flag
+    return escapeNal(out, bw.buf, bwFinish(&bw));
+}
+
+static uint32 writePps(uint8 *out, const SpsParams *p)
+{
+    BitWriter bw;
+
+    bwInit(&bw);
+    bwPut(&bw, 8, 0x68);
+    bwPutUE(&bw, 0);                // pic_parameter_set_id
+    bwPutUE(&bw, 0);                // seq_parameter_set_id
+    bwPut(&bw, 1, p->entropyCodingMode);
+    bwPut(&bw, 1, 0);
+    bwPutUE(&bw, 0);
+    return escapeNal(out, bw.buf, bwFinish(&bw));
+}
+
+static uint32 writeAvcConfig(uint8 *out, const SpsParams *p)
+{
+    static const uint8 kStartCode[] = { 0x00, 0x00, 0x00, 0x01 };
+    uint32 n = 0;
+
+    memcpy(out, p->longStartCode ? kStartCode : kStartCode + 1, p->longStartCode ? 4 : 3);
+    n += p->longStartCode ? 4 : 3;
+    n += writeSps(out + n, p);
+    memcpy(out + n, kStartCode + 1, 3);
+    n += 3;
+    n += writePps(out + n, p);
+    return n;
+}
+
+// ------------------------------------------------------------------
+// MPEG-4 config buffers
+
+static uint32 writeM4vConfig(uint8 *out, uint32 width, uint32 height,
+                             uint32 userDataLen, uint32 visualObjectType)
+{
+    BitWriter bw;
+    uint32 i;
+
+    bwInit(&bw);
+    bwPut(&bw, 32, 0x000001B0);     // visual_object_sequence_start_code
+    bwPut(&bw, 8, 0x08);            // profile_and_level_indication
+    if (userDataLen)
+    {
+        bwPut(&bw, 32, 0x000001B2);
+        for (i = 0; i < userDataLen; i++)
+            bwPut(&bw, 8, (i % 5 == 4) ? 0x00 : 'a' + i % 26);
+    }
+    bwPut(&bw, 32, 0x000001B5);     // visual_object_start_code
+    bwPut(&bw, 1, 0);               // is_visual_object_identifier
+    bwPut(&bw, 4, visualObjectType);
+    if (visualObjectType == 1)
+    {
+        bwPut(&bw, 1, 0);           // video_signal_type
+    }
+    bwPut(&bw, 1, 0);               // next_start_code()
+    while (bw.bitPos & 7)
+        bwPut(&bw, 1, 1);
+    bwPut(&bw, 32, 0x00000100);     // video_object_start_code
+    bwPut(&bw, 32, 0x00000120);     // video_object_layer_start_code
+    bwPut(&bw, 1, 0);               // random_accessible_vol
+    bwPut(&bw, 8, 1);               // video_object_type_indication
+    bwPut(&bw, 1, 0);               // is_object_layer_identifier
+    bwPut(&bw, 4, 1);               // aspect_ratio_info
+    bwPut(&bw, 1, 0);               // vol_control_parameters
+    bwPut(&bw, 2, 0);               // video_object_layer_shape
+    bwPut(&bw, 1, 1);
+    bwPut(&bw, 16, 30);             // vop_time_increment_resolution
+    bwPut(&bw, 1, 1);
+    bwPut(&bw, 1, 0);               // fixed_vop_rate
+    bwPut(&bw, 1, 1);
+    bwPut(&bw, 13, width);
+    bwPut(&bw, 1, 1);
+    bwPut(&bw, 13, height);
+    bwPut(&bw, 1, 1);
+    bwPut(&bw, 1, 0);               // interlaced
+    bwPut(&bw, 1, 1);               // obmc_disable
+    while (bw.bitPos & 7)
+        bwPut(&bw, 1, 1);
+    memcpy(out, bw.buf, bw.bitPos >> 3);
+    return bw.bitPos >> 3;
+}
+
+// ------------------------------------------------------------------
+// The decoder's H.264 SPS parse (VIDDEC_ParseVideo_H264 with nType 0),
+// before and after
+
+// Bytes after the RBSP read as ones, so that garbage ue(v) codes end
+// inside the buffer in both versions
+struct DecoderSps
+{
+    bool ok;
+    uint32 rbspLen;
+    uint8 rbsp[1024];
+    int32 width, height, cropWidth, cropHeight;
+};
+
+static void refDecoderSps(const uint8 *buf, uint32 total, DecoderSps *out)
+{
+    uint32 nInBytePosition = 0, nBitPosition, nNumBytesInNALunit, nNalUnitType;
+    uint32 pos = 0;
+    uint32 i;
+    bool found;
+
+    memset(out, 0, sizeof(*out));
+    memset(out->rbsp, 0xFF, sizeof(out->rbsp));
+    if (total < 4)
+        return;
+    do
+    {
+        nInBytePosition = RefDecoderScan(buf, nInBytePosition, total, &found);
+        if (found)
+            nInBytePosition += 3;
+        nNumBytesInNALunit = RefDecoderScan(buf, nInBytePosition, total, &found);
+        if (!found)
+            return;
+        nNumBytesInNALunit += 3;
+        nBitPosition = nInBytePosition * 8;
+        RefGetBits(&nBitPosition, 1, buf, true);
+        RefGetBits(&nBitPosition, 2, buf, true);
+        nNalUnitType = RefGetBits(&nBitPosition, 5, buf, true);
+        nInBytePosition++;
+    }
+    while (nNalUnitType != 7);
+
+    out->rbspLen = RefDecoderRbsp(out->rbsp, buf, nInBytePosition, nNumBytesInNALunit - 3);
+
+    RefGetBits(&pos, 8, out->rbsp, true);
+    RefGetBits(&pos, 1, out->rbsp, true);
+    RefGetBits(&pos, 1, out->rbsp, true);
+    RefGetBits(&pos, 1, out->rbsp, true);
+    RefGetBits(&pos, 5, out->rbsp, true);
+    RefGetBits(&pos, 8, out->rbsp, true);
+    RefUVLC(&pos, out->rbsp);
+    RefUVLC(&pos, out->rbsp);
+    uint32 pocType = RefUVLC(&pos, out->rbsp);
+    if (pocType == 0)
+    {
+        RefUVLC(&pos, out->rbsp);
+    }
+    else if (pocType == 1)
+    {
+        RefGetBits(&pos, 1, out->rbsp, true);
+        RefUVLC(&pos, out->rbsp);
+        RefUVLC(&pos, out->rbsp);
+        uint32 n = RefUVLC(&pos, out->rbsp);
+        for (i = 0; i < n; i++)
+            RefUVLC(&pos, out->rbsp);
+    }
+    RefUVLC(&pos, out->rbsp);
+    RefGetBits(&pos, 1, out->rbsp, true);
+    out->width = (RefUVLC(&pos, out->rbsp) + 1) * 16;
+    out->height = (RefUVLC(&pos, out->rbsp) + 1) * 16;
+    if (!RefGetBits(&pos, 1, out->rbsp, true))
+        RefGetBits(&pos, 1, out->rbsp, true);
+    RefGetBits(&pos, 1, out->rbsp, true);
+    if (RefGetBits(&pos, 1, out->rbsp, true))
+    {
+        uint32 l = RefUVLC(&pos, out->rbsp);
+        uint32 r = RefUVLC(&pos, out->rbsp);
+        uint32 t = RefUVLC(&pos, out->rbsp);
+        uint32 b = RefUVLC(&pos, out->rbsp);
+        out->cropWidth = 2 * l + 2 * r;
+        out->cropHeight = 2 * t + 2 * b;
+    }
+    out->ok = true;
+}
+
+// The decoder's walk and parse, OMX_TI_FindAvcSps and OMX_TI_ParseAvcSps
+static void newDecoderSps(const uint8 *buf, uint32 total, DecoderSps *out)
+{
+    OMX_U32 nFrom, nEnd;
+    OMX_TI_AVC_SPS sps;
+
+    memset(out, 0, sizeof(*out));
+    memset(out->rbsp, 0xFF, sizeof(out->rbsp));
+    if (!OMX_TI_FindAvcSps(buf, total, &nFrom, &nEnd))
+        return;
+    if (nFrom < nEnd)
+        out->rbspLen = OMX_TI_CopyRbsp(out->rbsp, buf, nFrom, nEnd);
+
+    OMX_TI_ParseAvcSps(out->rbsp, sizeof(out->rbsp), &sps);
+    out->width = (sps.nPicWidthInMbsMinus1 + 1) * 16;
+    out->height = (sps.nPicHeightInMapUnitsMinus1 + 1) * 16;
+    if (sps.nFrameCroppingFlag)
+    {
+        out->cropWidth = 2 * sps.nFrameCropLeftOffset + 2 * sps.nFrameCropRightOffset;
+        out->cropHeight = 2 * sps.nFrameCropTopOffset + 2 * sps.nFrameCropBottomOffset;
+    }
+    out->ok = true;
+}
+
+// ------------------------------------------------------------------
+// Checks run on every stream of the corpus
+
+// Every offset of short buffers, about 200 spread over long ones
+static uint32 nextOffset(uint32 from, uint32 len)
+{
+    if (len <= 256 || from < 64 || from + 64 >= len)
+        return from + 1;
+    return from + 1 + nextRand() % (len / 100);
+}
+
+static void checkScans(const Stream *s, const uint8 *buf)
+{
+    uint32 len = s->len;
+    uint32 from;
+    bool found;
+
+    // Decoder start code loops, from every offset
+    if (len >= 4)
+    {
+        for (from = 0; from < len; from = nextOffset(from, len))
+        {
+            uint32 ref = RefDecoderScan(buf, from, len, &found);
+            uint32 got = OMX_TI_FindStartCode(buf, from, len - 1);
+            if (found)
+                CHECK(got == ref, "%s: start code from %u at %u, expected %u", s->name, from, got, ref);
+            else
+                CHECK(got == len - 1, "%s: start code from %u at %u, expected none", s->name, from, got);
+        }
+        CHECK(OMX_TI_CountPrefixes(buf, len, 0x01) == RefScanConfigBuffer(buf, len, 0x000001),
+              "%s: %u start codes counted, expected %u", s->name,
+              (uint32)OMX_TI_CountPrefixes(buf, len, 0x01), RefScanConfigBuffer(buf, len, 0x000001));
+    }
+
+    // LocateFrameHeader on every tail of the buffer
+    for (from = 0; from <= len; from = nextOffset(from, len))
+    {
+        int32 ref = RefLocateFrameHeader(buf + from, len - from);
+        int32 got = LocateFrameHeader((uint8 *)buf + from, len - from);
+        CHECK(got == ref, "%s: LocateFrameHeader from %u gives %d, expected %d", s->name, from, got, ref);
+    }
+}
+
+static void checkRbsp(const Stream *s, const uint8 *buf)
+{
+    uint32 len = s->len;
+    uint8 *ref = (uint8 *)calloc(len + SLACK, 1);
+    uint8 *got = (uint8 *)calloc(len + SLACK, 1);
+    uint32 from, refLen, gotLen;
+    int32 refSize, gotSize;
+
+    // The decoder's copy, for a few ranges
+    for (from = 0; from < len && from < 8; from++)
+    {
+        uint32 end;
+        for (end = from; end <= len; end += 1 + end / 4)
+        {
+            memset(ref, 0, len + SLACK);
+            memset(got, 0, len + SLACK);
+            refLen = RefDecoderRbsp(ref, buf, from, end);
+            gotLen = OMX_TI_CopyRbsp(got, buf, from, end);
+            CHECK(refLen == gotLen && memcmp(ref, got, refLen) == 0,
+                  "%s: RBSP of [%u, %u) is %u bytes, expected %u", s->name, from, end, gotLen, refLen);
+        }
+    }
+
+    // Parser_EBSPtoRBSP works in place
+    memcpy(ref, buf, len);
+    memcpy(got, buf, len);
+    refSize = gotSize = len;
+    RefEBSPtoRBSP(ref, &refSize);
+    Parser_EBSPtoRBSP(got, &gotSize);
+    CHECK(refSize == gotSize && memcmp(ref, got, refSize) == 0,
+          "%s: Parser_EBSPtoRBSP gives %d bytes, expected %d", s->name, gotSize, refSize);
+
+    free(ref);
+    free(got);
+}
+
+static void checkBitReads(const Stream *s, const uint8 *buf)
+{
+    OMX_TI_BITREADER reader;
+    uint32 pos = 0;
+    uint32 nBits;
+
+    // Reads of 1 to 25 bits, the most VIDDEC_GetBits gets right at any bit
+    // position, while the old code stays inside the buffer
+    OMX_TI_BitReaderInit(&reader, buf, s->len);
+    while (pos + 32 <= s->len * 8)
+    {
+        nBits = 1 + nextRand() % 25;
+        uint32 ref = RefGetBits(&pos, nBits, buf, true);
+        uint32 got = OMX_TI_ReadBits(&reader, nBits);
+        CHECK(got == ref, "%s: %u bits at %u read %#x, expected %#x", s->name, nBits, pos - nBits, got, ref);
+        if (got != ref)
+            return;
+    }
+}
+
+static void checkDecoderSps(const Stream *s, const uint8 *buf)
+{
+    static DecoderSps ref, got;
+
+    if (s->len + 3 > sizeof(ref.rbsp))
+        return;
+    refDecoderSps(buf, s->len, &ref);
+    newDecoderSps(buf, s->len, &got);
+    CHECK(ref.ok == got.ok, "%s: decoder SPS parse %s, expected %s", s->name,
+          got.ok ? "succeeds" : "fails", ref.ok ? "success" : "failure");
+    if (ref.ok && got.ok)
+    {
+        CHECK(ref.rbspLen == got.rbspLen && memcmp(ref.rbsp, got.rbsp, ref.rbspLen) == 0,
+              "%s: decoder SPS RBSP is %u bytes, expected %u", s->name, got.rbspLen, ref.rbspLen);
+        CHECK(ref.width == got.width && ref.height == got.height &&
+              ref.cropWidth == got.cropWidth && ref.cropHeight == got.cropHeight,
+              "%s: decoder SPS %dx%d crop %dx%d, expected %dx%d crop %dx%d", s->name,
+              got.width, got.height, got.cropWidth, got.cropHeight,
+              ref.width, ref.height, ref.cropWidth, ref.cropHeight);
+    }
+}
+
+static void checkStream(const Stream *s)
+{
+    uint8 *block = (uint8 *)malloc(s->len + SLACK + 8);
+    uint32 align;
+
+    // The word loop of the scan depends on where the buffer starts
+    for (align = 0; align < 8; align++)
+    {
+        uint8 *buf = block + align;
+        memset(buf, 0, s->len + SLACK);
+        memcpy(buf, s->data, s->len);
+
+        checkScans(s, buf);
+        if (align == 0 || align == 3)
+        {
+            checkRbsp(s, buf);
+            checkBitReads(s, buf);
+            checkDecoderSps(s, buf);
+        }
+    }
+    free(block);
+}
+
+// ------------------------------------------------------------------
+// Exp-Golomb codes of every length against VIDDEC_UVLC_dec
+
+static void checkUE()
+{
+    BitWriter bw;
+    OMX_TI_BITREADER reader;
+    uint32 values[200];
+    uint32 pos = 0;
+    int i, n = 0;
+
+    bwInit(&bw);
+    bwPut(&bw, 3, 5);   // start off byte alignment
+    for (i = 0; i < 31; i++)
+        values[n++] = (1u << i) - 1 + (i ? nextRand() % (1u << i) : 0);
+    while (n < 200)
+        values[n++] = nextRand() % (1u << (nextRand() % 12));
+    for (i = 0; i < n && bw.bitPos < (sizeof(bw.buf) - 16) * 8; i++)
+        bwPutUE(&bw, values[i]);
+    n = i;
+
+    OMX_TI_BitReaderInit(&reader, bw.buf, sizeof(bw.buf));
+    OMX_TI_ReadBits(&reader, 3);
+    pos = 3;
+    for (i = 0; i < n; i++)
+    {
+        uint32 ref = RefUVLC(&pos, bw.buf);
+        uint32 got = OMX_TI_ReadUE(&reader);
+        CHECK(ref == values[i], "ue(v) %d: VIDDEC_UVLC_dec gives %u, expected %u", i, ref, values[i]);
+        CHECK(got == values[i], "ue(v) %d: OMX_TI_ReadUE gives %u, expected %u", i, got, values[i]);
+        CHECK(reader.nBitPos == pos, "ue(v) %d: at bit %u, expected %u", i, (uint32)reader.nBitPos, pos);
+    }
+}
+
+// ------------------------------------------------------------------
+// Whole config buffers through the parser
+
+static void checkAvcConfig(const SpsParams *p, const char *name)
+{
+    uint8 buf[2048];
+    uint32 len = writeAvcConfig(buf, p);
+    int32 width, height, displayWidth, displayHeight, profile, level;
+    uint32 entropy = 0xFF;
+    int32 expWidth = p->widthMbs * 16, expHeight = p->heightMbs * 16;
+    int16 status;
+
+    addStream(name, buf, len);
+
+    status = iGetAVCConfigInfo(buf, len, &width, &height, &displayWidth, &displayHeight,
+                               &profile, &level, &entropy);
+    CHECK(status == 0, "%s: iGetAVCConfigInfo returns %d", name, status);
+    CHECK(width == expWidth && height == expHeight, "%s: %dx%d, expected %dx%d",
+          name, width, height, expWidth, expHeight);
+    CHECK(displayWidth == expWidth - 2 * (int32)(p->crop[0] + p->crop[1]) &&
+          displayHeight == expHeight - 2 * (int32)(p->crop[2] + p->crop[3]),
+          "%s: display %dx%d", name, displayWidth, displayHeight);
+    CHECK(profile == (int32)p->profile && level == (int32)p->level,
+          "%s: profile %d level %d", name, profile, level);
+    CHECK(entropy == p->entropyCodingMode, "%s: entropy_coding_mode_flag %u", name, entropy);
+
+    if (p->profile != H264_PROFILE_IDC_HIGH)
+    {
+        // The decoder's own parse only knows the baseline layout
+        DecoderSps sps;
+        newDecoderSps(buf, len, &sps);
+        CHECK(sps.ok && sps.width == expWidth && sps.height == expHeight &&
+              sps.cropWidth == 2 * (int32)(p->crop[0] + p->crop[1]) &&
+              sps.cropHeight == 2 * (int32)(p->crop[2] + p->crop[3]),
+              "%s: decoder SPS %dx%d crop %dx%d", name, sps.width, sps.height,
+              sps.cropWidth, sps.cropHeight);
+    }
+}
+
+static void checkM4vConfig(uint32 w, uint32 h, uint32 userDataLen, uint32 objectType, const char *name)
+{
+    uint8 buf[2048];
+    uint32 len = writeM4vConfig(buf, w, h, userDataLen, objectType);
+    int32 width, height, displayWidth, displayHeight;
+    int16 status;
+
+    addStream(name, buf, len);
+
+    status = iGetM4VConfigInfo(buf, len, &width, &height, &displayWidth, &displayHeight);
+    CHECK(status == 0, "%s: iGetM4VConfigInfo returns %d", name, status);
+    CHECK(displayWidth == (int32)w && displayHeight == (int32)h &&
+          width == (int32)((w + 15) & ~15) && height == (int32)((h + 15) & ~15),
+          "%s: %dx%d display %dx%d", name, width, height, displayWidth, displayHeight);
+}
+
+static void buildHeaders()
+{
+    static const SpsParams kSps[] =
+    {
+        // level 0 puts 00 00 after the profile, so the SPS gets escaped
+        { 66,  0, 0, 1, 11,   9, { 0, 0, 0, 0 }, false, 0 },
+        { 66, 30, 2, 1, 22,  18, { 0, 0, 0, 0 }, true,  0 },
+        { 77, 31, 0, 4, 45,  30, { 0, 0, 0, 0 }, true,  1 },
+        { 77, 40, 1, 2, 120, 68, { 0, 0, 0, 4 }, false, 1 },
+        { 66, 13, 1, 0, 1,    1, { 0, 0, 0, 0 }, true,  0 },
+        { 66,  0, 2, 0, 2,    2, { 1, 0, 0, 1 }, false, 0 },
+        { 100, 40, 0, 4, 80, 45, { 0, 0, 0, 0 }, true,  1 },
+        { 100, 41, 0, 4, 120, 68, { 0, 0, 0, 4 }, false, 1 },
+    };
+    char name[64];
+    uint32 i;
+
+    for (i = 0; i < sizeof(kSps) / sizeof(kSps[0]); i++)
+    {
+        snprintf(name, sizeof(name), "avc config %u", i);
+        checkAvcConfig(&kSps[i], name);
+    }
+
+    checkM4vConfig(176, 144, 0, 1, "m4v qcif");
+    checkM4vConfig(352, 288, 13, 1, "m4v cif user data");
+    checkM4vConfig(640, 480, 200, 1, "m4v vga long user data");
+    checkM4vConfig(720, 480, 0, 2, "m4v still texture object");
+    checkM4vConfig(854, 480, 1, 2, "m4v wvga user data");
+}
+
+// ------------------------------------------------------------------
+// Random streams
+
+static void buildRandom()
+{
+    static const uint32 kZeroPercent[] = { 1, 30, 70, 100 };
+    uint8 buf[4096];
+    char name[64];
+    uint32 i, n, len;
+
+    // Every short buffer over {0, 1, 3} and a few others
+    for (len = 0; len <= 7; len++)
+    {
+        uint32 combos = 1;
+        for (i = 0; i < len; i++)
+            combos *= 3;
+        for (n = 0; n < combos && n < 400; n++)
+        {
+            uint32 c = n;
+            for (i = 0; i < len; i++)
+            {
+                static const uint8 kSymbols[] = { 0x00, 0x01, 0x03 };
+                buf[i] = kSymbols[c % 3];
+                c /= 3;
+            }
+            snprintf(name, sizeof(name), "short %u/%u", len, n);
+            addStream(name, buf, len);
+        }
+    }
+
+    for (n = 0; n < 400; n++)
+    {
+        uint32 zeros = kZeroPercent[n % 4];
+        len = 1 + nextRand() % (n < 300 ? 300 : sizeof(buf));
+        for (i = 0; i < len; i++)
+            buf[i] = (nextRand() % 100 < zeros) ? 0 : 1 + nextRand() % 255;
+        for (i = nextRand() % 8; i > 0 && len > 4; i--)
+        {
+            uint32 at = nextRand() % (len - 3);
+            buf[at] = 0;
+            buf[at + 1] = 0;
+            buf[at + 2] = (nextRand() & 1) ? 0x01 : 0x03;
+        }
+        if (n % 7 == 0 && len >= 3)
+        {
+            // a start code as the last three bytes
+            buf[len - 3] = 0;
+            buf[len - 2] = 0;
+            buf[len - 1] = 1;
+        }
+        snprintf(name, sizeof(name), "random %u (%u%% zeros)", n, zeros);
+        addStream(name, buf, len);
+    }
+}
+
+static bool loadFile(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    uint8 *data;
+    long len;
+
+    if (f == NULL)
+    {
+        printf("cannot open %s\n", path);
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    data = (uint8 *)malloc(len > 0 ? len : 1);
+    if (fread(data, 1, len, f) != (size_t)len)
+    {
+        printf("cannot read %s\n", path);
+        fclose(f);
+        free(data);
+        return false;
+    }
+    fclose(f);
+    addStream(path, data, len);
+    free(data);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!loadFile(argv[i]))
+            return 1;
+    }
+    buildHeaders();
+    buildRandom();
+    checkUE();
+
+    for (i = 0; i < gCorpusCount; i++)
+        checkStream(&gCorpus[i]);
+
+    printf("%d streams, %d failures\n", gCorpusCount, gFailures);
+    return gFailures ? 1 : 0;
+}
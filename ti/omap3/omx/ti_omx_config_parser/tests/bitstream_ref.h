@@ -0,0 +1,238 @@
+/* ------------------------------------------------------------------
+ * Copyright (C) 1998-2009 PacketVideo
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ * -------------------------------------------------------------------
+ */
+// The byte at a time scans and bit reads the parsers used before
+// OMX_TI_Bitstream.h, kept as the reference the test and the benchmark
+// compare against.
+
+#ifndef BITSTREAM_REF_H_INCLUDED
+#define BITSTREAM_REF_H_INCLUDED
+
+#include "oscl_types.h"
+
+// VIDDEC_GetBits
+static inline uint32 RefGetBits(uint32 *nPosition, uint8 nBits, const uint8 *pBuffer, bool bIncrease)
+{
+    uint32 nOutput;
+    uint32 nNumBitsRead = 0;
+    uint32 nBytePosition = *nPosition / 8;
+    uint8 nBitPosition = *nPosition % 8;
+
+    if (bIncrease)
+        *nPosition += nBits;
+    nOutput = ((uint32)pBuffer[nBytePosition] << (24 + nBitPosition));
+    nNumBitsRead = nNumBitsRead + (8 - nBitPosition);
+    if (nNumBitsRead < nBits)
+    {
+        nOutput = nOutput | (pBuffer[nBytePosition + 1] << (16 + nBitPosition));
+        nNumBitsRead = nNumBitsRead + 8;
+    }
+    if (nNumBitsRead < nBits)
+    {
+        nOutput = nOutput | (pBuffer[nBytePosition + 2] << (8 + nBitPosition));
+        nNumBitsRead = nNumBitsRead + 8;
+    }
+    if (nNumBitsRead < nBits)
+    {
+        nOutput = nOutput | (pBuffer[nBytePosition + 3] << (nBitPosition));
+        nNumBitsRead = nNumBitsRead + 8;
+    }
+    nOutput = nOutput >> (32 - nBits);
+    return nOutput;
+}
+
+// VIDDEC_UVLC_dec
+static inline uint32 RefUVLC(uint32 *nPosition, const uint8 *pBuffer)
+{
+    uint32 nBytePosition = (*nPosition) / 8;
+    uint8 cBitPosition = (*nPosition) % 8;
+    uint32 nLen = 1;
+    uint32 nCtrBit = 0;
+    uint32 nVal = 1;
+    uint32 nInfoBit = 0;
+
+    nCtrBit = pBuffer[nBytePosition] & (0x1 << (7 - cBitPosition));
+    while (nCtrBit == 0)
+    {
+        nLen++;
+        cBitPosition++;
+        (*nPosition)++;
+        if (!(cBitPosition % 8))
+        {
+            cBitPosition = 0;
+            nBytePosition++;
+        }
+        nCtrBit = pBuffer[nBytePosition] & (0x1 << (7 - cBitPosition));
+    }
+    for (nInfoBit = 0; nInfoBit < nLen - 1; nInfoBit++)
+    {
+        cBitPosition++;
+        (*nPosition)++;
+        if (!(cBitPosition % 8))
+        {
+            cBitPosition = 0;
+            nBytePosition++;
+        }
+        nVal = (nVal << 1);
+        if (pBuffer[nBytePosition] & (0x01 << (7 - cBitPosition)))
+            nVal |= 1;
+    }
+    (*nPosition)++;
+    return nVal - 1;
+}
+
+// The start code loop of the VIDDEC_ParseVideo_* functions: the first
+// 0x000001 at or after nFrom that starts before nTotal - 3, or nTotal - 3
+// (nFrom if that is larger) when there is none.
+static inline uint32 RefDecoderScan(const uint8 *pStream, uint32 nFrom, uint32 nTotal, bool *pFound)
+{
+    uint32 nBitPosition = nFrom * 8;
+    uint32 nInBytePosition = nFrom;
+
+    *pFound = false;
+    while (nInBytePosition < nTotal - 3)
+    {
+        if (RefGetBits(&nBitPosition, 24, pStream, false) != 0x000001)
+        {
+            nBitPosition += 8;
+            nInBytePosition++;
+        }
+        else
+        {
+            *pFound = true;
+            break;
+        }
+    }
+    return nInBytePosition;
+}
+
+// VIDDEC_ScanConfigBufferAVC
+static inline uint32 RefScanConfigBuffer(const uint8 *pStream, uint32 nTotal, uint32 pattern)
+{
+    uint32 nBitPosition = 0;
+    uint32 nInBytePosition = 0;
+    uint32 nPatternCounter = 0;
+
+    while (nInBytePosition < nTotal - 3)
+    {
+        if (RefGetBits(&nBitPosition, 24, pStream, false) != pattern)
+        {
+            nBitPosition += 8;
+            nInBytePosition++;
+        }
+        else
+        {
+            nPatternCounter++;
+            nBitPosition += 24;
+            nInBytePosition += 3;
+        }
+    }
+    return nPatternCounter;
+}
+
+// The RBSP copy of VIDDEC_ParseVideo_H264, [nFrom, nEnd + 3)
+static inline uint32 RefDecoderRbsp(uint8 *pRbsp, const uint8 *pStream, uint32 nFrom, uint32 nEnd)
+{
+    uint32 nBitPosition = nFrom * 8;
+    uint32 nInBytePosition = nFrom;
+    uint32 i = 0;
+
+    while (nInBytePosition < nEnd)
+    {
+        if (((nInBytePosition + 2) < nEnd) &&
+                (RefGetBits(&nBitPosition, 24, pStream, false) == 0x000003))
+        {
+            pRbsp[i++] = pStream[nInBytePosition++];
+            pRbsp[i++] = pStream[nInBytePosition++];
+            nInBytePosition++;
+            nBitPosition += 24;
+        }
+        else
+        {
+            pRbsp[i++] = pStream[nInBytePosition++];
+            nBitPosition += 8;
+        }
+    }
+    return i;
+}
+
+// ti_m4v_config_parser.cpp LocateFrameHeader
+static inline int32 RefLocateFrameHeader(const uint8 *ptr, int32 size)
+{
+    int32 count = 0;
+    int32 i = size;
+
+    if (size < 1)
+    {
+        return 0;
+    }
+    while (i--)
+    {
+        if ((count > 1) && (*ptr == 0x01))
+        {
+            i += 2;
+            break;
+        }
+
+        if (*ptr++)
+            count = 0;
+        else
+            count++;
+    }
+    return (size - (i + 1));
+}
+
+// ti_m4v_config_parser.cpp Parser_EBSPtoRBSP
+static inline void RefEBSPtoRBSP(uint8 *nal_unit, int32 *size)
+{
+    int32 i, j;
+    int32 count = 0;
+
+    for (i = 0; i < *size; i++)
+    {
+        if (count == 2 && nal_unit[i] == 0x03)
+        {
+            break;
+        }
+
+        if (nal_unit[i])
+            count = 0;
+        else
+            count++;
+    }
+
+    count = 0;
+    j = i++;
+    for (; i < *size; i++)
+    {
+        if (count == 2 && nal_unit[i] == 0x03)
+        {
+            i++;
+            count = 0;
+        }
+        nal_unit[j] = nal_unit[i];
+        if (nal_unit[i])
+            count = 0;
+        else
+            count++;
+        j++;
+    }
+
+    *size = j;
+}
+
+#endif // BITSTREAM_REF_H_INCLUDED
@@ -0,0 +1,30 @@
+/* ------------------------------------------------------------------
+ * Copyright (C) 1998-2009 PacketVideo
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ * -------------------------------------------------------------------
+ */
+// The few OSCL definitions ti_m4v_config_parser.cpp uses, so the parser
+// builds on the host for the tests without opencore.
+
+#ifndef OSCL_BASE_H_INCLUDED
+#define OSCL_BASE_H_INCLUDED
+
+#include "oscl_types.h"
+
+#define OSCL_EXPORT_REF
+#define OSCL_IMPORT_REF
+#define OSCL_UNUSED_ARG(x) (void)(x)
+
+#endif
@@ -0,0 +1,28 @@
+/* ------------------------------------------------------------------
+ * Copyright (C) 1998-2009 PacketVideo
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ * -------------------------------------------------------------------
+ */
+#ifndef OSCL_MEM_H_INCLUDED
+#define OSCL_MEM_H_INCLUDED
+
+#include <stdlib.h>
+#include <string.h>
+
+#define OSCL_MALLOC(size) malloc(size)
+#define OSCL_FREE(ptr) free(ptr)
+#define oscl_memcpy(dst, src, len) memcpy((dst), (src), (len))
+
+#endif
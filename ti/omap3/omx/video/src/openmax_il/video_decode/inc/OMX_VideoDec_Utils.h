@@ -716,37 +716,6 @@ typedef struct VIDDEC_MPEG4UncompressedVideoFormat{
     OMX_U32 iRgbFormat;
 }VIDDEC_MPEG4UncompressedVideoFormat;
 
-typedef struct VIDDEC_AVC_ParserParam {
-    OMX_U32 nBitPosTemp;
-    OMX_U32 nForbiddenZeroBit;
-    OMX_U32 nNalRefIdc;
-    OMX_U32 nProfileIdc;
-    OMX_U32 nConstraintSet0Flag;
-    OMX_U32 nConstraintSet1Flag;
-    OMX_U32 nConstraintSet2Flag;
-    OMX_U32 nReservedZero5bits;
-    OMX_U32 nLevelIdc;
-    OMX_U32 nSeqParameterSetId;
-    OMX_U32 nLog2MaxFrameNumMinus4;
-    OMX_U32 nPicOrderCntType;
-    OMX_U32 nLog2MaxPicOrderCntLsbMinus4;
-    OMX_S32 nOffsetForNonRefPic;
-    OMX_S32 nOffsetForTopToBottomField;
-    OMX_U32 nNumRefFramesInPicOrderCntCycle;
-    OMX_U32 nNumRefFrames;
-    OMX_S32 nGapsInFrameNumValueAllowedFlag;
-    OMX_U32 nPicWidthInMbsMinus1;
-    OMX_U32 nPicHeightInMapUnitsMinus1;
-    OMX_U32 nFrameMbsOnlyFlag;
-    OMX_S32 nMBAdaptiveFrameFieldFlag ;
-    OMX_U32 nDirect8x8InferenceFlag;
-    OMX_U32 nFrameCroppingFlag;
-    OMX_U32 nFrameCropLeftOffset;
-    OMX_U32 nFrameCropRightOffset;
-    OMX_U32 nFrameCropTopOffset;
-    OMX_U32 nFrameCropBottomOffset;
-}VIDDEC_AVC_ParserParam;
-
 typedef struct VIDDEC_MPEG4_ParserParam {
     OMX_U32 nIsVisualObjectIdentifier;
     OMX_U32 nVisualObjectType;
@@ -54,6 +54,7 @@
 #include "OMX_VideoDec_Utils.h"
 #include "OMX_VideoDec_DSP.h"
 #include "OMX_VideoDec_Thread.h"
+#include "OMX_TI_Bitstream.h"
 #define LOG_TAG "TI_Video_Decoder"
 /*----------------------------------------------------------------------------*/
 /**
@@ -3957,17 +3958,18 @@ OMX_ERRORTYPE VIDDEC_ParseVideo_MPEG2( OMX_S32* nWidth, OMX_S32* nHeight, OMX_BU
 
     nTotalInBytes = pBuffHead->nFilledLen;
 
+    if (nTotalInBytes < 4) {
+        eError = OMX_ErrorStreamCorrupt;
+        goto EXIT;
+    }
+
     do{
-        for (; (!nStartFlag) && (nInBytePosition < nTotalInBytes - 3); ) {
-           if (VIDDEC_GetBits(&nBitPosition, 24, pHeaderStream, OMX_FALSE) != 0x000001) {
-                nBitPosition += 8;
-                nInBytePosition++;
-           }
-           else {
-               nStartFlag = OMX_TRUE;
-               nBitPosition += 24;
-               nInBytePosition += 3;
-           }
+        /* a start code needs a byte after it */
+        nInBytePosition = OMX_TI_FindStartCode(pHeaderStream, nInBytePosition, nTotalInBytes - 1);
+        if (nInBytePosition < nTotalInBytes - 1) {
+            nStartFlag = OMX_TRUE;
+            nInBytePosition += 3;
+            nBitPosition = nInBytePosition * 8;
         }
         if (!nStartFlag) {
             eError = OMX_ErrorStreamCorrupt;
@@ -4016,17 +4018,18 @@ OMX_ERRORTYPE VIDDEC_ParseVideo_WMV9_VC1( OMX_S32* nWidth, OMX_S32* nHeight, OMX
 
     nTotalInBytes = pBuffHead->nFilledLen;
 
+    if (nTotalInBytes < 4) {
+        eError = OMX_ErrorStreamCorrupt;
+        goto EXIT;
+    }
+
     do{
-        for (; (!nStartFlag) && (nInBytePosition < nTotalInBytes - 3); ) {
-           if (VIDDEC_GetBits(&nBitPosition, 24, pHeaderStream, OMX_FALSE) != 0x000001) {
-                nBitPosition += 8;
-                nInBytePosition++;
-           }
-           else {
-               nStartFlag = OMX_TRUE;
-               nBitPosition += 24;
-               nInBytePosition += 3;
-           }
+        /* a start code needs a byte after it */
+        nInBytePosition = OMX_TI_FindStartCode(pHeaderStream, nInBytePosition, nTotalInBytes - 1);
+        if (nInBytePosition < nTotalInBytes - 1) {
+            nStartFlag = OMX_TRUE;
+            nInBytePosition += 3;
+            nBitPosition = nInBytePosition * 8;
         }
         if (!nStartFlag) {
             eError = OMX_ErrorStreamCorrupt;
@@ -4113,6 +4116,7 @@ OMX_ERRORTYPE VIDDEC_ParseVideo_MPEG4( OMX_S32* nWidth, OMX_S32* nHeight, OMX_BU
     OMX_ERRORTYPE eError = OMX_ErrorUndefined;
     OMX_U32    nSartCode = 0;
     OMX_U32    nBitPosition = 0;
+    OMX_U32    nStartCodePosition = 0;
     OMX_BOOL   bHeaderParseCompleted = OMX_FALSE;
     OMX_BOOL   bFillHeaderInfo = OMX_FALSE;
     OMX_U8* pHeaderStream = (OMX_U8*)pBuffHead->pBuffer;
@@ -4195,10 +4199,13 @@ OMX_ERRORTYPE VIDDEC_ParseVideo_MPEG4( OMX_S32* nWidth, OMX_S32* nHeight, OMX_BU
         else if (nSartCode == 0x1B2) /*user data*/
         {
             OMX_PARSER_CHECKLIMIT(nTotalInBytes, nBitPosition, 24);
-            while (VIDDEC_GetBits(&nBitPosition, 24, pHeaderStream, OMX_TRUE)!= 0x1)
-                nBitPosition-=16;        /*discard only 8 bits and try againg until*/
-                                        /*the next start code is found*/
-            nBitPosition -=24;            /* prepare to read the entire start code*/
+            /*discard the user data up to the next start code, start codes are byte aligned*/
+            nStartCodePosition = OMX_TI_FindStartCode(pHeaderStream, nBitPosition >> 3, pBuffHead->nFilledLen);
+            if (nStartCodePosition == pBuffHead->nFilledLen) {
+                eError = OMX_ErrorStreamCorrupt;
+                goto EXIT;
+            }
+            nBitPosition = nStartCodePosition << 3;    /* prepare to read the entire start code*/
         /*    OMX_PARSER_CHECKLIMIT(nTotalInBytes, nBitPosition, 1);
             sMPEG4_Param->NBitZero = VIDDEC_GetBits(&nBitPosition, 1, pHeaderStream, OMX_TRUE);
             PRINT("sMPEG4_Param->NBitZero = %d", sMPEG4_Param->NBitZero);
@@ -4532,26 +4539,8 @@ EXIT:
 /*                                                                            */
 /*  desc    Use to scan buffer for certain patter. Used to know if ConfigBuffers are together                             */
 /*  ==========================================================================*/
-static OMX_U32 VIDDEC_ScanConfigBufferAVC(OMX_BUFFERHEADERTYPE* pBuffHead,  OMX_U32 pattern){
-    OMX_U32 nBitPosition = 0;
-    OMX_U32 nInBytePosition = 0;
-    OMX_U32 nPatternCounter = 0;
-    OMX_U32 nTotalInBytes = pBuffHead->nFilledLen;
-    OMX_U8* nBitStream = (OMX_U8*)pBuffHead->pBuffer;
-    
-    while (nInBytePosition < nTotalInBytes - 3){
-         if (VIDDEC_GetBits(&nBitPosition, 24, nBitStream, OMX_FALSE) != pattern) {
-              nBitPosition += 8;
-              nInBytePosition++;
-         }
-         else {
-             /*Pattern found; add count*/
-             nPatternCounter++;
-             nBitPosition += 24;
-             nInBytePosition += 3;
-         }
-    }
-    return nPatternCounter;
+static OMX_U32 VIDDEC_ScanConfigBufferAVC(OMX_BUFFERHEADERTYPE* pBuffHead,  OMX_U8 pattern){
+    return OMX_TI_CountPrefixes((OMX_U8*)pBuffHead->pBuffer, pBuffHead->nFilledLen, pattern);
 }
 
 /*  ==========================================================================*/
@@ -4565,12 +4554,9 @@ OMX_ERRORTYPE VIDDEC_ParseVideo_H264(VIDDEC_COMPONENT_PRIVATE* pComponentPrivate
                                      OMX_S32* nCropHeight, OMX_U32 nType)
 {
     OMX_ERRORTYPE eError = OMX_ErrorBadParameter;
-    OMX_S32 i = 0;
-    VIDDEC_AVC_ParserParam* sParserParam = NULL;
+    OMX_TI_AVC_SPS sSps;
     /*OMX_S32 nRetVal = 0;*/
-    OMX_BOOL nStartFlag = OMX_FALSE;
     OMX_U32 nBitPosition = 0;
-    OMX_U32 nRbspPosition = 0;
     OMX_U32 nTotalInBytes = 0;
     OMX_U32 nInBytePosition = 0;
     OMX_U32 nInPositionTemp = 0;
@@ -4593,16 +4579,11 @@ OMX_ERRORTYPE VIDDEC_ParseVideo_H264(VIDDEC_COMPONENT_PRIVATE* pComponentPrivate
         goto EXIT;
     }
     memset(nRbspByte, 0x0, nTotalInBytes);
-    sParserParam = (VIDDEC_AVC_ParserParam *)malloc(sizeof(VIDDEC_AVC_ParserParam));
-    if (!sParserParam) {
-        eError =  OMX_ErrorInsufficientResources;
-        goto EXIT;
-    }
 
     if (nType == 0) {
         /* Start of Handle fragmentation of Config Buffer  Code*/
         /*Scan for 2 "0x000001", requiered on buffer to parser properly*/
-        nConfigBufferCounter += VIDDEC_ScanConfigBufferAVC(pBuffHead, 0x000001);
+        nConfigBufferCounter += VIDDEC_ScanConfigBufferAVC(pBuffHead, 0x01);
         if(nConfigBufferCounter < 2){ /*If less of 2 we need to store the data internally to later assembly the complete ConfigBuffer*/
             /*Set flag to False, the Config Buffer is not complete */
             OMX_PRINT2(pComponentPrivate->dbg, "Setting bConfigBufferCompleteAVC = OMX_FALSE");
@@ -4687,63 +4668,12 @@ OMX_ERRORTYPE VIDDEC_ParseVideo_H264(VIDDEC_COMPONENT_PRIVATE* pComponentPrivate
         }
          /* End of Handle fragmentation Config Buffer Code*/
 
-        do{
-            for (; (!nStartFlag) && (nInBytePosition < nTotalInBytes - 3); )
-            {
-               if (VIDDEC_GetBits(&nBitPosition, 24, nBitStream, OMX_FALSE) != 0x000001)
-               {
-                    nBitPosition += 8;
-                    nInBytePosition++;
-               }
-               else
-               {
-                   /*Start Code found*/
-                   nStartFlag = OMX_TRUE;
-                   nBitPosition += 24;
-                   nInBytePosition += 3;
-               }
-            }
-            nStartFlag = OMX_FALSE;
-            /* offset to NumBytesInNALunit*/
-            nNumBytesInNALunit = nInBytePosition;
-            sParserParam->nBitPosTemp = nBitPosition;
-              for (;(!nStartFlag)&&(nNumBytesInNALunit < nTotalInBytes-3); )
-            {
-                if (VIDDEC_GetBits(&sParserParam->nBitPosTemp, 24, nBitStream, OMX_FALSE) != 0x000001)
-                /*find start code*/
-                {
-                    sParserParam->nBitPosTemp += 8;
-                    nNumBytesInNALunit++;
-                }
-                else
-                {
-                   /*Start Code found*/
-                    nStartFlag = OMX_TRUE;
-                    sParserParam->nBitPosTemp += 24;
-                    nNumBytesInNALunit += 3;
-                }
-            }
-
-            if (!nStartFlag)
-            {
-                eError = OMX_ErrorStreamCorrupt;
-                goto EXIT;
-            }
-            /* forbidden_zero_bit */
-            sParserParam->nForbiddenZeroBit = VIDDEC_GetBits(&nBitPosition, 1, nBitStream, OMX_TRUE);
-            /* nal_ref_idc */
-            sParserParam->nNalRefIdc = VIDDEC_GetBits(&nBitPosition, 2, nBitStream, OMX_TRUE);
-            /* nal_unit_type */
-            nNalUnitType = VIDDEC_GetBits(&nBitPosition, 5, nBitStream, OMX_TRUE);
-            nInBytePosition++;
-
-            /* This code is to ensure we will get parameter info */
-            if (nNalUnitType != 7)
-            {
-                OMX_PRINT2(pComponentPrivate->dbg, "nal_unit_type does not specify parameter information need to look for next startcode\n");
-                nStartFlag = OMX_FALSE;
-            }
-        }while (nNalUnitType != 7);
+        if (!OMX_TI_FindAvcSps(nBitStream, nTotalInBytes, &nInBytePosition, &nInPositionTemp))
+        {
+            eError = OMX_ErrorStreamCorrupt;
+            goto EXIT;
+        }
+        nNumBytesInNALunit = nInPositionTemp + 3;
     }
     else {
          pDataBuf = (OMX_U8*)nBitStream;
@@ -4786,12 +4716,8 @@ OMX_ERRORTYPE VIDDEC_ParseVideo_H264(VIDDEC_COMPONENT_PRIVATE* pComponentPrivate
                 eError = OMX_ErrorBadParameter;
                 goto EXIT;
             }
-            /* forbidden_zero_bit */
-            sParserParam->nForbiddenZeroBit = VIDDEC_GetBits(&nBitPosition, 1, nBitStream, OMX_TRUE);
-            /* nal_ref_idc */
-            sParserParam->nNalRefIdc = VIDDEC_GetBits(&nBitPosition, 2, nBitStream, OMX_TRUE);
-            /* nal_unit_type */
-            nNalUnitType = VIDDEC_GetBits(&nBitPosition, 5, nBitStream, OMX_TRUE);
+            /* nal_unit_type, after forbidden_zero_bit and nal_ref_idc */
+            nNalUnitType = VIDDEC_GetBits(&nBitPosition, 8, nBitStream, OMX_TRUE) & 0x1F;
             nInBytePosition++;
             /* This code is to ensure we will get parameter info */
             if (nNalUnitType != 7) {
@@ -4805,100 +4731,29 @@ OMX_ERRORTYPE VIDDEC_ParseVideo_H264(VIDDEC_COMPONENT_PRIVATE* pComponentPrivate
         nNumBytesInNALunit += 8 + nInBytePosition;/*sum to keep the code flow*/
                                 /*the buffer must had enough space to enter this number*/
     }
-    for (i=0; nInBytePosition < nNumBytesInNALunit - 3; )
-    {
-
-        if (((nInBytePosition + 2) < nNumBytesInNALunit - 3)&&
-            (VIDDEC_GetBits(&nBitPosition, 24, nBitStream, OMX_FALSE) == 0x000003))
-        {
-            OMX_PRINT2(pComponentPrivate->dbg, "discard emulation prev byte\n");
-            nRbspByte[i++] = nBitStream[nInBytePosition++];
-            nRbspByte[i++] = nBitStream[nInBytePosition++];
-            nNumOfBytesInRbsp += 2;
-            /* discard emulation prev byte */
-            nInBytePosition++;
-            nBitPosition += 24;
-        }
-        else
-        {
-            nRbspByte[i++] = nBitStream[nInBytePosition++];
-            nNumOfBytesInRbsp++;
-            nBitPosition += 8;
-        }
-    }
-
-
-    /*Parse RBSP sequence*/
-    /*///////////////////*/
-    /*  profile_idc u(8) */
-    sParserParam->nProfileIdc = VIDDEC_GetBits(&nRbspPosition, 8, nRbspByte, OMX_TRUE);
-    /* constraint_set0_flag u(1)*/
-    sParserParam->nConstraintSet0Flag = VIDDEC_GetBits(&nRbspPosition, 1, nRbspByte, OMX_TRUE);
-    /* constraint_set1_flag u(1)*/
-    sParserParam->nConstraintSet1Flag = VIDDEC_GetBits(&nRbspPosition, 1, nRbspByte, OMX_TRUE);
-    /* constraint_set2_flag u(1)*/
-    sParserParam->nConstraintSet2Flag = VIDDEC_GetBits(&nRbspPosition, 1, nRbspByte, OMX_TRUE);
-    /* reserved_zero_5bits u(5)*/
-    sParserParam->nReservedZero5bits = VIDDEC_GetBits(&nRbspPosition, 5, nRbspByte, OMX_TRUE);
-    /* level_idc*/
-    sParserParam->nLevelIdc = VIDDEC_GetBits(&nRbspPosition, 8, nRbspByte, OMX_TRUE);
-    sParserParam->nSeqParameterSetId = VIDDEC_UVLC_dec(&nRbspPosition, nRbspByte);
-    sParserParam->nLog2MaxFrameNumMinus4 = VIDDEC_UVLC_dec(&nRbspPosition, nRbspByte);
-    sParserParam->nPicOrderCntType = VIDDEC_UVLC_dec(&nRbspPosition, nRbspByte);
-
-    if ( sParserParam->nPicOrderCntType == 0 )
-    {
-        sParserParam->nLog2MaxPicOrderCntLsbMinus4 = VIDDEC_UVLC_dec(&nRbspPosition, nRbspByte);
-    }
-    else if( sParserParam->nPicOrderCntType == 1 )
-    {
-        /* delta_pic_order_always_zero_flag*/
-        VIDDEC_GetBits(&nRbspPosition, 1, nRbspByte, OMX_TRUE);
-        sParserParam->nOffsetForNonRefPic = VIDDEC_UVLC_dec(&nRbspPosition, nRbspByte);
-        if (sParserParam->nOffsetForNonRefPic > 1)
-              sParserParam->nOffsetForNonRefPic = sParserParam->nOffsetForNonRefPic & 0x1 ?
-                                                sParserParam->nOffsetForNonRefPic >> 1 :
-                                              -(sParserParam->nOffsetForNonRefPic >> 1);
-        sParserParam->nOffsetForTopToBottomField = VIDDEC_UVLC_dec(&nRbspPosition, nRbspByte);
-        sParserParam->nNumRefFramesInPicOrderCntCycle = VIDDEC_UVLC_dec(&nRbspPosition, nRbspByte);
-        for(i = 0; i < sParserParam->nNumRefFramesInPicOrderCntCycle; i++ )
-            VIDDEC_UVLC_dec(&nRbspPosition, nRbspByte); /*offset_for_ref_frame[i]*/
-    }
-
-    sParserParam->nNumRefFrames = VIDDEC_UVLC_dec(&nRbspPosition, nRbspByte);
-    sParserParam->nGapsInFrameNumValueAllowedFlag = VIDDEC_GetBits(&nRbspPosition, 1, nRbspByte, OMX_TRUE);
-    sParserParam->nPicWidthInMbsMinus1 = VIDDEC_UVLC_dec(&nRbspPosition, nRbspByte);
-    (*nWidth) = (sParserParam->nPicWidthInMbsMinus1 + 1) * 16;
-    sParserParam->nPicHeightInMapUnitsMinus1 = VIDDEC_UVLC_dec(&nRbspPosition, nRbspByte);
-    (*nHeight) = (sParserParam->nPicHeightInMapUnitsMinus1 + 1) * 16;
-    /* Checking for cropping in picture saze */
-    /* getting frame_mbs_only_flag */
-    sParserParam->nFrameMbsOnlyFlag = VIDDEC_GetBits(&nRbspPosition, 1, nRbspByte, OMX_TRUE);
-    if (!sParserParam->nFrameMbsOnlyFlag)
+    /* copy the NAL unit up to the next start code, without the emulation
+       prevention bytes */
+    if (nInBytePosition < (OMX_U32)(nNumBytesInNALunit - 3))
     {
-        sParserParam->nMBAdaptiveFrameFieldFlag = VIDDEC_GetBits(&nRbspPosition, 1, nRbspByte, OMX_TRUE);
+        nNumOfBytesInRbsp = OMX_TI_CopyRbsp(nRbspByte, nBitStream,
+                                            nInBytePosition, nNumBytesInNALunit - 3);
     }
-    /*getting direct_8x8_inference_flag and frame_cropping_flag*/
-    sParserParam->nDirect8x8InferenceFlag = VIDDEC_GetBits(&nRbspPosition, 1, nRbspByte, OMX_TRUE);
-    sParserParam->nFrameCroppingFlag = VIDDEC_GetBits(&nRbspPosition, 1, nRbspByte, OMX_TRUE);
-    /*getting the crop values if exist*/
-    if (sParserParam->nFrameCroppingFlag)
+    OMX_PRINT2(pComponentPrivate->dbg, "%lu bytes of RBSP\n", nNumOfBytesInRbsp);
+    OMX_TI_ParseAvcSps(nRbspByte, nTotalInBytes, &sSps);
+
+    (*nWidth) = (sSps.nPicWidthInMbsMinus1 + 1) * 16;
+    (*nHeight) = (sSps.nPicHeightInMapUnitsMinus1 + 1) * 16;
+    /* Update framesize taking into account the cropping values */
+    if (sSps.nFrameCroppingFlag)
     {
-        sParserParam->nFrameCropLeftOffset = VIDDEC_UVLC_dec(&nRbspPosition, nRbspByte);
-        sParserParam->nFrameCropRightOffset = VIDDEC_UVLC_dec(&nRbspPosition, nRbspByte);
-        sParserParam->nFrameCropTopOffset = VIDDEC_UVLC_dec(&nRbspPosition, nRbspByte);
-        sParserParam->nFrameCropBottomOffset = VIDDEC_UVLC_dec(&nRbspPosition, nRbspByte);
-        /* Update framesize taking into account the cropping values */
-        (*nCropWidth) = (2 * sParserParam->nFrameCropLeftOffset + 2 * sParserParam->nFrameCropRightOffset);
-        (*nCropHeight) = (2 * sParserParam->nFrameCropTopOffset + 2 * sParserParam->nFrameCropBottomOffset);
+        (*nCropWidth) = (2 * sSps.nFrameCropLeftOffset + 2 * sSps.nFrameCropRightOffset);
+        (*nCropHeight) = (2 * sSps.nFrameCropTopOffset + 2 * sSps.nFrameCropBottomOffset);
     }
     eError = OMX_ErrorNone;
 
 EXIT:
     if (nRbspByte)
         free( nRbspByte);
-    if (sParserParam)
-        free( sParserParam);
     return eError;
 }
 #endif
@@ -53,6 +53,7 @@
 #define WSPI_PAD_LEN_WRITE          4
 #define WSPI_PAD_LEN_READ           8                    
 #define MAX_XFER_BUFS               4
+#define MAX_AGGREG_TXNS             16   /* Max transactions the TxnQ combines in one bus transaction */
 
 #define TXN_PARAM_STATUS_OK         0
 #define TXN_PARAM_STATUS_ERROR      1
@@ -94,6 +94,9 @@ typedef struct _TBusDrvObj
     TI_UINT8 *       pTxDmaBuf;          /* The Tx DMA-able buffer for buffering all write transactions */
     TI_UINT32        uTxDmaBufLen;       /* The Tx DMA-able buffer length in bytes */
     TI_UINT32        uTxnLength;         /* The current transaction accumulated length (including Tx aggregation case) */
+    TI_UINT32        uTxnHwAddr;         /* The current transaction HW address (of the first Txn in aggregation case) */
+    TTxnStruct *     aAggregRxTxns[MAX_AGGREG_TXNS]; /* Read transactions accumulated so far in an Rx aggregation */
+    TI_UINT32        uAggregRxTxnsNum;   /* Number of read transactions in aAggregRxTxns */
 
 } TBusDrvObj;
 
@@ -104,6 +107,7 @@ typedef struct _TBusDrvObj
 static TI_BOOL  busDrv_PrepareTxnParts  (TBusDrvObj *pBusDrv, TTxnStruct *pTxn);
 static void     busDrv_SendTxnParts     (TBusDrvObj *pBusDrv);
 static void     busDrv_TxnDoneCb        (TI_HANDLE hBusDrv, TI_INT32 status);
+static TI_UINT8 *busDrv_CopyRxBufs      (TBusDrvObj *pBusDrv, TTxnStruct *pTxn, TI_UINT8 *pDmaBuf);
  
 
 
@@ -230,6 +234,7 @@ TI_STATUS busDrv_ConnectBus (TI_HANDLE        hBusDrv,
     pBusDrv->uCurrTxnPartsNum = 0;
     pBusDrv->uCurrTxnPartsCountSync = 0;
     pBusDrv->uTxnLength = 0;
+    pBusDrv->uAggregRxTxnsNum = 0;
 	
     /*
      * Configure the SDIO driver parameters and handle SDIO enumeration.
@@ -357,7 +362,7 @@ ETxnStatus busDrv_Transact (TI_HANDLE hBusDrv, TTxnStruct *pTxn)
 static TI_BOOL busDrv_PrepareTxnParts (TBusDrvObj *pBusDrv, TTxnStruct *pTxn)
 {
     TI_UINT32 uPartNum     = 0;
-    TI_UINT32 uCurrHwAddr  = pTxn->uHwAddr;
+    TI_UINT32 uCurrHwAddr;
     TI_BOOL   bFixedHwAddr = TXN_PARAM_GET_FIXED_ADDR(pTxn);
     TI_BOOL   bWrite       = (TXN_PARAM_GET_DIRECTION(pTxn) == TXN_DIRECTION_WRITE) ? TI_TRUE : TI_FALSE;
     TI_UINT8 *pHostBuf     = bWrite ? pBusDrv->pTxDmaBuf : pBusDrv->pRxDmaBuf; /* Use DMA buffer (Rx or Tx) for actual transaction */
@@ -365,6 +370,13 @@ static TI_BOOL busDrv_PrepareTxnParts (TBusDrvObj *pBusDrv, TTxnStruct *pTxn)
     TI_UINT32 uBufLen;
     TI_UINT32 uRemainderLen;
 
+    /* If first Txn (not in the middle of an aggregation), save its HW address for the whole transaction */
+    if (pBusDrv->uTxnLength == 0)
+    {
+        pBusDrv->uTxnHwAddr       = pTxn->uHwAddr;
+        pBusDrv->uAggregRxTxnsNum = 0;
+    }
+
     /* Go over the transaction buffers */
     for (uBufNum = 0; uBufNum < MAX_XFER_BUFS; uBufNum++) 
     {
@@ -386,14 +398,27 @@ static TI_BOOL busDrv_PrepareTxnParts (TBusDrvObj *pBusDrv, TTxnStruct *pTxn)
         pBusDrv->uTxnLength += uBufLen;
     }
 
-    /* If in a Tx aggregation, return TRUE (need to accumulate all parts before sending the transaction) */
+    /* If in an aggregation, return TRUE (need to accumulate all parts before sending the transaction) */
     if (TXN_PARAM_GET_AGGREGATE(pTxn) == TXN_AGGREGATE_ON)
     {
+        /* For read, save the Txn so its buffers are filled from the DMA buffer when the read is done */
+        if (!bWrite)
+        {
+            if (pBusDrv->uAggregRxTxnsNum < MAX_AGGREG_TXNS)
+            {
+                pBusDrv->aAggregRxTxns[pBusDrv->uAggregRxTxnsNum++] = pTxn;
+            }
+            else
+            {
+                TRACE1(pBusDrv->hReport, REPORT_SEVERITY_ERROR, "busDrv_PrepareTxnParts: Too many Txns in Rx aggregation, uTxnLength=%d\n", pBusDrv->uTxnLength);
+            }
+        }
         TRACE6(pBusDrv->hReport, REPORT_SEVERITY_INFORMATION, "busDrv_PrepareTxnParts: In aggregation so exit, uTxnLength=%d, bWrite=%d, Len0=%d, Len1=%d, Len2=%d, Len3=%d\n", pBusDrv->uTxnLength, bWrite, pTxn->aLen[0], pTxn->aLen[1], pTxn->aLen[2], pTxn->aLen[3]);
         return TI_TRUE;
     }
 
     /* If current buffer has a remainder, prepare its transaction part */
+    uCurrHwAddr   = pBusDrv->uTxnHwAddr;
     uRemainderLen = pBusDrv->uTxnLength & pBusDrv->uBlkSizeMask;
     if (uRemainderLen > 0)
     {
@@ -456,7 +481,7 @@ static TI_BOOL busDrv_PrepareTxnParts (TBusDrvObj *pBusDrv, TTxnStruct *pTxn)
     pBusDrv->aTxnParts[uPartNum - 1].bMore = TXN_PARAM_GET_MORE(pTxn);
     pBusDrv->uCurrTxnPartsNum = uPartNum;
 
-    TRACE9(pBusDrv->hReport, REPORT_SEVERITY_INFORMATION, "busDrv_PrepareTxnParts: Txn prepared, PartsNum=%d, bWrite=%d, uTxnLength=%d, uRemainderLen=%d, uHwAddr=0x%x, Len0=%d, Len1=%d, Len2=%d, Len3=%d\n", uPartNum, bWrite, pBusDrv->uTxnLength, uRemainderLen, pTxn->uHwAddr, pTxn->aLen[0], pTxn->aLen[1], pTxn->aLen[2], pTxn->aLen[3]);
+    TRACE9(pBusDrv->hReport, REPORT_SEVERITY_INFORMATION, "busDrv_PrepareTxnParts: Txn prepared, PartsNum=%d, bWrite=%d, uTxnLength=%d, uRemainderLen=%d, uHwAddr=0x%x, Len0=%d, Len1=%d, Len2=%d, Len3=%d\n", uPartNum, bWrite, pBusDrv->uTxnLength, uRemainderLen, pBusDrv->uTxnHwAddr, pTxn->aLen[0], pTxn->aLen[1], pTxn->aLen[2], pTxn->aLen[3]);
 
     pBusDrv->uTxnLength = 0;
 
@@ -560,23 +585,16 @@ static void busDrv_SendTxnParts (TBusDrvObj *pBusDrv)
     /* For read transaction, copy the data from the DMA-able buffer to the host buffer(s) */
     if (TXN_PARAM_GET_DIRECTION(pTxn) == TXN_DIRECTION_READ)
     {
-        TI_UINT32 uBufNum;
-        TI_UINT32 uBufLen;
         TI_UINT8 *pDmaBuf = pBusDrv->pRxDmaBuf; /* After the read transaction the data is in the Rx DMA buffer */
+        TI_UINT32 i;
 
-        for (uBufNum = 0; uBufNum < MAX_XFER_BUFS; uBufNum++)
+        /* First the Txns aggregated before the current one (if any), in their order */
+        for (i = 0; i < pBusDrv->uAggregRxTxnsNum; i++)
         {
-            uBufLen = pTxn->aLen[uBufNum];
-
-            /* If no more buffers, exit the loop */
-            if (uBufLen == 0)
-            {
-                break;
-            }
-
-            os_memoryCopy (pBusDrv->hOs, pTxn->aBuf[uBufNum], pDmaBuf, uBufLen);
-            pDmaBuf += uBufLen;
+            pDmaBuf = busDrv_CopyRxBufs (pBusDrv, pBusDrv->aAggregRxTxns[i], pDmaBuf);
         }
+
+        busDrv_CopyRxBufs (pBusDrv, pTxn, pDmaBuf);
     }
 
     /* Set status OK in Txn struct, and call TxnDone CB if not fully sync */
@@ -588,6 +606,43 @@ static void busDrv_SendTxnParts (TBusDrvObj *pBusDrv)
 }
 
 
+/** 
+ * \fn     busDrv_CopyRxBufs
+ * \brief  Copy read data to the Txn host buffers
+ * 
+ * Called by busDrv_SendTxnParts() when a read transaction is done.
+ * Copies the Txn part of the read data from the Rx DMA buffer to the Txn host buffer(s).
+ * 
+ * \note   
+ * \param  pBusDrv - The module's object
+ * \param  pTxn    - The transaction object 
+ * \param  pDmaBuf - The Txn data in the Rx DMA buffer
+ * \return The next Txn data in the Rx DMA buffer (for Rx aggregation)
+ * \sa     busDrv_SendTxnParts
+ */ 
+static TI_UINT8 *busDrv_CopyRxBufs (TBusDrvObj *pBusDrv, TTxnStruct *pTxn, TI_UINT8 *pDmaBuf)
+{
+    TI_UINT32 uBufNum;
+    TI_UINT32 uBufLen;
+
+    for (uBufNum = 0; uBufNum < MAX_XFER_BUFS; uBufNum++)
+    {
+        uBufLen = pTxn->aLen[uBufNum];
+
+        /* If no more buffers, exit the loop */
+        if (uBufLen == 0)
+        {
+            break;
+        }
+
+        os_memoryCopy (pBusDrv->hOs, pTxn->aBuf[uBufNum], pDmaBuf, uBufLen);
+        pDmaBuf += uBufLen;
+    }
+
+    return pDmaBuf;
+}
+
+
 /** 
  * \fn     busDrv_TxnDoneCb
  * \brief  Continue async transaction processing (CB)
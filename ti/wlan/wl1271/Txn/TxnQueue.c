@@ -74,6 +74,19 @@
 #define MAX_PRIORITY        2   /* Maximum 2 prioritys per functional driver */
 #define TXN_QUE_SIZE        QUE_UNLIMITED_SIZE
 #define TXN_DONE_QUE_SIZE   QUE_UNLIMITED_SIZE
+#define NO_AGGREG_QUE       0xFFFFFFFF  /* uAggregQueIdx value while no Tx aggregation is in progress */
+
+
+/************************************************************************
+ * Macros
+ ************************************************************************/
+/* 
+ * The queues are mapped to bits by priority and then function, so the lowest bit set in
+ *     the ready-queues bitmap is the first queue to serve (as the priorities loop used to do).
+ */
+#define TXN_QUE_IDX(uFunc, uPrio)   ((uPrio) * MAX_FUNCTIONS + (uFunc))
+#define TXN_QUE_FUNC(uQueIdx)       ((uQueIdx) % MAX_FUNCTIONS)
+#define TXN_QUE_PRIO(uQueIdx)       ((uQueIdx) / MAX_FUNCTIONS)
 
 
 /************************************************************************
@@ -113,8 +126,9 @@ typedef struct _TTxnQObj
     TI_HANDLE       aTxnQueues[MAX_FUNCTIONS][MAX_PRIORITY];  /* Handle of the Transactions-Queue */
     TI_HANDLE       hTxnDoneQueue;      /* Queue for completed transactions not reported to yet to the upper layer */
     TTxnStruct *    pCurrTxn;           /* The transaction currently processed in the bus driver (NULL if none) */
-    TI_UINT32       uMinFuncId;         /* The minimal function ID actually registered (through txnQ_Open) */
-    TI_UINT32       uMaxFuncId;         /* The maximal function ID actually registered (through txnQ_Open) */
+    TI_UINT32       uReadyQueMap;       /* Bitmap of non-empty queues (bit per TXN_QUE_IDX) */
+    TI_UINT32       uRunningQueMap;     /* Bitmap of the queues of the running functions (bit per TXN_QUE_IDX) */
+    TI_UINT32       uSingleStepMap;     /* Bitmap of the functions with a single step Txn waiting (bit per function) */
     TI_BOOL         bSchedulerBusy;     /* If set, the scheduler is currently running so it shouldn't be reentered */
     TI_BOOL         bSchedulerPend;     /* If set, a call to the scheduler was postponed because it was busy */
     
@@ -122,8 +136,19 @@ typedef struct _TTxnQObj
     TTxnDoneCb      fConnectCb;
     TI_HANDLE       hConnectCb;
 
+    TI_UINT32       uAggregQueIdx;      /* While Tx aggregation in progress, saves its queue index to ensure continuity */
+
+    /* Txn aggregation - combining adjacent queued transactions in one bus transaction */
+    TI_UINT32       uAggregMaxLen;      /* Configured max bytes in one bus transaction (see txnQ_SetAggregParams) */
+    TI_UINT32       uAggregMaxTxns;     /* Configured max Txns in one bus transaction (1 = no aggregation) */
+    TI_UINT32       aDmaBufLen[2];      /* The bus driver DMA buffer length per direction (0 if not supported) */
+    TI_UINT32       aAggregMaxLen[2];   /* Max bytes per direction - the configured limit bounded by the DMA buffers */
+    TTxnStruct *    aAggregTxns[MAX_AGGREG_TXNS]; /* The Txns sent together, the last is pCurrTxn while pending */
+    TI_UINT32       uAggregTxnsNum;     /* Number of Txns in aAggregTxns */
+
 #ifdef TI_DBG
-    TI_HANDLE       pAggregQueue;       /* While Tx aggregation in progress, saves its queue pointer to ensure continuity */
+    TI_UINT32       uDbgBusTxns;        /* Number of bus transactions issued */
+    TI_UINT32       uDbgAggregTxns;     /* Number of Txns sent combined with a previous one */
 #endif
 
 } TTxnQObj;
@@ -136,6 +161,10 @@ static void         txnQ_TxnDoneCb    (TI_HANDLE hTxnQ, void *hTxn);
 static ETxnStatus   txnQ_RunScheduler (TTxnQObj *pTxnQ, TTxnStruct *pInputTxn);
 static ETxnStatus   txnQ_Scheduler    (TTxnQObj *pTxnQ, TTxnStruct *pInputTxn);
 static TTxnStruct  *txnQ_SelectTxn    (TTxnQObj *pTxnQ);
+static TTxnStruct  *txnQ_DequeueTxn   (TTxnQObj *pTxnQ, TI_UINT32 uQueIdx);
+static void         txnQ_AggregateTxns(TTxnQObj *pTxnQ, TTxnStruct *pFirstTxn, TI_UINT32 uQueIdx);
+static TI_BOOL      txnQ_AggregTxnsDone (TTxnQObj *pTxnQ, TTxnStruct *pInputTxn, TI_BOOL bDrop);
+static void         txnQ_SetFuncState (TTxnQObj *pTxnQ, TI_UINT32 uFuncId, EFuncState eState);
 static void         txnQ_ConnectCB    (TI_HANDLE hTxnQ, void *hTxn);
 
 
@@ -162,11 +191,8 @@ TI_HANDLE txnQ_Create (TI_HANDLE hOs)
     
     pTxnQ->hOs             = hOs;
     pTxnQ->pCurrTxn        = NULL;
-    pTxnQ->uMinFuncId      = MAX_FUNCTIONS; /* Start at maximum and save minimal value in txnQ_Open */
-    pTxnQ->uMaxFuncId      = 0;             /* Start at minimum and save maximal value in txnQ_Open */
-#ifdef TI_DBG
-    pTxnQ->pAggregQueue    = NULL;
-#endif
+    pTxnQ->uAggregQueIdx   = NO_AGGREG_QUE;
+    pTxnQ->uAggregMaxTxns  = 1;             /* No Txn aggregation unless configured (txnQ_SetAggregParams) */
 
     for (i = 0; i < MAX_FUNCTIONS; i++)
     {
@@ -236,13 +262,35 @@ TI_STATUS txnQ_ConnectBus (TI_HANDLE  hTxnQ,
                            TI_UINT32  *pTxDmaBufLen)
 {
     TTxnQObj *pTxnQ = (TTxnQObj*) hTxnQ;
+    TI_STATUS eStatus;
 
     TRACE0(pTxnQ->hReport, REPORT_SEVERITY_INFORMATION, "txnQ_ConnectBus()\n");
 
     pTxnQ->fConnectCb = fConnectCb;
     pTxnQ->hConnectCb = hConnectCb;
 
-    return busDrv_ConnectBus (pTxnQ->hBusDrv, pBusDrvCfg, txnQ_TxnDoneCb, hTxnQ, txnQ_ConnectCB, pRxDmaBufLen, pTxDmaBufLen);
+    /* A bus driver that doesn't report DMA buffers doesn't support aggregation (limits stay 0) */
+    *pRxDmaBufLen = 0;
+    *pTxDmaBufLen = 0;
+
+    eStatus = busDrv_ConnectBus (pTxnQ->hBusDrv, pBusDrvCfg, txnQ_TxnDoneCb, hTxnQ, txnQ_ConnectCB, pRxDmaBufLen, pTxDmaBufLen);
+
+    /* The Txn aggregation length is bounded by the DMA buffer of each direction */
+    pTxnQ->aDmaBufLen[TXN_DIRECTION_READ]  = *pRxDmaBufLen;
+    pTxnQ->aDmaBufLen[TXN_DIRECTION_WRITE] = *pTxDmaBufLen;
+    txnQ_SetAggregParams (hTxnQ, pTxnQ->uAggregMaxLen, pTxnQ->uAggregMaxTxns);
+
+    return eStatus;
+}
+
+void txnQ_SetAggregParams (TI_HANDLE hTxnQ, TI_UINT32 uMaxLen, TI_UINT32 uMaxTxns)
+{
+    TTxnQObj *pTxnQ = (TTxnQObj*) hTxnQ;
+
+    pTxnQ->uAggregMaxLen  = uMaxLen;
+    pTxnQ->uAggregMaxTxns = TI_MIN(TI_MAX(uMaxTxns, 1), MAX_AGGREG_TXNS);
+    pTxnQ->aAggregMaxLen[TXN_DIRECTION_READ]  = TI_MIN(uMaxLen, pTxnQ->aDmaBufLen[TXN_DIRECTION_READ]);
+    pTxnQ->aAggregMaxLen[TXN_DIRECTION_WRITE] = TI_MIN(uMaxLen, pTxnQ->aDmaBufLen[TXN_DIRECTION_WRITE]);
 }
 
 TI_STATUS txnQ_DisconnectBus (TI_HANDLE hTxnQ)
@@ -274,7 +322,7 @@ TI_STATUS txnQ_Open (TI_HANDLE       hTxnQ,
     pTxnQ->aFuncInfo[uFuncId].uNumPrios       = uNumPrios;
     pTxnQ->aFuncInfo[uFuncId].fTxnQueueDoneCb = fTxnQueueDoneCb;
     pTxnQ->aFuncInfo[uFuncId].hCbHandle       = hCbHandle;
-    pTxnQ->aFuncInfo[uFuncId].eState          = FUNC_STATE_STOPPED;
+    txnQ_SetFuncState (pTxnQ, uFuncId, FUNC_STATE_STOPPED);
     
     /* Create the functional driver's queues. */
     uNodeHeaderOffset = TI_FIELD_OFFSET(TTxnStruct, tTxnQNode); 
@@ -289,16 +337,6 @@ TI_STATUS txnQ_Open (TI_HANDLE       hTxnQ,
         }
     }
 
-    /* Update functions actual range (to optimize Txn selection loops - see txnQ_SelectTxn) */
-    if (uFuncId < pTxnQ->uMinFuncId) 
-    {
-        pTxnQ->uMinFuncId = uFuncId;
-    }
-    if (uFuncId > pTxnQ->uMaxFuncId) 
-    {
-        pTxnQ->uMaxFuncId = uFuncId;
-    }
-
     context_LeaveCriticalSection (pTxnQ->hContext);
 
     TRACE2(pTxnQ->hReport, REPORT_SEVERITY_INFORMATION, ": Function %d registered successfully, uNumPrios = %d\n", uFuncId, uNumPrios);
@@ -317,31 +355,16 @@ void txnQ_Close (TI_HANDLE  hTxnQ, TI_UINT32 uFuncId)
     for (i = 0; i < pTxnQ->aFuncInfo[uFuncId].uNumPrios; i++)
     {
         que_Destroy (pTxnQ->aTxnQueues[uFuncId][i]);
+        pTxnQ->uReadyQueMap &= ~(1 << TXN_QUE_IDX(uFuncId, i));
     }
 
     /* Clear functional driver info */
+    txnQ_SetFuncState (pTxnQ, uFuncId, FUNC_STATE_NONE);
     pTxnQ->aFuncInfo[uFuncId].uNumPrios       = 0;
     pTxnQ->aFuncInfo[uFuncId].fTxnQueueDoneCb = NULL;
     pTxnQ->aFuncInfo[uFuncId].hCbHandle       = NULL;
-    pTxnQ->aFuncInfo[uFuncId].eState          = FUNC_STATE_NONE;
-    
-    /* Update functions actual range (to optimize Txn selection loops - see txnQ_SelectTxn) */
-    pTxnQ->uMinFuncId      = MAX_FUNCTIONS; 
-    pTxnQ->uMaxFuncId      = 0;             
-    for (i = 0; i < MAX_FUNCTIONS; i++) 
-    {
-        if (pTxnQ->aFuncInfo[i].eState != FUNC_STATE_NONE) 
-        {
-            if (i < pTxnQ->uMinFuncId) 
-            {
-                pTxnQ->uMinFuncId = i;
-            }
-            if (i > pTxnQ->uMaxFuncId) 
-            {
-                pTxnQ->uMaxFuncId = i;
-            }
-        }
-    }
+    pTxnQ->aFuncInfo[uFuncId].pSingleStep     = NULL;
+    pTxnQ->uSingleStepMap &= ~(1 << uFuncId);
 
     context_LeaveCriticalSection (pTxnQ->hContext);
 
@@ -361,7 +384,7 @@ ETxnStatus txnQ_Restart (TI_HANDLE hTxnQ, TI_UINT32 uFuncId)
     {
         if (TXN_PARAM_GET_FUNC_ID(pTxnQ->pCurrTxn) == uFuncId)
         {
-            pTxnQ->aFuncInfo[uFuncId].eState = FUNC_STATE_RESTART;
+            txnQ_SetFuncState (pTxnQ, uFuncId, FUNC_STATE_RESTART);
 
             context_LeaveCriticalSection (pTxnQ->hContext);
 
@@ -394,7 +417,7 @@ void txnQ_Run (TI_HANDLE hTxnQ, TI_UINT32 uFuncId)
 #endif
 
     /* Enable function's queues */
-    pTxnQ->aFuncInfo[uFuncId].eState = FUNC_STATE_RUNNING;
+    txnQ_SetFuncState (pTxnQ, uFuncId, FUNC_STATE_RUNNING);
 
     /* Send queued transactions as possible */
     txnQ_RunScheduler (pTxnQ, NULL); 
@@ -412,8 +435,8 @@ void txnQ_Stop (TI_HANDLE hTxnQ, TI_UINT32 uFuncId)
     }
 #endif
 
-    /* Enable function's queues */
-    pTxnQ->aFuncInfo[uFuncId].eState = FUNC_STATE_STOPPED;
+    /* Disable function's queues */
+    txnQ_SetFuncState (pTxnQ, uFuncId, FUNC_STATE_STOPPED);
 }
 
 ETxnStatus txnQ_Transact (TI_HANDLE hTxnQ, TTxnStruct *pTxn)
@@ -424,15 +447,23 @@ ETxnStatus txnQ_Transact (TI_HANDLE hTxnQ, TTxnStruct *pTxn)
 
     if (TXN_PARAM_GET_SINGLE_STEP(pTxn)) 
     {
+        context_EnterCriticalSection (pTxnQ->hContext);
         pTxnQ->aFuncInfo[uFuncId].pSingleStep = pTxn;
+        pTxnQ->uSingleStepMap |= 1 << uFuncId;
+        context_LeaveCriticalSection (pTxnQ->hContext);
         TRACE0(pTxnQ->hReport, REPORT_SEVERITY_INFORMATION, "txnQ_Transact(): Single step Txn\n");
     }
     else 
     {
         TI_STATUS eStatus;
-        TI_HANDLE hQueue = pTxnQ->aTxnQueues[uFuncId][TXN_PARAM_GET_PRIORITY(pTxn)];
+        TI_UINT32 uPrio  = TXN_PARAM_GET_PRIORITY(pTxn);
+        TI_HANDLE hQueue = pTxnQ->aTxnQueues[uFuncId][uPrio];
         context_EnterCriticalSection (pTxnQ->hContext);
         eStatus = que_Enqueue (hQueue, (TI_HANDLE)pTxn);
+        if (eStatus == TI_OK)
+        {
+            pTxnQ->uReadyQueMap |= 1 << TXN_QUE_IDX(uFuncId, uPrio);
+        }
         context_LeaveCriticalSection (pTxnQ->hContext);
         if (eStatus != TI_OK)
         {
@@ -505,23 +536,18 @@ static void txnQ_TxnDoneCb (TI_HANDLE hTxnQ, void *hTxn)
         /* First, Clear the restarted function queues  */
         txnQ_ClearQueues (hTxnQ, uFuncId);
 
+        /* Drop the Txns sent together with the current one, as the queued ones */
+        txnQ_AggregTxnsDone (pTxnQ, NULL, TI_TRUE);
+
         /* Call function CB for current Txn with restart indication */
         TXN_PARAM_SET_STATUS(pTxn, TXN_PARAM_STATUS_RECOVERY);
         pTxnQ->aFuncInfo[uFuncId].fTxnQueueDoneCb (pTxnQ->aFuncInfo[uFuncId].hCbHandle, pTxn);
     }
 
-    /* In the normal case (no restart), enqueue completed transaction in TxnDone queue */
+    /* In the normal case (no restart), enqueue completed transaction(s) in TxnDone queue */
     else 
     {
-        TI_STATUS eStatus;
-
-        context_EnterCriticalSection (pTxnQ->hContext);
-        eStatus = que_Enqueue (pTxnQ->hTxnDoneQueue, (TI_HANDLE)pTxn);
-        if (eStatus != TI_OK)
-        {
-            TRACE3(pTxnQ->hReport, REPORT_SEVERITY_ERROR, "txnQ_TxnDoneCb(): Enqueue failed, pTxn=0x%x, HwAddr=0x%x, Len0=%d\n", pTxn, pTxn->uHwAddr, pTxn->aLen[0]);
-        }
-        context_LeaveCriticalSection (pTxnQ->hContext);
+        txnQ_AggregTxnsDone (pTxnQ, NULL, TI_FALSE);
     }
 
     /* Indicate that no transaction is currently processed in the bus-driver */
@@ -640,8 +666,9 @@ static ETxnStatus txnQ_Scheduler (TTxnQObj *pTxnQ, TTxnStruct *pInputTxn)
     {
         TTxnStruct   *pSelectedTxn;
         ETxnStatus    eStatus;
+        TI_UINT32     i;
 
-        /* Get next enabled transaction by priority. If none, exit loop. */
+        /* Get next enabled transaction by priority, and the ones to send with it. If none, exit loop. */
         context_EnterCriticalSection (pTxnQ->hContext);
         pSelectedTxn = txnQ_SelectTxn (pTxnQ);
         context_LeaveCriticalSection (pTxnQ->hContext);
@@ -650,37 +677,35 @@ static ETxnStatus txnQ_Scheduler (TTxnQObj *pTxnQ, TTxnStruct *pInputTxn)
             break;
         }
 
+        /* If aggregated, the bus driver only buffers the Txns before the last one */
+        for (i = 0; i < pTxnQ->uAggregTxnsNum - 1; i++)
+        {
+            busDrv_Transact (pTxnQ->hBusDrv, pTxnQ->aAggregTxns[i]);
+        }
+        pSelectedTxn = pTxnQ->aAggregTxns[i];
+
+#ifdef TI_DBG
+        pTxnQ->uDbgBusTxns++;
+        pTxnQ->uDbgAggregTxns += i;
+#endif
+
         /* Save transaction in case it will be async (to indicate that the bus driver is busy) */
         pTxnQ->pCurrTxn = pSelectedTxn;
 
         /* Send selected transaction to bus driver */
         eStatus = busDrv_Transact (pTxnQ->hBusDrv, pSelectedTxn);
 
-        /* If we've just sent the input transaction, use the status as the return value */
-        if (pSelectedTxn == pInputTxn)
-        {
-            eInputTxnStatus = eStatus;
-        }
-
-        TRACE3(pTxnQ->hReport, REPORT_SEVERITY_INFORMATION, "txnQ_Scheduler(): Txn 0x%x sent, status = %d, eInputTxnStatus = %d\n", pSelectedTxn, eStatus, eInputTxnStatus);
+        TRACE4(pTxnQ->hReport, REPORT_SEVERITY_INFORMATION, "txnQ_Scheduler(): Txn 0x%x sent, status = %d, eInputTxnStatus = %d, Aggregated = %d\n", pSelectedTxn, eStatus, eInputTxnStatus, i);
 
         /* If transaction completed */
         if (eStatus != TXN_STATUS_PENDING)
         {
             pTxnQ->pCurrTxn = NULL;
 
-            /* If it's not the input transaction, enqueue it in TxnDone queue */
-            if (pSelectedTxn != pInputTxn)
+            /* Enqueue the sent Txns in TxnDone queue, except the input transaction which gets the status */
+            if (txnQ_AggregTxnsDone (pTxnQ, pInputTxn, TI_FALSE))
             {
-                TI_STATUS eStatus;
-
-                context_EnterCriticalSection (pTxnQ->hContext);
-                eStatus = que_Enqueue (pTxnQ->hTxnDoneQueue, (TI_HANDLE)pSelectedTxn);
-                if (eStatus != TI_OK)
-                {
-                    TRACE3(pTxnQ->hReport, REPORT_SEVERITY_ERROR, "txnQ_Scheduler(): Enqueue failed, pTxn=0x%x, HwAddr=0x%x, Len0=%d\n", pSelectedTxn, pSelectedTxn->uHwAddr, pSelectedTxn->aLen[0]);
-                }
-                context_LeaveCriticalSection (pTxnQ->hContext);
+                eInputTxnStatus = eStatus;
             }
         }
 
@@ -725,27 +750,31 @@ static ETxnStatus txnQ_Scheduler (TTxnQObj *pTxnQ, TTxnStruct *pInputTxn)
  * \brief  Select transaction to send
  * 
  * Called from txnQ_RunScheduler() which is protected in critical section.
- * Select the next enabled transaction by priority.
+ * Select the next enabled transaction by priority, and the transactions to send with it.
+ * The queue is found by the lowest bit of the ready queues bitmap masked by the running 
+ *     queues bitmap, so empty or stopped queues are not visited.
  * 
  * \note   
  * \param  pTxnQ - The module's object
- * \return The selected transaction to send (NULL if none available)
- * \sa     
+ * \return The selected transaction to send (NULL if none available).
+ *         All transactions to send are in aAggregTxns, the selected one first.
+ * \sa     txnQ_AggregateTxns
  */ 
 static TTxnStruct *txnQ_SelectTxn (TTxnQObj *pTxnQ)
 {
     TTxnStruct *pSelectedTxn;
-    TI_UINT32   uFunc;
-    TI_UINT32   uPrio;
+    TI_UINT32   uMap;
+    TI_UINT32   uIdx;
+
+    pTxnQ->uAggregTxnsNum = 0;
 
-#ifdef TI_DBG
     /* If within Tx aggregation, dequeue Txn from same queue, and if not NULL return it */
-    if (pTxnQ->pAggregQueue)
+    if (pTxnQ->uAggregQueIdx != NO_AGGREG_QUE)
     {
-        pSelectedTxn = (TTxnStruct *) que_Dequeue (pTxnQ->pAggregQueue);
+        pSelectedTxn = txnQ_DequeueTxn (pTxnQ, pTxnQ->uAggregQueIdx);
         if (pSelectedTxn != NULL)
         {
-            /* If aggregation ended, reset the aggregation-queue pointer */
+            /* If aggregation ended, reset the aggregation-queue index */
             if (TXN_PARAM_GET_AGGREGATE(pSelectedTxn) == TXN_AGGREGATE_OFF) 
             {
                 if ((TXN_PARAM_GET_FIXED_ADDR(pSelectedTxn) != TXN_FIXED_ADDR) ||
@@ -753,54 +782,240 @@ static TTxnStruct *txnQ_SelectTxn (TTxnQObj *pTxnQ)
                 {
                     TRACE2(pTxnQ->hReport, REPORT_SEVERITY_ERROR, "txnQ_SelectTxn: Mixed transaction during aggregation, HwAddr=0x%x, TxnParams=0x%x\n", pSelectedTxn->uHwAddr, pSelectedTxn->uTxnParams);
                 }
-                pTxnQ->pAggregQueue = NULL;
+                pTxnQ->uAggregQueIdx = NO_AGGREG_QUE;
             }
+            pTxnQ->aAggregTxns[pTxnQ->uAggregTxnsNum++] = pSelectedTxn;
             return pSelectedTxn;
         }
         return NULL;
     }
-#endif
 
-    /* For all functions, if single-step Txn waiting, return it (sent even if function is stopped) */
-    for (uFunc = pTxnQ->uMinFuncId; uFunc <= pTxnQ->uMaxFuncId; uFunc++)
+    /* If single-step Txn waiting, return it (sent even if function is stopped) */
+    uMap = pTxnQ->uSingleStepMap;
+    if (uMap != 0)
     {
-        pSelectedTxn = pTxnQ->aFuncInfo[uFunc].pSingleStep;
-        if (pSelectedTxn != NULL)
+        for (uIdx = 0; (uMap & (1 << uIdx)) == 0; uIdx++);
+
+        pSelectedTxn = pTxnQ->aFuncInfo[uIdx].pSingleStep;
+        pTxnQ->aFuncInfo[uIdx].pSingleStep = NULL;
+        pTxnQ->uSingleStepMap &= ~(1 << uIdx);
+        pTxnQ->aAggregTxns[pTxnQ->uAggregTxnsNum++] = pSelectedTxn;
+        return pSelectedTxn;
+    }
+
+    /* Find the first queue by priority from high to low and then by function, if none return NULL */
+    uMap = pTxnQ->uReadyQueMap & pTxnQ->uRunningQueMap;
+    if (uMap == 0)
+    {
+        return NULL;
+    }
+    for (uIdx = 0; (uMap & (1 << uIdx)) == 0; uIdx++);
+
+    pSelectedTxn = txnQ_DequeueTxn (pTxnQ, uIdx);
+
+    /* If Tx aggregation begins, save the aggregation-queue index to ensure continuity */
+    if (TXN_PARAM_GET_AGGREGATE(pSelectedTxn) == TXN_AGGREGATE_ON) 
+    {
+        pTxnQ->uAggregQueIdx = uIdx;
+        pTxnQ->aAggregTxns[pTxnQ->uAggregTxnsNum++] = pSelectedTxn;
+        return pSelectedTxn;
+    }
+
+    /* Add the following Txns of this queue that can be sent with it (if configured) */
+    txnQ_AggregateTxns (pTxnQ, pSelectedTxn, uIdx);
+
+    return pSelectedTxn;
+}
+
+
+/** 
+ * \fn     txnQ_DequeueTxn
+ * \brief  Dequeue a transaction
+ * 
+ * Dequeue the next Txn of the given queue, and clear the queue ready bit if it is now empty.
+ * 
+ * \note   Called in critical section.
+ * \param  pTxnQ   - The module's object
+ * \param  uQueIdx - The queue index (see TXN_QUE_IDX)
+ * \return The dequeued transaction (NULL if the queue is empty)
+ * \sa     
+ */ 
+static TTxnStruct *txnQ_DequeueTxn (TTxnQObj *pTxnQ, TI_UINT32 uQueIdx)
+{
+    TI_HANDLE   hQueue = pTxnQ->aTxnQueues[TXN_QUE_FUNC(uQueIdx)][TXN_QUE_PRIO(uQueIdx)];
+    TTxnStruct *pTxn   = (TTxnStruct *) que_Dequeue (hQueue);
+
+    if (que_Size (hQueue) == 0)
+    {
+        pTxnQ->uReadyQueMap &= ~(1 << uQueIdx);
+    }
+    return pTxn;
+}
+
+
+/** 
+ * \fn     txnQ_AggregateTxns
+ * \brief  Select the transactions to send with the selected one
+ * 
+ * Called from txnQ_SelectTxn() which is protected in critical section.
+ * Dequeue the following Txns of the same queue as long as each continues the previous one
+ *     on the bus: same direction and address mode, and the same address (fixed) or the 
+ *     address following it (incremented).
+ * Stop at the configured Txns number or length (bounded by the bus driver DMA buffer).
+ * All Txns but the last are marked for aggregation, so the bus driver only buffers them
+ *     and sends them all in one bus transaction with the last.
+ * 
+ * \note   
+ * \param  pTxnQ     - The module's object
+ * \param  pFirstTxn - The selected transaction
+ * \param  uQueIdx   - The selected transaction queue index
+ * \return void
+ * \sa     txnQ_SelectTxn, txnQ_AggregTxnsDone
+ */ 
+static void txnQ_AggregateTxns (TTxnQObj *pTxnQ, TTxnStruct *pFirstTxn, TI_UINT32 uQueIdx)
+{
+    TI_HANDLE   hQueue     = pTxnQ->aTxnQueues[TXN_QUE_FUNC(uQueIdx)][TXN_QUE_PRIO(uQueIdx)];
+    TI_UINT32   uDirection = TXN_PARAM_GET_DIRECTION(pFirstTxn);
+    TI_UINT32   uFixedAddr = TXN_PARAM_GET_FIXED_ADDR(pFirstTxn);
+    TI_UINT32   uMaxLen    = pTxnQ->aAggregMaxLen[uDirection];
+    TI_UINT32   uTotalLen  = 0;
+    TI_UINT32   uNextHwAddr = 0;
+    TTxnStruct *pTxn       = pFirstTxn;
+
+    while (1)
+    {
+        TI_UINT32 uLen = 0;
+        TI_UINT32 uBufNum;
+
+        for (uBufNum = 0; uBufNum < MAX_XFER_BUFS && pTxn->aLen[uBufNum] != 0; uBufNum++)
         {
-            pTxnQ->aFuncInfo[uFunc].pSingleStep = NULL;
-            return pSelectedTxn;
+            uLen += pTxn->aLen[uBufNum];
+        }
+
+        if (pTxn != pFirstTxn)
+        {
+            /* If the Txn doesn't continue the previous one or doesn't fit, return it to the queue and exit */
+            if ((TXN_PARAM_GET_AGGREGATE(pTxn)  != TXN_AGGREGATE_OFF) ||
+                (TXN_PARAM_GET_DIRECTION(pTxn)  != uDirection)        ||
+                (TXN_PARAM_GET_FIXED_ADDR(pTxn) != uFixedAddr)        ||
+                (pTxn->uHwAddr != uNextHwAddr)                        ||
+                (uTotalLen + uLen > uMaxLen))
+            {
+                que_Requeue (hQueue, (TI_HANDLE)pTxn);
+                pTxnQ->uReadyQueMap |= 1 << uQueIdx;
+                break;
+            }
+
+            /* Mark the previous Txn for aggregation */
+            TXN_PARAM_SET_AGGREGATE(pTxnQ->aAggregTxns[pTxnQ->uAggregTxnsNum - 1], TXN_AGGREGATE_ON);
+        }
+
+        pTxnQ->aAggregTxns[pTxnQ->uAggregTxnsNum++] = pTxn;
+        uTotalLen  += uLen;
+        uNextHwAddr = (uFixedAddr == TXN_FIXED_ADDR) ? pTxn->uHwAddr : pTxn->uHwAddr + uLen;
+
+        /* If reached the limits or no more Txns, exit */
+        if ((pTxnQ->uAggregTxnsNum >= pTxnQ->uAggregMaxTxns) || (uTotalLen >= uMaxLen))
+        {
+            break;
+        }
+        pTxn = txnQ_DequeueTxn (pTxnQ, uQueIdx);
+        if (pTxn == NULL)
+        {
+            break;
         }
     }
 
-    /* For all priorities from high to low */
-    for (uPrio = 0; uPrio < MAX_PRIORITY; uPrio++)
+    TRACE3(pTxnQ->hReport, REPORT_SEVERITY_INFORMATION, "txnQ_AggregateTxns: TxnsNum=%d, TotalLen=%d, HwAddr=0x%x\n", pTxnQ->uAggregTxnsNum, uTotalLen, pFirstTxn->uHwAddr);
+}
+
+
+/** 
+ * \fn     txnQ_AggregTxnsDone
+ * \brief  Complete the sent transactions
+ * 
+ * Called when the last of the sent Txns is done.
+ * The Txns sent with it get its status and their aggregation mark is cleared.
+ * All are enqueued in the TxnDone queue, except the input Txn whose status is returned 
+ *     directly by the caller, or they are all dropped on restart.
+ * 
+ * \note   
+ * \param  pTxnQ     - The module's object
+ * \param  pInputTxn - The transaction inserted in the current context (NULL if none)
+ * \param  bDrop     - If TRUE (restart), don't enqueue the Txns (the last one is reported by the caller)
+ * \return TRUE if the input transaction was sent
+ * \sa     txnQ_AggregateTxns
+ */ 
+static TI_BOOL txnQ_AggregTxnsDone (TTxnQObj *pTxnQ, TTxnStruct *pInputTxn, TI_BOOL bDrop)
+{
+    TTxnStruct *pLastTxn = pTxnQ->aAggregTxns[pTxnQ->uAggregTxnsNum - 1];
+    TI_BOOL     bInputTxnSent = TI_FALSE;
+    TI_UINT32   i;
+
+    context_EnterCriticalSection (pTxnQ->hContext);
+
+    for (i = 0; i < pTxnQ->uAggregTxnsNum; i++)
     {
-        /* For all functions */
-        for (uFunc = pTxnQ->uMinFuncId; uFunc <= pTxnQ->uMaxFuncId; uFunc++)
+        TTxnStruct *pTxn = pTxnQ->aAggregTxns[i];
+
+        if (pTxn != pLastTxn)
         {
-            /* If function running and uses this priority */
-            if (pTxnQ->aFuncInfo[uFunc].eState == FUNC_STATE_RUNNING  &&
-                pTxnQ->aFuncInfo[uFunc].uNumPrios > uPrio)
+            TXN_PARAM_SET_AGGREGATE(pTxn, TXN_AGGREGATE_OFF);
+            TXN_PARAM_SET_STATUS(pTxn, TXN_PARAM_GET_STATUS(pLastTxn));
+        }
+
+        if (pTxn == pInputTxn)
+        {
+            bInputTxnSent = TI_TRUE;
+        }
+        /* If it's not the input transaction, enqueue it in TxnDone queue */
+        else if (!bDrop)
+        {
+            if (que_Enqueue (pTxnQ->hTxnDoneQueue, (TI_HANDLE)pTxn) != TI_OK)
             {
-                /* Dequeue Txn from current func and priority queue, and if not NULL return it */
-                pSelectedTxn = (TTxnStruct *) que_Dequeue (pTxnQ->aTxnQueues[uFunc][uPrio]);
-                if (pSelectedTxn != NULL)
-                {
-#ifdef TI_DBG
-                    /* If aggregation begins, save the aggregation-queue pointer to ensure continuity */
-                    if (TXN_PARAM_GET_AGGREGATE(pSelectedTxn) == TXN_AGGREGATE_ON) 
-                    {
-                        pTxnQ->pAggregQueue = pTxnQ->aTxnQueues[uFunc][uPrio];
-                    }
-#endif
-                    return pSelectedTxn;
-                }
+                TRACE3(pTxnQ->hReport, REPORT_SEVERITY_ERROR, "txnQ_AggregTxnsDone(): Enqueue failed, pTxn=0x%x, HwAddr=0x%x, Len0=%d\n", pTxn, pTxn->uHwAddr, pTxn->aLen[0]);
             }
         }
     }
 
-    /* If no transaction was selected, return NULL */
-    return NULL;
+    pTxnQ->uAggregTxnsNum = 0;
+
+    context_LeaveCriticalSection (pTxnQ->hContext);
+
+    return bInputTxnSent;
+}
+
+
+/** 
+ * \fn     txnQ_SetFuncState
+ * \brief  Set function state
+ * 
+ * Set the function state and update its queues bits in the running queues bitmap.
+ * 
+ * \note   
+ * \param  pTxnQ   - The module's object
+ * \param  uFuncId - The functional driver
+ * \param  eState  - The new state
+ * \return void
+ * \sa     txnQ_SelectTxn
+ */ 
+static void txnQ_SetFuncState (TTxnQObj *pTxnQ, TI_UINT32 uFuncId, EFuncState eState)
+{
+    TI_UINT32 uPrio;
+
+    pTxnQ->aFuncInfo[uFuncId].eState = eState;
+
+    for (uPrio = 0; uPrio < MAX_PRIORITY; uPrio++)
+    {
+        if ((eState == FUNC_STATE_RUNNING) && (uPrio < pTxnQ->aFuncInfo[uFuncId].uNumPrios))
+        {
+            pTxnQ->uRunningQueMap |= 1 << TXN_QUE_IDX(uFuncId, uPrio);
+        }
+        else
+        {
+            pTxnQ->uRunningQueMap &= ~(1 << TXN_QUE_IDX(uFuncId, uPrio));
+        }
+    }
 }
 
 
@@ -825,14 +1040,21 @@ void txnQ_ClearQueues (TI_HANDLE hTxnQ, TI_UINT32 uFuncId)
     context_EnterCriticalSection (pTxnQ->hContext);
 
     pTxnQ->aFuncInfo[uFuncId].pSingleStep = NULL;
+    pTxnQ->uSingleStepMap &= ~(1 << uFuncId);
 
     /* For all function priorities */
     for (uPrio = 0; uPrio < pTxnQ->aFuncInfo[uFuncId].uNumPrios; uPrio++)
     {
+        /* A Tx aggregation in progress on a cleared queue is ended */
+        if (pTxnQ->uAggregQueIdx == TXN_QUE_IDX(uFuncId, uPrio))
+        {
+            pTxnQ->uAggregQueIdx = NO_AGGREG_QUE;
+        }
+
         do
         {
             /* Dequeue Txn from current priority queue */
-            pTxn = (TTxnStruct *) que_Dequeue (pTxnQ->aTxnQueues[uFuncId][uPrio]);
+            pTxn = txnQ_DequeueTxn (pTxnQ, TXN_QUE_IDX(uFuncId, uPrio));
 
             /* 
              * Drop on Restart 
@@ -842,7 +1064,7 @@ void txnQ_ClearQueues (TI_HANDLE hTxnQ, TI_UINT32 uFuncId)
     }
 
     /* Clear state - for restart (doesn't call txnQ_Open) */
-    pTxnQ->aFuncInfo[uFuncId].eState = FUNC_STATE_RUNNING;
+    txnQ_SetFuncState (pTxnQ, uFuncId, FUNC_STATE_RUNNING);
 
     context_LeaveCriticalSection (pTxnQ->hContext);
 }
@@ -856,5 +1078,8 @@ void txnQ_PrintQueues (TI_HANDLE hTxnQ)
     WLAN_OS_REPORT(("================\n"));
     que_Print(pTxnQ->aTxnQueues[TXN_FUNC_ID_WLAN][TXN_LOW_PRIORITY]);
     que_Print(pTxnQ->aTxnQueues[TXN_FUNC_ID_WLAN][TXN_HIGH_PRIORITY]);
+    WLAN_OS_REPORT(("Bus Txns = %d, Aggregated Txns = %d (max %d Txns, %d/%d bytes read/write)\n", 
+                    pTxnQ->uDbgBusTxns, pTxnQ->uDbgAggregTxns, pTxnQ->uAggregMaxTxns,
+                    pTxnQ->aAggregMaxLen[TXN_DIRECTION_READ], pTxnQ->aAggregMaxLen[TXN_DIRECTION_WRITE]));
 }
 #endif /* TI_DBG */
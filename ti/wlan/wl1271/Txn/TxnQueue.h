@@ -137,6 +137,22 @@ TI_STATUS   txnQ_ConnectBus (TI_HANDLE hTxnQ,
  * \sa
  */ 
 TI_STATUS   txnQ_DisconnectBus (TI_HANDLE hTxnQ);
+/** \brief	Configure transactions aggregation
+ * 
+ * \param  hTxnQ    - The module's object
+ * \param  uMaxLen  - Max bytes in one bus transaction (bounded by the bus driver DMA buffers)
+ * \param  uMaxTxns - Max queued transactions combined in one bus transaction (1 = no aggregation)
+ * \return void
+ * 
+ * \par Description
+ * Called by DrvMain upon init.
+ * Adjacent queued transactions of a function queue (same direction, continuous addresses) 
+ * are combined by the bus driver and sent in one bus transaction, up to these limits.
+ * A bus driver that doesn't support aggregation reports no DMA buffers, which disables it.
+ * 
+ * \sa
+ */ 
+void        txnQ_SetAggregParams (TI_HANDLE hTxnQ, TI_UINT32 uMaxLen, TI_UINT32 uMaxTxns);
 /** \brief	Register functional driver to TxnQ
  * 
  * \param  hTxnQ           - The module's object
@@ -746,6 +746,8 @@ NDIS_STRING STRTxPerChannelPowerCompensation_5G_OFDM =    NDIS_STRING_CONST("TxP
 NDIS_STRING STRWlanDrvThreadPriority = NDIS_STRING_CONST("WlanDrvThreadPriority");
 NDIS_STRING STRBusDrvThreadPriority  = NDIS_STRING_CONST("BusDrvThreadPriority");
 NDIS_STRING STRSdioBlkSizeShift      = NDIS_STRING_CONST("SdioBlkSizeShift");
+NDIS_STRING STRTxnAggregMaxLen       = NDIS_STRING_CONST("TxnAggregMaxLen");
+NDIS_STRING STRTxnAggregMaxTxns      = NDIS_STRING_CONST("TxnAggregMaxTxns");
 
 
 /*-----------------------------------*/
@@ -4115,6 +4117,16 @@ regReadIntegerParameter(pAdapter, &STRSingle_Dual_Band_Solution,
                              sizeof p->tDrvMainParams.uSdioBlkSizeShift,
                              (TI_UINT8*)&p->tDrvMainParams.uSdioBlkSizeShift);
 
+    regReadIntegerParameter( pAdapter, &STRTxnAggregMaxLen,
+                             TXN_AGGREG_MAX_LEN_DEF, TXN_AGGREG_MAX_LEN_MIN, TXN_AGGREG_MAX_LEN_MAX,
+                             sizeof p->tDrvMainParams.uTxnAggregMaxLen,
+                             (TI_UINT8*)&p->tDrvMainParams.uTxnAggregMaxLen);
+
+    regReadIntegerParameter( pAdapter, &STRTxnAggregMaxTxns,
+                             TXN_AGGREG_MAX_TXNS_DEF, TXN_AGGREG_MAX_TXNS_MIN, TXN_AGGREG_MAX_TXNS_MAX,
+                             sizeof p->tDrvMainParams.uTxnAggregMaxTxns,
+                             (TI_UINT8*)&p->tDrvMainParams.uTxnAggregMaxTxns);
+
 
 
 /*-----------------------------------*/
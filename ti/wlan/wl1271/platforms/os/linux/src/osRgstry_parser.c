@@ -41,26 +41,214 @@
 
 extern void regReadLastDbgState(TWlanDrvIfObjPtr pAdapter);
 
+/*
+ * The ini file keys index: a hash of the file lines "key = value", so each of
+ *   the registry parameters is found without scanning the whole file for it.
+ */
+#define RGSTRY_INDEX_BUCKETS    256     /* a power of 2, about twice the keys of a full ini file */
+#define RGSTRY_INDEX_NONE       0xFFFF
+#define RGSTRY_INDEX_MAX_KEYS   0xFFFE
+
+#define RGSTRY_CHECKSUM_SEED    2166136261U
+
+typedef struct
+{
+    char       *pKey;       /* the key in the ini file */
+    char       *pValue;     /* the value, after the '=' and the blanks following it */
+    TI_UINT16   uKeyLen;
+    TI_UINT16   uNext;      /* the next key in the same bucket */
+} TRgstryKey;
+
+typedef struct
+{
+    TI_UINT32   uSize;                          /* the index allocation size */
+    TI_UINT16   aBuckets[RGSTRY_INDEX_BUCKETS]; /* the first key of each bucket */
+    TRgstryKey  aKeys[1];                       /* the keys, in their ini file order */
+} TRgstryIndex;
+
 static char *init_file      = NULL;
 static int init_file_length = 0;
 static PNDIS_CONFIGURATION_PARAMETER pNdisParm;
+static TRgstryIndex *pKeysIndex = NULL;
+
+static TRgstryIndex *regIndexBuild (TI_HANDLE hOs, char *buf, int length);
+static TI_UINT32 regChecksum (TI_UINT32 uSum, void *pBuf, TI_UINT32 uLen);
+static TI_UINT32 regSnapshotLayout (void);
+static TI_BOOL regSnapshotLoad (TInitTable *InitTable, char **pFileBuf, int *pFileLength);
 
 int osInitTable_IniFile (TI_HANDLE hOs, TInitTable *InitTable, char *file_buf, int file_length)
 {
     TWlanDrvIfObjPtr drv = (TWlanDrvIfObjPtr)hOs;
     static NDIS_CONFIGURATION_PARAMETER vNdisParm;
+    TI_BOOL bLoaded;
+
+    /* A valid snapshot is taken as is, otherwise its ini text is parsed */
+    bLoaded = regSnapshotLoad (InitTable, &file_buf, &file_length);
 
     init_file         = file_buf;
     init_file_length  = file_length;
     pNdisParm = &vNdisParm;
-    
-    regFillInitTable (drv, InitTable);
+
+    if (!bLoaded)
+    {
+        /* If the index can't be allocated, the keys are searched in the file as before */
+        pKeysIndex = regIndexBuild (hOs, file_buf, file_length);
+
+        regFillInitTable (drv, InitTable);
+    }
 #ifdef TI_DBG
     regReadLastDbgState(drv);
 #endif
+
+    if (pKeysIndex)
+    {
+        os_memoryFree (hOs, pKeysIndex, pKeysIndex->uSize);
+        pKeysIndex = NULL;
+    }
     return 0;
 }
 
+/** 
+ * \fn     osInitTable_Snapshot
+ * \brief  Compile an ini file to a registry snapshot
+ * 
+ * Parse the ini file and write the snapshot: a header, the parsed init table, and the ini
+ *   text itself. The snapshot may be given to the driver in place of the ini file.
+ * 
+ * \param  hOs         - The OS adapter object
+ * \param  InitTable   - The init table to parse the ini file to
+ * \param  file_buf    - The ini file text
+ * \param  file_length - The ini file length
+ * \param  snap_buf    - The snapshot buffer
+ * \param  snap_length - The snapshot buffer length
+ * \return The snapshot length, or -1 if the snapshot buffer is too short
+ * \sa     osInitTable_IniFile
+ */ 
+int osInitTable_Snapshot (TI_HANDLE hOs, TInitTable *InitTable, char *file_buf, int file_length,
+                          char *snap_buf, int snap_length)
+{
+    TRgstrySnapshotHdr tHdr;
+    int length = sizeof(tHdr) + sizeof(TInitTable) + file_length;
+
+    if (file_length < 0 || snap_length < length)
+        return -1;
+
+    osInitTable_IniFile (hOs, InitTable, file_buf, file_length);
+
+    tHdr.uMagic    = RGSTRY_SNAPSHOT_MAGIC;
+    tHdr.uVersion  = RGSTRY_SNAPSHOT_VERSION;
+    tHdr.uLayout   = regSnapshotLayout ();
+    tHdr.uTableLen = sizeof(TInitTable);
+    tHdr.uTableSum = regChecksum (RGSTRY_CHECKSUM_SEED, InitTable, sizeof(TInitTable));
+    tHdr.uIniLen   = file_length;
+    tHdr.uIniSum   = regChecksum (RGSTRY_CHECKSUM_SEED, file_buf, file_length);
+
+    memcpy (snap_buf, &tHdr, sizeof(tHdr));
+    memcpy (snap_buf + sizeof(tHdr), InitTable, sizeof(TInitTable));
+    memcpy (snap_buf + sizeof(tHdr) + sizeof(TInitTable), file_buf, file_length);
+
+    return length;
+}
+
+/* FNV-1a, which is enough to detect a corrupted or foreign snapshot */
+static TI_UINT32 regChecksum (TI_UINT32 uSum, void *pBuf, TI_UINT32 uLen)
+{
+    TI_UINT8 *pByte = (TI_UINT8 *)pBuf;
+
+    while (uLen--)
+    {
+        uSum ^= *pByte++;
+        uSum *= 16777619;
+    }
+    return uSum;
+}
+
+/* The init table size and members offsets, which differ between driver builds and ABIs */
+static TI_UINT32 regSnapshotLayout (void)
+{
+    TI_UINT32 aLayout[32];
+    TI_UINT32 i = 0;
+
+    aLayout[i++] = sizeof(TInitTable);
+    aLayout[i++] = offsetof(TInitTable, siteMgrInitParams);
+    aLayout[i++] = offsetof(TInitTable, connInitParams);
+    aLayout[i++] = offsetof(TInitTable, authInitParams);
+    aLayout[i++] = offsetof(TInitTable, assocInitParams);
+    aLayout[i++] = offsetof(TInitTable, txDataInitParams);
+    aLayout[i++] = offsetof(TInitTable, ctrlDataInitParams);
+    aLayout[i++] = offsetof(TInitTable, rsnInitParams);
+    aLayout[i++] = offsetof(TInitTable, regulatoryDomainInitParams);
+    aLayout[i++] = offsetof(TInitTable, measurementInitParams);
+    aLayout[i++] = offsetof(TInitTable, tSmeModifiedInitParams);
+    aLayout[i++] = offsetof(TInitTable, tSmeInitParams);
+    aLayout[i++] = offsetof(TInitTable, SoftGeminiInitParams);
+    aLayout[i++] = offsetof(TInitTable, qosMngrInitParams);
+    aLayout[i++] = offsetof(TInitTable, clsfrParams);
+#ifdef XCC_MODULE_INCLUDED
+    aLayout[i++] = offsetof(TInitTable, XCCMngrParams);
+#endif
+    aLayout[i++] = offsetof(TInitTable, SwitchChannelInitParams);
+    aLayout[i++] = offsetof(TInitTable, healthMonitorInitParams);
+    aLayout[i++] = offsetof(TInitTable, apConnParams);
+    aLayout[i++] = offsetof(TInitTable, PowerMgrInitParams);
+    aLayout[i++] = offsetof(TInitTable, tScanCncnInitParams);
+    aLayout[i++] = offsetof(TInitTable, rxDataInitParams);
+    aLayout[i++] = offsetof(TInitTable, SendINIBufferToUser);
+    aLayout[i++] = offsetof(TInitTable, trafficMonitorMinIntervalPercentage);
+    aLayout[i++] = offsetof(TInitTable, tReport);
+    aLayout[i++] = offsetof(TInitTable, tCurrBssInitParams);
+    aLayout[i++] = offsetof(TInitTable, tContextInitParams);
+    aLayout[i++] = offsetof(TInitTable, tMlmeInitParams);
+    aLayout[i++] = offsetof(TInitTable, tDrvMainParams);
+    aLayout[i++] = offsetof(TInitTable, tRoamScanMngrInitParams);
+
+    return regChecksum (RGSTRY_CHECKSUM_SEED, aLayout, i * sizeof(TI_UINT32));
+}
+
+/* 
+ * Take the init table from a snapshot that matches this driver. If the file is a snapshot
+ *   that doesn't (or is corrupted), point the file to its ini text, to be parsed instead.
+ */
+static TI_BOOL regSnapshotLoad (TInitTable *InitTable, char **pFileBuf, int *pFileLength)
+{
+    TRgstrySnapshotHdr tHdr;
+    char *pTable;
+    char *pIni;
+
+    if (*pFileBuf == NULL || *pFileLength < (int)sizeof(tHdr))
+        return TI_FALSE;
+
+    /* The snapshot follows the other files in the loader data, so it may be unaligned */
+    memcpy (&tHdr, *pFileBuf, sizeof(tHdr));
+    if (tHdr.uMagic != RGSTRY_SNAPSHOT_MAGIC)
+        return TI_FALSE;
+
+    if (tHdr.uTableLen > *pFileLength - sizeof(tHdr) ||
+        tHdr.uIniLen != *pFileLength - sizeof(tHdr) - tHdr.uTableLen)
+    {
+        print_err("osInitTable_IniFile(): truncated registry snapshot, parsing it as an ini file\n");
+        return TI_FALSE;
+    }
+
+    pTable = *pFileBuf + sizeof(tHdr);
+    pIni   = pTable + tHdr.uTableLen;
+    *pFileBuf    = pIni;
+    *pFileLength = tHdr.uIniLen;
+
+    if (tHdr.uVersion != RGSTRY_SNAPSHOT_VERSION ||
+        tHdr.uTableLen != sizeof(TInitTable) ||
+        tHdr.uLayout != regSnapshotLayout () ||
+        tHdr.uTableSum != regChecksum (RGSTRY_CHECKSUM_SEED, pTable, tHdr.uTableLen) ||
+        tHdr.uIniSum != regChecksum (RGSTRY_CHECKSUM_SEED, pIni, tHdr.uIniLen))
+    {
+        print_err("osInitTable_IniFile(): invalid registry snapshot, parsing its ini file\n");
+        return TI_FALSE;
+    }
+
+    memcpy (InitTable, pTable, sizeof(TInitTable));
+    return TI_TRUE;
+}
+
 unsigned long TiDebugFlag;
 
 /* void PRINT( char * type, char *format, ... )*/
@@ -113,11 +301,122 @@ char * ltrim(char *s )
     return s;
 }
 
+/* The hash and compare of the keys ignore the case, as mem_str() */
+static TI_UINT32 regKeyHash (char *key, int len)
+{
+    TI_UINT32 uHash = 0;
+
+    while (len--)
+        uHash = uHash * 31 + tolower(*key++);
+    return uHash & (RGSTRY_INDEX_BUCKETS - 1);
+}
+
+static char *regIndexFind (TRgstryIndex *pIndex, char *name, int len)
+{
+    TI_UINT16 uKey = pIndex->aBuckets[regKeyHash (name, len)];
+    int i;
+
+    for ( ; uKey != RGSTRY_INDEX_NONE; uKey = pIndex->aKeys[uKey].uNext )
+    {
+        TRgstryKey *pKey = &pIndex->aKeys[uKey];
+
+        if( pKey->uKeyLen != len )
+            continue;
+        for( i = 0; i < len && tolower(pKey->pKey[i]) == tolower(name[i]); i++ ) ;
+        if( i == len )
+            return pKey->pValue;
+    }
+    return NULL;
+}
+
+/*
+ * Index the "key = value" lines of the ini file. Lines without a '=' and remarks are
+ *   skipped, and of a key that repeats only the first line is kept, as when searching it.
+ */
+static TRgstryIndex *regIndexBuild (TI_HANDLE hOs, char *buf, int length)
+{
+    TRgstryIndex *pIndex;
+    char *end_buf = buf + length;
+    char *s, *key;
+    TI_UINT32 uLines = 1;
+    TI_UINT32 uSize;
+    TI_UINT16 uNumKeys = 0;
+    TI_UINT32 uBucket;
+    int i;
+
+    if( !buf || length <= 0 )
+        return NULL;
+
+    for( s = buf; s < end_buf; s++ )
+        if( *s == '\n' )
+            uLines++;
+    if( uLines > RGSTRY_INDEX_MAX_KEYS )
+        return NULL;
+
+    uSize = sizeof(TRgstryIndex) + (uLines - 1) * sizeof(TRgstryKey);
+    pIndex = os_memoryAlloc (hOs, uSize);
+    if( !pIndex )
+        return NULL;
+    pIndex->uSize = uSize;
+    for( i = 0; i < RGSTRY_INDEX_BUCKETS; i++ )
+        pIndex->aBuckets[i] = RGSTRY_INDEX_NONE;
+
+    for( s = buf; s < end_buf; s++ )
+    {
+        while( s < end_buf && (*s == ' ' || *s == '\t') ) s++;
+        key = s;
+        while( s < end_buf && *s != ' ' && *s != '\t' && *s != '=' && *s != '#' &&
+               *s != '\r' && *s != '\n' ) s++;
+        i = s - key;
+        while( s < end_buf && (*s == ' ' || *s == '\t') ) s++;
+
+        if( i > 0 && s < end_buf && *s == '=' && !regIndexFind (pIndex, key, i) )
+        {
+            TRgstryKey *pKey = &pIndex->aKeys[uNumKeys];
+
+            for( s++; s < end_buf && (*s == ' ' || *s == '\t'); s++ ) ;
+            pKey->pKey    = key;
+            pKey->uKeyLen = (TI_UINT16)i;
+            pKey->pValue  = s;
+            uBucket = regKeyHash (key, i);
+            pKey->uNext   = pIndex->aBuckets[uBucket];
+            pIndex->aBuckets[uBucket] = uNumKeys++;
+        }
+
+        /* Skip the rest of the line */
+        while( s < end_buf && *s != '\n' ) s++;
+    }
+
+    return pIndex;
+}
+
+/* Search the key in the ini file, without the index */
+static char *regScanFind (char *name)
+{
+    char *s, *buf = init_file, *end_buf = init_file + init_file_length;
+
+    while(buf < end_buf)
+    {
+        buf = ltrim(buf);
+        s = mem_str(buf, name, end_buf);
+        if( !s )
+            break;
+
+        buf = ltrim(s + strlen(name));
+        if( *buf == '=' )
+            return ltrim(buf + 1);
+
+        /*print_err("\n...init_config err: delim not found (=): ** %s **\n", buf );*/
+        buf = s + 1; /*strlen(name);*/
+    }
+    return NULL;
+}
+
 void NdisReadConfiguration( OUT PNDIS_STATUS  status, OUT PNDIS_CONFIGURATION_PARAMETER  *param_value,
     IN NDIS_HANDLE  config_handle, IN PNDIS_STRING  keyword, IN NDIS_PARAMETER_TYPE  param_type )
 {
     char *name = keyword->Buffer;
-    char *s, *buf = init_file, *end_buf = init_file + init_file_length;
+    char *s, *buf;
     static int count = 0;
 
     *status = NDIS_STATUS_FAILURE;
@@ -134,75 +433,59 @@ void NdisReadConfiguration( OUT PNDIS_STATUS  status, OUT PNDIS_CONFIGURATION_PA
 
     memset(pNdisParm, 0, sizeof(NDIS_CONFIGURATION_PARAMETER));
 
-    while(buf < end_buf)
+    buf = pKeysIndex ? regIndexFind (pKeysIndex, name, strlen(name)) : regScanFind (name);
+    if( !buf )
+        return ;
+
+    if( param_type == NdisParameterString )
     {
-        buf = ltrim(buf);
-        s = mem_str(buf, name, end_buf);
-        if( !s )
-            break;
+        char *remark = NULL;
 
-        buf = ltrim(s + strlen(name));
-        if( *buf == '=' )
-            buf++;
-        else {
-            /*print_err("\n...init_config err: delim not found (=): ** %s **\n", buf );*/
-            buf = s + 1; /*strlen(name);*/
-            continue;
-        }
-        buf = ltrim(buf);
-        if( param_type == NdisParameterString )
+        s = strchr(buf, '\n');
+        if( !s )
+            s = buf+strlen(buf);
+        
+        remark = memchr(buf, '#', s - buf);        /* skip remarks */
+        if( remark )
         {
-            char *remark = NULL;
-
-            s = strchr(buf, '\n');
-            if( !s )
-                s = buf+strlen(buf);
+            do {        /* remove whitespace  */
+                remark--;
+            } while( *remark == ' ' || *remark == '\t' );    
             
-            remark = memchr(buf, '#', s - buf);        /* skip remarks */
-            if( remark )
-            {
-                do {        /* remove whitespace  */
-                    remark--;
-                } while( *remark == ' ' || *remark == '\t' );    
-                
-                pNdisParm->ParameterData.StringData.Length = remark - buf + 1;
-            }
-            else
-                pNdisParm->ParameterData.StringData.Length = s - buf;
-                   
-            pNdisParm->ParameterData.StringData.Buffer = (TI_UINT8*)&pNdisParm->StringBuffer[0];
-            pNdisParm->ParameterData.StringData.MaximumLength = NDIS_MAX_STRING_LEN;
-            if( !pNdisParm->ParameterData.StringData.Length > NDIS_MAX_STRING_LEN )
-            {
-                *status = NDIS_STATUS_BUFFER_TOO_SHORT;
-                return;
-            }
-            memcpy(pNdisParm->ParameterData.StringData.Buffer, buf, pNdisParm->ParameterData.StringData.Length);
-            print_info("NdisReadConfiguration(): %s = (%d)'%s'\n", name, pNdisParm->ParameterData.StringData.Length, pNdisParm->ParameterData.StringData.Buffer);
+            pNdisParm->ParameterData.StringData.Length = remark - buf + 1;
         }
-        else if( param_type == NdisParameterInteger )
+        else
+            pNdisParm->ParameterData.StringData.Length = s - buf;
+               
+        pNdisParm->ParameterData.StringData.Buffer = (TI_UINT8*)&pNdisParm->StringBuffer[0];
+        pNdisParm->ParameterData.StringData.MaximumLength = NDIS_MAX_STRING_LEN;
+        if( pNdisParm->ParameterData.StringData.Length >= NDIS_MAX_STRING_LEN )
         {
+            *status = NDIS_STATUS_BUFFER_TOO_SHORT;
+            return;
+        }
+        memcpy(pNdisParm->ParameterData.StringData.Buffer, buf, pNdisParm->ParameterData.StringData.Length);
+        print_info("NdisReadConfiguration(): %s = (%d)'%s'\n", name, pNdisParm->ParameterData.StringData.Length, pNdisParm->ParameterData.StringData.Buffer);
+    }
+    else if( param_type == NdisParameterInteger )
+    {
 	    char *end_p;
-            pNdisParm->ParameterData.IntegerData = simple_strtol(buf, &end_p, 0);
-            if (end_p && *end_p && *end_p!=' ' && *end_p!='\n'
+        pNdisParm->ParameterData.IntegerData = simple_strtol(buf, &end_p, 0);
+        if (end_p && *end_p && *end_p!=' ' && *end_p!='\n'
 		&& *end_p!='\r' && *end_p!='\t')
-            {
-                print_err("\n...init_config: invalid int value for <%s> : %s\n", name, buf );
-                return;
-            }
-            /*print_deb(" NdisReadConfiguration(): buf = %p (%.20s)\n", buf, buf );*/
-            print_info("NdisReadConfiguration(): %s = %d\n", name, (TI_INT32) pNdisParm->ParameterData.IntegerData);
-        }
-        else
         {
-            print_err("NdisReadConfiguration(): unknow parameter type %d for %s\n", param_type, name );
+            print_err("\n...init_config: invalid int value for <%s> : %s\n", name, buf );
             return;
         }
-        *status = NDIS_STATUS_SUCCESS;
+        /*print_deb(" NdisReadConfiguration(): buf = %p (%.20s)\n", buf, buf );*/
+        print_info("NdisReadConfiguration(): %s = %d\n", name, (TI_INT32) pNdisParm->ParameterData.IntegerData);
+    }
+    else
+    {
+        print_err("NdisReadConfiguration(): unknow parameter type %d for %s\n", param_type, name );
         return;
-
     }
-    return ;
+    *status = NDIS_STATUS_SUCCESS;
 }
 
 void NdisWriteConfiguration( OUT PNDIS_STATUS  Status, 
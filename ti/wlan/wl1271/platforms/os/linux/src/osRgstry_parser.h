@@ -54,8 +54,29 @@
 
 void regFillInitTable ( TWlanDrvIfObjPtr pAdapter, void* pInitTable);
 
+/*
+ * The registry snapshot: the init table parsed from an ini file, followed by the ini text.
+ * It may be loaded instead of the ini file. A snapshot of another driver build or ABI
+ *   is detected by its layout and checksums, and then its ini text is parsed instead.
+ */
+#define RGSTRY_SNAPSHOT_MAGIC       0x53524954  /* "TIRS" */
+#define RGSTRY_SNAPSHOT_VERSION     1
+
+typedef struct
+{
+    TI_UINT32   uMagic;
+    TI_UINT32   uVersion;
+    TI_UINT32   uLayout;        /* signature of the init table size and members offsets */
+    TI_UINT32   uTableLen;      /* the init table length, following the header */
+    TI_UINT32   uTableSum;      /* the init table checksum */
+    TI_UINT32   uIniLen;        /* the ini text length, following the init table */
+    TI_UINT32   uIniSum;        /* the ini text checksum */
+} TRgstrySnapshotHdr;
+
 extern void osInitTable (TInitTable *InitTable);
 extern  int osInitTable_IniFile (TI_HANDLE hOs, TInitTable *InitTable, char *file_buf, int file_length);
+extern  int osInitTable_Snapshot (TI_HANDLE hOs, TInitTable *InitTable, char *file_buf, int file_length,
+                                  char *snap_buf, int snap_length);
 
 
 #endif /* _OS_RGSTRY_PARSER_ */
@@ -117,8 +117,13 @@
 #define SITE_MGR_RX_LEVEL_TABLE_SIZE_DEF        44
 
 /* due to the fact we use the site table only to connect we need just 2 entries each table */
+/* (may be raised at build time, up to 254 entries each table) */
+#ifndef MAX_SITES_BG_BAND
 #define MAX_SITES_BG_BAND   2
+#endif
+#ifndef MAX_SITES_A_BAND
 #define MAX_SITES_A_BAND    2
+#endif
 #define NUM_OF_SITE_TABLE   2
 
 /* Beacon broadcast options */
@@ -1447,6 +1452,14 @@ IP&Port classification table  */
 #define SDIO_BLK_SIZE_SHIFT_MAX                             16
 #define SDIO_BLK_SIZE_SHIFT_DEF                             9
 
+/* TxnQ aggregation of adjacent queued transactions in one bus transaction (MaxTxns 1 = disabled) */
+#define TXN_AGGREG_MAX_LEN_MIN                              0
+#define TXN_AGGREG_MAX_LEN_MAX                              65535
+#define TXN_AGGREG_MAX_LEN_DEF                              4096
+#define TXN_AGGREG_MAX_TXNS_MIN                             1
+#define TXN_AGGREG_MAX_TXNS_MAX                             16
+#define TXN_AGGREG_MAX_TXNS_DEF                             8
+
 
 /*****************************************************************************
  **         POWER MANAGER MODULE REGISTRY DEFINITIONS                       **
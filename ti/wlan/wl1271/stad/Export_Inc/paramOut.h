@@ -1152,6 +1152,8 @@ typedef struct
     TI_UINT32       uWlanDrvThreadPriority; /* Default setting of the WLAN driver task priority  */
     TI_UINT32       uBusDrvThreadPriority;  /* Default setting of the bus driver thread priority */
     TI_UINT32       uSdioBlkSizeShift;      /* In block-mode:  uBlkSize = (1 << uBlkSizeShift)   */
+    TI_UINT32       uTxnAggregMaxLen;       /* Max bytes of transactions combined in one bus transaction */
+    TI_UINT32       uTxnAggregMaxTxns;      /* Max transactions combined in one bus transaction (1 = none) */
 }TDrvMainParams;
 
 /* This table is forwarded to the driver upon creation by the OS abstraction layer. */
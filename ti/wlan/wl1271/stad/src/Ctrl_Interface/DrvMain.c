@@ -918,6 +918,9 @@ static TI_STATUS drvMain_SetDefaults (TI_HANDLE hDrvMain, TI_UINT8 *pBuf, TI_UIN
     pDrvMain->tBusDrvCfg.tSdioCfg.uBlkSizeShift         = pInitTable->tDrvMainParams.uSdioBlkSizeShift;
     pDrvMain->tBusDrvCfg.tSdioCfg.uBusDrvThreadPriority = pInitTable->tDrvMainParams.uBusDrvThreadPriority;
     os_SetDrvThreadPriority (pDrvMain->tStadHandles.hOs, pInitTable->tDrvMainParams.uWlanDrvThreadPriority);
+    txnQ_SetAggregParams (pDrvMain->tStadHandles.hTxnQ, 
+                          pInitTable->tDrvMainParams.uTxnAggregMaxLen, 
+                          pInitTable->tDrvMainParams.uTxnAggregMaxTxns);
 
     /* Release the init table memory */
     os_memoryFree (pDrvMain->tStadHandles.hOs, pInitTable, sizeof(TInitTable));
@@ -321,6 +321,8 @@ TI_STATUS txDataQ_InsertPacket (TI_HANDLE hTxDataQ, TTxCtrlBlk *pPktCtrlBlk, TI_
     txCtrl_t         *pTxCtrl = (txCtrl_t *)(pTxDataQ->hTxCtrl);
     TI_BOOL          bRequestSchedule = TI_FALSE;
     TI_BOOL          bStopNetStack = TI_FALSE;
+    TI_BOOL          bStopPaceTimer = TI_FALSE;
+    TI_BOOL          bStartPaceTimer = TI_FALSE;
 	CL_TRACE_START_L3();
 
     /* If packet is EAPOL or from the generic Ethertype, forward it to the Mgmt-Queue and exit */
@@ -360,17 +362,13 @@ TRACE0(pTxDataQ->hReport, REPORT_SEVERITY_WARNING, "txDataQueue_xmit: No matchin
         /* If the queue has the desired number of packets, request switch to driver context for handling them */
         if (uQueSize == pTxDataQ->aTxSendPaceThresh[uQueId])
         {
-            tmr_StopTimer (pTxDataQ->hTxSendPaceTimer);
+            bStopPaceTimer = TI_TRUE;
             bRequestSchedule = TI_TRUE;
         }
         /* If below Tx-Send pacing threshold, start timer to trigger packets handling if expired */
         else if (uQueSize < pTxDataQ->aTxSendPaceThresh[uQueId]) 
         {
-            tmr_StartTimer (pTxDataQ->hTxSendPaceTimer, 
-                            txDataQ_TxSendPaceTimeout, 
-                            hTxDataQ, 
-                            TX_SEND_PACE_TIMEOUT_MSEC, 
-                            TI_FALSE);
+            bStartPaceTimer = TI_TRUE;
         }
     }
 
@@ -386,6 +384,20 @@ TRACE0(pTxDataQ->hReport, REPORT_SEVERITY_WARNING, "txDataQueue_xmit: No matchin
     /* Leave critical section */
     context_LeaveCriticalSection (pTxDataQ->hContext);
 
+    /* Stop or start the Tx-Send pacing timer (the timer module enters the critical section itself) */
+    if (bStopPaceTimer)
+    {
+        tmr_StopTimer (pTxDataQ->hTxSendPaceTimer);
+    }
+    else if (bStartPaceTimer)
+    {
+        tmr_StartTimer (pTxDataQ->hTxSendPaceTimer, 
+                        txDataQ_TxSendPaceTimeout, 
+                        hTxDataQ, 
+                        TX_SEND_PACE_TIMEOUT_MSEC, 
+                        TI_FALSE);
+    }
+
     /* If needed, schedule Tx handling */
 	if (bRequestSchedule)
     {
@@ -152,8 +152,9 @@ typedef struct
 	Tdot11HtCapabilitiesUnparse *pHtCapabilities;
 	Tdot11HtInformationUnparse	*pHtInformation;
     dot11_TIM_t                 *pTIM;                  /* for beacons only */
-    TI_UINT8                    *pUnknownIe;
-    TI_UINT16                   unknownIeLen;
+    TI_UINT8                    *pIes;                  /* the parsed IEs, in the received frame buffer */
+    TI_UINT16                   iesLen;
+    TI_UINT16                   unknownIeLen;           /* total length of the IEs without a parser */
 } beacon_probeRsp_t; 
 
 
@@ -211,7 +212,6 @@ typedef struct
     dot11_RATES_t           extRates;
     dot11_FH_PARAMS_t       fhParams;
     dot11_CF_PARAMS_t       cfParams;
-    dot11_DS_PARAMS_t       dsParams;
     dot11_IBSS_PARAMS_t     ibssParams;
     dot11_COUNTRY_t         country;
     dot11_WME_PARAM_t       WMEParams;
@@ -224,7 +224,6 @@ typedef struct
     dot11_CELL_TP_t         cellTP;
 #endif
     dot11_RSN_t             rsnIe[3];
-    dot11_TIM_t             tim;
     dot11_QOS_CAPABILITY_IE_t   QosCapParams;
 	Tdot11HtCapabilitiesUnparse tHtCapabilities;
 	Tdot11HtInformationUnparse	tHtInformation;
@@ -236,8 +235,6 @@ typedef struct
 
     TI_BOOL                 recvChannelSwitchAnnoncIE;
 
-	TI_UINT8                unknownIe[MAX_BEACON_BODY_LENGTH];
-
     mlmeFrameInfo_t         frame;
 }mlmeIEParsingParams_t;
 
@@ -276,6 +273,8 @@ TI_STATUS mlme_reportAssocStatus(TI_HANDLE hMlme, TI_UINT16 status);
 
 /* MLME parser API */
 
+void mlmeParser_init (void);
+
 TI_STATUS mlmeParser_recv(TI_HANDLE hMlme, void *pBuffer, TRxAttr* pRxAttr);
 
 TI_STATUS mlmeParser_parseIEs(TI_HANDLE hMlme, 
@@ -293,6 +292,8 @@ void mlmeParser_readXCCOui (TI_UINT8 *pData,
 
 mlmeIEParsingParams_t *mlmeParser_getParseIEsBuffer(TI_HANDLE *hMlme);
 
+TI_UINT16 mlmeParser_CopyUnknownIes (TI_HANDLE hOs, beacon_probeRsp_t *pFrame, TI_UINT8 *pBuf, TI_UINT32 uBufLen);
+
 /* Association SM API */
 
 TI_HANDLE assoc_create(TI_HANDLE pOs);
@@ -880,30 +880,6 @@ void mlmeParser_readXCCOui (TI_UINT8 *pData, TI_UINT32 dataLen, TI_UINT32 *pRead
 #endif
 
 
-TI_STATUS mlmeParser_readERP(mlme_t *pMlme, TI_UINT8 *pData, TI_UINT32 dataLen, TI_UINT32 *pReadLen,
-                             TI_BOOL *useProtection, EPreamble *barkerPreambleMode)
-{
-
-    TI_UINT32 erpIElen;
-    TI_UINT16 ctrl;
-
-    erpIElen = *(pData+1);
-    *pReadLen = erpIElen + 2;
-
-    if (dataLen < (TI_UINT32)(erpIElen + 2))
-    {
-        return TI_NOK;
-    }
-
-    COPY_WLAN_WORD(&ctrl , pData + 2);
-
-    *useProtection = (ctrl & 0x2) >>1;
-    *barkerPreambleMode = ((ctrl & 0x4) >>2) ? PREAMBLE_LONG : PREAMBLE_SHORT;
-
-    return TI_OK;
-}
-
-
 TI_STATUS mlmeParser_readRates(mlme_t *pMlme, TI_UINT8 *pData, TI_UINT32 dataLen, TI_UINT32 *pReadLen, dot11_RATES_t *pRates)
 {
     pRates->hdr[0] = *pData;
@@ -927,172 +903,6 @@ TI_STATUS mlmeParser_readRates(mlme_t *pMlme, TI_UINT8 *pData, TI_UINT32 dataLen
 }
 
 
-TI_STATUS mlmeParser_readSsid(mlme_t *pMlme, TI_UINT8 *pData, TI_UINT32 dataLen, TI_UINT32 *pReadLen, dot11_SSID_t *pSsid)
-{
-    pSsid->hdr[0] = *pData;
-    pSsid->hdr[1] = *(pData+1);
-
-    *pReadLen = pSsid->hdr[1] + 2;
-
-    if ((dataLen < 2) || (dataLen < (TI_UINT32)(pSsid->hdr[1] + 2)))
-    {
-        return TI_NOK;
-    }
-
-    if (pSsid->hdr[1] > MAX_SSID_LEN)
-    {
-        return TI_NOK;
-    }
-
-    os_memoryCopy(pMlme->hOs, (void *)pSsid->serviceSetId, pData+2, pSsid->hdr[1]);
-
-    return TI_OK;
-}
-
-
-TI_STATUS mlmeParser_readFhParams(mlme_t *pMlme, TI_UINT8 *pData, TI_UINT32 dataLen, TI_UINT32 *pReadLen, dot11_FH_PARAMS_t *pFhParams)
-{
-    pFhParams->hdr[0] = *pData;
-    pFhParams->hdr[1] = *(pData+1);
-    pData += 2;
-
-    if ((dataLen < 2) || (dataLen < (TI_UINT32)(pFhParams->hdr[1] + 2)))
-    {
-        return TI_NOK;
-    }
-
-    COPY_WLAN_WORD(&pFhParams->dwellTime , pData);
-    pData += 2;
-
-    pFhParams->hopSet = *pData;
-    pFhParams->hopPattern = *(pData+1);
-    pFhParams->hopIndex = *(pData+2);
-
-    *pReadLen = pFhParams->hdr[1] + 2;
-
-    return TI_OK;
-}
-
-
-TI_STATUS mlmeParser_readDsParams(mlme_t *pMlme, TI_UINT8 *pData, TI_UINT32 dataLen, TI_UINT32 *pReadLen, dot11_DS_PARAMS_t *pDsParams)
-{
-    pDsParams->hdr[0] = *pData;
-    pDsParams->hdr[1] = *(pData+1);
-
-    if ((dataLen < 2) || (dataLen < (TI_UINT32)(pDsParams->hdr[1] + 2)))
-    {
-        return TI_NOK;
-    }
-
-    pDsParams->currChannel = *(pData+2);
-
-    *pReadLen = pDsParams->hdr[1] + 2;
-
-    return TI_OK;
-}
-
-
-TI_STATUS mlmeParser_readCfParams(mlme_t *pMlme, TI_UINT8 *pData, TI_UINT32 dataLen, TI_UINT32 *pReadLen, dot11_CF_PARAMS_t *pCfParams)
-{
-    pCfParams->hdr[0] = *pData;
-    pCfParams->hdr[1] = *(pData+1);
-    pData += 2;
-
-    if ((dataLen < 2) || (dataLen < (TI_UINT32)(pCfParams->hdr[1] + 2)))
-    {
-        return TI_NOK;
-    }
-
-    pCfParams->cfpCount = *pData;
-    pCfParams->cfpPeriod = *(pData+1);
-    pData += 2;
-
-    COPY_WLAN_WORD(&pCfParams->cfpMaxDuration, pData);
-    pData += 2;
-
-    COPY_WLAN_WORD(&pCfParams->cfpDurRemain, pData);
-
-    *pReadLen = pCfParams->hdr[1] + 2;
-
-    return TI_OK;
-}
-
-
-TI_STATUS mlmeParser_readIbssParams(mlme_t *pMlme, TI_UINT8 *pData, TI_UINT32 dataLen, TI_UINT32 *pReadLen, dot11_IBSS_PARAMS_t *pIbssParams)
-{
-    pIbssParams->hdr[0] = *pData;
-    pIbssParams->hdr[1] = *(pData+1);
-    pData += 2;
-
-    if ((dataLen < 2) || (dataLen < (TI_UINT32)(pIbssParams->hdr[1] + 2)))
-    {
-        return TI_NOK;
-    }
-
-    COPY_WLAN_WORD(&pIbssParams->atimWindow, pData);
-
-    *pReadLen = pIbssParams->hdr[1] + 2;
-
-    return TI_OK;
-}
-
-
-TI_STATUS mlmeParser_readTim(mlme_t *pMlme, TI_UINT8 *pData, TI_UINT32 dataLen, TI_UINT32 *pReadLen, dot11_TIM_t *pTim)
-{
-    pTim->hdr[0] = *pData;
-    pTim->hdr[1] = *(pData+1);
-
-    if ((dataLen < 2) || (dataLen < (TI_UINT32)(pTim->hdr[1] + 2)) || (pTim->hdr[1] < 3))
-    {
-        return TI_NOK;
-    }
-
-    pTim->dtimCount		= *(pData + 2);
-    pTim->dtimPeriod	= *(pData + 3);
-    pTim->bmapControl	= *(pData + 4);
-
-    os_memoryCopy(pMlme->hOs, (void *)pTim->partialVirtualBmap, pData + 5, pTim->hdr[1] - 3);
-
-    *pReadLen = pTim->hdr[1] + 2;
-
-    return TI_OK;
-}
-
-
-TI_STATUS mlmeParser_readCountry(mlme_t *pMlme,TI_UINT8 *pData, TI_UINT32 dataLen, TI_UINT32 *pReadLen, dot11_COUNTRY_t *countryIE)
-{
-	TI_INT32 i, j;
-
-    countryIE->hdr[0] = *pData;
-    countryIE->hdr[1] = *(pData+1);
-
-    *pReadLen = countryIE->hdr[1] + 2;
-
-    if ((dataLen < 8) || (dataLen < (TI_UINT32)(countryIE->hdr[1] + 2)))
-    {
-        return TI_NOK;
-    }
-
-    if (countryIE->hdr[1] > DOT11_COUNTRY_ELE_LEN_MAX)
-    {
-        TRACE2(pMlme->hReport, REPORT_SEVERITY_ERROR, "MLME_PARSER: country IE error: eleLen=%d, maxLen=%d\n", countryIE->hdr[1], DOT11_COUNTRY_ELE_LEN_MAX);
-        return TI_NOK;
-    }
-
-    os_memoryCopy(pMlme->hOs,&(countryIE->countryIE.CountryString), pData+2, DOT11_COUNTRY_STRING_LEN);
-
-	/* Loop on all tripletChannels. Each item has three fields ('i' counts rows and 'j' counts bytes). */
-	for (i = 0, j = 0;  j < (countryIE->hdr[1] - DOT11_COUNTRY_STRING_LEN);  i++, j+=3)
-	{
-		countryIE->countryIE.tripletChannels[i].firstChannelNumber	= *(pData + j + 5);
-		countryIE->countryIE.tripletChannels[i].numberOfChannels	= *(pData + j + 6);
-		countryIE->countryIE.tripletChannels[i].maxTxPowerLevel		= *(pData + j + 7);
-	}
-
-    return TI_OK;
-}
-
-
 TI_STATUS mlmeParser_readWMEParams(mlme_t *pMlme,TI_UINT8 *pData, TI_UINT32 dataLen, 
 								   TI_UINT32 *pReadLen, dot11_WME_PARAM_t *pWMEParamIE, 
 								   assocRsp_t *assocRsp)
@@ -1139,11 +949,12 @@ TI_STATUS mlmeParser_readWMEParams(mlme_t *pMlme,TI_UINT8 *pData, TI_UINT32 data
 			 *	1) It exists only in the WME-Params IE.
 			 *	2) There is a gap of 2 bytes before the WME_ACParameteres if OS_PACKED is not supported.
 			 */
-			os_memoryCopy(pMlme->hOs,&(pWMEParamIE->OUI), pData+2, 8);
+			os_memoryCopy(pMlme->hOs,&(pWMEParamIE->OUI), pData+2, (pWMEParamIE->hdr[1] < 8) ? pWMEParamIE->hdr[1] : 8);
 		
-			if ( *((TI_UINT8*)(pData+6)) == dot11_WME_OUI_SUB_TYPE_PARAMS_IE )
+			if (( *((TI_UINT8*)(pData+6)) == dot11_WME_OUI_SUB_TYPE_PARAMS_IE ) && (pWMEParamIE->hdr[1] > 8))
 			{
-				os_memoryCopy(pMlme->hOs,&(pWMEParamIE->WME_ACParameteres), pData+10, pWMEParamIE->hdr[1] - 8);
+				os_memoryCopy(pMlme->hOs,&(pWMEParamIE->WME_ACParameteres), pData+10,
+							  (pWMEParamIE->hdr[1] - 8 < sizeof(dot11_ACParameters_t)) ? pWMEParamIE->hdr[1] - 8 : sizeof(dot11_ACParameters_t));
 			}
 
 			break;
@@ -1177,40 +988,6 @@ TRACE1(pMlme->hReport, REPORT_SEVERITY_ERROR, "MLME_PARSER: WME Parameter IE err
 }
 
 
-static TI_UINT32 mlmeParser_getWSCReadLen(TI_UINT8 *pData)
-{
-    return *(pData+1) + 2;
-}
-
-
-static TI_STATUS mlmeParser_readWSCParams(mlme_t *pMlme,TI_UINT8 *pData, TI_UINT32 dataLen, TI_UINT32 *pReadLen, dot11_WSC_t *pWSC_IE)
-{
-	pWSC_IE->hdr[0] = *pData;
-	pWSC_IE->hdr[1] = *(pData+1);
-
-    *pReadLen = pWSC_IE->hdr[1] + 2;
-
-    /* Length Sanity check of the WSC IE */
-	if ((dataLen < 8) || (dataLen < (TI_UINT32)(pWSC_IE->hdr[1] + 2)))
-    {
-        TRACE2(pMlme->hReport, REPORT_SEVERITY_ERROR, "MLME_PARSER: WSC Parameter IE error: dataLen=%d, pWSC_IE->hdr[1]=%d\n", dataLen, pWSC_IE->hdr[1]);
-		return TI_NOK;
-    }
-
-    /* Length Sanity check of the WSC IE */
-	if (pWSC_IE->hdr[1] > ( sizeof(dot11_WSC_t) - sizeof(dot11_eleHdr_t) ))
-    {
-        TRACE2(pMlme->hReport, REPORT_SEVERITY_ERROR, "MLME_PARSER: WSC Parameter IE error: eleLen=%d, maxLen=%d\n", pWSC_IE->hdr[1], ( sizeof(dot11_WSC_t) - sizeof(dot11_eleHdr_t) ));
-        return TI_NOK;
-    }
-    
-	/* Copy the WSC Params IE */
-	os_memoryCopy(pMlme->hOs,&(pWSC_IE->OUI), pData+2, pWSC_IE->hdr[1]);
-
-    return TI_OK;
-}
-
-
 TI_STATUS mlmeParser_readQosCapabilityIE(mlme_t *pMlme,TI_UINT8 *pData, TI_UINT32 dataLen, TI_UINT32 *pReadLen, dot11_QOS_CAPABILITY_IE_t *QosCapParams)
 {
     QosCapParams->hdr[0] = *pData;
@@ -1229,7 +1006,10 @@ TI_STATUS mlmeParser_readQosCapabilityIE(mlme_t *pMlme,TI_UINT8 *pData, TI_UINT3
         return TI_NOK;
     }
 
-   QosCapParams->QosInfoField = (*(pData+1));
+    if (QosCapParams->hdr[1] != 0)
+    {
+        QosCapParams->QosInfoField = *(pData+2);
+    }
     return TI_OK;
 }
 
@@ -1276,7 +1056,7 @@ TI_STATUS mlmeParser_readHtInformationIE(mlme_t *pMlme,TI_UINT8 *pData, TI_UINT3
         return TI_NOK;
     }
 
-    os_memoryCopy(pMlme->hOs, (void*)pHtInformation->aHtInformationIe, pData + 2, pHtInformation->tHdr[1]);
+    os_memoryCopy(pMlme->hOs, (void*)pHtInformation->aHtInformationIe, pData + 2, DOT11_HT_INFORMATION_ELE_LEN);
   
     return TI_OK;
 }
@@ -1328,447 +1108,587 @@ TI_STATUS mlmeParser_readRsnIe(mlme_t *pMlme, TI_UINT8 *pData, TI_UINT32 dataLen
     return TI_OK;
 }
 
-TI_STATUS mlmeParser_readPowerConstraint(mlme_t *pMlme,TI_UINT8 *pData, TI_UINT32 dataLen, TI_UINT32 *pReadLen, dot11_POWER_CONSTRAINT_t *powerConstraintIE)
+TI_STATUS mlmeParser_readChannelSwitch(mlme_t *pMlme,TI_UINT8 *pData, TI_UINT32 dataLen, TI_UINT32 *pReadLen, dot11_CHANNEL_SWITCH_t *channelSwitch, TI_UINT8 channel)
 {
-    powerConstraintIE->hdr[0] = *pData;
-    powerConstraintIE->hdr[1] = *(pData+1);
+    channelSwitch->hdr[0] = *pData++;
+    channelSwitch->hdr[1] = *pData++;
 
-    *pReadLen = powerConstraintIE->hdr[1] + 2;
+    *pReadLen = channelSwitch->hdr[1] + 2;
 
-    if ((dataLen < 2) || (dataLen < (TI_UINT32)(powerConstraintIE->hdr[1] + 2)))
+    if ((dataLen < 2) || (dataLen < (TI_UINT32)(channelSwitch->hdr[1] + 2)))
     {
         return TI_NOK;
     }
 
-    if (powerConstraintIE->hdr[1] > DOT11_POWER_CONSTRAINT_ELE_LEN)
+    if (channelSwitch->hdr[1] != DOT11_CHANNEL_SWITCH_ELE_LEN)
     {
         return TI_NOK;
     }
 
-    os_memoryCopy(pMlme->hOs,(void *)&(powerConstraintIE->powerConstraint), pData+2, powerConstraintIE->hdr[1]);
+    channelSwitch->channelSwitchMode = *pData++;
+    channelSwitch->channelNumber = *pData++;
+    channelSwitch->channelSwitchCount = *pData;
+
+
+	switchChannel_recvCmd(pMlme->hSwitchChannel, channelSwitch, channel);
+	return TI_OK;
+}
+
+/*
+ * Beacon and probe response IEs parsing
+ *
+ * The IEs are parsed in a single pass. Each element ID is looked up in aIeParsers (through
+ * aIeParserIndex), its length is checked against the entry limits and the entry handler is
+ * called with an element that is known to be complete. IEs whose consumers only read what
+ * the element holds are referenced in place in the frame buffer instead of being copied.
+ * Elements without a parser are only counted here, and copied on demand by
+ * mlmeParser_CopyUnknownIes.
+ */
+
+/* An element shorter than uMinLen rejects the frame (by default it is ignored) */
+#define MLME_IE_SHORT_IS_ERROR      0x01
+
+typedef struct
+{
+    mlme_t                  *pMlme;
+    mlmeIEParsingParams_t   *pParams;
+    beacon_probeRsp_t       *pFrame;
+    TI_UINT8                uRsnIeNum;
+} TMlmeIeParseCtx;
+
+/* pIe points to a complete element, with a length within the parser entry limits */
+typedef TI_STATUS (*TMlmeIeParseFunc) (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe);
+
+typedef struct
+{
+    TI_UINT8                uIeId;
+    TI_UINT8                uMinLen;
+    TI_UINT8                uMaxLen;
+    TI_UINT8                uFlags;
+    TMlmeIeParseFunc        fParse;
+} TMlmeIeParser;
+
+
+static TI_STATUS mlmeParser_parseSsidIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
+{
+    dot11_SSID_t *pSsid = &pCtx->pParams->ssid;
+
+    /* copied since the SSID consumers compare the whole serviceSetId */
+    pSsid->hdr[0] = pIe[0];
+    pSsid->hdr[1] = pIe[1];
+    os_memoryCopy (pCtx->pMlme->hOs, (void *)pSsid->serviceSetId, pIe + 2, pIe[1]);
+    pCtx->pFrame->pSsid = pSsid;
 
     return TI_OK;
 }
 
+static TI_STATUS mlmeParser_parseRatesIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
+{
+    pCtx->pFrame->pRates = (dot11_RATES_t *)pIe;
 
-TI_STATUS mlmeParser_readChannelSwitch(mlme_t *pMlme,TI_UINT8 *pData, TI_UINT32 dataLen, TI_UINT32 *pReadLen, dot11_CHANNEL_SWITCH_t *channelSwitch, TI_UINT8 channel)
+    return TI_OK;
+}
+
+static TI_STATUS mlmeParser_parseExtRatesIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
 {
-    channelSwitch->hdr[0] = *pData++;
-    channelSwitch->hdr[1] = *pData++;
+    pCtx->pFrame->pExtRates = (dot11_RATES_t *)pIe;
 
-    *pReadLen = channelSwitch->hdr[1] + 2;
+    return TI_OK;
+}
 
-    if ((dataLen < 2) || (dataLen < (TI_UINT32)(channelSwitch->hdr[1] + 2)))
-    {
-        return TI_NOK;
-    }
+static TI_STATUS mlmeParser_parseErpIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
+{
+    pCtx->pFrame->useProtection = (pIe[2] & 0x2) >> 1;
+    pCtx->pFrame->barkerPreambleMode = ((pIe[2] & 0x4) >> 2) ? PREAMBLE_LONG : PREAMBLE_SHORT;
+
+    return TI_OK;
+}
+
+static TI_STATUS mlmeParser_parseFhParamsIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
+{
+    dot11_FH_PARAMS_t *pFhParams = &pCtx->pParams->fhParams;
+
+    pFhParams->hdr[0] = pIe[0];
+    pFhParams->hdr[1] = pIe[1];
+    COPY_WLAN_WORD(&pFhParams->dwellTime, pIe + 2);
+    pFhParams->hopSet = pIe[4];
+    pFhParams->hopPattern = pIe[5];
+    pFhParams->hopIndex = pIe[6];
+    pCtx->pFrame->pFHParamsSet = pFhParams;
+
+    return TI_OK;
+}
+
+static TI_STATUS mlmeParser_parseDsParamsIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
+{
+    dot11_DS_PARAMS_t *pDsParams = (dot11_DS_PARAMS_t *)pIe;
 
-    if (channelSwitch->hdr[1] > DOT11_CHANNEL_SWITCH_ELE_LEN)
+    if ((RADIO_BAND_2_4_GHZ == pCtx->pParams->band) && (pDsParams->currChannel != pCtx->pParams->rxChannel))
     {
+        TRACE2(pCtx->pMlme->hReport, REPORT_SEVERITY_ERROR, "Channel ERROR - incompatible channel source information: Frame=%d Vs Radio=%d.\nparser ABORTED!!!\n", pDsParams->currChannel , pCtx->pParams->rxChannel);
         return TI_NOK;
     }
+    pCtx->pFrame->pDSParamsSet = pDsParams;
 
-    channelSwitch->channelSwitchMode = *pData++;
-    channelSwitch->channelNumber = *pData++;
-    channelSwitch->channelSwitchCount = *pData;
+    return TI_OK;
+}
 
+static TI_STATUS mlmeParser_parseCfParamsIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
+{
+    dot11_CF_PARAMS_t *pCfParams = &pCtx->pParams->cfParams;
 
-	switchChannel_recvCmd(pMlme->hSwitchChannel, channelSwitch, channel);
-	return TI_OK;
+    pCfParams->hdr[0] = pIe[0];
+    pCfParams->hdr[1] = pIe[1];
+    pCfParams->cfpCount = pIe[2];
+    pCfParams->cfpPeriod = pIe[3];
+    COPY_WLAN_WORD(&pCfParams->cfpMaxDuration, pIe + 4);
+    COPY_WLAN_WORD(&pCfParams->cfpDurRemain, pIe + 6);
+    pCtx->pFrame->pCFParamsSet = pCfParams;
+
+    return TI_OK;
+}
+
+static TI_STATUS mlmeParser_parseIbssParamsIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
+{
+    dot11_IBSS_PARAMS_t *pIbssParams = &pCtx->pParams->ibssParams;
+
+    pIbssParams->hdr[0] = pIe[0];
+    pIbssParams->hdr[1] = pIe[1];
+    COPY_WLAN_WORD(&pIbssParams->atimWindow, pIe + 2);
+    pCtx->pFrame->pIBSSParamsSet = pIbssParams;
+
+    return TI_OK;
 }
 
-TI_STATUS mlmeParser_readQuiet(mlme_t *pMlme,TI_UINT8 *pData, TI_UINT32 dataLen, TI_UINT32 *pReadLen, dot11_QUIET_t *quiet)
+static TI_STATUS mlmeParser_parseTimIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
 {
-    quiet->hdr[0] = *pData++;
-    quiet->hdr[1] = *pData++;
+    pCtx->pFrame->pTIM = (dot11_TIM_t *)pIe;
 
-    *pReadLen = quiet->hdr[1] + 2;
+    return TI_OK;
+}
+
+static TI_STATUS mlmeParser_parseCountryIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
+{
+    dot11_COUNTRY_t *pCountry = &pCtx->pParams->country;
+    TI_UINT32        i, j;
 
-    if ((dataLen < 2) || (dataLen < (TI_UINT32)(quiet->hdr[1] + 2)))
+    /* copied since the regulatory domain keeps the whole country structure */
+    pCountry->hdr[0] = pIe[0];
+    pCountry->hdr[1] = pIe[1];
+    os_memoryCopy (pCtx->pMlme->hOs, &(pCountry->countryIE.CountryString), pIe + 2, DOT11_COUNTRY_STRING_LEN);
+
+    /* Loop on all complete tripletChannels ('i' counts rows and 'j' counts bytes) */
+    for (i = 0, j = DOT11_COUNTRY_STRING_LEN;  j + 3 <= pIe[1];  i++, j += 3)
     {
-        return TI_NOK;
+        pCountry->countryIE.tripletChannels[i].firstChannelNumber = pIe[j + 2];
+        pCountry->countryIE.tripletChannels[i].numberOfChannels   = pIe[j + 3];
+        pCountry->countryIE.tripletChannels[i].maxTxPowerLevel    = pIe[j + 4];
     }
+    pCtx->pFrame->country = pCountry;
+
+    return TI_OK;
+}
+
+static TI_STATUS mlmeParser_parsePowerConstraintIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
+{
+    dot11_POWER_CONSTRAINT_t *pPowerConstraint = &pCtx->pParams->powerConstraint;
 
-    if (quiet->hdr[1] > DOT11_QUIET_ELE_LEN)
+    pPowerConstraint->hdr[0] = pIe[0];
+    pPowerConstraint->hdr[1] = pIe[1];
+    if (pIe[1] != 0)
     {
-        return TI_NOK;
+        pPowerConstraint->powerConstraint = pIe[2];
     }
+    pCtx->pFrame->powerConstraint = pPowerConstraint;
 
-    quiet->quietCount = *pData++;
-    quiet->quietPeriod = *pData++;
-    quiet->quietDuration = *((TI_UINT16*)pData);
-    pData += sizeof(TI_UINT16);
-    quiet->quietOffset = *((TI_UINT16*)pData);
+    return TI_OK;
+}
 
-	return TI_OK;
+static TI_STATUS mlmeParser_parseChannelSwitchIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
+{
+    TI_UINT32 uReadLen;
+
+    pCtx->pFrame->channelSwitch = &pCtx->pParams->channelSwitch;
+
+    /* Ignore Switch Channel commands from non my BSSID */
+    if (pCtx->pParams->myBssid)
+    {
+        pCtx->pParams->recvChannelSwitchAnnoncIE = TI_TRUE;
+        if (mlmeParser_readChannelSwitch (pCtx->pMlme, pIe, pIe[1] + 2, &uReadLen, pCtx->pFrame->channelSwitch, pCtx->pParams->rxChannel) != TI_OK)
+        {
+            /*
+             * PATCH for working with AP-DK 4.0.51 that use IE 37 (with length 20) for RSNE
+             * Ignore the IE instead of rejecting the whole BUF (beacon or probe response)
+             */
+            TRACE0(pCtx->pMlme->hReport, REPORT_SEVERITY_WARNING, "MLME_PARSER: error reading Channel Switch announcement parameters - ignore IE\n");
+        }
+    }
+
+    return TI_OK;
 }
 
+static TI_STATUS mlmeParser_parseQuietIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
+{
+    dot11_QUIET_t *pQuiet = &pCtx->pParams->quiet;
+
+    pQuiet->hdr[0] = pIe[0];
+    pQuiet->hdr[1] = pIe[1];
+    pQuiet->quietCount = pIe[2];
+    pQuiet->quietPeriod = pIe[3];
+    COPY_WLAN_WORD(&pQuiet->quietDuration, pIe + 4);
+    COPY_WLAN_WORD(&pQuiet->quietOffset, pIe + 6);
+    pCtx->pFrame->quiet = pQuiet;
 
-TI_STATUS mlmeParser_readTPCReport(mlme_t *pMlme,TI_UINT8 *pData, TI_UINT32 dataLen, TI_UINT32 *pReadLen, dot11_TPC_REPORT_t *TPCReport)
+    return TI_OK;
+}
+
+static TI_STATUS mlmeParser_parseTpcReportIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
 {
-    TPCReport->hdr[0] = *pData;
-    TPCReport->hdr[1] = *(pData+1);
+    dot11_TPC_REPORT_t *pTpcReport = &pCtx->pParams->TPCReport;
 
-    *pReadLen = TPCReport->hdr[1] + 2;
+    pTpcReport->hdr[0] = pIe[0];
+    pTpcReport->hdr[1] = pIe[1];
+    pTpcReport->transmitPower = pIe[2];
+    pCtx->pFrame->TPCReport = pTpcReport;
 
-    if ((dataLen < 2) || (dataLen < (TI_UINT32)(TPCReport->hdr[1] + 2)))
+    return TI_OK;
+}
+
+/* RSN, XCC extension and WPA IEs are gathered one after the other (up to MAX_RSN_IE) */
+static TI_STATUS mlmeParser_parseRsnIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
+{
+    TI_UINT32 uReadLen;
+
+    if (pCtx->uRsnIeNum >= MAX_RSN_IE)
     {
-        return TI_NOK;
+        TRACE1(pCtx->pMlme->hReport, REPORT_SEVERITY_WARNING, "MLME_PARSER: more than %d RSN IEs - IE ignored\n", MAX_RSN_IE);
+        return TI_OK;
     }
 
-    if (TPCReport->hdr[1] > DOT11_TPC_REPORT_ELE_LEN)
+    if (mlmeParser_readRsnIe (pCtx->pMlme, pIe, pIe[1] + 2, &uReadLen, &pCtx->pParams->rsnIe[pCtx->uRsnIeNum]) != TI_OK)
     {
+        TRACE0(pCtx->pMlme->hReport, REPORT_SEVERITY_ERROR, "MLME_PARSER: error reading RSN IE\n");
         return TI_NOK;
     }
+    pCtx->pFrame->pRsnIe = &pCtx->pParams->rsnIe[0];
+    pCtx->pFrame->rsnIeLen += uReadLen;
+    pCtx->uRsnIeNum++;
+
+    return TI_OK;
+}
 
-    TPCReport->transmitPower = *(pData+2);
+static TI_STATUS mlmeParser_parseQosCapabilityIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
+{
+    dot11_QOS_CAPABILITY_IE_t *pQosCap = &pCtx->pParams->QosCapParams;
+
+    pQosCap->hdr[0] = pIe[0];
+    pQosCap->hdr[1] = pIe[1];
+    if (pIe[1] != 0)
+    {
+        pQosCap->QosInfoField = pIe[2];
+    }
+    pCtx->pFrame->QoSCapParameters = pQosCap;
 
     return TI_OK;
 }
 
+static TI_STATUS mlmeParser_parseHtCapabilitiesIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
+{
+    pCtx->pFrame->pHtCapabilities = (Tdot11HtCapabilitiesUnparse *)pIe;
 
-#ifdef XCC_MODULE_INCLUDED
-TI_STATUS mlmeParser_readCellTP(mlme_t *pMlme, TI_UINT8 *pData, TI_UINT32 dataLen, TI_UINT32 *pReadLen, dot11_CELL_TP_t *cellTP)
+    return TI_OK;
+}
+
+static TI_STATUS mlmeParser_parseHtInformationIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
 {
-    TI_UINT8 XCC_OUI[] = XCC_OUI;
+    pCtx->pFrame->pHtInformation = (Tdot11HtInformationUnparse *)pIe;
 
-    cellTP->hdr[0] = *pData++;
-    cellTP->hdr[1] = *pData++;
+    return TI_OK;
+}
 
-    *pReadLen = cellTP->hdr[1] + 2;
+static TI_STATUS mlmeParser_parseVendorIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
+{
+    mlme_t      *pMlme = pCtx->pMlme;
+    TI_UINT8     wpaIeOui[] = WPA_IE_OUI;
+    TI_UINT32    uReadLen;
 
-    if ((dataLen < 2) || (dataLen < (TI_UINT32)(cellTP->hdr[1] + 2)))
+    /* Note : WSC, WPA and WME use the same OUI, and differ by the OUI type (1, 2 and 4) */
+    if ((pIe[1] < 4) || (os_memoryCompare (pMlme->hOs, pIe + 2, wpaIeOui, 3) != 0))
     {
-        return TI_NOK;
+        return TI_OK;
     }
 
-    if (cellTP->hdr[1] > DOT11_CELL_TP_ELE_LEN)
+    switch (pIe[5])
     {
-        return TI_NOK;
+    case dot11_WPA_OUI_TYPE:
+        return mlmeParser_parseRsnIe (pCtx, pIe);
+
+    case dot11_WME_OUI_TYPE:
+        /* WME-Params IE or WME-Info IE, both are kept in WMEParams (Info is a subset of Params) */
+        if ((pIe[1] >= 5) &&
+            ((pIe[6] == dot11_WME_OUI_SUB_TYPE_PARAMS_IE) || (pIe[6] == dot11_WME_OUI_SUB_TYPE_IE)))
+        {
+            pCtx->pFrame->WMEParams = &pCtx->pParams->WMEParams;
+            if (mlmeParser_readWMEParams (pMlme, pIe, pIe[1] + 2, &uReadLen, pCtx->pFrame->WMEParams, NULL) != TI_OK)
+            {
+                return TI_NOK;
+            }
+        }
+        break;
+
+    case dot11_WSC_OUI_TYPE:
+        /*
+         * This IE is not supposed to be found in beacons according to the standard
+         * definition. However, some APs do add it to beacons. It is read from beacons
+         * according to a registry key (which is false by default).
+         */
+        if ((BEACON != pCtx->pParams->frame.subType) || (TI_TRUE == pMlme->bParseBeaconWSC))
+        {
+            /* copied since the WSC attributes are walked beyond the IE by their consumers */
+            if (pIe[1] > (sizeof(dot11_WSC_t) - sizeof(dot11_eleHdr_t)))
+            {
+                TRACE2(pMlme->hReport, REPORT_SEVERITY_ERROR, "MLME_PARSER: WSC Parameter IE error: eleLen=%d, maxLen=%d\n", pIe[1], (sizeof(dot11_WSC_t) - sizeof(dot11_eleHdr_t)));
+                return TI_NOK;
+            }
+            pCtx->pParams->WSCParams.hdr[0] = pIe[0];
+            pCtx->pParams->WSCParams.hdr[1] = pIe[1];
+            os_memoryCopy (pMlme->hOs, &(pCtx->pParams->WSCParams.OUI), pIe + 2, pIe[1]);
+            pCtx->pFrame->WSCParams = &pCtx->pParams->WSCParams;
+        }
+        break;
+
+    default:
+        /* Unrecognized OUI type */
+        break;
     }
 
-	os_memoryCopy(pMlme->hOs, (void*)cellTP->oui, pData, cellTP->hdr[1]);
+    return TI_OK;
+}
 
-    if (os_memoryCompare(pMlme->hOs, (void*)cellTP->oui, XCC_OUI, 3) != 0)
+#ifdef XCC_MODULE_INCLUDED
+static TI_STATUS mlmeParser_parseCellTpIe (TMlmeIeParseCtx *pCtx, TI_UINT8 *pIe)
+{
+    dot11_CELL_TP_t *pCellTp = &pCtx->pParams->cellTP;
+    TI_UINT8         XCC_oui[] = XCC_OUI;
+
+    /*
+     * We mustn't take the Cell Transmit Power IE into account if there's a Power
+     * Constraint IE. Since the IEs must be in increasing order, the Power Constraint
+     * IE, if present, has already been processed.
+     */
+    if (pCtx->pFrame->powerConstraint != NULL)
     {
-		return TI_NOK;
+        return TI_OK;
+    }
+
+    if (os_memoryCompare (pCtx->pMlme->hOs, pIe + 2, XCC_oui, 3) != 0)
+    {
+        return TI_NOK;
     }
 
+    pCellTp->hdr[0] = pIe[0];
+    pCellTp->hdr[1] = pIe[1];
+    os_memoryCopy (pCtx->pMlme->hOs, (void *)pCellTp->oui, pIe + 2, pIe[1]);
+    pCtx->pFrame->cellTP = pCellTp;
+
     return TI_OK;
 }
 #endif
 
-#if CHECK_PARSING_ERROR_CONDITION_PRINT
-	#define CHECK_PARSING_ERROR_CONDITION(x, msg, bDump)	   \
-			if ((x)) \
-			{ \
-                TRACE0(pHandle->hReport, REPORT_SEVERITY_ERROR, msg);    \
-                if (bDump) {\
-                    TRACE1(pHandle->hReport, REPORT_SEVERITY_ERROR, "Buff len = %d \n", packetLength);    \
-                    report_PrintDump (pPacketBody, packetLength); }\
-				return TI_NOK; \
-			}
-#else
-	#define CHECK_PARSING_ERROR_CONDITION(x, msg, bDump) \
-         if ((x)) return TI_NOK;
-#endif
 
-TI_STATUS mlmeParser_parseIEs(TI_HANDLE hMlme, 
-							  TI_UINT8 *pData,
-							  TI_INT32 bodyDataLen,
-							  mlmeIEParsingParams_t *params)
+/* The elements parsed in beacons and probe responses, with their length limits */
+static const TMlmeIeParser aIeParsers[] =
 {
-    dot11_eleHdr_t 		*pEleHdr;
-    TI_UINT32 			 readLen;
-	TI_STATUS			 status = TI_NOK;
-    TI_UINT8 			 rsnIeIdx = 0;
-    TI_UINT8 			 wpaIeOuiIe[4] = { 0x00, 0x50, 0xf2, 0x01};
-	beacon_probeRsp_t 	*frame = &(params->frame.content.iePacket);
-	mlme_t 				*pHandle = (mlme_t *)hMlme;
+    {SSID_IE_ID,                        0, MAX_SSID_LEN,                    0,  mlmeParser_parseSsidIe},
+    {SUPPORTED_RATES_IE_ID,             0, DOT11_MAX_SUPPORTED_RATES,       0,  mlmeParser_parseRatesIe},
+    {EXT_SUPPORTED_RATES_IE_ID,         0, DOT11_MAX_SUPPORTED_RATES,       0,  mlmeParser_parseExtRatesIe},
+    {ERP_IE_ID,                         1, 255,                             0,  mlmeParser_parseErpIe},
+    {FH_PARAMETER_SET_IE_ID,            DOT11_FH_PARAMS_ELE_LEN, 255,       0,  mlmeParser_parseFhParamsIe},
+    {DS_PARAMETER_SET_IE_ID,            DOT11_DS_PARAMS_ELE_LEN, 255,       0,  mlmeParser_parseDsParamsIe},
+    {CF_PARAMETER_SET_IE_ID,            DOT11_CF_PARAMS_ELE_LEN, 255,       0,  mlmeParser_parseCfParamsIe},
+    {IBSS_PARAMETER_SET_IE_ID,          DOT11_IBSS_PARAMS_ELE_LEN, 255,     0,  mlmeParser_parseIbssParamsIe},
+    {TIM_IE_ID,                         3, 255,                             MLME_IE_SHORT_IS_ERROR, mlmeParser_parseTimIe},
+    {COUNTRY_IE_ID,                     DOT11_COUNTRY_STRING_LEN, DOT11_COUNTRY_ELE_LEN_MAX, 0, mlmeParser_parseCountryIe},
+    {POWER_CONSTRAINT_IE_ID,            0, DOT11_POWER_CONSTRAINT_ELE_LEN,  0,  mlmeParser_parsePowerConstraintIe},
+    {CHANNEL_SWITCH_ANNOUNCEMENT_IE_ID, 0, 255,                             0,  mlmeParser_parseChannelSwitchIe},
+    {QUIET_IE_ID,                       DOT11_QUIET_ELE_LEN, DOT11_QUIET_ELE_LEN, 0, mlmeParser_parseQuietIe},
+    {TPC_REPORT_IE_ID,                  1, DOT11_TPC_REPORT_ELE_LEN,        0,  mlmeParser_parseTpcReportIe},
+    {RSN_IE_ID,                         0, 255,                             0,  mlmeParser_parseRsnIe},
+    {XCC_EXT_1_IE_ID,                   0, 255,                             0,  mlmeParser_parseRsnIe},
+    {DOT11_QOS_CAPABILITY_ELE_ID,       0, DOT11_QOS_CAPABILITY_ELE_LEN,    0,  mlmeParser_parseQosCapabilityIe},
+    {HT_CAPABILITIES_IE_ID,             DOT11_HT_CAPABILITIES_ELE_LEN, DOT11_HT_CAPABILITIES_ELE_LEN, MLME_IE_SHORT_IS_ERROR, mlmeParser_parseHtCapabilitiesIe},
+    {HT_INFORMATION_IE_ID,              DOT11_HT_INFORMATION_ELE_LEN, 255,  MLME_IE_SHORT_IS_ERROR, mlmeParser_parseHtInformationIe},
+    {WPA_IE_ID,                         0, 255,                             0,  mlmeParser_parseVendorIe},
 #ifdef XCC_MODULE_INCLUDED
-	TI_BOOL				allowCellTP = TI_TRUE;
+    {CELL_POWER_IE,                     3, DOT11_CELL_TP_ELE_LEN,           0,  mlmeParser_parseCellTpIe},
 #endif
-#if CHECK_PARSING_ERROR_CONDITION_PRINT
-	TI_INT32				packetLength = bodyDataLen;
-	TI_UINT8				*pPacketBody = pData;
-#endif
-
-	params->recvChannelSwitchAnnoncIE = TI_FALSE;
+};
 
-	while (bodyDataLen > 1)
-	{
-		pEleHdr = (dot11_eleHdr_t *)pData;
-	
-#if CHECK_PARSING_ERROR_CONDITION_PRINT
-		/* CHECK_PARSING_ERROR_CONDITION(((*pEleHdr)[1] > (bodyDataLen - 2)), ("MLME_PARSER: IE %d with length %d out of bounds %d\n", (*pEleHdr)[0], (*pEleHdr)[1], (bodyDataLen - 2)), TI_TRUE); */
-		if ((*pEleHdr)[1] > (bodyDataLen - 2))
-		{
-			TRACE3(pHandle->hReport, REPORT_SEVERITY_ERROR, "MLME_PARSER: IE %d with length %d out of bounds %d\n", (*pEleHdr)[0], (*pEleHdr)[1], (bodyDataLen - 2));
-		
-			TRACE1(pHandle->hReport, REPORT_SEVERITY_ERROR, "Buff len = %d \n", packetLength);
-			report_PrintDump (pPacketBody, packetLength); 
-		}
-#endif
-        switch ((*pEleHdr)[0])
-		{
-		/* read SSID */
-		case SSID_IE_ID:
-			frame->pSsid = &params->ssid;
-			status = mlmeParser_readSsid(pHandle, pData, bodyDataLen, &readLen, frame->pSsid);
-			CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading SSID\n"),TI_TRUE);
-			break;
-		/* read rates */
-		case SUPPORTED_RATES_IE_ID:
-			frame->pRates = &params->rates;
-			status = mlmeParser_readRates(pHandle, pData, bodyDataLen, &readLen, frame->pRates);
-			CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading RATES\n"),TI_TRUE);
-			break;
-		case EXT_SUPPORTED_RATES_IE_ID:
-			frame->pExtRates = &params->extRates;
-			status = mlmeParser_readRates(pHandle, pData, bodyDataLen, &readLen, frame->pExtRates);
-			CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading EXT RATES\n"),TI_TRUE);
-			break;
+#define MLME_IE_PARSERS_NUM     (sizeof(aIeParsers) / sizeof(TMlmeIeParser))
 
-		case ERP_IE_ID:
-			status = mlmeParser_readERP(pHandle, pData, bodyDataLen, &readLen,
-										(TI_BOOL *)&frame->useProtection,
-										(EPreamble *)&frame->barkerPreambleMode);
+/* Element ID to aIeParsers index + 1 (0 for elements without a parser) */
+static TI_UINT8 aIeParserIndex[256];
 
-			CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading ERP\n"),TI_TRUE);
-			break;
-		/* read FH parameter set */
-		case FH_PARAMETER_SET_IE_ID:
-			frame->pFHParamsSet = &params->fhParams;
-			status = mlmeParser_readFhParams(pHandle, pData, bodyDataLen, &readLen, frame->pFHParamsSet);
-			CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading FH parameters\n"),TI_TRUE);
-			break;
-		/* read DS parameter set */
-		case DS_PARAMETER_SET_IE_ID:
-			frame->pDSParamsSet = &params->dsParams;
-			status = mlmeParser_readDsParams(pHandle, pData, bodyDataLen, &readLen, frame->pDSParamsSet);
-			CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading DS parameters\n"),TI_TRUE);
-			if (RADIO_BAND_2_4_GHZ == params->band )
-			{
-				if (frame->pDSParamsSet->currChannel != params->rxChannel)
-				{
-					TRACE2(pHandle->hReport, REPORT_SEVERITY_ERROR, "Channel ERROR - incompatible channel source information: Frame=%d Vs Radio=%d.\nparser ABORTED!!!\n",
-						frame->pDSParamsSet->currChannel , params->rxChannel);
 
-					return TI_NOK;
-				}
-			}
-			break;
-		/* read CF parameter set */
-		case CF_PARAMETER_SET_IE_ID:
-			frame->pCFParamsSet = &params->cfParams;
-			status = mlmeParser_readCfParams(pHandle, pData, bodyDataLen, &readLen, frame->pCFParamsSet);
-			CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading CF parameters\n"),TI_TRUE);
-			break;
-		/* read IBSS parameter set */
-		case IBSS_PARAMETER_SET_IE_ID:
-			frame->pIBSSParamsSet = &params->ibssParams;
-			status = mlmeParser_readIbssParams(pHandle, pData, bodyDataLen, &readLen, frame->pIBSSParamsSet);
-			CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading IBSS parameters\n"),TI_TRUE);
-			break;
+/**
+ * \fn     mlmeParser_init
+ * \brief  Build the IE parsers lookup
+ *
+ * Fill the element ID to parser lookup used by mlmeParser_parseIEs.
+ *
+ * \note   Called once from mlme_init, before any frame is parsed
+ * \return void
+ * \sa     mlmeParser_parseIEs
+ */
+void mlmeParser_init (void)
+{
+    TI_UINT32 i;
 
-		/* read TIM */
-		case TIM_IE_ID:
-			frame->pTIM = &params->tim;
-			status = mlmeParser_readTim(pHandle, pData, bodyDataLen, &readLen, frame->pTIM);
-			CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading TIM\n"),TI_TRUE);
-			break;
+    for (i = 0; i < MLME_IE_PARSERS_NUM; i++)
+    {
+        aIeParserIndex[aIeParsers[i].uIeId] = (TI_UINT8)(i + 1);
+    }
+}
 
-		/* read Country */
-		case COUNTRY_IE_ID:
-			frame->country = &params->country;
-			status = mlmeParser_readCountry(pHandle, pData, bodyDataLen, &readLen, frame->country);
-			CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading country parameters\n"),TI_TRUE);
-			break;
 
-		/* read Power Constraint */
-		case POWER_CONSTRAINT_IE_ID:
-#ifdef XCC_MODULE_INCLUDED
-			allowCellTP = TI_FALSE;
+TI_STATUS mlmeParser_parseIEs(TI_HANDLE hMlme,
+							  TI_UINT8 *pData,
+							  TI_INT32 bodyDataLen,
+							  mlmeIEParsingParams_t *params)
+{
+    mlme_t              *pHandle = (mlme_t *)hMlme;
+    TMlmeIeParseCtx      tCtx;
+    const TMlmeIeParser *pParser;
+    TI_UINT8             uIndex;
+    TI_UINT8             uLen;
+#if CHECK_PARSING_ERROR_CONDITION_PRINT
+    TI_INT32             packetLength = bodyDataLen;
+    TI_UINT8            *pPacketBody = pData;
 #endif
-			frame->powerConstraint = &params->powerConstraint;
-			status = mlmeParser_readPowerConstraint(pHandle, pData, bodyDataLen, &readLen, frame->powerConstraint);
-			CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading Power Constraint parameters\n"),TI_TRUE);
-			break;
 
-		/* read Channel Switch Mode */
-        case CHANNEL_SWITCH_ANNOUNCEMENT_IE_ID:
-            
-            frame->channelSwitch = &params->channelSwitch;
+    tCtx.pMlme = pHandle;
+    tCtx.pParams = params;
+    tCtx.pFrame = &(params->frame.content.iePacket);
+    tCtx.uRsnIeNum = 0;
 
-            if (params->myBssid)
-			{   /* Ignore Switch Channel commands from non my BSSID */
-				params->recvChannelSwitchAnnoncIE = TI_TRUE;
-				status = mlmeParser_readChannelSwitch(pHandle, pData, bodyDataLen, &readLen, frame->channelSwitch, params->rxChannel);
-				if (status != TI_OK)
-				{
-					/*
-					 * PATCH for working with AP-DK 4.0.51 that use IE 37 (with length 20) for RSNE
-					 * Ignore the IE instead of rejecting the whole BUF (beacon or probe response)
-					 */
-                    TRACE0(pHandle->hReport, REPORT_SEVERITY_WARNING, "MLME_PARSER: error reading Channel Switch announcement parameters - ignore IE\n");
-				}
-			}
-			break;
+    params->recvChannelSwitchAnnoncIE = TI_FALSE;
+    tCtx.pFrame->pIes = pData;
+    tCtx.pFrame->iesLen = (bodyDataLen > 0) ? (TI_UINT16)bodyDataLen : 0;
+    tCtx.pFrame->unknownIeLen = 0;
 
-		/* read Quiet IE */
-		case QUIET_IE_ID:
-			frame->quiet = &params->quiet;
-			status = mlmeParser_readQuiet(pHandle, pData, bodyDataLen, &readLen, frame->quiet);
-			CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading Quiet parameters\n"),TI_TRUE);
-			break;
+    while (bodyDataLen > 1)
+    {
+        uLen = pData[1];
+        uIndex = aIeParserIndex[pData[0]];
 
-		/* read TPC report IE */
-		case TPC_REPORT_IE_ID:
-			frame->TPCReport = &params->TPCReport;
-			status = mlmeParser_readTPCReport(pHandle, pData, bodyDataLen, &readLen, frame->TPCReport);
-			CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading TPC report parameters\n"),TI_TRUE);
-			break;
+        if (uLen > (bodyDataLen - 2))
+        {
+            /* A truncated last element is ignored, unless it is one we should have parsed */
+            if (uIndex == 0)
+            {
+                break;
+            }
+            TRACE3(pHandle->hReport, REPORT_SEVERITY_ERROR, "MLME_PARSER: IE %d with length %d out of bounds %d\n", pData[0], uLen, (bodyDataLen - 2));
+            goto parse_error;
+        }
 
-		case XCC_EXT_1_IE_ID:
-			frame->pRsnIe   = &params->rsnIe[0];
-			status = mlmeParser_readRsnIe(pHandle, pData, bodyDataLen, &readLen, &params->rsnIe[rsnIeIdx]);
-			CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading RSN IE\n"),TI_TRUE);
+        if (uIndex == 0)
+        {
+            TRACE1(pHandle->hReport, REPORT_SEVERITY_INFORMATION, "MLME_PARSER: unknown IE found (%d)\n", pData[0]);
+            tCtx.pFrame->unknownIeLen += uLen + 2;
+        }
+        else
+        {
+            pParser = &aIeParsers[uIndex - 1];
 
-			frame->rsnIeLen += readLen;
-			rsnIeIdx ++;
-			break;
+            if (uLen > pParser->uMaxLen)
+            {
+                TRACE3(pHandle->hReport, REPORT_SEVERITY_ERROR, "MLME_PARSER: IE %d error: eleLen=%d, maxLen=%d\n", pData[0], uLen, pParser->uMaxLen);
+                goto parse_error;
+            }
 
-		case RSN_IE_ID:
-			frame->pRsnIe = &params->rsnIe[0];
-			status = mlmeParser_readRsnIe(pHandle, pData, bodyDataLen, &readLen, &params->rsnIe[rsnIeIdx]);
-			CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading RSN IE\n"),TI_TRUE);
+            if (uLen < pParser->uMinLen)
+            {
+                if (pParser->uFlags & MLME_IE_SHORT_IS_ERROR)
+                {
+                    TRACE3(pHandle->hReport, REPORT_SEVERITY_ERROR, "MLME_PARSER: IE %d error: eleLen=%d, minLen=%d\n", pData[0], uLen, pParser->uMinLen);
+                    goto parse_error;
+                }
+                TRACE3(pHandle->hReport, REPORT_SEVERITY_WARNING, "MLME_PARSER: IE %d ignored: eleLen=%d, minLen=%d\n", pData[0], uLen, pParser->uMinLen);
+            }
+            else if (pParser->fParse (&tCtx, pData) != TI_OK)
+            {
+                TRACE1(pHandle->hReport, REPORT_SEVERITY_ERROR, "MLME_PARSER: error reading IE %d\n", pData[0]);
+                goto parse_error;
+            }
+        }
 
-			frame->rsnIeLen += readLen;
-			rsnIeIdx ++;
-			break;
+        pData += uLen + 2;
+        bodyDataLen -= uLen + 2;
+    }
 
-		case DOT11_QOS_CAPABILITY_ELE_ID:
-			frame->QoSCapParameters = &params->QosCapParams;
-			status = mlmeParser_readQosCapabilityIE(pHandle, pData, bodyDataLen, &readLen, &params->QosCapParams);
-			CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading QOS CapabilityIE\n"),TI_TRUE);
-			break;
+    return TI_OK;
+
+parse_error:
+#if CHECK_PARSING_ERROR_CONDITION_PRINT
+    TRACE1(pHandle->hReport, REPORT_SEVERITY_ERROR, "Buff len = %d \n", packetLength);
+    report_PrintDump (pPacketBody, packetLength);
+#endif
+    return TI_NOK;
+}
 
-	case HT_CAPABILITIES_IE_ID:
-		frame->pHtCapabilities = &params->tHtCapabilities;
-		status = mlmeParser_readHtCapabilitiesIE(pHandle, pData, bodyDataLen, &readLen, &params->tHtCapabilities);
-		CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading HT Capabilitys IE\n"),TI_TRUE);
-		break;
 
-	case HT_INFORMATION_IE_ID:
-		frame->pHtInformation = &params->tHtInformation;
-		status = mlmeParser_readHtInformationIE(pHandle, pData, bodyDataLen, &readLen, &params->tHtInformation);
-		CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading HT Information IE\n"),TI_TRUE);
-		break;
+/**
+ * \fn     mlmeParser_CopyUnknownIes
+ * \brief  Copy the IEs the parser does not handle
+ *
+ * Copy the elements of a parsed beacon or probe response which have no parser, as is
+ * and in their order in the frame, for the applications that want all of the IEs.
+ * They are not gathered while parsing since only the scan result table keeps them.
+ *
+ * \note   Must be called while the parsed frame buffer is still valid
+ * \param  hOs - handle to the OS object
+ * \param  pFrame - the frame parsed by mlmeParser_parseIEs
+ * \param  pBuf - buffer for the unknown IEs
+ * \param  uBufLen - the buffer length (IEs that do not fit are dropped)
+ * \return The length of the copied IEs
+ * \sa     mlmeParser_parseIEs
+ */
+TI_UINT16 mlmeParser_CopyUnknownIes (TI_HANDLE hOs, beacon_probeRsp_t *pFrame, TI_UINT8 *pBuf, TI_UINT32 uBufLen)
+{
+    TI_UINT8    *pIe = pFrame->pIes;
+    TI_UINT32    uLeft = pFrame->iesLen;
+    TI_UINT32    uIeLen;
+    TI_UINT32    uCopied = 0;
 
-		case WPA_IE_ID:
-			if (!os_memoryCompare(pHandle->hOs, pData+2, wpaIeOuiIe, 3))
-			{
-				/* Note : WSC, WPA and WME use the same OUI */
-				/*  Its assumes that:
-						WPA uses OUI Type with value  - 1
-						WME uses OUI Type with value  - 2
-						WSC uses OUI Type with value  - 4
-				*/
-
-				/* Check the OUI sub Type to verify whether this is a WSC IE, WME IE or WPA IE*/
-				if( (*(TI_UINT8*)(pData+5)) == dot11_WPA_OUI_TYPE)
-				{
-					/* If we are here - the following is WPA IE */
-					frame->pRsnIe = &params->rsnIe[0];
-					status = mlmeParser_readRsnIe(pHandle, pData, bodyDataLen,
-												  &readLen, &params->rsnIe[rsnIeIdx]);
-					frame->rsnIeLen += readLen;
-					rsnIeIdx ++;
-
-					CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading RSN IE\n"),TI_TRUE);
-				}
-				if( ( (*(TI_UINT8*)(pData+5)) == dot11_WME_OUI_TYPE ) && 
-					( ( (*(TI_UINT8*)(pData+6)) == dot11_WME_OUI_SUB_TYPE_PARAMS_IE) ||
-					  ( (*(TI_UINT8*)(pData+6)) == dot11_WME_OUI_SUB_TYPE_IE) ) )
-				{
-					/* If we are here - the following is WME-Params IE, WME-Info IE or TSPEC IE. */
-					/* Note that we are using the WMEParams struct also to hold the WME-Info IE
-					     which is a subset of WMEParams, and only one of them is sent in a frame. */
-					frame->WMEParams = &params->WMEParams;
-					status = mlmeParser_readWMEParams(pHandle, pData, bodyDataLen, &readLen, frame->WMEParams, NULL);
-					
-					CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading WME params\n"),TI_TRUE);
-				}
-				if( ( (*(TI_UINT8*)(pData+5)) == dot11_WSC_OUI_TYPE ))
-				{
-					/* If we are here - the following is WSC IE */
-                    readLen = mlmeParser_getWSCReadLen (pData);
-                    /* 
-                     * This IE is not supposed to be found in beacons accroding to the standard
-                     * definition. However, some APs do add it to beacons. It is read from beacons
-                     * accroding to a registry key (which is false by default). Even if it is not
-                     * read, the readLen must be set for the pointer to advance, which is done
-                     * above.
-                     */
-                    if ((BEACON != params->frame.subType) || (TI_TRUE == pHandle->bParseBeaconWSC))
-                    {
-					frame->WSCParams = &params->WSCParams;
-					status = mlmeParser_readWSCParams(pHandle, pData, bodyDataLen, &readLen, frame->WSCParams);
-					CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading WSC params\n"),TI_TRUE);
-				}
-                }
-				else
-				{
-					/* Unrecognized OUI type */
-					readLen = (*pEleHdr)[1] + 2;
-				}
-			}
-			else
-			{
-				readLen = (*pEleHdr)[1] + 2;
-			}
+    if (pFrame->unknownIeLen == 0)
+    {
+        return 0;
+    }
 
-			break;
+    while (uLeft > 1)
+    {
+        uIeLen = pIe[1] + 2;
+        if (uIeLen > uLeft)
+        {
+            break;
+        }
 
-#ifdef XCC_MODULE_INCLUDED
-		case CELL_POWER_IE:
-			/* We mustn't take the Cell Transmit Power IE into account if */
-			/* there's a Power Constraint IE. Since the IEs must be in increasing */
-			/* order, it's enough to perform the check here, because if the Power */
-			/* Constraint IE is present it must have already been processed. */ 
-			if (allowCellTP)
-			{
-				frame->cellTP = &params->cellTP;
-				status = mlmeParser_readCellTP(pHandle, pData, bodyDataLen, &readLen, frame->cellTP);
-				CHECK_PARSING_ERROR_CONDITION((status != TI_OK), ("MLME_PARSER: error reading Cell Transmit Power params.\n"),TI_TRUE);
-			}
-			break;
-#endif
+        if (aIeParserIndex[pIe[0]] == 0)
+        {
+            if (uCopied + uIeLen > uBufLen)
+            {
+                break;
+            }
+            os_memoryCopy (hOs, pBuf + uCopied, pIe, uIeLen);
+            uCopied += uIeLen;
+        }
 
-		default:
-			TRACE1(pHandle->hReport, REPORT_SEVERITY_INFORMATION, "MLME_PARSER: unknown IE found (%d)\n", pData[0]);
-			readLen = pData[1] + 2;
-			status = TI_OK;
-			os_memoryCopy( pHandle->hOs,
-				       &params->unknownIe[params->frame.content.iePacket.unknownIeLen],
-				       pData, readLen );
-			params->frame.content.iePacket.pUnknownIe = params->unknownIe;
-			params->frame.content.iePacket.unknownIeLen += readLen;
-			break;
-		}
-		pData += readLen;
-		bodyDataLen -= readLen;
-#if CHECK_PARSING_ERROR_CONDITION_PRINT
-		/* CHECK_PARSING_ERROR_CONDITION((bodyDataLen < 0), ("MLME_PARSER: negative bodyDataLen %d bytes\n", bodyDataLen),TI_TRUE); */
-		if (bodyDataLen < 0)
-		{
-			TRACE1(pHandle->hReport, REPORT_SEVERITY_ERROR, "MLME_PARSER: negative bodyDataLen %d bytes\n", bodyDataLen);
-			TRACE1(pHandle->hReport, REPORT_SEVERITY_ERROR, "Buff len = %d \n", packetLength);
-			report_PrintDump (pPacketBody, packetLength);
-		}
-#endif
-	}
-	return TI_OK;
+        pIe += uIeLen;
+        uLeft -= uIeLen;
+    }
+
+    return (TI_UINT16)uCopied;
 }
 
 mlmeIEParsingParams_t *mlmeParser_getParseIEsBuffer(TI_HANDLE *hMlme)
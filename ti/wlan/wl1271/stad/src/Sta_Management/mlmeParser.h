@@ -83,55 +83,6 @@ TI_STATUS mlmeParser_readRates(mlme_t *pMlme,
 							TI_UINT32 *pReadLen, 
 							dot11_RATES_t *pRates);
 
-TI_STATUS mlmeParser_readERP(mlme_t *pMlme,
-                             TI_UINT8 *pData,
-                             TI_UINT32 dataLen,
-                             TI_UINT32 *pReadLen,
-                             TI_BOOL *useProtection,
-                             EPreamble *barkerPreambleMode);
-
-TI_STATUS mlmeParser_readSsid(mlme_t *pMlme, 
-						   TI_UINT8 *pData, 
-						   TI_UINT32 dataLen, 
-						   TI_UINT32 *pReadLen, 
-						   dot11_SSID_t *pSsid);
-
-TI_STATUS mlmeParser_readFhParams(mlme_t *pMlme, 
-							   TI_UINT8 *pData, 
-							   TI_UINT32 dataLen, 
-							   TI_UINT32 *pReadLen, 
-							   dot11_FH_PARAMS_t *pFhParams);
-
-TI_STATUS mlmeParser_readDsParams(mlme_t *pMlme, 
-							   TI_UINT8 *pData, 
-							   TI_UINT32 dataLen, 
-							   TI_UINT32 *pReadLen, 
-							   dot11_DS_PARAMS_t *pDsParams);
-
-TI_STATUS mlmeParser_readCfParams(mlme_t *pMlme, 
-							   TI_UINT8 *pData, 
-							   TI_UINT32 dataLen, 
-							   TI_UINT32 *pReadLen, 
-							   dot11_CF_PARAMS_t *pCfParams);
-
-TI_STATUS mlmeParser_readIbssParams(mlme_t *pMlme, 
-								 TI_UINT8 *pData, 
-								 TI_UINT32 dataLen, 
-								 TI_UINT32 *pReadLen, 
-								 dot11_IBSS_PARAMS_t *pIbssParams);
-
-TI_STATUS mlmeParser_readTim(mlme_t *pMlme, 
-						  TI_UINT8 *pData, 
-						  TI_UINT32 dataLen, 
-						  TI_UINT32 *pReadLen, 
-						  dot11_TIM_t *pTim);
-
-TI_STATUS mlmeParser_readCountry(mlme_t *pMlme,
-								 TI_UINT8 *pData,
-								 TI_UINT32 dataLen,
-								 TI_UINT32 *pReadLen,
-								 dot11_COUNTRY_t *countryIE);
-
 TI_STATUS mlmeParser_readWMEParams(mlme_t *pMlme,
 								   TI_UINT8 *pData,
 								   TI_UINT32 dataLen,
@@ -139,12 +90,6 @@ TI_STATUS mlmeParser_readWMEParams(mlme_t *pMlme,
 								   dot11_WME_PARAM_t *pWMEParamIE, 
 								   assocRsp_t *assocRsp);
 
-TI_STATUS mlmeParser_readPowerConstraint(mlme_t *pMlme,
-										 TI_UINT8 *pData,
-										 TI_UINT32 dataLen,
-										 TI_UINT32 *pReadLen,
-										 dot11_POWER_CONSTRAINT_t *powerConstraintIE);
-
 TI_STATUS mlmeParser_readChannelSwitch(mlme_t *pMlme,
 									   TI_UINT8 *pData,
 									   TI_UINT32 dataLen,
@@ -152,26 +97,6 @@ TI_STATUS mlmeParser_readChannelSwitch(mlme_t *pMlme,
 									   dot11_CHANNEL_SWITCH_t *channelSwitch,
                                        TI_UINT8 channel);
 
-TI_STATUS mlmeParser_readTPCReport(mlme_t *pMlme,
-								   TI_UINT8 *pData,
-								   TI_UINT32 dataLen,
-								   TI_UINT32 *pReadLen,
-								   dot11_TPC_REPORT_t	*TPCReport);
-
-#ifdef XCC_MODULE_INCLUDED
-TI_STATUS mlmeParser_readCellTP(mlme_t *pMlme, 
-								TI_UINT8 *pData, 
-								TI_UINT32 dataLen, 
-								TI_UINT32 *pReadLen, 
-								dot11_CELL_TP_t *cellTP);
-#endif
-
-TI_STATUS mlmeParser_readQuiet(mlme_t *pMlme,
-							   TI_UINT8 *pData,
-							   TI_UINT32 dataLen,
-							   TI_UINT32 *pReadLen,
-							   dot11_QUIET_t *quiet);
-
 TI_STATUS mlmeParser_readChallange(mlme_t *pMlme, 
 								TI_UINT8 *pData, 
 								TI_UINT32 dataLen, 
@@ -258,6 +258,8 @@ void mlme_init (TStadHandlesList *pStadHandles)
     pHandle->debug_lastBeaconTSFTime = 0;
     pHandle->debug_isFunctionFirstTime = TI_TRUE;
     pHandle->BeaconsCounterPS = 0;
+
+    mlmeParser_init ();
 }
 
 void mlme_SetDefaults (TI_HANDLE hMlmeSm, TMlmeInitParams *pMlmeInitParams)
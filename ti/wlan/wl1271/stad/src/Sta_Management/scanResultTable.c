@@ -49,6 +49,10 @@
 //#define TABLE_ENTRIES_NUMBER    32
 
 #define MILISECONDS(seconds)                            (seconds * 1000)
+
+#define SCAN_RESULT_NO_ENTRY                            0xFFFF  /* end of the hash bucket and age lists */
+#define SCAN_RESULT_MAX_ENTRIES                         SCAN_RESULT_NO_ENTRY
+#define IS_HIDDEN_SSID(pSsid)                           (((pSsid)->len == 0) || (((pSsid)->len == 1) && ((pSsid)->str[0] == 0)))
 #define UPDATE_LOCAL_TIMESTAMP(pSite, hOs)              pSite->localTimeStamp = os_timeStampMs(hOs);
 
 #define UPDATE_BSSID(pSite, pFrame)                     MAC_COPY((pSite)->bssid, *((pFrame)->bssId))
@@ -113,16 +117,20 @@
 #define UPDATE_SNR(pSite, pFrame)                       (pSite)->snr = (pFrame)->snr;
 #define UPDATE_RATE(pSite, pFrame)                      if ((DRV_RATE_1M <= (pFrame)->rate) && (DRV_RATE_54M <= (pFrame)->rate)) \
                                                             (pSite)->rxRate = (pFrame)->rate;
-#define UPDATE_UNKOWN_IE(pScanResultTable, pSite, pNewUnknwonIe, newUnknwonIeLen) if ((pNewUnknwonIe) != NULL) { \
-                                                                                    pSite->unknownIeLen = newUnknwonIeLen; \
-                                                                                    os_memoryCopy(pScanResultTable->hOS, \
-                                                                                                  (void *)(pSite->pUnknownIe), \
-                                                                                                  pNewUnknwonIe, \
-                                                                                                  newUnknwonIeLen);	\
-                                                                                  } else { \
-                                                                                 	pSite->unknownIeLen = 0; \
-                                                                                  }
+#define UPDATE_UNKOWN_IE(pScanResultTable, pSite, pFrame)   (pSite)->unknownIeLen = mlmeParser_CopyUnknownIes ((pScanResultTable)->hOS, \
+                                                                                                       &((pFrame)->parsedIEs->content.iePacket), \
+                                                                                                       (pSite)->pUnknownIe, \
+                                                                                                       MAX_BEACON_BODY_LENGTH)
+
 
+/* The index links of a table entry (kept apart from the entries, which are copied around) */
+typedef struct
+{
+    TI_UINT16       uHashNext;              /**< next entry in the same hash bucket */
+    TI_UINT16       uAgePrev;               /**< previous (older) entry in the age list */
+    TI_UINT16       uAgeNext;               /**< next (newer) entry in the age list */
+    TI_UINT16       uBucket;                /**< the entry hash bucket */
+} TScanResultLinks;
 
 typedef struct
 {
@@ -136,6 +144,12 @@ typedef struct
     TI_UINT32       uSraThreshold;          /**< Rssi threshold for frame filtering */
     TI_BOOL         bStable;                /**< table status (updating / stable) */
     EScanResultTableClear  eClearTable;     /** inicates if table should be cleared at scan */
+    TScanResultLinks *pLinks;               /**< per entry hash bucket and age list links */
+    TI_UINT16       *pHashHeads;            /**< first entry of each hash bucket (by SSID and BSSID) */
+    TI_UINT32       uHashMask;              /**< number of hash buckets - 1 */
+    TI_UINT16       uAgeOldest;             /**< the least recently updated entry */
+    TI_UINT16       uAgeNewest;             /**< the most recently updated entry */
+    TI_UINT32       uHiddenSsidNumber;      /**< number of entries with hidden SSID */
 } TScanResultTable;
 
 static TSiteEntry  *scanResultTbale_AllocateNewEntry (TI_HANDLE hScanResultTable);
@@ -144,6 +158,11 @@ static void         scanResultTable_updateRates(TI_HANDLE hScanResultTable, TSit
 static void         scanResultTable_UpdateWSCParams (TSiteEntry *pSite, TScanFrameInfo *pFrame);
 static TI_STATUS    scanResultTable_CheckRxSignalValidity(TScanResultTable *pScanResultTable, siteEntry_t *pSite, TI_INT8 rxLevel, TI_UINT8 channel);
 static void         scanResultTable_RemoveEntry(TI_HANDLE hScanResultTable, TI_UINT32 uIndex);
+static void         scanResultTable_Clear (TScanResultTable *pScanResultTable);
+static TI_UINT32    scanResultTable_Hash (TScanResultTable *pScanResultTable, TSsid *pSsid, TMacAddr *pBssid);
+static void         scanResultTable_LinkEntry (TScanResultTable *pScanResultTable, TI_UINT32 uIndex);
+static void         scanResultTable_UnlinkEntry (TScanResultTable *pScanResultTable, TI_UINT32 uIndex);
+static void         scanResultTable_MoveEntry (TScanResultTable *pScanResultTable, TI_UINT32 uFrom, TI_UINT32 uTo);
 
 
 /** 
@@ -160,6 +179,14 @@ static void         scanResultTable_RemoveEntry(TI_HANDLE hScanResultTable, TI_U
 TI_HANDLE scanResultTable_Create (TI_HANDLE hOS, TI_UINT32 uEntriesNumber)
 {
     TScanResultTable    *pScanResultTable = NULL;
+    TI_UINT32           uBucketsNumber;
+
+    /* the entries are linked by 16 bit indexes */
+    if ((uEntriesNumber == 0) || (uEntriesNumber >= SCAN_RESULT_MAX_ENTRIES))
+    {
+        WLAN_OS_REPORT(("scanResultTable_Create: Invalid number of entries %d\n", uEntriesNumber));
+        return NULL;
+    }
 
     /* Allocate object storage */
     pScanResultTable = (TScanResultTable*)os_memoryAlloc (hOS, sizeof(TScanResultTable));
@@ -171,6 +198,7 @@ TI_HANDLE scanResultTable_Create (TI_HANDLE hOS, TI_UINT32 uEntriesNumber)
         return NULL;  /* this is done similarly to the next error case */
     }
 
+    os_memoryZero(hOS, pScanResultTable, sizeof(TScanResultTable));
     pScanResultTable->hOS = hOS;
     /* allocate memory for sites' data */
     pScanResultTable->pTable = 
@@ -185,6 +213,20 @@ TI_HANDLE scanResultTable_Create (TI_HANDLE hOS, TI_UINT32 uEntriesNumber)
     }
     pScanResultTable->uEntriesNumber = uEntriesNumber;
     os_memoryZero(pScanResultTable->hOS, pScanResultTable->pTable, sizeof(TSiteEntry) * uEntriesNumber);
+
+    /* allocate the index: a hash bucket per entry (rounded up to a power of 2), and the entries links */
+    for (uBucketsNumber = 1; uBucketsNumber < uEntriesNumber; uBucketsNumber <<= 1);
+    pScanResultTable->uHashMask = uBucketsNumber - 1;
+    pScanResultTable->pHashHeads = (TI_UINT16 *)os_memoryAlloc (pScanResultTable->hOS, sizeof(TI_UINT16) * uBucketsNumber);
+    pScanResultTable->pLinks = (TScanResultLinks *)os_memoryAlloc (pScanResultTable->hOS, sizeof(TScanResultLinks) * uEntriesNumber);
+    if ((NULL == pScanResultTable->pHashHeads) || (NULL == pScanResultTable->pLinks))
+    {
+        WLAN_OS_REPORT(("scanResultTable_Create: Unable to allocate memory for the index of %d entries\n", uEntriesNumber));
+        scanResultTable_Destroy ((TI_HANDLE)pScanResultTable);
+        return NULL;
+    }
+    scanResultTable_Clear (pScanResultTable);
+
     return (TI_HANDLE)pScanResultTable;
 }
 
@@ -210,7 +252,7 @@ void        scanResultTable_Init (TI_HANDLE hScanResultTable, TStadHandlesList *
     pScanResultTable->hSiteMgr = pStadHandles->hSiteMgr;
 
     /* initialize other parameters */
-    pScanResultTable->uCurrentSiteNumber = 0;
+    scanResultTable_Clear (pScanResultTable);
     pScanResultTable->bStable = TI_TRUE;
     pScanResultTable->uIterator = 0;
     pScanResultTable->eClearTable = eClearTable;
@@ -241,6 +283,18 @@ void        scanResultTable_Destroy (TI_HANDLE hScanResultTable)
                        sizeof (TSiteEntry) * pScanResultTable->uEntriesNumber);
     }
 
+    /* free the table index memory */
+    if (NULL != pScanResultTable->pHashHeads)
+    {
+        os_memoryFree (pScanResultTable->hOS, (void*)pScanResultTable->pHashHeads, 
+                       sizeof (TI_UINT16) * (pScanResultTable->uHashMask + 1));
+    }
+    if (NULL != pScanResultTable->pLinks)
+    {
+        os_memoryFree (pScanResultTable->hOS, (void*)pScanResultTable->pLinks, 
+                       sizeof (TScanResultLinks) * pScanResultTable->uEntriesNumber);
+    }
+
     /* free scan result table object memeory */
     os_memoryFree (pScanResultTable->hOS, (void*)hScanResultTable, sizeof (TScanResultTable));
 }
@@ -292,7 +346,7 @@ TI_STATUS scanResultTable_UpdateEntry (TI_HANDLE hScanResultTable, TMacAddr *pBs
         if (SCAN_RESULT_TABLE_CLEAR == pScanResultTable->eClearTable) 
         {
             /* clear table contents */
-            pScanResultTable->uCurrentSiteNumber = 0;
+            scanResultTable_Clear (pScanResultTable);
         }
     }
 
@@ -324,8 +378,10 @@ TI_STATUS scanResultTable_UpdateEntry (TI_HANDLE hScanResultTable, TMacAddr *pBs
         if (TI_NOK != scanResultTable_CheckRxSignalValidity(pScanResultTable, pSite, pFrame->rssi, pFrame->channel))
         {
             TRACE0(pScanResultTable->hReport, REPORT_SEVERITY_INFORMATION , "scanResultTable_UpdateEntry: entry already exists, updating\n");
-            /* BSSID exists: update its data */
+            /* BSSID exists: update its data, and move it to the end of the age list */
             scanResultTable_UpdateSiteData (hScanResultTable, pSite, pFrame);
+            scanResultTable_UnlinkEntry (pScanResultTable, pSite - pScanResultTable->pTable);
+            scanResultTable_LinkEntry (pScanResultTable, pSite - pScanResultTable->pTable);
         }
     }
     else
@@ -343,6 +399,9 @@ TI_STATUS scanResultTable_UpdateEntry (TI_HANDLE hScanResultTable, TMacAddr *pBs
         scanResultTable_UpdateSiteData (hScanResultTable, 
                                         pSite,
                                         pFrame);
+
+        /* index it by its SSID and BSSID, as the newest entry */
+        scanResultTable_LinkEntry (pScanResultTable, pSite - pScanResultTable->pTable);
     }
 
     return TI_OK;
@@ -371,7 +430,7 @@ void    scanResultTable_SetStableState (TI_HANDLE hScanResultTable)
     {
         TRACE0(pScanResultTable->hReport, REPORT_SEVERITY_INFORMATION , "scanResultTable_SetStableState: also clearing table contents\n");
 
-        pScanResultTable->uCurrentSiteNumber = 0;
+        scanResultTable_Clear (pScanResultTable);
     }
 
     /* set stable state */
@@ -428,7 +487,7 @@ TSiteEntry  *scanResultTable_GetNext (TI_HANDLE hScanResultTable)
  * \fn     scanResultTable_GetByBssid
  * \brief  retreives an entry according to its SSID and BSSID
  * 
- * retreives an entry according to its BSSID
+ * retreives an entry according to its BSSID, from the entries with the same SSID and BSSID hash
  * 
  * \param  hScanResultTable - handle to the scan result table object
  * \param  pSsid - SSID to search for
@@ -442,8 +501,10 @@ TSiteEntry  *scanResultTable_GetBySsidBssidPair (TI_HANDLE hScanResultTable, TSs
 
     TRACE6(pScanResultTable->hReport, REPORT_SEVERITY_INFORMATION , "scanResultTable_GetBySsidBssidPair: Searching for SSID  BSSID %02x:%02x:%02x:%02x:%02x:%02x\n", (*pBssid)[ 0 ], (*pBssid)[ 1 ], (*pBssid)[ 2 ], (*pBssid)[ 3 ], (*pBssid)[ 4 ], (*pBssid)[ 5 ]);
     
-    /* check all entries in the table */
-    for (uIndex = 0; uIndex < pScanResultTable->uCurrentSiteNumber; uIndex++)
+    /* check the entries in the SSID and BSSID hash bucket */
+    for (uIndex = pScanResultTable->pHashHeads[ scanResultTable_Hash (pScanResultTable, pSsid, pBssid) ]; 
+         uIndex != SCAN_RESULT_NO_ENTRY; 
+         uIndex = pScanResultTable->pLinks[ uIndex ].uHashNext)
     {
         /* if the BSSID and SSID match */
         if (MAC_EQUAL (*pBssid, pScanResultTable->pTable[ uIndex ].bssid) &&
@@ -475,13 +536,12 @@ static TI_STATUS scanResultTable_FindHidden (TScanResultTable *pScanResultTable,
     TI_UINT32 uIndex;
 
     TRACE0(pScanResultTable->hReport, REPORT_SEVERITY_INFORMATION , "scanResultTable_FindHidden: Searching for hidden SSID\n");
-    
-    /* check all entries in the table */
-    for (uIndex = 0; uIndex < pScanResultTable->uCurrentSiteNumber; uIndex++)
+
+    /* check all entries in the table, if any has hidden SSID */
+    for (uIndex = 0; (pScanResultTable->uHiddenSsidNumber > 0) && (uIndex < pScanResultTable->uCurrentSiteNumber); uIndex++)
     {
         /* check if entry is with hidden SSID */
-        if ( (pScanResultTable->pTable[ uIndex ].ssid.len == 0) ||
-            ((pScanResultTable->pTable[ uIndex ].ssid.len == 1) && (pScanResultTable->pTable[ uIndex ].ssid.str[0] == 0)))
+        if (IS_HIDDEN_SSID(&pScanResultTable->pTable[ uIndex ].ssid))
         {
             TRACE1(pScanResultTable->hReport, REPORT_SEVERITY_INFORMATION , "scanResultTable_FindHidden: Entry found at index %d\n", uIndex);
             *uHiddenSsidIndex = uIndex;
@@ -498,6 +558,9 @@ static TI_STATUS scanResultTable_FindHidden (TScanResultTable *pScanResultTable,
  * \fn     scanResultTable_performAging 
  * \brief  Deletes from table all entries which are older than the Sra threshold
  * 
+ * The entries are checked from the oldest in the age list, up to the first one 
+ * which is not old, so only the deleted entries are visited.
+ * 
  * \param  hScanResultTable - handle to the scan result table object
  * \return None
  * \sa     scanResultTable_SetSraThreshold
@@ -505,26 +568,17 @@ static TI_STATUS scanResultTable_FindHidden (TScanResultTable *pScanResultTable,
 void   scanResultTable_PerformAging(TI_HANDLE hScanResultTable)
 {
     TScanResultTable    *pScanResultTable = (TScanResultTable*)hScanResultTable;
-    TI_UINT32           uIndex = 0;
+    TI_UINT32           uOldestTimeStamp = os_timeStampMs(pScanResultTable->hOS) - MILISECONDS(pScanResultTable->uSraThreshold);
+    TI_UINT32           uIndex;
 
-    /* check all entries in the table */
-    while (uIndex < pScanResultTable->uCurrentSiteNumber)
+    /* remove the oldest entry while it is old */
+    while ((uIndex = pScanResultTable->uAgeOldest) != SCAN_RESULT_NO_ENTRY)
     {
-        /* check if the entry's age is old if it remove it */
-        if (pScanResultTable->pTable[uIndex].localTimeStamp < 
-            os_timeStampMs(pScanResultTable->hOS) - MILISECONDS(pScanResultTable->uSraThreshold))
-        {
-            /* The removeEntry places the last entry instead of the deleted entry
-             * in order to preserve the table's continuity. For this reason the
-             * uIndex is not incremented because we want to check the entry that 
-             * was placed instead of the entry deleted */
-            scanResultTable_RemoveEntry(hScanResultTable, uIndex);
-        }
-        else
+        if (pScanResultTable->pTable[uIndex].localTimeStamp >= uOldestTimeStamp)
         {
-            /* If the entry was not deleted check the next entry */
-            uIndex++;
+            break;
         }
+        scanResultTable_RemoveEntry(hScanResultTable, uIndex);
     }
 }
 
@@ -548,6 +602,8 @@ void   scanResultTable_RemoveEntry(TI_HANDLE hScanResultTable, TI_UINT32 uIndex)
         return;
     }
 
+    scanResultTable_UnlinkEntry (pScanResultTable, uIndex);
+
     /* if uIndex is not the last entry, then copy the last entry in the table to the uIndex entry */
     if (uIndex < (pScanResultTable->uCurrentSiteNumber - 1))
     {
@@ -555,6 +611,7 @@ void   scanResultTable_RemoveEntry(TI_HANDLE hScanResultTable, TI_UINT32 uIndex)
                       &(pScanResultTable->pTable[uIndex]), 
                       &(pScanResultTable->pTable[pScanResultTable->uCurrentSiteNumber - 1]),
                       sizeof(TSiteEntry));
+        scanResultTable_MoveEntry (pScanResultTable, pScanResultTable->uCurrentSiteNumber - 1, uIndex);
     }
 
     /* clear the last entry */
@@ -563,6 +620,182 @@ void   scanResultTable_RemoveEntry(TI_HANDLE hScanResultTable, TI_UINT32 uIndex)
     pScanResultTable->uCurrentSiteNumber--;
 }
 
+/** 
+ * \fn     scanResultTable_Clear 
+ * \brief  Empties the table and its index
+ * 
+ * \param  pScanResultTable - the scan result table object
+ * \return None
+ */ 
+static void scanResultTable_Clear (TScanResultTable *pScanResultTable)
+{
+    TI_UINT32 uBucket;
+
+    for (uBucket = 0; uBucket <= pScanResultTable->uHashMask; uBucket++)
+    {
+        pScanResultTable->pHashHeads[ uBucket ] = SCAN_RESULT_NO_ENTRY;
+    }
+    pScanResultTable->uAgeOldest = SCAN_RESULT_NO_ENTRY;
+    pScanResultTable->uAgeNewest = SCAN_RESULT_NO_ENTRY;
+    pScanResultTable->uHiddenSsidNumber = 0;
+    pScanResultTable->uCurrentSiteNumber = 0;
+}
+
+/** 
+ * \fn     scanResultTable_Hash 
+ * \brief  Returns the hash bucket of an SSID and BSSID pair
+ * 
+ * \param  pScanResultTable - the scan result table object
+ * \param  pSsid - the SSID
+ * \param  pBssid - the BSSID
+ * \return The hash bucket
+ */ 
+static TI_UINT32 scanResultTable_Hash (TScanResultTable *pScanResultTable, TSsid *pSsid, TMacAddr *pBssid)
+{
+    TI_UINT32 uHash = 0;
+    TI_UINT32 i;
+
+    for (i = 0; i < MAC_ADDR_LEN; i++)
+    {
+        uHash = uHash * 31 + (*pBssid)[ i ];
+    }
+    for (i = 0; i < pSsid->len; i++)
+    {
+        uHash = uHash * 31 + (TI_UINT8)pSsid->str[ i ];
+    }
+    return (uHash ^ (uHash >> 16)) & pScanResultTable->uHashMask;
+}
+
+/** 
+ * \fn     scanResultTable_LinkEntry 
+ * \brief  Adds an entry to the index
+ * 
+ * Adds the entry to its SSID and BSSID hash bucket, and to the end of the age list 
+ * (as the most recently updated).
+ * 
+ * \param  pScanResultTable - the scan result table object
+ * \param  uIndex - index of the entry, which SSID and BSSID are set
+ * \return None
+ * \sa     scanResultTable_UnlinkEntry
+ */ 
+static void scanResultTable_LinkEntry (TScanResultTable *pScanResultTable, TI_UINT32 uIndex)
+{
+    TSiteEntry          *pSite = &(pScanResultTable->pTable[ uIndex ]);
+    TScanResultLinks    *pLinks = &(pScanResultTable->pLinks[ uIndex ]);
+
+    pLinks->uBucket = (TI_UINT16)scanResultTable_Hash (pScanResultTable, &pSite->ssid, &pSite->bssid);
+    pLinks->uHashNext = pScanResultTable->pHashHeads[ pLinks->uBucket ];
+    pScanResultTable->pHashHeads[ pLinks->uBucket ] = (TI_UINT16)uIndex;
+
+    pLinks->uAgePrev = pScanResultTable->uAgeNewest;
+    pLinks->uAgeNext = SCAN_RESULT_NO_ENTRY;
+    if (pScanResultTable->uAgeNewest != SCAN_RESULT_NO_ENTRY)
+    {
+        pScanResultTable->pLinks[ pScanResultTable->uAgeNewest ].uAgeNext = (TI_UINT16)uIndex;
+    }
+    else
+    {
+        pScanResultTable->uAgeOldest = (TI_UINT16)uIndex;
+    }
+    pScanResultTable->uAgeNewest = (TI_UINT16)uIndex;
+
+    if (IS_HIDDEN_SSID(&pSite->ssid))
+    {
+        pScanResultTable->uHiddenSsidNumber++;
+    }
+}
+
+/** 
+ * \fn     scanResultTable_UnlinkEntry 
+ * \brief  Removes an entry from the index
+ * 
+ * \param  pScanResultTable - the scan result table object
+ * \param  uIndex - index of the entry, as linked (its SSID and BSSID were not changed since)
+ * \return None
+ * \sa     scanResultTable_LinkEntry
+ */ 
+static void scanResultTable_UnlinkEntry (TScanResultTable *pScanResultTable, TI_UINT32 uIndex)
+{
+    TScanResultLinks    *pLinks = &(pScanResultTable->pLinks[ uIndex ]);
+    TI_UINT16           *pPrevNext;
+
+    for (pPrevNext = &(pScanResultTable->pHashHeads[ pLinks->uBucket ]); 
+         *pPrevNext != uIndex; 
+         pPrevNext = &(pScanResultTable->pLinks[ *pPrevNext ].uHashNext))
+    {
+        if (*pPrevNext == SCAN_RESULT_NO_ENTRY)
+        {
+            TRACE1(pScanResultTable->hReport, REPORT_SEVERITY_ERROR , "scanResultTable_UnlinkEntry: entry %d is not in its hash bucket\n", uIndex);
+            return;
+        }
+    }
+    *pPrevNext = pLinks->uHashNext;
+
+    if (pLinks->uAgePrev != SCAN_RESULT_NO_ENTRY)
+    {
+        pScanResultTable->pLinks[ pLinks->uAgePrev ].uAgeNext = pLinks->uAgeNext;
+    }
+    else
+    {
+        pScanResultTable->uAgeOldest = pLinks->uAgeNext;
+    }
+    if (pLinks->uAgeNext != SCAN_RESULT_NO_ENTRY)
+    {
+        pScanResultTable->pLinks[ pLinks->uAgeNext ].uAgePrev = pLinks->uAgePrev;
+    }
+    else
+    {
+        pScanResultTable->uAgeNewest = pLinks->uAgePrev;
+    }
+
+    if (IS_HIDDEN_SSID(&pScanResultTable->pTable[ uIndex ].ssid))
+    {
+        pScanResultTable->uHiddenSsidNumber--;
+    }
+}
+
+/** 
+ * \fn     scanResultTable_MoveEntry 
+ * \brief  Moves an entry links to another index
+ * 
+ * Called when an entry is copied to another place in the table, to keep it in the same 
+ * places in its hash bucket and the age list.
+ * 
+ * \param  pScanResultTable - the scan result table object
+ * \param  uFrom - the entry previous index
+ * \param  uTo - the entry new index (not linked)
+ * \return None
+ */ 
+static void scanResultTable_MoveEntry (TScanResultTable *pScanResultTable, TI_UINT32 uFrom, TI_UINT32 uTo)
+{
+    TScanResultLinks    *pLinks = &(pScanResultTable->pLinks[ uTo ]);
+    TI_UINT16           *pPrevNext;
+
+    *pLinks = pScanResultTable->pLinks[ uFrom ];
+
+    for (pPrevNext = &(pScanResultTable->pHashHeads[ pLinks->uBucket ]); 
+         *pPrevNext != uFrom; 
+         pPrevNext = &(pScanResultTable->pLinks[ *pPrevNext ].uHashNext));
+    *pPrevNext = (TI_UINT16)uTo;
+
+    if (pLinks->uAgePrev != SCAN_RESULT_NO_ENTRY)
+    {
+        pScanResultTable->pLinks[ pLinks->uAgePrev ].uAgeNext = (TI_UINT16)uTo;
+    }
+    else
+    {
+        pScanResultTable->uAgeOldest = (TI_UINT16)uTo;
+    }
+    if (pLinks->uAgeNext != SCAN_RESULT_NO_ENTRY)
+    {
+        pScanResultTable->pLinks[ pLinks->uAgeNext ].uAgePrev = (TI_UINT16)uTo;
+    }
+    else
+    {
+        pScanResultTable->uAgeNewest = (TI_UINT16)uTo;
+    }
+}
+
 /** 
  * \fn     scanresultTbale_AllocateNewEntry 
  * \brief  Allocates an empty entry for a new site
@@ -584,7 +817,10 @@ TSiteEntry *scanResultTbale_AllocateNewEntry (TI_HANDLE hScanResultTable)
         if (scanResultTable_FindHidden(pScanResultTable, &uHiddenSsidIndex) == TI_OK)
         {
             TRACE1(pScanResultTable->hReport, REPORT_SEVERITY_INFORMATION , "scanResultTbale_AllocateNewEntry: Table is full, found hidden SSID at index %d to replace with\n", uHiddenSsidIndex);
-            
+
+            /* Remove it from the index (the new site is indexed when its data is set) */
+            scanResultTable_UnlinkEntry (pScanResultTable, uHiddenSsidIndex);
+
             /* Nullify new site data */
             os_memoryZero(pScanResultTable->hOS, &(pScanResultTable->pTable[ uHiddenSsidIndex ]), sizeof (TSiteEntry));
 
@@ -657,7 +893,7 @@ void scanResultTable_UpdateSiteData (TI_HANDLE hScanResultTable, TSiteEntry *pSi
     UPDATE_RSSI (pSite, pFrame);
     UPDATE_SNR (pSite, pFrame);
     UPDATE_RATE (pSite, pFrame);
-	UPDATE_UNKOWN_IE(pScanResultTable, pSite, pFrame->parsedIEs->content.iePacket.pUnknownIe, pFrame->parsedIEs->content.iePacket.unknownIeLen );
+	UPDATE_UNKOWN_IE(pScanResultTable, pSite, pFrame);
 
     param.paramType = SITE_MGR_OPERATIONAL_MODE_PARAM;
     siteMgr_getParam (pScanResultTable->hSiteMgr, &param);
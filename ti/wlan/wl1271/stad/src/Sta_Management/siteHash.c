@@ -57,17 +57,89 @@
 	
 	This file implements the site hash mechanism. This mechanism is used for faster access to the sites information.
 	It is compound of the following:
-		1.	hash function	-	which maps the 4 last bits of the BSSID to an entry in the hash table.
+		1.	hash function	-	which maps the 3 last bytes of the BSSID to 4 bits, an entry in the hash table.
 		2.	hash table		-	each entry in the table points to a linked list of site entries
 		3.	site table		-	each entry holds a site information
 															
 	In order to find a site in the site table, we operate the hash function on the site's BSSID.
 	We receive a hash entry. We go over the linked list pointed by this hash entry until we find the site entry.
+
+	Each band's site table has its own hash table. The linked lists hold siteTable indexes (hashTable/hashNext);
+	a site is linked when it is inserted and unlinked when it is removed or aged out, so lookups by BSSID
+	never scan the whole site table.
 *****************************************************************************************************************/
 
 #define WLAN_NUM_OF_MISSED_SACNS_BEFORE_AGING 2
 
 
+/********************************************/
+/*		Hash Helpers						*/
+/********************************************/
+
+/* Link siteTable[index] at the head of its hash entry list */
+static void siteHash_link (siteTablesParams_t *pSiteTable, TI_UINT8 index)
+{
+	TI_UINT8	key = SITE_HASH_KEY(pSiteTable->siteTable[index].bssid);
+
+	pSiteTable->hashNext[index] = pSiteTable->hashTable[key];
+	pSiteTable->hashTable[key] = index;
+}
+
+/* Unlink siteTable[index] from its hash entry list, does nothing if it is not linked */
+static void siteHash_unlink (siteTablesParams_t *pSiteTable, TI_UINT8 index)
+{
+	TI_UINT8	*pLink = &pSiteTable->hashTable[SITE_HASH_KEY(pSiteTable->siteTable[index].bssid)];
+
+	while (*pLink != SITE_HASH_NIL)
+	{
+		if (*pLink == index)
+		{
+			*pLink = pSiteTable->hashNext[index];
+			pSiteTable->hashNext[index] = SITE_HASH_NIL;
+			return;
+		}
+		pLink = &pSiteTable->hashNext[*pLink];
+	}
+}
+
+/* Return the site with this BSSID in the given site table, NULL if not found */
+static siteEntry_t *siteHash_lookup (siteTablesParams_t *pSiteTable, TMacAddr *mac)
+{
+	TI_UINT8	index = pSiteTable->hashTable[SITE_HASH_KEY(*mac)];
+
+	while (index != SITE_HASH_NIL)
+	{
+		if (MAC_EQUAL (pSiteTable->siteTable[index].bssid, *mac))
+		{
+			return &(pSiteTable->siteTable[index]);
+		}
+		index = pSiteTable->hashNext[index];
+	}
+
+	return NULL;
+}
+
+/* Return the site table holding the site entry, NULL if none does */
+static siteTablesParams_t *siteHash_getSiteTable (siteMgr_t *pSiteMgr, siteEntry_t *pSiteEntry)
+{
+	siteTablesParams_t	*pSiteTable;
+
+	pSiteTable = &pSiteMgr->pSitesMgmtParams->dot11BG_sitesTables;
+	if ((pSiteEntry >= &pSiteTable->siteTable[0]) && (pSiteEntry < &pSiteTable->siteTable[pSiteTable->maxNumOfSites]))
+	{
+		return pSiteTable;
+	}
+
+	pSiteTable = (siteTablesParams_t *)&pSiteMgr->pSitesMgmtParams->dot11A_sitesTables;
+	if ((pSiteEntry >= &pSiteTable->siteTable[0]) && (pSiteEntry < &pSiteTable->siteTable[pSiteTable->maxNumOfSites]))
+	{
+		return pSiteTable;
+	}
+
+	return NULL;
+}
+
+
 /********************************************/
 /*		Functions Implementations			*/
 /********************************************/
@@ -113,6 +185,9 @@ TI_STATUS siteMgr_resetSiteTable(TI_HANDLE	hSiteMgr, siteTablesParams_t	*pSiteTa
         pSiteTableParams->siteTable[i].dtimPeriod = 1;
 	}
 
+	os_memorySet(pSiteMgr->hOs, pSiteTableParams->hashTable, SITE_HASH_NIL, sizeof(pSiteTableParams->hashTable));
+	os_memorySet(pSiteMgr->hOs, pSiteTableParams->hashNext, SITE_HASH_NIL, sizeof(pSiteTableParams->hashNext));
+
 	pSiteTableParams->numOfSites = 0;
 
 	pSiteMgr->pSitesMgmtParams->pPrimarySite = NULL;
@@ -143,7 +218,7 @@ siteEntry_t	*findSiteEntry(siteMgr_t		*pSiteMgr,
 {
     siteTablesParams_t      *pCurrentSiteTable = pSiteMgr->pSitesMgmtParams->pCurrentSiteTable;
 	siteEntry_t             *pSiteEntry;	
-    TI_UINT8                 tableIndex=2, i;
+    TI_UINT8                 tableIndex=2;
 
    /* It looks like it never happens. Anyway decided to check */
     if ( pCurrentSiteTable->maxNumOfSites > MAX_SITES_BG_BAND )
@@ -158,18 +233,13 @@ siteEntry_t	*findSiteEntry(siteMgr_t		*pSiteMgr,
     do
 	{
         tableIndex--;
-		for (i = 0; i < pCurrentSiteTable->maxNumOfSites; i++)
-	    {
-			pSiteEntry = &(pCurrentSiteTable->siteTable[i]);
-        
-	    	if (MAC_EQUAL (pSiteEntry->bssid, *mac))
-	    	{
-                TRACE6(pSiteMgr->hReport, REPORT_SEVERITY_INFORMATION,
-                     "FIND success, bssid: %X-%X-%X-%X-%X-%X\n\n", (*mac)[0], (*mac)[1], (*mac)[2], (*mac)[3], (*mac)[4], (*mac)[5]);
-	    		return pSiteEntry;
-	    	}
-
-	    }
+		pSiteEntry = siteHash_lookup (pCurrentSiteTable, mac);
+		if (pSiteEntry != NULL)
+		{
+			TRACE6(pSiteMgr->hReport, REPORT_SEVERITY_INFORMATION,
+				 "FIND success, bssid: %X-%X-%X-%X-%X-%X\n\n", (*mac)[0], (*mac)[1], (*mac)[2], (*mac)[3], (*mac)[4], (*mac)[5]);
+			return pSiteEntry;
+		}
 	   if ((pSiteMgr->pDesiredParams->siteMgrDesiredDot11Mode == DOT11_DUAL_MODE) &&
            (tableIndex==1))
 	   {   /* change site table */
@@ -259,19 +329,21 @@ siteEntry_t	*findAndInsertSiteEntry(siteMgr_t		*pSiteMgr,
         handleRunProblem(PROBLEM_BUF_SIZE_VIOLATION);
         return NULL;
     }
-    /* Loop all the sites till the desired MAC is found */
+    /* Look for the desired MAC in its hash entry */
+    pSiteEntry = siteHash_lookup (pCurrentSiteTable, mac);
+    if (pSiteEntry != NULL)
+    {
+        TRACE6(pSiteMgr->hReport, REPORT_SEVERITY_INFORMATION, "FIND success, bssid: %X-%X-%X-%X-%X-%X\n\n", (*mac)[0], (*mac)[1], (*mac)[2], (*mac)[3], (*mac)[4], (*mac)[5]);
+
+        return pSiteEntry;
+    }
+
+    /* Not found - loop all the sites for the first empty site and the oldest one */
     for (i = 0; i < pCurrentSiteTable->maxNumOfSites; i++)
     {
         pSiteEntry = &(pCurrentSiteTable->siteTable[i]);
 		
-        if (MAC_EQUAL (pSiteEntry->bssid, *mac))
-		{
-
-            TRACE6(pSiteMgr->hReport, REPORT_SEVERITY_INFORMATION, "FIND success, bssid: %X-%X-%X-%X-%X-%X\n\n", (*mac)[0], (*mac)[1], (*mac)[2], (*mac)[3], (*mac)[4], (*mac)[5]);
-
-            return pSiteEntry;
-        }
-        else if (pSiteEntry->siteType == SITE_NULL)
+        if (pSiteEntry->siteType == SITE_NULL)
         {   /* Save the first empty site, in case the
             desired MAC is not found */
             if (!firstEmptySiteFound)
@@ -308,8 +380,12 @@ siteEntry_t	*findAndInsertSiteEntry(siteMgr_t		*pSiteMgr,
 
 	pSiteEntry = &(pCurrentSiteTable->siteTable[emptySiteIndex]);
 
+	/* An entry inserted but never updated is still SITE_NULL, unlink it before reuse */
+	siteHash_unlink (pCurrentSiteTable, emptySiteIndex);
+
 	/* fill the entry with the station mac */
 	MAC_COPY (pSiteEntry->bssid, *mac);
+	siteHash_link (pCurrentSiteTable, emptySiteIndex);
 
     /* Some parameters have to be initialized immediately after entry allocation */
 
@@ -342,6 +418,7 @@ void removeSiteEntry(siteMgr_t  *pSiteMgr,
                      siteEntry_t         *pSiteEntry)
 {
 	TI_UINT8			index; 
+	siteTablesParams_t	*pSiteTable;
 
 	if (pSiteEntry == NULL)
 	{
@@ -359,7 +436,13 @@ TRACE6(pSiteMgr->hReport, REPORT_SEVERITY_INFORMATION, "removeSiteEntry REMOVE s
 
 	pCurrSiteTblParams->numOfSites--;
 		
-	/* Now remove (exclude) hashPtr entry from the linked list */
+	/* Now remove (exclude) hashPtr entry from the linked list. The caller may pass
+	   the current site table rather than the one holding the site, so look it up */
+	pSiteTable = siteHash_getSiteTable (pSiteMgr, pSiteEntry);
+	if (pSiteTable != NULL)
+	{
+		siteHash_unlink (pSiteTable, (TI_UINT8)(pSiteEntry - &pSiteTable->siteTable[0]));
+	}
 
 TRACE6(pSiteMgr->hReport, REPORT_SEVERITY_INFORMATION, "REMOVAL success, bssid: %X-%X-%X-%X-%X-%X\n\n", pSiteEntry->bssid[0], pSiteEntry->bssid[1], pSiteEntry->bssid[2], pSiteEntry->bssid[3], pSiteEntry->bssid[4], pSiteEntry->bssid[5]);
 TRACE1(pSiteMgr->hReport, REPORT_SEVERITY_INFORMATION, " SITE TABLE remaining entries number  %d \n", pCurrSiteTblParams->numOfSites);
@@ -382,3 +465,39 @@ TRACE1(pSiteMgr->hReport, REPORT_SEVERITY_INFORMATION, " SITE TABLE remaining en
 	return;
 }
 
+/************************************************************************
+ *                        updateSiteEntryBssid							*
+ ************************************************************************
+DESCRIPTION: Change the BSSID of a site entry and move the entry to the 
+			 hash entry of the new BSSID. The BSSID of a site in the site 
+			 table must not be changed in any other way.
+                                                                                                   
+INPUT:      pSiteMgr		- Handle to site mgr
+            pSiteEntry		- Pointer to the site entry      
+            bssid			- The new BSSID
+
+
+OUTPUT:		
+
+RETURN:     
+
+************************************************************************/
+void updateSiteEntryBssid(siteMgr_t		*pSiteMgr, 
+						  siteEntry_t	*pSiteEntry,
+						  TMacAddr		*bssid)
+{
+	siteTablesParams_t	*pSiteTable = siteHash_getSiteTable (pSiteMgr, pSiteEntry);
+	TI_UINT8			index;
+
+	if (pSiteTable == NULL)
+	{
+		MAC_COPY (pSiteEntry->bssid, *bssid);
+		return;
+	}
+
+	index = (TI_UINT8)(pSiteEntry - &pSiteTable->siteTable[0]);
+	siteHash_unlink (pSiteTable, index);
+	MAC_COPY (pSiteEntry->bssid, *bssid);
+	siteHash_link (pSiteTable, index);
+}
+
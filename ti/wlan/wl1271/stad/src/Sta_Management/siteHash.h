@@ -59,10 +59,23 @@
     and data used to manage the site table and hash table */
 typedef TSiteEntry siteEntry_t;
 
+/* BSSID hash: the XOR of the 3 last BSSID bytes, folded to SITE_HASH_SIZE buckets */
+#define SITE_HASH_SIZE          16
+#define SITE_HASH_NIL           0xFF
+#define SITE_HASH_MAX_SITES     ((MAX_SITES_BG_BAND > MAX_SITES_A_BAND) ? MAX_SITES_BG_BAND : MAX_SITES_A_BAND)
+#define SITE_HASH_KEY(mac)      ((((TI_UINT8*)(mac))[3] ^ ((TI_UINT8*)(mac))[4] ^ ((TI_UINT8*)(mac))[5]) & (SITE_HASH_SIZE - 1))
+
+/*
+ * The hash fields must stay ahead of siteTable and identical in both structs below,
+ * since the A band table is accessed through a (siteTablesParams_t *) cast.
+ * Both hold siteTable indexes, SITE_HASH_NIL terminates a bucket chain.
+ */
 typedef struct
 {
     TI_UINT8           numOfSites;
     TI_UINT8           maxNumOfSites;
+    TI_UINT8           hashTable[SITE_HASH_SIZE];       /* first site of each bucket */
+    TI_UINT8           hashNext[SITE_HASH_MAX_SITES];   /* next site in the same bucket */
     siteEntry_t        siteTable[MAX_SITES_BG_BAND];
 }siteTablesParams_t;
 
@@ -71,6 +84,8 @@ typedef struct
 {
     TI_UINT8           numOfSites;
     TI_UINT8           maxNumOfSites;
+    TI_UINT8           hashTable[SITE_HASH_SIZE];
+    TI_UINT8           hashNext[SITE_HASH_MAX_SITES];
     siteEntry_t        siteTable[MAX_SITES_A_BAND];
 }siteTablesParamsBandA_t;
 
@@ -159,6 +174,8 @@ siteEntry_t *findSiteEntry(siteMgr_t        *pSiteMgr,
 void removeSiteEntry(siteMgr_t *pSiteMgr, siteTablesParams_t *pCurrSiteTblParams,
                      siteEntry_t  *hashPtr);
 
+void updateSiteEntryBssid(siteMgr_t *pSiteMgr, siteEntry_t *pSiteEntry, TMacAddr *bssid);
+
 TI_STATUS removeEldestSite(siteMgr_t *pSiteMgr);
 
 TI_STATUS buildProbeReqTemplate(siteMgr_t *pSiteMgr, TSetTemplate *pTemplate, TSsid *pSsid, ERadioBand radioBand);
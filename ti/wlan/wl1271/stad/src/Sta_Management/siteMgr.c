@@ -1679,7 +1679,8 @@ TRACE6(pSiteMgr->hReport, REPORT_SEVERITY_ERROR, "siteMgr_IbssMerge, cannot find
 	pSite->siteType = SITE_PRIMARY;
 	pSiteMgr->pSitesMgmtParams->pPrimarySite = pSite;
     
-	MAC_COPY(pSite->bssid, new_bssid);
+	/* move the site to the hash entry of its new BSSID */
+	updateSiteEntryBssid(pSiteMgr, pSite, (TMacAddr*)new_bssid);
     
 	Param.paramType   = SITE_MGR_DESIRED_BSSID_PARAM;
     Param.paramLength = sizeof(TMacAddr);
@@ -0,0 +1,214 @@
+LOCAL_PATH:= $(call my-dir)
+
+#
+# Host unit tests, benchmarks and tools of driver modules. They build the
+# module sources as they are, with hostOs.c standing in for the OS abstraction.
+#
+WILINK_ROOT = ..
+
+WILINK_HOST_TEST_INCLUDES = \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/stad/Export_Inc \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/utils \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/platforms/os/common/inc \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/platforms/os/linux/src \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/platforms/os/linux/inc \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/platforms/hw/linux \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/TWD \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/TWD/Ctrl \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/TWD/Data_Service/Export_Inc \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/TWD/FW_Transfer/Export_Inc \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/TWD/FW_Transfer \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/TWD/Ctrl/Export_Inc \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/TWD/MacServices/Export_Inc \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/TWD/FirmwareApi \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/TWD/TwIf \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/TWD/MacServices \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/TWD/TWDriver \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/Txn \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/stad/src/AirLink_Managment \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/stad/src/Application \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/stad/src/Connection_Managment \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/stad/src/Ctrl_Interface \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/stad/src/Data_link \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/stad/src/Sta_Management \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/stad/src/core/EvHandler \
+	$(LOCAL_PATH)/$(WILINK_ROOT)/Test
+
+WILINK_HOST_TEST_CFLAGS = -O2 -g -Wall -D__LINUX__ -D__BYTE_ORDER_LITTLE_ENDIAN \
+	-DHOST_COMPILE -DFW_RUNNING_AS_STA -DTNETW1273
+
+# the site tables are raised to a dense environment size
+SITE_HASH_TEST_CFLAGS = -DMAX_SITES_BG_BAND=128 -DMAX_SITES_A_BAND=64
+
+# as the driver build (common.inc), the queues rely on it to be re-enqueued
+TXNQ_TEST_CFLAGS = -DTI_DBG
+
+# the timers expiry queues too
+TIMER_TEST_CFLAGS = $(TXNQ_TEST_CFLAGS)
+
+# the OS abstraction sources include kernel headers, which host/ stands in for
+WILINK_HOST_KERNEL_INCLUDES = $(LOCAL_PATH)/host
+
+# the ini file of the source tree, when none is given
+RGSTRY_TEST_CFLAGS = -DRGSTRY_TEST_INI=\"$(LOCAL_PATH)/$(WILINK_ROOT)/config/tiwlan.ini\"
+
+# as the driver build (common.inc), so the snapshot table is the one the driver parses
+RGSTRY_SNAPSHOT_CFLAGS = -DTI_DBG -fsigned-char
+
+#
+# Site table BSSID hash
+#
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	siteHash_test.c \
+	hostOs.c \
+	$(WILINK_ROOT)/stad/src/Sta_Management/siteHash.c
+
+LOCAL_C_INCLUDES:= $(WILINK_HOST_TEST_INCLUDES)
+LOCAL_CFLAGS:= $(WILINK_HOST_TEST_CFLAGS) $(SITE_HASH_TEST_CFLAGS)
+LOCAL_MODULE:= wl1271_sitehash_test
+LOCAL_MODULE_TAGS:= tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	siteHash_bench.c \
+	hostOs.c \
+	$(WILINK_ROOT)/stad/src/Sta_Management/siteHash.c
+
+LOCAL_C_INCLUDES:= $(WILINK_HOST_TEST_INCLUDES)
+LOCAL_CFLAGS:= $(WILINK_HOST_TEST_CFLAGS) $(SITE_HASH_TEST_CFLAGS)
+LOCAL_LDLIBS += -lrt
+LOCAL_MODULE:= wl1271_sitehash_bench
+LOCAL_MODULE_TAGS:= tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+#
+# TxnQ scheduling and aggregation, over a simulated SDIO adapter
+#
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	txnQ_test.c \
+	sdioAdaptSim.c \
+	hostOs.c \
+	$(WILINK_ROOT)/Txn/TxnQueue.c \
+	$(WILINK_ROOT)/Txn/SdioBusDrv.c \
+	$(WILINK_ROOT)/utils/queue.c
+
+LOCAL_C_INCLUDES:= $(WILINK_HOST_TEST_INCLUDES)
+LOCAL_CFLAGS:= $(WILINK_HOST_TEST_CFLAGS) $(TXNQ_TEST_CFLAGS)
+LOCAL_MODULE:= wl1271_txnq_test
+LOCAL_MODULE_TAGS:= tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	txnQ_bench.c \
+	sdioAdaptSim.c \
+	hostOs.c \
+	$(WILINK_ROOT)/Txn/TxnQueue.c \
+	$(WILINK_ROOT)/Txn/SdioBusDrv.c \
+	$(WILINK_ROOT)/utils/queue.c
+
+LOCAL_C_INCLUDES:= $(WILINK_HOST_TEST_INCLUDES)
+LOCAL_CFLAGS:= $(WILINK_HOST_TEST_CFLAGS) $(TXNQ_TEST_CFLAGS)
+LOCAL_MODULE:= wl1271_txnq_bench
+LOCAL_MODULE_TAGS:= tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+#
+# Scan result table index and aging, over synthetic scan floods
+#
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	scanResultTable_test.c \
+	hostOs.c \
+	$(WILINK_ROOT)/stad/src/Sta_Management/scanResultTable.c \
+	$(WILINK_ROOT)/utils/rate.c \
+	$(WILINK_ROOT)/utils/freq.c
+
+LOCAL_C_INCLUDES:= $(WILINK_HOST_TEST_INCLUDES)
+LOCAL_CFLAGS:= $(WILINK_HOST_TEST_CFLAGS)
+LOCAL_MODULE:= wl1271_scanresult_test
+LOCAL_MODULE_TAGS:= tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+#
+# Beacon and probe response IE parsing, over built and fuzzed frames
+#
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	mlmeParser_test.c \
+	hostOs.c \
+	$(WILINK_ROOT)/stad/src/Sta_Management/mlmeParser.c
+
+LOCAL_C_INCLUDES:= $(WILINK_HOST_TEST_INCLUDES)
+LOCAL_CFLAGS:= $(WILINK_HOST_TEST_CFLAGS)
+LOCAL_LDLIBS += -lrt
+LOCAL_MODULE:= wl1271_mlmeparser_test
+LOCAL_MODULE_TAGS:= tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+#
+# Registry keys index and snapshot, over the ini files, and the snapshot compiler
+#
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	osRgstry_test.c \
+	hostOs.c \
+	$(WILINK_ROOT)/platforms/os/linux/src/osRgstry_parser.c \
+	$(WILINK_ROOT)/platforms/os/common/src/osRgstry.c
+
+LOCAL_C_INCLUDES:= $(WILINK_HOST_KERNEL_INCLUDES) $(WILINK_HOST_TEST_INCLUDES)
+LOCAL_CFLAGS:= $(WILINK_HOST_TEST_CFLAGS) $(RGSTRY_TEST_CFLAGS)
+LOCAL_LDLIBS += -lrt
+LOCAL_MODULE:= wl1271_rgstry_test
+LOCAL_MODULE_TAGS:= tests
+
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	rgstrySnapshot.c \
+	hostOs.c \
+	$(WILINK_ROOT)/platforms/os/linux/src/osRgstry_parser.c \
+	$(WILINK_ROOT)/platforms/os/common/src/osRgstry.c
+
+LOCAL_C_INCLUDES:= $(WILINK_HOST_KERNEL_INCLUDES) $(WILINK_HOST_TEST_INCLUDES)
+LOCAL_CFLAGS:= $(WILINK_HOST_TEST_CFLAGS) $(RGSTRY_SNAPSHOT_CFLAGS)
+LOCAL_MODULE:= wl1271_rgstry_snapshot
+LOCAL_MODULE_TAGS:= optional
+
+include $(BUILD_HOST_EXECUTABLE)
+
+#
+# Timers wheel, over thousands of timers on a virtual clock
+#
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+	timer_test.c \
+	hostOs.c \
+	$(WILINK_ROOT)/utils/timer.c \
+	$(WILINK_ROOT)/utils/queue.c
+
+LOCAL_C_INCLUDES:= $(WILINK_HOST_TEST_INCLUDES)
+LOCAL_CFLAGS:= $(WILINK_HOST_TEST_CFLAGS) $(TIMER_TEST_CFLAGS)
+LOCAL_MODULE:= wl1271_timer_test
+LOCAL_MODULE_TAGS:= tests
+
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,275 @@
+/*
+ * hostOs.c
+ *
+ * Copyright(c) 1998 - 2010 Texas Instruments. All rights reserved.      
+ * All rights reserved.                                                  
+ *                                                                       
+ * Redistribution and use in source and binary forms, with or without    
+ * modification, are permitted provided that the following conditions    
+ * are met:                                                              
+ *                                                                       
+ *  * Redistributions of source code must retain the above copyright     
+ *    notice, this list of conditions and the following disclaimer.      
+ *  * Redistributions in binary form must reproduce the above copyright  
+ *    notice, this list of conditions and the following disclaimer in    
+ *    the documentation and/or other materials provided with the         
+ *    distribution.                                                      
+ *  * Neither the name Texas Instruments nor the names of its            
+ *    contributors may be used to endorse or promote products derived    
+ *    from this software without specific prior written permission.      
+ *                                                                       
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT  
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT      
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT   
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file hostOs.c
+ *  \brief Host build of the OS abstraction services used by the driver unit tests
+ *
+ *  Only what the tested modules call is provided here. Traces are compiled in
+ *  but never printed since the tests run without a report module (hReport is NULL).
+ *
+ *  \see osApi.h
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "tidef.h"
+#include "report.h"
+#include "osApi.h"
+#include "context.h"
+
+
+/* Allocations left to fail, so the tests can take the modules allocation failure paths */
+static TI_UINT32 uFailAllocs;
+
+void *os_memoryAlloc (TI_HANDLE OsContext, TI_UINT32 Size)
+{
+	if (uFailAllocs)
+	{
+		uFailAllocs--;
+		return NULL;
+	}
+	return malloc (Size);
+}
+
+void hostOs_FailAllocs (TI_UINT32 uCount)
+{
+	uFailAllocs = uCount;
+}
+
+void os_memoryFree (TI_HANDLE OsContext, void *pMemPtr, TI_UINT32 Size)
+{
+	free (pMemPtr);
+}
+
+void os_memoryZero (TI_HANDLE OsContext, void *pMemPtr, TI_UINT32 Length)
+{
+	memset (pMemPtr, 0, Length);
+}
+
+void os_memorySet (TI_HANDLE OsContext, void *pMemPtr, TI_INT32 Value, TI_UINT32 Length)
+{
+	memset (pMemPtr, Value, Length);
+}
+
+void os_memoryCopy (TI_HANDLE OsContext, void *pDestination, void *pSource, TI_UINT32 Size)
+{
+	memmove (pDestination, pSource, Size);
+}
+
+TI_INT32 os_memoryCompare (TI_HANDLE OsContext, TI_UINT8* Buf1, TI_UINT8* Buf2, TI_INT32 Count)
+{
+	return memcmp (Buf1, Buf2, Count);
+}
+
+/* Added to the time stamps, so the tests can let minutes pass */
+static TI_UINT32 uTimeOffsetMs;
+
+/* When stopped, the time stamps move only as the tests advance them */
+static TI_BOOL bClockStopped;
+
+TI_UINT32 os_timeStampMs (TI_HANDLE OsContext)
+{
+	struct timeval tv;
+
+	if (bClockStopped)
+	{
+		return uTimeOffsetMs;
+	}
+
+	gettimeofday (&tv, NULL);
+	return (TI_UINT32)(tv.tv_sec * 1000 + tv.tv_usec / 1000) + uTimeOffsetMs;
+}
+
+void hostOs_AdvanceTime (TI_UINT32 uMs)
+{
+	uTimeOffsetMs += uMs;
+}
+
+void hostOs_StopClock (TI_UINT32 uStartMs)
+{
+	bClockStopped = TI_TRUE;
+	uTimeOffsetMs = uStartMs;
+}
+
+/* The OS timers fire only when the tests run them, at the time stamps they were started for */
+typedef struct _THostTimer
+{
+	struct _THostTimer *pNext;
+	fTimerFunction      fRoutine;
+	TI_HANDLE           hFuncHandle;
+	TI_BOOL             bArmed;
+	TI_UINT32           uDueMs;
+} THostTimer;
+
+static THostTimer *pHostTimers;
+static TI_BOOL     bHostTimerCreateFails;
+
+/* Make the following OS timer allocations fail (or succeed again) */
+void hostOs_FailTimerCreate (TI_BOOL bFail)
+{
+	bHostTimerCreateFails = bFail;
+}
+
+TI_HANDLE os_timerCreate (TI_HANDLE OsContext, fTimerFunction pRoutine, TI_HANDLE hFuncHandle)
+{
+	THostTimer *pTimer;
+
+	if (bHostTimerCreateFails)
+	{
+		return NULL;
+	}
+
+	pTimer = os_memoryAlloc (OsContext, sizeof(THostTimer));
+	if (pTimer)
+	{
+		memset (pTimer, 0, sizeof(THostTimer));
+		pTimer->fRoutine    = pRoutine;
+		pTimer->hFuncHandle = hFuncHandle;
+		pTimer->pNext       = pHostTimers;
+		pHostTimers = pTimer;
+	}
+	return (TI_HANDLE)pTimer;
+}
+
+void os_timerDestroy (TI_HANDLE OsContext, TI_HANDLE TimerHandle)
+{
+	THostTimer **ppTimer;
+
+	for (ppTimer = &pHostTimers; *ppTimer; ppTimer = &(*ppTimer)->pNext)
+	{
+		if (*ppTimer == (THostTimer *)TimerHandle)
+		{
+			*ppTimer = (*ppTimer)->pNext;
+			break;
+		}
+	}
+	os_memoryFree (OsContext, TimerHandle, sizeof(THostTimer));
+}
+
+void os_timerStart (TI_HANDLE OsContext, TI_HANDLE TimerHandle, TI_UINT32 DelayMs)
+{
+	THostTimer *pTimer = (THostTimer *)TimerHandle;
+
+	pTimer->bArmed = TI_TRUE;
+	pTimer->uDueMs = os_timeStampMs (OsContext) + DelayMs;
+}
+
+void os_timerStop (TI_HANDLE OsContext, TI_HANDLE TimerHandle)
+{
+	((THostTimer *)TimerHandle)->bArmed = TI_FALSE;
+}
+
+/* Fire the OS timers due by now, and return how many fired */
+TI_UINT32 hostOs_RunTimers (void)
+{
+	THostTimer *pTimer;
+	TI_UINT32   uNow = os_timeStampMs (NULL);
+	TI_UINT32   uFired = 0;
+
+	for (pTimer = pHostTimers; pTimer; pTimer = pTimer->pNext)
+	{
+		if (pTimer->bArmed && (TI_INT32)(uNow - pTimer->uDueMs) >= 0)
+		{
+			pTimer->bArmed = TI_FALSE;
+			pTimer->fRoutine (pTimer->hFuncHandle);
+			uFired++;
+		}
+	}
+	return uFired;
+}
+
+/* Get the time stamp the earliest armed OS timer is due at, or FALSE if none is armed */
+TI_BOOL hostOs_NextTimer (TI_UINT32 *pDueMs)
+{
+	THostTimer *pTimer;
+	TI_BOOL     bFound = TI_FALSE;
+
+	for (pTimer = pHostTimers; pTimer; pTimer = pTimer->pNext)
+	{
+		if (pTimer->bArmed && (!bFound || (TI_INT32)(pTimer->uDueMs - *pDueMs) < 0))
+		{
+			*pDueMs = pTimer->uDueMs;
+			bFound = TI_TRUE;
+		}
+	}
+	return bFound;
+}
+
+void os_printf (const char *format ,...)
+{
+	va_list args;
+
+	va_start (args, format);
+	vprintf (format, args);
+	va_end (args);
+}
+
+void os_Trace (TI_HANDLE OsContext, TI_UINT32 uLevel, TI_UINT32 uFileId, TI_UINT32 uLineNum, TI_UINT32 uParamsNum, ...)
+{
+}
+
+/*
+ * The tests run in one context, so there is nothing to protect, but the driver's critical
+ *   section is a non-recursive spinlock, so entering it while held (or leaving it when not
+ *   held) would hang or corrupt the driver and fails the test here.
+ */
+static int iCriticalSectionDepth = 0;
+
+void context_EnterCriticalSection (TI_HANDLE hContext)
+{
+	if (iCriticalSectionDepth)
+	{
+		printf ("context_EnterCriticalSection: ERROR - already in critical section!\n");
+		abort ();
+	}
+	iCriticalSectionDepth++;
+}
+
+void context_LeaveCriticalSection (TI_HANDLE hContext)
+{
+	if (!iCriticalSectionDepth)
+	{
+		printf ("context_LeaveCriticalSection: ERROR - not in critical section!\n");
+		abort ();
+	}
+	iCriticalSectionDepth--;
+}
+
+void handleRunProblem (EProblemType prType)
+{
+	printf ("handleRunProblem: problem type %d\n", prType);
+	abort ();
+}
@@ -0,0 +1,780 @@
+/*
+ * mlmeParser_test.c
+ *
+ * Copyright(c) 1998 - 2010 Texas Instruments. All rights reserved.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *  * Neither the name Texas Instruments nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file mlmeParser_test.c
+ *  \brief Host unit test of the beacon and probe response IEs parsing
+ *
+ *  Parses hand built frames and checks each parsed IE, then parses random and
+ *  mutated IE sequences, each in a heap buffer of its exact size (so a build with
+ *  -fsanitize=address catches any read beyond the frame), and checks that every
+ *  parsed IE is within the frame or the parser buffers. Last, times typical beacons
+ *  through mlmeParser_recv and reports the beacons per second.
+ *
+ *      wl1271_mlmeparser_test [fuzz frames] [seed] [beacons]
+ *
+ *  \see mlmeParser.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "tidef.h"
+#include "report.h"
+#include "osApi.h"
+#include "paramOut.h"
+#include "DataCtrl_Api.h"
+#include "mlmeApi.h"
+#include "mlmeSm.h"
+#include "AssocSM.h"
+#include "authSm.h"
+#include "measurementMgrApi.h"
+#include "ScanCncn.h"
+#include "currBss.h"
+#include "apConn.h"
+#include "SwitchChannelApi.h"
+#include "regulatoryDomainApi.h"
+#include "qosMngr_API.h"
+#include "RxBuf.h"
+
+
+#define TEST_CHANNEL        6
+#define MAX_TEST_BODY       1024
+
+static mlme_t               tMlme;
+static int                  iErrors;
+
+/* what the MLME parser passed on */
+static TI_UINT32            uScanResults;
+static TI_UINT32            uScanInvalid;
+static TI_UINT32            uChannelSwitches;
+static TI_UINT32            uBufsFreed;
+static TI_UINT8             aScanUnknownIes[MAX_BEACON_BODY_LENGTH];
+static TI_UINT16            uScanUnknownIesLen;
+static char                 aScanSsid[MAX_SSID_LEN + 1];
+
+static TMacAddr             tCurrentBssid = {0x00, 0x1b, 0x2f, 0x00, 0x00, 0x01};
+
+#define CHECK(cond) \
+	do { if (!(cond)) { printf ("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); iErrors++; } } while (0)
+
+
+/*
+ * The services the MLME parser calls
+ */
+int WMEQosTagToACTable[MAX_NUM_OF_802_1d_TAGS];
+
+TI_STATUS ctrlData_getParam (TI_HANDLE hCtrlData, paramInfo_t *pParamInfo)
+{
+	if (pParamInfo->paramType == CTRL_DATA_CURRENT_BSSID_PARAM)
+	{
+		MAC_COPY (pParamInfo->content.ctrlDataCurrentBSSID, tCurrentBssid);
+	}
+	else
+	{
+		memset (&pParamInfo->content, 0, sizeof(pParamInfo->content));
+	}
+	return TI_OK;
+}
+
+/* as the scan result table, which copies the unknown IEs of each result */
+void scanCncn_MlmeResultCB (TI_HANDLE hScanCncn, TMacAddr* bssid, mlmeFrameInfo_t* frameInfo,
+							TRxAttr* pRxAttr, TI_UINT8* buffer, TI_UINT16 bufferLength)
+{
+	dot11_SSID_t *pSsid;
+
+	if (frameInfo == NULL)
+	{
+		uScanInvalid++;
+		return;
+	}
+	uScanResults++;
+
+	pSsid = frameInfo->content.iePacket.pSsid;
+	aScanSsid[0] = '\0';
+	if (pSsid != NULL)
+	{
+		memcpy (aScanSsid, pSsid->serviceSetId, pSsid->hdr[1]);
+		aScanSsid[pSsid->hdr[1]] = '\0';
+	}
+	uScanUnknownIesLen = mlmeParser_CopyUnknownIes (NULL, &frameInfo->content.iePacket, aScanUnknownIes, sizeof(aScanUnknownIes));
+}
+
+TI_STATUS currBSS_beaconReceivedCallb (TI_HANDLE hCurrBSS, TRxAttr *pRxAttr, TMacAddr *bssid,
+									   mlmeFrameInfo_t *pFrameInfo, TI_UINT8 *dataBuffer, TI_UINT16 bufLength)
+{
+	return TI_OK;
+}
+
+TI_STATUS currBSS_probRespReceivedCallb (TI_HANDLE hCurrBSS, TRxAttr *pRxAttr, TMacAddr *bssid,
+										 mlmeFrameInfo_t *pFrameInfo, TI_UINT8 *dataBuffer, TI_UINT16 bufLength)
+{
+	return TI_OK;
+}
+
+void measurementMgr_mlmeResultCB (TI_HANDLE hMeasurementMgr, TMacAddr *bssid, mlmeFrameInfo_t *frameInfo,
+								  TRxAttr *pRxAttr, TI_UINT8 *buffer, TI_UINT16 bufferLength)
+{
+}
+
+void switchChannel_recvCmd (TI_HANDLE hSwitchChannel, dot11_CHANNEL_SWITCH_t *channelSwitch, TI_UINT8 channel)
+{
+	if (channelSwitch != NULL)
+	{
+		uChannelSwitches++;
+	}
+}
+
+TI_STATUS regulatoryDomain_setParam (TI_HANDLE hRegulatoryDomain, paramInfo_t *pParam)
+{
+	return TI_OK;
+}
+
+/* the frames are owned by the test */
+void RxBufFree (TI_HANDLE hOs, void *pBuf)
+{
+	uBufsFreed++;
+}
+
+TI_STATUS assoc_recv (TI_HANDLE hAssoc, mlmeFrameInfo_t *pFrame)
+{
+	return TI_OK;
+}
+
+TI_STATUS assoc_saveAssocRespMessage (assoc_t *pAssocSm, TI_UINT8 *pAssocBuffer, TI_UINT32 length)
+{
+	return TI_OK;
+}
+
+TI_STATUS auth_recv (TI_HANDLE hAuth, mlmeFrameInfo_t *pFrame)
+{
+	return TI_OK;
+}
+
+TI_STATUS apConn_reportRoamingEvent (TI_HANDLE hAPConnection, apConn_roamingTrigger_e roamingEventType,
+									 roamingEventData_u *pRoamingEventData)
+{
+	return TI_OK;
+}
+
+TI_STATUS QosMngr_receiveActionFrames (TI_HANDLE hQosMngr, TI_UINT8* pData, TI_UINT8 action, TI_UINT32 bodyLen)
+{
+	return TI_OK;
+}
+
+
+/*
+ * Frames building
+ */
+static TI_UINT32 addIe (TI_UINT8 *pBody, TI_UINT32 uLen, TI_UINT8 uId, const TI_UINT8 *pData, TI_UINT8 uIeLen)
+{
+	pBody[uLen] = uId;
+	pBody[uLen + 1] = uIeLen;
+	if (pData != NULL)
+	{
+		memcpy (pBody + uLen + 2, pData, uIeLen);
+	}
+	else
+	{
+		memset (pBody + uLen + 2, uId, uIeLen);
+	}
+	return uLen + 2 + uIeLen;
+}
+
+static TI_UINT32 addWme (TI_UINT8 *pBody, TI_UINT32 uLen, TI_UINT8 uIeLen, TI_UINT8 uAcInfo)
+{
+	TI_UINT8 aWme[255];
+
+	memset (aWme, 0xaa, sizeof(aWme));
+	aWme[0] = 0x00;
+	aWme[1] = 0x50;
+	aWme[2] = 0xf2;
+	aWme[3] = dot11_WME_OUI_TYPE;
+	aWme[4] = dot11_WME_OUI_SUB_TYPE_PARAMS_IE;
+	aWme[5] = dot11_WME_VERSION;
+	aWme[6] = uAcInfo;
+	return addIe (pBody, uLen, WPA_IE_ID, aWme, uIeLen);
+}
+
+static TI_UINT32 addVendor (TI_UINT8 *pBody, TI_UINT32 uLen, TI_UINT8 uOuiType, TI_UINT8 uIeLen)
+{
+	TI_UINT8 aVendor[255];
+
+	memset (aVendor, uOuiType, sizeof(aVendor));
+	aVendor[0] = 0x00;
+	aVendor[1] = 0x50;
+	aVendor[2] = 0xf2;
+	aVendor[3] = uOuiType;
+	return addIe (pBody, uLen, WPA_IE_ID, aVendor, uIeLen);
+}
+
+/* the IEs of a typical beacon, after the fixed fields */
+static TI_UINT32 buildBeaconIes (TI_UINT8 *pBody, const char *pSsid)
+{
+	static const TI_UINT8 aRates[] = {0x82, 0x84, 0x8b, 0x96, 0x0c, 0x12, 0x18, 0x24};
+	static const TI_UINT8 aExtRates[] = {0x30, 0x48, 0x60, 0x6c};
+	static const TI_UINT8 aTim[] = {0, 3, 0, 0};
+	static const TI_UINT8 aCountry[] = {'U', 'S', ' ', 1, 11, 30};
+	static const TI_UINT8 aErp[] = {0x00};
+	static const TI_UINT8 aExtCap[] = {0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40};
+	TI_UINT8 aDs[1];
+	TI_UINT8 aRsn[20];
+	TI_UINT32 uLen = 0;
+
+	aDs[0] = TEST_CHANNEL;
+	memset (aRsn, 0, sizeof(aRsn));
+	aRsn[0] = 1;
+
+	uLen = addIe (pBody, uLen, SSID_IE_ID, (const TI_UINT8 *)pSsid, (TI_UINT8)strlen (pSsid));
+	uLen = addIe (pBody, uLen, SUPPORTED_RATES_IE_ID, aRates, sizeof(aRates));
+	uLen = addIe (pBody, uLen, DS_PARAMETER_SET_IE_ID, aDs, sizeof(aDs));
+	uLen = addIe (pBody, uLen, TIM_IE_ID, aTim, sizeof(aTim));
+	uLen = addIe (pBody, uLen, COUNTRY_IE_ID, aCountry, sizeof(aCountry));
+	uLen = addIe (pBody, uLen, ERP_IE_ID, aErp, sizeof(aErp));
+	uLen = addIe (pBody, uLen, HT_CAPABILITIES_IE_ID, NULL, DOT11_HT_CAPABILITIES_ELE_LEN);
+	uLen = addIe (pBody, uLen, RSN_IE_ID, aRsn, sizeof(aRsn));
+	uLen = addIe (pBody, uLen, EXT_SUPPORTED_RATES_IE_ID, aExtRates, sizeof(aExtRates));
+	uLen = addIe (pBody, uLen, HT_INFORMATION_IE_ID, NULL, DOT11_HT_INFORMATION_ELE_LEN);
+	uLen = addIe (pBody, uLen, 127, aExtCap, sizeof(aExtCap));
+	uLen = addWme (pBody, uLen, DOT11_WME_PARAM_ELE_LEN, 0x01);
+	uLen = addVendor (pBody, uLen, dot11_WSC_OUI_TYPE, 30);
+	uLen = addIe (pBody, uLen, 0xdd, (const TI_UINT8 *)"\x00\x10\x18\x02\x00\x00\x1c\x00\x00", 9);
+
+	return uLen;
+}
+
+static void resetParams (ERadioBand eBand, dot11MgmtSubType_e eSubType, TI_BOOL bMyBssid)
+{
+	memset (&tMlme.tempFrameInfo, 0, sizeof(tMlme.tempFrameInfo));
+	tMlme.tempFrameInfo.frame.subType = eSubType;
+	tMlme.tempFrameInfo.band = eBand;
+	tMlme.tempFrameInfo.rxChannel = TEST_CHANNEL;
+	tMlme.tempFrameInfo.myBssid = bMyBssid;
+}
+
+/* parses the IEs from a heap buffer of their exact size */
+static TI_STATUS parse (const TI_UINT8 *pIes, TI_UINT32 uLen, TI_UINT8 **ppBuf)
+{
+	TI_UINT8 *pBuf = malloc (uLen ? uLen : 1);
+
+	memcpy (pBuf, pIes, uLen);
+	*ppBuf = pBuf;
+	return mlmeParser_parseIEs (&tMlme, pBuf, uLen, &tMlme.tempFrameInfo);
+}
+
+
+/*
+ * Tests
+ */
+static void testBeaconIes (void)
+{
+	beacon_probeRsp_t *pFrame = &tMlme.tempFrameInfo.frame.content.iePacket;
+	TI_UINT8    aBody[MAX_TEST_BODY];
+	TI_UINT8    aUnknown[MAX_BEACON_BODY_LENGTH];
+	TI_UINT8    *pBuf;
+	TI_UINT32   uLen;
+
+	uLen = buildBeaconIes (aBody, "ti-ap");
+	resetParams (RADIO_BAND_2_4_GHZ, BEACON, TI_FALSE);
+	CHECK (parse (aBody, uLen, &pBuf) == TI_OK);
+
+	CHECK (pFrame->pSsid == &tMlme.tempFrameInfo.ssid);
+	CHECK (pFrame->pSsid->hdr[1] == 5 && memcmp (pFrame->pSsid->serviceSetId, "ti-ap", 5) == 0);
+	CHECK (pFrame->pRates == (dot11_RATES_t *)(pBuf + 7));
+	CHECK (pFrame->pRates->hdr[1] == 8 && pFrame->pRates->rates[2] == 0x8b);
+	CHECK (pFrame->pDSParamsSet != NULL && pFrame->pDSParamsSet->currChannel == TEST_CHANNEL);
+	CHECK (pFrame->pTIM != NULL && pFrame->pTIM->dtimPeriod == 3);
+	CHECK (pFrame->country == &tMlme.tempFrameInfo.country);
+	CHECK (memcmp (pFrame->country->countryIE.CountryString, "US ", 3) == 0);
+	CHECK (pFrame->country->countryIE.tripletChannels[0].numberOfChannels == 11);
+	CHECK (pFrame->useProtection == 0 && pFrame->barkerPreambleMode == PREAMBLE_SHORT);
+	CHECK (pFrame->pHtCapabilities != NULL && pFrame->pHtCapabilities->tHdr[1] == DOT11_HT_CAPABILITIES_ELE_LEN);
+	CHECK (pFrame->pHtInformation != NULL && pFrame->pHtInformation->aHtInformationIe[0] == HT_INFORMATION_IE_ID);
+	CHECK (pFrame->pRsnIe == &tMlme.tempFrameInfo.rsnIe[0] && pFrame->rsnIeLen == 22);
+	CHECK (pFrame->pExtRates != NULL && pFrame->pExtRates->hdr[1] == 4);
+	CHECK (pFrame->WMEParams == &tMlme.tempFrameInfo.WMEParams && pFrame->WMEParams->ACInfoField == 0x01);
+	CHECK (pFrame->WMEParams->WME_ACParameteres.ACBEParametersRecord.ACI_AIFSN == 0xaa);
+	/* not read from beacons by default */
+	CHECK (pFrame->WSCParams == NULL);
+	CHECK (pFrame->pFHParamsSet == NULL && pFrame->pCFParamsSet == NULL && pFrame->pIBSSParamsSet == NULL);
+	CHECK (pFrame->channelSwitch == NULL && pFrame->quiet == NULL && pFrame->powerConstraint == NULL);
+
+	/* only the extended capabilities IE has no parser */
+	CHECK (pFrame->unknownIeLen == 10);
+	CHECK (mlmeParser_CopyUnknownIes (NULL, pFrame, aUnknown, sizeof(aUnknown)) == 10);
+	CHECK (aUnknown[0] == 127 && aUnknown[1] == 8 && aUnknown[9] == 0x40);
+	CHECK (mlmeParser_CopyUnknownIes (NULL, pFrame, aUnknown, 9) == 0);
+	free (pBuf);
+
+	/* the WSC IE is read from probe responses, and from beacons if so configured */
+	resetParams (RADIO_BAND_2_4_GHZ, PROBE_RESPONSE, TI_FALSE);
+	CHECK (parse (aBody, uLen, &pBuf) == TI_OK);
+	CHECK (pFrame->WSCParams == &tMlme.tempFrameInfo.WSCParams && pFrame->WSCParams->hdr[1] == 30);
+	CHECK (pFrame->WSCParams->OUIType == dot11_WSC_OUI_TYPE);
+	free (pBuf);
+
+	tMlme.bParseBeaconWSC = TI_TRUE;
+	resetParams (RADIO_BAND_2_4_GHZ, BEACON, TI_FALSE);
+	CHECK (parse (aBody, uLen, &pBuf) == TI_OK);
+	CHECK (pFrame->WSCParams != NULL);
+	tMlme.bParseBeaconWSC = TI_FALSE;
+	free (pBuf);
+}
+
+static void testBadIes (void)
+{
+	beacon_probeRsp_t *pFrame = &tMlme.tempFrameInfo.frame.content.iePacket;
+	TI_UINT8    aBody[MAX_TEST_BODY];
+	TI_UINT8    aData[255];
+	TI_UINT8    *pBuf;
+	TI_UINT32   uLen;
+	TI_UINT32   i;
+
+	memset (aData, 0, sizeof(aData));
+
+	/* too long SSID */
+	uLen = addIe (aBody, 0, SSID_IE_ID, NULL, MAX_SSID_LEN + 1);
+	resetParams (RADIO_BAND_2_4_GHZ, BEACON, TI_FALSE);
+	CHECK (parse (aBody, uLen, &pBuf) == TI_NOK);
+	free (pBuf);
+
+	/* DS channel of another channel, which is only checked on 2.4GHz */
+	aData[0] = TEST_CHANNEL + 1;
+	uLen = addIe (aBody, 0, DS_PARAMETER_SET_IE_ID, aData, 1);
+	resetParams (RADIO_BAND_2_4_GHZ, BEACON, TI_FALSE);
+	CHECK (parse (aBody, uLen, &pBuf) == TI_NOK);
+	free (pBuf);
+	resetParams (RADIO_BAND_5_0_GHZ, BEACON, TI_FALSE);
+	CHECK (parse (aBody, uLen, &pBuf) == TI_OK);
+	free (pBuf);
+	aData[0] = 0;
+
+	/* too short TIM and HT IEs reject the frame, other short IEs are ignored */
+	uLen = addIe (aBody, 0, TIM_IE_ID, aData, 2);
+	resetParams (RADIO_BAND_2_4_GHZ, BEACON, TI_FALSE);
+	CHECK (parse (aBody, uLen, &pBuf) == TI_NOK);
+	free (pBuf);
+	uLen = addIe (aBody, 0, HT_CAPABILITIES_IE_ID, aData, DOT11_HT_CAPABILITIES_ELE_LEN - 1);
+	resetParams (RADIO_BAND_2_4_GHZ, BEACON, TI_FALSE);
+	CHECK (parse (aBody, uLen, &pBuf) == TI_NOK);
+	free (pBuf);
+	uLen = addIe (aBody, 0, FH_PARAMETER_SET_IE_ID, aData, 2);
+	uLen = addIe (aBody, uLen, IBSS_PARAMETER_SET_IE_ID, aData, 0);
+	uLen = addIe (aBody, uLen, ERP_IE_ID, aData, 0);
+	resetParams (RADIO_BAND_2_4_GHZ, BEACON, TI_FALSE);
+	CHECK (parse (aBody, uLen, &pBuf) == TI_OK);
+	CHECK (pFrame->pFHParamsSet == NULL && pFrame->pIBSSParamsSet == NULL);
+	free (pBuf);
+
+	/* a truncated last IE rejects the frame if it is parsed, and is ignored if not */
+	uLen = addIe (aBody, 0, SSID_IE_ID, NULL, 4);
+	aBody[1] = 5;
+	resetParams (RADIO_BAND_2_4_GHZ, BEACON, TI_FALSE);
+	CHECK (parse (aBody, uLen, &pBuf) == TI_NOK);
+	free (pBuf);
+	uLen = addIe (aBody, 0, SSID_IE_ID, NULL, 4);
+	uLen = addIe (aBody, uLen, 200, NULL, 4);
+	aBody[uLen - 5] = 5;
+	resetParams (RADIO_BAND_2_4_GHZ, BEACON, TI_FALSE);
+	CHECK (parse (aBody, uLen, &pBuf) == TI_OK);
+	CHECK (pFrame->pSsid != NULL && pFrame->unknownIeLen == 0);
+	free (pBuf);
+
+	/* RSN IEs beyond the gathered ones are ignored */
+	uLen = 0;
+	for (i = 0; i < MAX_RSN_IE + 2; i++)
+	{
+		uLen = addIe (aBody, uLen, RSN_IE_ID, NULL, 200);
+	}
+	resetParams (RADIO_BAND_2_4_GHZ, BEACON, TI_FALSE);
+	CHECK (parse (aBody, uLen, &pBuf) == TI_OK);
+	CHECK (tMlme.tempFrameInfo.rsnIe[MAX_RSN_IE - 1].hdr[1] == 200);
+	free (pBuf);
+
+	/* the longest WME IE does not overflow its AC parameters */
+	uLen = addWme (aBody, 0, WME_TSPEC_IE_LEN, 0x02);
+	resetParams (RADIO_BAND_2_4_GHZ, BEACON, TI_FALSE);
+	CHECK (parse (aBody, uLen, &pBuf) == TI_OK);
+	CHECK (pFrame->WMEParams != NULL && pFrame->WMEParams->ACInfoField == 0x02);
+	CHECK (tMlme.tempFrameInfo.WSCParams.hdr[0] == 0);
+	free (pBuf);
+
+	/* too long WSC IE */
+	uLen = addVendor (aBody, 0, dot11_WSC_OUI_TYPE, sizeof(dot11_WSC_t) - 1);
+	resetParams (RADIO_BAND_2_4_GHZ, PROBE_RESPONSE, TI_FALSE);
+	CHECK (parse (aBody, uLen, &pBuf) == TI_NOK);
+	free (pBuf);
+
+	/* channel switch, of the current BSS only, and ignored if its length is wrong */
+	aData[0] = 1;
+	aData[1] = TEST_CHANNEL + 4;
+	aData[2] = 10;
+	uLen = addIe (aBody, 0, CHANNEL_SWITCH_ANNOUNCEMENT_IE_ID, aData, DOT11_CHANNEL_SWITCH_ELE_LEN);
+	uChannelSwitches = 0;
+	resetParams (RADIO_BAND_2_4_GHZ, BEACON, TI_FALSE);
+	CHECK (parse (aBody, uLen, &pBuf) == TI_OK);
+	CHECK (uChannelSwitches == 0 && tMlme.tempFrameInfo.recvChannelSwitchAnnoncIE == TI_FALSE);
+	free (pBuf);
+	resetParams (RADIO_BAND_2_4_GHZ, BEACON, TI_TRUE);
+	CHECK (parse (aBody, uLen, &pBuf) == TI_OK);
+	CHECK (uChannelSwitches == 1 && tMlme.tempFrameInfo.recvChannelSwitchAnnoncIE == TI_TRUE);
+	CHECK (pFrame->channelSwitch->channelNumber == TEST_CHANNEL + 4);
+	free (pBuf);
+	uLen = addIe (aBody, 0, CHANNEL_SWITCH_ANNOUNCEMENT_IE_ID, aData, 20);
+	resetParams (RADIO_BAND_2_4_GHZ, BEACON, TI_TRUE);
+	CHECK (parse (aBody, uLen, &pBuf) == TI_OK);
+	CHECK (uChannelSwitches == 1);
+	free (pBuf);
+	memset (aData, 0, sizeof(aData));
+}
+
+
+/*
+ * Random and mutated IE sequences
+ */
+static const TI_UINT8 aParsedIds[] =
+{
+	SSID_IE_ID, SUPPORTED_RATES_IE_ID, FH_PARAMETER_SET_IE_ID, DS_PARAMETER_SET_IE_ID,
+	CF_PARAMETER_SET_IE_ID, TIM_IE_ID, IBSS_PARAMETER_SET_IE_ID, COUNTRY_IE_ID,
+	POWER_CONSTRAINT_IE_ID, TPC_REPORT_IE_ID, CHANNEL_SWITCH_ANNOUNCEMENT_IE_ID, QUIET_IE_ID,
+	ERP_IE_ID, HT_CAPABILITIES_IE_ID, DOT11_QOS_CAPABILITY_ELE_ID, RSN_IE_ID,
+	EXT_SUPPORTED_RATES_IE_ID, HT_INFORMATION_IE_ID, XCC_EXT_1_IE_ID, WPA_IE_ID
+};
+
+#define PARSED_IDS_NUM  (sizeof(aParsedIds) / sizeof(aParsedIds[0]))
+
+static TI_BOOL isParsedId (TI_UINT8 uId)
+{
+	TI_UINT32 i;
+
+	for (i = 0; i < PARSED_IDS_NUM; i++)
+	{
+		if (aParsedIds[i] == uId)
+			return TI_TRUE;
+	}
+	return TI_FALSE;
+}
+
+/* a parsed IE is either referenced in the frame, whole, or copied to the parser buffers */
+static TI_BOOL isInFrame (const void *pIe, TI_UINT32 uSize, const TI_UINT8 *pBuf, TI_UINT32 uLen)
+{
+	const TI_UINT8 *p = (const TI_UINT8 *)pIe;
+
+	return (p >= pBuf) && (p + 2 <= pBuf + uLen) && (p + 2 + p[1] <= pBuf + uLen) && (p + uSize <= pBuf + uLen);
+}
+
+static TI_BOOL isInParams (const void *pIe)
+{
+	const TI_UINT8 *p = (const TI_UINT8 *)pIe;
+	const TI_UINT8 *pParams = (const TI_UINT8 *)&tMlme.tempFrameInfo;
+
+	return (p >= pParams) && (p < pParams + sizeof(tMlme.tempFrameInfo));
+}
+
+static void checkParsedFrame (const TI_UINT8 *pBuf, TI_UINT32 uLen)
+{
+	beacon_probeRsp_t *pFrame = &tMlme.tempFrameInfo.frame.content.iePacket;
+
+	CHECK (pFrame->pRates == NULL || isInFrame (pFrame->pRates, 2, pBuf, uLen));
+	CHECK (pFrame->pExtRates == NULL || isInFrame (pFrame->pExtRates, 2, pBuf, uLen));
+	CHECK (pFrame->pDSParamsSet == NULL || isInFrame (pFrame->pDSParamsSet, sizeof(dot11_DS_PARAMS_t), pBuf, uLen));
+	CHECK (pFrame->pTIM == NULL || isInFrame (pFrame->pTIM, 5, pBuf, uLen));
+	CHECK (pFrame->pHtCapabilities == NULL || isInFrame (pFrame->pHtCapabilities, sizeof(Tdot11HtCapabilitiesUnparse), pBuf, uLen));
+	CHECK (pFrame->pHtInformation == NULL || isInFrame (pFrame->pHtInformation, sizeof(Tdot11HtInformationUnparse), pBuf, uLen));
+	CHECK (pFrame->pSsid == NULL || (isInParams (pFrame->pSsid) && pFrame->pSsid->hdr[1] <= MAX_SSID_LEN));
+	CHECK (pFrame->country == NULL || isInParams (pFrame->country));
+	CHECK (pFrame->pRsnIe == NULL || isInParams (pFrame->pRsnIe));
+	CHECK (pFrame->WMEParams == NULL || isInParams (pFrame->WMEParams));
+	CHECK (pFrame->WSCParams == NULL || isInParams (pFrame->WSCParams));
+	CHECK (pFrame->pFHParamsSet == NULL || isInParams (pFrame->pFHParamsSet));
+	CHECK (pFrame->pCFParamsSet == NULL || isInParams (pFrame->pCFParamsSet));
+	CHECK (pFrame->pIBSSParamsSet == NULL || isInParams (pFrame->pIBSSParamsSet));
+	CHECK (pFrame->quiet == NULL || isInParams (pFrame->quiet));
+	CHECK (pFrame->TPCReport == NULL || isInParams (pFrame->TPCReport));
+}
+
+/* the unknown IEs of a frame, up to its first truncated IE */
+static TI_UINT32 modelUnknownLen (const TI_UINT8 *pBuf, TI_UINT32 uLen)
+{
+	TI_UINT32 uPos = 0;
+	TI_UINT32 uUnknown = 0;
+
+	while (uPos + 1 < uLen && uPos + 2 + pBuf[uPos + 1] <= uLen)
+	{
+		if (!isParsedId (pBuf[uPos]))
+		{
+			uUnknown += 2 + pBuf[uPos + 1];
+		}
+		uPos += 2 + pBuf[uPos + 1];
+	}
+	return uUnknown;
+}
+
+static TI_UINT32 randomIes (TI_UINT8 *pBody)
+{
+	TI_UINT32 uLen = 0;
+	TI_UINT32 uIes = rand () % 24;
+	TI_UINT32 i;
+	TI_UINT8  uId, uIeLen;
+
+	for (i = 0; i < uIes; i++)
+	{
+		uId = (rand () % 3) ? aParsedIds[rand () % PARSED_IDS_NUM] : (TI_UINT8)rand ();
+		switch (rand () % 4)
+		{
+		case 0:     uIeLen = (TI_UINT8)(rand () % 8);          break;
+		case 1:     uIeLen = (TI_UINT8)(rand () % 40);         break;
+		case 2:     uIeLen = (TI_UINT8)rand ();                break;
+		default:    uIeLen = (uId == WPA_IE_ID) ? 24 : 26;     break;
+		}
+		if (uLen + 2 + uIeLen > MAX_TEST_BODY)
+			break;
+		uLen = addIe (pBody, uLen, uId, NULL, uIeLen);
+		/* vendor IEs of the WPA OUI, with random types and sub types */
+		if (uId == WPA_IE_ID && uIeLen >= 5 && (rand () % 2))
+		{
+			TI_UINT8 *pIe = pBody + uLen - uIeLen - 2;
+			pIe[2] = 0x00;
+			pIe[3] = 0x50;
+			pIe[4] = 0xf2;
+			pIe[5] = (TI_UINT8)(1 + rand () % 4);
+			pIe[6] = (TI_UINT8)(rand () % 3);
+			if (uIeLen >= 6)
+				pIe[7] = (TI_UINT8)(rand () % 2);
+		}
+	}
+	return uLen;
+}
+
+static void fuzz (TI_UINT32 uFrames, TI_UINT32 uSeed)
+{
+	TI_UINT8    aBody[MAX_TEST_BODY];
+	TI_UINT8    *pBuf;
+	TI_UINT8    *pUnknown;
+	TI_UINT32   uLen, uUnknownBufLen, uCopied, uPos;
+	TI_UINT32   uFrame, uMutations, i;
+	TI_UINT32   uAccepted = 0;
+	beacon_probeRsp_t *pFrame = &tMlme.tempFrameInfo.frame.content.iePacket;
+
+	srand (uSeed);
+	for (uFrame = 0; uFrame < uFrames; uFrame++)
+	{
+		if (uFrame % 2)
+		{
+			uLen = buildBeaconIes (aBody, "fuzzed-ap");
+		}
+		else
+		{
+			uLen = randomIes (aBody);
+		}
+
+		/* flip bytes, and sometimes cut the frame anywhere */
+		uMutations = rand () % 4;
+		for (i = 0; i < uMutations && uLen > 0; i++)
+		{
+			aBody[rand () % uLen] = (TI_UINT8)rand ();
+		}
+		if (uLen > 0 && (rand () % 4) == 0)
+		{
+			uLen = rand () % uLen;
+		}
+
+		tMlme.bParseBeaconWSC = (TI_BOOL)(rand () % 2);
+		resetParams ((rand () % 2) ? RADIO_BAND_2_4_GHZ : RADIO_BAND_5_0_GHZ,
+					 (rand () % 2) ? BEACON : PROBE_RESPONSE, (TI_BOOL)(rand () % 2));
+		if (parse (aBody, uLen, &pBuf) != TI_OK)
+		{
+			free (pBuf);
+			continue;
+		}
+		uAccepted++;
+		checkParsedFrame (pBuf, uLen);
+		CHECK (pFrame->unknownIeLen == modelUnknownLen (pBuf, uLen));
+
+		/* the unknown IEs are copied whole, as far as they fit */
+		uUnknownBufLen = rand () % (MAX_BEACON_BODY_LENGTH + 1);
+		pUnknown = malloc (uUnknownBufLen ? uUnknownBufLen : 1);
+		uCopied = mlmeParser_CopyUnknownIes (NULL, pFrame, pUnknown, uUnknownBufLen);
+		CHECK (uCopied <= uUnknownBufLen && uCopied <= pFrame->unknownIeLen);
+		CHECK (uUnknownBufLen < pFrame->unknownIeLen || uCopied == pFrame->unknownIeLen);
+		for (uPos = 0; uPos < uCopied; uPos += 2 + pUnknown[uPos + 1])
+		{
+			CHECK (!isParsedId (pUnknown[uPos]));
+			CHECK (uPos + 2 + pUnknown[uPos + 1] <= uCopied);
+		}
+		free (pUnknown);
+		free (pBuf);
+	}
+	tMlme.bParseBeaconWSC = TI_FALSE;
+
+	printf ("mlme parser: %u of %u fuzzed frames accepted\n", uAccepted, uFrames);
+}
+
+
+/*
+ * Received frames
+ */
+static TI_UINT8 *buildRxBuf (TI_UINT16 uFc, const TI_UINT8 *pIes, TI_UINT32 uIesLen, TI_UINT32 *pSize)
+{
+	TI_UINT32           uFrameLen = WLAN_HDR_LEN + TIME_STAMP_LEN + 4 + uIesLen;
+	TI_UINT32           uWords = (sizeof(RxIfDescriptor_t) + uFrameLen + 3) / 4;
+	TI_UINT8            *pBuf = calloc (uWords, 4);
+	RxIfDescriptor_t    *pDesc = (RxIfDescriptor_t *)pBuf;
+	dot11_mgmtFrame_t   *pMgmt = (dot11_mgmtFrame_t *)RX_BUF_DATA(pBuf);
+	TI_UINT8            *pBody = (TI_UINT8 *)pMgmt->body;
+
+	pDesc->length = (TI_UINT16)uWords;
+	pDesc->extraBytes = (TI_UINT8)(uWords * 4 - sizeof(RxIfDescriptor_t) - uFrameLen);
+
+	COPY_WLAN_WORD(&pMgmt->hdr.fc, &uFc);
+	memset (pMgmt->hdr.DA, 0xff, MAC_ADDR_LEN);
+	MAC_COPY (pMgmt->hdr.SA, tCurrentBssid);
+	MAC_COPY (pMgmt->hdr.BSSID, tCurrentBssid);
+	pMgmt->hdr.BSSID[5] = 0x02;
+
+	/* beacon interval and capabilities */
+	pBody[TIME_STAMP_LEN] = 100;
+	pBody[TIME_STAMP_LEN + 2] = 0x01;
+	memcpy (pBody + TIME_STAMP_LEN + 4, pIes, uIesLen);
+
+	*pSize = uWords * 4;
+	return pBuf;
+}
+
+static void testRecv (void)
+{
+	TRxAttr     tRxAttr;
+	TI_UINT8    aBody[MAX_TEST_BODY];
+	TI_UINT8    *pBuf;
+	TI_UINT32   uLen, uSize, i;
+
+	memset (&tRxAttr, 0, sizeof(tRxAttr));
+	tRxAttr.band = RADIO_BAND_2_4_GHZ;
+	tRxAttr.channel = TEST_CHANNEL;
+	tRxAttr.eScanTag = SCAN_RESULT_TAG_APPLICATION_ONE_SHOT;
+
+	uLen = buildBeaconIes (aBody, "recv-ap");
+	pBuf = buildRxBuf (DOT11_FC_BEACON, aBody, uLen, &uSize);
+	uScanResults = uScanInvalid = uBufsFreed = 0;
+	CHECK (mlmeParser_recv (&tMlme, pBuf, &tRxAttr) == TI_OK);
+	CHECK (uScanResults == 1 && uBufsFreed == 1);
+	CHECK (strcmp (aScanSsid, "recv-ap") == 0);
+	CHECK (uScanUnknownIesLen == 10 && aScanUnknownIes[0] == 127);
+	free (pBuf);
+
+	/* a probe response of mostly unknown IEs */
+	uLen = addIe (aBody, 0, SSID_IE_ID, (const TI_UINT8 *)"big", 3);
+	for (i = 0; i < 3; i++)
+	{
+		uLen = addIe (aBody, uLen, (TI_UINT8)(200 + i), NULL, 100);
+	}
+	pBuf = buildRxBuf (DOT11_FC_PROBE_RESP, aBody, uLen, &uSize);
+	CHECK (mlmeParser_recv (&tMlme, pBuf, &tRxAttr) == TI_OK);
+	CHECK (uScanResults == 2 && uScanUnknownIesLen == 3 * 102);
+	free (pBuf);
+
+	/* frames that fail parsing are still reported to the scan, as invalid */
+	uLen = addIe (aBody, 0, SSID_IE_ID, NULL, MAX_SSID_LEN + 1);
+	pBuf = buildRxBuf (DOT11_FC_BEACON, aBody, uLen, &uSize);
+	CHECK (mlmeParser_recv (&tMlme, pBuf, &tRxAttr) == TI_NOK);
+	CHECK (uScanResults == 2 && uScanInvalid == 1 && uBufsFreed == 3);
+	free (pBuf);
+}
+
+
+static double nsNow (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* typical beacons of a few APs, through mlmeParser_recv up to the scan result */
+static void bench (TI_UINT32 uBeacons)
+{
+	TRxAttr     tRxAttr;
+	TI_UINT8    aBody[MAX_TEST_BODY];
+	TI_UINT8    *apBufs[8];
+	TI_UINT32   uLen, uSize, i;
+	char        aSsid[16];
+	double      t0, t;
+
+	for (i = 0; i < 8; i++)
+	{
+		sprintf (aSsid, "bench-ap-%u", i);
+		uLen = buildBeaconIes (aBody, aSsid);
+		apBufs[i] = buildRxBuf (DOT11_FC_BEACON, aBody, uLen, &uSize);
+	}
+
+	memset (&tRxAttr, 0, sizeof(tRxAttr));
+	tRxAttr.band = RADIO_BAND_2_4_GHZ;
+	tRxAttr.channel = TEST_CHANNEL;
+	tRxAttr.eScanTag = SCAN_RESULT_TAG_APPLICATION_ONE_SHOT;
+	uScanResults = 0;
+
+	t0 = nsNow ();
+	for (i = 0; i < uBeacons; i++)
+	{
+		mlmeParser_recv (&tMlme, apBufs[i % 8], &tRxAttr);
+	}
+	t = nsNow () - t0;
+	CHECK (uScanResults == uBeacons);
+
+	printf ("mlme parser: %u beacons of %u bytes, %.0f ns/beacon, %.0f beacons/s\n",
+			uBeacons, uSize, t / uBeacons, uBeacons * 1e9 / t);
+
+	for (i = 0; i < 8; i++)
+	{
+		free (apBufs[i]);
+	}
+}
+
+int main (int argc, char **argv)
+{
+	TI_UINT32   uFuzzFrames = (argc > 1) ? (TI_UINT32)atoi (argv[1]) : 200000;
+	TI_UINT32   uSeed = (argc > 2) ? (TI_UINT32)atoi (argv[2]) : 1;
+	TI_UINT32   uBeacons = (argc > 3) ? (TI_UINT32)atoi (argv[3]) : 1000000;
+
+	memset (&tMlme, 0, sizeof(tMlme));
+	mlmeParser_init ();
+
+	testBeaconIes ();
+	testBadIes ();
+	testRecv ();
+	fuzz (uFuzzFrames, uSeed);
+	bench (uBeacons);
+
+	printf ("mlme parser: %s\n", iErrors ? "FAILED" : "passed");
+	return iErrors ? 1 : 0;
+}
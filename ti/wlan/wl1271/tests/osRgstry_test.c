@@ -0,0 +1,522 @@
+/*
+ * osRgstry_test.c
+ *
+ * Copyright(c) 1998 - 2010 Texas Instruments. All rights reserved.      
+ * All rights reserved.                                                  
+ *                                                                       
+ * Redistribution and use in source and binary forms, with or without    
+ * modification, are permitted provided that the following conditions    
+ * are met:                                                              
+ *                                                                       
+ *  * Redistributions of source code must retain the above copyright     
+ *    notice, this list of conditions and the following disclaimer.      
+ *  * Redistributions in binary form must reproduce the above copyright  
+ *    notice, this list of conditions and the following disclaimer in    
+ *    the documentation and/or other materials provided with the         
+ *    distribution.                                                      
+ *  * Neither the name Texas Instruments nor the names of its            
+ *    contributors may be used to endorse or promote products derived    
+ *    from this software without specific prior written permission.      
+ *                                                                       
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT  
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT      
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT   
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file osRgstry_test.c
+ *  \brief Host unit test of the registry keys index and snapshot
+ *
+ *  Parses ini files to init tables through the keys index, through the search of each key
+ *  in the whole file (as when the index can't be allocated), and through a compiled snapshot,
+ *  and checks the tables are the same. Variants of each file (CRLF lines, keys case, repeated
+ *  keys, remarks, broken lines and random edits) are checked the same way, and a corrupted
+ *  or foreign snapshot is checked to fall back to its ini text. Then each path is timed.
+ *
+ *      wl1271_rgstry_test [ini files]
+ *
+ *  \see osRgstry_parser.c, osRgstry.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "osRgstry_parser.h"
+
+
+#ifndef RGSTRY_TEST_INI
+#define RGSTRY_TEST_INI         "../config/tiwlan.ini"
+#endif
+
+#define FUZZ_ROUNDS             200
+#define BENCH_STARTS            200
+
+static TWlanDrvIfObj        tDrv;
+static TInitTable           tTable;
+static TInitTable           tExpected;
+static int                  iErrors;
+
+extern void hostOs_FailAllocs (TI_UINT32 uCount);
+
+#define CHECK(cond) \
+	do { if (!(cond)) { printf ("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); iErrors++; } } while (0)
+
+
+/* the ini text, with room for the edits of the variants */
+typedef struct
+{
+	char       *pBuf;
+	int         iLen;
+	int         iSize;
+} TText;
+
+static void textInit (TText *pText, int iSize)
+{
+	pText->pBuf = malloc (iSize + 1);
+	pText->iLen = 0;
+	pText->iSize = iSize;
+}
+
+static void textAdd (TText *pText, const char *pStr, int iLen)
+{
+	if (pText->iLen + iLen > pText->iSize)
+	{
+		pText->iSize = (pText->iLen + iLen) * 2;
+		pText->pBuf = realloc (pText->pBuf, pText->iSize + 1);
+	}
+	memcpy (pText->pBuf + pText->iLen, pStr, iLen);
+	pText->iLen += iLen;
+	/* as the loader, which sends the file with a terminating byte */
+	pText->pBuf[pText->iLen] = '\0';
+}
+
+static int readFile (const char *pName, TText *pText)
+{
+	FILE   *pFile = fopen (pName, "rb");
+	char    aChunk[4096];
+	size_t  uLen;
+
+	if (pFile == NULL)
+	{
+		return -1;
+	}
+	textInit (pText, sizeof(aChunk));
+	while ((uLen = fread (aChunk, 1, sizeof(aChunk), pFile)) > 0)
+	{
+		textAdd (pText, aChunk, (int)uLen);
+	}
+	fclose (pFile);
+	return 0;
+}
+
+
+/*
+ * The parse paths, each to a table first filled with garbage
+ */
+static void parseIndexed (char *pBuf, int iLen, TInitTable *pTable)
+{
+	memset (pTable, 0xA5, sizeof(*pTable));
+	osInitTable_IniFile (&tDrv, pTable, pBuf, iLen);
+}
+
+/* the index is the first allocation of the parse, so failing it falls back to the keys search */
+static void parseScanned (char *pBuf, int iLen, TInitTable *pTable)
+{
+	memset (pTable, 0x5A, sizeof(*pTable));
+	hostOs_FailAllocs (1);
+	osInitTable_IniFile (&tDrv, pTable, pBuf, iLen);
+	hostOs_FailAllocs (0);
+}
+
+static int compileSnapshot (char *pBuf, int iLen, char **ppSnap)
+{
+	int iSnapLen = sizeof(TRgstrySnapshotHdr) + sizeof(TInitTable) + iLen;
+	TInitTable *pTable = malloc (sizeof(TInitTable));
+
+	/* one more byte, as the loader sends, and to shift the snapshot off its alignment */
+	*ppSnap = malloc (iSnapLen + 2);
+	CHECK (osInitTable_Snapshot (&tDrv, pTable, pBuf, iLen, *ppSnap, iSnapLen - 1) == -1);
+	CHECK (osInitTable_Snapshot (&tDrv, pTable, pBuf, iLen, *ppSnap, iSnapLen) == iSnapLen);
+	(*ppSnap)[iSnapLen] = '\0';
+	free (pTable);
+	return iSnapLen;
+}
+
+static TI_BOOL sameTables (const char *pWhat, const char *pName, TInitTable *pTable1, TInitTable *pTable2)
+{
+	TI_UINT8    *p1 = (TI_UINT8 *)pTable1;
+	TI_UINT8    *p2 = (TI_UINT8 *)pTable2;
+	TI_UINT32   i;
+
+	for (i = 0; i < sizeof(TInitTable); i++)
+	{
+		if (p1[i] != p2[i])
+		{
+			printf ("%s: %s: init tables differ at offset %u (0x%02x, 0x%02x)\n", pName, pWhat, i, p1[i], p2[i]);
+			iErrors++;
+			return TI_FALSE;
+		}
+	}
+	return TI_TRUE;
+}
+
+/* the indexed parse of a text is the same as its scanned parse */
+static void checkText (const char *pWhat, const char *pName, TText *pText)
+{
+	static TInitTable tScanned;
+
+	parseIndexed (pText->pBuf, pText->iLen, &tTable);
+	parseScanned (pText->pBuf, pText->iLen, &tScanned);
+	sameTables (pWhat, pName, &tTable, &tScanned);
+}
+
+
+/*
+ * The ini file variants, each built line by line from the file
+ */
+typedef void (*TLineEdit) (TText *pOut, char *pLine, int iLen, int iLineNum);
+
+static void buildVariant (TText *pIn, TText *pOut, TLineEdit fEdit)
+{
+	char *pLine = pIn->pBuf;
+	char *pEnd = pIn->pBuf + pIn->iLen;
+	char *pEol;
+	int   iLineNum = 0;
+
+	textInit (pOut, pIn->iLen * 2);
+	while (pLine < pEnd)
+	{
+		for (pEol = pLine; pEol < pEnd && *pEol != '\n'; pEol++) ;
+		fEdit (pOut, pLine, pEol - pLine, iLineNum++);
+		if (pEol < pEnd)
+		{
+			textAdd (pOut, "\n", 1);
+		}
+		pLine = pEol + 1;
+	}
+}
+
+/* the length of the key at the line start, after its leading blanks in *pStart */
+static int lineKey (char *pLine, int iLen, int *pStart)
+{
+	int i = 0, iKey;
+
+	while (i < iLen && (pLine[i] == ' ' || pLine[i] == '\t')) i++;
+	*pStart = i;
+	for (iKey = i; iKey < iLen && !strchr (" \t=#\r", pLine[iKey]); iKey++) ;
+	return iKey - i;
+}
+
+static void editCrLf (TText *pOut, char *pLine, int iLen, int iLineNum)
+{
+	textAdd (pOut, pLine, iLen);
+	textAdd (pOut, "\r", 1);
+}
+
+static void editKeysCase (TText *pOut, char *pLine, int iLen, int iLineNum)
+{
+	int iStart, iKey = lineKey (pLine, iLen, &iStart);
+	int i;
+
+	for (i = iStart; i < iStart + iKey; i++)
+	{
+		pLine[i] = (iLineNum & 1) ? toupper (pLine[i]) : tolower (pLine[i]);
+	}
+	textAdd (pOut, pLine, iLen);
+}
+
+/* each key line is repeated with another value, which is ignored as the second one */
+static void editRepeatKeys (TText *pOut, char *pLine, int iLen, int iLineNum)
+{
+	int iStart, iKey = lineKey (pLine, iLen, &iStart);
+
+	textAdd (pOut, pLine, iLen);
+	if (iKey > 0)
+	{
+		textAdd (pOut, "\n", 1);
+		textAdd (pOut, pLine, iStart + iKey);
+		textAdd (pOut, " = 7", 4);
+	}
+}
+
+/* every third line becomes a remark, and remarks are added with keys in them */
+static void editRemarks (TText *pOut, char *pLine, int iLen, int iLineNum)
+{
+	int iStart, iKey = lineKey (pLine, iLen, &iStart);
+
+	if (iLineNum % 3 == 0)
+	{
+		textAdd (pOut, "# ", 2);
+	}
+	textAdd (pOut, pLine, iLen);
+	if (iKey > 0 && iLineNum % 3 == 1)
+	{
+		textAdd (pOut, "\n\t# ", 4);
+		textAdd (pOut, pLine + iStart, iKey);
+		textAdd (pOut, " = 3", 4);
+	}
+}
+
+/* the blanks around the '=' are removed or doubled */
+static void editBlanks (TText *pOut, char *pLine, int iLen, int iLineNum)
+{
+	int i;
+
+	for (i = 0; i < iLen; i++)
+	{
+		if (pLine[i] == ' ' && (iLineNum & 1))
+		{
+			continue;
+		}
+		if (pLine[i] == '=' && !(iLineNum & 1))
+		{
+			textAdd (pOut, " \t= \t", 5);
+			continue;
+		}
+		textAdd (pOut, &pLine[i], 1);
+	}
+}
+
+/* random edits: keys cut, '=' dropped, lines remarked, repeated and swapped */
+static char *pSwapLine;
+static int   iSwapLen;
+
+static void editRandom (TText *pOut, char *pLine, int iLen, int iLineNum)
+{
+	int iStart, iKey = lineKey (pLine, iLen, &iStart);
+	char *pEq = memchr (pLine, '=', iLen);
+
+	switch (rand () % 8)
+	{
+	case 0:
+		if (iKey > 1)
+		{
+			int iCut = 1 + rand () % (iKey - 1);
+
+			textAdd (pOut, pLine, iStart + iCut);
+			textAdd (pOut, pLine + iStart + iKey, iLen - iStart - iKey);
+			return;
+		}
+		break;
+
+	case 1:
+		if (pEq != NULL)
+		{
+			textAdd (pOut, pLine, pEq - pLine);
+			textAdd (pOut, pEq + 1, iLen - (pEq + 1 - pLine));
+			return;
+		}
+		break;
+
+	case 2:
+		textAdd (pOut, "#", 1);
+		break;
+
+	case 3:
+		textAdd (pOut, pLine, iLen);
+		textAdd (pOut, "\n", 1);
+		break;
+
+	case 4:
+		/* swapped with the next line */
+		if (pSwapLine == NULL)
+		{
+			pSwapLine = pLine;
+			iSwapLen = iLen;
+			return;
+		}
+		break;
+	}
+	textAdd (pOut, pLine, iLen);
+	if (pSwapLine != NULL && pSwapLine != pLine)
+	{
+		textAdd (pOut, "\n", 1);
+		textAdd (pOut, pSwapLine, iSwapLen);
+		pSwapLine = NULL;
+	}
+}
+
+static void checkVariants (const char *pName, TText *pText)
+{
+	static const struct
+	{
+		const char *pWhat;
+		TLineEdit   fEdit;
+	} aVariants[] =
+	{
+		{ "CRLF lines",     editCrLf },
+		{ "keys case",      editKeysCase },
+		{ "repeated keys",  editRepeatKeys },
+		{ "remarks",        editRemarks },
+		{ "blanks",         editBlanks },
+	};
+	TText       tCopy, tVariant;
+	TI_UINT32   i;
+
+	for (i = 0; i < SIZE_ARR(aVariants); i++)
+	{
+		/* the edits may change the lines in place */
+		textInit (&tCopy, pText->iLen);
+		textAdd (&tCopy, pText->pBuf, pText->iLen);
+		buildVariant (&tCopy, &tVariant, aVariants[i].fEdit);
+		checkText (aVariants[i].pWhat, pName, &tVariant);
+		free (tVariant.pBuf);
+		free (tCopy.pBuf);
+	}
+
+	/* the ignored repeated keys and the remarks leave the file table as is */
+	textInit (&tCopy, pText->iLen);
+	textAdd (&tCopy, pText->pBuf, pText->iLen);
+	buildVariant (&tCopy, &tVariant, editRepeatKeys);
+	parseIndexed (tVariant.pBuf, tVariant.iLen, &tTable);
+	sameTables ("repeated keys", pName, &tTable, &tExpected);
+	free (tVariant.pBuf);
+	free (tCopy.pBuf);
+
+	for (i = 0; i < FUZZ_ROUNDS; i++)
+	{
+		srand (i + 1);
+		pSwapLine = NULL;
+		buildVariant (pText, &tVariant, editRandom);
+		checkText ("random edits", pName, &tVariant);
+		free (tVariant.pBuf);
+	}
+}
+
+
+/*
+ * The snapshot loaded as is, and falling back to its ini text when it's not valid
+ */
+static void checkSnapshot (const char *pName, TText *pText)
+{
+	TRgstrySnapshotHdr tHdr;
+	char    *pSnap;
+	int     iSnapLen = compileSnapshot (pText->pBuf, pText->iLen, &pSnap);
+
+	memcpy (&tHdr, pSnap, sizeof(tHdr));
+	CHECK (tHdr.uMagic == RGSTRY_SNAPSHOT_MAGIC);
+	CHECK (tHdr.uTableLen == sizeof(TInitTable) && tHdr.uIniLen == (TI_UINT32)pText->iLen);
+
+	parseIndexed (pSnap, iSnapLen, &tTable);
+	sameTables ("snapshot", pName, &tTable, &tExpected);
+
+	/* unaligned, as it follows the other files in the loader data */
+	memmove (pSnap + 1, pSnap, iSnapLen + 1);
+	parseIndexed (pSnap + 1, iSnapLen, &tTable);
+	sameTables ("unaligned snapshot", pName, &tTable, &tExpected);
+	memmove (pSnap, pSnap + 1, iSnapLen + 1);
+
+	/* a corrupted table */
+	pSnap[sizeof(tHdr) + sizeof(TInitTable) / 2] ^= 0x10;
+	parseIndexed (pSnap, iSnapLen, &tTable);
+	sameTables ("corrupted snapshot", pName, &tTable, &tExpected);
+	pSnap[sizeof(tHdr) + sizeof(TInitTable) / 2] ^= 0x10;
+
+	/* of another layout */
+	((TRgstrySnapshotHdr *)pSnap)->uLayout ^= 1;
+	parseIndexed (pSnap, iSnapLen, &tTable);
+	sameTables ("foreign snapshot", pName, &tTable, &tExpected);
+	((TRgstrySnapshotHdr *)pSnap)->uLayout ^= 1;
+
+	/* of another version */
+	((TRgstrySnapshotHdr *)pSnap)->uVersion++;
+	parseIndexed (pSnap, iSnapLen, &tTable);
+	sameTables ("snapshot version", pName, &tTable, &tExpected);
+	((TRgstrySnapshotHdr *)pSnap)->uVersion--;
+
+	/* truncated, it's parsed as an ini file (only not to crash) */
+	parseIndexed (pSnap, iSnapLen - 1, &tTable);
+	parseIndexed (pSnap, sizeof(tHdr) + 1, &tTable);
+	parseIndexed (pSnap, sizeof(tHdr) - 1, &tTable);
+
+	/* and unharmed by the above */
+	parseIndexed (pSnap, iSnapLen, &tTable);
+	sameTables ("snapshot", pName, &tTable, &tExpected);
+
+	free (pSnap);
+}
+
+
+static double usNow (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* the time of a driver start parse through each path */
+static void bench (const char *pName, TText *pText)
+{
+	char    *pSnap;
+	int     iSnapLen = compileSnapshot (pText->pBuf, pText->iLen, &pSnap);
+	double  t0, tScanned, tIndexed, tSnapshot;
+	int     i;
+
+	t0 = usNow ();
+	for (i = 0; i < BENCH_STARTS; i++)
+	{
+		parseScanned (pText->pBuf, pText->iLen, &tTable);
+	}
+	tScanned = (usNow () - t0) / BENCH_STARTS;
+
+	t0 = usNow ();
+	for (i = 0; i < BENCH_STARTS; i++)
+	{
+		parseIndexed (pText->pBuf, pText->iLen, &tTable);
+	}
+	tIndexed = (usNow () - t0) / BENCH_STARTS;
+
+	t0 = usNow ();
+	for (i = 0; i < BENCH_STARTS; i++)
+	{
+		parseIndexed (pSnap, iSnapLen, &tTable);
+	}
+	tSnapshot = (usNow () - t0) / BENCH_STARTS;
+
+	printf ("registry: %s (%d bytes): keys search %.1f us, keys index %.1f us, snapshot (%d bytes) %.1f us\n",
+			pName, pText->iLen, tScanned, tIndexed, iSnapLen, tSnapshot);
+	free (pSnap);
+}
+
+int main (int argc, char **argv)
+{
+	const char  *apDefault[] = { RGSTRY_TEST_INI };
+	const char  **apFiles = (argc > 1) ? (const char **)&argv[1] : apDefault;
+	int         iFiles = (argc > 1) ? argc - 1 : 1;
+	TText       tText;
+	int         i;
+
+	memset (&tDrv, 0, sizeof(tDrv));
+
+	for (i = 0; i < iFiles; i++)
+	{
+		if (readFile (apFiles[i], &tText) != 0)
+		{
+			printf ("registry: can't read %s\n", apFiles[i]);
+			iErrors++;
+			continue;
+		}
+
+		checkText ("ini file", apFiles[i], &tText);
+		memcpy (&tExpected, &tTable, sizeof(tTable));
+
+		checkVariants (apFiles[i], &tText);
+		checkSnapshot (apFiles[i], &tText);
+		bench (apFiles[i], &tText);
+
+		free (tText.pBuf);
+	}
+
+	printf ("registry: %s\n", iErrors ? "FAILED" : "passed");
+	return iErrors ? 1 : 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * rgstrySnapshot.c
+ *
+ * Copyright(c) 1998 - 2010 Texas Instruments. All rights reserved.      
+ * All rights reserved.                                                  
+ *                                                                       
+ * Redistribution and use in source and binary forms, with or without    
+ * modification, are permitted provided that the following conditions    
+ * are met:                                                              
+ *                                                                       
+ *  * Redistributions of source code must retain the above copyright     
+ *    notice, this list of conditions and the following disclaimer.      
+ *  * Redistributions in binary form must reproduce the above copyright  
+ *    notice, this list of conditions and the following disclaimer in    
+ *    the documentation and/or other materials provided with the         
+ *    distribution.                                                      
+ *  * Neither the name Texas Instruments nor the names of its            
+ *    contributors may be used to endorse or promote products derived    
+ *    from this software without specific prior written permission.      
+ *                                                                       
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT  
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT      
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT   
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file rgstrySnapshot.c
+ *  \brief Host tool compiling an ini file to a registry snapshot
+ *
+ *  The snapshot holds the init table parsed from the ini file, followed by the ini text,
+ *  and may be given to the driver in place of the ini file (tiwlan_loader -i) to skip the
+ *  parsing at each driver start. The driver takes the table only if the tool was built with
+ *  the driver build flags and ABI (sizes and alignment, e.g. a 32 bits host build for a
+ *  32 bits target), and otherwise parses the ini text of the snapshot.
+ *
+ *      wl1271_rgstry_snapshot <ini file> <snapshot file>
+ *
+ *  \see osRgstry_parser.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "osRgstry_parser.h"
+
+
+int main (int argc, char **argv)
+{
+	TWlanDrvIfObj   tDrv;
+	TInitTable      *pTable;
+	FILE            *pFile;
+	char            *pIni, *pSnap;
+	long            lIniLen;
+	int             iSnapLen;
+
+	if (argc != 3)
+	{
+		printf ("usage: %s <ini file> <snapshot file>\n", argv[0]);
+		return 1;
+	}
+
+	pFile = fopen (argv[1], "rb");
+	if (pFile == NULL)
+	{
+		printf ("%s: can't read %s\n", argv[0], argv[1]);
+		return 1;
+	}
+	fseek (pFile, 0, SEEK_END);
+	lIniLen = ftell (pFile);
+	fseek (pFile, 0, SEEK_SET);
+
+	/* as the loader, which sends the file with a terminating byte */
+	pIni = calloc (1, lIniLen + 1);
+	iSnapLen = sizeof(TRgstrySnapshotHdr) + sizeof(TInitTable) + lIniLen;
+	pSnap = malloc (iSnapLen);
+	pTable = malloc (sizeof(TInitTable));
+	if (pIni == NULL || pSnap == NULL || pTable == NULL ||
+		fread (pIni, 1, lIniLen, pFile) != (size_t)lIniLen)
+	{
+		printf ("%s: can't read %s\n", argv[0], argv[1]);
+		return 1;
+	}
+	fclose (pFile);
+
+	memset (&tDrv, 0, sizeof(tDrv));
+	iSnapLen = osInitTable_Snapshot (&tDrv, pTable, pIni, (int)lIniLen, pSnap, iSnapLen);
+
+	pFile = fopen (argv[2], "wb");
+	if (pFile == NULL || iSnapLen < 0 || fwrite (pSnap, 1, iSnapLen, pFile) != (size_t)iSnapLen)
+	{
+		printf ("%s: can't write %s\n", argv[0], argv[2]);
+		return 1;
+	}
+	fclose (pFile);
+
+	printf ("%s: %s (%ld bytes) to %s (%d bytes, init table %u bytes)\n",
+			argv[0], argv[1], lIniLen, argv[2], iSnapLen, (TI_UINT32)sizeof(TInitTable));
+
+	free (pTable);
+	free (pSnap);
+	free (pIni);
+	return 0;
+}
@@ -0,0 +1,547 @@
+/*
+ * scanResultTable_test.c
+ *
+ * Copyright(c) 1998 - 2010 Texas Instruments. All rights reserved.      
+ * All rights reserved.                                                  
+ *                                                                       
+ * Redistribution and use in source and binary forms, with or without    
+ * modification, are permitted provided that the following conditions    
+ * are met:                                                              
+ *                                                                       
+ *  * Redistributions of source code must retain the above copyright     
+ *    notice, this list of conditions and the following disclaimer.      
+ *  * Redistributions in binary form must reproduce the above copyright  
+ *    notice, this list of conditions and the following disclaimer in    
+ *    the documentation and/or other materials provided with the         
+ *    distribution.                                                      
+ *  * Neither the name Texas Instruments nor the names of its            
+ *    contributors may be used to endorse or promote products derived    
+ *    from this software without specific prior written permission.      
+ *                                                                       
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT  
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT      
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT   
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** \file scanResultTable_test.c
+ *  \brief Host unit test of the scan result table index and aging
+ *
+ *  Replays synthetic scan floods (more APs than the table holds, with hidden and
+ *  multiple SSIDs per BSSID) into scanResultTable.c, and checks the table after each
+ *  frame and aging step against a model of the expected entries. Then replays the
+ *  same flood unchecked and reports the time per frame.
+ *
+ *      wl1271_scanresult_test [scan cycles] [seed]
+ *
+ *  \see scanResultTable.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "tidef.h"
+#include "report.h"
+#include "osApi.h"
+#include "paramOut.h"
+#include "mlmeApi.h"
+#include "siteMgrApi.h"
+#include "scanResultTable.h"
+
+
+#define FLOOD_TABLE_ENTRIES     512
+#define FLOOD_APS               640     /* with their second SSIDs, well over the table size */
+#define FLOOD_VISIBLE_APS       400     /* APs in range in each scan cycle */
+#define FLOOD_AP_STEP           40      /* APs going out of range in each scan cycle */
+#define SCAN_CYCLE_MS           10000
+#define AGING_THRESHOLD_SEC     55      /* half a scan cycle from the entries time stamps */
+
+/* the expected table entry */
+typedef struct
+{
+	TMacAddr    bssid;
+	TSsid       ssid;
+	TI_INT32    rssi;
+	TI_UINT8    channel;
+	TI_UINT32   uTimeStamp;
+} TModelSite;
+
+static TModelSite           aModel[FLOOD_TABLE_ENTRIES];
+static TI_UINT32            uModelNum;
+static TI_UINT32            uModelMax;
+static int                  iErrors;
+
+static dot11_SSID_t         tFrameSsid;
+static dot11_RATES_t        tFrameRates;
+static mlmeFrameInfo_t      tFrameInfo;
+static TScanFrameInfo       tFrame;
+static TI_UINT8             aFrameBody[64];
+
+extern void hostOs_AdvanceTime (TI_UINT32 uMs);
+
+#define CHECK(cond) \
+	do { if (!(cond)) { printf ("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); iErrors++; } } while (0)
+
+#define IS_HIDDEN(pSsid)    (((pSsid)->len == 0) || (((pSsid)->len == 1) && ((pSsid)->str[0] == 0)))
+
+
+/* the site manager services the table calls while updating an entry */
+TI_STATUS siteMgr_getParam (TI_HANDLE hSiteMgr, paramInfo_t *pParam)
+{
+	pParam->content.siteMgrDot11OperationalMode = DOT11_B_MODE;
+	return TI_OK;
+}
+
+void siteMgr_UpdatHtParams (TI_HANDLE hSiteMgr, TSiteEntry *pSite, mlmeFrameInfo_t *pFrameInfo)
+{
+}
+
+/* the frames are built without unknown IEs */
+TI_UINT16 mlmeParser_CopyUnknownIes (TI_HANDLE hOs, beacon_probeRsp_t *pFrame, TI_UINT8 *pBuf, TI_UINT32 uBufLen)
+{
+	return 0;
+}
+
+
+static TI_HANDLE createTable (TI_UINT32 uEntries, EScanResultTableClear eClear)
+{
+	TStadHandlesList    tHandles;
+	TI_HANDLE           hTable;
+
+	memset (&tHandles, 0, sizeof(tHandles));
+	hTable = scanResultTable_Create (NULL, uEntries);
+	CHECK (hTable != NULL);
+	scanResultTable_Init (hTable, &tHandles, eClear);
+	scanResultTable_SetSraThreshold (hTable, AGING_THRESHOLD_SEC);
+	uModelNum = 0;
+	uModelMax = uEntries;
+	return hTable;
+}
+
+static void makeBssid (TMacAddr mac, TI_UINT32 uAp)
+{
+	mac[0] = 0x00;
+	mac[1] = 0x1b;
+	mac[2] = 0x2f;
+	mac[3] = (TI_UINT8)(uAp >> 16);
+	mac[4] = (TI_UINT8)(uAp >> 8);
+	mac[5] = (TI_UINT8)uAp;
+}
+
+static void makeSsid (TSsid *pSsid, const char *pStr, TI_UINT32 uLen)
+{
+	memset (pSsid, 0, sizeof(*pSsid));
+	memcpy (pSsid->str, pStr, uLen);
+	pSsid->len = (TI_UINT8)uLen;
+}
+
+static TI_STATUS receiveFrame (TI_HANDLE hTable, TMacAddr *pBssid, TSsid *pSsid, TI_UINT8 uChannel, TI_INT8 iRssi)
+{
+	memset (&tFrameInfo, 0, sizeof(tFrameInfo));
+	tFrameSsid.hdr[0] = SSID_IE_ID;
+	tFrameSsid.hdr[1] = pSsid->len;
+	memcpy (tFrameSsid.serviceSetId, pSsid->str, pSsid->len);
+	tFrameRates.hdr[0] = SUPPORTED_RATES_IE_ID;
+	tFrameRates.hdr[1] = 2;
+	tFrameRates.rates[0] = 0x82;
+	tFrameRates.rates[1] = 0x8b;
+
+	tFrameInfo.subType = (iRssi & 1) ? BEACON : PROBE_RESPONSE;
+	tFrameInfo.content.iePacket.beaconInerval = 100;
+	tFrameInfo.content.iePacket.pSsid = &tFrameSsid;
+	tFrameInfo.content.iePacket.pRates = &tFrameRates;
+
+	tFrame.bssId = pBssid;
+	tFrame.parsedIEs = &tFrameInfo;
+	tFrame.band = RADIO_BAND_2_4_GHZ;
+	tFrame.channel = uChannel;
+	tFrame.rssi = iRssi;
+	tFrame.rate = DRV_RATE_1M;
+	tFrame.buffer = aFrameBody;
+	tFrame.bufferLength = sizeof(aFrameBody);
+
+	return scanResultTable_UpdateEntry (hTable, pBssid, &tFrame);
+}
+
+static int modelFind (TMacAddr *pBssid, TSsid *pSsid)
+{
+	TI_UINT32 i;
+
+	for (i = 0; i < uModelNum; i++)
+	{
+		if (MAC_EQUAL (aModel[i].bssid, *pBssid) && aModel[i].ssid.len == pSsid->len &&
+			memcmp (aModel[i].ssid.str, pSsid->str, pSsid->len) == 0)
+			return (int)i;
+	}
+	return -1;
+}
+
+/* the hidden SSID entry the table replaces when it is full (the first one in the table) */
+static TI_BOOL findFirstHidden (TI_HANDLE hTable, TMacAddr *pBssid, TSsid *pSsid)
+{
+	TSiteEntry *pSite;
+
+	for (pSite = scanResultTable_GetFirst (hTable); pSite != NULL; pSite = scanResultTable_GetNext (hTable))
+	{
+		if (IS_HIDDEN(&pSite->ssid))
+		{
+			MAC_COPY (*pBssid, pSite->bssid);
+			*pSsid = pSite->ssid;
+			return TI_TRUE;
+		}
+	}
+	return TI_FALSE;
+}
+
+/* passes a frame to the table and to the model, and checks the entry */
+static void receiveAndCheck (TI_HANDLE hTable, TMacAddr *pBssid, TSsid *pSsid, TI_UINT8 uChannel, TI_INT8 iRssi)
+{
+	TMacAddr    tHiddenBssid;
+	TSsid       tHiddenSsid;
+	TI_BOOL     bHidden = TI_FALSE;
+	TI_STATUS   eStatus;
+	TSiteEntry  *pSite;
+	int         iModel;
+
+	iModel = modelFind (pBssid, pSsid);
+	if (iModel < 0 && uModelNum == uModelMax)
+		bHidden = findFirstHidden (hTable, &tHiddenBssid, &tHiddenSsid);
+
+	eStatus = receiveFrame (hTable, pBssid, pSsid, uChannel, iRssi);
+
+	if (iModel >= 0)
+	{
+		CHECK (eStatus == TI_OK);
+		/* a weaker frame from another channel is taken for a ripple, and ignored */
+		if (uChannel == aModel[iModel].channel || iRssi >= aModel[iModel].rssi)
+		{
+			aModel[iModel].rssi = iRssi;
+			aModel[iModel].channel = uChannel;
+		}
+	}
+	else
+	{
+		if (uModelNum < uModelMax)
+		{
+			CHECK (eStatus == TI_OK);
+			iModel = (int)uModelNum++;
+		}
+		else if (bHidden)
+		{
+			CHECK (eStatus == TI_OK);
+			iModel = modelFind (&tHiddenBssid, &tHiddenSsid);
+			CHECK (iModel >= 0);
+			CHECK (scanResultTable_GetBySsidBssidPair (hTable, &tHiddenSsid, &tHiddenBssid) == NULL);
+		}
+		else
+		{
+			CHECK (eStatus == TI_NOK);
+			CHECK (scanResultTable_GetBySsidBssidPair (hTable, pSsid, pBssid) == NULL);
+			return;
+		}
+		if (iModel < 0)
+			return;
+		MAC_COPY (aModel[iModel].bssid, *pBssid);
+		aModel[iModel].ssid = *pSsid;
+		aModel[iModel].rssi = iRssi;
+		aModel[iModel].channel = uChannel;
+	}
+
+	pSite = scanResultTable_GetBySsidBssidPair (hTable, pSsid, pBssid);
+	CHECK (pSite != NULL);
+	if (pSite != NULL)
+	{
+		CHECK (pSite->rssi == aModel[iModel].rssi && pSite->channel == aModel[iModel].channel);
+		aModel[iModel].uTimeStamp = pSite->localTimeStamp;
+	}
+}
+
+/* the table holds the model entries, each found by its SSID and BSSID */
+static void checkTable (TI_HANDLE hTable)
+{
+	TSiteEntry  *pSite;
+	TI_UINT32   uNum = 0;
+	TI_UINT32   i;
+	int         iModel;
+
+	for (pSite = scanResultTable_GetFirst (hTable); pSite != NULL; pSite = scanResultTable_GetNext (hTable))
+	{
+		uNum++;
+		CHECK (scanResultTable_GetBySsidBssidPair (hTable, &pSite->ssid, &pSite->bssid) == pSite);
+		iModel = modelFind (&pSite->bssid, &pSite->ssid);
+		CHECK (iModel >= 0);
+		if (iModel >= 0)
+			CHECK (pSite->rssi == aModel[iModel].rssi && pSite->localTimeStamp == aModel[iModel].uTimeStamp);
+	}
+	CHECK (uNum == uModelNum);
+	for (i = 0; i < uModelNum; i++)
+		CHECK (scanResultTable_GetBySsidBssidPair (hTable, &aModel[i].ssid, &aModel[i].bssid) != NULL);
+}
+
+/* ages the table and the model */
+static void ageAndCheck (TI_HANDLE hTable)
+{
+	TI_UINT32 uOldest = os_timeStampMs (NULL) - AGING_THRESHOLD_SEC * 1000;
+	TI_UINT32 i = 0;
+
+	scanResultTable_PerformAging (hTable);
+	while (i < uModelNum)
+	{
+		if (aModel[i].uTimeStamp < uOldest)
+			aModel[i] = aModel[--uModelNum];
+		else
+			i++;
+	}
+	checkTable (hTable);
+}
+
+static void testUpdate (void)
+{
+	TI_HANDLE   hTable = createTable (4, SCAN_RESULT_TABLE_DONT_CLEAR);
+	TMacAddr    macA, macB, macC, macD, macH;
+	TSsid       tNet, tGuest, tHidden, tNullHidden;
+
+	makeBssid (macA, 1);
+	makeBssid (macB, 2);
+	makeBssid (macC, 3);
+	makeBssid (macD, 4);
+	makeBssid (macH, 5);
+	makeSsid (&tNet, "net", 3);
+	makeSsid (&tGuest, "guest", 5);
+	makeSsid (&tHidden, "", 0);
+	makeSsid (&tNullHidden, "", 1);
+
+	/* a BSSID has an entry per SSID */
+	receiveAndCheck (hTable, &macA, &tNet, 6, -60);
+	receiveAndCheck (hTable, &macB, &tNet, 6, -70);
+	receiveAndCheck (hTable, &macA, &tGuest, 6, -61);
+	CHECK (uModelNum == 3);
+	receiveAndCheck (hTable, &macA, &tNet, 6, -40);
+	CHECK (uModelNum == 3);
+	checkTable (hTable);
+
+	/* ripples from the next channel are ignored, unless stronger */
+	receiveAndCheck (hTable, &macB, &tNet, 7, -80);
+	CHECK (scanResultTable_GetBySsidBssidPair (hTable, &tNet, &macB)->channel == 6);
+	receiveAndCheck (hTable, &macB, &tNet, 7, -50);
+	CHECK (scanResultTable_GetBySsidBssidPair (hTable, &tNet, &macB)->channel == 7);
+
+	/* when full, a new site replaces a hidden SSID site, or is dropped */
+	receiveAndCheck (hTable, &macH, &tHidden, 1, -50);
+	receiveAndCheck (hTable, &macC, &tNet, 1, -50);
+	CHECK (scanResultTable_GetBySsidBssidPair (hTable, &tHidden, &macH) == NULL);
+	receiveAndCheck (hTable, &macD, &tNet, 1, -50);
+	CHECK (scanResultTable_GetBySsidBssidPair (hTable, &tNet, &macD) == NULL);
+	checkTable (hTable);
+
+	/* a NULL filled SSID is hidden too, and is replaced once the table is full again */
+	hostOs_AdvanceTime ((AGING_THRESHOLD_SEC + 1) * 1000);
+	receiveAndCheck (hTable, &macA, &tNet, 6, -40);
+	ageAndCheck (hTable);
+	CHECK (uModelNum == 1);
+	receiveAndCheck (hTable, &macH, &tNullHidden, 1, -50);
+	receiveAndCheck (hTable, &macB, &tNet, 6, -40);
+	receiveAndCheck (hTable, &macC, &tNet, 6, -40);
+	CHECK (uModelNum == 4);
+	receiveAndCheck (hTable, &macD, &tNet, 6, -40);
+	CHECK (scanResultTable_GetBySsidBssidPair (hTable, &tNullHidden, &macH) == NULL);
+	CHECK (scanResultTable_GetBySsidBssidPair (hTable, &tNet, &macD) != NULL);
+	checkTable (hTable);
+
+	scanResultTable_Destroy (hTable);
+}
+
+static void testAgingOrder (void)
+{
+	TI_HANDLE   hTable = createTable (16, SCAN_RESULT_TABLE_DONT_CLEAR);
+	TMacAddr    mac;
+	TSsid       tNet;
+	TI_UINT32   i;
+
+	makeSsid (&tNet, "net", 3);
+	for (i = 0; i < 16; i++)
+	{
+		makeBssid (mac, i);
+		receiveAndCheck (hTable, &mac, &tNet, 1, -50);
+		hostOs_AdvanceTime (1000);
+	}
+	/* the early sites are refreshed, so the middle ones are the oldest */
+	for (i = 0; i < 4; i++)
+	{
+		makeBssid (mac, i);
+		receiveAndCheck (hTable, &mac, &tNet, 1, -51);
+	}
+	hostOs_AdvanceTime ((AGING_THRESHOLD_SEC - 5) * 1000 + 500);
+	ageAndCheck (hTable);
+	CHECK (uModelNum == 8);
+	for (i = 0; i < 16; i++)
+	{
+		makeBssid (mac, i);
+		CHECK ((scanResultTable_GetBySsidBssidPair (hTable, &tNet, &mac) == NULL) == (i >= 4 && i < 12));
+	}
+	hostOs_AdvanceTime (AGING_THRESHOLD_SEC * 1000);
+	ageAndCheck (hTable);
+	CHECK (uModelNum == 0);
+
+	scanResultTable_Destroy (hTable);
+}
+
+static void testClear (void)
+{
+	TI_HANDLE   hTable = createTable (8, SCAN_RESULT_TABLE_CLEAR);
+	TMacAddr    mac;
+	TSsid       tNet;
+	TI_UINT32   i;
+
+	makeSsid (&tNet, "net", 3);
+	for (i = 0; i < 8; i++)
+	{
+		makeBssid (mac, i);
+		receiveAndCheck (hTable, &mac, &tNet, 1, -50);
+	}
+	scanResultTable_SetStableState (hTable);
+	checkTable (hTable);
+
+	/* the first frame of the next scan clears the table */
+	uModelNum = 0;
+	makeBssid (mac, 100);
+	receiveAndCheck (hTable, &mac, &tNet, 1, -50);
+	CHECK (uModelNum == 1);
+	checkTable (hTable);
+	for (i = 0; i < 8; i++)
+	{
+		makeBssid (mac, i);
+		receiveAndCheck (hTable, &mac, &tNet, 1, -50);
+	}
+	CHECK (uModelNum == 8);
+	checkTable (hTable);
+
+	/* and a scan with no frames clears it too */
+	scanResultTable_SetStableState (hTable);
+	scanResultTable_SetStableState (hTable);
+	uModelNum = 0;
+	checkTable (hTable);
+
+	scanResultTable_Destroy (hTable);
+}
+
+/* the SSIDs of a flood AP: some are hidden, some share a BSSID with a guest network */
+static TI_UINT32 floodSsids (TI_UINT32 uAp, TSsid *pSsids)
+{
+	char str[MAX_SSID_LEN];
+
+	if (uAp % 20 == 0)
+		makeSsid (&pSsids[0], "", 1);
+	else if (uAp % 10 == 0)
+		makeSsid (&pSsids[0], "", 0);
+	else
+		makeSsid (&pSsids[0], str, sprintf (str, "net-%u", uAp / 4));
+	if (uAp % 7 == 0)
+	{
+		makeSsid (&pSsids[1], str, sprintf (str, "guest-%u", uAp));
+		return 2;
+	}
+	return 1;
+}
+
+/* 
+ * A walk through a dense area: each scan cycle sees the APs in range in random order,
+ * some twice and some as ripples on the next channel, and then the table is aged.
+ */
+static TI_UINT32 flood (TI_UINT32 uCycles, TI_UINT32 uSeed, TI_BOOL bCheck, double *pUs)
+{
+	TI_HANDLE       hTable = createTable (FLOOD_TABLE_ENTRIES, SCAN_RESULT_TABLE_DONT_CLEAR);
+	static TI_UINT32 aOrder[FLOOD_APS];
+	TSsid           aSsids[2];
+	TMacAddr        mac;
+	TI_UINT32       uCycle, uAp, uSsidsNum, uFrames = 0;
+	TI_UINT32       i, j, uTemp;
+	TI_UINT8        uChannel;
+	TI_INT8         iRssi;
+	struct timeval  t0, t1;
+
+	srand (uSeed);
+	*pUs = 0;
+	for (i = 0; i < FLOOD_APS; i++)
+		aOrder[i] = i;
+
+	for (uCycle = 0; uCycle < uCycles && !iErrors; uCycle++)
+	{
+		hostOs_AdvanceTime (SCAN_CYCLE_MS);
+		for (i = FLOOD_APS - 1; i > 0; i--)
+		{
+			j = rand () % (i + 1);
+			uTemp = aOrder[i];
+			aOrder[i] = aOrder[j];
+			aOrder[j] = uTemp;
+		}
+
+		gettimeofday (&t0, NULL);
+		for (i = 0; i < FLOOD_APS; i++)
+		{
+			uAp = aOrder[i];
+			if ((uAp + uCycle * FLOOD_AP_STEP) % FLOOD_APS >= FLOOD_VISIBLE_APS || rand () % 10 < 2)
+				continue;
+			makeBssid (mac, uAp);
+			uSsidsNum = floodSsids (uAp, aSsids);
+			for (j = 0; j < uSsidsNum * (1 + (rand () % 5 == 0)); j++)
+			{
+				uChannel = 1 + uAp % 11;
+				iRssi = (TI_INT8)(-30 - rand () % 60);
+				if (rand () % 20 == 0)
+				{
+					uChannel = 1 + uChannel % 11;
+				}
+				if (bCheck)
+					receiveAndCheck (hTable, &mac, &aSsids[j % uSsidsNum], uChannel, iRssi);
+				else
+					receiveFrame (hTable, &mac, &aSsids[j % uSsidsNum], uChannel, iRssi);
+				uFrames++;
+			}
+		}
+		scanResultTable_SetStableState (hTable);
+		if (bCheck)
+		{
+			checkTable (hTable);
+			ageAndCheck (hTable);
+		}
+		else
+		{
+			scanResultTable_PerformAging (hTable);
+		}
+		gettimeofday (&t1, NULL);
+		*pUs += (t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_usec - t0.tv_usec);
+	}
+
+	scanResultTable_Destroy (hTable);
+	return uFrames;
+}
+
+int main (int argc, char **argv)
+{
+	TI_UINT32   uCycles = (argc > 1) ? (TI_UINT32)atoi (argv[1]) : 40;
+	TI_UINT32   uSeed = (argc > 2) ? (TI_UINT32)atoi (argv[2]) : 1;
+	TI_UINT32   uFrames;
+	double      fUs;
+
+	testUpdate ();
+	testAgingOrder ();
+	testClear ();
+	flood (uCycles, uSeed, TI_TRUE, &fUs);
+
+	uFrames = flood (uCycles, uSeed, TI_FALSE, &fUs);
+	printf ("scan result table (%d entries, %d APs): %u frames in %u scans, %.0f ns/frame\n",
+			FLOOD_TABLE_ENTRIES, FLOOD_APS, uFrames, uCycles, fUs * 1000 / uFrames);
+
+	printf ("scan result table: %s\n", iErrors ? "FAILED" : "passed");
+	return iErrors ? 1 : 0;
+}
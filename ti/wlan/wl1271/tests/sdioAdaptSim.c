@@ -0,0 +1,269 @@
+/*
+ * sdioAdaptSim.c
+ *
+ * Copyright(c) 1998 - 2010 Texas Instruments. All rights reserved.      
+ * All rights reserved.                                                  
+ *                                                                       
+ * Redistribution and use in source and binary forms, with or without    
+ * modification, are permitted provided that the following conditions    
+ * are met:                                                              
+ *                                                                       
+ *  * Redistributions of source code must retain the above copyright     
+ *    notice, this list of conditions and the following disclaimer.      
+ *  * Redistributions in binary form must reproduce the above copyright  
+ *    notice, this list of conditions and the following disclaimer in    
+ *    the documentation and/or other materials provided with the         
+ *    distribution.                                                      
+ *  * Neither the name Texas Instruments nor the names of its            
+ *    contributors may be used to endorse or promote products derived    
+ *    from this software without specific prior written permission.      
+ *                                                                       
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT  
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT      
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT   
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file sdioAdaptSim.c
+ *  \brief Simulated SDIO adapter for the host tests of the bus driver and TxnQ
+ *
+ *  Stands in for SdioAdapter.c under SdioBusDrv.c: each bus transaction is recorded,
+ *  applied to a simulated device and accounted in a simple bus time model, and is
+ *  either completed in place or left pending until the test completes it (as the
+ *  TxnDone interrupt would).
+ *
+ *  \see sdioAdaptSim.h, SdioAdapter.c
+ */
+
+#include <string.h>
+#include "tidef.h"
+#include "BusDrv.h"
+#include "sdioAdaptSim.h"
+
+
+typedef void (*TSdioSimDoneCb) (void *hCbArg, int iStatus);
+
+static TSdioSimDoneCb   fDoneCb;
+static void *           hDoneCbArg;
+static unsigned char    aRxDmaBuf[SDIO_SIM_DMA_BUF_LEN];
+static unsigned char    aTxDmaBuf[SDIO_SIM_DMA_BUF_LEN];
+
+static unsigned int     bSimAsync;
+static unsigned int     bSimPending;
+static unsigned int     bSimFailNext;
+static TSdioSimTxn      aSimTxns[SDIO_SIM_MAX_TXNS];
+static unsigned int     uSimTxnsNum;
+static unsigned long    uSimBusBytes;
+static unsigned long long uSimBusNs;
+
+static unsigned char    aSimMem[SDIO_SIM_MEM_SIZE];
+static unsigned char    aSimFifo[SDIO_SIM_MEM_SIZE];
+static unsigned int     uSimFifoWritten;
+static unsigned int     uSimFifoRead;
+
+
+int sdioAdapt_ConnectBus (void *        fCbFunc,
+                          void *        hCbArg,
+                          unsigned int  uBlkSizeShift,
+                          unsigned int  uSdioThreadPriority,
+                          unsigned char **pRxDmaBufAddr,
+                          unsigned int  *pRxDmaBufLen,
+                          unsigned char **pTxDmaBufAddr,
+                          unsigned int  *pTxDmaBufLen)
+{
+	fDoneCb = (TSdioSimDoneCb)fCbFunc;
+	hDoneCbArg = hCbArg;
+	*pRxDmaBufAddr = aRxDmaBuf;
+	*pTxDmaBufAddr = aTxDmaBuf;
+	*pRxDmaBufLen = *pTxDmaBufLen = SDIO_SIM_DMA_BUF_LEN;
+	return 0;
+}
+
+int sdioAdapt_DisconnectBus (void)
+{
+	return 0;
+}
+
+static ETxnStatus simTransact (unsigned int  uFuncId,
+                               unsigned int  uHwAddr,
+                               void *        pHostAddr,
+                               unsigned int  uLength,
+                               unsigned int  bDirection,
+                               unsigned int  bBlkMode,
+                               unsigned int  bFixedAddr,
+                               unsigned int  bMore,
+                               unsigned int  bBytes)
+{
+	unsigned char *pHost = (unsigned char *)pHostAddr;
+	unsigned int   i;
+
+	if (uSimTxnsNum < SDIO_SIM_MAX_TXNS)
+	{
+		TSdioSimTxn *pTxn = &aSimTxns[uSimTxnsNum];
+
+		pTxn->uFuncId    = uFuncId;
+		pTxn->uHwAddr    = uHwAddr;
+		pTxn->uLength    = uLength;
+		pTxn->bDirection = bDirection;
+		pTxn->bBlkMode   = bBlkMode;
+		pTxn->bFixedAddr = bFixedAddr;
+		pTxn->bMore      = bMore;
+		pTxn->bBytes     = bBytes;
+	}
+	uSimTxnsNum++;
+	uSimBusBytes += uLength;
+	uSimBusNs += SDIO_SIM_TXN_NS + (unsigned long long)uLength * SDIO_SIM_BYTE_NS;
+
+	if (bSimFailNext)
+	{
+		bSimFailNext = 0;
+		if (bSimAsync)
+		{
+			bSimPending = 2;
+			return TXN_STATUS_PENDING;
+		}
+		return TXN_STATUS_ERROR;
+	}
+
+	for (i = 0; i < uLength; i++)
+	{
+		if (bFixedAddr)
+		{
+			if (bDirection == TXN_DIRECTION_WRITE)
+			{
+				aSimFifo[uSimFifoWritten++ % SDIO_SIM_MEM_SIZE] = pHost[i];
+			}
+			else
+			{
+				pHost[i] = (unsigned char)uSimFifoRead++;
+			}
+		}
+		else
+		{
+			if (bDirection == TXN_DIRECTION_WRITE)
+			{
+				aSimMem[(uHwAddr + i) % SDIO_SIM_MEM_SIZE] = pHost[i];
+			}
+			else
+			{
+				pHost[i] = aSimMem[(uHwAddr + i) % SDIO_SIM_MEM_SIZE];
+			}
+		}
+	}
+
+	if (bSimAsync)
+	{
+		bSimPending = 1;
+		return TXN_STATUS_PENDING;
+	}
+	return TXN_STATUS_COMPLETE;
+}
+
+ETxnStatus sdioAdapt_Transact (unsigned int  uFuncId,
+                               unsigned int  uHwAddr,
+                               void *        pHostAddr,
+                               unsigned int  uLength,
+                               unsigned int  bDirection,
+                               unsigned int  bBlkMode,
+                               unsigned int  bFixedAddr,
+                               unsigned int  bMore)
+{
+	/* the bus driver passes the address mode as "incrementing" */
+	return simTransact (uFuncId, uHwAddr, pHostAddr, uLength, bDirection, bBlkMode, !bFixedAddr, bMore, 0);
+}
+
+ETxnStatus sdioAdapt_TransactBytes (unsigned int  uFuncId,
+                                    unsigned int  uHwAddr,
+                                    void *        pHostAddr,
+                                    unsigned int  uLength,
+                                    unsigned int  bDirection,
+                                    unsigned int  bMore)
+{
+	return simTransact (uFuncId, uHwAddr, pHostAddr, uLength, bDirection, 0, 0, bMore, 1);
+}
+
+
+void sdioSim_Reset (unsigned int bAsync)
+{
+	bSimAsync = bAsync;
+	bSimPending = 0;
+	bSimFailNext = 0;
+	uSimTxnsNum = 0;
+	uSimBusBytes = 0;
+	uSimBusNs = 0;
+	uSimFifoWritten = 0;
+	uSimFifoRead = 0;
+	memset (aSimMem, 0, sizeof(aSimMem));
+	memset (aSimFifo, 0, sizeof(aSimFifo));
+}
+
+unsigned int sdioSim_TxnsNum (void)
+{
+	return uSimTxnsNum;
+}
+
+TSdioSimTxn *sdioSim_Txn (unsigned int uIndex)
+{
+	return (uIndex < uSimTxnsNum && uIndex < SDIO_SIM_MAX_TXNS) ? &aSimTxns[uIndex] : NULL;
+}
+
+unsigned long sdioSim_BusBytes (void)
+{
+	return uSimBusBytes;
+}
+
+unsigned long long sdioSim_BusNs (void)
+{
+	return uSimBusNs;
+}
+
+unsigned int sdioSim_Pending (void)
+{
+	return bSimPending != 0;
+}
+
+void sdioSim_Complete (int iStatus)
+{
+	if (!bSimPending)
+	{
+		return;
+	}
+	if (bSimPending == 2)
+	{
+		iStatus = -1;
+	}
+	/* the CB may start the next transaction */
+	bSimPending = 0;
+	fDoneCb (hDoneCbArg, iStatus);
+}
+
+void sdioSim_CompleteAll (void)
+{
+	while (bSimPending)
+	{
+		sdioSim_Complete (0);
+	}
+}
+
+void sdioSim_FailNext (void)
+{
+	bSimFailNext = 1;
+}
+
+unsigned char *sdioSim_Mem (void)
+{
+	return aSimMem;
+}
+
+unsigned char *sdioSim_FifoWritten (unsigned int *pLength)
+{
+	*pLength = uSimFifoWritten;
+	return aSimFifo;
+}
@@ -0,0 +1,94 @@
+/*
+ * sdioAdaptSim.h
+ *
+ * Copyright(c) 1998 - 2010 Texas Instruments. All rights reserved.      
+ * All rights reserved.                                                  
+ *                                                                       
+ * Redistribution and use in source and binary forms, with or without    
+ * modification, are permitted provided that the following conditions    
+ * are met:                                                              
+ *                                                                       
+ *  * Redistributions of source code must retain the above copyright     
+ *    notice, this list of conditions and the following disclaimer.      
+ *  * Redistributions in binary form must reproduce the above copyright  
+ *    notice, this list of conditions and the following disclaimer in    
+ *    the documentation and/or other materials provided with the         
+ *    distribution.                                                      
+ *  * Neither the name Texas Instruments nor the names of its            
+ *    contributors may be used to endorse or promote products derived    
+ *    from this software without specific prior written permission.      
+ *                                                                       
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT  
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT      
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT   
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file sdioAdaptSim.h
+ *  \brief Simulated SDIO adapter for the host tests of the bus driver and TxnQ
+ *
+ *  \see sdioAdaptSim.c, SdioAdapter.h
+ */
+
+#ifndef __SDIO_ADAPT_SIM_H__
+#define __SDIO_ADAPT_SIM_H__
+
+
+#include "SdioAdapter.h"
+
+
+#define SDIO_SIM_DMA_BUF_LEN    8192        /* As the SdioAdapter of the Linux platform */
+#define SDIO_SIM_MEM_SIZE       0x10000     /* Device memory, addressed modulo its size */
+#define SDIO_SIM_MAX_TXNS       4096        /* Bus transactions recorded */
+
+/* Bus time model: command, interrupt and DMA setup per transaction, and 4-bit bus at 25MHz per byte */
+#define SDIO_SIM_TXN_NS         20000
+#define SDIO_SIM_BYTE_NS        80
+
+
+/* A recorded bus transaction */
+typedef struct
+{
+    unsigned int    uFuncId;
+    unsigned int    uHwAddr;
+    unsigned int    uLength;
+    unsigned int    bDirection;
+    unsigned int    bBlkMode;
+    unsigned int    bFixedAddr;
+    unsigned int    bMore;
+    unsigned int    bBytes;         /* Sent with sdioAdapt_TransactBytes */
+} TSdioSimTxn;
+
+
+/* Clear the record and the device, and complete the transactions in place or only upon sdioSim_Complete */
+void            sdioSim_Reset      (unsigned int bAsync);
+unsigned int    sdioSim_TxnsNum    (void);
+TSdioSimTxn *   sdioSim_Txn        (unsigned int uIndex);
+unsigned long   sdioSim_BusBytes   (void);
+unsigned long long sdioSim_BusNs   (void);
+
+/* Async mode: a transaction is pending until completed, which calls the bus driver TxnDone CB */
+unsigned int    sdioSim_Pending    (void);
+void            sdioSim_Complete   (int iStatus);
+void            sdioSim_CompleteAll (void);
+
+/* The next transaction fails */
+void            sdioSim_FailNext   (void);
+
+/* 
+ * Device memory for incrementing address transactions.
+ * Fixed address transactions go to a FIFO: the written bytes are appended to the FIFO record,
+ *     and reads return the next bytes of a counting pattern ((count of bytes read) & 0xFF).
+ */
+unsigned char * sdioSim_Mem        (void);
+unsigned char * sdioSim_FifoWritten (unsigned int *pLength);
+
+
+#endif /* __SDIO_ADAPT_SIM_H__ */
@@ -0,0 +1,220 @@
+/*
+ * siteHash_bench.c
+ *
+ * Copyright(c) 1998 - 2010 Texas Instruments. All rights reserved.      
+ * All rights reserved.                                                  
+ *                                                                       
+ * Redistribution and use in source and binary forms, with or without    
+ * modification, are permitted provided that the following conditions    
+ * are met:                                                              
+ *                                                                       
+ *  * Redistributions of source code must retain the above copyright     
+ *    notice, this list of conditions and the following disclaimer.      
+ *  * Redistributions in binary form must reproduce the above copyright  
+ *    notice, this list of conditions and the following disclaimer in    
+ *    the documentation and/or other materials provided with the         
+ *    distribution.                                                      
+ *  * Neither the name Texas Instruments nor the names of its            
+ *    contributors may be used to endorse or promote products derived    
+ *    from this software without specific prior written permission.      
+ *                                                                       
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT  
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT      
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT   
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file siteHash_bench.c
+ *  \brief Beacon storm benchmark of the site table lookups
+ *
+ *  Replays beacons and probe responses of a dense environment (by default 120 APs
+ *  over both bands, 1/3 of them on 5GHz) and times what siteMgr_updateSite() and the
+ *  MLME parser do per frame: findSiteEntry() followed by findAndInsertSiteEntry().
+ *  The lookups are then timed alone, and with a linear scan of the site tables for
+ *  reference.
+ *
+ *      wl1271_sitehash_bench [frames] [APs]
+ *
+ *  \see siteHash.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "tidef.h"
+#include "report.h"
+#include "osApi.h"
+#include "siteMgrApi.h"
+#include "siteHash.h"
+
+
+static siteMgrInitParams_t  tDesiredParams;
+static sitesMgmtParams_t    tSitesMgmtParams;
+static siteMgr_t            tSiteMgr;
+
+typedef struct
+{
+	TMacAddr    tBssid;
+	ERadioBand  eBand;
+} TFrame;
+
+
+static void makeBssid (TMacAddr mac, TI_UINT32 uId)
+{
+	mac[0] = 0x00;
+	mac[1] = 0x1B;
+	mac[2] = 0x2F;
+	mac[3] = (TI_UINT8)(uId >> 16);
+	mac[4] = (TI_UINT8)(uId >> 8);
+	mac[5] = (TI_UINT8)uId;
+}
+
+/* findSiteEntry() as it was, a scan of the current and then the other table */
+static siteEntry_t *linearFindSiteEntry (siteMgr_t *pSiteMgr, TMacAddr *mac)
+{
+	siteTablesParams_t *apTables[2];
+	TI_UINT32 uTable, i;
+
+	apTables[0] = pSiteMgr->pSitesMgmtParams->pCurrentSiteTable;
+	apTables[1] = (apTables[0] == &pSiteMgr->pSitesMgmtParams->dot11BG_sitesTables) ?
+				  (siteTablesParams_t *)&pSiteMgr->pSitesMgmtParams->dot11A_sitesTables :
+				  &pSiteMgr->pSitesMgmtParams->dot11BG_sitesTables;
+
+	for (uTable = 0; uTable < 2; uTable++)
+	{
+		for (i = 0; i < apTables[uTable]->maxNumOfSites; i++)
+		{
+			if (MAC_EQUAL (apTables[uTable]->siteTable[i].bssid, *mac))
+			{
+				return &apTables[uTable]->siteTable[i];
+			}
+		}
+	}
+	return NULL;
+}
+
+static double nsNow (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main (int argc, char **argv)
+{
+	TI_UINT32   uFrames = (argc > 1) ? (TI_UINT32)atoi (argv[1]) : 2000000;
+	TI_UINT32   uAps = (argc > 2) ? (TI_UINT32)atoi (argv[2]) : 120;
+	TFrame      *pFrames;
+	TI_UINT32   i, uHits = 0, uMismatch = 0;
+	double      t0, tStorm, tHash, tLinear;
+	siteEntry_t *pSite;
+	volatile TI_UINT32 uSink = 0;
+
+	tDesiredParams.siteMgrDesiredDot11Mode = DOT11_DUAL_MODE;
+	tSiteMgr.pDesiredParams = &tDesiredParams;
+	tSiteMgr.pSitesMgmtParams = &tSitesMgmtParams;
+	tSiteMgr.siteMgrOperationalMode = DOT11_B_MODE;
+	tSitesMgmtParams.dot11A_sitesTables.maxNumOfSites = MAX_SITES_A_BAND;
+	siteMgr_resetSiteTable (&tSiteMgr, (siteTablesParams_t *)&tSitesMgmtParams.dot11A_sitesTables);
+	tSitesMgmtParams.dot11BG_sitesTables.maxNumOfSites = MAX_SITES_BG_BAND;
+	siteMgr_resetSiteTable (&tSiteMgr, &tSitesMgmtParams.dot11BG_sitesTables);
+	tSitesMgmtParams.pCurrentSiteTable = &tSitesMgmtParams.dot11BG_sitesTables;
+
+	/* beacons of random APs, in no particular order */
+	pFrames = malloc (uFrames * sizeof(TFrame));
+	if (pFrames == NULL)
+	{
+		return 1;
+	}
+	srand (1);
+	for (i = 0; i < uFrames; i++)
+	{
+		TI_UINT32 uAp = rand () % uAps;
+		makeBssid (pFrames[i].tBssid, uAp);
+		pFrames[i].eBand = (uAp % 3 == 0) ? RADIO_BAND_5_0_GHZ : RADIO_BAND_2_4_GHZ;
+	}
+
+	/* fill the tables as a first scan would */
+	for (i = 0; i < uAps; i++)
+	{
+		TMacAddr mac;
+		makeBssid (mac, i);
+		pSite = findAndInsertSiteEntry (&tSiteMgr, &mac, (i % 3 == 0) ? RADIO_BAND_5_0_GHZ : RADIO_BAND_2_4_GHZ);
+		if (pSite != NULL)
+		{
+			pSite->siteType = SITE_REGULAR;
+			pSite->localTimeStamp = i + 1;
+		}
+	}
+
+	t0 = nsNow ();
+	for (i = 0; i < uFrames; i++)
+	{
+		pSite = findSiteEntry (&tSiteMgr, &pFrames[i].tBssid);
+		if (pSite == NULL)
+		{
+			pSite = findAndInsertSiteEntry (&tSiteMgr, &pFrames[i].tBssid, pFrames[i].eBand);
+			if (pSite != NULL)
+			{
+				pSite->siteType = SITE_REGULAR;
+			}
+		}
+		else
+		{
+			uHits++;
+		}
+		if (pSite != NULL)
+		{
+			pSite->localTimeStamp = uFrames + i;
+			uSink += pSite->index;
+		}
+	}
+	tStorm = nsNow () - t0;
+
+	/* then the lookups alone, over the final tables */
+	t0 = nsNow ();
+	for (i = 0; i < uFrames; i++)
+	{
+		pSite = findSiteEntry (&tSiteMgr, &pFrames[i].tBssid);
+		uSink += (pSite != NULL) ? pSite->index : 0;
+	}
+	tHash = nsNow () - t0;
+
+	t0 = nsNow ();
+	for (i = 0; i < uFrames; i++)
+	{
+		pSite = linearFindSiteEntry (&tSiteMgr, &pFrames[i].tBssid);
+		uSink += (pSite != NULL) ? pSite->index : 0;
+	}
+	tLinear = nsNow () - t0;
+
+	/* both must agree once the storm is over */
+	for (i = 0; i < uAps; i++)
+	{
+		TMacAddr mac;
+		makeBssid (mac, i);
+		if (findSiteEntry (&tSiteMgr, &mac) != linearFindSiteEntry (&tSiteMgr, &mac))
+		{
+			uMismatch++;
+		}
+	}
+
+	printf ("%u frames from %u APs, tables of %d BG / %d A sites, %u%% found\n",
+			uFrames, uAps, MAX_SITES_BG_BAND, MAX_SITES_A_BAND, (TI_UINT32)(100.0 * uHits / uFrames));
+	printf ("storm:  %6.1f ns per frame (find, insert on a miss)\n", tStorm / uFrames);
+	printf ("hash:   %6.1f ns per lookup\n", tHash / uFrames);
+	printf ("linear: %6.1f ns per lookup\n", tLinear / uFrames);
+	printf ("%s\n", uMismatch ? "FAILED" : "passed");
+
+	free (pFrames);
+	return uMismatch ? 1 : 0;
+}
@@ -0,0 +1,414 @@
+/*
+ * siteHash_test.c
+ *
+ * Copyright(c) 1998 - 2010 Texas Instruments. All rights reserved.      
+ * All rights reserved.                                                  
+ *                                                                       
+ * Redistribution and use in source and binary forms, with or without    
+ * modification, are permitted provided that the following conditions    
+ * are met:                                                              
+ *                                                                       
+ *  * Redistributions of source code must retain the above copyright     
+ *    notice, this list of conditions and the following disclaimer.      
+ *  * Redistributions in binary form must reproduce the above copyright  
+ *    notice, this list of conditions and the following disclaimer in    
+ *    the documentation and/or other materials provided with the         
+ *    distribution.                                                      
+ *  * Neither the name Texas Instruments nor the names of its            
+ *    contributors may be used to endorse or promote products derived    
+ *    from this software without specific prior written permission.      
+ *                                                                       
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT  
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT      
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT   
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file siteHash_test.c
+ *  \brief Host unit test of the site table BSSID hash
+ *
+ *  Runs siteHash.c against a site manager that holds nothing but the site tables,
+ *  and checks every lookup against a linear scan of the tables after each
+ *  insert, remove and aging step.
+ *
+ *      wl1271_sitehash_test [random steps] [seed]
+ *
+ *  \see siteHash.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tidef.h"
+#include "report.h"
+#include "osApi.h"
+#include "siteMgrApi.h"
+#include "siteHash.h"
+
+
+static siteMgrInitParams_t  tDesiredParams;
+static sitesMgmtParams_t    tSitesMgmtParams;
+static siteMgr_t            tSiteMgr;
+static int                  iErrors;
+
+#define CHECK(cond) \
+	do { if (!(cond)) { printf ("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); iErrors++; } } while (0)
+
+#define BG_TABLE()      (&tSitesMgmtParams.dot11BG_sitesTables)
+#define A_TABLE()       ((siteTablesParams_t *)&tSitesMgmtParams.dot11A_sitesTables)
+
+
+static void resetSiteMgr (EDot11Mode eDot11Mode)
+{
+	memset (&tSiteMgr, 0, sizeof(tSiteMgr));
+	memset (&tDesiredParams, 0, sizeof(tDesiredParams));
+	memset (&tSitesMgmtParams, 0, sizeof(tSitesMgmtParams));
+
+	tDesiredParams.siteMgrDesiredDot11Mode = eDot11Mode;
+	tSiteMgr.pDesiredParams = &tDesiredParams;
+	tSiteMgr.pSitesMgmtParams = &tSitesMgmtParams;
+	tSiteMgr.siteMgrOperationalMode = DOT11_B_MODE;
+
+	tSitesMgmtParams.dot11A_sitesTables.maxNumOfSites = MAX_SITES_A_BAND;
+	siteMgr_resetSiteTable (&tSiteMgr, A_TABLE());
+	tSitesMgmtParams.dot11BG_sitesTables.maxNumOfSites = MAX_SITES_BG_BAND;
+	siteMgr_resetSiteTable (&tSiteMgr, BG_TABLE());
+	tSitesMgmtParams.pCurrentSiteTable = BG_TABLE();
+}
+
+static void makeBssid (TMacAddr mac, TI_UINT32 uId)
+{
+	/* an OUI and a sequential NIC part, as seen from multi BSSID APs */
+	mac[0] = 0x00;
+	mac[1] = 0x1B;
+	mac[2] = 0x2F;
+	mac[3] = (TI_UINT8)(uId >> 16);
+	mac[4] = (TI_UINT8)(uId >> 8);
+	mac[5] = (TI_UINT8)uId;
+}
+
+/* the reference: a plain scan of the used entries of one table */
+static siteEntry_t *scanTable (siteTablesParams_t *pTable, TMacAddr *mac)
+{
+	TI_UINT32 i;
+
+	for (i = 0; i < pTable->maxNumOfSites; i++)
+	{
+		if (pTable->siteTable[i].siteType != SITE_NULL && MAC_EQUAL (pTable->siteTable[i].bssid, *mac))
+		{
+			return &pTable->siteTable[i];
+		}
+	}
+	return NULL;
+}
+
+/* every used entry is linked exactly once, in the bucket of its BSSID */
+static void checkHash (siteTablesParams_t *pTable)
+{
+	TI_UINT8  aSeen[SITE_HASH_MAX_SITES];
+	TI_UINT32 uLinked = 0, uUsed = 0, uKey, i;
+	TI_UINT8  index;
+
+	memset (aSeen, 0, sizeof(aSeen));
+	for (uKey = 0; uKey < SITE_HASH_SIZE; uKey++)
+	{
+		for (index = pTable->hashTable[uKey]; index != SITE_HASH_NIL; index = pTable->hashNext[index])
+		{
+			if (index >= pTable->maxNumOfSites || aSeen[index] || uLinked > pTable->maxNumOfSites)
+			{
+				CHECK (!"corrupted hash list");
+				return;
+			}
+			aSeen[index] = 1;
+			uLinked++;
+			CHECK (SITE_HASH_KEY(pTable->siteTable[index].bssid) == uKey);
+		}
+	}
+	for (i = 0; i < pTable->maxNumOfSites; i++)
+	{
+		if (pTable->siteTable[i].siteType != SITE_NULL)
+		{
+			uUsed++;
+			CHECK (aSeen[i]);
+		}
+	}
+	CHECK (uLinked == uUsed);
+	CHECK (uUsed == pTable->numOfSites);
+}
+
+/*
+ * removeSiteEntry() decrements the site count of the table it is given, which is not
+ * always the one holding the site; fix the counts up as the hash is what is tested here
+ */
+static void recountSites (void)
+{
+	TI_UINT32 i;
+
+	BG_TABLE()->numOfSites = 0;
+	A_TABLE()->numOfSites = 0;
+	for (i = 0; i < MAX_SITES_BG_BAND; i++)
+		BG_TABLE()->numOfSites += (BG_TABLE()->siteTable[i].siteType != SITE_NULL);
+	for (i = 0; i < MAX_SITES_A_BAND; i++)
+		A_TABLE()->numOfSites += (A_TABLE()->siteTable[i].siteType != SITE_NULL);
+}
+
+/* what siteMgr_updateSite() does with a received beacon */
+static siteEntry_t *receiveBeacon (TMacAddr mac, ERadioBand eBand, TI_UINT32 uTimeStamp)
+{
+	siteEntry_t *pSite = findAndInsertSiteEntry (&tSiteMgr, (TMacAddr *)mac, eBand);
+
+	if (pSite != NULL)
+	{
+		pSite->siteType = SITE_REGULAR;
+		pSite->localTimeStamp = uTimeStamp;
+	}
+	return pSite;
+}
+
+/* what removeEldestSite() does on aging */
+static void ageOut (siteTablesParams_t *pTable)
+{
+	siteEntry_t *pEldest = NULL;
+	TI_UINT32 i;
+
+	for (i = 0; i < pTable->maxNumOfSites; i++)
+	{
+		siteEntry_t *pSite = &pTable->siteTable[i];
+		if (pSite->siteType != SITE_NULL && (pEldest == NULL || pSite->localTimeStamp < pEldest->localTimeStamp))
+		{
+			pEldest = pSite;
+		}
+	}
+	if (pEldest != NULL)
+	{
+		removeSiteEntry (&tSiteMgr, pTable, pEldest);
+	}
+}
+
+/*****************************************************************************/
+
+static void testInsertFind (void)
+{
+	TMacAddr    mac;
+	siteEntry_t *pSite;
+	TI_UINT32   i;
+
+	resetSiteMgr (DOT11_G_MODE);
+
+	makeBssid (mac, 1);
+	CHECK (findSiteEntry (&tSiteMgr, &mac) == NULL);
+
+	for (i = 0; i < MAX_SITES_BG_BAND; i++)
+	{
+		makeBssid (mac, i);
+		pSite = receiveBeacon (mac, RADIO_BAND_2_4_GHZ, i + 1);
+		CHECK (pSite != NULL);
+		CHECK (receiveBeacon (mac, RADIO_BAND_2_4_GHZ, i + 1) == pSite);
+	}
+	CHECK (BG_TABLE()->numOfSites == MAX_SITES_BG_BAND);
+	checkHash (BG_TABLE());
+
+	for (i = 0; i < MAX_SITES_BG_BAND; i++)
+	{
+		makeBssid (mac, i);
+		pSite = findSiteEntry (&tSiteMgr, &mac);
+		CHECK (pSite != NULL && pSite == scanTable (BG_TABLE(), &mac));
+	}
+
+	/* BSSIDs that differ in their first bytes only share a bucket */
+	makeBssid (mac, 0);
+	mac[0] = 0x02;
+	CHECK (findSiteEntry (&tSiteMgr, &mac) == NULL);
+
+	/* a full table replaces its oldest site */
+	makeBssid (mac, 1000);
+	pSite = receiveBeacon (mac, RADIO_BAND_2_4_GHZ, 5000);
+	CHECK (pSite != NULL);
+	CHECK (BG_TABLE()->numOfSites == MAX_SITES_BG_BAND);
+	CHECK (findSiteEntry (&tSiteMgr, &mac) == pSite);
+	makeBssid (mac, 0);
+	CHECK (findSiteEntry (&tSiteMgr, &mac) == NULL);
+	checkHash (BG_TABLE());
+}
+
+static void testCollisions (void)
+{
+	const TI_UINT32 uNum = (MAX_SITES_BG_BAND < 6) ? MAX_SITES_BG_BAND : 6;
+	TMacAddr    mac;
+	siteEntry_t *apSite[6];
+	TI_BOOL     abRemoved[6];
+	TI_UINT32   i;
+
+	resetSiteMgr (DOT11_G_MODE);
+
+	/* same NIC part under different OUIs, all in one bucket */
+	for (i = 0; i < uNum; i++)
+	{
+		makeBssid (mac, 7);
+		mac[1] = (TI_UINT8)i;
+		apSite[i] = receiveBeacon (mac, RADIO_BAND_2_4_GHZ, i + 1);
+		abRemoved[i] = TI_FALSE;
+	}
+	checkHash (BG_TABLE());
+
+	/* unlink from the middle, the head and the tail of the list */
+	abRemoved[uNum / 2] = TI_TRUE;
+	abRemoved[uNum - 1] = TI_TRUE;
+	abRemoved[0] = TI_TRUE;
+	for (i = 0; i < uNum; i++)
+	{
+		if (abRemoved[i])
+			removeSiteEntry (&tSiteMgr, BG_TABLE(), apSite[i]);
+	}
+	checkHash (BG_TABLE());
+
+	for (i = 0; i < uNum; i++)
+	{
+		makeBssid (mac, 7);
+		mac[1] = (TI_UINT8)i;
+		CHECK (findSiteEntry (&tSiteMgr, &mac) == (abRemoved[i] ? NULL : apSite[i]));
+	}
+}
+
+static void testDualBand (void)
+{
+	TMacAddr    macA, macBG, macNew;
+	siteEntry_t *pSiteA, *pSiteBG;
+
+	resetSiteMgr (DOT11_DUAL_MODE);
+
+	makeBssid (macA, 0x500);
+	makeBssid (macBG, 0x240);
+	pSiteA = receiveBeacon (macA, RADIO_BAND_5_0_GHZ, 1);
+	pSiteBG = receiveBeacon (macBG, RADIO_BAND_2_4_GHZ, 1);
+	CHECK (pSiteA != NULL && pSiteBG != NULL && pSiteA != pSiteBG);
+
+	/* dual mode looks in the other band table too */
+	CHECK (findSiteEntry (&tSiteMgr, &macA) == pSiteA);
+	CHECK (findSiteEntry (&tSiteMgr, &macBG) == pSiteBG);
+	tSitesMgmtParams.pCurrentSiteTable = A_TABLE();
+	CHECK (findSiteEntry (&tSiteMgr, &macBG) == pSiteBG);
+
+	tDesiredParams.siteMgrDesiredDot11Mode = DOT11_A_MODE;
+	CHECK (findSiteEntry (&tSiteMgr, &macBG) == NULL);
+	tDesiredParams.siteMgrDesiredDot11Mode = DOT11_DUAL_MODE;
+
+	/* the IBSS merge changes the BSSID of a site in place */
+	makeBssid (macNew, 0x777);
+	updateSiteEntryBssid (&tSiteMgr, pSiteBG, &macNew);
+	CHECK (findSiteEntry (&tSiteMgr, &macNew) == pSiteBG);
+	CHECK (findSiteEntry (&tSiteMgr, &macBG) == NULL);
+	checkHash (BG_TABLE());
+
+	/* removal through the current table, which doesn't hold the site */
+	removeSiteEntry (&tSiteMgr, A_TABLE(), pSiteBG);
+	recountSites ();
+	CHECK (findSiteEntry (&tSiteMgr, &macNew) == NULL);
+	CHECK (findSiteEntry (&tSiteMgr, &macA) == pSiteA);
+	checkHash (BG_TABLE());
+}
+
+static void testInsertedNotUpdated (void)
+{
+	TMacAddr    mac;
+	siteEntry_t *pSite;
+
+	resetSiteMgr (DOT11_G_MODE);
+
+	/* a site left as SITE_NULL after insertion is reused by the next insertion */
+	makeBssid (mac, 1);
+	pSite = findAndInsertSiteEntry (&tSiteMgr, &mac, RADIO_BAND_2_4_GHZ);
+	CHECK (pSite != NULL);
+	removeSiteEntry (&tSiteMgr, BG_TABLE(), pSite);
+	pSite = findAndInsertSiteEntry (&tSiteMgr, &mac, RADIO_BAND_2_4_GHZ);
+	CHECK (pSite != NULL);
+	pSite->siteType = SITE_NULL;
+	BG_TABLE()->numOfSites--;
+
+	makeBssid (mac, 2);
+	CHECK (receiveBeacon (mac, RADIO_BAND_2_4_GHZ, 1) == pSite);
+	makeBssid (mac, 1);
+	CHECK (findSiteEntry (&tSiteMgr, &mac) == NULL);
+	checkHash (BG_TABLE());
+}
+
+/* random beacons, removals and aging against the reference scan */
+static void testRandom (TI_UINT32 uSteps, TI_UINT32 uSeed)
+{
+	const TI_UINT32 uPool = 3 * (MAX_SITES_BG_BAND + MAX_SITES_A_BAND);
+	TMacAddr    mac;
+	TI_UINT32   uStep, uId, uOp;
+	ERadioBand  eBand;
+	siteTablesParams_t *pTable;
+	siteEntry_t *pSite;
+
+	resetSiteMgr (DOT11_DUAL_MODE);
+	srand (uSeed);
+
+	for (uStep = 0; uStep < uSteps && !iErrors; uStep++)
+	{
+		uId = rand () % uPool;
+		makeBssid (mac, uId);
+		/* a BSSID is only ever seen on one band */
+		eBand = (uId & 1) ? RADIO_BAND_5_0_GHZ : RADIO_BAND_2_4_GHZ;
+		pTable = (eBand == RADIO_BAND_5_0_GHZ) ? A_TABLE() : BG_TABLE();
+		uOp = rand () % 100;
+
+		if (uOp < 80)
+		{
+			pSite = receiveBeacon (mac, eBand, uStep + 1);
+			CHECK (pSite != NULL && pSite == scanTable (pTable, &mac));
+		}
+		else if (uOp < 90)
+		{
+			pSite = scanTable (pTable, &mac);
+			if (pSite != NULL)
+			{
+				removeSiteEntry (&tSiteMgr, pTable, pSite);
+				CHECK (scanTable (pTable, &mac) == NULL);
+			}
+		}
+		else if (uOp < 95)
+		{
+			ageOut (pTable);
+		}
+		else
+		{
+			tSitesMgmtParams.pCurrentSiteTable = (uOp & 1) ? A_TABLE() : BG_TABLE();
+		}
+		checkHash (BG_TABLE());
+		checkHash (A_TABLE());
+
+		for (uId = rand () % 8; uId < uPool; uId += 1 + rand () % 8)
+		{
+			makeBssid (mac, uId);
+			pSite = scanTable (BG_TABLE(), &mac);
+			if (pSite == NULL)
+				pSite = scanTable (A_TABLE(), &mac);
+			CHECK (findSiteEntry (&tSiteMgr, &mac) == pSite);
+		}
+	}
+}
+
+int main (int argc, char **argv)
+{
+	TI_UINT32 uSteps = (argc > 1) ? (TI_UINT32)atoi (argv[1]) : 10000;
+	TI_UINT32 uSeed = (argc > 2) ? (TI_UINT32)atoi (argv[2]) : 1;
+
+	testInsertFind ();
+	testCollisions ();
+	testDualBand ();
+	testInsertedNotUpdated ();
+	testRandom (uSteps, uSeed);
+
+	printf ("site hash (%d BG / %d A sites): %s\n", MAX_SITES_BG_BAND, MAX_SITES_A_BAND,
+			iErrors ? "FAILED" : "passed");
+	return iErrors ? 1 : 0;
+}
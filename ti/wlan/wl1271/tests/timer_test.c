@@ -0,0 +1,484 @@
+/*
+ * timer_test.c
+ *
+ * Copyright(c) 1998 - 2010 Texas Instruments. All rights reserved.      
+ * All rights reserved.                                                  
+ *                                                                       
+ * Redistribution and use in source and binary forms, with or without    
+ * modification, are permitted provided that the following conditions    
+ * are met:                                                              
+ *                                                                       
+ *  * Redistributions of source code must retain the above copyright     
+ *    notice, this list of conditions and the following disclaimer.      
+ *  * Redistributions in binary form must reproduce the above copyright  
+ *    notice, this list of conditions and the following disclaimer in    
+ *    the documentation and/or other materials provided with the         
+ *    distribution.                                                      
+ *  * Neither the name Texas Instruments nor the names of its            
+ *    contributors may be used to endorse or promote products derived    
+ *    from this software without specific prior written permission.      
+ *                                                                       
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT  
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT      
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT   
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file timer_test.c
+ *  \brief Host simulation of the timers wheel
+ *
+ *  Runs thousands of timers of timer.c on a virtual clock that wraps around during the run.
+ *  The timers are started, restarted, stopped and destroyed at random, from outside and from
+ *  their expiry callbacks, and each expiry is checked against a model of the running timers:
+ *  never early, late at most by the OS timer latency, and never after a stop. Then the driver
+ *  state and recovery handling of the expiry events is checked.
+ *
+ *      wl1271_timer_test [timers] [seed] [simulated seconds]
+ *
+ *  \see timer.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tidef.h"
+#include "report.h"
+#include "osApi.h"
+#include "context.h"
+#include "timer.h"
+
+
+#define SIM_START_MS        (0xFFFFFFFF - 100000)   /* the clock wraps 100 seconds into the run */
+#define SIM_MAX_LATENCY_MS  20      /* the most the OS timer is late */
+#define SIM_OPS_PER_STEP    4       /* random timer operations after each OS timer expiry */
+#define SIM_LONG_TIMERS     8       /* timers of days, in the top wheel levels */
+#define SIM_MAX_WAKEUPS_MS  2       /* bounds the OS timer expiries per simulated Msec, in case the wheel stalls */
+#define SIM_MAX_DRAIN_STEPS 1000000
+
+/* the expected timer state */
+typedef struct
+{
+	TI_HANDLE   hTimer;
+	TI_BOOL     bRunning;
+	TI_BOOL     bPeriodic;
+	TI_UINT32   uInterval;
+	TI_UINT32   uDue;
+	TI_UINT32   uStarts;
+	TI_UINT32   uStops;
+	TI_UINT32   uExpiries;
+} TSimTimer;
+
+static TSimTimer           *aSim;
+static TI_UINT32            uSimTimers;
+static TI_HANDLE            hTimerModule;
+static TI_UINT32            uMaxLate;
+static int                  iErrors;
+
+/* the timer module context client */
+static TContextCbFunc       fClientCb;
+static TI_HANDLE            hClientCb;
+static TI_BOOL              bScheduled;
+
+extern void      hostOs_AdvanceTime (TI_UINT32 uMs);
+extern void      hostOs_StopClock (TI_UINT32 uStartMs);
+extern TI_UINT32 hostOs_RunTimers (void);
+extern TI_BOOL   hostOs_NextTimer (TI_UINT32 *pDueMs);
+extern void      hostOs_FailTimerCreate (TI_BOOL bFail);
+
+#define CHECK(cond) \
+	do { if (!(cond)) { printf ("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); iErrors++; } } while (0)
+
+
+TI_UINT32 context_RegisterClient (TI_HANDLE       hContext,
+                                  TContextCbFunc  fCbFunc,
+                                  TI_HANDLE       hCbHndl,
+                                  TI_BOOL         bEnable,
+                                  char           *sName,
+                                  TI_UINT32       uNameSize)
+{
+	fClientCb = fCbFunc;
+	hClientCb = hCbHndl;
+	return 0;
+}
+
+void context_RequestSchedule (TI_HANDLE hContext, TI_UINT32 uClientId)
+{
+	bScheduled = TI_TRUE;
+}
+
+/* the driver task */
+static void driverTask (void)
+{
+	if (bScheduled)
+	{
+		bScheduled = TI_FALSE;
+		fClientCb (hClientCb);
+	}
+}
+
+/* fire the OS timer, at most SIM_MAX_LATENCY_MS late, and handle the expiries */
+static TI_UINT32 step (void)
+{
+	TI_UINT32 uNow = os_timeStampMs (NULL);
+	TI_UINT32 uDue;
+	TI_UINT32 uFired;
+
+	if (!hostOs_NextTimer (&uDue))
+	{
+		return 0;
+	}
+	if ((TI_INT32)(uDue - uNow) > 0)
+	{
+		hostOs_AdvanceTime (uDue - uNow);
+	}
+	if (rand () % 4 == 0)
+	{
+		hostOs_AdvanceTime (rand () % (SIM_MAX_LATENCY_MS + 1));
+	}
+
+	uFired = hostOs_RunTimers ();
+	driverTask ();
+	return uFired;
+}
+
+static TI_UINT32 randomInterval (void)
+{
+	int iRange = rand () % 100;
+
+	if (iRange < 60)
+	{
+		return rand () % 300;
+	}
+	if (iRange < 85)
+	{
+		return 300 + rand () % 5000;
+	}
+	if (iRange < 97)
+	{
+		return 5000 + rand () % 120000;
+	}
+	return 120000 + rand () % 4000000;
+}
+
+static void simExpiry (TI_HANDLE hCbHndl, TI_BOOL bTwdInitOccured);
+
+static void simStart (TSimTimer *pSim, TI_UINT32 uInterval, TI_BOOL bPeriodic)
+{
+	pSim->bRunning  = TI_TRUE;
+	pSim->bPeriodic = bPeriodic;
+	pSim->uInterval = uInterval;
+	pSim->uDue      = os_timeStampMs (NULL) + uInterval;
+	pSim->uStarts++;
+	tmr_StartTimer (pSim->hTimer, simExpiry, (TI_HANDLE)pSim, uInterval, bPeriodic);
+}
+
+static void simExpiry (TI_HANDLE hCbHndl, TI_BOOL bTwdInitOccured)
+{
+	TSimTimer *pSim = (TSimTimer *)hCbHndl;
+	TI_UINT32  uNow = os_timeStampMs (NULL);
+	TI_UINT32  uLate = uNow - pSim->uDue;
+
+	CHECK (pSim->bRunning);
+	CHECK (!bTwdInitOccured);
+	CHECK ((TI_INT32)uLate >= 0);
+	/* a zero interval expires on the Msec after the one the wheel has just processed */
+	CHECK (uLate <= SIM_MAX_LATENCY_MS + 1);
+	if (uLate > uMaxLate && (TI_INT32)uLate >= 0)
+	{
+		uMaxLate = uLate;
+	}
+	pSim->uExpiries++;
+	pSim->bRunning = TI_FALSE;
+
+	if (pSim->bPeriodic)
+	{
+		if (rand () % 16 == 0)
+		{
+			/* not in the wheel while expiring, so not counted as a stop */
+			tmr_StopTimer (pSim->hTimer);
+		}
+		else
+		{
+			/* restarted by the timer module when returning */
+			pSim->bRunning = TI_TRUE;
+			pSim->uDue = uNow + pSim->uInterval;
+			pSim->uStarts++;
+		}
+	}
+	else if (rand () % 4 == 0)
+	{
+		simStart (pSim, randomInterval (), TI_FALSE);
+	}
+}
+
+static void checkStats (TSimTimer *pSim)
+{
+	TTimerStats tStats;
+
+	tmr_GetStats (pSim->hTimer, &tStats);
+	CHECK (tStats.uStarts == pSim->uStarts);
+	CHECK (tStats.uStops == pSim->uStops);
+	CHECK (tStats.uExpiries == pSim->uExpiries);
+	CHECK (tStats.uDropped == 0);
+	CHECK (tStats.uMaxLateMsec <= SIM_MAX_LATENCY_MS + 1);
+	CHECK (tStats.uTotalLateMsec <= tStats.uExpiries * (SIM_MAX_LATENCY_MS + 1));
+}
+
+static void randomOp (void)
+{
+	TSimTimer *pSim = &aSim[SIM_LONG_TIMERS + rand () % (uSimTimers - SIM_LONG_TIMERS)];
+	int        iOp = rand () % 64;
+
+	if (iOp == 0)
+	{
+		/* destroyed whether running or not, and replaced */
+		checkStats (pSim);
+		CHECK (tmr_DestroyTimer (pSim->hTimer) == TI_OK);
+		memset (pSim, 0, sizeof(TSimTimer));
+		pSim->hTimer = tmr_CreateTimer (hTimerModule);
+		CHECK (pSim->hTimer != NULL);
+	}
+	else if (pSim->bRunning && iOp < 32)
+	{
+		tmr_StopTimer (pSim->hTimer);
+		pSim->bRunning = TI_FALSE;
+		pSim->uStops++;
+	}
+	else if (iOp < 52)
+	{
+		simStart (pSim, randomInterval (), TI_FALSE);
+	}
+	else
+	{
+		simStart (pSim, 10 + rand () % 2000, TI_TRUE);
+	}
+}
+
+/* run the timers for the given simulated time, then until all have expired */
+static void simulate (TI_UINT32 uTimers, TI_UINT32 uSeed, TI_UINT32 uSeconds)
+{
+	TI_UINT32   uEnd;
+	TI_UINT32   uWakeups = 0;
+	TI_UINT32   uExpiries = 0;
+	TI_UINT32   uStarts = 0;
+	TI_UINT32   uSteps = 0;
+	TI_UINT32   i, j;
+
+	srand (uSeed);
+	hostOs_StopClock (SIM_START_MS);
+	uMaxLate = 0;
+
+	hTimerModule = tmr_Create (NULL);
+	tmr_Init (hTimerModule, NULL, NULL, NULL);
+	tmr_UpdateDriverState (hTimerModule, TI_TRUE);
+	driverTask ();
+
+	uSimTimers = uTimers;
+	aSim = calloc (uTimers, sizeof(TSimTimer));
+	for (i = 0; i < uTimers; i++)
+	{
+		aSim[i].hTimer = tmr_CreateTimer (hTimerModule);
+		CHECK (aSim[i].hTimer != NULL);
+		if (i < SIM_LONG_TIMERS)
+		{
+			/* from a day and a half (the top level) to over 12 days */
+			simStart (&aSim[i], (1 << 27) + (i << 27), TI_FALSE);
+		}
+		else
+		{
+			simStart (&aSim[i], randomInterval (), rand () % 5 == 0);
+		}
+	}
+
+	uEnd = os_timeStampMs (NULL) + uSeconds * 1000;
+	while ((TI_INT32)(os_timeStampMs (NULL) - uEnd) < 0 && uSteps++ < uSeconds * 1000 * SIM_MAX_WAKEUPS_MS)
+	{
+		uWakeups += step ();
+		for (j = 0; j < SIM_OPS_PER_STEP; j++)
+		{
+			randomOp ();
+		}
+	}
+
+	/* no more restarts, so all the running timers expire and the wheel empties */
+	for (i = 0; i < uTimers; i++)
+	{
+		if (aSim[i].bPeriodic)
+		{
+			if (aSim[i].bRunning)
+			{
+				aSim[i].uStops++;
+			}
+			tmr_StopTimer (aSim[i].hTimer);
+			aSim[i].bRunning = TI_FALSE;
+			aSim[i].bPeriodic = TI_FALSE;
+		}
+	}
+	CHECK ((TI_INT32)(os_timeStampMs (NULL) - uEnd) >= 0);
+	uSteps = 0;
+	while (hostOs_NextTimer (&i) && uSteps++ < SIM_MAX_DRAIN_STEPS)
+	{
+		uWakeups += step ();
+	}
+	CHECK (!hostOs_NextTimer (&i));
+
+	for (i = 0; i < SIM_LONG_TIMERS; i++)
+	{
+		CHECK (aSim[i].uExpiries >= 1);
+	}
+	for (i = 0; i < uTimers; i++)
+	{
+		CHECK (!aSim[i].bRunning);
+		checkStats (&aSim[i]);
+		uExpiries += aSim[i].uExpiries;
+		uStarts += aSim[i].uStarts;
+		CHECK (tmr_DestroyTimer (aSim[i].hTimer) == TI_OK);
+	}
+
+	printf ("timer wheel (%u timers, %u seconds): %u starts, %u expiries on %u OS timer expiries, max latency %u ms\n",
+			uTimers, uSeconds, uStarts, uExpiries, uWakeups, uMaxLate);
+
+	free (aSim);
+	CHECK (tmr_Destroy (hTimerModule) == TI_OK);
+}
+
+
+/* the driver state test expiry callback */
+static TI_UINT32    uStateExpiries;
+static TI_BOOL      bStateTwdInit;
+
+static void stateExpiry (TI_HANDLE hCbHndl, TI_BOOL bTwdInitOccured)
+{
+	uStateExpiries++;
+	bStateTwdInit = bTwdInitOccured;
+}
+
+static void startState (TI_HANDLE hTimer, TI_UINT32 uInterval)
+{
+	tmr_StartTimer (hTimer, stateExpiry, NULL, uInterval, TI_FALSE);
+}
+
+/* expire the timers due in the given time, with or without handling them in the driver task */
+static void advance (TI_UINT32 uMs, TI_BOOL bDriverTask)
+{
+	hostOs_AdvanceTime (uMs);
+	hostOs_RunTimers ();
+	if (bDriverTask)
+	{
+		driverTask ();
+	}
+}
+
+static void testDriverState (void)
+{
+	TI_HANDLE   hTimer[3];
+	TTimerStats tStats;
+	TI_UINT32   i;
+
+	hostOs_StopClock (1000);
+	hTimerModule = tmr_Create (NULL);
+	tmr_Init (hTimerModule, NULL, NULL, NULL);
+	for (i = 0; i < 3; i++)
+	{
+		hTimer[i] = tmr_CreateTimer (hTimerModule);
+	}
+
+	/* expiry in init state */
+	uStateExpiries = 0;
+	startState (hTimer[0], 10);
+	advance (9, TI_TRUE);
+	CHECK (uStateExpiries == 0);
+	advance (1, TI_TRUE);
+	CHECK (uStateExpiries == 1 && !bStateTwdInit);
+
+	/* started in init state, expire in operational state, so are dropped */
+	startState (hTimer[0], 10);
+	startState (hTimer[1], 20);
+	advance (5, TI_TRUE);
+	tmr_UpdateDriverState (hTimerModule, TI_TRUE);
+	driverTask ();
+	advance (20, TI_TRUE);
+	CHECK (uStateExpiries == 1);
+	tmr_GetStats (hTimer[1], &tStats);
+	CHECK (tStats.uDropped == 1 && tStats.uExpiries == 0);
+
+	/* started in operational state, expires in recovery, handled once operational again */
+	startState (hTimer[2], 10);
+	tmr_UpdateDriverState (hTimerModule, TI_FALSE);
+	advance (10, TI_TRUE);
+	CHECK (uStateExpiries == 1);
+	tmr_UpdateDriverState (hTimerModule, TI_TRUE);
+	driverTask ();
+	CHECK (uStateExpiries == 2 && bStateTwdInit);
+
+	/* expired in init state, but not handled before the state is operational, so dropped */
+	tmr_UpdateDriverState (hTimerModule, TI_FALSE);
+	startState (hTimer[0], 10);
+	advance (10, TI_FALSE);
+	tmr_UpdateDriverState (hTimerModule, TI_TRUE);
+	driverTask ();
+	CHECK (uStateExpiries == 2);
+	tmr_GetStats (hTimer[0], &tStats);
+	CHECK (tStats.uDropped == 2 && tStats.uExpiries == 1 && tStats.uStarts == 3);
+
+	/* a stopped timer does not expire, and the OS timer stays armed for a running one */
+	startState (hTimer[0], 10);
+	startState (hTimer[1], 30);
+	tmr_StopTimer (hTimer[0]);
+	advance (29, TI_TRUE);
+	CHECK (uStateExpiries == 2);
+	advance (1, TI_TRUE);
+	CHECK (uStateExpiries == 3 && !bStateTwdInit);
+	tmr_GetStats (hTimer[0], &tStats);
+	CHECK (tStats.uStops == 1);
+
+	/* restarting a running timer moves its expiry */
+	startState (hTimer[0], 10);
+	advance (5, TI_TRUE);
+	startState (hTimer[0], 10);
+	advance (9, TI_TRUE);
+	CHECK (uStateExpiries == 3);
+	advance (1, TI_TRUE);
+	CHECK (uStateExpiries == 4);
+	CHECK (!hostOs_NextTimer (&i));
+
+	for (i = 0; i < 3; i++)
+	{
+		CHECK (tmr_DestroyTimer (hTimer[i]) == TI_OK);
+	}
+	CHECK (tmr_Destroy (hTimerModule) == TI_OK);
+}
+
+/* without the OS timer driving the wheel no timer can be created */
+static void testNoOsTimer (void)
+{
+	hostOs_FailTimerCreate (TI_TRUE);
+	hTimerModule = tmr_Create (NULL);
+	tmr_Init (hTimerModule, NULL, NULL, NULL);
+	hostOs_FailTimerCreate (TI_FALSE);
+
+	CHECK (tmr_CreateTimer (hTimerModule) == NULL);
+	CHECK (tmr_Destroy (hTimerModule) == TI_OK);
+}
+
+
+int main (int argc, char **argv)
+{
+	TI_UINT32   uTimers = (argc > 1) ? (TI_UINT32)atoi (argv[1]) : 4000;
+	TI_UINT32   uSeed = (argc > 2) ? (TI_UINT32)atoi (argv[2]) : 1;
+	TI_UINT32   uSeconds = (argc > 3) ? (TI_UINT32)atoi (argv[3]) : 600;
+
+	testDriverState ();
+	testNoOsTimer ();
+	simulate (uTimers, uSeed, uSeconds);
+
+	printf ("timer wheel: %s\n", iErrors ? "FAILED" : "passed");
+	return iErrors ? 1 : 0;
+}
@@ -0,0 +1,223 @@
+/*
+ * txnQ_bench.c
+ *
+ * Copyright(c) 1998 - 2010 Texas Instruments. All rights reserved.      
+ * All rights reserved.                                                  
+ *                                                                       
+ * Redistribution and use in source and binary forms, with or without    
+ * modification, are permitted provided that the following conditions    
+ * are met:                                                              
+ *                                                                       
+ *  * Redistributions of source code must retain the above copyright     
+ *    notice, this list of conditions and the following disclaimer.      
+ *  * Redistributions in binary form must reproduce the above copyright  
+ *    notice, this list of conditions and the following disclaimer in    
+ *    the documentation and/or other materials provided with the         
+ *    distribution.                                                      
+ *  * Neither the name Texas Instruments nor the names of its            
+ *    contributors may be used to endorse or promote products derived    
+ *    from this software without specific prior written permission.      
+ *                                                                       
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT  
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT      
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT   
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file txnQ_bench.c
+ *  \brief Bus transactions of a FW interrupt load, with and without TxnQ aggregation
+ *
+ *  Replays the transactions of a busy FW interrupt cycle over the simulated SDIO adapter:
+ *  the status read, the Rx packets reads from the Rx FIFO, the Rx counter write, the
+ *  Tx packets writes to the Tx FIFO and an occasional mailbox write. They are queued
+ *  while the status read is on the bus, as when the driver is loaded. The same load is
+ *  run with each aggregation setting, and the bus transactions, bytes and bus time of
+ *  the simulator model are printed. The data read and written must be the same in all.
+ *
+ *      wl1271_txnq_bench [cycles]
+ *
+ *  \see TxnQueue.c, SdioBusDrv.c, sdioAdaptSim.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tidef.h"
+#include "report.h"
+#include "osApi.h"
+#include "TxnDefs.h"
+#include "BusDrv.h"
+#include "TxnQueue.h"
+#include "sdioAdaptSim.h"
+
+
+#define STATUS_ADDR     0x0100
+#define COUNTER_ADDR    0x0300
+#define RX_FIFO_ADDR    0x0400
+#define TX_FIFO_ADDR    0x0800
+#define MAILBOX_ADDR    0x2000
+#define STATUS_LEN      64
+#define MAILBOX_LEN     128
+#define MAX_PKTS        4
+#define MAX_PKT_LEN     1600
+#define CYCLE_TXNS      (3 + 2 * MAX_PKTS)
+
+typedef struct
+{
+	TI_UINT32   uMaxLen;
+	TI_UINT32   uMaxTxns;
+} TAggregCfg;
+
+static const TAggregCfg aCfgs[] = { {0, 1}, {4096, 8}, {8192, 16} };
+
+static TTxnStruct   aTxns[CYCLE_TXNS];
+static TI_UINT8     aBufs[CYCLE_TXNS][MAX_PKT_LEN];
+static TI_UINT32    uTxnsNum;
+static TI_UINT32    uDoneNum;
+static TI_UINT32    uDataHash;
+
+
+static void txnDoneCb (TI_HANDLE hCbHandle, void *pTxn)
+{
+	uDoneNum++;
+}
+
+static void hashData (TI_UINT8 *pData, TI_UINT32 uLen)
+{
+	TI_UINT32 i;
+
+	for (i = 0; i < uLen; i++)
+	{
+		uDataHash = (uDataHash ^ pData[i]) * 16777619;
+	}
+}
+
+static void queueTxn (TI_HANDLE hTxnQ, TI_UINT32 uPrio, TI_UINT32 uDirection, TI_UINT32 uAddrMode, 
+                      TI_UINT32 uHwAddr, TI_UINT32 uLen)
+{
+	TTxnStruct *pTxn = &aTxns[uTxnsNum];
+	TI_UINT8   *pBuf = aBufs[uTxnsNum];
+	TI_UINT32   i;
+
+	memset (pTxn, 0, sizeof(*pTxn));
+	TXN_PARAM_SET(pTxn, uPrio, TXN_FUNC_ID_WLAN, uDirection, uAddrMode);
+	TXN_PARAM_SET_MORE(pTxn, 1);
+	BUILD_TTxnStruct(pTxn, uHwAddr, pBuf, uLen, NULL, NULL);
+	if (uDirection == TXN_DIRECTION_WRITE)
+	{
+		for (i = 0; i < uLen; i++)
+		{
+			pBuf[i] = (TI_UINT8)rand ();
+		}
+	}
+	uTxnsNum++;
+	txnQ_Transact (hTxnQ, pTxn);
+}
+
+static void runLoad (const TAggregCfg *pCfg, TI_UINT32 uCycles)
+{
+	TI_HANDLE   hTxnQ;
+	TBusDrvCfg  tCfg;
+	TI_UINT32   uRxDmaBufLen, uTxDmaBufLen;
+	TI_UINT32   uCycle, uTxns = 0, i;
+	TI_UINT32   uRxCounter = 0;
+	TI_UINT8   *pFifo;
+	TI_UINT32   uFifoLen;
+
+	sdioSim_Reset (TI_TRUE);
+	hTxnQ = txnQ_Create (NULL);
+	txnQ_Init (hTxnQ, NULL, NULL, NULL);
+	txnQ_SetAggregParams (hTxnQ, pCfg->uMaxLen, pCfg->uMaxTxns);
+	memset (&tCfg, 0, sizeof(tCfg));
+	tCfg.tSdioCfg.uBlkSizeShift = 9;
+	txnQ_ConnectBus (hTxnQ, &tCfg, NULL, NULL, &uRxDmaBufLen, &uTxDmaBufLen);
+	txnQ_Open (hTxnQ, TXN_FUNC_ID_WLAN, TXN_NUM_PRIORITYS, txnDoneCb, NULL);
+	txnQ_Run (hTxnQ, TXN_FUNC_ID_WLAN);
+
+	srand (1);
+	uDataHash = 2166136261u;
+	uDoneNum = 0;
+
+	for (uCycle = 0; uCycle < uCycles; uCycle++)
+	{
+		TI_UINT32 uRxPkts = rand () % (MAX_PKTS + 1);
+		TI_UINT32 uTxPkts = rand () % (MAX_PKTS + 1);
+
+		uTxnsNum = 0;
+
+		/* The status read goes on the bus, and the rest are queued behind it */
+		queueTxn (hTxnQ, TXN_HIGH_PRIORITY, TXN_DIRECTION_READ, TXN_INC_ADDR, STATUS_ADDR, STATUS_LEN);
+		for (i = 0; i < uRxPkts; i++)
+		{
+			queueTxn (hTxnQ, TXN_LOW_PRIORITY, TXN_DIRECTION_READ, TXN_FIXED_ADDR, RX_FIFO_ADDR, 64 + rand () % (MAX_PKT_LEN - 64));
+		}
+		if (uRxPkts > 0)
+		{
+			uRxCounter += uRxPkts;
+			queueTxn (hTxnQ, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, COUNTER_ADDR, 4);
+			memcpy (aBufs[uTxnsNum - 1], &uRxCounter, 4);
+		}
+		for (i = 0; i < uTxPkts; i++)
+		{
+			queueTxn (hTxnQ, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_FIXED_ADDR, TX_FIFO_ADDR, 64 + rand () % (MAX_PKT_LEN - 64));
+		}
+		if (uCycle % 8 == 0)
+		{
+			queueTxn (hTxnQ, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, MAILBOX_ADDR, MAILBOX_LEN);
+		}
+		sdioSim_CompleteAll ();
+
+		/* The data read in this cycle */
+		for (i = 0; i < uTxnsNum; i++)
+		{
+			if (TXN_PARAM_GET_DIRECTION((&aTxns[i])) == TXN_DIRECTION_READ)
+			{
+				hashData (aBufs[i], aTxns[i].aLen[0]);
+			}
+		}
+		uTxns += uTxnsNum;
+	}
+
+	/* And the data written */
+	pFifo = sdioSim_FifoWritten (&uFifoLen);
+	hashData (pFifo, (uFifoLen < SDIO_SIM_MEM_SIZE) ? uFifoLen : SDIO_SIM_MEM_SIZE);
+	hashData (sdioSim_Mem (), SDIO_SIM_MEM_SIZE);
+
+	printf ("MaxTxns %2u MaxLen %5u: %7u bus txns for %7u Txns, %9lu bytes, bus time %8.1f ms, data %08x%s\n",
+			pCfg->uMaxTxns, pCfg->uMaxLen, sdioSim_TxnsNum (), uTxns, sdioSim_BusBytes (), 
+			sdioSim_BusNs () / 1e6, uDataHash, (uDoneNum == uTxns) ? "" : " (completions missing)");
+
+	txnQ_Close (hTxnQ, TXN_FUNC_ID_WLAN);
+	txnQ_Destroy (hTxnQ);
+}
+
+int main (int argc, char **argv)
+{
+	TI_UINT32   uCycles = (argc > 1) ? (TI_UINT32)atoi (argv[1]) : 1000;
+	TI_UINT32   uFirstHash = 0;
+	TI_UINT32   i;
+	int         iFailed = 0;
+
+	for (i = 0; i < sizeof(aCfgs) / sizeof(aCfgs[0]); i++)
+	{
+		runLoad (&aCfgs[i], uCycles);
+		if (i == 0)
+		{
+			uFirstHash = uDataHash;
+		}
+		else if (uDataHash != uFirstHash)
+		{
+			iFailed = 1;
+		}
+	}
+
+	printf ("%s\n", iFailed ? "FAILED" : "passed");
+	return iFailed;
+}
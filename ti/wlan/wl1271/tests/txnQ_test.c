@@ -0,0 +1,459 @@
+/*
+ * txnQ_test.c
+ *
+ * Copyright(c) 1998 - 2010 Texas Instruments. All rights reserved.      
+ * All rights reserved.                                                  
+ *                                                                       
+ * Redistribution and use in source and binary forms, with or without    
+ * modification, are permitted provided that the following conditions    
+ * are met:                                                              
+ *                                                                       
+ *  * Redistributions of source code must retain the above copyright     
+ *    notice, this list of conditions and the following disclaimer.      
+ *  * Redistributions in binary form must reproduce the above copyright  
+ *    notice, this list of conditions and the following disclaimer in    
+ *    the documentation and/or other materials provided with the         
+ *    distribution.                                                      
+ *  * Neither the name Texas Instruments nor the names of its            
+ *    contributors may be used to endorse or promote products derived    
+ *    from this software without specific prior written permission.      
+ *                                                                       
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS   
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT     
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR 
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT  
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT      
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, 
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT   
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** \file txnQ_test.c
+ *  \brief Host unit test of the TxnQ scheduling and transactions aggregation
+ *
+ *  Runs TxnQueue.c and SdioBusDrv.c over the simulated SDIO adapter, which records
+ *  the bus transactions. The bus is kept busy (async mode) while transactions are
+ *  queued, and the test then checks which bus transactions they were sent in, the
+ *  data the device got or returned, and the completions reported per transaction.
+ *
+ *      wl1271_txnq_test
+ *
+ *  \see TxnQueue.c, SdioBusDrv.c, sdioAdaptSim.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tidef.h"
+#include "report.h"
+#include "osApi.h"
+#include "TxnDefs.h"
+#include "BusDrv.h"
+#include "TxnQueue.h"
+#include "sdioAdaptSim.h"
+
+
+#define MAX_TEST_TXNS   64
+#define MEM_ADDR        0x1000
+#define FIFO_ADDR       0x400
+
+static TI_HANDLE    hTxnQ;
+static TTxnStruct   aTxns[MAX_TEST_TXNS];
+static TI_UINT8     aBufs[MAX_TEST_TXNS][512];
+static TTxnStruct   tBlocker;
+static TI_UINT8     aBlockerBuf[4];
+static TTxnStruct * aDone[MAX_TEST_TXNS + 1];
+static TI_UINT32    uDoneNum;
+static int          iErrors;
+
+#define CHECK(cond) \
+	do { if (!(cond)) { printf ("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); iErrors++; } } while (0)
+
+
+static void txnDoneCb (TI_HANDLE hCbHandle, void *pTxn)
+{
+	if (uDoneNum < MAX_TEST_TXNS + 1)
+	{
+		aDone[uDoneNum] = (TTxnStruct *)pTxn;
+	}
+	uDoneNum++;
+}
+
+static void openTxnQ (TI_UINT32 uMaxLen, TI_UINT32 uMaxTxns)
+{
+	TBusDrvCfg tCfg;
+	TI_UINT32  uRxDmaBufLen, uTxDmaBufLen;
+
+	sdioSim_Reset (TI_TRUE);
+
+	hTxnQ = txnQ_Create (NULL);
+	txnQ_Init (hTxnQ, NULL, NULL, NULL);
+	txnQ_SetAggregParams (hTxnQ, uMaxLen, uMaxTxns);
+
+	memset (&tCfg, 0, sizeof(tCfg));
+	tCfg.tSdioCfg.uBlkSizeShift = 9;
+	txnQ_ConnectBus (hTxnQ, &tCfg, NULL, NULL, &uRxDmaBufLen, &uTxDmaBufLen);
+
+	txnQ_Open (hTxnQ, TXN_FUNC_ID_WLAN, TXN_NUM_PRIORITYS, txnDoneCb, NULL);
+	txnQ_Run (hTxnQ, TXN_FUNC_ID_WLAN);
+	uDoneNum = 0;
+}
+
+static void closeTxnQ (void)
+{
+	txnQ_Close (hTxnQ, TXN_FUNC_ID_WLAN);
+	txnQ_Close (hTxnQ, TXN_FUNC_ID_BT);
+	txnQ_Destroy (hTxnQ);
+}
+
+static TTxnStruct *buildTxn (TI_UINT32 uIndex, TI_UINT32 uFunc, TI_UINT32 uPrio, TI_UINT32 uDirection, 
+                             TI_UINT32 uAddrMode, TI_UINT32 uHwAddr, TI_UINT32 uLen)
+{
+	TTxnStruct *pTxn = &aTxns[uIndex];
+	TI_UINT32   i;
+
+	memset (pTxn, 0, sizeof(*pTxn));
+	TXN_PARAM_SET(pTxn, uPrio, uFunc, uDirection, uAddrMode);
+	TXN_PARAM_SET_MORE(pTxn, 1);
+	BUILD_TTxnStruct(pTxn, uHwAddr, aBufs[uIndex], uLen, NULL, NULL);
+	for (i = 0; i < uLen; i++)
+	{
+		aBufs[uIndex][i] = (TI_UINT8)(uIndex * 16 + i);
+	}
+	return pTxn;
+}
+
+/* Occupy the bus, so the following transactions are queued */
+static void blockBus (void)
+{
+	memset (&tBlocker, 0, sizeof(tBlocker));
+	TXN_PARAM_SET(((TTxnStruct *)&tBlocker), TXN_HIGH_PRIORITY, TXN_FUNC_ID_WLAN, TXN_DIRECTION_READ, TXN_INC_ADDR);
+	BUILD_TTxnStruct(((TTxnStruct *)&tBlocker), 0, aBlockerBuf, sizeof(aBlockerBuf), NULL, NULL);
+	CHECK (txnQ_Transact (hTxnQ, &tBlocker) == TXN_STATUS_PENDING);
+	CHECK (sdioSim_Pending ());
+}
+
+/* Completes the blocker and everything queued behind it, and forgets the blocker */
+static void runBus (void)
+{
+	sdioSim_CompleteAll ();
+	CHECK (uDoneNum > 0 && aDone[0] == &tBlocker);
+	if (uDoneNum > 0)
+	{
+		memmove (aDone, aDone + 1, (uDoneNum - 1) * sizeof(aDone[0]));
+		uDoneNum--;
+	}
+}
+
+
+/* Priorities first, then functions - single steps before all, stopped functions are skipped */
+static void testSelectOrder (void)
+{
+	openTxnQ (0, 1);
+	txnQ_Open (hTxnQ, TXN_FUNC_ID_BT, 1, txnDoneCb, NULL);
+	txnQ_Run (hTxnQ, TXN_FUNC_ID_BT);
+
+	blockBus ();
+	txnQ_Transact (hTxnQ, buildTxn (0, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, 0x100, 4));
+	txnQ_Transact (hTxnQ, buildTxn (1, TXN_FUNC_ID_WLAN, TXN_HIGH_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, 0x200, 4));
+	txnQ_Transact (hTxnQ, buildTxn (2, TXN_FUNC_ID_BT, TXN_HIGH_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, 0x300, 4));
+	buildTxn (3, TXN_FUNC_ID_WLAN, TXN_HIGH_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, 0x400, 1);
+	TXN_PARAM_SET_SINGLE_STEP((&aTxns[3]), 1);
+	txnQ_Transact (hTxnQ, &aTxns[3]);
+	txnQ_Transact (hTxnQ, buildTxn (4, TXN_FUNC_ID_WLAN, TXN_HIGH_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, 0x500, 4));
+	runBus ();
+
+	CHECK (uDoneNum == 5);
+	CHECK (aDone[0] == &aTxns[3]);
+	CHECK (aDone[1] == &aTxns[2]);
+	CHECK (aDone[2] == &aTxns[1]);
+	CHECK (aDone[3] == &aTxns[4]);
+	CHECK (aDone[4] == &aTxns[0]);
+	CHECK (sdioSim_TxnsNum () == 6);
+	CHECK (sdioSim_Txn (1)->bBytes && sdioSim_Txn (1)->uFuncId == TXN_FUNC_ID_CTRL);
+
+	/* A stopped function is not served until it runs again */
+	uDoneNum = 0;
+	txnQ_Stop (hTxnQ, TXN_FUNC_ID_WLAN);
+	CHECK (txnQ_Transact (hTxnQ, buildTxn (5, TXN_FUNC_ID_WLAN, TXN_HIGH_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, 0x600, 4)) == TXN_STATUS_PENDING);
+	CHECK (!sdioSim_Pending ());
+	txnQ_Transact (hTxnQ, buildTxn (6, TXN_FUNC_ID_BT, TXN_HIGH_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, 0x700, 4));
+	sdioSim_CompleteAll ();
+	CHECK (uDoneNum == 1 && aDone[0] == &aTxns[6]);
+	txnQ_Run (hTxnQ, TXN_FUNC_ID_WLAN);
+	sdioSim_CompleteAll ();
+	CHECK (uDoneNum == 2 && aDone[1] == &aTxns[5]);
+
+	closeTxnQ ();
+}
+
+/* Adjacent writes go in one bus transaction, and each is completed in order */
+static void testAggregWrite (void)
+{
+	TI_UINT32 uFifoLen;
+	TI_UINT8 *pFifo;
+	TI_UINT32 i;
+
+	openTxnQ (4096, 8);
+	blockBus ();
+	for (i = 0; i < 6; i++)
+	{
+		txnQ_Transact (hTxnQ, buildTxn (i, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, MEM_ADDR + i * 16, 16));
+	}
+	runBus ();
+
+	CHECK (sdioSim_TxnsNum () == 2);
+	CHECK (sdioSim_Txn (1)->uHwAddr == MEM_ADDR && sdioSim_Txn (1)->uLength == 6 * 16);
+	CHECK (sdioSim_Txn (1)->bDirection == TXN_DIRECTION_WRITE && !sdioSim_Txn (1)->bFixedAddr);
+	CHECK (uDoneNum == 6);
+	for (i = 0; i < 6; i++)
+	{
+		CHECK (aDone[i] == &aTxns[i]);
+		CHECK (TXN_PARAM_GET_AGGREGATE((&aTxns[i])) == TXN_AGGREGATE_OFF);
+		CHECK (TXN_PARAM_GET_STATUS((&aTxns[i])) == TXN_PARAM_STATUS_OK);
+		CHECK (memcmp (sdioSim_Mem () + MEM_ADDR + i * 16, aBufs[i], 16) == 0);
+	}
+
+	/* Gaps, address mode and direction changes start a new bus transaction */
+	sdioSim_Reset (TI_TRUE);
+	uDoneNum = 0;
+	blockBus ();
+	txnQ_Transact (hTxnQ, buildTxn (0, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, MEM_ADDR, 8));
+	txnQ_Transact (hTxnQ, buildTxn (1, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, MEM_ADDR + 12, 8));
+	txnQ_Transact (hTxnQ, buildTxn (2, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_FIXED_ADDR, FIFO_ADDR, 8));
+	txnQ_Transact (hTxnQ, buildTxn (3, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_FIXED_ADDR, FIFO_ADDR, 8));
+	txnQ_Transact (hTxnQ, buildTxn (4, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_READ, TXN_FIXED_ADDR, FIFO_ADDR, 8));
+	txnQ_Transact (hTxnQ, buildTxn (5, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_FIXED_ADDR, FIFO_ADDR, 8));
+	runBus ();
+
+	CHECK (sdioSim_TxnsNum () == 6);
+	CHECK (sdioSim_Txn (3)->uLength == 16 && sdioSim_Txn (3)->bFixedAddr);
+	CHECK (uDoneNum == 6);
+	pFifo = sdioSim_FifoWritten (&uFifoLen);
+	CHECK (uFifoLen == 24);
+	CHECK (memcmp (pFifo, aBufs[2], 8) == 0 && memcmp (pFifo + 8, aBufs[3], 8) == 0 && memcmp (pFifo + 16, aBufs[5], 8) == 0);
+
+	closeTxnQ ();
+}
+
+/* The Txns number and length limits */
+static void testAggregLimits (void)
+{
+	TI_UINT32 i;
+
+	openTxnQ (4096, 8);
+	blockBus ();
+	for (i = 0; i < 20; i++)
+	{
+		txnQ_Transact (hTxnQ, buildTxn (i, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, MEM_ADDR + i * 16, 16));
+	}
+	runBus ();
+	CHECK (sdioSim_TxnsNum () == 1 + 3);
+	CHECK (sdioSim_Txn (3)->uLength == 4 * 16);
+	CHECK (uDoneNum == 20);
+	closeTxnQ ();
+
+	openTxnQ (40, 8);
+	blockBus ();
+	for (i = 0; i < 20; i++)
+	{
+		txnQ_Transact (hTxnQ, buildTxn (i, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, MEM_ADDR + i * 16, 16));
+	}
+	runBus ();
+	CHECK (sdioSim_TxnsNum () == 1 + 10);
+	CHECK (uDoneNum == 20);
+	for (i = 0; i < 20; i++)
+	{
+		CHECK (memcmp (sdioSim_Mem () + MEM_ADDR + i * 16, aBufs[i], 16) == 0);
+	}
+	closeTxnQ ();
+
+	/* The length is bounded by the DMA buffer: 20 * 500 bytes are 2 in each bus transaction */
+	openTxnQ (65535, 16);
+	blockBus ();
+	for (i = 0; i < 20; i++)
+	{
+		txnQ_Transact (hTxnQ, buildTxn (i, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_FIXED_ADDR, FIFO_ADDR, 500));
+	}
+	runBus ();
+	for (i = 1; i < sdioSim_TxnsNum (); i++)
+	{
+		CHECK (sdioSim_Txn (i)->uLength <= SDIO_SIM_DMA_BUF_LEN);
+	}
+	CHECK (sdioSim_BusBytes () == sizeof(aBlockerBuf) + 20 * 500);
+	CHECK (uDoneNum == 20);
+	closeTxnQ ();
+
+	/* No aggregation */
+	openTxnQ (4096, 1);
+	blockBus ();
+	for (i = 0; i < 5; i++)
+	{
+		txnQ_Transact (hTxnQ, buildTxn (i, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, MEM_ADDR + i * 16, 16));
+	}
+	runBus ();
+	CHECK (sdioSim_TxnsNum () == 1 + 5);
+	closeTxnQ ();
+}
+
+/* Adjacent reads go in one bus transaction, and the data is split to the Txns buffers */
+static void testAggregRead (void)
+{
+	TI_UINT32 uExpected = 0;
+	TI_UINT32 i, j;
+
+	openTxnQ (4096, 8);
+	blockBus ();
+	for (i = 0; i < 5; i++)
+	{
+		txnQ_Transact (hTxnQ, buildTxn (i, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_READ, TXN_FIXED_ADDR, FIFO_ADDR, 10 + i * 30));
+		memset (aBufs[i], 0, sizeof(aBufs[i]));
+	}
+	runBus ();
+
+	CHECK (sdioSim_TxnsNum () == 2);
+	CHECK (sdioSim_Txn (1)->bDirection == TXN_DIRECTION_READ && sdioSim_Txn (1)->uLength == 5 * 10 + 30 * 10);
+	CHECK (uDoneNum == 5);
+	for (i = 0; i < 5; i++)
+	{
+		CHECK (aDone[i] == &aTxns[i]);
+		for (j = 0; j < 10 + i * 30; j++)
+		{
+			CHECK (aBufs[i][j] == (TI_UINT8)uExpected);
+			uExpected++;
+		}
+	}
+
+	/* Incrementing address, from the device memory */
+	sdioSim_Reset (TI_TRUE);
+	uDoneNum = 0;
+	for (i = 0; i < 256; i++)
+	{
+		sdioSim_Mem ()[MEM_ADDR + i] = (TI_UINT8)(255 - i);
+	}
+	blockBus ();
+	for (i = 0; i < 4; i++)
+	{
+		txnQ_Transact (hTxnQ, buildTxn (i, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_READ, TXN_INC_ADDR, MEM_ADDR + i * 64, 64));
+	}
+	runBus ();
+	CHECK (sdioSim_TxnsNum () == 2);
+	for (i = 0; i < 4; i++)
+	{
+		CHECK (memcmp (aBufs[i], sdioSim_Mem () + MEM_ADDR + i * 64, 64) == 0);
+	}
+
+	closeTxnQ ();
+}
+
+/* A failed bus transaction fails all the Txns sent in it */
+static void testAggregError (void)
+{
+	TI_UINT32 i;
+
+	openTxnQ (4096, 8);
+	blockBus ();
+	for (i = 0; i < 3; i++)
+	{
+		txnQ_Transact (hTxnQ, buildTxn (i, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, MEM_ADDR + i * 16, 16));
+	}
+	txnQ_Transact (hTxnQ, buildTxn (3, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_READ, TXN_INC_ADDR, MEM_ADDR, 16));
+	sdioSim_FailNext ();
+	sdioSim_CompleteAll ();
+
+	CHECK (uDoneNum == 5);
+	for (i = 0; i < 3; i++)
+	{
+		CHECK (TXN_PARAM_GET_STATUS((&aTxns[i])) == TXN_PARAM_STATUS_ERROR);
+	}
+	CHECK (TXN_PARAM_GET_STATUS((&aTxns[3])) == TXN_PARAM_STATUS_OK);
+
+	closeTxnQ ();
+}
+
+/* Restart while aggregated Txns are on the bus: they are dropped as the queued ones */
+static void testAggregRestart (void)
+{
+	TI_UINT32 i;
+
+	openTxnQ (4096, 8);
+	blockBus ();
+	for (i = 0; i < 4; i++)
+	{
+		txnQ_Transact (hTxnQ, buildTxn (i, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, MEM_ADDR + i * 16, 16));
+	}
+	sdioSim_Complete (0);
+	CHECK (sdioSim_Pending () && sdioSim_TxnsNum () == 2);
+	txnQ_Transact (hTxnQ, buildTxn (4, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, MEM_ADDR + 64, 16));
+
+	CHECK (txnQ_Restart (hTxnQ, TXN_FUNC_ID_WLAN) == TXN_STATUS_PENDING);
+	uDoneNum = 0;
+	sdioSim_CompleteAll ();
+
+	CHECK (uDoneNum == 1 && aDone[0] == &aTxns[3]);
+	CHECK (TXN_PARAM_GET_STATUS((&aTxns[3])) == TXN_PARAM_STATUS_RECOVERY);
+	for (i = 0; i < 3; i++)
+	{
+		CHECK (TXN_PARAM_GET_AGGREGATE((&aTxns[i])) == TXN_AGGREGATE_OFF);
+	}
+	CHECK (sdioSim_TxnsNum () == 2);
+
+	/* Works normally after the restart */
+	uDoneNum = 0;
+	txnQ_Transact (hTxnQ, buildTxn (5, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, MEM_ADDR, 16));
+	sdioSim_CompleteAll ();
+	CHECK (uDoneNum == 1 && aDone[0] == &aTxns[5]);
+
+	closeTxnQ ();
+}
+
+/* A Tx aggregation built by the caller (TxXfer) is sent on its own and continuously */
+static void testTxAggregation (void)
+{
+	TTxnStruct *pTxn;
+	TI_UINT32   i;
+
+	openTxnQ (4096, 8);
+	blockBus ();
+	txnQ_Transact (hTxnQ, buildTxn (0, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_FIXED_ADDR, FIFO_ADDR, 32));
+	for (i = 1; i <= 3; i++)
+	{
+		pTxn = buildTxn (i, TXN_FUNC_ID_WLAN, TXN_LOW_PRIORITY, TXN_DIRECTION_WRITE, TXN_FIXED_ADDR, FIFO_ADDR, 32);
+		if (i < 3)
+		{
+			TXN_PARAM_SET_AGGREGATE(pTxn, TXN_AGGREGATE_ON);
+		}
+	}
+	txnQ_Transact (hTxnQ, &aTxns[1]);
+	sdioSim_Complete (0);
+	CHECK (sdioSim_Pending () && sdioSim_TxnsNum () == 2 && sdioSim_Txn (1)->uLength == 32);
+
+	/* Aggregation started - a high priority Txn waits for its end */
+	sdioSim_Complete (0);
+	txnQ_Transact (hTxnQ, buildTxn (4, TXN_FUNC_ID_WLAN, TXN_HIGH_PRIORITY, TXN_DIRECTION_WRITE, TXN_INC_ADDR, MEM_ADDR, 16));
+	CHECK (!sdioSim_Pending () && sdioSim_TxnsNum () == 2);
+	txnQ_Transact (hTxnQ, &aTxns[2]);
+	txnQ_Transact (hTxnQ, &aTxns[3]);
+	CHECK (sdioSim_TxnsNum () == 3 && sdioSim_Txn (2)->uLength == 3 * 32);
+	sdioSim_CompleteAll ();
+	CHECK (sdioSim_TxnsNum () == 4 && sdioSim_Txn (3)->uHwAddr == MEM_ADDR);
+
+	closeTxnQ ();
+}
+
+int main (int argc, char **argv)
+{
+	testSelectOrder ();
+	testAggregWrite ();
+	testAggregLimits ();
+	testAggregRead ();
+	testAggregError ();
+	testAggregRestart ();
+	testTxAggregation ();
+
+	printf ("TxnQ aggregation: %s\n", iErrors ? "FAILED" : "passed");
+	return iErrors ? 1 : 0;
+}
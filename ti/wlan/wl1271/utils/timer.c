@@ -35,6 +35,11 @@
 /** \file   timer.c 
  *  \brief  The timers services OS-Independent layer over the OS-API timer services which are OS-Dependent.
  *  
+ *  All the driver timers are kept in a hierarchical timers wheel, driven by a single OS-API timer.
+ *  Starting and stopping a timer only links or unlinks it in a wheel slot. The OS-API timer is
+ *    armed for the next wheel event, and on its expiry all the due timers are moved in one batch
+ *    to the expiry queues, which are handled in the driver context.
+ *
  *  \see    timer.h, osapi.c
  */
 
@@ -48,6 +53,31 @@
 
 #define EXPIRY_QUE_SIZE  QUE_UNLIMITED_SIZE
 
+/*
+ * The timers wheel counts in Msec. Its root level has a slot per Msec for the timers expiring
+ *   in the next 256 Msec, and each of the next levels has 64 slots, each covering a whole turn
+ *   of the level below it, so the wheel covers any 32 bits interval.
+ * Whenever the root level completes a turn, the next slot of level 1 is cascaded into it (and
+ *   when level 1 completes a turn, the next slot of level 2 is cascaded into it, and so on).
+ */
+#define WHEEL_ROOT_BITS         8
+#define WHEEL_LEVEL_BITS        6
+#define WHEEL_ROOT_SIZE         (1 << WHEEL_ROOT_BITS)
+#define WHEEL_LEVEL_SIZE        (1 << WHEEL_LEVEL_BITS)
+#define WHEEL_LEVELS            5   /* The root and 4 levels (8 + 4 * 6 = 32 bits) */
+#define WHEEL_SLOTS             (WHEEL_ROOT_SIZE + (WHEEL_LEVELS - 1) * WHEEL_LEVEL_SIZE)
+
+/* The shift of the time bits indexing level uLevel (1 and above), and its first slot in the wheel */
+#define WHEEL_LEVEL_SHIFT(uLevel)   (WHEEL_ROOT_BITS + ((uLevel) - 1) * WHEEL_LEVEL_BITS)
+#define WHEEL_LEVEL_SLOT(uLevel)    (WHEEL_ROOT_SIZE + ((uLevel) - 1) * WHEEL_LEVEL_SIZE)
+
+/* The occupied slots map covers the root and level 1, the only levels searched for the next event */
+#define WHEEL_MAPPED_SLOTS      (WHEEL_ROOT_SIZE + WHEEL_LEVEL_SIZE)
+#define WHEEL_MAP_WORDS         (WHEEL_MAPPED_SLOTS / 32)
+
+/* Get the timer of a wheel node */
+#define WHEEL_NODE_TIMER(pNode) ((TTimerInfo *)((TI_UINT8 *)(pNode) - TI_FIELD_OFFSET(TTimerInfo, tWheelNodeHdr)))
+
 /* The timer module structure (common to all timers) */
 typedef struct 
 {
@@ -60,13 +90,28 @@ typedef struct
     TI_BOOL     bOperState;     /* TRUE when the driver is in operational state (not init or recovery) */
     TI_UINT32   uTwdInitCount;  /* Increments on each TWD init (i.e. recovery) */
     TI_UINT32   uTimersCount;   /* Number of created timers */
+
+    TI_HANDLE   hOsTimerObj;    /* The OS-API timer driving the wheel */
+    TI_BOOL     bOsTimerArmed;  /* TRUE while the OS-API timer is armed */
+    TI_UINT32   uOsTimerTime;   /* The time the OS-API timer is armed for */
+    TI_UINT32   uWheelTime;     /* The next Msec to be processed by the wheel */
+    TI_UINT32   uWheelCount;    /* Number of timers in the wheel */
+    TI_UINT32   uHighLevelsCount; /* Number of timers in the levels above level 1 */
+    TI_UINT32   aWheelMap[WHEEL_MAP_WORDS]; /* The occupied slots of the root and level 1 */
+    TQueNodeHdr aWheel[WHEEL_SLOTS];        /* The slots lists heads */
+
+    TI_UINT32   uOsTimerExpiries; /* Number of OS-API timer expiries */
+    TI_UINT32   uMaxBatch;      /* Most timers expired on a single OS-API timer expiry */
+    TI_UINT32   uCascades;      /* Number of timers cascaded down the wheel levels */
 } TTimerModule;	
 
 /* Per timer structure */
 typedef struct 
 {
     TI_HANDLE    hTimerModule;             /* The timer module handle (see TTimerModule, needed on expiry) */
-    TI_HANDLE    hOsTimerObj;              /* The OS-API timer object handle */
+    TQueNodeHdr  tWheelNodeHdr;            /* The header used for linking the timer in a wheel slot */
+    TI_UINT32    uWheelSlot;               /* The wheel slot the timer is linked in */
+    TI_UINT32    uExpiryTime;              /* The time the timer expires at */
     TQueNodeHdr  tQueNodeHdr;              /* The header used for queueing the timer */
     TTimerCbFunc fExpiryCbFunc;            /* The CB-function provided by the timer user for expiration */
     TI_HANDLE    hExpiryCbHndl;            /* The CB-function handle */
@@ -74,16 +119,24 @@ typedef struct
     TI_BOOL      bPeriodic;                /* If TRUE, restarted after each expiry */
     TI_BOOL      bOperStateWhenStarted;    /* The bOperState value when the timer was started */
     TI_UINT32    uTwdInitCountWhenStarted; /* The uTwdInitCount value when the timer was started */
+    TTimerStats  tStats;                   /* The timer client statistics */
 } TTimerInfo;	
 
 
+static void      tmr_WheelAdd (TTimerModule *pTimerModule, TTimerInfo *pTimerInfo);
+static void      tmr_WheelRemove (TTimerModule *pTimerModule, TTimerInfo *pTimerInfo);
+static TI_UINT32 tmr_WheelNextEvent (TTimerModule *pTimerModule);
+static TI_UINT32 tmr_WheelRun (TTimerModule *pTimerModule, TI_UINT32 uNow);
+static void      tmr_WheelArm (TTimerModule *pTimerModule, TI_UINT32 uNow);
+
+
 
 
 /** 
  * \fn     tmr_Create 
  * \brief  Create the timer module
  * 
- * Allocate and clear the timer module object.
+ * Allocate and clear the timer module object, and init the wheel slots.
  * 
  * \note   This is NOT a specific timer creation! (see tmr_CreateTimer)
  * \param  hOs - Handle to Os Abstraction Layer
@@ -92,20 +145,26 @@ typedef struct
  */ 
 TI_HANDLE tmr_Create (TI_HANDLE hOs)
 {
-    TI_HANDLE hTimerModule;
+    TTimerModule *pTimerModule;
+    TI_UINT32     uSlot;
 
     /* allocate module object */
-    hTimerModule = os_memoryAlloc (hOs, sizeof(TTimerModule));
+    pTimerModule = os_memoryAlloc (hOs, sizeof(TTimerModule));
 	
-    if (!hTimerModule)
+    if (!pTimerModule)
     {
         WLAN_OS_REPORT (("tmr_Create():  Allocation failed!!\n"));
         return NULL;
     }
 	
-    os_memoryZero (hOs, hTimerModule, (sizeof(TTimerModule)));
+    os_memoryZero (hOs, pTimerModule, (sizeof(TTimerModule)));
+
+    for (uSlot = 0; uSlot < WHEEL_SLOTS; uSlot++)
+    {
+        pTimerModule->aWheel[uSlot].pNext = pTimerModule->aWheel[uSlot].pPrev = &pTimerModule->aWheel[uSlot];
+    }
 
-    return (hTimerModule);
+    return ((TI_HANDLE)pTimerModule);
 }
 
 
@@ -113,7 +172,7 @@ TI_HANDLE tmr_Create (TI_HANDLE hOs)
  * \fn     tmr_Destroy
  * \brief  Destroy the module. 
  * 
- * Free the module's queues and object.
+ * Free the module's OS-API timer, queues and object.
  * 
  * \note   This is NOT a specific timer destruction! (see tmr_DestroyTimer)
  * \param  hTimerModule - The module object
@@ -136,6 +195,12 @@ TI_STATUS tmr_Destroy (TI_HANDLE hTimerModule)
         WLAN_OS_REPORT (("tmr_Destroy():  ERROR - Destroying Timer module but not all timers were destroyed!!\n"));
     }
 
+    /* Free the OS-API timer (not in critical section, since it waits for a running expiry) */
+    if (pTimerModule->hOsTimerObj)
+    {
+        os_timerDestroy (pTimerModule->hOs, pTimerModule->hOsTimerObj);
+    }
+
     /* Destroy the module's queues (protect in critical section)) */
     context_EnterCriticalSection (pTimerModule->hContext);
     que_Destroy (pTimerModule->hInitQueue);
@@ -209,7 +274,8 @@ void tmr_ClearOperQueue (TI_HANDLE hTimerModule)
  * \brief  Init required handles 
  * 
  * Init required handles and module variables, create the init-queue and 
- *     operational-queue, and register as the context-engine client.
+ *     operational-queue, create the OS-API timer driving the wheel,
+ *     and register as the context-engine client.
  * 
  * \note    
  * \param  hTimerModule  - The queue object
@@ -237,6 +303,7 @@ void tmr_Init (TI_HANDLE hTimerModule, TI_HANDLE hOs, TI_HANDLE hReport, TI_HAND
     pTimerModule->bOperState    = TI_FALSE;
     pTimerModule->uTimersCount  = 0;
     pTimerModule->uTwdInitCount = 0;
+    pTimerModule->uWheelTime    = os_timeStampMs (hOs);
 
     /* The offset of the queue-node-header from timer structure entry is needed by the queue */
     uNodeHeaderOffset = TI_FIELD_OFFSET(TTimerInfo, tQueNodeHdr); 
@@ -251,6 +318,13 @@ void tmr_Init (TI_HANDLE hTimerModule, TI_HANDLE hOs, TI_HANDLE hReport, TI_HAND
                                            EXPIRY_QUE_SIZE, 
                                            uNodeHeaderOffset);
 
+    /* Allocate the OS-API timer driving the wheel, providing the common expiry callback with the module handle */
+    pTimerModule->hOsTimerObj = os_timerCreate (pTimerModule->hOs, tmr_GetExpiry, hTimerModule);
+    if (!pTimerModule->hOsTimerObj)
+    {
+        WLAN_OS_REPORT (("tmr_Init():  OS-API Timer allocation failed!!\n"));
+    }
+
     /* Register to the context engine and get the client ID */
     pTimerModule->uContextId = context_RegisterClient (pTimerModule->hContext,
                                                        tmr_HandleExpiry,
@@ -279,6 +353,7 @@ void tmr_Init (TI_HANDLE hTimerModule, TI_HANDLE hOs, TI_HANDLE hReport, TI_HAND
 void tmr_UpdateDriverState (TI_HANDLE hTimerModule, TI_BOOL bOperState)
 {
     TTimerModule *pTimerModule = (TTimerModule *)hTimerModule;
+    TTimerInfo   *pTimerInfo;
 
     if (!pTimerModule)
     {
@@ -306,7 +381,10 @@ void tmr_UpdateDriverState (TI_HANDLE hTimerModule, TI_BOOL bOperState)
         pTimerModule->uTwdInitCount++;
 
         /* Empty the init queue (obsolete). */
-        while (que_Dequeue (pTimerModule->hInitQueue) != NULL) {}
+        while ((pTimerInfo = (TTimerInfo *)que_Dequeue (pTimerModule->hInitQueue)) != NULL)
+        {
+            pTimerInfo->tStats.uDropped++;
+        }
     }
 
     /* Leave critical section */
@@ -325,11 +403,12 @@ void tmr_UpdateDriverState (TI_HANDLE hTimerModule, TI_BOOL bOperState)
  * \fn     tmr_CreateTimer
  * \brief  Create a new timer
  * 
- * Create a new timer object, icluding creating a timer in the OS-API.  
+ * Create a new timer object (the timers share the module's OS-API timer).
  * 
  * \note   This timer creation may be used only after tmr_Create() and tmr_Init() were executed!!
+ *         Fails if tmr_Init() couldn't allocate the OS-API timer.
  * \param  hTimerModule - The module handle
- * \return TI_HANDLE    - The created timer handle
+ * \return TI_HANDLE    - The created timer handle, or NULL on failure
  * \sa     tmr_DestroyTimer
  */ 
 TI_HANDLE tmr_CreateTimer (TI_HANDLE hTimerModule)
@@ -343,6 +422,13 @@ TI_HANDLE tmr_CreateTimer (TI_HANDLE hTimerModule)
         return NULL;
     }
 
+    /* Without the OS-API timer driving the wheel the timer would never expire */
+    if (!pTimerModule->hOsTimerObj)
+    {
+        WLAN_OS_REPORT (("tmr_CreateTimer():  ERROR - No OS-API timer!!\n"));
+        return NULL;
+    }
+
     /* Allocate timer object */
     pTimerInfo = os_memoryAlloc (pTimerModule->hOs, sizeof(TTimerInfo));
     if (!pTimerInfo)
@@ -352,16 +438,6 @@ TI_HANDLE tmr_CreateTimer (TI_HANDLE hTimerModule)
     }
     os_memoryZero (pTimerModule->hOs, pTimerInfo, (sizeof(TTimerInfo)));
 
-    /* Allocate OS-API timer, providing the common expiry callback with the current timer handle */
-    pTimerInfo->hOsTimerObj = os_timerCreate(pTimerModule->hOs, tmr_GetExpiry, (TI_HANDLE)pTimerInfo);
-    if (!pTimerInfo->hOsTimerObj)
-    {
-        TRACE0(pTimerModule->hReport, REPORT_SEVERITY_CONSOLE ,"tmr_CreateTimer():  OS-API Timer allocation failed!!\n");
-        os_memoryFree (pTimerModule->hOs, pTimerInfo, sizeof(TTimerInfo));
-        WLAN_OS_REPORT (("tmr_CreateTimer():  OS-API Timer allocation failed!!\n"));
-        return NULL;
-    }
-
     /* Save the timer module handle in the created timer object (needed for the expiry callback) */
     pTimerInfo->hTimerModule = hTimerModule;
     pTimerModule->uTimersCount++;  /* count created timers */
@@ -375,7 +451,7 @@ TI_HANDLE tmr_CreateTimer (TI_HANDLE hTimerModule)
  * \fn     tmr_DestroyTimer
  * \brief  Destroy the specified timer
  * 
- * Destroy the specified timer object, icluding the timer in the OS-API.  
+ * Destroy the specified timer object, removing it from the wheel if running.
  * 
  * \note   This timer destruction function should be used before tmr_Destroy() is executed!!
  * \param  hTimerInfo - The timer handle
@@ -398,11 +474,15 @@ TI_STATUS tmr_DestroyTimer (TI_HANDLE hTimerInfo)
         return TI_NOK;
     }
 
-    /* Free the OS-API timer */
-    if (pTimerInfo->hOsTimerObj) {
-        os_timerDestroy (pTimerModule->hOs, pTimerInfo->hOsTimerObj);
-        pTimerModule->uTimersCount--;  /* update created timers number */
+    /* Remove the timer from the wheel */
+    context_EnterCriticalSection (pTimerModule->hContext);
+    if (pTimerInfo->tWheelNodeHdr.pNext)
+    {
+        tmr_WheelRemove (pTimerModule, pTimerInfo);
     }
+    pTimerModule->uTimersCount--;  /* update created timers number */
+    context_LeaveCriticalSection (pTimerModule->hContext);
+
     /* Free the timer object */
     os_memoryFree (pTimerModule->hOs, hTimerInfo, sizeof(TTimerInfo));
     return TI_OK;
@@ -413,7 +493,9 @@ TI_STATUS tmr_DestroyTimer (TI_HANDLE hTimerInfo)
  * \fn     tmr_StartTimer
  * \brief  Start a timer
  * 
- * Start the specified timer running.
+ * Start the specified timer running, by linking it in the wheel slot of its expiry time
+ *   (after removing it from its current slot if already running).
+ * The OS-API timer is re-armed only if the timer is its new next event.
  * 
  * \note   Periodic-Timer may be used by applications that serve the timer expiry 
  *           in a single context.
@@ -437,6 +519,8 @@ void tmr_StartTimer (TI_HANDLE     hTimerInfo,
 {
     TTimerInfo   *pTimerInfo   = (TTimerInfo *)hTimerInfo;                 /* The timer handle */     
     TTimerModule *pTimerModule = (TTimerModule *)pTimerInfo->hTimerModule; /* The timer module handle */
+    TI_UINT32     uNow;
+    TI_INT32      iLag;     /* How far the wheel is behind the current time */
 
     if (!pTimerModule)
     {
@@ -444,6 +528,11 @@ void tmr_StartTimer (TI_HANDLE     hTimerInfo,
         return;
     }
 
+    uNow = os_timeStampMs (pTimerModule->hOs);
+
+    /* Enter critical section */
+    context_EnterCriticalSection (pTimerModule->hContext);
+
     /* Save the timer parameters. */
     pTimerInfo->fExpiryCbFunc            = fExpiryCbFunc;
     pTimerInfo->hExpiryCbHndl            = hExpiryCbHndl;
@@ -451,9 +540,40 @@ void tmr_StartTimer (TI_HANDLE     hTimerInfo,
     pTimerInfo->bPeriodic                = bPeriodic;
     pTimerInfo->bOperStateWhenStarted    = pTimerModule->bOperState;
     pTimerInfo->uTwdInitCountWhenStarted = pTimerModule->uTwdInitCount;
+    pTimerInfo->tStats.uStarts++;
 
-    /* Start OS-API timer running */
-    os_timerStart(pTimerModule->hOs, pTimerInfo->hOsTimerObj, uIntervalMsec);
+    /* If already running, remove it from its current slot */
+    if (pTimerInfo->tWheelNodeHdr.pNext)
+    {
+        tmr_WheelRemove (pTimerModule, pTimerInfo);
+    }
+
+    /* An empty wheel is moved to the current time */
+    if (pTimerModule->uWheelCount == 0)
+    {
+        pTimerModule->uWheelTime = uNow;
+    }
+
+    /*
+     * Set the expiry time. The wheel may be ahead of the current time by the Msec it has just
+     *   processed, so a zero interval timer expires on the next processed Msec.
+     */
+    iLag = (TI_INT32)(uNow - pTimerModule->uWheelTime);
+    if (iLag < 0 && uIntervalMsec < (TI_UINT32)(-iLag))
+    {
+        pTimerInfo->uExpiryTime = pTimerModule->uWheelTime;
+    }
+    else
+    {
+        pTimerInfo->uExpiryTime = uNow + uIntervalMsec;
+    }
+
+    /* Link the timer in the wheel and arm the OS-API timer if it is the next event */
+    tmr_WheelAdd (pTimerModule, pTimerInfo);
+    tmr_WheelArm (pTimerModule, uNow);
+
+    /* Leave critical section */
+    context_LeaveCriticalSection (pTimerModule->hContext);
 }
 
 
@@ -461,7 +581,8 @@ void tmr_StartTimer (TI_HANDLE     hTimerInfo,
  * \fn     tmr_StopTimer
  * \brief  Stop a running timer
  * 
- * Stop the specified timer.
+ * Stop the specified timer, by removing it from the wheel.
+ * The OS-API timer is left armed, since another timer may be due by then.
  * 
  * \note   When using this function, it must be considered that timer expiry may happen
  *           right before the timer is stopped, so it can't be assumed that this completely 
@@ -481,8 +602,14 @@ void tmr_StopTimer (TI_HANDLE hTimerInfo)
         return;
     }
 
-    /* Stop OS-API timer running */
-    os_timerStop(pTimerModule->hOs, pTimerInfo->hOsTimerObj);
+    /* Remove the timer from the wheel */
+    context_EnterCriticalSection (pTimerModule->hContext);
+    if (pTimerInfo->tWheelNodeHdr.pNext)
+    {
+        tmr_WheelRemove (pTimerModule, pTimerInfo);
+        pTimerInfo->tStats.uStops++;
+    }
+    context_LeaveCriticalSection (pTimerModule->hContext);
 
     /* Clear periodic flag to prevent timer restart if we are in tmr_HandleExpiry context. */
     pTimerInfo->bPeriodic = TI_FALSE;
@@ -491,21 +618,23 @@ void tmr_StopTimer (TI_HANDLE hTimerInfo)
 
 /** 
  * \fn     tmr_GetExpiry
- * \brief  Called by OS-API upon any timer expiry
+ * \brief  Called by OS-API upon the wheel timer expiry
  * 
- * This is the common callback function called upon expiartion of any timer.
- * It is called by the OS-API in timer expiry context and handles the transition
- *   to the driver's context for handling the expiry event.
+ * This is the callback of the OS-API timer driving the wheel.
+ * It is called by the OS-API in timer expiry context. It moves all the timers due by now
+ *   from the wheel to the expiry queues, re-arms the OS-API timer for the next wheel event,
+ *   and handles the transition to the driver's context for handling the expiry events.
  * 
  * \note   
- * \param  hTimerInfo - The specific timer handle
+ * \param  hTimerModule - The module object
  * \return void
  * \sa     tmr_HandleExpiry
  */ 
-void tmr_GetExpiry (TI_HANDLE hTimerInfo)
+void tmr_GetExpiry (TI_HANDLE hTimerModule)
 {
-    TTimerInfo   *pTimerInfo   = (TTimerInfo *)hTimerInfo;                 /* The timer handle */     
-    TTimerModule *pTimerModule = (TTimerModule *)pTimerInfo->hTimerModule; /* The timer module handle */
+    TTimerModule *pTimerModule = (TTimerModule *)hTimerModule; /* The timer module handle */
+    TI_UINT32     uNow;
+    TI_UINT32     uExpired;  /* Number of timers moved to the expiry queues */
 
     if (!pTimerModule)
     {
@@ -513,33 +642,31 @@ void tmr_GetExpiry (TI_HANDLE hTimerInfo)
         return;
     }
 
+    uNow = os_timeStampMs (pTimerModule->hOs);
+
     /* Enter critical section */
     context_EnterCriticalSection (pTimerModule->hContext);
 
-    /* 
-     * If the expired timer was started when the driver's state was Operational,
-     *   insert it to the Operational-queue 
-     */
-    if (pTimerInfo->bOperStateWhenStarted)
-    {
-        que_Enqueue (pTimerModule->hOperQueue, hTimerInfo);
-    }
+    pTimerModule->bOsTimerArmed = TI_FALSE;
+    pTimerModule->uOsTimerExpiries++;
 
-    /* 
-     * Else (started when driver's state was NOT-Operational), if now the state is still
-     *   NOT Operational insert it to the Init-queue.
-     *   (If state changed from non-operational to operational the event is ignored)
-     */
-    else if (!pTimerModule->bOperState)
+    /* Expire all due timers and re-arm for the next event */
+    uExpired = tmr_WheelRun (pTimerModule, uNow);
+    tmr_WheelArm (pTimerModule, uNow);
+
+    if (uExpired > pTimerModule->uMaxBatch)
     {
-        que_Enqueue (pTimerModule->hInitQueue, hTimerInfo);
+        pTimerModule->uMaxBatch = uExpired;
     }
 
     /* Leave critical section */
     context_LeaveCriticalSection (pTimerModule->hContext);
 
     /* Request switch to driver context for handling timer events */
-    context_RequestSchedule (pTimerModule->hContext, pTimerModule->uContextId);
+    if (uExpired)
+    {
+        context_RequestSchedule (pTimerModule->hContext, pTimerModule->uContextId);
+    }
 }
 
 
@@ -562,6 +689,8 @@ void tmr_HandleExpiry (TI_HANDLE hTimerModule)
     TTimerModule *pTimerModule = (TTimerModule *)hTimerModule; /* The timer module handle */
     TTimerInfo   *pTimerInfo;      /* The timer handle */     
     TI_BOOL       bTwdInitOccured; /* Indicates if TWD init occured since timer start */
+    TI_UINT32     uNow;
+    TI_UINT32     uLate;           /* The expiry handling latency in Msec */
 
     if (!pTimerModule)
     {
@@ -569,6 +698,8 @@ void tmr_HandleExpiry (TI_HANDLE hTimerModule)
         return;
     }
 
+    uNow = os_timeStampMs (pTimerModule->hOs);
+
     while (1)
     {
         /* Enter critical section */
@@ -595,6 +726,15 @@ void tmr_HandleExpiry (TI_HANDLE hTimerModule)
             return;  /** EXIT Point **/
         }
 
+        /* Update the client statistics */
+        uLate = ((TI_INT32)(uNow - pTimerInfo->uExpiryTime) > 0) ? uNow - pTimerInfo->uExpiryTime : 0;
+        pTimerInfo->tStats.uExpiries++;
+        pTimerInfo->tStats.uTotalLateMsec += uLate;
+        if (uLate > pTimerInfo->tStats.uMaxLateMsec)
+        {
+            pTimerInfo->tStats.uMaxLateMsec = uLate;
+        }
+
         /* If current TWD-Init-Count is different than when the timer was started, Init occured. */
         bTwdInitOccured = (pTimerModule->uTwdInitCount != pTimerInfo->uTwdInitCountWhenStarted);
 
@@ -614,6 +754,367 @@ void tmr_HandleExpiry (TI_HANDLE hTimerModule)
 }
 
 
+/**
+ * \fn     tmr_GetStats
+ * \brief  Get a timer client statistics
+ *
+ * Copy the specified timer starts, stops, expiries and expiry latency counters.
+ *
+ * \note
+ * \param  hTimerInfo - The specific timer handle
+ * \param  pStats     - Returns the timer statistics
+ * \return void
+ * \sa     tmr_PrintTimer
+ */
+void tmr_GetStats (TI_HANDLE hTimerInfo, TTimerStats *pStats)
+{
+    TTimerInfo *pTimerInfo = (TTimerInfo *)hTimerInfo;
+
+    *pStats = pTimerInfo->tStats;
+}
+
+
+/**
+ * \fn     tmr_WheelAdd
+ * \brief  Link a timer in the wheel
+ *
+ * Link the timer in the root slot of its expiry Msec if it expires within the root turn,
+ *   or else in the slot of the lowest level covering its expiry time.
+ *
+ * \note   Called in critical section
+ * \param  pTimerModule - The module object
+ * \param  pTimerInfo   - The timer, with its expiry time set
+ * \return void
+ * \sa     tmr_WheelRemove
+ */
+static void tmr_WheelAdd (TTimerModule *pTimerModule, TTimerInfo *pTimerInfo)
+{
+    TI_UINT32    uExpiry = pTimerInfo->uExpiryTime;
+    TI_UINT32    uDelta  = uExpiry - pTimerModule->uWheelTime;
+    TI_UINT32    uLevel;
+    TI_UINT32    uSlot;
+    TQueNodeHdr *pHead;
+
+    if (uDelta < WHEEL_ROOT_SIZE)
+    {
+        uSlot = uExpiry & (WHEEL_ROOT_SIZE - 1);
+    }
+    else
+    {
+        for (uLevel = 1; uLevel < WHEEL_LEVELS - 1; uLevel++)
+        {
+            if ((uDelta >> WHEEL_LEVEL_SHIFT(uLevel + 1)) == 0)
+            {
+                break;
+            }
+        }
+        uSlot = WHEEL_LEVEL_SLOT(uLevel) + ((uExpiry >> WHEEL_LEVEL_SHIFT(uLevel)) & (WHEEL_LEVEL_SIZE - 1));
+    }
+
+    /* Link the timer at the slot tail (so same time timers expire in their start order) */
+    pHead = &pTimerModule->aWheel[uSlot];
+    pTimerInfo->tWheelNodeHdr.pNext = pHead;
+    pTimerInfo->tWheelNodeHdr.pPrev = pHead->pPrev;
+    pHead->pPrev->pNext = &pTimerInfo->tWheelNodeHdr;
+    pHead->pPrev = &pTimerInfo->tWheelNodeHdr;
+    pTimerInfo->uWheelSlot = uSlot;
+
+    if (uSlot < WHEEL_MAPPED_SLOTS)
+    {
+        pTimerModule->aWheelMap[uSlot >> 5] |= (TI_UINT32)1 << (uSlot & 31);
+    }
+    else
+    {
+        pTimerModule->uHighLevelsCount++;
+    }
+    pTimerModule->uWheelCount++;
+}
+
+
+/**
+ * \fn     tmr_WheelRemove
+ * \brief  Unlink a timer from the wheel
+ *
+ * \note   Called in critical section, only for a timer linked in the wheel
+ * \param  pTimerModule - The module object
+ * \param  pTimerInfo   - The timer
+ * \return void
+ * \sa     tmr_WheelAdd
+ */
+static void tmr_WheelRemove (TTimerModule *pTimerModule, TTimerInfo *pTimerInfo)
+{
+    TQueNodeHdr *pNode = &pTimerInfo->tWheelNodeHdr;
+    TI_UINT32    uSlot = pTimerInfo->uWheelSlot;
+
+    pNode->pPrev->pNext = pNode->pNext;
+    pNode->pNext->pPrev = pNode->pPrev;
+    pNode->pNext = pNode->pPrev = NULL;
+
+    if (uSlot < WHEEL_MAPPED_SLOTS)
+    {
+        /* Clear the slot from the map if it is now empty */
+        if (pTimerModule->aWheel[uSlot].pNext == &pTimerModule->aWheel[uSlot])
+        {
+            pTimerModule->aWheelMap[uSlot >> 5] &= ~((TI_UINT32)1 << (uSlot & 31));
+        }
+    }
+    else
+    {
+        pTimerModule->uHighLevelsCount--;
+    }
+    pTimerModule->uWheelCount--;
+}
+
+
+/**
+ * \fn     tmr_WheelFindSlot
+ * \brief  Find the next occupied slot of the root or level 1
+ *
+ * Search the occupied slots map cyclically, a map word at a time.
+ *
+ * \note
+ * \param  pTimerModule - The module object
+ * \param  uFirstSlot   - The first wheel slot of the level
+ * \param  uSize        - The level size
+ * \param  uFrom        - The level index the search starts from
+ * \return The distance in slots from uFrom to the next occupied slot, or uSize if none
+ * \sa     tmr_WheelNextEvent
+ */
+static TI_UINT32 tmr_WheelFindSlot (TTimerModule *pTimerModule, TI_UINT32 uFirstSlot, TI_UINT32 uSize, TI_UINT32 uFrom)
+{
+    TI_UINT32 uOffset;
+    TI_UINT32 uSlot;
+    TI_UINT32 uBits;
+
+    for (uOffset = 0; uOffset < uSize; uOffset += 32 - (uSlot & 31))
+    {
+        uSlot = uFirstSlot + ((uFrom + uOffset) & (uSize - 1));
+        uBits = pTimerModule->aWheelMap[uSlot >> 5] >> (uSlot & 31);
+        if (uBits)
+        {
+            while (!(uBits & 1))
+            {
+                uBits >>= 1;
+                uOffset++;
+            }
+            return uOffset;
+        }
+    }
+
+    return uSize;
+}
+
+
+/**
+ * \fn     tmr_WheelNextEvent
+ * \brief  Find the wheel next event
+ *
+ * The wheel next event is the earlier of its next occupied root slot, and the next root turn
+ *   end on which an occupied level 1 slot is cascaded. The higher levels are conservatively
+ *   taken as due on each level 1 turn end.
+ *
+ * \note   Called in critical section, only when the wheel is not empty
+ * \param  pTimerModule - The module object
+ * \return The distance in Msec from the wheel time to its next event
+ * \sa     tmr_WheelRun, tmr_WheelArm
+ */
+static TI_UINT32 tmr_WheelNextEvent (TTimerModule *pTimerModule)
+{
+    TI_UINT32 uTime = pTimerModule->uWheelTime;
+    TI_UINT32 uNext;
+    TI_UINT32 uToTurnEnd;  /* Msec to the next root turn end (0 if the wheel time is one) */
+    TI_UINT32 uIndex;      /* The level 1 index of that turn end */
+    TI_UINT32 uTurns;
+
+    uNext = tmr_WheelFindSlot (pTimerModule, 0, WHEEL_ROOT_SIZE, uTime & (WHEEL_ROOT_SIZE - 1));
+    if (uNext == WHEEL_ROOT_SIZE)
+    {
+        uNext = 0xFFFFFFFF;
+    }
+
+    uToTurnEnd = (WHEEL_ROOT_SIZE - (uTime & (WHEEL_ROOT_SIZE - 1))) & (WHEEL_ROOT_SIZE - 1);
+    uIndex     = ((uTime + uToTurnEnd) >> WHEEL_ROOT_BITS) & (WHEEL_LEVEL_SIZE - 1);
+    uTurns     = tmr_WheelFindSlot (pTimerModule, WHEEL_LEVEL_SLOT(1), WHEEL_LEVEL_SIZE, uIndex);
+
+    /* The higher levels are cascaded on level 1 index 0 */
+    if (pTimerModule->uHighLevelsCount && uTurns > ((WHEEL_LEVEL_SIZE - uIndex) & (WHEEL_LEVEL_SIZE - 1)))
+    {
+        uTurns = (WHEEL_LEVEL_SIZE - uIndex) & (WHEEL_LEVEL_SIZE - 1);
+    }
+
+    if (uTurns < WHEEL_LEVEL_SIZE && uToTurnEnd + (uTurns << WHEEL_ROOT_BITS) < uNext)
+    {
+        uNext = uToTurnEnd + (uTurns << WHEEL_ROOT_BITS);
+    }
+
+    return uNext;
+}
+
+
+/**
+ * \fn     tmr_WheelCascade
+ * \brief  Cascade the wheel levels on a root turn end
+ *
+ * Move the timers of the level 1 slot of the current turn down to the root, and so on
+ *   up the levels while each level completes its own turn.
+ *
+ * \note   Called in critical section, when the wheel time is a root turn end
+ * \param  pTimerModule - The module object
+ * \return void
+ * \sa     tmr_WheelRun
+ */
+static void tmr_WheelCascade (TTimerModule *pTimerModule)
+{
+    TI_UINT32    uLevel = 1;
+    TI_UINT32    uIndex;
+    TQueNodeHdr *pHead;
+    TTimerInfo  *pTimerInfo;
+
+    do
+    {
+        uIndex = (pTimerModule->uWheelTime >> WHEEL_LEVEL_SHIFT(uLevel)) & (WHEEL_LEVEL_SIZE - 1);
+        pHead  = &pTimerModule->aWheel[WHEEL_LEVEL_SLOT(uLevel) + uIndex];
+
+        /* The slot timers are all relinked in lower levels */
+        while (pHead->pNext != pHead)
+        {
+            pTimerInfo = WHEEL_NODE_TIMER(pHead->pNext);
+            tmr_WheelRemove (pTimerModule, pTimerInfo);
+            tmr_WheelAdd (pTimerModule, pTimerInfo);
+            pTimerModule->uCascades++;
+        }
+
+        uLevel++;
+    }
+    while (uIndex == 0 && uLevel < WHEEL_LEVELS);
+}
+
+
+/**
+ * \fn     tmr_WheelRun
+ * \brief  Expire the wheel timers due by now
+ *
+ * Advance the wheel from event to event up to the current time, cascading the levels on
+ *   root turn ends and moving the expired timers to the expiry queues.
+ * If the expired timer was started when the driver's state was Operational, it is inserted to
+ *   the Operational-queue. Else, if the state is still NOT Operational it is inserted to the
+ *   Init-queue (if the state changed from non-operational to operational the event is ignored).
+ *
+ * \note   Called in critical section
+ * \param  pTimerModule - The module object
+ * \param  uNow         - The current time
+ * \return Number of timers inserted to the expiry queues
+ * \sa     tmr_GetExpiry
+ */
+static TI_UINT32 tmr_WheelRun (TTimerModule *pTimerModule, TI_UINT32 uNow)
+{
+    TI_UINT32    uExpired = 0;
+    TI_UINT32    uNext;
+    TQueNodeHdr *pHead;
+    TTimerInfo  *pTimerInfo;
+    TI_HANDLE    hQueue;
+
+    while (pTimerModule->uWheelCount)
+    {
+        uNext = tmr_WheelNextEvent (pTimerModule);
+        if (uNext == 0xFFFFFFFF || (TI_INT32)(uNow - pTimerModule->uWheelTime) < (TI_INT32)uNext)
+        {
+            break;
+        }
+        pTimerModule->uWheelTime += uNext;
+
+        if ((pTimerModule->uWheelTime & (WHEEL_ROOT_SIZE - 1)) == 0)
+        {
+            tmr_WheelCascade (pTimerModule);
+        }
+
+        /* All the timers of the current root slot expire now */
+        pHead = &pTimerModule->aWheel[pTimerModule->uWheelTime & (WHEEL_ROOT_SIZE - 1)];
+        while (pHead->pNext != pHead)
+        {
+            pTimerInfo = WHEEL_NODE_TIMER(pHead->pNext);
+            tmr_WheelRemove (pTimerModule, pTimerInfo);
+
+            if (pTimerInfo->bOperStateWhenStarted)
+            {
+                hQueue = pTimerModule->hOperQueue;
+            }
+            else if (!pTimerModule->bOperState)
+            {
+                hQueue = pTimerModule->hInitQueue;
+            }
+            else
+            {
+                pTimerInfo->tStats.uDropped++;
+                continue;
+            }
+
+            /* A timer that expires again before its previous expiry was handled is queued once */
+            if (que_Enqueue (hQueue, (TI_HANDLE)pTimerInfo) == TI_OK)
+            {
+                uExpired++;
+            }
+            else
+            {
+                pTimerInfo->tStats.uDropped++;
+            }
+        }
+
+        pTimerModule->uWheelTime++;
+    }
+
+    /* Nothing is due up to the current time */
+    if ((TI_INT32)(uNow + 1 - pTimerModule->uWheelTime) > 0)
+    {
+        pTimerModule->uWheelTime = uNow + 1;
+    }
+
+    return uExpired;
+}
+
+
+/**
+ * \fn     tmr_WheelArm
+ * \brief  Arm the OS-API timer for the wheel next event
+ *
+ * The OS-API timer is re-armed only if it is not armed or armed for a later time.
+ *
+ * \note   Called in critical section
+ * \param  pTimerModule - The module object
+ * \param  uNow         - The current time
+ * \return void
+ * \sa     tmr_StartTimer, tmr_GetExpiry
+ */
+static void tmr_WheelArm (TTimerModule *pTimerModule, TI_UINT32 uNow)
+{
+    TI_UINT32 uNext;
+    TI_UINT32 uTime;
+
+    if (!pTimerModule->uWheelCount || !pTimerModule->hOsTimerObj)
+    {
+        return;
+    }
+
+    uNext = tmr_WheelNextEvent (pTimerModule);
+    if (uNext == 0xFFFFFFFF)
+    {
+        return;
+    }
+    uTime = pTimerModule->uWheelTime + uNext;
+
+    if (pTimerModule->bOsTimerArmed && (TI_INT32)(uTime - pTimerModule->uOsTimerTime) >= 0)
+    {
+        return;
+    }
+
+    pTimerModule->bOsTimerArmed = TI_TRUE;
+    pTimerModule->uOsTimerTime  = uTime;
+    os_timerStart (pTimerModule->hOs,
+                   pTimerModule->hOsTimerObj,
+                   ((TI_INT32)(uTime - uNow) > 0) ? uTime - uNow : 0);
+}
+
+
 /** 
  * \fn     tmr_PrintModule / tmr_PrintTimer
  * \brief  Print module / timer information
@@ -643,6 +1144,11 @@ void tmr_PrintModule (TI_HANDLE hTimerModule)
     pTimerModule->uContextId, pTimerModule->bOperState, 
     pTimerModule->uTwdInitCount, pTimerModule->uTimersCount));
 
+    /* Print wheel parameters */
+    WLAN_OS_REPORT(("tmr_PrintModule(): uWheelCount=%d, uHighLevelsCount=%d, uOsTimerExpiries=%d, uMaxBatch=%d, uCascades=%d\n",
+    pTimerModule->uWheelCount, pTimerModule->uHighLevelsCount,
+    pTimerModule->uOsTimerExpiries, pTimerModule->uMaxBatch, pTimerModule->uCascades));
+
     /* Print Init Queue Info */
     WLAN_OS_REPORT(("tmr_PrintModule(): Init-Queue:\n")); 
     que_Print(pTimerModule->hInitQueue);
@@ -657,9 +1163,13 @@ void tmr_PrintTimer (TI_HANDLE hTimerInfo)
 #ifdef REPORT_LOG
     TTimerInfo   *pTimerInfo   = (TTimerInfo *)hTimerInfo;                 /* The timer handle */     
 
-    WLAN_OS_REPORT(("tmr_PrintTimer(): uIntervalMs=%d, bPeriodic=%d, bOperStateWhenStarted=%d, uTwdInitCountWhenStarted=%d, hOsTimerObj=0x%x, fExpiryCbFunc=0x%x\n", 
+    WLAN_OS_REPORT(("tmr_PrintTimer(): uIntervalMs=%d, bPeriodic=%d, bOperStateWhenStarted=%d, uTwdInitCountWhenStarted=%d, uExpiryTime=%d, fExpiryCbFunc=0x%x\n",
     pTimerInfo->uIntervalMsec, pTimerInfo->bPeriodic, pTimerInfo->bOperStateWhenStarted, 
-    pTimerInfo->uTwdInitCountWhenStarted, pTimerInfo->hOsTimerObj, pTimerInfo->fExpiryCbFunc));
+    pTimerInfo->uTwdInitCountWhenStarted, pTimerInfo->uExpiryTime, pTimerInfo->fExpiryCbFunc));
+
+    WLAN_OS_REPORT(("tmr_PrintTimer(): uStarts=%d, uStops=%d, uExpiries=%d, uDropped=%d, uMaxLateMsec=%d, uTotalLateMsec=%d\n",
+    pTimerInfo->tStats.uStarts, pTimerInfo->tStats.uStops, pTimerInfo->tStats.uExpiries,
+    pTimerInfo->tStats.uDropped, pTimerInfo->tStats.uMaxLateMsec, pTimerInfo->tStats.uTotalLateMsec));
 #endif
 }
 
@@ -46,6 +46,17 @@
 /* The callback function type for timer clients */
 typedef void (*TTimerCbFunc)(TI_HANDLE hCbHndl, TI_BOOL bTwdInitOccured);
 
+/* The statistics of a timer client */
+typedef struct
+{
+    TI_UINT32   uStarts;        /* Number of timer starts (including periodic restarts) */
+    TI_UINT32   uStops;         /* Number of stops of the running timer */
+    TI_UINT32   uExpiries;      /* Number of expiry callbacks */
+    TI_UINT32   uDropped;       /* Number of expiries dropped on driver state change or while still queued */
+    TI_UINT32   uMaxLateMsec;   /* Longest expiry callback latency */
+    TI_UINT32   uTotalLateMsec; /* Sum of the expiry callbacks latency */
+} TTimerStats;
+
 
 /* External Functions Prototypes */
 /* ============================= */
@@ -64,8 +75,9 @@ void      tmr_StartTimer (TI_HANDLE     hTimerInfo,
                           TI_UINT32     uIntervalMsec,
                           TI_BOOL       bPeriodic);
 void      tmr_StopTimer (TI_HANDLE hTimerInfo);
-void      tmr_GetExpiry (TI_HANDLE hTimerInfo);
+void      tmr_GetExpiry (TI_HANDLE hTimerModule);
 void      tmr_HandleExpiry (TI_HANDLE hTimerModule);
+void      tmr_GetStats (TI_HANDLE hTimerInfo, TTimerStats *pStats);
 
 #ifdef TI_DBG
 void      tmr_PrintModule (TI_HANDLE hTimerModule);